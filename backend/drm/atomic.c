@@ -23,18 +23,23 @@ static void atomic_begin(struct atomic *atom) {
 	}
 }
 
-static bool atomic_commit(struct atomic *atom,
+static bool atomic_commit(struct atomic *atom, struct wlr_drm_backend *drm,
 		struct wlr_drm_connector *conn, uint32_t flags) {
-	struct wlr_drm_backend *drm = conn->backend;
 	if (atom->failed) {
 		return false;
 	}
 
 	int ret = drmModeAtomicCommit(drm->fd, atom->req, flags, drm);
 	if (ret) {
-		wlr_drm_conn_log_errno(conn, WLR_ERROR, "Atomic %s failed (%s)",
-			(flags & DRM_MODE_ATOMIC_TEST_ONLY) ? "test" : "commit",
-			(flags & DRM_MODE_ATOMIC_ALLOW_MODESET) ? "modeset" : "pageflip");
+		if (conn != NULL) {
+			wlr_drm_conn_log_errno(conn, WLR_ERROR, "Atomic %s failed (%s)",
+				(flags & DRM_MODE_ATOMIC_TEST_ONLY) ? "test" : "commit",
+				(flags & DRM_MODE_ATOMIC_ALLOW_MODESET) ? "modeset" : "pageflip");
+		} else {
+			wlr_log_errno(WLR_ERROR, "Atomic multi-CRTC %s failed (%s)",
+				(flags & DRM_MODE_ATOMIC_TEST_ONLY) ? "test" : "commit",
+				(flags & DRM_MODE_ATOMIC_ALLOW_MODESET) ? "modeset" : "pageflip");
+		}
 		return false;
 	}
 
@@ -153,6 +158,10 @@ static void set_plane_props(struct atomic *atom, struct wlr_drm_backend *drm,
 	atomic_add(atom, id, props->crtc_id, crtc_id);
 	atomic_add(atom, id, props->crtc_x, (uint64_t)x);
 	atomic_add(atom, id, props->crtc_y, (uint64_t)y);
+	if (props->in_fence_fd != 0 && plane->pending_fence_fd >= 0) {
+		atomic_add(atom, id, props->in_fence_fd,
+			(uint64_t)plane->pending_fence_fd);
+	}
 
 	return;
 
@@ -161,19 +170,23 @@ error:
 	atom->failed = true;
 }
 
-static bool atomic_crtc_commit(struct wlr_drm_backend *drm,
-		struct wlr_drm_connector *conn, uint32_t flags) {
+// Appends one connector's pending state to an atomic request. mode_id and
+// gamma_lut must be initialized to the CRTC's current blob IDs, and are
+// replaced with freshly created blobs when the pending state requires new
+// ones; callers are responsible for committing or rolling them back once the
+// request has been submitted.
+static bool atomic_conn_add(struct atomic *atom, struct wlr_drm_backend *drm,
+		struct wlr_drm_connector *conn, uint32_t *mode_id,
+		uint32_t *gamma_lut, bool *vrr_enabled) {
 	struct wlr_output *output = &conn->output;
 	struct wlr_drm_crtc *crtc = conn->crtc;
 
-	uint32_t mode_id = crtc->mode_id;
 	if (crtc->pending_modeset) {
-		if (!create_mode_blob(drm, crtc, &mode_id)) {
+		if (!create_mode_blob(drm, crtc, mode_id)) {
 			return false;
 		}
 	}
 
-	uint32_t gamma_lut = crtc->gamma_lut;
 	if (output->pending.committed & WLR_OUTPUT_STATE_GAMMA_LUT) {
 		// Fallback to legacy gamma interface when gamma properties are not
 		// available (can happen on older Intel GPUs that support gamma but not
@@ -186,82 +199,173 @@ static bool atomic_crtc_commit(struct wlr_drm_backend *drm,
 			}
 		} else {
 			if (!create_gamma_lut_blob(drm, output->pending.gamma_lut_size,
-					output->pending.gamma_lut, &gamma_lut)) {
+					output->pending.gamma_lut, gamma_lut)) {
 				return false;
 			}
 		}
 	}
 
-	bool prev_vrr_enabled =
+	*vrr_enabled =
 		output->adaptive_sync_status == WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED;
-	bool vrr_enabled = prev_vrr_enabled;
 	if ((output->pending.committed & WLR_OUTPUT_STATE_ADAPTIVE_SYNC_ENABLED) &&
 			drm_connector_supports_vrr(conn)) {
-		vrr_enabled = output->pending.adaptive_sync_enabled;
+		*vrr_enabled = output->pending.adaptive_sync_enabled;
 	}
 
-	if (crtc->pending_modeset) {
-		flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
-	} else {
-		flags |= DRM_MODE_ATOMIC_NONBLOCK;
-	}
-
-	struct atomic atom;
-	atomic_begin(&atom);
-	atomic_add(&atom, conn->id, conn->props.crtc_id,
+	atomic_add(atom, conn->id, conn->props.crtc_id,
 		crtc->pending.active ? crtc->id : 0);
 	if (crtc->pending_modeset && crtc->pending.active &&
 			conn->props.link_status != 0) {
-		atomic_add(&atom, conn->id, conn->props.link_status,
+		atomic_add(atom, conn->id, conn->props.link_status,
 			DRM_MODE_LINK_STATUS_GOOD);
 	}
-	atomic_add(&atom, crtc->id, crtc->props.mode_id, mode_id);
-	atomic_add(&atom, crtc->id, crtc->props.active, crtc->pending.active);
+	atomic_add(atom, crtc->id, crtc->props.mode_id, *mode_id);
+	atomic_add(atom, crtc->id, crtc->props.active, crtc->pending.active);
 	if (crtc->pending.active) {
 		if (crtc->props.gamma_lut != 0) {
-			atomic_add(&atom, crtc->id, crtc->props.gamma_lut, gamma_lut);
+			atomic_add(atom, crtc->id, crtc->props.gamma_lut, *gamma_lut);
 		}
 		if (crtc->props.vrr_enabled != 0) {
-			atomic_add(&atom, crtc->id, crtc->props.vrr_enabled, vrr_enabled);
+			atomic_add(atom, crtc->id, crtc->props.vrr_enabled, *vrr_enabled);
 		}
-		set_plane_props(&atom, drm, crtc->primary, crtc->id, 0, 0);
+		set_plane_props(atom, drm, crtc->primary, crtc->id, 0, 0);
 		if (crtc->cursor) {
 			if (drm_connector_is_cursor_visible(conn)) {
-				set_plane_props(&atom, drm, crtc->cursor, crtc->id,
+				set_plane_props(atom, drm, crtc->cursor, crtc->id,
 					conn->cursor_x, conn->cursor_y);
 			} else {
-				plane_disable(&atom, crtc->cursor);
+				plane_disable(atom, crtc->cursor);
+			}
+		}
+		if (crtc->overlay) {
+			if (crtc->overlay->overlay_enabled &&
+					plane_get_next_fb(crtc->overlay) != NULL) {
+				set_plane_props(atom, drm, crtc->overlay, crtc->id,
+					crtc->overlay->overlay_x, crtc->overlay->overlay_y);
+			} else {
+				plane_disable(atom, crtc->overlay);
 			}
 		}
 	} else {
-		plane_disable(&atom, crtc->primary);
+		plane_disable(atom, crtc->primary);
 		if (crtc->cursor) {
-			plane_disable(&atom, crtc->cursor);
+			plane_disable(atom, crtc->cursor);
+		}
+		if (crtc->overlay) {
+			plane_disable(atom, crtc->overlay);
 		}
 	}
 
-	bool ok = atomic_commit(&atom, conn, flags);
-	atomic_finish(&atom);
+	return true;
+}
 
-	if (ok && !(flags & DRM_MODE_ATOMIC_TEST_ONLY)) {
-		commit_blob(drm, &crtc->mode_id, mode_id);
-		commit_blob(drm, &crtc->gamma_lut, gamma_lut);
+static bool atomic_crtcs_commit(struct wlr_drm_backend *drm,
+		struct wlr_drm_connector **conns, size_t n_conns, uint32_t flags) {
+	uint32_t mode_ids[n_conns];
+	uint32_t gamma_luts[n_conns];
+	bool vrr_enabled[n_conns];
 
-		if (vrr_enabled != prev_vrr_enabled) {
-			output->adaptive_sync_status = vrr_enabled ?
-				WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED :
-				WLR_OUTPUT_ADAPTIVE_SYNC_DISABLED;
-			wlr_drm_conn_log(conn, WLR_DEBUG, "VRR %s",
-				vrr_enabled ? "enabled" : "disabled");
+	struct atomic atom;
+	atomic_begin(&atom);
+
+	// Build a single request spanning all connectors, so that the kernel
+	// applies the whole configuration in one vblank (or rejects it as a
+	// whole).
+	bool ok = true;
+	bool modeset = false;
+	size_t n_added = 0;
+	for (size_t i = 0; i < n_conns; ++i) {
+		struct wlr_drm_crtc *crtc = conns[i]->crtc;
+		mode_ids[i] = crtc->mode_id;
+		gamma_luts[i] = crtc->gamma_lut;
+		if (!atomic_conn_add(&atom, drm, conns[i], &mode_ids[i],
+				&gamma_luts[i], &vrr_enabled[i])) {
+			ok = false;
+			break;
 		}
+		modeset = modeset || crtc->pending_modeset || crtc->pending_dpms;
+		++n_added;
+	}
+
+	if (modeset) {
+		flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
 	} else {
-		rollback_blob(drm, &crtc->mode_id, mode_id);
-		rollback_blob(drm, &crtc->gamma_lut, gamma_lut);
+		flags |= DRM_MODE_ATOMIC_NONBLOCK;
 	}
 
+	if (ok && modeset && !(flags & DRM_MODE_ATOMIC_TEST_ONLY) &&
+			n_conns == 1) {
+		// A blocking modeset would stall the event loop. Validate the
+		// configuration synchronously, then let a worker thread run the
+		// real commit so the other outputs keep flipping meanwhile.
+		ok = atomic_commit(&atom, drm, conns[0],
+			flags | DRM_MODE_ATOMIC_TEST_ONLY);
+		if (ok && drm_async_modeset_start(drm, conns[0], atom.req, flags)) {
+			atom.req = NULL; // now owned by the worker
+		} else if (ok) {
+			ok = atomic_commit(&atom, drm, conns[0], flags);
+		}
+	} else {
+		ok = ok && atomic_commit(&atom, drm,
+			n_conns == 1 ? conns[0] : NULL, flags);
+	}
+	atomic_finish(&atom);
+
+	for (size_t i = 0; i < n_added; ++i) {
+		struct wlr_drm_connector *conn = conns[i];
+		struct wlr_output *output = &conn->output;
+		struct wlr_drm_crtc *crtc = conn->crtc;
+
+		if (ok && !(flags & DRM_MODE_ATOMIC_TEST_ONLY)) {
+			commit_blob(drm, &crtc->mode_id, mode_ids[i]);
+			commit_blob(drm, &crtc->gamma_lut, gamma_luts[i]);
+
+			bool prev_vrr_enabled =
+				output->adaptive_sync_status == WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED;
+			if (vrr_enabled[i] != prev_vrr_enabled) {
+				output->adaptive_sync_status = vrr_enabled[i] ?
+					WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED :
+					WLR_OUTPUT_ADAPTIVE_SYNC_DISABLED;
+				wlr_drm_conn_log(conn, WLR_DEBUG, "VRR %s",
+					vrr_enabled[i] ? "enabled" : "disabled");
+			}
+		} else {
+			rollback_blob(drm, &crtc->mode_id, mode_ids[i]);
+			rollback_blob(drm, &crtc->gamma_lut, gamma_luts[i]);
+		}
+	}
+
+	return ok;
+}
+
+static bool atomic_crtc_commit(struct wlr_drm_backend *drm,
+		struct wlr_drm_connector *conn, uint32_t flags) {
+	return atomic_crtcs_commit(drm, &conn, 1, flags);
+}
+
+static bool atomic_crtc_move_cursor(struct wlr_drm_backend *drm,
+		struct wlr_drm_connector *conn) {
+	struct wlr_drm_crtc *crtc = conn->crtc;
+	struct wlr_drm_plane *plane = crtc->cursor;
+
+	struct atomic atom;
+	atomic_begin(&atom);
+	atomic_add(&atom, plane->id, plane->props.crtc_x, (uint64_t)conn->cursor_x);
+	atomic_add(&atom, plane->id, plane->props.crtc_y, (uint64_t)conn->cursor_y);
+
+	bool ok = !atom.failed && drmModeAtomicCommit(drm->fd, atom.req,
+		DRM_MODE_ATOMIC_NONBLOCK, drm) == 0;
+	if (!ok) {
+		// The caller falls back to a full commit, don't be noisy about it
+		wlr_drm_conn_log_errno(conn, WLR_DEBUG, "Atomic cursor move failed");
+	}
+	atomic_finish(&atom);
+
 	return ok;
 }
 
 const struct wlr_drm_interface atomic_iface = {
 	.crtc_commit = atomic_crtc_commit,
+	.crtcs_commit = atomic_crtcs_commit,
+	.crtc_move_cursor = atomic_crtc_move_cursor,
 };
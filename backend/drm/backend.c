@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include <wlr/backend/interface.h>
@@ -57,6 +58,12 @@ static void backend_destroy(struct wlr_backend *backend) {
 
 	free(drm->name);
 	wlr_session_close_file(drm->session, drm->dev);
+	if (drm->modeset_event != NULL) {
+		wl_event_source_remove(drm->modeset_event);
+		close(drm->modeset_sock[0]);
+		close(drm->modeset_sock[1]);
+	}
+	wl_event_source_remove(drm->scan_timer);
 	wl_event_source_remove(drm->drm_event);
 	free(drm);
 }
@@ -106,6 +113,12 @@ static void handle_session_active(struct wl_listener *listener, void *data) {
 
 	if (session->active) {
 		wlr_log(WLR_INFO, "DRM fd resumed");
+
+		// The immediate scan supersedes any debounced one
+		if (drm->scan_pending) {
+			wl_event_source_timer_update(drm->scan_timer, 0);
+			drm->scan_pending = false;
+		}
 		scan_drm_connectors(drm);
 
 		struct wlr_drm_connector *conn;
@@ -121,6 +134,22 @@ static void handle_session_active(struct wl_listener *listener, void *data) {
 	}
 }
 
+// Docks and MST hubs deliver a burst of change uevents on connect. Scanning
+// once per uevent serializes several full probe passes, so rescans are
+// debounced: the first event arms the timer and the rest of the burst rides
+// along with the scheduled scan.
+#define DRM_SCAN_DEBOUNCE_MS 50
+
+static int handle_scan_timer(void *data) {
+	struct wlr_drm_backend *drm = data;
+	drm->scan_pending = false;
+
+	if (drm->session->active) {
+		scan_drm_connectors(drm);
+	}
+	return 0;
+}
+
 static void handle_dev_change(struct wl_listener *listener, void *data) {
 	struct wlr_drm_backend *drm = wl_container_of(listener, drm, dev_change);
 
@@ -129,7 +158,13 @@ static void handle_dev_change(struct wl_listener *listener, void *data) {
 	}
 
 	wlr_log(WLR_DEBUG, "%s invalidated", drm->name);
-	scan_drm_connectors(drm);
+
+	if (drm->scan_pending) {
+		// A scan is already scheduled and will cover this event too
+		return;
+	}
+	drm->scan_pending = true;
+	wl_event_source_timer_update(drm->scan_timer, DRM_SCAN_DEBOUNCE_MS);
 }
 
 static void handle_session_destroy(struct wl_listener *listener, void *data) {
@@ -186,6 +221,35 @@ struct wlr_backend *wlr_drm_backend_create(struct wl_display *display,
 		goto error_fd;
 	}
 
+	drm->scan_timer = wl_event_loop_add_timer(event_loop,
+		handle_scan_timer, drm);
+	if (!drm->scan_timer) {
+		wlr_log(WLR_ERROR, "Failed to create connector scan timer");
+		goto error_timer;
+	}
+
+	// Asynchronous modesets are best-effort: without the socket pair,
+	// modesets simply block the loop as they used to
+	drm->modeset_sock[0] = drm->modeset_sock[1] = -1;
+	const char *no_async = getenv("WLR_DRM_NO_ASYNC_MODESET");
+	if (no_async == NULL || strcmp(no_async, "1") != 0) {
+		int sock[2];
+		if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0,
+				sock) == 0) {
+			drm->modeset_event = wl_event_loop_add_fd(event_loop, sock[0],
+				WL_EVENT_READABLE, handle_drm_async_modeset, drm);
+			if (drm->modeset_event != NULL) {
+				drm->modeset_sock[0] = sock[0];
+				drm->modeset_sock[1] = sock[1];
+			} else {
+				close(sock[0]);
+				close(sock[1]);
+			}
+		} else {
+			wlr_log_errno(WLR_ERROR, "Failed to create modeset socket pair");
+		}
+	}
+
 	drm->session_active.notify = handle_session_active;
 	wl_signal_add(&session->events.active, &drm->session_active);
 
@@ -212,6 +276,13 @@ struct wlr_backend *wlr_drm_backend_create(struct wl_display *display,
 
 error_event:
 	wl_list_remove(&drm->session_active.link);
+	if (drm->modeset_event != NULL) {
+		wl_event_source_remove(drm->modeset_event);
+		close(drm->modeset_sock[0]);
+		close(drm->modeset_sock[1]);
+	}
+	wl_event_source_remove(drm->scan_timer);
+error_timer:
 	wl_event_source_remove(drm->drm_event);
 error_fd:
 	wlr_session_close_file(drm->session, dev);
@@ -3,14 +3,19 @@
 #include <drm_fourcc.h>
 #include <drm_mode.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <gbm.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 #include <wayland-server-core.h>
 #include <wayland-util.h>
 #include <wlr/backend/interface.h>
@@ -26,6 +31,7 @@
 #include "backend/drm/util.h"
 #include "render/swapchain.h"
 #include "util/signal.h"
+#include "util/trace.h"
 
 bool check_drm_features(struct wlr_drm_backend *drm) {
 	uint64_t cap;
@@ -97,6 +103,7 @@ static bool add_plane(struct wlr_drm_backend *drm,
 		return false;
 	}
 
+	p->pending_fence_fd = -1;
 	p->type = type;
 	p->id = drm_plane->plane_id;
 	p->props = *props;
@@ -149,6 +156,9 @@ static bool add_plane(struct wlr_drm_backend *drm,
 	case DRM_PLANE_TYPE_CURSOR:
 		crtc->cursor = p;
 		break;
+	case DRM_PLANE_TYPE_OVERLAY:
+		crtc->overlay = p;
+		break;
 	default:
 		abort();
 	}
@@ -190,13 +200,6 @@ static bool init_planes(struct wlr_drm_backend *drm) {
 			goto error;
 		}
 
-		// We don't really care about overlay planes, as we don't support them
-		// yet.
-		if (type == DRM_PLANE_TYPE_OVERLAY) {
-			drmModeFreePlane(plane);
-			continue;
-		}
-
 		assert(drm->num_crtcs <= 32);
 		struct wlr_drm_crtc *crtc = NULL;
 		for (size_t j = 0; j < drm->num_crtcs ; j++) {
@@ -207,7 +210,8 @@ static bool init_planes(struct wlr_drm_backend *drm) {
 
 			struct wlr_drm_crtc *candidate = &drm->crtcs[j];
 			if ((type == DRM_PLANE_TYPE_PRIMARY && !candidate->primary) ||
-					(type == DRM_PLANE_TYPE_CURSOR && !candidate->cursor)) {
+					(type == DRM_PLANE_TYPE_CURSOR && !candidate->cursor) ||
+					(type == DRM_PLANE_TYPE_OVERLAY && !candidate->overlay)) {
 				crtc = candidate;
 				break;
 			}
@@ -301,6 +305,10 @@ void finish_drm_resources(struct wlr_drm_backend *drm) {
 			wlr_drm_format_set_finish(&crtc->cursor->formats);
 			free(crtc->cursor);
 		}
+		if (crtc->overlay) {
+			wlr_drm_format_set_finish(&crtc->overlay->formats);
+			free(crtc->overlay);
+		}
 	}
 
 	free(drm->crtcs);
@@ -318,36 +326,88 @@ static bool drm_connector_attach_render(struct wlr_output *output,
 	return drm_surface_make_current(&conn->crtc->primary->surf, buffer_age);
 }
 
+static void drm_plane_clear_fence(struct wlr_drm_plane *plane) {
+	if (plane->pending_fence_fd >= 0) {
+		close(plane->pending_fence_fd);
+		plane->pending_fence_fd = -1;
+	}
+}
+
 static void drm_plane_set_committed(struct wlr_drm_plane *plane) {
 	drm_fb_move(&plane->queued_fb, &plane->pending_fb);
+	drm_plane_clear_fence(plane);
 
-	if (plane->queued_fb) {
+	// Overlay planes scan out imported client buffers and have no swapchain
+	if (plane->queued_fb && plane->surf.swapchain != NULL) {
 		wlr_swapchain_set_buffer_submitted(plane->surf.swapchain,
 			plane->queued_fb->wlr_buf);
 	}
 }
 
-static bool drm_crtc_commit(struct wlr_drm_connector *conn, uint32_t flags) {
-	struct wlr_drm_backend *drm = conn->backend;
-	struct wlr_drm_crtc *crtc = conn->crtc;
-	bool ok = drm->iface->crtc_commit(drm, conn, flags);
-	if (ok && !(flags & DRM_MODE_ATOMIC_TEST_ONLY)) {
-		memcpy(&crtc->current, &crtc->pending, sizeof(struct wlr_drm_crtc_state));
-		drm_plane_set_committed(crtc->primary);
-		if (crtc->cursor != NULL) {
-			drm_plane_set_committed(crtc->cursor);
+bool drm_crtcs_commit(struct wlr_drm_backend *drm,
+		struct wlr_drm_connector **conns, size_t n_conns, uint32_t flags) {
+	bool in_flight = false;
+	for (size_t i = 0; i < n_conns; ++i) {
+		if (conns[i]->modeset_in_flight) {
+			wlr_drm_conn_log(conns[i], WLR_DEBUG, "Rejecting commit: "
+				"an asynchronous modeset is still in flight");
+			in_flight = true;
 		}
-	} else {
-		memcpy(&crtc->pending, &crtc->current, sizeof(struct wlr_drm_crtc_state));
-		drm_fb_clear(&crtc->primary->pending_fb);
-		if (crtc->cursor != NULL) {
-			drm_fb_clear(&crtc->cursor->pending_fb);
+	}
+
+	bool ok = !in_flight &&
+		drm->iface->crtcs_commit(drm, conns, n_conns, flags);
+	for (size_t i = 0; i < n_conns; ++i) {
+		struct wlr_drm_crtc *crtc = conns[i]->crtc;
+		if (!(flags & DRM_MODE_ATOMIC_TEST_ONLY)) {
+			// Whatever was waiting behind an in-flight page-flip has been
+			// superseded by this commit
+			conns[i]->queued_page_flip = false;
 		}
+		if (ok && !(flags & DRM_MODE_ATOMIC_TEST_ONLY)) {
+			memcpy(&crtc->current, &crtc->pending,
+				sizeof(struct wlr_drm_crtc_state));
+			drm_plane_set_committed(crtc->primary);
+			if (crtc->cursor != NULL) {
+				drm_plane_set_committed(crtc->cursor);
+				crtc->cursor->cursor_scanout_enabled = crtc->current.active &&
+					drm_connector_is_cursor_visible(conns[i]);
+			}
+			if (crtc->overlay != NULL) {
+				drm_plane_set_committed(crtc->overlay);
+			}
+		} else {
+			if (!ok && !(flags & DRM_MODE_ATOMIC_TEST_ONLY) &&
+					crtc->primary->mgpu_was_direct) {
+				// The kernel refused to scan out the render GPU's buffer
+				// even though the import succeeded: blit from now on
+				wlr_log(WLR_INFO, "Direct cross-GPU scan-out failed, "
+					"falling back to blitting");
+				crtc->primary->mgpu_disable_direct = true;
+			}
+			memcpy(&crtc->pending, &crtc->current,
+				sizeof(struct wlr_drm_crtc_state));
+			drm_fb_clear(&crtc->primary->pending_fb);
+			drm_plane_clear_fence(crtc->primary);
+			if (crtc->cursor != NULL) {
+				drm_fb_clear(&crtc->cursor->pending_fb);
+				drm_plane_clear_fence(crtc->cursor);
+			}
+			if (crtc->overlay != NULL) {
+				drm_fb_clear(&crtc->overlay->pending_fb);
+				drm_plane_clear_fence(crtc->overlay);
+			}
+		}
+		crtc->pending_modeset = false;
+		crtc->pending_dpms = false;
 	}
-	crtc->pending_modeset = false;
 	return ok;
 }
 
+static bool drm_crtc_commit(struct wlr_drm_connector *conn, uint32_t flags) {
+	return drm_crtcs_commit(conn->backend, &conn, 1, flags);
+}
+
 static bool drm_crtc_page_flip(struct wlr_drm_connector *conn) {
 	struct wlr_drm_crtc *crtc = conn->crtc;
 	assert(crtc != NULL);
@@ -356,10 +416,23 @@ static bool drm_crtc_page_flip(struct wlr_drm_connector *conn) {
 	// page-flip, either a blocking modeset. When performing a blocking modeset
 	// we'll wait for all queued page-flips to complete, so we don't need this
 	// safeguard.
-	if (conn->pending_page_flip_crtc && !crtc->pending_modeset) {
-		wlr_drm_conn_log(conn, WLR_ERROR, "Failed to page-flip output: "
-			"a page-flip is already pending");
-		return false;
+	if (conn->pending_page_flip_crtc && !crtc->pending_modeset &&
+			!crtc->pending_dpms) {
+		// The kernel's commit queue is one entry deep and in-flight requests
+		// can't be amended. Hold the new state in the planes' pending FBs and
+		// submit it from the page-flip handler, so the commit returns
+		// immediately instead of stalling or failing with EBUSY.
+		if (conn->queued_page_flip) {
+			wlr_drm_conn_log(conn, WLR_ERROR, "Failed to page-flip output: "
+				"a page-flip is already queued");
+			return false;
+		}
+
+		assert(crtc->pending.active);
+		assert(plane_get_next_fb(crtc->primary));
+		conn->queued_page_flip = true;
+		conn->output.frame_pending = true;
+		return true;
 	}
 
 	assert(crtc->pending.active);
@@ -450,6 +523,32 @@ static bool drm_connector_test(struct wlr_output *output) {
 		if (!test_buffer(conn, output->pending.buffer)) {
 			return false;
 		}
+
+		// The format/modifier checks above can't catch everything (stride
+		// limits, CRTC bandwidth, ...), so ask the kernel with a test-only
+		// commit of the actual buffer before promising direct scan-out
+		struct wlr_drm_backend *drm = conn->backend;
+		if (drm->iface == &atomic_iface && conn->crtc != NULL) {
+			struct wlr_drm_plane *plane = conn->crtc->primary;
+			struct wlr_drm_fb *prev_fb = plane->pending_fb;
+			plane->pending_fb = NULL;
+
+			bool ok = drm_fb_import(&plane->pending_fb, drm,
+				output->pending.buffer, &plane->formats);
+			if (ok) {
+				ok = drm->iface->crtc_commit(drm, conn,
+					DRM_MODE_ATOMIC_TEST_ONLY);
+			}
+
+			drm_fb_clear(&plane->pending_fb);
+			plane->pending_fb = prev_fb;
+
+			if (!ok) {
+				wlr_drm_conn_log(conn, WLR_DEBUG,
+					"Direct scan-out buffer rejected by test commit");
+				return false;
+			}
+		}
 	}
 
 	return true;
@@ -485,8 +584,12 @@ static bool drm_connector_commit_buffer(struct wlr_output *output) {
 
 	assert(output->pending.committed & WLR_OUTPUT_STATE_BUFFER);
 	switch (output->pending.buffer_type) {
-	case WLR_OUTPUT_STATE_BUFFER_RENDER:
-		if (!drm_plane_lock_surface(plane, drm)) {
+	case WLR_OUTPUT_STATE_BUFFER_RENDER:;
+		pixman_region32_t *damage = NULL;
+		if (output->pending.committed & WLR_OUTPUT_STATE_DAMAGE) {
+			damage = &output->pending.damage;
+		}
+		if (!drm_plane_lock_surface(plane, drm, damage)) {
 			wlr_drm_conn_log(conn, WLR_ERROR, "drm_plane_lock_surface failed");
 			return false;
 		}
@@ -511,17 +614,12 @@ static bool drm_connector_commit_buffer(struct wlr_output *output) {
 }
 
 bool drm_connector_supports_vrr(struct wlr_drm_connector *conn) {
-	struct wlr_drm_backend *drm = conn->backend;
-
 	struct wlr_drm_crtc *crtc = conn->crtc;
 	if (!crtc) {
 		return false;
 	}
 
-	uint64_t vrr_capable;
-	if (conn->props.vrr_capable == 0 ||
-			!get_drm_prop(drm->fd, conn->id, conn->props.vrr_capable,
-			&vrr_capable) || !vrr_capable) {
+	if (!conn->vrr_capable) {
 		wlr_drm_conn_log(conn, WLR_DEBUG, "Failed to enable adaptive sync: "
 			"connector doesn't support VRR");
 		return false;
@@ -536,6 +634,59 @@ bool drm_connector_supports_vrr(struct wlr_drm_connector *conn) {
 	return true;
 }
 
+/**
+ * Toggles the CRTC's ACTIVE property without touching the rest of the pipe:
+ * the mode blob, renderer surfaces and CRTC assignment are all preserved, so
+ * the kernel skips mode re-validation and the panel comes back in a single
+ * commit instead of a full modeset. Returns false when the fast path doesn't
+ * apply or the commit is rejected, in which case the caller falls back to the
+ * full modeset path.
+ */
+static bool drm_connector_set_active(struct wlr_drm_connector *conn,
+		bool active) {
+	struct wlr_drm_backend *drm = conn->backend;
+	struct wlr_drm_crtc *crtc = conn->crtc;
+
+	if (drm->iface != &atomic_iface) {
+		// Legacy re-validates the mode on wake via drmModeSetCrtc anyway
+		return false;
+	}
+	if (crtc == NULL || conn->state != WLR_DRM_CONN_CONNECTED ||
+			conn->output.current_mode == NULL ||
+			crtc->current.mode !=
+			(struct wlr_drm_mode *)conn->output.current_mode) {
+		return false;
+	}
+
+	if (crtc->current.active == active) {
+		conn->desired_enabled = active;
+		wlr_output_update_enabled(&conn->output, active);
+		return true;
+	}
+
+	if (active && plane_get_next_fb(crtc->primary) == NULL) {
+		// Nothing left to scan out; the full path renders a frame first
+		return false;
+	}
+
+	wlr_drm_conn_log(conn, WLR_DEBUG,
+		"Toggling CRTC active for power %s (skipping modeset)",
+		active ? "on" : "off");
+
+	crtc->pending.active = active;
+	crtc->pending_dpms = true;
+	bool ok = active ? drm_crtc_page_flip(conn) : drm_crtc_commit(conn, 0);
+	if (!ok) {
+		wlr_drm_conn_log(conn, WLR_DEBUG,
+			"ACTIVE-only commit failed, falling back to a full modeset");
+		return false;
+	}
+
+	conn->desired_enabled = active;
+	wlr_output_update_enabled(&conn->output, active);
+	return true;
+}
+
 static bool drm_connector_commit(struct wlr_output *output) {
 	struct wlr_drm_connector *conn = get_drm_connector_from_output(output);
 	struct wlr_drm_backend *drm = conn->backend;
@@ -548,6 +699,20 @@ static bool drm_connector_commit(struct wlr_output *output) {
 		return false;
 	}
 
+	if (conn->lessee_id != 0) {
+		wlr_drm_conn_log(conn, WLR_ERROR, "Cannot commit a leased output");
+		return false;
+	}
+
+	// Pure power state changes on an already-configured pipe don't need the
+	// modeset pipeline: toggle the CRTC's ACTIVE property and keep everything
+	// else in place
+	if ((output->pending.committed & WLR_OUTPUT_STATE_ENABLED) &&
+			!(output->pending.committed & WLR_OUTPUT_STATE_MODE) &&
+			drm_connector_set_active(conn, output->pending.enabled)) {
+		return true;
+	}
+
 	if (output->pending.committed &
 			(WLR_OUTPUT_STATE_MODE | WLR_OUTPUT_STATE_ENABLED)) {
 		struct wlr_output_mode *wlr_mode = output->current_mode;
@@ -598,14 +763,19 @@ size_t drm_crtc_get_gamma_lut_size(struct wlr_drm_backend *drm,
 		return (size_t)crtc->legacy_crtc->gamma_size;
 	}
 
-	uint64_t gamma_lut_size;
-	if (!get_drm_prop(drm->fd, crtc->id, crtc->props.gamma_lut_size,
-			&gamma_lut_size)) {
-		wlr_log(WLR_ERROR, "Unable to get gamma lut size");
-		return 0;
+	// The property's value never changes, so one kernel query per CRTC is
+	// enough; gamma updates shouldn't hit the property ioctls at all
+	if (crtc->gamma_lut_size == 0) {
+		uint64_t gamma_lut_size;
+		if (!get_drm_prop(drm->fd, crtc->id, crtc->props.gamma_lut_size,
+				&gamma_lut_size)) {
+			wlr_log(WLR_ERROR, "Unable to get gamma lut size");
+			return 0;
+		}
+		crtc->gamma_lut_size = gamma_lut_size;
 	}
 
-	return gamma_lut_size;
+	return crtc->gamma_lut_size;
 }
 
 static size_t drm_connector_get_gamma_size(struct wlr_output *output) {
@@ -680,7 +850,7 @@ static bool drm_connector_pageflip_renderer(struct wlr_drm_connector *conn) {
 		if (!drm_surface_render_black_frame(&plane->surf)) {
 			return false;
 		}
-		if (!drm_plane_lock_surface(plane, drm)) {
+		if (!drm_plane_lock_surface(plane, drm, NULL)) {
 			return false;
 		}
 	}
@@ -863,6 +1033,160 @@ struct wlr_output_mode *wlr_drm_connector_add_mode(struct wlr_output *output,
 	return &mode->wlr_mode;
 }
 
+bool wlr_drm_connector_set_overlay_buffer(struct wlr_output *output,
+		struct wlr_buffer *buffer, int x, int y) {
+	struct wlr_drm_connector *conn = get_drm_connector_from_output(output);
+	struct wlr_drm_backend *drm = conn->backend;
+
+	struct wlr_drm_crtc *crtc = conn->crtc;
+	if (crtc == NULL || crtc->overlay == NULL) {
+		return false;
+	}
+	struct wlr_drm_plane *plane = crtc->overlay;
+
+	if (buffer == NULL) {
+		plane->overlay_enabled = false;
+		drm_fb_clear(&plane->pending_fb);
+		return true;
+	}
+
+	/* Legacy never gets to have nice things, see test_buffer. */
+	if (drm->iface == &legacy_iface) {
+		return false;
+	}
+
+	if (!drm->session->active) {
+		return false;
+	}
+
+	struct wlr_dmabuf_attributes attribs;
+	if (!wlr_buffer_get_dmabuf(buffer, &attribs)) {
+		return false;
+	}
+	if (attribs.flags != 0 || !wlr_drm_format_set_has(&plane->formats,
+			attribs.format, attribs.modifier)) {
+		return false;
+	}
+
+	struct wlr_drm_fb *prev_fb = plane->pending_fb;
+	plane->pending_fb = NULL;
+
+	bool prev_enabled = plane->overlay_enabled;
+	int32_t prev_x = plane->overlay_x, prev_y = plane->overlay_y;
+	plane->overlay_enabled = true;
+	plane->overlay_x = x;
+	plane->overlay_y = y;
+
+	// The format/modifier checks above can't catch everything (stride limits,
+	// scan-out engine capabilities, ...), so ask the kernel with a test-only
+	// commit before promising to offload this buffer
+	bool ok = drm_fb_import(&plane->pending_fb, drm, buffer, &plane->formats);
+	if (ok) {
+		ok = drm->iface->crtc_commit(drm, conn, DRM_MODE_ATOMIC_TEST_ONLY);
+	}
+
+	if (!ok) {
+		wlr_drm_conn_log(conn, WLR_DEBUG,
+			"Overlay buffer rejected by test commit");
+		drm_fb_clear(&plane->pending_fb);
+		plane->pending_fb = prev_fb;
+		plane->overlay_enabled = prev_enabled;
+		plane->overlay_x = prev_x;
+		plane->overlay_y = prev_y;
+		return false;
+	}
+
+	drm_fb_clear(&prev_fb);
+	return true;
+}
+
+bool wlr_drm_backend_test_outputs(struct wlr_output **outputs,
+		size_t n_outputs) {
+	if (n_outputs == 0) {
+		return true;
+	}
+
+	struct wlr_drm_backend *drm = NULL;
+	struct wlr_drm_connector *conns[n_outputs];
+	for (size_t i = 0; i < n_outputs; ++i) {
+		struct wlr_drm_connector *conn =
+			get_drm_connector_from_output(outputs[i]);
+		if (drm == NULL) {
+			drm = conn->backend;
+		} else if (conn->backend != drm) {
+			wlr_log(WLR_DEBUG,
+				"Can't test outputs of different DRM backends together");
+			return false;
+		}
+		conns[i] = conn;
+	}
+
+	if (!drm->session->active || drm->iface != &atomic_iface) {
+		return false;
+	}
+
+	for (size_t i = 0; i < n_outputs; ++i) {
+		if (!drm_connector_test(outputs[i])) {
+			return false;
+		}
+	}
+
+	// Stage each connector's pending output state on its CRTC the way a real
+	// commit would, build one test-only request spanning all of them, then
+	// put everything back
+	struct wlr_drm_crtc_state saved_states[n_outputs];
+	bool saved_modesets[n_outputs];
+	size_t staged = 0;
+	bool ok = false;
+	for (size_t i = 0; i < n_outputs; ++i) {
+		struct wlr_drm_connector *conn = conns[i];
+		struct wlr_output *output = outputs[i];
+		struct wlr_drm_crtc *crtc = conn->crtc;
+		if (crtc == NULL) {
+			// No CRTC to validate this configuration against
+			goto out;
+		}
+
+		saved_states[i] = crtc->pending;
+		saved_modesets[i] = crtc->pending_modeset;
+		++staged;
+
+		bool enable = (output->pending.committed & WLR_OUTPUT_STATE_ENABLED) ?
+			output->pending.enabled : output->enabled;
+		crtc->pending.active = enable;
+		if (output->pending.committed & WLR_OUTPUT_STATE_ENABLED) {
+			crtc->pending_modeset = true;
+		}
+		if (output->pending.committed & WLR_OUTPUT_STATE_MODE) {
+			struct wlr_output_mode *wlr_mode =
+				drm_connector_get_pending_mode(conn);
+			if (wlr_mode == NULL) {
+				goto out;
+			}
+			crtc->pending.mode = (struct wlr_drm_mode *)wlr_mode;
+			crtc->pending_modeset = true;
+		}
+
+		// An active CRTC needs an FB: outputs which have never rendered yet
+		// can't be fully validated
+		if (enable && plane_get_next_fb(crtc->primary) == NULL) {
+			goto out;
+		}
+	}
+
+	// Bypass drm_crtcs_commit: its bookkeeping would clear pending FBs and
+	// CRTC state, which a test must leave untouched
+	ok = drm->iface->crtcs_commit(drm, conns, n_outputs,
+		DRM_MODE_ATOMIC_TEST_ONLY);
+
+out:
+	for (size_t i = 0; i < staged; ++i) {
+		conns[i]->crtc->pending = saved_states[i];
+		conns[i]->crtc->pending_modeset = saved_modesets[i];
+	}
+	return ok;
+}
+
 static bool drm_connector_set_cursor(struct wlr_output *output,
 		struct wlr_texture *texture, float scale,
 		enum wl_output_transform transform,
@@ -947,7 +1271,7 @@ static bool drm_connector_set_cursor(struct wlr_output *output,
 		wlr_render_texture_with_matrix(rend, texture, matrix, 1.0);
 		wlr_renderer_end(rend);
 
-		if (!drm_plane_lock_surface(plane, drm)) {
+		if (!drm_plane_lock_surface(plane, drm, NULL)) {
 			return false;
 		}
 
@@ -984,6 +1308,19 @@ static bool drm_connector_move_cursor(struct wlr_output *output,
 	conn->cursor_x = box.x;
 	conn->cursor_y = box.y;
 
+	// Move the cursor plane directly when nothing else needs to change:
+	// high-rate mice would otherwise turn every motion event into a full
+	// commit. Fall back to scheduling a frame when a page-flip is in
+	// flight (the new position rides that flip) or the update fails.
+	struct wlr_drm_backend *drm = conn->backend;
+	if (drm->session->active && conn->state == WLR_DRM_CONN_CONNECTED &&
+			!conn->pending_page_flip_crtc && !conn->queued_page_flip &&
+			plane->cursor_scanout_enabled &&
+			drm_connector_is_cursor_visible(conn) &&
+			drm->iface->crtc_move_cursor(drm, conn)) {
+		return true;
+	}
+
 	wlr_output_update_needs_frame(output);
 	return true;
 }
@@ -1017,6 +1354,8 @@ static void drm_connector_destroy_output(struct wlr_output *output) {
 	conn->desired_mode = NULL;
 	conn->possible_crtcs = 0;
 	conn->pending_page_flip_crtc = 0;
+	conn->queued_page_flip = false;
+	conn->vrr_capable = false;
 
 	struct wlr_drm_mode *mode, *mode_tmp;
 	wl_list_for_each_safe(mode, mode_tmp, &conn->output.modes, wlr_mode.link) {
@@ -1048,6 +1387,88 @@ uint32_t wlr_drm_connector_get_id(struct wlr_output *output) {
 	return conn->id;
 }
 
+int wlr_drm_create_lease(struct wlr_output **outputs, size_t n_outputs,
+		uint32_t *lessee_id) {
+	if (n_outputs == 0) {
+		wlr_log(WLR_ERROR, "Can't lease 0 outputs");
+		return -1;
+	}
+
+	struct wlr_drm_backend *drm = NULL;
+	// Connector + CRTC + primary plane per output, plus an optional cursor
+	// plane
+	uint32_t objects[n_outputs * 4];
+	size_t n_objects = 0;
+	for (size_t i = 0; i < n_outputs; ++i) {
+		struct wlr_drm_connector *conn =
+			get_drm_connector_from_output(outputs[i]);
+		if (drm == NULL) {
+			drm = conn->backend;
+		} else if (conn->backend != drm) {
+			wlr_log(WLR_ERROR,
+				"Can't lease outputs from different DRM backends");
+			return -1;
+		}
+
+		if (conn->lessee_id != 0) {
+			wlr_drm_conn_log(conn, WLR_ERROR, "Connector is already leased");
+			return -1;
+		}
+		if (conn->crtc == NULL) {
+			wlr_drm_conn_log(conn, WLR_ERROR,
+				"Can't lease a connector without a CRTC");
+			return -1;
+		}
+
+		objects[n_objects++] = conn->id;
+		objects[n_objects++] = conn->crtc->id;
+		objects[n_objects++] = conn->crtc->primary->id;
+		if (conn->crtc->cursor != NULL) {
+			objects[n_objects++] = conn->crtc->cursor->id;
+		}
+	}
+
+	wlr_log(WLR_DEBUG, "Issuing DRM lease with %zu objects", n_objects);
+	uint32_t id;
+	int lease_fd = drmModeCreateLease(drm->fd, objects, n_objects, O_CLOEXEC,
+		&id);
+	if (lease_fd < 0) {
+		wlr_log_errno(WLR_ERROR, "Failed to create DRM lease");
+		return -1;
+	}
+
+	for (size_t i = 0; i < n_outputs; ++i) {
+		struct wlr_drm_connector *conn =
+			get_drm_connector_from_output(outputs[i]);
+		conn->lessee_id = id;
+	}
+
+	if (lessee_id != NULL) {
+		*lessee_id = id;
+	}
+	return lease_fd;
+}
+
+bool wlr_drm_backend_terminate_lease(struct wlr_backend *backend,
+		uint32_t lessee_id) {
+	struct wlr_drm_backend *drm = get_drm_backend_from_backend(backend);
+
+	wlr_log(WLR_DEBUG, "Terminating DRM lease %"PRIu32, lessee_id);
+	int ret = drmModeRevokeLease(drm->fd, lessee_id);
+	if (ret < 0) {
+		wlr_log_errno(WLR_ERROR, "Failed to revoke DRM lease");
+	}
+
+	struct wlr_drm_connector *conn;
+	wl_list_for_each(conn, &drm->outputs, link) {
+		if (conn->lessee_id == lessee_id) {
+			conn->lessee_id = 0;
+		}
+	}
+
+	return ret >= 0;
+}
+
 static const int32_t subpixel_map[] = {
 	[DRM_MODE_SUBPIXEL_UNKNOWN] = WL_OUTPUT_SUBPIXEL_UNKNOWN,
 	[DRM_MODE_SUBPIXEL_HORIZONTAL_RGB] = WL_OUTPUT_SUBPIXEL_HORIZONTAL_RGB,
@@ -1076,6 +1497,11 @@ static void dealloc_crtc(struct wlr_drm_connector *conn) {
 	drm_plane_finish_surface(conn->crtc->cursor);
 	if (conn->crtc->cursor != NULL) {
 		conn->crtc->cursor->cursor_enabled = false;
+		conn->crtc->cursor->cursor_scanout_enabled = false;
+	}
+	drm_plane_finish_surface(conn->crtc->overlay);
+	if (conn->crtc->overlay != NULL) {
+		conn->crtc->overlay->overlay_enabled = false;
 	}
 
 	conn->crtc = NULL;
@@ -1100,9 +1526,17 @@ static void realloc_crtcs(struct wlr_drm_backend *drm) {
 		previous_match[i] = UNMATCHED;
 	}
 
+	// CRTCs leased out to another DRM master can't be re-assigned
+	uint32_t leased_crtcs = 0;
+	struct wlr_drm_connector *conn;
+	wl_list_for_each(conn, &drm->outputs, link) {
+		if (conn->lessee_id != 0 && conn->crtc != NULL) {
+			leased_crtcs |= 1 << (conn->crtc - drm->crtcs);
+		}
+	}
+
 	wlr_log(WLR_DEBUG, "State before reallocation:");
 	size_t i = 0;
-	struct wlr_drm_connector *conn;
 	wl_list_for_each(conn, &drm->outputs, link) {
 		connectors[i] = conn;
 
@@ -1114,12 +1548,15 @@ static void realloc_crtcs(struct wlr_drm_backend *drm) {
 			previous_match[conn->crtc - drm->crtcs] = i;
 		}
 
-		// Only search CRTCs for user-enabled outputs (that are already
-		// connected or in need of a modeset)
-		if ((conn->state == WLR_DRM_CONN_CONNECTED ||
+		if (conn->lessee_id != 0 && conn->crtc != NULL) {
+			// Pin the leased connector to the CRTC it was leased with
+			connector_constraints[i] = 1 << (conn->crtc - drm->crtcs);
+		} else if ((conn->state == WLR_DRM_CONN_CONNECTED ||
 				conn->state == WLR_DRM_CONN_NEEDS_MODESET) &&
 				conn->desired_enabled) {
-			connector_constraints[i] = conn->possible_crtcs;
+			// Only search CRTCs for user-enabled outputs (that are already
+			// connected or in need of a modeset)
+			connector_constraints[i] = conn->possible_crtcs & ~leased_crtcs;
 		} else {
 			// Will always fail to match anything
 			connector_constraints[i] = 0;
@@ -1167,6 +1604,12 @@ static void realloc_crtcs(struct wlr_drm_backend *drm) {
 		wlr_log(WLR_DEBUG, "  '%s' crtc=%zd state=%d desired_enabled=%d",
 			conn->name, connector_match[i], conn->state, conn->desired_enabled);
 
+		// The lessee owns the leased resources: don't disable the CRTC or
+		// touch the planes behind its back
+		if (conn->lessee_id != 0) {
+			continue;
+		}
+
 		// We don't need to change anything.
 		if (prev_enabled && connector_match[i] == conn->crtc - drm->crtcs) {
 			continue;
@@ -1224,6 +1667,125 @@ static uint32_t get_possible_crtcs(int fd, drmModeRes *res,
 
 static void disconnect_drm_connector(struct wlr_drm_connector *conn);
 
+/*
+ * Warm-start snapshot. The expensive part of a compositor start is the full
+ * connector probe with its blocking EDID reads, but the kernel keeps probed
+ * connector state for the rest of the boot and refreshes it on hotplug
+ * uevents. A small per-device snapshot records that a full probe succeeded in
+ * this kernel boot; when a restarted compositor finds a matching snapshot it
+ * reads the kernel's current state instead of probing again, the same way
+ * uevent-triggered rescans already do.
+ */
+
+#define DRM_WARM_START_VERSION 1
+
+static bool drm_warm_start_path(struct wlr_drm_backend *drm,
+		char *buf, size_t size) {
+	char dir[256];
+	const char *cache_home = getenv("XDG_CACHE_HOME");
+	if (cache_home != NULL && cache_home[0] != '\0') {
+		snprintf(dir, sizeof(dir), "%s/wlroots", cache_home);
+	} else {
+		const char *home = getenv("HOME");
+		if (home == NULL || home[0] == '\0') {
+			return false;
+		}
+		snprintf(dir, sizeof(dir), "%s/.cache/wlroots", home);
+	}
+
+	if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+		return false;
+	}
+
+	// One snapshot per device node
+	char dev[64];
+	snprintf(dev, sizeof(dev), "%s", drm->name);
+	for (char *p = dev; *p != '\0'; ++p) {
+		if (*p == '/') {
+			*p = '-';
+		}
+	}
+
+	snprintf(buf, size, "%s/drm-probe%s", dir, dev);
+	return true;
+}
+
+static bool read_boot_id(char *buf, size_t size) {
+	FILE *f = fopen("/proc/sys/kernel/random/boot_id", "re");
+	if (f == NULL) {
+		return false;
+	}
+	bool ok = fgets(buf, size, f) != NULL;
+	fclose(f);
+	if (!ok) {
+		return false;
+	}
+	buf[strcspn(buf, "\n")] = '\0';
+	return buf[0] != '\0';
+}
+
+static bool drm_warm_start_usable(struct wlr_drm_backend *drm) {
+	const char *no_warm = getenv("WLR_DRM_NO_WARM_START");
+	if (no_warm != NULL && strcmp(no_warm, "1") == 0) {
+		return false;
+	}
+
+	char path[512], boot_id[64];
+	if (!drm_warm_start_path(drm, path, sizeof(path)) ||
+			!read_boot_id(boot_id, sizeof(boot_id))) {
+		return false;
+	}
+
+	FILE *f = fopen(path, "re");
+	if (f == NULL) {
+		return false;
+	}
+	int version = 0;
+	char cached_boot_id[64] = {0};
+	bool ok = fscanf(f, "%d %63s", &version, cached_boot_id) == 2;
+	fclose(f);
+
+	// A snapshot from a previous boot says nothing about this one
+	return ok && version == DRM_WARM_START_VERSION &&
+		strcmp(boot_id, cached_boot_id) == 0;
+}
+
+static void drm_warm_start_store(struct wlr_drm_backend *drm) {
+	char path[512], boot_id[64];
+	if (!drm_warm_start_path(drm, path, sizeof(path)) ||
+			!read_boot_id(boot_id, sizeof(boot_id))) {
+		return;
+	}
+
+	// Write to a temporary file and rename it, so that concurrent
+	// compositor instances never read a partially-written snapshot
+	char tmp[520];
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	FILE *f = fopen(tmp, "we");
+	if (f == NULL) {
+		return;
+	}
+	fprintf(f, "%d %s\n", DRM_WARM_START_VERSION, boot_id);
+	fclose(f);
+	if (rename(tmp, path) != 0) {
+		unlink(tmp);
+	}
+}
+
+struct drm_connector_probe {
+	pthread_t thread;
+	bool started;
+	int fd;
+	uint32_t conn_id;
+	drmModeConnector *conn;
+};
+
+static void *drm_connector_probe_thread(void *data) {
+	struct drm_connector_probe *probe = data;
+	probe->conn = drmModeGetConnector(probe->fd, probe->conn_id);
+	return NULL;
+}
+
 void scan_drm_connectors(struct wlr_drm_backend *drm) {
 	/*
 	 * This GPU is not really a modesetting device.
@@ -1249,9 +1811,55 @@ void scan_drm_connectors(struct wlr_drm_backend *drm) {
 	size_t new_outputs_len = 0;
 	struct wlr_drm_connector *new_outputs[res->count_connectors + 1];
 
+	// When a compositor from this same kernel boot has already done a full
+	// probe, the kernel's connector state is still valid and the initial
+	// scan can reuse it, bringing a restart down to milliseconds
+	bool warm_start = !drm->scanned && drm_warm_start_usable(drm);
+	if (warm_start) {
+		wlr_log(WLR_INFO, "Warm start: reusing kernel connector probe state");
+	}
+
+	// The initial scan forces a probe of every connector, and each probe can
+	// block on an EDID read over DDC (hundreds of milliseconds per output on
+	// some monitors). The probes are independent ioctls, so issue them from
+	// one thread per connector and join before processing the results
+	// sequentially.
+	struct drm_connector_probe *probes = NULL;
+	if (!drm->scanned && !warm_start && res->count_connectors > 1) {
+		probes = calloc(res->count_connectors, sizeof(*probes));
+	}
+	if (probes != NULL) {
+		for (int i = 0; i < res->count_connectors; ++i) {
+			probes[i].fd = drm->fd;
+			probes[i].conn_id = res->connectors[i];
+			probes[i].started = pthread_create(&probes[i].thread, NULL,
+				drm_connector_probe_thread, &probes[i]) == 0;
+			if (!probes[i].started) {
+				// Probe inline if the thread couldn't be spawned
+				probes[i].conn = drmModeGetConnector(drm->fd,
+					res->connectors[i]);
+			}
+		}
+		for (int i = 0; i < res->count_connectors; ++i) {
+			if (probes[i].started) {
+				pthread_join(probes[i].thread, NULL);
+			}
+		}
+	}
+
 	for (int i = 0; i < res->count_connectors; ++i) {
-		drmModeConnector *drm_conn = drmModeGetConnector(drm->fd,
-			res->connectors[i]);
+		// Rescans happen in response to a uevent, and the kernel has probed
+		// the connectors to generate it. Reuse its results instead of forcing
+		// another probe: re-reading EDIDs over DDC can block for seconds on
+		// DP-MST hubs. Only the initial scan forces a probe.
+		drmModeConnector *drm_conn;
+		if (probes != NULL) {
+			drm_conn = probes[i].conn;
+		} else if (drm->scanned || warm_start) {
+			drm_conn = drmModeGetConnectorCurrent(drm->fd, res->connectors[i]);
+		} else {
+			drm_conn = drmModeGetConnector(drm->fd, res->connectors[i]);
+		}
 		if (!drm_conn) {
 			wlr_log_errno(WLR_ERROR, "Failed to get DRM connector");
 			continue;
@@ -1343,7 +1951,22 @@ void scan_drm_connectors(struct wlr_drm_backend *drm) {
 				wlr_conn->output.phys_width, wlr_conn->output.phys_height);
 			wlr_conn->output.subpixel = subpixel_map[drm_conn->subpixel];
 
-			get_drm_connector_props(drm->fd, wlr_conn->id, &wlr_conn->props);
+			// Property IDs are stable for the lifetime of the kernel
+			// connector object, so only resolve the name table on the first
+			// connect; reconnects (DP link flaps, MST hubs) skip the
+			// per-property ioctls
+			if (wlr_conn->props.crtc_id == 0) {
+				get_drm_connector_props(drm->fd, wlr_conn->id,
+					&wlr_conn->props);
+			}
+
+			// VRR capability depends on the connected display's EDID, so read
+			// it once per connect instead of on every commit
+			uint64_t vrr_capable;
+			wlr_conn->vrr_capable = wlr_conn->props.vrr_capable != 0 &&
+				get_drm_prop(drm->fd, wlr_conn->id,
+					wlr_conn->props.vrr_capable, &vrr_capable) &&
+				vrr_capable;
 
 			size_t edid_len = 0;
 			uint8_t *edid = get_drm_prop_blob(drm->fd,
@@ -1416,6 +2039,12 @@ void scan_drm_connectors(struct wlr_drm_backend *drm) {
 				wlr_conn->state == WLR_DRM_CONN_NEEDS_MODESET) &&
 				drm_conn->connection != DRM_MODE_CONNECTED) {
 			wlr_log(WLR_INFO, "'%s' disconnected", wlr_conn->name);
+			if (wlr_conn->lessee_id != 0) {
+				// The leased resources are gone with the display: revoke
+				// the lease so its CRTC becomes available again
+				wlr_drm_backend_terminate_lease(&drm->backend,
+					wlr_conn->lessee_id);
+			}
 			disconnect_drm_connector(wlr_conn);
 		}
 
@@ -1423,6 +2052,7 @@ void scan_drm_connectors(struct wlr_drm_backend *drm) {
 		drmModeFreeConnector(drm_conn);
 	}
 
+	free(probes);
 	drmModeFreeResources(res);
 
 	// Iterate in reverse order because we'll remove items from the list and
@@ -1436,9 +2066,20 @@ void scan_drm_connectors(struct wlr_drm_backend *drm) {
 		}
 
 		wlr_log(WLR_INFO, "'%s' disappeared", conn->name);
+		if (conn->lessee_id != 0) {
+			wlr_drm_backend_terminate_lease(&drm->backend, conn->lessee_id);
+		}
 		destroy_drm_connector(conn);
 	}
 
+	if (!drm->scanned) {
+		// The kernel's state is now backed by validated probe results (either
+		// a fresh full probe, or the earlier one the warm start reused):
+		// record that for the next compositor start in this boot
+		drm_warm_start_store(drm);
+	}
+	drm->scanned = true;
+
 	realloc_crtcs(drm);
 
 	for (size_t i = 0; i < new_outputs_len; ++i) {
@@ -1460,6 +2101,9 @@ static void page_flip_handler(int fd, unsigned seq,
 		unsigned tv_sec, unsigned tv_usec, unsigned crtc_id, void *data) {
 	struct wlr_drm_backend *drm = data;
 
+	wlr_trace(drm_page_flip, crtc_id, seq, tv_sec, tv_usec);
+	trace_span_instant("page_flip");
+
 	bool found = false;
 	struct wlr_drm_connector *conn;
 	wl_list_for_each(conn, &drm->outputs, link) {
@@ -1489,6 +2133,19 @@ static void page_flip_handler(int fd, unsigned seq,
 		drm_fb_move(&conn->crtc->cursor->current_fb,
 			&conn->crtc->cursor->queued_fb);
 	}
+	if (conn->crtc->overlay && conn->crtc->overlay->queued_fb) {
+		drm_fb_move(&conn->crtc->overlay->current_fb,
+			&conn->crtc->overlay->queued_fb);
+	}
+
+	// Now that the kernel's queue has room again, submit the commit that was
+	// held back while this page-flip was in flight.
+	bool was_queued = conn->queued_page_flip;
+	bool dequeued = false;
+	if (conn->queued_page_flip) {
+		conn->queued_page_flip = false;
+		dequeued = drm_crtc_page_flip(conn);
+	}
 
 	uint32_t present_flags = WLR_OUTPUT_PRESENT_VSYNC |
 		WLR_OUTPUT_PRESENT_HW_CLOCK | WLR_OUTPUT_PRESENT_HW_COMPLETION;
@@ -1507,8 +2164,9 @@ static void page_flip_handler(int fd, unsigned seq,
 	};
 	struct wlr_output_event_present present_event = {
 		/* The DRM backend guarantees that the presentation event will be for
-		 * the last submitted frame. */
-		.commit_seq = conn->output.commit_seq,
+		 * the last submitted frame, except when a commit was queued behind
+		 * this page-flip: the on-screen frame then is the one before it. */
+		.commit_seq = conn->output.commit_seq - (was_queued ? 1 : 0),
 		.when = &present_time,
 		.seq = seq,
 		.refresh = mhz_to_nsec(conn->output.refresh),
@@ -1516,7 +2174,12 @@ static void page_flip_handler(int fd, unsigned seq,
 	};
 	wlr_output_send_present(&conn->output, &present_event);
 
-	if (drm->session->active && conn->output.enabled) {
+	// When a queued commit was just submitted, the frame event is sent from
+	// its own page-flip event instead, keeping one frame event per flip.
+	// With frame pipelining the dequeue frees the queue slot, which
+	// wlr_output_send_frame turns into the next frame event.
+	if (drm->session->active && conn->output.enabled &&
+			(!dequeued || conn->output.frame_pipelining_enabled)) {
 		wlr_output_send_frame(&conn->output);
 	}
 }
@@ -1531,6 +2194,125 @@ int handle_drm_event(int fd, uint32_t mask, void *data) {
 	return 1;
 }
 
+/* A blocking ALLOW_MODESET commit can stall the event loop for tens to
+ * hundreds of milliseconds while the kernel programs the display, freezing
+ * input and the other outputs. Instead, the pre-built atomic request is
+ * handed to a transient worker thread which runs the blocking ioctl and
+ * reports back through the backend's modeset socket; the connector is marked
+ * transitioning and rejects commits until the completion message arrives.
+ *
+ * The worker only touches plain values (fds, the request) — never the
+ * backend or connector structs, which the main thread keeps mutating. The
+ * connector pointer rides along opaquely and is validated against the output
+ * list before use, in case the connector was destroyed mid-modeset. */
+struct drm_async_modeset_job {
+	int drm_fd;
+	int notify_fd;
+	drmModeAtomicReq *req;
+	uint32_t flags;
+	void *event_data; // user data for the page-flip event
+	struct wlr_drm_connector *conn; // opaque
+};
+
+struct drm_async_modeset_msg {
+	struct wlr_drm_connector *conn;
+	int error; // 0 on success
+};
+
+static void *drm_async_modeset_worker(void *data) {
+	struct drm_async_modeset_job *job = data;
+
+	int ret = drmModeAtomicCommit(job->drm_fd, job->req, job->flags,
+		job->event_data);
+
+	struct drm_async_modeset_msg msg = {
+		.conn = job->conn,
+		.error = ret != 0 ? -errno : 0,
+	};
+	send(job->notify_fd, &msg, sizeof(msg), MSG_NOSIGNAL);
+
+	close(job->notify_fd);
+	drmModeAtomicFree(job->req);
+	free(job);
+	return NULL;
+}
+
+int handle_drm_async_modeset(int fd, uint32_t mask, void *data) {
+	struct wlr_drm_backend *drm = data;
+
+	struct drm_async_modeset_msg msg;
+	while (recv(fd, &msg, sizeof(msg), MSG_DONTWAIT) == sizeof(msg)) {
+		struct wlr_drm_connector *conn = NULL, *c;
+		wl_list_for_each(c, &drm->outputs, link) {
+			if (c == msg.conn) {
+				conn = c;
+				break;
+			}
+		}
+		if (conn == NULL) {
+			// The connector was destroyed while its modeset ran
+			continue;
+		}
+
+		conn->modeset_in_flight = false;
+
+		if (msg.error != 0) {
+			wlr_drm_conn_log(conn, WLR_ERROR,
+				"Asynchronous modeset failed: %s", strerror(-msg.error));
+			// The page-flip event will never arrive: clear the flip
+			// bookkeeping so the compositor's next commit can retry
+			conn->pending_page_flip_crtc = 0;
+			conn->queued_page_flip = false;
+			conn->output.frame_pending = false;
+		}
+
+		// If the flip raced ahead of this message and a commit was
+		// rejected meanwhile, this restarts the render loop; it is a no-op
+		// when a frame is already pending
+		wlr_output_schedule_frame(&conn->output);
+	}
+	return 0;
+}
+
+bool drm_async_modeset_start(struct wlr_drm_backend *drm,
+		struct wlr_drm_connector *conn, drmModeAtomicReq *req,
+		uint32_t flags) {
+	if (drm->modeset_sock[1] < 0) {
+		return false;
+	}
+
+	struct drm_async_modeset_job *job = calloc(1, sizeof(*job));
+	if (job == NULL) {
+		wlr_log_errno(WLR_ERROR, "Allocation failed");
+		return false;
+	}
+	job->drm_fd = drm->fd;
+	job->req = req;
+	job->flags = flags;
+	job->event_data = drm;
+	job->conn = conn;
+
+	job->notify_fd = fcntl(drm->modeset_sock[1], F_DUPFD_CLOEXEC, 0);
+	if (job->notify_fd < 0) {
+		wlr_log_errno(WLR_ERROR, "Failed to dup modeset socket");
+		free(job);
+		return false;
+	}
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, drm_async_modeset_worker, job) != 0) {
+		wlr_log(WLR_ERROR, "Failed to create modeset thread");
+		close(job->notify_fd);
+		free(job);
+		return false;
+	}
+	pthread_detach(thread);
+
+	conn->modeset_in_flight = true;
+	wlr_drm_conn_log(conn, WLR_DEBUG, "Modeset handed to a worker thread");
+	return true;
+}
+
 void restore_drm_outputs(struct wlr_drm_backend *drm) {
 	uint64_t to_close = (UINT64_C(1) << wl_list_length(&drm->outputs)) - 1;
 
@@ -113,6 +113,27 @@ static bool legacy_crtc_commit(struct wlr_drm_backend *drm,
 	return true;
 }
 
+static bool legacy_crtcs_commit(struct wlr_drm_backend *drm,
+		struct wlr_drm_connector **conns, size_t n_conns, uint32_t flags) {
+	// The legacy interface has no way to update several CRTCs with a single
+	// ioctl: commit each connector in turn.
+	bool ok = true;
+	for (size_t i = 0; i < n_conns; ++i) {
+		ok &= legacy_crtc_commit(drm, conns[i], flags);
+	}
+	return ok;
+}
+
+static bool legacy_crtc_move_cursor(struct wlr_drm_backend *drm,
+		struct wlr_drm_connector *conn) {
+	if (drmModeMoveCursor(drm->fd, conn->crtc->id,
+			conn->cursor_x, conn->cursor_y) != 0) {
+		wlr_drm_conn_log_errno(conn, WLR_DEBUG, "drmModeMoveCursor failed");
+		return false;
+	}
+	return true;
+}
+
 static void fill_empty_gamma_table(size_t size,
 		uint16_t *r, uint16_t *g, uint16_t *b) {
 	assert(0xFFFF < UINT64_MAX / (size - 1));
@@ -156,4 +177,6 @@ bool drm_legacy_crtc_set_gamma(struct wlr_drm_backend *drm,
 
 const struct wlr_drm_interface legacy_iface = {
 	.crtc_commit = legacy_crtc_commit,
+	.crtcs_commit = legacy_crtcs_commit,
+	.crtc_move_cursor = legacy_crtc_move_cursor,
 };
@@ -90,6 +90,16 @@ static bool init_drm_surface(struct wlr_drm_surface *surf,
 		return false;
 	}
 
+	// Pre-allocate the buffers and their FBOs now, while no frame is due,
+	// so the first frames after a modeset don't stutter on gbm allocations
+	if (!wlr_swapchain_warmup(surf->swapchain, renderer->wlr_rend)) {
+		wlr_log(WLR_ERROR, "Failed to warm up swapchain");
+	}
+
+	for (size_t i = 0; i < WLR_SWAPCHAIN_CAP; ++i) {
+		pixman_region32_init(&surf->past_damage[i]);
+	}
+
 	return true;
 }
 
@@ -98,6 +108,10 @@ static void finish_drm_surface(struct wlr_drm_surface *surf) {
 		return;
 	}
 
+	for (size_t i = 0; i < WLR_SWAPCHAIN_CAP; ++i) {
+		pixman_region32_fini(&surf->past_damage[i]);
+	}
+
 	wlr_buffer_unlock(surf->back_buffer);
 	wlr_swapchain_destroy(surf->swapchain);
 
@@ -131,7 +145,7 @@ void drm_surface_unset_current(struct wlr_drm_surface *surf) {
 }
 
 static struct wlr_buffer *drm_surface_blit(struct wlr_drm_surface *surf,
-		struct wlr_buffer *buffer) {
+		struct wlr_buffer *buffer, pixman_region32_t *damage) {
 	struct wlr_renderer *renderer = surf->renderer->wlr_rend;
 
 	if (surf->width != (uint32_t)buffer->width ||
@@ -150,19 +164,68 @@ static struct wlr_buffer *drm_surface_blit(struct wlr_drm_surface *surf,
 		return NULL;
 	}
 
-	if (!drm_surface_make_current(surf, NULL)) {
+	int buffer_age = -1;
+	if (!drm_surface_make_current(surf, &buffer_age)) {
 		wlr_texture_destroy(tex);
 		return NULL;
 	}
 
+	// A destination buffer of age N is missing the damage of the last N
+	// frames; without damage information or a usable age, copy everything
+	pixman_region32_t blit_damage;
+	pixman_region32_init(&blit_damage);
+	if (damage == NULL || buffer_age <= 0 ||
+			buffer_age > (int)WLR_SWAPCHAIN_CAP) {
+		pixman_region32_union_rect(&blit_damage, &blit_damage,
+			0, 0, surf->width, surf->height);
+	} else {
+		pixman_region32_copy(&blit_damage, damage);
+		for (int i = 0; i < buffer_age - 1; ++i) {
+			pixman_region32_union(&blit_damage, &blit_damage,
+				&surf->past_damage[
+					(surf->past_damage_idx + i) % WLR_SWAPCHAIN_CAP]);
+		}
+		pixman_region32_intersect_rect(&blit_damage, &blit_damage,
+			0, 0, surf->width, surf->height);
+	}
+
+	// Record this frame's own damage (not the whole repaint) for future ages
+	surf->past_damage_idx =
+		(surf->past_damage_idx + WLR_SWAPCHAIN_CAP - 1) % WLR_SWAPCHAIN_CAP;
+	pixman_region32_t *record = &surf->past_damage[surf->past_damage_idx];
+	if (damage != NULL) {
+		pixman_region32_intersect_rect(record, damage,
+			0, 0, surf->width, surf->height);
+	} else {
+		pixman_region32_clear(record);
+		pixman_region32_union_rect(record, record,
+			0, 0, surf->width, surf->height);
+	}
+
 	float mat[9];
 	wlr_matrix_projection(mat, 1, 1, WL_OUTPUT_TRANSFORM_NORMAL);
 
 	wlr_renderer_begin(renderer, surf->width, surf->height);
-	wlr_renderer_clear(renderer, (float[]){ 0.0, 0.0, 0.0, 0.0 });
-	wlr_render_texture_with_matrix(renderer, tex, mat, 1.0f);
+
+	int nrects;
+	pixman_box32_t *rects = pixman_region32_rectangles(&blit_damage, &nrects);
+	for (int i = 0; i < nrects; ++i) {
+		struct wlr_box scissor = {
+			.x = rects[i].x1,
+			.y = rects[i].y1,
+			.width = rects[i].x2 - rects[i].x1,
+			.height = rects[i].y2 - rects[i].y1,
+		};
+		wlr_renderer_scissor(renderer, &scissor);
+		wlr_renderer_clear(renderer, (float[]){ 0.0, 0.0, 0.0, 0.0 });
+		wlr_render_texture_with_matrix(renderer, tex, mat, 1.0f);
+	}
+	wlr_renderer_scissor(renderer, NULL);
+
 	wlr_renderer_end(renderer);
 
+	pixman_region32_fini(&blit_damage);
+
 	assert(surf->back_buffer != NULL);
 	struct wlr_buffer *out = wlr_buffer_lock(surf->back_buffer);
 
@@ -183,6 +246,11 @@ void drm_plane_finish_surface(struct wlr_drm_plane *plane) {
 	drm_fb_clear(&plane->queued_fb);
 	drm_fb_clear(&plane->current_fb);
 
+	if (plane->pending_fence_fd >= 0) {
+		close(plane->pending_fence_fd);
+		plane->pending_fence_fd = -1;
+	}
+
 	finish_drm_surface(&plane->surf);
 	finish_drm_surface(&plane->mgpu_surf);
 }
@@ -214,6 +282,18 @@ bool drm_plane_init_surface(struct wlr_drm_plane *plane,
 	if (!wlr_drm_format_set_has(&plane->formats, format, DRM_FORMAT_MOD_INVALID)) {
 		format = strip_alpha_channel(format);
 	}
+
+	// The modeset after a VT switch re-initializes the plane with unchanged
+	// parameters. Keep the swapchain and its framebuffers in that case
+	// instead of rebuilding the whole surface.
+	if (plane->surf.swapchain != NULL &&
+			plane->surf.width == (uint32_t)width &&
+			plane->surf.height == height &&
+			plane->surf.format == format &&
+			plane->surf.with_modifiers == with_modifiers) {
+		return true;
+	}
+
 	const struct wlr_drm_format *plane_format =
 		wlr_drm_format_set_get(&plane->formats, format);
 	if (plane_format == NULL) {
@@ -237,13 +317,20 @@ bool drm_plane_init_surface(struct wlr_drm_plane *plane,
 	}
 
 	struct wlr_drm_format *format_implicit_modifier = NULL;
+	struct wlr_drm_format *owned_format = NULL;
+	const struct wlr_drm_format *drm_format;
 	if (!with_modifiers) {
 		format_implicit_modifier = wlr_drm_format_create(format);
-		render_format = format_implicit_modifier;
+		owned_format =
+			wlr_drm_format_intersect(plane_format, format_implicit_modifier);
+		drm_format = owned_format;
+	} else {
+		// The result is owned by the format-set cache and stays valid as long
+		// as neither set changes, so repeated plane re-inits don't re-compute
+		// the intersection
+		drm_format = wlr_drm_format_set_intersect_cached(&plane->formats,
+			render_formats, format);
 	}
-
-	struct wlr_drm_format *drm_format =
-		wlr_drm_format_intersect(plane_format, render_format);
 	if (drm_format == NULL) {
 		wlr_log(WLR_ERROR,
 			"Failed to intersect plane and render formats 0x%"PRIX32,
@@ -261,7 +348,7 @@ bool drm_plane_init_surface(struct wlr_drm_plane *plane,
 	} else {
 		struct wlr_drm_format *drm_format_linear = create_linear_format(format);
 		if (drm_format_linear == NULL) {
-			free(drm_format);
+			free(owned_format);
 			free(format_implicit_modifier);
 			return false;
 		}
@@ -277,7 +364,12 @@ bool drm_plane_init_surface(struct wlr_drm_plane *plane,
 		}
 	}
 
-	free(drm_format);
+	if (ok) {
+		plane->surf.format = format;
+		plane->surf.with_modifiers = with_modifiers;
+	}
+
+	free(owned_format);
 	free(format_implicit_modifier);
 
 	return ok;
@@ -295,7 +387,7 @@ void drm_fb_clear(struct wlr_drm_fb **fb_ptr) {
 }
 
 bool drm_plane_lock_surface(struct wlr_drm_plane *plane,
-		struct wlr_drm_backend *drm) {
+		struct wlr_drm_backend *drm, pixman_region32_t *damage) {
 	assert(plane->surf.back_buffer != NULL);
 	struct wlr_buffer *buf = wlr_buffer_lock(plane->surf.back_buffer);
 
@@ -303,19 +395,53 @@ bool drm_plane_lock_surface(struct wlr_drm_plane *plane,
 	// making another context current.
 	drm_surface_unset_current(&plane->surf);
 
+	plane->mgpu_was_direct = false;
+	if (drm->parent && !plane->mgpu_disable_direct &&
+			drm_fb_import(&plane->pending_fb, drm, buf, &plane->formats)) {
+		// The scanout GPU can import the render GPU's buffer directly
+		// (plane->surf is allocated with a LINEAR layout for exactly this
+		// reason): skip the cross-GPU copy entirely.
+		plane->mgpu_was_direct = true;
+
+		if (plane->pending_fence_fd >= 0) {
+			close(plane->pending_fence_fd);
+		}
+		plane->pending_fence_fd =
+			wlr_renderer_get_fence_fd(plane->surf.renderer->wlr_rend);
+
+		wlr_buffer_unlock(buf);
+		return true;
+	}
+
 	struct wlr_buffer *local_buf;
+	struct wlr_drm_surface *local_surf = &plane->surf;
 	if (drm->parent) {
-		// Perform a copy across GPUs
-		local_buf = drm_surface_blit(&plane->mgpu_surf, buf);
+		if (!plane->mgpu_disable_direct) {
+			wlr_log(WLR_DEBUG, "Scanout GPU can't import the render GPU's "
+				"buffer directly, blitting across GPUs instead");
+			plane->mgpu_disable_direct = true;
+		}
+
+		// Perform a copy across GPUs, limited to the damaged region
+		local_buf = drm_surface_blit(&plane->mgpu_surf, buf, damage);
 		if (!local_buf) {
 			wlr_log(WLR_ERROR, "Failed to blit buffer across GPUs");
 			return false;
 		}
+		local_surf = &plane->mgpu_surf;
 	} else {
 		local_buf = wlr_buffer_lock(buf);
 	}
 	wlr_buffer_unlock(buf);
 
+	// Export a fence for the rendering into the scanout buffer, so that the
+	// kernel can wait for it explicitly instead of blocking in the commit
+	if (plane->pending_fence_fd >= 0) {
+		close(plane->pending_fence_fd);
+	}
+	plane->pending_fence_fd =
+		wlr_renderer_get_fence_fd(local_surf->renderer->wlr_rend);
+
 	bool ok = drm_fb_import(&plane->pending_fb, drm, local_buf, NULL);
 	wlr_buffer_unlock(local_buf);
 	return ok;
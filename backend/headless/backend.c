@@ -3,6 +3,7 @@
 #include <drm_fourcc.h>
 #include <fcntl.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 #include <wlr/interfaces/wlr_input_device.h>
 #include <wlr/interfaces/wlr_output.h>
@@ -294,3 +295,27 @@ error_drm_fd:
 bool wlr_backend_is_headless(struct wlr_backend *backend) {
 	return backend->impl == &backend_impl;
 }
+
+void wlr_headless_backend_set_manual_frames(struct wlr_backend *wlr_backend,
+		bool manual) {
+	struct wlr_headless_backend *backend =
+		headless_backend_from_backend(wlr_backend);
+	if (backend->manual_frames == manual) {
+		return;
+	}
+	backend->manual_frames = manual;
+
+	struct wlr_headless_output *output;
+	wl_list_for_each(output, &backend->outputs, link) {
+		if (manual) {
+			// Frames are driven by commits from now on; start the virtual
+			// presentation clock from the current time so timestamps stay
+			// plausible
+			wl_event_source_timer_update(output->frame_timer, 0);
+			clock_gettime(CLOCK_MONOTONIC, &output->virtual_present_time);
+		} else if (backend->started) {
+			wl_event_source_timer_update(output->frame_timer,
+				output->frame_delay);
+		}
+	}
+}
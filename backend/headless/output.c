@@ -1,6 +1,8 @@
+#define _POSIX_C_SOURCE 200809L
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
 #include <wlr/interfaces/wlr_output.h>
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/util/log.h>
@@ -70,6 +72,12 @@ static bool output_test(struct wlr_output *wlr_output) {
 	return true;
 }
 
+static void signal_frame_idle(void *data) {
+	struct wlr_headless_output *output = data;
+	output->frame_idle = NULL;
+	wlr_output_send_frame(&output->wlr_output);
+}
+
 static bool output_commit(struct wlr_output *wlr_output) {
 	struct wlr_headless_output *output =
 		headless_output_from_output(wlr_output);
@@ -109,7 +117,35 @@ static bool output_commit(struct wlr_output *wlr_output) {
 
 		wlr_swapchain_set_buffer_submitted(output->swapchain, buffer);
 
-		wlr_output_send_present(wlr_output, NULL);
+		if (output->backend->manual_frames) {
+			// Advance the virtual presentation clock by one refresh period
+			// and complete the frame as soon as control returns to the event
+			// loop: the pipeline runs as fast as the compositor can commit
+			int32_t refresh = wlr_output->refresh > 0 ?
+				wlr_output->refresh : HEADLESS_DEFAULT_REFRESH;
+			int64_t period_nsec = 1000000000000LL / refresh;
+			output->virtual_present_time.tv_sec += period_nsec / 1000000000;
+			output->virtual_present_time.tv_nsec += period_nsec % 1000000000;
+			if (output->virtual_present_time.tv_nsec >= 1000000000) {
+				output->virtual_present_time.tv_nsec -= 1000000000;
+				++output->virtual_present_time.tv_sec;
+			}
+
+			struct wlr_output_event_present present_event = {
+				.commit_seq = wlr_output->commit_seq + 1,
+				.when = &output->virtual_present_time,
+			};
+			wlr_output_send_present(wlr_output, &present_event);
+
+			if (output->frame_idle == NULL) {
+				struct wl_event_loop *ev =
+					wl_display_get_event_loop(output->backend->display);
+				output->frame_idle = wl_event_loop_add_idle(ev,
+					signal_frame_idle, output);
+			}
+		} else {
+			wlr_output_send_present(wlr_output, NULL);
+		}
 	}
 
 	return true;
@@ -147,6 +183,9 @@ static void output_destroy(struct wlr_output *wlr_output) {
 		headless_output_from_output(wlr_output);
 	wl_list_remove(&output->link);
 	wl_event_source_remove(output->frame_timer);
+	if (output->frame_idle != NULL) {
+		wl_event_source_remove(output->frame_idle);
+	}
 	wlr_swapchain_destroy(output->swapchain);
 	wlr_buffer_unlock(output->back_buffer);
 	wlr_buffer_unlock(output->front_buffer);
@@ -167,6 +206,10 @@ bool wlr_output_is_headless(struct wlr_output *wlr_output) {
 
 static int signal_frame(void *data) {
 	struct wlr_headless_output *output = data;
+	if (output->backend->manual_frames) {
+		// Frames are driven by commits, let the timer expire
+		return 0;
+	}
 	wlr_output_send_frame(&output->wlr_output);
 	wl_event_source_timer_update(output->frame_timer, output->frame_delay);
 	return 0;
@@ -210,8 +253,15 @@ struct wlr_output *wlr_headless_add_output(struct wlr_backend *wlr_backend,
 
 	wl_list_insert(&backend->outputs, &output->link);
 
+	if (backend->manual_frames) {
+		clock_gettime(CLOCK_MONOTONIC, &output->virtual_present_time);
+	}
+
 	if (backend->started) {
-		wl_event_source_timer_update(output->frame_timer, output->frame_delay);
+		if (!backend->manual_frames) {
+			wl_event_source_timer_update(output->frame_timer,
+				output->frame_delay);
+		}
 		wlr_output_update_enabled(wlr_output, true);
 		wlr_signal_emit_safe(&backend->backend.events.new_output, wlr_output);
 	}
@@ -1,7 +1,11 @@
 #include <assert.h>
+#include <fcntl.h>
 #include <libinput.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
 #include <wlr/backend/interface.h>
 #include <wlr/backend/session.h>
 #include <wlr/util/log.h>
@@ -52,14 +56,129 @@ static int handle_libinput_readable(int fd, uint32_t mask, void *_backend) {
 		// TODO: some kind of abort?
 		return 0;
 	}
-	struct libinput_event *event;
-	while ((event = libinput_get_event(backend->libinput_context))) {
-		handle_libinput_event(backend, event);
-		libinput_event_destroy(event);
+	handle_libinput_events(backend);
+	return 0;
+}
+
+static bool set_fd_flags(int fd) {
+	int flags = fcntl(fd, F_GETFD);
+	if (flags == -1 || fcntl(fd, F_SETFD, flags | FD_CLOEXEC) == -1) {
+		return false;
+	}
+	flags = fcntl(fd, F_GETFL);
+	if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+		return false;
+	}
+	return true;
+}
+
+static void *input_thread_run(void *_backend) {
+	struct wlr_libinput_backend *backend = _backend;
+
+	struct pollfd fds[2] = {
+		{ .fd = libinput_get_fd(backend->libinput_context), .events = POLLIN },
+		{ .fd = backend->input_thread.shutdown_pipe[0], .events = POLLIN },
+	};
+
+	while (true) {
+		if (poll(fds, sizeof(fds) / sizeof(fds[0]), -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			wlr_log_errno(WLR_ERROR, "Failed to poll libinput fd");
+			break;
+		}
+		if (fds[1].revents != 0) {
+			break;
+		}
+
+		// Move events from the kernel queues into libinput's queue at
+		// hardware cadence, so a long render or a blocking commit on the
+		// main thread can't overflow evdev buffers or delay timestamps
+		pthread_mutex_lock(&backend->input_thread.mutex);
+		if (libinput_dispatch(backend->libinput_context) != 0) {
+			wlr_log(WLR_ERROR, "Failed to dispatch libinput");
+		}
+		pthread_mutex_unlock(&backend->input_thread.mutex);
+
+		if (write(backend->input_thread.wakeup_pipe[1], "1", 1) < 0) {
+			// The pipe is full: the main loop already has a wakeup pending
+		}
+	}
+	return NULL;
+}
+
+static int handle_input_thread_readable(int fd, uint32_t mask, void *_backend) {
+	struct wlr_libinput_backend *backend = _backend;
+
+	char buf[64];
+	while (read(fd, buf, sizeof(buf)) > 0) {
+		// Drain the wakeup pipe
 	}
+
+	pthread_mutex_lock(&backend->input_thread.mutex);
+	handle_libinput_events(backend);
+	pthread_mutex_unlock(&backend->input_thread.mutex);
 	return 0;
 }
 
+static bool start_input_thread(struct wlr_libinput_backend *backend) {
+	if (pipe(backend->input_thread.wakeup_pipe) != 0) {
+		wlr_log_errno(WLR_ERROR, "pipe failed");
+		return false;
+	}
+	if (pipe(backend->input_thread.shutdown_pipe) != 0) {
+		wlr_log_errno(WLR_ERROR, "pipe failed");
+		close(backend->input_thread.wakeup_pipe[0]);
+		close(backend->input_thread.wakeup_pipe[1]);
+		return false;
+	}
+	for (size_t i = 0; i < 2; ++i) {
+		if (!set_fd_flags(backend->input_thread.wakeup_pipe[i]) ||
+				!set_fd_flags(backend->input_thread.shutdown_pipe[i])) {
+			wlr_log(WLR_ERROR, "Failed to set flags on pipe");
+			goto error_pipes;
+		}
+	}
+
+	pthread_mutex_init(&backend->input_thread.mutex, NULL);
+	if (pthread_create(&backend->input_thread.thread, NULL, input_thread_run,
+			backend) != 0) {
+		wlr_log(WLR_ERROR, "Failed to start input thread");
+		pthread_mutex_destroy(&backend->input_thread.mutex);
+		goto error_pipes;
+	}
+
+	backend->input_thread.started = true;
+	wlr_log(WLR_DEBUG, "Started libinput input thread");
+	return true;
+
+error_pipes:
+	close(backend->input_thread.wakeup_pipe[0]);
+	close(backend->input_thread.wakeup_pipe[1]);
+	close(backend->input_thread.shutdown_pipe[0]);
+	close(backend->input_thread.shutdown_pipe[1]);
+	return false;
+}
+
+static void stop_input_thread(struct wlr_libinput_backend *backend) {
+	if (!backend->input_thread.started) {
+		return;
+	}
+
+	if (write(backend->input_thread.shutdown_pipe[1], "1", 1) < 0) {
+		wlr_log_errno(WLR_ERROR, "Failed to wake input thread for shutdown");
+	}
+	pthread_join(backend->input_thread.thread, NULL);
+	pthread_mutex_destroy(&backend->input_thread.mutex);
+
+	close(backend->input_thread.wakeup_pipe[0]);
+	close(backend->input_thread.wakeup_pipe[1]);
+	close(backend->input_thread.shutdown_pipe[0]);
+	close(backend->input_thread.shutdown_pipe[1]);
+	backend->input_thread.started = false;
+}
+
 static enum wlr_log_importance libinput_log_priority_to_wlr(
 		enum libinput_log_priority priority) {
 	switch (priority) {
@@ -123,8 +242,17 @@ static bool backend_start(struct wlr_backend *wlr_backend) {
 	if (backend->input_event) {
 		wl_event_source_remove(backend->input_event);
 	}
-	backend->input_event = wl_event_loop_add_fd(event_loop, libinput_fd,
-			WL_EVENT_READABLE, handle_libinput_readable, backend);
+
+	char *threaded = getenv("WLR_LIBINPUT_THREAD");
+	if (threaded != NULL && strcmp(threaded, "1") == 0 &&
+			start_input_thread(backend)) {
+		backend->input_event = wl_event_loop_add_fd(event_loop,
+				backend->input_thread.wakeup_pipe[0], WL_EVENT_READABLE,
+				handle_input_thread_readable, backend);
+	} else {
+		backend->input_event = wl_event_loop_add_fd(event_loop, libinput_fd,
+				WL_EVENT_READABLE, handle_libinput_readable, backend);
+	}
 	if (!backend->input_event) {
 		wlr_log(WLR_ERROR, "Failed to create input event on event loop");
 		return false;
@@ -156,6 +284,7 @@ static void backend_destroy(struct wlr_backend *wlr_backend) {
 	wl_list_remove(&backend->session_signal.link);
 
 	wlr_list_finish(&backend->wlr_device_lists);
+	stop_input_thread(backend);
 	if (backend->input_event) {
 		wl_event_source_remove(backend->input_event);
 	}
@@ -181,11 +310,17 @@ static void session_signal(struct wl_listener *listener, void *data) {
 		return;
 	}
 
+	if (backend->input_thread.started) {
+		pthread_mutex_lock(&backend->input_thread.mutex);
+	}
 	if (session->active) {
 		libinput_resume(backend->libinput_context);
 	} else {
 		libinput_suspend(backend->libinput_context);
 	}
+	if (backend->input_thread.started) {
+		pthread_mutex_unlock(&backend->input_thread.mutex);
+	}
 }
 
 static void handle_session_destroy(struct wl_listener *listener, void *data) {
@@ -8,6 +8,7 @@
 #include <wlr/util/log.h>
 #include "backend/libinput.h"
 #include "util/signal.h"
+#include "util/trace.h"
 
 static struct wlr_libinput_input_device *get_libinput_device_from_device(
 		struct wlr_input_device *wlr_dev) {
@@ -226,6 +227,9 @@ void handle_libinput_event(struct wlr_libinput_backend *backend,
 		struct libinput_event *event) {
 	struct libinput_device *libinput_dev = libinput_event_get_device(event);
 	enum libinput_event_type event_type = libinput_event_get_type(event);
+
+	wlr_trace(libinput_event, event_type, libinput_dev);
+
 	switch (event_type) {
 	case LIBINPUT_EVENT_DEVICE_ADDED:
 		handle_device_added(backend, libinput_dev);
@@ -310,3 +314,38 @@ void handle_libinput_event(struct wlr_libinput_backend *backend,
 		break;
 	}
 }
+
+void handle_libinput_events(struct wlr_libinput_backend *backend) {
+	struct libinput_event *event =
+		libinput_get_event(backend->libinput_context);
+	while (event != NULL) {
+		struct libinput_event *next =
+			libinput_get_event(backend->libinput_context);
+
+		if (libinput_event_get_type(event) == LIBINPUT_EVENT_POINTER_MOTION) {
+			// A high-rate mouse queues a burst of relative motions per
+			// dispatch. Sum consecutive motions from the same device and run
+			// the signal->handler->seat->client chain once with the
+			// aggregate delta and the latest timestamp, instead of once per
+			// hardware report.
+			struct libinput_device *libinput_dev =
+				libinput_event_get_device(event);
+			struct wlr_event_pointer_motion wlr_event = { 0 };
+			pointer_motion_add(event, &wlr_event);
+			while (next != NULL &&
+					libinput_event_get_type(next) ==
+						LIBINPUT_EVENT_POINTER_MOTION &&
+					libinput_event_get_device(next) == libinput_dev) {
+				pointer_motion_add(next, &wlr_event);
+				libinput_event_destroy(next);
+				next = libinput_get_event(backend->libinput_context);
+			}
+			finish_pointer_motion(libinput_dev, &wlr_event);
+		} else {
+			handle_libinput_event(backend, event);
+		}
+
+		libinput_event_destroy(event);
+		event = next;
+	}
+}
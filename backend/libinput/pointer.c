@@ -20,28 +20,38 @@ struct wlr_pointer *create_libinput_pointer(
 	return wlr_pointer;
 }
 
-void handle_pointer_motion(struct libinput_event *event,
-		struct libinput_device *libinput_dev) {
+void pointer_motion_add(struct libinput_event *event,
+		struct wlr_event_pointer_motion *wlr_event) {
+	struct libinput_event_pointer *pevent =
+		libinput_event_get_pointer_event(event);
+	wlr_event->time_msec =
+		usec_to_msec(libinput_event_pointer_get_time_usec(pevent));
+	wlr_event->delta_x += libinput_event_pointer_get_dx(pevent);
+	wlr_event->delta_y += libinput_event_pointer_get_dy(pevent);
+	wlr_event->unaccel_dx += libinput_event_pointer_get_dx_unaccelerated(pevent);
+	wlr_event->unaccel_dy += libinput_event_pointer_get_dy_unaccelerated(pevent);
+}
+
+void finish_pointer_motion(struct libinput_device *libinput_dev,
+		struct wlr_event_pointer_motion *wlr_event) {
 	struct wlr_input_device *wlr_dev =
 		get_appropriate_device(WLR_INPUT_DEVICE_POINTER, libinput_dev);
 	if (!wlr_dev) {
 		wlr_log(WLR_DEBUG, "Got a pointer event for a device with no pointers?");
 		return;
 	}
-	struct libinput_event_pointer *pevent =
-		libinput_event_get_pointer_event(event);
-	struct wlr_event_pointer_motion wlr_event = { 0 };
-	wlr_event.device = wlr_dev;
-	wlr_event.time_msec =
-		usec_to_msec(libinput_event_pointer_get_time_usec(pevent));
-	wlr_event.delta_x = libinput_event_pointer_get_dx(pevent);
-	wlr_event.delta_y = libinput_event_pointer_get_dy(pevent);
-	wlr_event.unaccel_dx = libinput_event_pointer_get_dx_unaccelerated(pevent);
-	wlr_event.unaccel_dy = libinput_event_pointer_get_dy_unaccelerated(pevent);
-	wlr_signal_emit_safe(&wlr_dev->pointer->events.motion, &wlr_event);
+	wlr_event->device = wlr_dev;
+	wlr_signal_emit_safe(&wlr_dev->pointer->events.motion, wlr_event);
 	wlr_signal_emit_safe(&wlr_dev->pointer->events.frame, wlr_dev->pointer);
 }
 
+void handle_pointer_motion(struct libinput_event *event,
+		struct libinput_device *libinput_dev) {
+	struct wlr_event_pointer_motion wlr_event = { 0 };
+	pointer_motion_add(event, &wlr_event);
+	finish_pointer_motion(libinput_dev, &wlr_event);
+}
+
 void handle_pointer_motion_abs(struct libinput_event *event,
 		struct libinput_device *libinput_dev) {
 	struct wlr_input_device *wlr_dev =
@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <wlr/interfaces/wlr_output.h>
+#include <wlr/render/null.h>
 #include <wlr/util/log.h>
 #include "backend/noop.h"
 #include "util/signal.h"
@@ -41,12 +42,21 @@ static void backend_destroy(struct wlr_backend *wlr_backend) {
 
 	wl_list_remove(&backend->display_destroy.link);
 
+	wlr_renderer_destroy(backend->renderer);
+
 	free(backend);
 }
 
+static struct wlr_renderer *backend_get_renderer(
+		struct wlr_backend *wlr_backend) {
+	struct wlr_noop_backend *backend = noop_backend_from_backend(wlr_backend);
+	return backend->renderer;
+}
+
 static const struct wlr_backend_impl backend_impl = {
 	.start = backend_start,
 	.destroy = backend_destroy,
+	.get_renderer = backend_get_renderer,
 };
 
 static void handle_display_destroy(struct wl_listener *listener, void *data) {
@@ -68,6 +78,15 @@ struct wlr_backend *wlr_noop_backend_create(struct wl_display *display) {
 	backend->display = display;
 	wl_list_init(&backend->outputs);
 
+	// There is no hardware to render with; the null renderer lets
+	// compositors run their full surface and output commit paths anyway
+	backend->renderer = wlr_null_renderer_create();
+	if (backend->renderer == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create null renderer");
+		free(backend);
+		return NULL;
+	}
+
 	backend->display_destroy.notify = handle_display_destroy;
 	wl_display_add_destroy_listener(display, &backend->display_destroy);
 
@@ -99,6 +99,15 @@ out:
 	return fd;
 }
 
+static int handle_async_reply(sd_bus_message *msg, void *userdata,
+		sd_bus_error *ret_error) {
+	const sd_bus_error *error = sd_bus_message_get_error(msg);
+	if (error != NULL) {
+		wlr_log(WLR_ERROR, "D-Bus call failed: %s", error->message);
+	}
+	return 0;
+}
+
 static void logind_release_device(struct wlr_session *base, int fd) {
 	struct logind_session *session = logind_session_from_session(base);
 
@@ -111,18 +120,21 @@ static void logind_release_device(struct wlr_session *base, int fd) {
 	}
 	close(fd);
 
-	sd_bus_message *msg = NULL;
-	sd_bus_error error = SD_BUS_ERROR_NULL;
-	int ret = sd_bus_call_method(session->bus, "org.freedesktop.login1",
-		session->path, "org.freedesktop.login1.Session", "ReleaseDevice",
-		&error, &msg, "uu", major(st.st_rdev), minor(st.st_rdev));
+	// The reply carries no data, so don't wait for it: devices are released
+	// back-to-back during teardown, and a blocking call per device turns
+	// into as many sequential round trips through dbus-daemon. Queue the
+	// call and only drain the write queue.
+	int ret = sd_bus_call_method_async(session->bus, NULL,
+		"org.freedesktop.login1", session->path,
+		"org.freedesktop.login1.Session", "ReleaseDevice",
+		handle_async_reply, NULL, "uu", major(st.st_rdev), minor(st.st_rdev));
 	if (ret < 0) {
 		wlr_log(WLR_ERROR, "Failed to release device '%d': %s", fd,
-			error.message);
+			strerror(-ret));
+		return;
 	}
 
-	sd_bus_error_free(&error);
-	sd_bus_message_unref(msg);
+	sd_bus_flush(session->bus);
 }
 
 static bool logind_change_vt(struct wlr_session *base, unsigned vt) {
@@ -310,9 +322,14 @@ static int pause_device(sd_bus_message *msg, void *userdata,
 	}
 
 	if (strcmp(type, "pause") == 0) {
-		ret = sd_bus_call_method(session->bus, "org.freedesktop.login1",
-			session->path, "org.freedesktop.login1.Session", "PauseDeviceComplete",
-			ret_error, &msg, "uu", major, minor);
+		// On a VT switch logind pauses every device in turn, so waiting for
+		// each PauseDeviceComplete reply serializes the switch on D-Bus round
+		// trips. We're inside sd_bus_process here, which writes queued
+		// messages out itself.
+		ret = sd_bus_call_method_async(session->bus, NULL,
+			"org.freedesktop.login1", session->path,
+			"org.freedesktop.login1.Session", "PauseDeviceComplete",
+			handle_async_reply, NULL, "uu", major, minor);
 		if (ret < 0) {
 			wlr_log(WLR_ERROR, "Failed to send PauseDeviceComplete signal: %s",
 				strerror(-ret));
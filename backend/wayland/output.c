@@ -99,12 +99,24 @@ static bool output_set_custom_mode(struct wlr_output *wlr_output,
 	struct wlr_wl_output *output = get_wl_output_from_output(wlr_output);
 
 	if (wlr_output->width != width || wlr_output->height != height) {
-		struct wlr_swapchain *swapchain = wlr_swapchain_create(
-			output->backend->allocator, width, height, output->backend->format);
-		if (swapchain == NULL) {
-			return false;
+		struct wlr_swapchain *swapchain = NULL;
+		if (output->prev_swapchain != NULL &&
+				output->prev_swapchain->width == width &&
+				output->prev_swapchain->height == height) {
+			// The previous size is back: reuse the retired swapchain (and
+			// the parent-compositor wl_buffers bound to its buffers)
+			// instead of reallocating every flip
+			swapchain = output->prev_swapchain;
+			output->prev_swapchain = NULL;
+		} else {
+			swapchain = wlr_swapchain_create(output->backend->allocator,
+				width, height, output->backend->format);
+			if (swapchain == NULL) {
+				return false;
+			}
 		}
-		wlr_swapchain_destroy(output->swapchain);
+		wlr_swapchain_destroy(output->prev_swapchain);
+		output->prev_swapchain = output->swapchain;
 		output->swapchain = swapchain;
 	}
 
@@ -324,14 +336,24 @@ static bool output_commit(struct wlr_output *wlr_output) {
 			wl_surface_damage_buffer(output->surface,
 				0, 0, INT32_MAX, INT32_MAX);
 		} else {
+			// Clip to the buffer: out-of-bounds damage is allowed by the
+			// protocol, but forwarding it makes some host compositors fall
+			// back to repainting the whole surface
+			pixman_region32_t clipped;
+			pixman_region32_init_rect(&clipped, 0, 0,
+				wlr_output->width, wlr_output->height);
+			pixman_region32_intersect(&clipped, &clipped, damage);
+
 			int rects_len;
 			pixman_box32_t *rects =
-				pixman_region32_rectangles(damage, &rects_len);
+				pixman_region32_rectangles(&clipped, &rects_len);
 			for (int i = 0; i < rects_len; i++) {
 				pixman_box32_t *r = &rects[i];
 				wl_surface_damage_buffer(output->surface, r->x1, r->y1,
 					r->x2 - r->x1, r->y2 - r->y1);
 			}
+
+			pixman_region32_fini(&clipped);
 		}
 
 		wl_surface_commit(output->surface);
@@ -488,6 +510,7 @@ static void output_destroy(struct wlr_output *wlr_output) {
 
 	wlr_buffer_unlock(output->back_buffer);
 	wlr_swapchain_destroy(output->swapchain);
+	wlr_swapchain_destroy(output->prev_swapchain);
 	if (output->zxdg_toplevel_decoration_v1) {
 		zxdg_toplevel_decoration_v1_destroy(output->zxdg_toplevel_decoration_v1);
 	}
@@ -39,6 +39,54 @@ static struct wlr_wl_pointer *output_get_pointer(
 	return NULL;
 }
 
+static struct wlr_input_device *pointer_event_device(
+		struct wlr_wl_pointer_event *event) {
+	switch (event->type) {
+	case WLR_WL_POINTER_EVENT_MOTION:
+		return event->motion.device;
+	case WLR_WL_POINTER_EVENT_MOTION_ABSOLUTE:
+		return event->motion_absolute.device;
+	case WLR_WL_POINTER_EVENT_BUTTON:
+		return event->button.device;
+	case WLR_WL_POINTER_EVENT_AXIS:
+		return event->axis.device;
+	}
+	abort(); // unreachable
+}
+
+static void pointer_flush_events(struct wlr_wl_seat *seat) {
+	for (size_t i = 0; i < seat->pointer_events_len; ++i) {
+		struct wlr_wl_pointer_event *event = &seat->pointer_events[i];
+		struct wlr_pointer *wlr_pointer = pointer_event_device(event)->pointer;
+		switch (event->type) {
+		case WLR_WL_POINTER_EVENT_MOTION:
+			wlr_signal_emit_safe(&wlr_pointer->events.motion, &event->motion);
+			break;
+		case WLR_WL_POINTER_EVENT_MOTION_ABSOLUTE:
+			wlr_signal_emit_safe(&wlr_pointer->events.motion_absolute,
+				&event->motion_absolute);
+			break;
+		case WLR_WL_POINTER_EVENT_BUTTON:
+			wlr_signal_emit_safe(&wlr_pointer->events.button, &event->button);
+			break;
+		case WLR_WL_POINTER_EVENT_AXIS:
+			wlr_signal_emit_safe(&wlr_pointer->events.axis, &event->axis);
+			break;
+		}
+	}
+	seat->pointer_events_len = 0;
+}
+
+static void pointer_queue_event(struct wlr_wl_seat *seat,
+		const struct wlr_wl_pointer_event *event) {
+	if (seat->pointer_events_len == WLR_WL_POINTER_EVENTS_CAP) {
+		// Pathologically busy remote frame: emit what we have so far and keep
+		// buffering, at the cost of an extra flush
+		pointer_flush_events(seat);
+	}
+	seat->pointer_events[seat->pointer_events_len++] = *event;
+}
+
 static void pointer_handle_enter(void *data, struct wl_pointer *wl_pointer,
 		uint32_t serial, struct wl_surface *surface, wl_fixed_t sx,
 		wl_fixed_t sy) {
@@ -95,13 +143,28 @@ static void pointer_handle_motion(void *data, struct wl_pointer *wl_pointer,
 	}
 
 	struct wlr_output *wlr_output = &pointer->output->wlr_output;
-	struct wlr_event_pointer_motion_absolute event = {
-		.device = &pointer->input_device->wlr_input_device,
-		.time_msec = time,
-		.x = wl_fixed_to_double(sx) / wlr_output->width,
-		.y = wl_fixed_to_double(sy) / wlr_output->height,
+	struct wlr_wl_pointer_event event = {
+		.type = WLR_WL_POINTER_EVENT_MOTION_ABSOLUTE,
+		.motion_absolute = {
+			.device = &pointer->input_device->wlr_input_device,
+			.time_msec = time,
+			.x = wl_fixed_to_double(sx) / wlr_output->width,
+			.y = wl_fixed_to_double(sy) / wlr_output->height,
+		},
 	};
-	wlr_signal_emit_safe(&pointer->wlr_pointer.events.motion_absolute, &event);
+
+	// Multiple motion events within one remote frame are logically a single
+	// move: keep only the most recent position
+	if (seat->pointer_events_len > 0) {
+		struct wlr_wl_pointer_event *last =
+			&seat->pointer_events[seat->pointer_events_len - 1];
+		if (last->type == WLR_WL_POINTER_EVENT_MOTION_ABSOLUTE &&
+				last->motion_absolute.device == event.motion_absolute.device) {
+			last->motion_absolute = event.motion_absolute;
+			return;
+		}
+	}
+	pointer_queue_event(seat, &event);
 }
 
 static void pointer_handle_button(void *data, struct wl_pointer *wl_pointer,
@@ -112,13 +175,16 @@ static void pointer_handle_button(void *data, struct wl_pointer *wl_pointer,
 		return;
 	}
 
-	struct wlr_event_pointer_button event = {
-		.device = &pointer->input_device->wlr_input_device,
-		.button = button,
-		.state = state,
-		.time_msec = time,
+	struct wlr_wl_pointer_event event = {
+		.type = WLR_WL_POINTER_EVENT_BUTTON,
+		.button = {
+			.device = &pointer->input_device->wlr_input_device,
+			.button = button,
+			.state = state,
+			.time_msec = time,
+		},
 	};
-	wlr_signal_emit_safe(&pointer->wlr_pointer.events.button, &event);
+	pointer_queue_event(seat, &event);
 }
 
 static void pointer_handle_axis(void *data, struct wl_pointer *wl_pointer,
@@ -129,21 +195,31 @@ static void pointer_handle_axis(void *data, struct wl_pointer *wl_pointer,
 		return;
 	}
 
-	struct wlr_event_pointer_axis event = {
-		.device = &pointer->input_device->wlr_input_device,
-		.delta = wl_fixed_to_double(value),
-		.delta_discrete = pointer->axis_discrete,
-		.orientation = axis,
-		.time_msec = time,
-		.source = pointer->axis_source,
+	struct wlr_wl_pointer_event event = {
+		.type = WLR_WL_POINTER_EVENT_AXIS,
+		.axis = {
+			.device = &pointer->input_device->wlr_input_device,
+			.delta = wl_fixed_to_double(value),
+			.delta_discrete = pointer->axis_discrete,
+			.orientation = axis,
+			.time_msec = time,
+			.source = pointer->axis_source,
+		},
 	};
-	wlr_signal_emit_safe(&pointer->wlr_pointer.events.axis, &event);
+	pointer_queue_event(seat, &event);
 
 	pointer->axis_discrete = 0;
 }
 
 static void pointer_handle_frame(void *data, struct wl_pointer *wl_pointer) {
 	struct wlr_wl_seat *seat = data;
+
+	// Everything buffered since the last frame belongs to this one: emit it
+	// back-to-back, then the frame event marking the end of the batch. The
+	// buffered events carry their own device, so they survive a leave that
+	// cleared active_pointer mid-frame.
+	pointer_flush_events(seat);
+
 	struct wlr_wl_pointer *pointer = seat->active_pointer;
 	if (pointer == NULL) {
 		return;
@@ -172,15 +248,18 @@ static void pointer_handle_axis_stop(void *data, struct wl_pointer *wl_pointer,
 		return;
 	}
 
-	struct wlr_event_pointer_axis event = {
-		.device = &pointer->input_device->wlr_input_device,
-		.delta = 0,
-		.delta_discrete = 0,
-		.orientation = axis,
-		.time_msec = time,
-		.source = pointer->axis_source,
+	struct wlr_wl_pointer_event event = {
+		.type = WLR_WL_POINTER_EVENT_AXIS,
+		.axis = {
+			.device = &pointer->input_device->wlr_input_device,
+			.delta = 0,
+			.delta_discrete = 0,
+			.orientation = axis,
+			.time_msec = time,
+			.source = pointer->axis_source,
+		},
 	};
-	wlr_signal_emit_safe(&pointer->wlr_pointer.events.axis, &event);
+	pointer_queue_event(seat, &event);
 }
 
 static void pointer_handle_axis_discrete(void *data,
@@ -493,6 +572,18 @@ static void pointer_destroy(struct wlr_pointer *wlr_pointer) {
 		seat->active_pointer = NULL;
 	}
 
+	// Drop buffered events targeting this device, they would be emitted with
+	// a dangling device pointer on the next frame
+	size_t len = 0;
+	for (size_t i = 0; i < seat->pointer_events_len; ++i) {
+		struct wlr_wl_pointer_event *event = &seat->pointer_events[i];
+		if (pointer_event_device(event) !=
+				&pointer->input_device->wlr_input_device) {
+			seat->pointer_events[len++] = *event;
+		}
+	}
+	seat->pointer_events_len = len;
+
 	wl_list_remove(&pointer->output_destroy.link);
 	free(pointer);
 }
@@ -614,15 +705,20 @@ static void relative_pointer_handle_relative_motion(void *data,
 
 	uint64_t time_usec = (uint64_t)utime_hi << 32 | utime_lo;
 
-	struct wlr_event_pointer_motion wlr_event = {
-		.device = wlr_dev,
-		.time_msec = (uint32_t)(time_usec / 1000),
-		.delta_x = wl_fixed_to_double(dx),
-		.delta_y = wl_fixed_to_double(dy),
-		.unaccel_dx = wl_fixed_to_double(dx_unaccel),
-		.unaccel_dy = wl_fixed_to_double(dy_unaccel),
+	// Relative motion is coupled with the wl_pointer's frame events, so it
+	// joins the same per-frame batch as the absolute events
+	struct wlr_wl_pointer_event event = {
+		.type = WLR_WL_POINTER_EVENT_MOTION,
+		.motion = {
+			.device = wlr_dev,
+			.time_msec = (uint32_t)(time_usec / 1000),
+			.delta_x = wl_fixed_to_double(dx),
+			.delta_y = wl_fixed_to_double(dy),
+			.unaccel_dx = wl_fixed_to_double(dx_unaccel),
+			.unaccel_dy = wl_fixed_to_double(dy_unaccel),
+		},
 	};
-	wlr_signal_emit_safe(&wlr_dev->pointer->events.motion, &wlr_event);
+	pointer_queue_event(input_device->seat, &event);
 }
 
 static const struct zwp_relative_pointer_v1_listener relative_pointer_listener = {
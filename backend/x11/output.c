@@ -236,6 +236,8 @@ static bool output_commit_buffer(struct wlr_x11_output *output) {
 	xcb_xfixes_region_t region = XCB_NONE;
 	if (output->wlr_output.pending.committed & WLR_OUTPUT_STATE_DAMAGE) {
 		pixman_region32_union(&output->exposed, &output->exposed, &output->wlr_output.pending.damage);
+		pixman_region32_intersect_rect(&output->exposed, &output->exposed,
+			0, 0, output->wlr_output.width, output->wlr_output.height);
 
 		int rects_len = 0;
 		pixman_box32_t *rects = pixman_region32_rectangles(&output->exposed, &rects_len);
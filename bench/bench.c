@@ -0,0 +1,113 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <wlr/util/log.h>
+#include "bench.h"
+
+#define BENCH_MAX 64
+
+// Each benchmark is re-run with a growing iteration count until it lasts at
+// least this long, so short operations still produce a stable ns/op figure
+#define BENCH_MIN_RUN_NSEC 200000000ULL // 200ms
+
+struct bench {
+	const char *name;
+	bench_func_t func;
+};
+
+static struct bench benches[BENCH_MAX];
+static size_t n_benches;
+
+void bench_register(const char *name, bench_func_t func) {
+	assert(n_benches < BENCH_MAX);
+	benches[n_benches].name = name;
+	benches[n_benches].func = func;
+	++n_benches;
+}
+
+static uint64_t now_nsec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void bench_run_one(const struct bench *bench) {
+	struct bench_run run = {
+		.iters = 1,
+	};
+
+	uint64_t elapsed;
+	while (true) {
+		run.bytes = 0;
+
+		uint64_t start = now_nsec();
+		bench->func(&run);
+		elapsed = now_nsec() - start;
+
+		// The cap keeps a benchmark that skipped itself (e.g. missing
+		// hardware) from growing its iteration count forever
+		if (elapsed >= BENCH_MIN_RUN_NSEC || run.iters >= UINT64_C(1) << 30) {
+			break;
+		}
+
+		// Scale towards the target run time, with headroom so we rarely
+		// need more than one extra round
+		uint64_t next = run.iters * 10;
+		if (elapsed > 0) {
+			uint64_t scaled = run.iters * BENCH_MIN_RUN_NSEC / elapsed * 2;
+			if (scaled < next) {
+				next = scaled;
+			}
+		}
+		run.iters = next > run.iters ? next : run.iters + 1;
+	}
+
+	double ns_per_op = (double)elapsed / run.iters;
+	printf("%-32s %12" PRIu64 " iters %12.2f ns/op", bench->name,
+		run.iters, ns_per_op);
+	if (run.bytes > 0) {
+		double mb_per_sec = (double)run.bytes * run.iters /
+			((double)elapsed / 1e9) / (1024.0 * 1024.0);
+		printf(" %8" PRIu64 " bytes/op %10.2f MB/s", run.bytes, mb_per_sec);
+	}
+	printf("\n");
+}
+
+static bool str_has_infix(const char *haystack, const char *needle) {
+	return strstr(haystack, needle) != NULL;
+}
+
+int main(int argc, char *argv[]) {
+	wlr_log_init(WLR_ERROR, NULL);
+
+	bench_region_register();
+	bench_matrix_register();
+	bench_headless_register();
+	bench_drm_format_set_register();
+	bench_xcursor_register();
+
+	size_t n_run = 0;
+	for (size_t i = 0; i < n_benches; ++i) {
+		if (argc > 1 && !str_has_infix(benches[i].name, argv[1])) {
+			continue;
+		}
+		bench_run_one(&benches[i]);
+		++n_run;
+	}
+
+	if (n_run == 0) {
+		fprintf(stderr, "no benchmark matches '%s'\n",
+			argc > 1 ? argv[1] : "");
+		fprintf(stderr, "available benchmarks:\n");
+		for (size_t i = 0; i < n_benches; ++i) {
+			fprintf(stderr, "  %s\n", benches[i].name);
+		}
+		return 1;
+	}
+	return 0;
+}
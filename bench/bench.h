@@ -0,0 +1,32 @@
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include <stdint.h>
+
+/**
+ * A single benchmark run. The benchmark body must execute exactly `iters`
+ * iterations of the measured operation; the harness picks `iters` so that
+ * each run lasts long enough for a stable ns/op figure. A benchmark may set
+ * `bytes` to the number of bytes it processes per iteration to get
+ * throughput reported alongside ns/op.
+ */
+struct bench_run {
+	uint64_t iters;
+	uint64_t bytes;
+};
+
+typedef void (*bench_func_t)(struct bench_run *run);
+
+/**
+ * Registers a benchmark under the given name. Called by the per-module
+ * register functions below before the harness starts measuring.
+ */
+void bench_register(const char *name, bench_func_t func);
+
+void bench_region_register(void);
+void bench_matrix_register(void);
+void bench_headless_register(void);
+void bench_drm_format_set_register(void);
+void bench_xcursor_register(void);
+
+#endif
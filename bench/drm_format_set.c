@@ -0,0 +1,58 @@
+#include <drm_fourcc.h>
+#include <stdlib.h>
+#include "render/drm_format_set.h"
+#include "bench.h"
+
+static const uint32_t formats[] = {
+	DRM_FORMAT_ARGB8888,
+	DRM_FORMAT_XRGB8888,
+	DRM_FORMAT_ABGR8888,
+	DRM_FORMAT_XBGR8888,
+	DRM_FORMAT_RGB565,
+	DRM_FORMAT_NV12,
+};
+
+// Roughly the shape of a render-format/plane-format pair on real hardware:
+// a handful of formats with a dozen or so modifiers each, mostly overlapping
+static void seed_set(struct wlr_drm_format_set *set) {
+	for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); ++i) {
+		for (uint64_t m = 0; m < 16; ++m) {
+			wlr_drm_format_set_add(set, formats[i], m);
+		}
+	}
+}
+
+static void bench_format_intersect(struct bench_run *run) {
+	struct wlr_drm_format_set a = {0}, b = {0};
+	seed_set(&a);
+	seed_set(&b);
+
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		uint32_t fmt = formats[i % (sizeof(formats) / sizeof(formats[0]))];
+		struct wlr_drm_format *result = wlr_drm_format_intersect(
+			wlr_drm_format_set_get(&a, fmt), wlr_drm_format_set_get(&b, fmt));
+		free(result);
+	}
+
+	wlr_drm_format_set_finish(&a);
+	wlr_drm_format_set_finish(&b);
+}
+
+static void bench_format_intersect_cached(struct bench_run *run) {
+	struct wlr_drm_format_set a = {0}, b = {0};
+	seed_set(&a);
+	seed_set(&b);
+
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		uint32_t fmt = formats[i % (sizeof(formats) / sizeof(formats[0]))];
+		wlr_drm_format_set_intersect_cached(&a, &b, fmt);
+	}
+
+	wlr_drm_format_set_finish(&a);
+	wlr_drm_format_set_finish(&b);
+}
+
+void bench_drm_format_set_register(void) {
+	bench_register("drm_format_intersect", bench_format_intersect);
+	bench_register("drm_format_intersect_cached", bench_format_intersect_cached);
+}
@@ -0,0 +1,97 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <wayland-server-core.h>
+#include <wlr/backend.h>
+#include <wlr/backend/headless.h>
+#include <wlr/render/wlr_renderer.h>
+#include <wlr/types/wlr_box.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_output_damage.h>
+#include "bench.h"
+
+static struct wl_display *display;
+static struct wlr_backend *backend;
+static struct wlr_output *output;
+
+// The backend is created lazily and shared between benchmarks; the bench
+// binary exits without tearing it down, like the examples do
+static bool headless_setup(void) {
+	if (output != NULL) {
+		return true;
+	}
+	if (display != NULL) {
+		return false; // Already tried and failed
+	}
+
+	display = wl_display_create();
+	if (display == NULL) {
+		return false;
+	}
+
+	backend = wlr_headless_backend_create(display);
+	if (backend == NULL) {
+		fprintf(stderr, "headless backend unavailable, skipping\n");
+		return false;
+	}
+
+	// Manual frames: each commit completes immediately instead of waiting
+	// for the refresh timer, so the pipeline runs as fast as the CPU allows
+	wlr_headless_backend_set_manual_frames(backend, true);
+
+	if (!wlr_backend_start(backend)) {
+		fprintf(stderr, "failed to start headless backend, skipping\n");
+		return false;
+	}
+
+	output = wlr_headless_add_output(backend, 1920, 1080);
+	return output != NULL;
+}
+
+static void bench_output_commit(struct bench_run *run) {
+	if (!headless_setup()) {
+		return;
+	}
+	struct wlr_renderer *renderer = wlr_backend_get_renderer(backend);
+
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		if (!wlr_output_attach_render(output, NULL)) {
+			break;
+		}
+		wlr_renderer_begin(renderer, output->width, output->height);
+		float color[4] = {0.2f, 0.3f, 0.4f, 1.0f};
+		wlr_renderer_clear(renderer, color);
+		wlr_renderer_end(renderer);
+		if (!wlr_output_commit(output)) {
+			break;
+		}
+	}
+}
+
+static void bench_output_damage_add(struct bench_run *run) {
+	if (!headless_setup()) {
+		return;
+	}
+
+	struct wlr_output_damage *damage = wlr_output_damage_create(output);
+	if (damage == NULL) {
+		return;
+	}
+
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		struct wlr_box box = {
+			.x = (int)(i % 128) * 10,
+			.y = (int)(i % 72) * 10,
+			.width = 64,
+			.height = 64,
+		};
+		wlr_output_damage_add_box(damage, &box);
+	}
+
+	wlr_output_damage_destroy(damage);
+}
+
+void bench_headless_register(void) {
+	bench_register("headless_output_commit", bench_output_commit);
+	bench_register("output_damage_add", bench_output_damage_add);
+}
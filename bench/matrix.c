@@ -0,0 +1,69 @@
+#include <wlr/types/wlr_box.h>
+#include <wlr/types/wlr_matrix.h>
+#include "bench.h"
+
+static void bench_matrix_project_box(struct bench_run *run) {
+	float projection[9];
+	wlr_matrix_projection(projection, 1920, 1080, WL_OUTPUT_TRANSFORM_NORMAL);
+
+	struct wlr_box box = {
+		.x = 100,
+		.y = 100,
+		.width = 640,
+		.height = 480,
+	};
+
+	float mat[9];
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		wlr_matrix_project_box(mat, &box, WL_OUTPUT_TRANSFORM_90, 0.1f,
+			projection);
+	}
+}
+
+// Same projection, but rotation-free: takes the affine fast path
+static void bench_matrix_project_box_affine(struct bench_run *run) {
+	float projection[9];
+	wlr_matrix_projection(projection, 1920, 1080, WL_OUTPUT_TRANSFORM_NORMAL);
+
+	struct wlr_box box = {
+		.x = 100,
+		.y = 100,
+		.width = 640,
+		.height = 480,
+	};
+
+	float mat[9];
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		wlr_matrix_project_box(mat, &box, WL_OUTPUT_TRANSFORM_90, 0.0f,
+			projection);
+	}
+}
+
+#define BENCH_MATRIX_BATCH 16
+
+static void bench_matrix_project_boxes(struct bench_run *run) {
+	float projection[9];
+	wlr_matrix_projection(projection, 1920, 1080, WL_OUTPUT_TRANSFORM_NORMAL);
+
+	struct wlr_box boxes[BENCH_MATRIX_BATCH];
+	for (int i = 0; i < BENCH_MATRIX_BATCH; ++i) {
+		boxes[i] = (struct wlr_box){
+			.x = 10 * i,
+			.y = 20 * i,
+			.width = 64 + i,
+			.height = 48 + i,
+		};
+	}
+
+	float mats[BENCH_MATRIX_BATCH][9];
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		wlr_matrix_project_boxes(mats, boxes, BENCH_MATRIX_BATCH,
+			WL_OUTPUT_TRANSFORM_90, 0.0f, projection);
+	}
+}
+
+void bench_matrix_register(void) {
+	bench_register("matrix_project_box", bench_matrix_project_box);
+	bench_register("matrix_project_box_affine", bench_matrix_project_box_affine);
+	bench_register("matrix_project_boxes_16", bench_matrix_project_boxes);
+}
@@ -0,0 +1,18 @@
+#!/bin/sh -eu
+# Canonical PGO training workload. Run against an instrumented build
+# (-Db_pgo=generate), then rebuild with -Db_pgo=use. Parameters are fixed on
+# purpose so profiles are comparable from release to release; change them
+# deliberately, not per run.
+
+BENCH="$1"
+STRESS="$2"
+
+# CPU-side microbenchmarks: damage/region math, matrices, format-set
+# intersection, xcursor decode, plus headless output commits when EGL is
+# available
+"$BENCH"
+
+# Commit-path workload: many small surfaces first, then fewer large ones
+# with small damage, covering both the per-surface and the per-byte costs
+"$STRESS" -n 32 -s 128 -r 240 -d full -t 10 -m
+"$STRESS" -n 8 -s 512 -r 240 -d small -t 10 -m
@@ -0,0 +1,46 @@
+#include <pixman.h>
+#include <wlr/util/region.h>
+#include "bench.h"
+
+// A moderately fragmented damage region: a grid of non-touching rectangles,
+// the kind a busy desktop produces from many small surface updates
+static void seed_region(pixman_region32_t *region) {
+	pixman_region32_init(region);
+	for (int y = 0; y < 16; ++y) {
+		for (int x = 0; x < 16; ++x) {
+			pixman_region32_union_rect(region, region,
+				x * 120, y * 68, 100, 50);
+		}
+	}
+}
+
+static void bench_region_scale(struct bench_run *run) {
+	pixman_region32_t src, dst;
+	seed_region(&src);
+	pixman_region32_init(&dst);
+
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		wlr_region_scale(&dst, &src, 1.5f);
+	}
+
+	pixman_region32_fini(&dst);
+	pixman_region32_fini(&src);
+}
+
+static void bench_region_transform(struct bench_run *run) {
+	pixman_region32_t src, dst;
+	seed_region(&src);
+	pixman_region32_init(&dst);
+
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		wlr_region_transform(&dst, &src, WL_OUTPUT_TRANSFORM_90, 1920, 1080);
+	}
+
+	pixman_region32_fini(&dst);
+	pixman_region32_fini(&src);
+}
+
+void bench_region_register(void) {
+	bench_register("region_scale", bench_region_scale);
+	bench_register("region_transform", bench_region_transform);
+}
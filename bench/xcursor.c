@@ -0,0 +1,40 @@
+#include <stddef.h>
+#include <wlr/xcursor.h>
+#include "bench.h"
+
+// Loads whatever theme is installed, or the embedded fallback cursor when
+// none is: either way the load, parse and cache path gets exercised
+static void bench_xcursor_theme_load(struct bench_run *run) {
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		struct wlr_xcursor_theme *theme = wlr_xcursor_theme_load(NULL, 24);
+		if (theme == NULL) {
+			return;
+		}
+		wlr_xcursor_theme_prewarm(theme);
+		wlr_xcursor_theme_destroy(theme);
+	}
+}
+
+static void bench_xcursor_frame(struct bench_run *run) {
+	struct wlr_xcursor_theme *theme = wlr_xcursor_theme_load(NULL, 24);
+	if (theme == NULL) {
+		return;
+	}
+	struct wlr_xcursor *cursor =
+		wlr_xcursor_theme_get_cursor(theme, "left_ptr");
+	if (cursor == NULL) {
+		wlr_xcursor_theme_destroy(theme);
+		return;
+	}
+
+	for (uint64_t i = 0; i < run->iters; ++i) {
+		wlr_xcursor_frame(cursor, (uint32_t)(i * 16));
+	}
+
+	wlr_xcursor_theme_destroy(theme);
+}
+
+void bench_xcursor_register(void) {
+	bench_register("xcursor_theme_load", bench_xcursor_theme_load);
+	bench_register("xcursor_frame", bench_xcursor_frame);
+}
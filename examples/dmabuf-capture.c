@@ -3,11 +3,13 @@
 #include <libavutil/display.h>
 #include <libavutil/hwcontext_drm.h>
 #include <libavutil/pixdesc.h>
+#include <inttypes.h>
 #include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <stdbool.h>
@@ -53,6 +55,12 @@ struct capture_context {
 	int err;
 	bool quit;
 
+	/* Benchmark mode */
+	bool bench;
+	uint64_t bench_frames;
+	uint64_t bench_bytes;
+	struct timespec bench_start, bench_report;
+
 	/* FFmpeg specific parts */
 	pthread_t vid_thread;
 	AVFrame *current_frame;
@@ -370,6 +378,32 @@ fail:
 
 static void register_cb(struct capture_context *ctx);
 
+/* Report sustained capture throughput, at most once per second */
+static void bench_count_frame(struct capture_context *ctx, uint64_t bytes) {
+	if (ctx->bench_frames++ == 0) {
+		clock_gettime(CLOCK_MONOTONIC, &ctx->bench_start);
+		ctx->bench_report = ctx->bench_start;
+	}
+	ctx->bench_bytes += bytes;
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	double since_report = (now.tv_sec - ctx->bench_report.tv_sec) +
+		(now.tv_nsec - ctx->bench_report.tv_nsec) / 1e9;
+	if (since_report < 1.0) {
+		return;
+	}
+
+	double elapsed = (now.tv_sec - ctx->bench_start.tv_sec) +
+		(now.tv_nsec - ctx->bench_start.tv_nsec) / 1e9;
+	printf("bench: proto=export-dmabuf frames=%" PRIu64 " seconds=%.3f "
+		"frames_per_sec=%.2f mb_per_sec=%.2f\n", ctx->bench_frames, elapsed,
+		ctx->bench_frames / elapsed,
+		ctx->bench_bytes / (1024.0 * 1024.0) / elapsed);
+	fflush(stdout);
+	ctx->bench_report = now;
+}
+
 static void frame_ready(void *data, struct zwlr_export_dmabuf_frame_v1 *frame,
 		uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec) {
 	struct capture_context *ctx = data;
@@ -378,6 +412,14 @@ static void frame_ready(void *data, struct zwlr_export_dmabuf_frame_v1 *frame,
 	enum AVPixelFormat pix_fmt = drm_fmt_to_pixfmt(desc->layers[0].format);
 	int err = 0;
 
+	if (ctx->bench) {
+		uint64_t bytes = 0;
+		for (int i = 0; i < desc->nb_objects; i++) {
+			bytes += desc->objects[i].size;
+		}
+		bench_count_frame(ctx, bytes);
+	}
+
 	/* Timestamp, nanoseconds timebase */
 	f->pts = ((((uint64_t)tv_sec_hi) << 32) | tv_sec_lo) * 1000000000 + tv_nsec;
 
@@ -777,6 +819,7 @@ static const char usage[] = "usage: dmabuf-capture [options...] <destination fil
 	"  -e <encoder>\n"
 	"  -f <pixel format>\n"
 	"  -r <bitrate in Mbps>\n"
+	"  -b (report capture throughput once per second)\n"
 	"\n"
 	"Example:\n"
 	"  dmabuf-capture -o 32 -t vaapi -d /dev/dri/renderD129 \\\n"
@@ -792,9 +835,12 @@ int main(int argc, char *argv[]) {
 	const char *hw_device_type = "vaapi";
 	const char *software_format = "nv12";
 	int opt;
-	while ((opt = getopt(argc, argv, "ho:t:d:e:f:r:")) != -1) {
+	while ((opt = getopt(argc, argv, "hbo:t:d:e:f:r:")) != -1) {
 		char *end;
 		switch (opt) {
+		case 'b':
+			ctx.bench = true;
+			break;
 		case 'o':
 			output_id = strtol(optarg, &end, 10);
 			if (optarg[0] == '\0' || end[0] != '\0') {
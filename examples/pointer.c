@@ -1,6 +1,8 @@
 #define _POSIX_C_SOURCE 200112L
 #include <assert.h>
+#include <inttypes.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,6 +36,12 @@ struct sample_state {
 	struct wl_list devices;
 	struct timespec last_frame;
 
+	// Benchmark mode: every input event is counted and the sustained rate
+	// is reported at most once per second
+	bool bench;
+	uint64_t bench_events;
+	struct timespec bench_start, bench_report;
+
 	struct wl_listener new_output;
 	struct wl_listener new_input;
 	struct wl_listener cursor_motion;
@@ -73,6 +81,33 @@ struct sample_keyboard {
 	struct wl_listener destroy;
 };
 
+static void bench_count_event(struct sample_state *state) {
+	if (!state->bench) {
+		return;
+	}
+	if (state->bench_events++ == 0) {
+		clock_gettime(CLOCK_MONOTONIC, &state->bench_start);
+		state->bench_report = state->bench_start;
+		return;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	double since_report = (now.tv_sec - state->bench_report.tv_sec) +
+		(now.tv_nsec - state->bench_report.tv_nsec) / 1e9;
+	if (since_report < 1.0) {
+		return;
+	}
+
+	double elapsed = (now.tv_sec - state->bench_start.tv_sec) +
+		(now.tv_nsec - state->bench_start.tv_nsec) / 1e9;
+	printf("bench: proto=pointer events=%" PRIu64 " seconds=%.3f "
+		"events_per_sec=%.2f\n", state->bench_events, elapsed,
+		state->bench_events / elapsed);
+	fflush(stdout);
+	state->bench_report = now;
+}
+
 static void warp_to_touch(struct sample_state *state,
 		struct wlr_input_device *dev) {
 	if (wl_list_empty(&state->touch_points)) {
@@ -111,6 +146,7 @@ static void handle_cursor_motion(struct wl_listener *listener, void *data) {
 	struct sample_state *sample =
 		wl_container_of(listener, sample, cursor_motion);
 	struct wlr_event_pointer_motion *event = data;
+	bench_count_event(sample);
 	wlr_cursor_move(sample->cursor, event->device, event->delta_x,
 			event->delta_y);
 }
@@ -120,6 +156,7 @@ static void handle_cursor_motion_absolute(struct wl_listener *listener,
 	struct sample_state *sample =
 		wl_container_of(listener, sample, cursor_motion_absolute);
 	struct wlr_event_pointer_motion_absolute *event = data;
+	bench_count_event(sample);
 
 	sample->cur_x = event->x;
 	sample->cur_y = event->y;
@@ -132,6 +169,7 @@ static void handle_cursor_button(struct wl_listener *listener, void *data) {
 	struct sample_state *sample =
 		wl_container_of(listener, sample, cursor_button);
 	struct wlr_event_pointer_button *event = data;
+	bench_count_event(sample);
 
 	float (*color)[4];
 	if (event->state == WLR_BUTTON_RELEASED) {
@@ -149,6 +187,7 @@ static void handle_cursor_axis(struct wl_listener *listener, void *data) {
 	struct sample_state *sample =
 		wl_container_of(listener, sample, cursor_axis);
 	struct wlr_event_pointer_axis *event = data;
+	bench_count_event(sample);
 
 	for (size_t i = 0; i < 3; ++i) {
 		sample->default_color[i] += event->delta > 0 ? -0.05f : 0.05f;
@@ -167,6 +206,7 @@ static void handle_cursor_axis(struct wl_listener *listener, void *data) {
 static void handle_touch_up(struct wl_listener *listener, void *data) {
 	struct sample_state *sample = wl_container_of(listener, sample, touch_up);
 	struct wlr_event_touch_up *event = data;
+	bench_count_event(sample);
 
 	struct touch_point *point, *tmp;
 	wl_list_for_each_safe(point, tmp, &sample->touch_points, link) {
@@ -182,6 +222,7 @@ static void handle_touch_up(struct wl_listener *listener, void *data) {
 static void handle_touch_down(struct wl_listener *listener, void *data) {
 	struct sample_state *sample = wl_container_of(listener, sample, touch_down);
 	struct wlr_event_touch_down *event = data;
+	bench_count_event(sample);
 	struct touch_point *point = calloc(1, sizeof(struct touch_point));
 	point->touch_id = event->touch_id;
 	point->x = event->x;
@@ -195,6 +236,7 @@ static void handle_touch_motion(struct wl_listener *listener, void *data) {
 	struct sample_state *sample =
 		wl_container_of(listener, sample, touch_motion);
 	struct wlr_event_touch_motion *event = data;
+	bench_count_event(sample);
 
 	struct touch_point *point;
 	wl_list_for_each(point, &sample->touch_points, link) {
@@ -216,6 +258,7 @@ static void handle_tablet_tool_axis(struct wl_listener *listener, void *data) {
 	struct sample_state *sample =
 		wl_container_of(listener, sample, tablet_tool_axis);
 	struct wlr_event_tablet_tool_axis *event = data;
+	bench_count_event(sample);
 	if ((event->updated_axes & WLR_TABLET_TOOL_AXIS_X) &&
 			(event->updated_axes & WLR_TABLET_TOOL_AXIS_Y)) {
 		wlr_cursor_warp_absolute(sample->cursor,
@@ -333,6 +376,18 @@ int main(int argc, char *argv[]) {
 		.display = display
 	};
 
+	int opt;
+	while ((opt = getopt(argc, argv, "b")) != -1) {
+		switch (opt) {
+		case 'b':
+			state.bench = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-b]\n", argv[0]);
+			exit(1);
+		}
+	}
+
 	struct wlr_backend *wlr = wlr_backend_autocreate(display);
 	if (!wlr) {
 		exit(1);
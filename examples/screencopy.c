@@ -24,6 +24,7 @@
 #define _POSIX_C_SOURCE 200112L
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <png.h>
 #include <stdbool.h>
@@ -34,6 +35,7 @@
 #include <sys/param.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 #include <assert.h>
 #include <wayland-client-protocol.h>
@@ -113,13 +115,14 @@ static void frame_handle_buffer(void *data,
 	buffer.height = height;
 	buffer.stride = stride;
 
-	// Make sure the buffer is not allocated
-	assert(!buffer.wl_buffer);
-	buffer.wl_buffer =
-		create_shm_buffer(format, width, height, stride, &buffer.data);
+	// In benchmark mode the buffer is reused for every capture
 	if (buffer.wl_buffer == NULL) {
-		fprintf(stderr, "failed to create buffer\n");
-		exit(EXIT_FAILURE);
+		buffer.wl_buffer =
+			create_shm_buffer(format, width, height, stride, &buffer.data);
+		if (buffer.wl_buffer == NULL) {
+			fprintf(stderr, "failed to create buffer\n");
+			exit(EXIT_FAILURE);
+		}
 	}
 
 	zwlr_screencopy_frame_v1_copy(frame, buffer.wl_buffer);
@@ -226,6 +229,19 @@ static void write_image(char *filename, enum wl_shm_format wl_fmt, int width,
 }
 
 int main(int argc, char *argv[]) {
+	double bench_seconds = 0;
+	int opt;
+	while ((opt = getopt(argc, argv, "b:")) != -1) {
+		switch (opt) {
+		case 'b':
+			bench_seconds = atof(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-b seconds]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
 	struct wl_display * display = wl_display_connect(NULL);
 	if (display == NULL) {
 		perror("failed to create display");
@@ -257,8 +273,39 @@ int main(int argc, char *argv[]) {
 		// This space is intentionally left blank
 	}
 
-	write_image("wayland-screenshot.png", buffer.format, buffer.width,
-		buffer.height, buffer.stride, buffer.y_invert, buffer.data);
+	if (bench_seconds > 0) {
+		// Benchmark mode: keep capturing into the same buffer for the given
+		// duration, then report sustained throughput machine-readably
+		struct timespec start, now;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		uint64_t frames = 0;
+		double elapsed = 0;
+		do {
+			zwlr_screencopy_frame_v1_destroy(frame);
+			buffer_copy_done = false;
+			frame = zwlr_screencopy_manager_v1_capture_output(
+				screencopy_manager, 0, output);
+			zwlr_screencopy_frame_v1_add_listener(frame, &frame_listener,
+				NULL);
+			while (!buffer_copy_done && wl_display_dispatch(display) != -1) {
+				// This space is intentionally left blank
+			}
+			++frames;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			elapsed = (now.tv_sec - start.tv_sec) +
+				(now.tv_nsec - start.tv_nsec) / 1e9;
+		} while (elapsed < bench_seconds);
+
+		double mb = (double)frames * buffer.stride * buffer.height /
+			(1024.0 * 1024.0);
+		printf("bench: proto=screencopy frames=%" PRIu64 " seconds=%.3f "
+			"frames_per_sec=%.2f mb_per_sec=%.2f\n",
+			frames, elapsed, frames / elapsed, mb / elapsed);
+	} else {
+		write_image("wayland-screenshot.png", buffer.format, buffer.width,
+			buffer.height, buffer.stride, buffer.y_invert, buffer.data);
+	}
+	zwlr_screencopy_frame_v1_destroy(frame);
 	wl_buffer_destroy(buffer.wl_buffer);
 	munmap(buffer.data, buffer.stride * buffer.height);
 
@@ -0,0 +1,527 @@
+#define _GNU_SOURCE
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-client.h>
+#include <wayland-server-core.h>
+#include <wlr/backend.h>
+#include <wlr/backend/headless.h>
+#include <wlr/render/wlr_renderer.h>
+#include <wlr/types/wlr_compositor.h>
+#include <wlr/types/wlr_matrix.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_surface.h>
+#include <wlr/util/log.h>
+
+/*
+ * Synthetic-load stress harness: runs a compositor on the headless backend
+ * and, in the same process, a Wayland client that commits N surfaces at a
+ * configurable rate with configurable sizes and damage patterns. Reports
+ * sustained commit throughput and frame render times once per second and a
+ * summary at the end.
+ */
+
+enum damage_pattern {
+	DAMAGE_FULL, // damage the whole surface every commit
+	DAMAGE_SMALL, // a small rectangle walking across the surface
+};
+
+struct stress_surface {
+	struct wl_surface *surface;
+	struct wl_buffer *buffers[2];
+	uint32_t *data[2];
+	int current;
+	uint64_t commits;
+};
+
+struct stress;
+
+struct stress_view {
+	struct wl_list link;
+	struct stress *stress;
+	struct wlr_surface *surface;
+	int x, y;
+
+	struct wl_listener commit;
+	struct wl_listener destroy;
+};
+
+struct stress {
+	// Server side
+	struct wl_display *display;
+	struct wl_event_loop *event_loop;
+	struct wlr_backend *backend;
+	struct wlr_renderer *renderer;
+	struct wlr_compositor *compositor;
+	struct wlr_output *output;
+	struct wl_listener new_surface;
+	struct wl_listener output_frame;
+	struct wl_list views;
+
+	// Client side, driven from the server's event loop
+	struct wl_display *client_display;
+	struct wl_compositor *client_compositor;
+	struct wl_shm *client_shm;
+	struct stress_surface *surfaces;
+	struct wl_event_source *commit_timer;
+	struct wl_event_source *stats_timer;
+	struct wl_event_source *duration_timer;
+
+	// Configuration
+	int n_surfaces;
+	int surface_size;
+	int rate; // commits per second per surface
+	enum damage_pattern damage;
+	int duration; // seconds, 0 = run until interrupted
+	bool manual_frames;
+
+	// Counters for the current reporting interval
+	uint64_t commits;
+	uint64_t server_commits;
+	uint64_t frames;
+	uint64_t render_total_nsec;
+	uint64_t render_max_nsec;
+
+	// Totals for the final summary
+	uint64_t total_commits;
+	uint64_t total_frames;
+	uint64_t total_render_nsec;
+	struct timespec start;
+};
+
+static uint64_t timespec_diff_nsec(const struct timespec *a,
+		const struct timespec *b) {
+	return (uint64_t)(a->tv_sec - b->tv_sec) * 1000000000 +
+		a->tv_nsec - b->tv_nsec;
+}
+
+static void view_handle_commit(struct wl_listener *listener, void *data) {
+	struct stress_view *view = wl_container_of(listener, view, commit);
+	++view->stress->server_commits;
+}
+
+static void view_handle_destroy(struct wl_listener *listener, void *data) {
+	struct stress_view *view = wl_container_of(listener, view, destroy);
+	wl_list_remove(&view->commit.link);
+	wl_list_remove(&view->destroy.link);
+	wl_list_remove(&view->link);
+	free(view);
+}
+
+static void handle_new_surface(struct wl_listener *listener, void *data) {
+	struct stress *stress = wl_container_of(listener, stress, new_surface);
+	struct wlr_surface *surface = data;
+
+	struct stress_view *view = calloc(1, sizeof(struct stress_view));
+	if (view == NULL) {
+		return;
+	}
+	view->stress = stress;
+	view->surface = surface;
+
+	// Lay the surfaces out on a grid, wrapping at the output's edge
+	int n = wl_list_length(&stress->views);
+	int per_row = stress->output->width / stress->surface_size;
+	if (per_row <= 0) {
+		per_row = 1;
+	}
+	view->x = (n % per_row) * stress->surface_size;
+	view->y = ((n / per_row) * stress->surface_size) %
+		(stress->output->height > 0 ? stress->output->height : 1);
+
+	view->commit.notify = view_handle_commit;
+	wl_signal_add(&surface->events.commit, &view->commit);
+	view->destroy.notify = view_handle_destroy;
+	wl_signal_add(&surface->events.destroy, &view->destroy);
+	wl_list_insert(&stress->views, &view->link);
+}
+
+static void handle_output_frame(struct wl_listener *listener, void *data) {
+	struct stress *stress = wl_container_of(listener, stress, output_frame);
+	struct wlr_output *output = stress->output;
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	if (!wlr_output_attach_render(output, NULL)) {
+		return;
+	}
+	wlr_renderer_begin(stress->renderer, output->width, output->height);
+	float clear_color[4] = {0.1f, 0.1f, 0.1f, 1.0f};
+	wlr_renderer_clear(stress->renderer, clear_color);
+
+	struct stress_view *view;
+	wl_list_for_each(view, &stress->views, link) {
+		struct wlr_texture *texture = wlr_surface_get_texture(view->surface);
+		if (texture == NULL) {
+			continue;
+		}
+		wlr_render_texture(stress->renderer, texture,
+			output->transform_matrix, view->x, view->y, 1.0f);
+	}
+
+	wlr_renderer_end(stress->renderer);
+	if (!wlr_output_commit(output)) {
+		return;
+	}
+
+	wl_list_for_each(view, &stress->views, link) {
+		wlr_surface_send_frame_done(view->surface, &start);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	uint64_t render_nsec = timespec_diff_nsec(&end, &start);
+	++stress->frames;
+	stress->render_total_nsec += render_nsec;
+	if (render_nsec > stress->render_max_nsec) {
+		stress->render_max_nsec = render_nsec;
+	}
+}
+
+static struct wl_buffer *create_shm_buffer(struct stress *stress,
+		uint32_t **data_out) {
+	int size = stress->surface_size;
+	int stride = size * 4;
+	int pool_size = stride * size;
+
+	int fd = memfd_create("wlr-stress", 0);
+	if (fd < 0) {
+		perror("memfd_create");
+		return NULL;
+	}
+	if (ftruncate(fd, pool_size) < 0) {
+		perror("ftruncate");
+		close(fd);
+		return NULL;
+	}
+
+	void *data = mmap(NULL, pool_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		fd, 0);
+	if (data == MAP_FAILED) {
+		perror("mmap");
+		close(fd);
+		return NULL;
+	}
+
+	struct wl_shm_pool *pool = wl_shm_create_pool(stress->client_shm, fd,
+		pool_size);
+	struct wl_buffer *buffer = wl_shm_pool_create_buffer(pool, 0, size, size,
+		stride, WL_SHM_FORMAT_ARGB8888);
+	wl_shm_pool_destroy(pool);
+	close(fd);
+
+	*data_out = data;
+	return buffer;
+}
+
+static int handle_commit_timer(void *data) {
+	struct stress *stress = data;
+	int size = stress->surface_size;
+
+	for (int i = 0; i < stress->n_surfaces; ++i) {
+		struct stress_surface *surface = &stress->surfaces[i];
+		surface->current ^= 1;
+		uint32_t *pixels = surface->data[surface->current];
+
+		int x = 0, y = 0, width = size, height = size;
+		if (stress->damage == DAMAGE_SMALL) {
+			width = size < 64 ? size : 64;
+			height = width;
+			x = (surface->commits * width) % (size - width + 1);
+			y = (surface->commits * height / size) % (size - height + 1);
+		}
+
+		// Scribble into the damaged area so uploads actually move new bytes
+		uint32_t color = 0xff000000 | (uint32_t)(surface->commits * 0x10401);
+		for (int row = y; row < y + height; ++row) {
+			for (int col = x; col < x + width; ++col) {
+				pixels[row * size + col] = color;
+			}
+		}
+
+		wl_surface_attach(surface->surface,
+			surface->buffers[surface->current], 0, 0);
+		wl_surface_damage(surface->surface, x, y, width, height);
+		wl_surface_commit(surface->surface);
+		++surface->commits;
+		++stress->commits;
+	}
+
+	wl_display_flush(stress->client_display);
+
+	wl_event_source_timer_update(stress->commit_timer,
+		stress->rate > 0 ? 1000 / stress->rate : 1000);
+	return 0;
+}
+
+static int handle_client_readable(int fd, uint32_t mask, void *data) {
+	struct stress *stress = data;
+	if (wl_display_prepare_read(stress->client_display) == 0) {
+		wl_display_read_events(stress->client_display);
+	}
+	wl_display_dispatch_pending(stress->client_display);
+	return 0;
+}
+
+static int handle_stats_timer(void *data) {
+	struct stress *stress = data;
+
+	double avg_ms = stress->frames > 0 ?
+		stress->render_total_nsec / 1e6 / stress->frames : 0.0;
+	printf("%6" PRIu64 " commits/s  %6" PRIu64 " frames/s  "
+		"render avg %6.3f ms  max %6.3f ms\n",
+		stress->commits, stress->frames, avg_ms,
+		stress->render_max_nsec / 1e6);
+
+	stress->total_commits += stress->commits;
+	stress->total_frames += stress->frames;
+	stress->total_render_nsec += stress->render_total_nsec;
+	stress->commits = 0;
+	stress->server_commits = 0;
+	stress->frames = 0;
+	stress->render_total_nsec = 0;
+	stress->render_max_nsec = 0;
+
+	wl_event_source_timer_update(stress->stats_timer, 1000);
+	return 0;
+}
+
+static int handle_duration_timer(void *data) {
+	struct stress *stress = data;
+	wl_display_terminate(stress->display);
+	return 0;
+}
+
+static void registry_handle_global(void *data, struct wl_registry *registry,
+		uint32_t name, const char *interface, uint32_t version) {
+	struct stress *stress = data;
+	if (strcmp(interface, wl_compositor_interface.name) == 0) {
+		stress->client_compositor = wl_registry_bind(registry, name,
+			&wl_compositor_interface, 4);
+	} else if (strcmp(interface, wl_shm_interface.name) == 0) {
+		stress->client_shm = wl_registry_bind(registry, name,
+			&wl_shm_interface, 1);
+	}
+}
+
+static void registry_handle_global_remove(void *data,
+		struct wl_registry *registry, uint32_t name) {
+	// Globals don't come and go in this harness
+}
+
+static const struct wl_registry_listener registry_listener = {
+	.global = registry_handle_global,
+	.global_remove = registry_handle_global_remove,
+};
+
+static void sync_handle_done(void *data, struct wl_callback *callback,
+		uint32_t serial) {
+	bool *done = data;
+	*done = true;
+}
+
+static const struct wl_callback_listener sync_listener = {
+	.done = sync_handle_done,
+};
+
+// Both ends live in this process and thread, so a blocking client roundtrip
+// would deadlock: pump the server's event loop by hand until the client has
+// seen its reply instead
+static void client_roundtrip(struct stress *stress) {
+	struct wl_callback *callback = wl_display_sync(stress->client_display);
+	bool done = false;
+	wl_callback_add_listener(callback, &sync_listener, &done);
+
+	while (!done) {
+		wl_display_flush(stress->client_display);
+		wl_display_flush_clients(stress->display);
+		wl_event_loop_dispatch(stress->event_loop, 10);
+		if (wl_display_prepare_read(stress->client_display) == 0) {
+			wl_display_read_events(stress->client_display);
+		}
+		wl_display_dispatch_pending(stress->client_display);
+	}
+	wl_callback_destroy(callback);
+}
+
+static const char usage[] = "usage: stress [options]\n"
+	"  -n <count>   number of surfaces (default 16)\n"
+	"  -s <size>    surface width and height in pixels (default 256)\n"
+	"  -r <rate>    commits per second per surface (default 60)\n"
+	"  -d <mode>    damage pattern: full or small (default full)\n"
+	"  -t <secs>    run time in seconds, 0 = until interrupted (default 10)\n"
+	"  -m           manual frames: let the output tick as fast as the CPU "
+	"allows\n";
+
+int main(int argc, char *argv[]) {
+	struct stress stress = {
+		.n_surfaces = 16,
+		.surface_size = 256,
+		.rate = 60,
+		.damage = DAMAGE_FULL,
+		.duration = 10,
+	};
+
+	int c;
+	while ((c = getopt(argc, argv, "n:s:r:d:t:mh")) != -1) {
+		switch (c) {
+		case 'n':
+			stress.n_surfaces = atoi(optarg);
+			break;
+		case 's':
+			stress.surface_size = atoi(optarg);
+			break;
+		case 'r':
+			stress.rate = atoi(optarg);
+			break;
+		case 'd':
+			if (strcmp(optarg, "small") == 0) {
+				stress.damage = DAMAGE_SMALL;
+			} else if (strcmp(optarg, "full") == 0) {
+				stress.damage = DAMAGE_FULL;
+			} else {
+				fprintf(stderr, "%s", usage);
+				return 1;
+			}
+			break;
+		case 't':
+			stress.duration = atoi(optarg);
+			break;
+		case 'm':
+			stress.manual_frames = true;
+			break;
+		default:
+			fprintf(stderr, "%s", usage);
+			return c == 'h' ? 0 : 1;
+		}
+	}
+	if (stress.n_surfaces <= 0 || stress.surface_size <= 0 ||
+			stress.rate < 0) {
+		fprintf(stderr, "%s", usage);
+		return 1;
+	}
+
+	wlr_log_init(WLR_ERROR, NULL);
+	wl_list_init(&stress.views);
+
+	stress.display = wl_display_create();
+	stress.event_loop = wl_display_get_event_loop(stress.display);
+	stress.backend = wlr_headless_backend_create(stress.display);
+	if (stress.backend == NULL) {
+		fprintf(stderr, "failed to create headless backend\n");
+		return 1;
+	}
+	if (stress.manual_frames) {
+		wlr_headless_backend_set_manual_frames(stress.backend, true);
+	}
+
+	stress.renderer = wlr_backend_get_renderer(stress.backend);
+	wlr_renderer_init_wl_display(stress.renderer, stress.display);
+	stress.compositor = wlr_compositor_create(stress.display, stress.renderer);
+	stress.new_surface.notify = handle_new_surface;
+	wl_signal_add(&stress.compositor->events.new_surface, &stress.new_surface);
+
+	if (!wlr_backend_start(stress.backend)) {
+		fprintf(stderr, "failed to start backend\n");
+		return 1;
+	}
+	stress.output = wlr_headless_add_output(stress.backend, 1920, 1080);
+	if (stress.output == NULL) {
+		fprintf(stderr, "failed to add headless output\n");
+		return 1;
+	}
+	stress.output_frame.notify = handle_output_frame;
+	wl_signal_add(&stress.output->events.frame, &stress.output_frame);
+
+	// Connect the in-process client over a socketpair
+	int sv[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+		perror("socketpair");
+		return 1;
+	}
+	if (wl_client_create(stress.display, sv[0]) == NULL) {
+		fprintf(stderr, "failed to create client\n");
+		return 1;
+	}
+	stress.client_display = wl_display_connect_to_fd(sv[1]);
+	if (stress.client_display == NULL) {
+		fprintf(stderr, "failed to connect client\n");
+		return 1;
+	}
+	wl_event_loop_add_fd(stress.event_loop,
+		wl_display_get_fd(stress.client_display), WL_EVENT_READABLE,
+		handle_client_readable, &stress);
+
+	struct wl_registry *registry =
+		wl_display_get_registry(stress.client_display);
+	wl_registry_add_listener(registry, &registry_listener, &stress);
+	client_roundtrip(&stress);
+	if (stress.client_compositor == NULL || stress.client_shm == NULL) {
+		fprintf(stderr, "missing wl_compositor or wl_shm global\n");
+		return 1;
+	}
+
+	stress.surfaces = calloc(stress.n_surfaces,
+		sizeof(struct stress_surface));
+	if (stress.surfaces == NULL) {
+		return 1;
+	}
+	for (int i = 0; i < stress.n_surfaces; ++i) {
+		struct stress_surface *surface = &stress.surfaces[i];
+		surface->surface =
+			wl_compositor_create_surface(stress.client_compositor);
+		for (int j = 0; j < 2; ++j) {
+			surface->buffers[j] = create_shm_buffer(&stress,
+				&surface->data[j]);
+			if (surface->buffers[j] == NULL) {
+				return 1;
+			}
+		}
+	}
+	client_roundtrip(&stress);
+
+	stress.commit_timer = wl_event_loop_add_timer(stress.event_loop,
+		handle_commit_timer, &stress);
+	wl_event_source_timer_update(stress.commit_timer, 1);
+	stress.stats_timer = wl_event_loop_add_timer(stress.event_loop,
+		handle_stats_timer, &stress);
+	wl_event_source_timer_update(stress.stats_timer, 1000);
+	if (stress.duration > 0) {
+		stress.duration_timer = wl_event_loop_add_timer(stress.event_loop,
+			handle_duration_timer, &stress);
+		wl_event_source_timer_update(stress.duration_timer,
+			stress.duration * 1000);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &stress.start);
+	printf("%d surfaces of %dx%d, %d commits/s each, %s damage\n",
+		stress.n_surfaces, stress.surface_size, stress.surface_size,
+		stress.rate, stress.damage == DAMAGE_FULL ? "full" : "small");
+
+	wl_display_run(stress.display);
+
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double elapsed = timespec_diff_nsec(&end, &stress.start) / 1e9;
+	stress.total_commits += stress.commits;
+	stress.total_frames += stress.frames;
+	stress.total_render_nsec += stress.render_total_nsec;
+	printf("sustained: %.0f commits/s, %.0f frames/s, "
+		"avg render %.3f ms over %.1f s\n",
+		stress.total_commits / elapsed, stress.total_frames / elapsed,
+		stress.total_frames > 0 ?
+			stress.total_render_nsec / 1e6 / stress.total_frames : 0.0,
+		elapsed);
+
+	wl_display_destroy_clients(stress.display);
+	wl_display_destroy(stress.display);
+	return 0;
+}
@@ -1,6 +1,8 @@
 #define _POSIX_C_SOURCE 200112L
 #include <GLES2/gl2.h>
+#include <inttypes.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -30,6 +32,12 @@ struct sample_state {
 	struct wl_listener new_output;
 	struct wl_listener new_input;
 	struct wl_list touch;
+
+	// Benchmark mode: every touch event is counted and the sustained rate
+	// is reported at most once per second
+	bool bench;
+	uint64_t bench_events;
+	struct timespec bench_start, bench_report;
 };
 
 struct touch_point {
@@ -63,6 +71,33 @@ struct sample_keyboard {
 	struct wl_listener destroy;
 };
 
+static void bench_count_event(struct sample_state *sample) {
+	if (!sample->bench) {
+		return;
+	}
+	if (sample->bench_events++ == 0) {
+		clock_gettime(CLOCK_MONOTONIC, &sample->bench_start);
+		sample->bench_report = sample->bench_start;
+		return;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	double since_report = (now.tv_sec - sample->bench_report.tv_sec) +
+		(now.tv_nsec - sample->bench_report.tv_nsec) / 1e9;
+	if (since_report < 1.0) {
+		return;
+	}
+
+	double elapsed = (now.tv_sec - sample->bench_start.tv_sec) +
+		(now.tv_nsec - sample->bench_start.tv_nsec) / 1e9;
+	printf("bench: proto=touch events=%" PRIu64 " seconds=%.3f "
+		"events_per_sec=%.2f\n", sample->bench_events, elapsed,
+		sample->bench_events / elapsed);
+	fflush(stdout);
+	sample->bench_report = now;
+}
+
 static void output_frame_notify(struct wl_listener *listener, void *data) {
 	struct sample_output *sample_output = wl_container_of(listener, sample_output, frame);
 	struct sample_state *sample = sample_output->sample;
@@ -95,6 +130,7 @@ static void touch_down_notify(struct wl_listener *listener, void *data) {
 	struct wlr_event_touch_motion *event = data;
 	struct touch_state *tstate = wl_container_of(listener, tstate, down);
 	struct sample_state *sample = tstate->sample;
+	bench_count_event(sample);
 	struct touch_point *point = calloc(1, sizeof(struct touch_point));
 	point->touch_id = event->touch_id;
 	point->x = event->x;
@@ -106,6 +142,7 @@ static void touch_up_notify(struct wl_listener *listener, void *data ) {
 	struct wlr_event_touch_up *event = data;
 	struct touch_state *tstate = wl_container_of(listener, tstate, up);
 	struct sample_state *sample = tstate->sample;
+	bench_count_event(sample);
 	struct touch_point *point, *tmp;
 	wl_list_for_each_safe(point, tmp, &sample->touch_points, link) {
 		if (point->touch_id == event->touch_id) {
@@ -119,6 +156,7 @@ static void touch_motion_notify(struct wl_listener *listener, void *data) {
 	struct wlr_event_touch_motion *event = data;
 	struct touch_state *tstate = wl_container_of(listener, tstate, motion);
 	struct sample_state *sample = tstate->sample;
+	bench_count_event(sample);
 	struct touch_point *point;
 	wl_list_for_each(point, &sample->touch_points, link) {
 		if (point->touch_id == event->touch_id) {
@@ -249,6 +287,18 @@ int main(int argc, char *argv[]) {
 	wl_list_init(&state.touch_points);
 	wl_list_init(&state.touch);
 
+	int opt;
+	while ((opt = getopt(argc, argv, "b")) != -1) {
+		switch (opt) {
+		case 'b':
+			state.bench = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-b]\n", argv[0]);
+			exit(1);
+		}
+	}
+
 	struct wlr_backend *wlr = wlr_backend_autocreate(display);
 	if (!wlr) {
 		exit(1);
@@ -32,12 +32,29 @@ struct wlr_drm_plane {
 	/* Buffer currently displayed on screen */
 	struct wlr_drm_fb *current_fb;
 
+	/* In-fence for the next page-flip, or -1. The kernel waits for it to
+	 * signal before presenting pending_fb. */
+	int pending_fence_fd;
+
+	/* Multi-GPU only. When the scanout GPU can import the render GPU's
+	 * buffers directly they are scanned out as-is, skipping the cross-GPU
+	 * blit; the first failed import or commit disables the direct path. */
+	bool mgpu_was_direct;
+	bool mgpu_disable_direct;
+
 	struct wlr_drm_format_set formats;
 
 	// Only used by cursor
 	bool cursor_enabled;
+	// Whether the last commit left the cursor plane scanning out, which the
+	// position-only cursor update path requires
+	bool cursor_scanout_enabled;
 	int32_t cursor_hotspot_x, cursor_hotspot_y;
 
+	// Only used by overlay
+	bool overlay_enabled;
+	int32_t overlay_x, overlay_y;
+
 	union wlr_drm_plane_props props;
 };
 
@@ -50,17 +67,23 @@ struct wlr_drm_crtc {
 	uint32_t id;
 
 	bool pending_modeset;
+	/* The commit only toggles the ACTIVE property: it needs
+	 * DRM_MODE_ATOMIC_ALLOW_MODESET, but keeps the current mode blob so the
+	 * kernel skips mode re-validation */
+	bool pending_dpms;
 	struct wlr_drm_crtc_state pending, current;
 
 	// Atomic modesetting only
 	uint32_t mode_id;
 	uint32_t gamma_lut;
+	size_t gamma_lut_size; // resolved once, the property is immutable
 
 	// Legacy only
 	drmModeCrtc *legacy_crtc;
 
 	struct wlr_drm_plane *primary;
 	struct wlr_drm_plane *cursor;
+	struct wlr_drm_plane *overlay; // may be NULL
 
 	union wlr_drm_crtc_props props;
 };
@@ -80,9 +103,25 @@ struct wlr_drm_backend {
 	size_t num_crtcs;
 	struct wlr_drm_crtc *crtcs;
 
+	/* Whether the initial forced connector probe has been performed. Later
+	 * scans reuse the kernel's own probe results. */
+	bool scanned;
+
 	struct wl_display *display;
 	struct wl_event_source *drm_event;
 
+	/* Debounced connector rescan: change uevents arm this timer instead of
+	 * scanning directly, so a hotplug burst runs one coalesced scan. */
+	struct wl_event_source *scan_timer;
+	bool scan_pending;
+
+	/* Asynchronous modesets, see drm_async_modeset_start: worker threads run
+	 * the blocking ALLOW_MODESET commits and report completion through this
+	 * socket pair ([0] is the loop side, [1] the workers'). Both -1 when
+	 * async modesets are unavailable or disabled. */
+	int modeset_sock[2];
+	struct wl_event_source *modeset_event;
+
 	struct wl_listener display_destroy;
 	struct wl_listener session_destroy;
 	struct wl_listener session_active;
@@ -123,6 +162,12 @@ struct wlr_drm_connector {
 	uint32_t possible_crtcs;
 
 	union wlr_drm_connector_props props;
+	// Whether the connected display reports VRR support, read at connect time
+	bool vrr_capable;
+
+	// Lessee ID if the connector has been leased out with
+	// wlr_drm_create_lease, zero otherwise
+	uint32_t lessee_id;
 
 	int32_t cursor_x, cursor_y;
 
@@ -138,6 +183,18 @@ struct wlr_drm_connector {
 	 * they're sent.
 	 */
 	uint32_t pending_page_flip_crtc;
+
+	/* A page-flip was requested while another one was still pending.
+	 *
+	 * The new state is left in the planes' pending FBs and submitted from the
+	 * page-flip handler once the kernel's queue frees up, instead of failing
+	 * the commit with EBUSY.
+	 */
+	bool queued_page_flip;
+
+	/* A worker thread is still running this connector's blocking modeset.
+	 * Further commits are rejected until the completion message arrives. */
+	bool modeset_in_flight;
 };
 
 struct wlr_drm_backend *get_drm_backend_from_backend(
@@ -148,10 +205,18 @@ void finish_drm_resources(struct wlr_drm_backend *drm);
 void restore_drm_outputs(struct wlr_drm_backend *drm);
 void scan_drm_connectors(struct wlr_drm_backend *state);
 int handle_drm_event(int fd, uint32_t mask, void *data);
+int handle_drm_async_modeset(int fd, uint32_t mask, void *data);
+bool drm_async_modeset_start(struct wlr_drm_backend *drm,
+	struct wlr_drm_connector *conn, drmModeAtomicReq *req, uint32_t flags);
 void destroy_drm_connector(struct wlr_drm_connector *conn);
 bool drm_connector_set_mode(struct wlr_drm_connector *conn,
 	struct wlr_output_mode *mode);
 bool drm_connector_is_cursor_visible(struct wlr_drm_connector *conn);
+// Commits the pending state of several connectors on the same device in a
+// single request, so that the changes hit the screen on the same vblank when
+// the atomic interface is available.
+bool drm_crtcs_commit(struct wlr_drm_backend *drm,
+	struct wlr_drm_connector **conns, size_t n_conns, uint32_t flags);
 bool drm_connector_supports_vrr(struct wlr_drm_connector *conn);
 size_t drm_crtc_get_gamma_lut_size(struct wlr_drm_backend *drm,
 	struct wlr_drm_crtc *crtc);
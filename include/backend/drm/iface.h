@@ -3,6 +3,7 @@
 
 #include <gbm.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <xf86drm.h>
 #include <xf86drmMode.h>
@@ -16,6 +17,15 @@ struct wlr_drm_interface {
 	// Commit al pending changes on a CRTC.
 	bool (*crtc_commit)(struct wlr_drm_backend *drm,
 		struct wlr_drm_connector *conn, uint32_t flags);
+	// Commit all pending changes on several CRTCs at once. The atomic
+	// interface submits a single request for all of them, the legacy
+	// interface commits each CRTC in turn.
+	bool (*crtcs_commit)(struct wlr_drm_backend *drm,
+		struct wlr_drm_connector **conns, size_t n_conns, uint32_t flags);
+	// Update only the cursor plane's position from conn->cursor_x/y,
+	// without committing the rest of the CRTC's state.
+	bool (*crtc_move_cursor)(struct wlr_drm_backend *drm,
+		struct wlr_drm_connector *conn);
 };
 
 extern const struct wlr_drm_interface atomic_iface;
@@ -59,8 +59,9 @@ union wlr_drm_plane_props {
 		uint32_t crtc_h;
 		uint32_t fb_id;
 		uint32_t crtc_id;
+		uint32_t in_fence_fd; // Not guaranteed to exist
 	};
-	uint32_t props[13];
+	uint32_t props[14];
 };
 
 bool get_drm_connector_props(int fd, uint32_t id,
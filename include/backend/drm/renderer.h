@@ -2,10 +2,12 @@
 #define BACKEND_DRM_RENDERER_H
 
 #include <gbm.h>
+#include <pixman.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <wlr/backend.h>
 #include <wlr/render/wlr_renderer.h>
+#include "render/swapchain.h"
 
 struct wlr_drm_backend;
 struct wlr_drm_plane;
@@ -24,9 +26,19 @@ struct wlr_drm_surface {
 
 	uint32_t width;
 	uint32_t height;
+	// Parameters the surface was initialized with, used to skip the
+	// reallocation when it's re-initialized unchanged (e.g. on VT re-entry)
+	uint32_t format;
+	bool with_modifiers;
 
 	struct wlr_swapchain *swapchain;
 	struct wlr_buffer *back_buffer;
+
+	// Circular history of the damage blitted into the swapchain, most
+	// recent at past_damage_idx, so a cross-GPU copy can repaint only what
+	// a destination buffer of a given age is missing
+	pixman_region32_t past_damage[WLR_SWAPCHAIN_CAP];
+	size_t past_damage_idx;
 };
 
 struct wlr_drm_fb {
@@ -60,6 +72,6 @@ bool drm_plane_init_surface(struct wlr_drm_plane *plane,
 		uint32_t format, bool with_modifiers);
 void drm_plane_finish_surface(struct wlr_drm_plane *plane);
 bool drm_plane_lock_surface(struct wlr_drm_plane *plane,
-		struct wlr_drm_backend *drm);
+		struct wlr_drm_backend *drm, pixman_region32_t *damage);
 
 #endif
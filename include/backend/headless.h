@@ -1,6 +1,7 @@
 #ifndef BACKEND_HEADLESS_H
 #define BACKEND_HEADLESS_H
 
+#include <time.h>
 #include <wlr/backend/headless.h>
 #include <wlr/backend/interface.h>
 
@@ -20,6 +21,9 @@ struct wlr_headless_backend {
 	struct wl_listener renderer_destroy;
 	bool has_parent_renderer;
 	bool started;
+	/* Frames are driven by commits instead of timers, see
+	 * wlr_headless_backend_set_manual_frames */
+	bool manual_frames;
 };
 
 struct wlr_headless_output {
@@ -33,6 +37,10 @@ struct wlr_headless_output {
 
 	struct wl_event_source *frame_timer;
 	int frame_delay; // ms
+
+	// Manual-frames mode only
+	struct wl_event_source *frame_idle;
+	struct timespec virtual_present_time;
 };
 
 struct wlr_headless_input_device {
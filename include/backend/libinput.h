@@ -2,12 +2,14 @@
 #define BACKEND_LIBINPUT_H
 
 #include <libinput.h>
+#include <pthread.h>
 #include <wayland-server-core.h>
 #include <wlr/backend/interface.h>
 #include <wlr/backend/libinput.h>
 #include <wlr/interfaces/wlr_input_device.h>
 #include <wlr/types/wlr_input_device.h>
 #include <wlr/types/wlr_list.h>
+#include <wlr/types/wlr_pointer.h>
 
 struct wlr_libinput_backend {
 	struct wlr_backend backend;
@@ -18,6 +20,18 @@ struct wlr_libinput_backend {
 	struct libinput *libinput_context;
 	struct wl_event_source *input_event;
 
+	// Optional dedicated input thread (WLR_LIBINPUT_THREAD=1). The thread
+	// services the libinput fd at hardware cadence; the main loop drains
+	// libinput's event queue when woken via the pipe. The mutex serializes
+	// all access to the libinput context.
+	struct {
+		bool started;
+		pthread_t thread;
+		pthread_mutex_t mutex;
+		int wakeup_pipe[2]; // input thread -> main loop
+		int shutdown_pipe[2]; // main loop -> input thread
+	} input_thread;
+
 	struct wl_listener display_destroy;
 	struct wl_listener session_destroy;
 	struct wl_listener session_signal;
@@ -35,6 +49,7 @@ uint32_t usec_to_msec(uint64_t usec);
 
 void handle_libinput_event(struct wlr_libinput_backend *state,
 		struct libinput_event *event);
+void handle_libinput_events(struct wlr_libinput_backend *backend);
 
 struct wlr_input_device *get_appropriate_device(
 		enum wlr_input_device_type desired_type,
@@ -49,6 +64,10 @@ struct wlr_pointer *create_libinput_pointer(
 		struct libinput_device *device);
 void handle_pointer_motion(struct libinput_event *event,
 		struct libinput_device *device);
+void pointer_motion_add(struct libinput_event *event,
+		struct wlr_event_pointer_motion *wlr_event);
+void finish_pointer_motion(struct libinput_device *device,
+		struct wlr_event_pointer_motion *wlr_event);
 void handle_pointer_motion_abs(struct libinput_event *event,
 		struct libinput_device *device);
 void handle_pointer_button(struct libinput_event *event,
@@ -76,6 +76,9 @@ struct wlr_wl_output {
 	struct wl_list presentation_feedbacks;
 
 	struct wlr_swapchain *swapchain;
+	// Swapchain retired by the last size change, kept as reuse pool while
+	// sizes oscillate (e.g. interactive resize of the host window)
+	struct wlr_swapchain *prev_swapchain;
 	struct wlr_buffer *back_buffer;
 
 	uint32_t enter_serial;
@@ -113,6 +116,27 @@ struct wlr_wl_pointer {
 	struct wl_listener output_destroy;
 };
 
+enum wlr_wl_pointer_event_type {
+	WLR_WL_POINTER_EVENT_MOTION,
+	WLR_WL_POINTER_EVENT_MOTION_ABSOLUTE,
+	WLR_WL_POINTER_EVENT_BUTTON,
+	WLR_WL_POINTER_EVENT_AXIS,
+};
+
+struct wlr_wl_pointer_event {
+	enum wlr_wl_pointer_event_type type;
+	union {
+		struct wlr_event_pointer_motion motion;
+		struct wlr_event_pointer_motion_absolute motion_absolute;
+		struct wlr_event_pointer_button button;
+		struct wlr_event_pointer_axis axis;
+	};
+};
+
+// Maximum number of remote pointer events buffered within one
+// wl_pointer.frame before the queue is flushed early
+#define WLR_WL_POINTER_EVENTS_CAP 8
+
 struct wlr_wl_seat {
 	struct wl_seat *wl_seat;
 
@@ -124,6 +148,13 @@ struct wlr_wl_seat {
 
 	struct wlr_wl_backend *backend;
 	struct wlr_wl_pointer *active_pointer;
+
+	// Pointer events from the remote compositor are buffered here until its
+	// wl_pointer.frame, so one remote frame (e.g. motion+axis+button) is
+	// flushed into the seat logic as one batch instead of an emission per
+	// event
+	struct wlr_wl_pointer_event pointer_events[WLR_WL_POINTER_EVENTS_CAP];
+	size_t pointer_events_len;
 };
 
 struct wlr_wl_backend *get_wl_backend_from_backend(struct wlr_backend *backend);
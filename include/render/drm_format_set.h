@@ -15,5 +15,17 @@ struct wlr_drm_format *wlr_drm_format_dup(const struct wlr_drm_format *format);
  */
 struct wlr_drm_format *wlr_drm_format_intersect(
 	const struct wlr_drm_format *a, const struct wlr_drm_format *b);
+/**
+ * Intersect modifiers for a format in two format sets, with caching.
+ *
+ * Repeated queries for the same (a, b, format) triple hit a small cache
+ * instead of re-computing the intersection. The returned format is owned by
+ * the cache: callers must not free it, and it only stays valid until either
+ * set is mutated or finished. Returns NULL if either set doesn't contain the
+ * format, or if the formats aren't compatible.
+ */
+const struct wlr_drm_format *wlr_drm_format_set_intersect_cached(
+	const struct wlr_drm_format_set *a, const struct wlr_drm_format_set *b,
+	uint32_t format);
 
 #endif
@@ -12,6 +12,9 @@ struct wlr_gbm_buffer {
 
 	struct gbm_bo *gbm_bo; // NULL if the gbm_device has been destroyed
 	struct wlr_dmabuf_attributes dmabuf;
+
+	// Accounted allocation size, subtracted again on destroy
+	size_t mem_bytes;
 };
 
 struct wlr_gbm_allocator {
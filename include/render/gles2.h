@@ -3,15 +3,18 @@
 
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/types.h>
 #include <wlr/backend.h>
 #include <wlr/render/egl.h>
 #include <wlr/render/gles2.h>
 #include <wlr/render/interface.h>
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/render/wlr_texture.h>
+#include <wlr/util/gpu_memory.h>
 #include <wlr/util/log.h>
 
 struct wlr_gles2_pixel_format {
@@ -21,14 +24,30 @@ struct wlr_gles2_pixel_format {
 	bool has_alpha;
 };
 
+// A program whose glLinkProgram call has been issued but whose result hasn't
+// been queried yet. With GL_KHR_parallel_shader_compile the driver keeps
+// compiling on its own worker threads until a status query forces completion.
+struct wlr_gles2_pending_program {
+	GLuint program;
+	GLuint vert, frag; // still attached; zero when loaded from the binary cache
+	const GLchar *vert_src, *frag_src;
+};
+
 struct wlr_gles2_tex_shader {
 	GLuint program;
 	GLint proj;
 	GLint invert_y;
 	GLint tex;
 	GLint alpha;
+	GLint lut_enabled;
+	GLint lut;
 	GLint pos_attrib;
 	GLint tex_attrib;
+
+	// Shadowed uniform state: uniforms are program state and survive program
+	// switches, so constant uploads only need to happen once
+	bool proj_identity;
+	bool tex_unit_set;
 };
 
 struct wlr_gles2_renderer {
@@ -43,6 +62,12 @@ struct wlr_gles2_renderer {
 		bool debug_khr;
 		bool egl_image_external_oes;
 		bool egl_image_oes;
+		bool disjoint_timer_query_ext;
+		bool get_program_binary_oes;
+		bool pixel_buffer_object_nv;
+		bool map_buffer_range_ext;
+		bool texture_npot_oes;
+		bool parallel_shader_compile_khr;
 	} exts;
 
 	struct {
@@ -52,6 +77,17 @@ struct wlr_gles2_renderer {
 		PFNGLPOPDEBUGGROUPKHRPROC glPopDebugGroupKHR;
 		PFNGLPUSHDEBUGGROUPKHRPROC glPushDebugGroupKHR;
 		PFNGLEGLIMAGETARGETRENDERBUFFERSTORAGEOESPROC glEGLImageTargetRenderbufferStorageOES;
+		PFNGLGENQUERIESEXTPROC glGenQueriesEXT;
+		PFNGLDELETEQUERIESEXTPROC glDeleteQueriesEXT;
+		PFNGLBEGINQUERYEXTPROC glBeginQueryEXT;
+		PFNGLENDQUERYEXTPROC glEndQueryEXT;
+		PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuivEXT;
+		PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXT;
+		PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOES;
+		PFNGLPROGRAMBINARYOESPROC glProgramBinaryOES;
+		PFNGLMAPBUFFERRANGEEXTPROC glMapBufferRangeEXT;
+		PFNGLUNMAPBUFFEROESPROC glUnmapBufferOES;
+		PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreadsKHR;
 	} procs;
 
 	struct {
@@ -59,24 +95,153 @@ struct wlr_gles2_renderer {
 			GLuint program;
 			GLint proj;
 			GLint color;
+			GLint lut_enabled;
+			GLint lut;
 			GLint pos_attrib;
 		} quad;
 		struct {
 			GLuint program;
 			GLint proj;
 			GLint color;
+			GLint lut_enabled;
+			GLint lut;
 			GLint pos_attrib;
 			GLint tex_attrib;
 		} ellipse;
 		struct wlr_gles2_tex_shader tex_rgba;
 		struct wlr_gles2_tex_shader tex_rgbx;
+		// Red/blue swapped, only used for readback format conversion
+		struct wlr_gles2_tex_shader tex_swap_rgba;
 		struct wlr_gles2_tex_shader tex_ext;
 	} shaders;
 
+	// Program links are issued at create time but their results are only
+	// collected on first use, so shader compilation overlaps the rest of
+	// compositor startup
+	struct {
+		bool collected;
+		bool ok;
+		struct wlr_gles2_pending_program quad, ellipse, tex_rgba, tex_rgbx,
+			tex_swap_rgba, tex_ext;
+	} pending_shaders;
+
 	struct wl_list buffers; // wlr_gles2_buffer.link
 
 	struct wlr_gles2_buffer *current_buffer;
 	uint32_t viewport_width, viewport_height;
+
+	// Gamma/color LUT sampled by the fragment shaders, one ramp per channel
+	// resampled to WLR_GLES2_LUT_SIZE texels. Zero when no LUT is set.
+	GLuint lut_tex;
+
+	// Shadow copies of GL state the draw path sets on every draw, so that
+	// redundant driver calls can be skipped when consecutive draws share
+	// state. Zero means "unknown": GL code outside the draw path must call
+	// gles2_invalidate_gl_state after touching program or texture bindings.
+	struct {
+		GLuint program;
+		GLenum tex_target;
+		GLuint tex;
+		GLuint filter_tex; // texture whose GL_TEXTURE_MIN_FILTER is known
+		GLenum min_filter;
+		// GL_BLEND; a separate known flag since a zeroed shadow copy must
+		// read as "unknown", not "disabled"
+		bool blend_known;
+		bool blend;
+	} gl_state;
+
+	// The compositor declared it does no GL of its own on this context,
+	// see wlr_gles2_renderer_set_context_ownership
+	bool context_owned;
+	bool context_state_prepared; // per-context setup (blend) already done
+
+	// Counters served by wlr_renderer_get_stats; only actual driver calls
+	// are counted, not ones skipped via the gl_state shadow copies
+	struct wlr_renderer_stats stats;
+
+	// Quads sharing a shader and texture are accumulated here and drawn with
+	// a single glDrawArrays call from a persistent VBO
+	struct {
+		GLuint vbo;
+		size_t vbo_size; // size of the GL buffer store, in bytes
+
+		GLfloat *verts; // interleaved pos + texcoord, 4 floats per vertex
+		size_t len, cap; // in quads
+
+		// State shared by all batched quads
+		struct wlr_gles2_tex_shader *shader;
+		GLenum target;
+		GLuint tex;
+		GLenum min_filter;
+		bool invert_y;
+		float alpha;
+		bool blend; // whether the batched quads need blending
+	} quad_batch;
+
+	// GPU frame timing via GL_EXT_disjoint_timer_query. A small ring of
+	// queries keeps result retrieval from stalling on in-flight frames.
+	struct {
+		GLuint queries[4];
+		bool pending[4];
+		size_t next;
+		bool active; // a query is recording the current frame
+		uint64_t last_duration_ns;
+	} timer;
+
+	struct wl_list async_reads; // wlr_gles2_async_read.link
+
+	struct wl_list atlases; // wlr_gles2_atlas.link
+
+	struct wl_list dmabuf_images; // wlr_gles2_dmabuf_image.link
+
+	struct wl_list tex_pool; // wlr_gles2_tex_pool_entry.link
+
+	// Large shm texture uploads are handed off to a worker thread holding a
+	// shared EGL context, so that surface commits don't block on glTexImage2D
+	struct {
+		bool started;
+		pthread_t thread;
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		struct wl_list jobs; // wlr_gles2_upload.link
+		bool shutdown;
+	} upload;
+};
+
+// A texture upload in flight on the upload thread
+struct wlr_gles2_upload {
+	struct wl_list link; // wlr_gles2_renderer.upload.jobs
+	struct wlr_gles2_texture *texture;
+
+	const struct wlr_gles2_pixel_format *fmt;
+	uint32_t stride, width, height;
+	void *data; // copy of the pixels, owned by the job
+
+	// When non-zero, a recycled texture whose storage already has the right
+	// size and format; the worker then only performs the pixel transfer
+	GLuint recycled_tex;
+
+	bool taken; // the worker has started on this job
+	bool done;
+	// Filled in by the worker once done
+	GLuint tex;
+	EGLSyncKHR sync;
+};
+
+// Shared GL texture into which small shm textures (cursors, decorations) are
+// packed, so that drawing them doesn't cost one texture bind each
+struct wlr_gles2_atlas {
+	struct wl_list link; // wlr_gles2_renderer.atlases
+	struct wlr_gles2_renderer *renderer;
+
+	GLint gl_format, gl_type;
+	GLuint tex;
+	int size;
+
+	// Shelf-packing state
+	int row_x, row_y, row_height;
+
+	size_t n_entries;
 };
 
 struct wlr_gles2_buffer {
@@ -91,6 +256,50 @@ struct wlr_gles2_buffer {
 	struct wl_listener buffer_destroy;
 };
 
+// A cached DMA-BUF import: clients typically cycle through a small set of
+// buffers for their whole lifetime, so the EGLImage and GL texture created
+// for a buffer are shared between all textures importing it and kept around
+// for a while after the last importer goes away.
+struct wlr_gles2_dmabuf_image {
+	struct wl_list link; // wlr_gles2_renderer.dmabuf_images
+
+	// Identity of the first plane's dma-buf
+	dev_t dev;
+	ino_t inode;
+	uint32_t format;
+	uint64_t modifier;
+	int width, height;
+
+	EGLImageKHR image;
+	GLuint tex;
+	GLenum target;
+
+	size_t n_refs; // may be zero while the entry is cached for reuse
+
+	// Accounted allocation size, subtracted when the import is destroyed
+	size_t mem_bytes;
+};
+
+// A GL texture whose owning wlr_texture has been destroyed, kept around so
+// that its storage can back the next same-sized texture. During interactive
+// resizes clients retire and recreate equally-sized buffers every frame, and
+// reusing warm storage turns the driver's allocate-and-validate work into a
+// plain pixel transfer.
+struct wlr_gles2_tex_pool_entry {
+	struct wl_list link; // wlr_gles2_renderer.tex_pool
+
+	GLint gl_format, gl_type;
+	uint32_t width, height;
+
+	GLuint tex;
+
+	// Accounted allocation size, carried over from the retired texture
+	size_t mem_bytes;
+
+	// Number of frame boundaries the entry has sat unused
+	size_t frames_unused;
+};
+
 struct wlr_gles2_texture {
 	struct wlr_texture wlr_texture;
 	struct wlr_gles2_renderer *renderer;
@@ -108,6 +317,30 @@ struct wlr_gles2_texture {
 
 	// Only affects target == GL_TEXTURE_2D
 	enum wl_shm_format wl_format; // used to interpret upload data
+
+	// When non-NULL, the pixels live in the shared atlas texture at
+	// (atlas_x, atlas_y) and tex is zero
+	struct wlr_gles2_atlas *atlas;
+	int atlas_x, atlas_y;
+
+	// When non-NULL, the initial upload is still in flight on the upload
+	// thread and tex is zero until gles2_texture_sync_upload is called
+	struct wlr_gles2_upload *upload;
+
+	// When non-NULL, tex and image are owned by this shared DMA-BUF import
+	// and must not be destroyed with the texture
+	struct wlr_gles2_dmabuf_image *dmabuf_image;
+
+	// Accounted allocation size, subtracted again on destroy
+	size_t mem_bytes;
+	enum wlr_gpu_memory_type mem_type;
+
+	// Set when the texture may carry a mipmap chain, for better quality and
+	// cheaper fetches on downscaled (e.g. fractionally scaled) draws. Writes
+	// only mark the chain dirty; it is regenerated lazily on the next draw
+	// that actually minifies the texture.
+	bool mipmapped;
+	bool mipmaps_dirty;
 };
 
 const struct wlr_gles2_pixel_format *get_gles2_format_from_wl(
@@ -129,6 +362,75 @@ struct wlr_texture *gles2_texture_from_wl_drm(struct wlr_renderer *wlr_renderer,
 struct wlr_texture *gles2_texture_from_dmabuf(struct wlr_renderer *wlr_renderer,
 	struct wlr_dmabuf_attributes *attribs);
 
+// Maximum dimension for a texture to be placed in an atlas
+#define WLR_GLES2_ATLAS_MAX_ENTRY 128
+
+// Number of unreferenced DMA-BUF imports kept around for reuse
+#define WLR_GLES2_DMABUF_CACHE_SIZE 8
+
+void gles2_dmabuf_image_unref(struct wlr_gles2_renderer *renderer,
+	struct wlr_gles2_dmabuf_image *dmabuf_image);
+// The renderer's EGL context must be current
+void gles2_dmabuf_cache_destroy_all(struct wlr_gles2_renderer *renderer);
+
+// Number of retired GL textures kept for reuse
+#define WLR_GLES2_TEX_POOL_SIZE 8
+
+// Number of frame boundaries a pooled texture may sit unused before its
+// storage is handed back to the driver
+#define WLR_GLES2_TEX_POOL_MAX_AGE 8
+
+// Takes a pooled texture with exactly matching storage out of the pool, or
+// returns zero when none is cached
+GLuint gles2_tex_pool_get(struct wlr_gles2_renderer *renderer,
+	GLint gl_format, GLint gl_type, uint32_t width, uint32_t height);
+// Hands a retired GL texture to the pool; returns false when the pool
+// declined and the caller still owns the texture
+bool gles2_tex_pool_put(struct wlr_gles2_renderer *renderer, GLuint tex,
+	GLint gl_format, GLint gl_type, uint32_t width, uint32_t height,
+	size_t mem_bytes);
+// Ages the pool by one frame, deleting entries that have gone stale. The
+// renderer's EGL context must be current.
+void gles2_tex_pool_age(struct wlr_gles2_renderer *renderer);
+// The renderer's EGL context must be current
+void gles2_tex_pool_destroy_all(struct wlr_gles2_renderer *renderer);
+
+// The renderer's EGL context must be current. On success, fills in the
+// texture's atlas, atlas_x and atlas_y fields.
+bool gles2_atlas_add_texture(struct wlr_gles2_renderer *renderer,
+	struct wlr_gles2_texture *texture,
+	const struct wlr_gles2_pixel_format *fmt);
+void gles2_atlas_remove_texture(struct wlr_gles2_texture *texture);
+// The renderer's EGL context must be current
+void gles2_atlas_destroy_all(struct wlr_gles2_renderer *renderer);
+
+// Minimum dimension for a texture upload to be handed to the upload thread:
+// below this the hand-off overhead exceeds the transfer time
+#define WLR_GLES2_UPLOAD_THREAD_MIN 256
+
+// Size of the shader gamma LUT, in texels per channel. The shaders hard-code
+// the matching texel-center coordinates, so keep them in sync.
+#define WLR_GLES2_LUT_SIZE 256
+
+bool gles2_upload_thread_init(struct wlr_gles2_renderer *renderer);
+// The renderer's EGL context must be current
+void gles2_upload_thread_finish(struct wlr_gles2_renderer *renderer);
+bool gles2_upload_thread_queue(struct wlr_gles2_renderer *renderer,
+	struct wlr_gles2_texture *texture,
+	const struct wlr_gles2_pixel_format *fmt, uint32_t stride,
+	uint32_t width, uint32_t height, const void *data, GLuint recycled_tex);
+// Waits for the texture's in-flight upload, if any, and makes its result
+// visible to the renderer's context
+void gles2_texture_sync_upload(struct wlr_gles2_texture *texture);
+
+// Marks the shadowed GL state as unknown again. Must be called after GL code
+// outside the renderer's draw path changes program or texture bindings.
+void gles2_invalidate_gl_state(struct wlr_gles2_renderer *renderer);
+
+// Makes the renderer's EGL context current. In context-ownership mode the
+// eglMakeCurrent call is skipped when the context already is current.
+bool gles2_make_current(struct wlr_gles2_renderer *renderer);
+
 void push_gles2_debug_(struct wlr_gles2_renderer *renderer,
 	const char *file, const char *func);
 #define push_gles2_debug(renderer) push_gles2_debug_(renderer, _WLR_FILENAME, __func__)
@@ -0,0 +1,24 @@
+#ifndef RENDER_NULL_H
+#define RENDER_NULL_H
+
+#include <wayland-server-protocol.h>
+#include <wlr/render/interface.h>
+#include <wlr/render/null.h>
+#include <wlr/render/wlr_renderer.h>
+#include <wlr/render/wlr_texture.h>
+
+struct wlr_null_renderer {
+	struct wlr_renderer wlr_renderer;
+
+	uint32_t viewport_width, viewport_height;
+};
+
+struct wlr_null_texture {
+	struct wlr_texture wlr_texture;
+	struct wlr_null_renderer *renderer;
+
+	enum wl_shm_format wl_format;
+	bool has_alpha;
+};
+
+#endif
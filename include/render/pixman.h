@@ -0,0 +1,35 @@
+#ifndef RENDER_PIXMAN_H
+#define RENDER_PIXMAN_H
+
+#include <pixman.h>
+#include <wayland-server-protocol.h>
+#include <wlr/render/interface.h>
+#include <wlr/render/pixman.h>
+#include <wlr/render/wlr_renderer.h>
+#include <wlr/render/wlr_texture.h>
+
+struct wlr_pixman_renderer {
+	struct wlr_renderer wlr_renderer;
+
+	// Render target for the current frame, kept across frames of the same
+	// size
+	pixman_image_t *target;
+	uint32_t viewport_width, viewport_height;
+};
+
+struct wlr_pixman_texture {
+	struct wlr_texture wlr_texture;
+	struct wlr_pixman_renderer *renderer;
+
+	pixman_image_t *image;
+	void *data; // owned copy of the pixels backing image, NULL if borrowed
+
+	// When texturing directly from a mapped wl_shm pool, the buffer whose
+	// storage `image` borrows; reads must be wrapped in begin/end_access
+	struct wl_shm_buffer *shm_buffer;
+
+	enum wl_shm_format wl_format; // used to interpret upload data
+	bool has_alpha;
+};
+
+#endif
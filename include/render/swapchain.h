@@ -7,6 +7,8 @@
 
 #define WLR_SWAPCHAIN_CAP 4
 
+struct wlr_renderer;
+
 struct wlr_swapchain_slot {
 	struct wlr_buffer *buffer;
 	bool acquired; // waiting for release
@@ -38,6 +40,18 @@ void wlr_swapchain_destroy(struct wlr_swapchain *swapchain);
  */
 struct wlr_buffer *wlr_swapchain_acquire(struct wlr_swapchain *swapchain,
 	int *age);
+/**
+ * Pre-allocate every free buffer slot of the swap chain.
+ *
+ * Buffers are otherwise allocated lazily on first acquire, so the first
+ * frames after a modeset or hotplug pay for buffer allocation. If a renderer
+ * is given, each buffer is additionally bound once so that renderer-side
+ * state (e.g. FBOs) is built off the critical frame path too.
+ *
+ * Returns false if any slot could not be warmed up.
+ */
+bool wlr_swapchain_warmup(struct wlr_swapchain *swapchain,
+	struct wlr_renderer *renderer);
 /**
  * Mark the buffer as submitted for presentation. This needs to be called by
  * swap chain users on frame boundaries.
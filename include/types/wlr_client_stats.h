@@ -0,0 +1,18 @@
+#ifndef TYPES_WLR_CLIENT_STATS_H
+#define TYPES_WLR_CLIENT_STATS_H
+
+#include <stdint.h>
+#include <wayland-server-core.h>
+#include <wlr/types/wlr_client_stats.h>
+
+/*
+ * Counter maintenance, called from the wl_surface request handlers. The
+ * per-client state is created lazily on the first counted request and torn
+ * down when the client disconnects.
+ */
+void client_stats_count_commit(struct wl_client *client);
+void client_stats_count_damage(struct wl_client *client, uint32_t rects);
+void client_stats_count_frame_callback(struct wl_client *client);
+void client_stats_frame_callback_fired(struct wl_client *client);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef TYPES_WLR_OUTPUT_CAPTURE_H
+#define TYPES_WLR_OUTPUT_CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <wayland-server-core.h>
+#include <wlr/types/wlr_output.h>
+
+/**
+ * Shared, damage-driven scheduling for screen-capture consumers.
+ *
+ * All consumers capturing the same output share one pair of
+ * precommit/commit hooks instead of each hooking the output's signals;
+ * per-consumer damage interest and max-fps budgets then decide which
+ * consumers are actually woken for a given frame, so untouched frames
+ * and over-budget commits cost nothing.
+ */
+struct wlr_output_capture_consumer {
+	// Set by the owner before wlr_output_capture_add
+	bool only_damaged; // skip frames which didn't change the output
+	uint32_t max_fps; // 0 to deliver every frame
+	void (*precommit)(struct wlr_output_capture_consumer *consumer,
+		struct wlr_output_event_precommit *event);
+	void (*commit)(struct wlr_output_capture_consumer *consumer,
+		struct wlr_output_event_commit *event);
+	void *data;
+
+	// Engine state
+	struct wlr_output_capture_source *source; // NULL when detached
+	struct wl_list link; // wlr_output_capture_source::consumers
+	struct timespec last_capture;
+	bool damaged;
+	bool eligible;
+};
+
+struct wlr_output_capture_source {
+	struct wlr_output *output;
+	struct wl_list link; // private sources list
+	struct wl_list consumers; // wlr_output_capture_consumer::link
+
+	// When the source last delivered a frame to any consumer; newly added
+	// consumers start their budget from here, so a stream of short-lived
+	// consumers can't exceed its cap by re-subscribing
+	struct timespec last_capture;
+
+	struct wl_listener output_precommit;
+	struct wl_listener output_commit;
+	struct wl_listener output_destroy;
+};
+
+bool wlr_output_capture_add(struct wlr_output *output,
+	struct wlr_output_capture_consumer *consumer);
+void wlr_output_capture_remove(struct wlr_output_capture_consumer *consumer);
+/**
+ * Records that the consumer captured the current frame: starts a new
+ * max-fps budget period and resets the accumulated damage interest.
+ */
+void wlr_output_capture_consumer_captured(
+	struct wlr_output_capture_consumer *consumer);
+
+#endif
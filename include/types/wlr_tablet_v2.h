@@ -71,6 +71,19 @@ struct wlr_tablet_tool_client_v2 {
 	struct wlr_tablet_seat_client_v2 *seat;
 
 	struct wl_event_source *frame_source;
+
+	// Latest value of each axis updated while the focused surface had no
+	// frame callback pending, flushed together with the next frame event.
+	// Wheel deltas are accumulated instead of replaced.
+	uint32_t deferred_axes; // enum wlr_tablet_tool_axes
+	double x, y;
+	double pressure;
+	double distance;
+	double tilt_x, tilt_y;
+	double rotation;
+	double slider;
+	double wheel_degrees;
+	int32_t wheel_clicks;
 };
 
 struct wlr_tablet_client_v2 *tablet_client_from_resource(struct wl_resource *resource);
@@ -13,6 +13,12 @@ struct wlr_xdg_positioner_resource {
 extern const struct wlr_surface_role xdg_toplevel_surface_role;
 extern const struct wlr_surface_role xdg_popup_surface_role;
 
+struct wlr_slab;
+
+// Slab backing the per-configure toplevel state, shared between the surface
+// and toplevel translation units
+struct wlr_slab *xdg_toplevel_state_slab(void);
+
 uint32_t schedule_xdg_surface_configure(struct wlr_xdg_surface *surface);
 struct wlr_xdg_surface *create_xdg_surface(
 	struct wlr_xdg_client *client, struct wlr_surface *surface,
@@ -0,0 +1,24 @@
+#ifndef UTIL_FLUSH_H
+#define UTIL_FLUSH_H
+
+#include <wayland-server-core.h>
+
+/**
+ * Coalesced client flushing.
+ *
+ * Event senders scattered across types/ each risk paying one write() per
+ * event when they flush eagerly. flush_clients_soon instead schedules a
+ * single wl_display_flush_clients pass as an idle task of the display's
+ * event loop: any number of events sent during one dispatch turn leave in
+ * one write per client. Calling it repeatedly within a turn is cheap, the
+ * pass is only scheduled once.
+ */
+void flush_clients_soon(struct wl_display *display);
+
+/**
+ * Same as flush_clients_soon, for senders that hold the client but not the
+ * display.
+ */
+void client_flush_soon(struct wl_client *client);
+
+#endif
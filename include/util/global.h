@@ -12,4 +12,25 @@
 void wlr_global_destroy_safe(struct wl_global *global,
 	struct wl_display *display);
 
+/**
+ * Called on the first bind of a lazy global. Returns the implementation
+ * state passed to the global's bind function, or NULL on failure (in which
+ * case the bind is rejected and the next bind tries again).
+ */
+typedef void *(*wlr_lazy_global_init_func_t)(struct wl_display *display,
+	void *data);
+
+/**
+ * Create a global that is advertised to clients right away, but whose
+ * implementation state is only constructed when a client first binds it.
+ * `init` is called once, on the first bind; the value it returns replaces
+ * `data` as the user data handed to `bind`. The bookkeeping lives until the
+ * display is destroyed, so this is only suitable for globals that stay
+ * registered for the lifetime of the display.
+ */
+struct wl_global *wlr_global_create_lazy(struct wl_display *display,
+	const struct wl_interface *interface, int version,
+	wl_global_bind_func_t bind, wlr_lazy_global_init_func_t init,
+	void *data);
+
 #endif
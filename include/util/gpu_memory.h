@@ -0,0 +1,19 @@
+#ifndef UTIL_GPU_MEMORY_H
+#define UTIL_GPU_MEMORY_H
+
+#include <stddef.h>
+#include <wlr/util/gpu_memory.h>
+
+/**
+ * Internal accounting hooks. Every gpu_memory_add must be paired with a
+ * gpu_memory_sub of the same type and size when the allocation goes away;
+ * the per-client variants additionally attribute the bytes to a client.
+ * Client entries clean themselves up when the client disconnects, so a
+ * late gpu_memory_client_sub for a gone client is a safe no-op.
+ */
+void gpu_memory_add(enum wlr_gpu_memory_type type, size_t bytes);
+void gpu_memory_sub(enum wlr_gpu_memory_type type, size_t bytes);
+void gpu_memory_client_add(struct wl_client *client, size_t bytes);
+void gpu_memory_client_sub(struct wl_client *client, size_t bytes);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef UTIL_MAP_H
+#define UTIL_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An open-addressing hash map from non-zero uint32 IDs to pointers, for
+ * object tables that are looked up by ID on every event (X11 window IDs, DRM
+ * object IDs). Linear probing with backward-shift deletion, so there are no
+ * tombstones; the table grows once it is two-thirds full.
+ */
+struct wlr_map {
+	uint32_t *keys; // 0 marks an empty slot
+	void **values;
+	size_t len;
+	size_t cap; // always zero or a power of two
+};
+
+void wlr_map_init(struct wlr_map *map);
+void wlr_map_finish(struct wlr_map *map);
+/**
+ * Inserts or replaces the value stored under a key. The key must be non-zero.
+ * Returns false on allocation failure, leaving the map unchanged.
+ */
+bool wlr_map_insert(struct wlr_map *map, uint32_t key, void *value);
+void *wlr_map_get(struct wlr_map *map, uint32_t key);
+/**
+ * Removes and returns the value stored under a key, or NULL if the key is
+ * absent.
+ */
+void *wlr_map_remove(struct wlr_map *map, uint32_t key);
+
+#endif
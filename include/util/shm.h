@@ -1,7 +1,17 @@
 #ifndef UTIL_SHM_H
 #define UTIL_SHM_H
 
+#include <stddef.h>
+
 int create_shm_file(void);
 int allocate_shm_file(size_t size);
+/**
+ * Creates a file pre-filled with the given data and seals it against any
+ * further modification. The returned descriptor and dup()s of it can be
+ * handed out to clients directly and shared between them. Fails when the
+ * seals cannot be applied (no memfd support); callers must then fall back
+ * to a private copy per client.
+ */
+int allocate_sealed_shm_file(const void *data, size_t size);
 
 #endif
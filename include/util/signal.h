@@ -1,8 +1,43 @@
 #ifndef UTIL_SIGNAL_H
 #define UTIL_SIGNAL_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <wayland-server-core.h>
 
 void wlr_signal_emit_safe(struct wl_signal *signal, void *data);
 
+/**
+ * An array-backed multi-listener emitter for high-frequency signals.
+ *
+ * wlr_signal_emit_safe chases pointers through separately allocated
+ * wl_listener nodes and splices two sentinels into the list per emit. For
+ * signals that fire on every commit or input event, this stores listeners in
+ * a compact array instead, so emission is a linear scan.
+ *
+ * Listeners registered with wlr_fast_signal_add must be removed with
+ * wlr_fast_signal_remove, not wl_list_remove. The embedded wl_signal remains
+ * available through wl_signal_add for code that doesn't care about emission
+ * cost; it is emitted after the array.
+ *
+ * Handlers may add and remove listeners (including themselves) during
+ * emission: listeners removed mid-emit are not called, listeners added
+ * mid-emit are first called on the next emit.
+ */
+struct wlr_fast_signal {
+	struct wl_signal legacy;
+	struct wl_listener **entries;
+	size_t len, cap;
+	size_t nesting; // > 0 while emitting
+	bool compact_pending; // an entry was removed during emission
+};
+
+void wlr_fast_signal_init(struct wlr_fast_signal *signal);
+void wlr_fast_signal_finish(struct wlr_fast_signal *signal);
+void wlr_fast_signal_add(struct wlr_fast_signal *signal,
+	struct wl_listener *listener);
+void wlr_fast_signal_remove(struct wlr_fast_signal *signal,
+	struct wl_listener *listener);
+void wlr_fast_signal_emit(struct wlr_fast_signal *signal, void *data);
+
 #endif
@@ -0,0 +1,33 @@
+#ifndef UTIL_SLAB_H
+#define UTIL_SLAB_H
+
+#include <stddef.h>
+
+/**
+ * A slab allocator for short-lived, same-sized objects.
+ *
+ * Entries are carved out of malloc'd chunks and recycled through a free
+ * list, so steady-state allocation is a pointer pop and entries freed
+ * together stay close in memory. Intended for objects churned on hot paths
+ * such as the surface commit path. Not thread-safe; like the rest of
+ * wlroots it assumes a single event-loop thread.
+ */
+struct wlr_slab {
+	size_t entry_size;
+	size_t chunk_entries;
+	struct wlr_slab_chunk *chunks;
+	void *free_list;
+};
+
+void wlr_slab_init(struct wlr_slab *slab, size_t entry_size);
+/**
+ * Releases all chunks. All entries must have been freed beforehand.
+ */
+void wlr_slab_finish(struct wlr_slab *slab);
+/**
+ * Returns a zeroed entry, or NULL on allocation failure.
+ */
+void *wlr_slab_alloc(struct wlr_slab *slab);
+void wlr_slab_free(struct wlr_slab *slab, void *ptr);
+
+#endif
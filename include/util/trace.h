@@ -0,0 +1,58 @@
+#ifndef UTIL_TRACE_H
+#define UTIL_TRACE_H
+
+#include <stdbool.h>
+#include <wlr/config.h>
+
+/**
+ * Statically-defined tracepoints (USDT) under the "wlroots" provider. These
+ * compile to a single nop until a tracer arms them, so they can stay in
+ * production builds and be attached to without rebuilding, e.g.:
+ *
+ *   bpftrace -e 'usdt:libwlroots.so:wlroots:output_commit { ... }'
+ *
+ * Arguments are limited to integers and pointers; pass pointers to structs
+ * for the tracer to read the fields it cares about.
+ */
+#if WLR_HAS_TRACEPOINTS
+
+#include <sys/sdt.h>
+
+#define wlr_trace(name, ...) STAP_PROBEV(wlroots, name, ##__VA_ARGS__)
+
+#else
+
+#define wlr_trace(name, ...)
+
+#endif
+
+/**
+ * In-process span recorder backing wlr_trace_start/dump (see
+ * wlr/util/trace.h). Complements the USDT tracepoints above: those need an
+ * external tracer attached, the recorder dumps from within the process.
+ *
+ * `name` must be a string literal (or otherwise outlive the recording):
+ * only the pointer is stored.
+ */
+extern bool trace_recorder_active;
+void trace_recorder_record(const char *name, char phase);
+
+static inline void trace_span_begin(const char *name) {
+	if (trace_recorder_active) {
+		trace_recorder_record(name, 'B');
+	}
+}
+
+static inline void trace_span_end(const char *name) {
+	if (trace_recorder_active) {
+		trace_recorder_record(name, 'E');
+	}
+}
+
+static inline void trace_span_instant(const char *name) {
+	if (trace_recorder_active) {
+		trace_recorder_record(name, 'i');
+	}
+}
+
+#endif
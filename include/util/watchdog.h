@@ -0,0 +1,17 @@
+#ifndef UTIL_WATCHDOG_H
+#define UTIL_WATCHDOG_H
+
+#include <stdbool.h>
+#include <wayland-server-core.h>
+
+/**
+ * Hooks for the event-loop stall watchdog, see wlr/util/watchdog.h. The
+ * signal emitters call these around every listener dispatch when the
+ * watchdog is running; only the outermost listener of a nested emit chain
+ * is tracked and timed.
+ */
+extern bool watchdog_active;
+void watchdog_listener_begin(struct wl_listener *listener);
+void watchdog_listener_end(struct wl_listener *listener);
+
+#endif
@@ -12,6 +12,7 @@
 #include <wayland-server-core.h>
 #include <wlr/backend.h>
 #include <wlr/backend/session.h>
+#include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_output.h>
 
 /**
@@ -40,4 +41,61 @@ typedef struct _drmModeModeInfo drmModeModeInfo;
 struct wlr_output_mode *wlr_drm_connector_add_mode(struct wlr_output *output,
 	const drmModeModeInfo *mode);
 
+/**
+ * Scans out a dma-buf buffer on the output's overlay plane, at (x, y) in
+ * output-buffer coordinates, bypassing composition for that buffer entirely.
+ *
+ * The buffer is checked against the plane's formats and with a test-only
+ * atomic commit: when this returns false the caller must composite the
+ * buffer's content instead. The overlay is shown above the primary plane
+ * starting with the output's next commit, and stays on screen until this is
+ * called again (with NULL to disable the overlay).
+ *
+ * Requires the atomic interface and an output whose CRTC has an overlay
+ * plane.
+ */
+bool wlr_drm_connector_set_overlay_buffer(struct wlr_output *output,
+	struct wlr_buffer *buffer, int x, int y);
+
+/**
+ * Validates the pending state of several DRM outputs with a single test-only
+ * atomic commit spanning all of their CRTCs.
+ *
+ * Stage the whole configuration with wlr_output_enable, wlr_output_set_mode
+ * etc., call this once, and only then commit each output: serial per-head
+ * test-and-commit cycles (and their flicker) are avoided because every head
+ * is known to be acceptable before the first modeset happens.
+ *
+ * All outputs must belong to the same DRM backend. Returns false when the
+ * configuration is rejected or when it cannot be validated this way (legacy
+ * interface, or an output that has no CRTC or has never rendered); callers
+ * should then fall back to applying head by head.
+ */
+bool wlr_drm_backend_test_outputs(struct wlr_output **outputs,
+	size_t n_outputs);
+
+/**
+ * Leases the given outputs to another DRM master, handing over their
+ * connectors, CRTCs and primary (plus cursor, when present) planes. The
+ * returned file descriptor is a restricted DRM device the lessee (e.g. a VR
+ * runtime) can drive directly, with no compositor involvement per frame.
+ *
+ * All outputs must belong to the same DRM backend and have a CRTC assigned
+ * (i.e. be enabled). While leased, the outputs reject commits; terminate the
+ * lease to take them back. The lease is revoked automatically when a leased
+ * connector is disconnected or disappears.
+ *
+ * Returns the lease file descriptor and stores the lessee ID (to pass to
+ * wlr_drm_backend_terminate_lease) in lessee_id, or returns -1 on failure.
+ */
+int wlr_drm_create_lease(struct wlr_output **outputs, size_t n_outputs,
+	uint32_t *lessee_id);
+
+/**
+ * Terminates a lease previously created with wlr_drm_create_lease and makes
+ * the leased outputs available to the compositor again.
+ */
+bool wlr_drm_backend_terminate_lease(struct wlr_backend *backend,
+	uint32_t lessee_id);
+
 #endif
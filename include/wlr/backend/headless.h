@@ -37,6 +37,19 @@ struct wlr_output *wlr_headless_add_output(struct wlr_backend *backend,
  */
 struct wlr_input_device *wlr_headless_add_input_device(
 	struct wlr_backend *backend, enum wlr_input_device_type type);
+/**
+ * Switches the backend between timed and manual frames.
+ *
+ * By default outputs tick at their configured refresh rate using real-time
+ * timers. In manual mode the timers are stopped and each commit immediately
+ * produces its presentation and `frame` events, with presentation timestamps
+ * advancing a virtual clock by one refresh period per frame. This lets the
+ * full commit/render pipeline run as fast as the CPU allows, which is useful
+ * for benchmarks and tests that want to simulate minutes of output activity
+ * in seconds.
+ */
+void wlr_headless_backend_set_manual_frames(struct wlr_backend *backend,
+	bool manual);
 bool wlr_backend_is_headless(struct wlr_backend *backend);
 bool wlr_input_device_is_headless(struct wlr_input_device *device);
 bool wlr_output_is_headless(struct wlr_output *output);
@@ -39,9 +39,14 @@ struct wlr_egl_context {
 struct wlr_egl {
 	EGLDisplay display;
 	EGLContext context;
+	EGLContext upload_context; // may be EGL_NO_CONTEXT
 	EGLDeviceEXT device; // may be EGL_NO_DEVICE_EXT
 	struct gbm_device *gbm_device;
 
+	// Whether the driver granted the EGL_IMG_context_priority high priority
+	// request for the primary context
+	bool has_high_priority;
+
 	struct {
 		// Display extensions
 		bool bind_wayland_display_wl;
@@ -50,6 +55,10 @@ struct wlr_egl {
 		bool image_dmabuf_import_ext;
 		bool image_dmabuf_import_modifiers_ext;
 
+		// Display extensions
+		bool fence_sync_khr;
+		bool native_fence_sync_android;
+
 		// Device extensions
 		bool device_drm_ext;
 	} exts;
@@ -68,6 +77,11 @@ struct wlr_egl {
 		PFNEGLDEBUGMESSAGECONTROLKHRPROC eglDebugMessageControlKHR;
 		PFNEGLQUERYDISPLAYATTRIBEXTPROC eglQueryDisplayAttribEXT;
 		PFNEGLQUERYDEVICESTRINGEXTPROC eglQueryDeviceStringEXT;
+		PFNEGLQUERYDEVICESEXTPROC eglQueryDevicesEXT;
+		PFNEGLCREATESYNCKHRPROC eglCreateSyncKHR;
+		PFNEGLDESTROYSYNCKHRPROC eglDestroySyncKHR;
+		PFNEGLCLIENTWAITSYNCKHRPROC eglClientWaitSyncKHR;
+		PFNEGLDUPNATIVEFENCEFDANDROIDPROC eglDupNativeFenceFDANDROID;
 	} procs;
 
 	struct wl_display *wl_display;
@@ -79,6 +93,12 @@ struct wlr_egl {
 /**
  * Initializes an EGL context for the given platform and remote display.
  * Will attempt to load all possibly required api functions.
+ *
+ * With EGL_PLATFORM_DEVICE_EXT and a NULL remote_display, a device is
+ * selected via EGL_EXT_device_enumeration. The last-known-good choice is
+ * cached on disk ($XDG_CACHE_HOME/wlroots-egl-device) and revalidated
+ * against the device's DRM node and driver extension string, so repeat
+ * startups on multi-GPU machines skip probing the other devices.
  */
 struct wlr_egl *wlr_egl_create(EGLenum platform, void *remote_display);
 
@@ -141,6 +161,14 @@ bool wlr_egl_unset_current(struct wlr_egl *egl);
 
 bool wlr_egl_is_current(struct wlr_egl *egl);
 
+/**
+ * Returns true if the context was created with high priority via
+ * EGL_IMG_context_priority. A high priority context gets its GPU work
+ * scheduled ahead of client contexts, which keeps compositing responsive
+ * when a fullscreen client saturates the GPU.
+ */
+bool wlr_egl_has_high_priority(struct wlr_egl *egl);
+
 /**
  * Save the current EGL context to the structure provided in the argument.
  *
@@ -155,4 +183,50 @@ bool wlr_egl_restore_context(struct wlr_egl_context *context);
 
 int wlr_egl_dup_drm_fd(struct wlr_egl *egl);
 
+/**
+ * Inserts a fence into the current GL command stream of the context.
+ *
+ * Returns EGL_NO_SYNC_KHR if fences are unsupported.
+ */
+EGLSyncKHR wlr_egl_create_sync(struct wlr_egl *egl);
+
+/**
+ * Destroys a fence created with wlr_egl_create_sync.
+ */
+void wlr_egl_destroy_sync(struct wlr_egl *egl, EGLSyncKHR sync);
+
+/**
+ * Checks whether a fence has signalled, without blocking.
+ */
+bool wlr_egl_check_sync(struct wlr_egl *egl, EGLSyncKHR sync);
+
+/**
+ * Inserts a native fence into the current GL command stream of the context.
+ *
+ * Returns EGL_NO_SYNC_KHR if EGL_ANDROID_native_fence_sync is unsupported.
+ */
+EGLSyncKHR wlr_egl_create_native_sync(struct wlr_egl *egl);
+
+/**
+ * Duplicates the sync file backing a native fence sync. The commands creating
+ * the sync must have been flushed beforehand.
+ *
+ * The caller is responsible for closing the returned file descriptor.
+ * Returns -1 on failure.
+ */
+int wlr_egl_dup_fence_fd(struct wlr_egl *egl, EGLSyncKHR sync);
+
+/**
+ * Creates a second context sharing objects with the primary one, intended to
+ * be made current on a texture upload thread.
+ */
+bool wlr_egl_create_upload_context(struct wlr_egl *egl);
+
+/**
+ * Make the upload context current on the calling thread.
+ */
+bool wlr_egl_make_upload_current(struct wlr_egl *egl);
+
+bool wlr_egl_unset_upload_current(struct wlr_egl *egl);
+
 #endif
@@ -21,6 +21,16 @@ struct wlr_egl *wlr_gles2_renderer_get_egl(struct wlr_renderer *renderer);
 bool wlr_gles2_renderer_check_ext(struct wlr_renderer *renderer,
 	const char *ext);
 
+/**
+ * Declare that the renderer is the sole user of its EGL context and GL
+ * state. The renderer then keeps the context current across frames, skips
+ * redundant eglMakeCurrent calls and stops re-establishing GL state at the
+ * start of every frame. Compositors that issue GL calls of their own (or
+ * hand the context to another library) must leave this disabled.
+ */
+void wlr_gles2_renderer_set_context_ownership(struct wlr_renderer *renderer,
+	bool owned);
+
 struct wlr_gles2_texture_attribs {
 	GLenum target; /* either GL_TEXTURE_2D or GL_TEXTURE_EXTERNAL_OES */
 	GLuint tex;
@@ -9,6 +9,7 @@
 #ifndef WLR_RENDER_INTERFACE_H
 #define WLR_RENDER_INTERFACE_H
 
+#include <pixman.h>
 #include <stdbool.h>
 #include <wayland-server-protocol.h>
 #include <wlr/render/wlr_renderer.h>
@@ -28,6 +29,10 @@ struct wlr_renderer_impl {
 	bool (*render_subtexture_with_matrix)(struct wlr_renderer *renderer,
 		struct wlr_texture *texture, const struct wlr_fbox *box,
 		const float matrix[static 9], float alpha);
+	bool (*render_subtexture_with_matrix_damage)(struct wlr_renderer *renderer,
+		struct wlr_texture *texture, const struct wlr_fbox *box,
+		const float matrix[static 9], float alpha,
+		pixman_region32_t *damage);
 	void (*render_quad_with_matrix)(struct wlr_renderer *renderer,
 		const float color[static 4], const float matrix[static 9]);
 	void (*render_ellipse_with_matrix)(struct wlr_renderer *renderer,
@@ -47,9 +52,20 @@ struct wlr_renderer_impl {
 		uint32_t *flags, uint32_t stride, uint32_t width, uint32_t height,
 		uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y,
 		void *data);
+	bool (*read_pixels_async)(struct wlr_renderer *renderer,
+		enum wl_shm_format fmt, uint32_t *flags, uint32_t stride,
+		uint32_t width, uint32_t height, uint32_t src_x, uint32_t src_y,
+		uint32_t dst_x, uint32_t dst_y, void *data,
+		wlr_renderer_read_pixels_cb cb, void *cb_data);
+	size_t (*poll_async_reads)(struct wlr_renderer *renderer);
 	struct wlr_texture *(*texture_from_pixels)(struct wlr_renderer *renderer,
 		enum wl_shm_format fmt, uint32_t stride, uint32_t width,
 		uint32_t height, const void *data);
+	struct wlr_texture *(*texture_from_shm_resource)(
+		struct wlr_renderer *renderer, struct wl_resource *resource);
+	struct wlr_texture *(*texture_from_pixels_borrowed)(
+		struct wlr_renderer *renderer, enum wl_shm_format fmt,
+		uint32_t stride, uint32_t width, uint32_t height, const void *data);
 	struct wlr_texture *(*texture_from_wl_drm)(struct wlr_renderer *renderer,
 		struct wl_resource *data);
 	struct wlr_texture *(*texture_from_dmabuf)(struct wlr_renderer *renderer,
@@ -59,8 +75,16 @@ struct wlr_renderer_impl {
 		struct wl_display *wl_display);
 	bool (*blit_dmabuf)(struct wlr_renderer *renderer,
 		struct wlr_dmabuf_attributes *dst,
-		struct wlr_dmabuf_attributes *src);
+		struct wlr_dmabuf_attributes *src, const struct wlr_fbox *src_box);
 	int (*get_drm_fd)(struct wlr_renderer *renderer);
+	bool (*get_render_timings)(struct wlr_renderer *renderer,
+		struct wlr_render_timings *timings);
+	bool (*get_stats)(struct wlr_renderer *renderer,
+		struct wlr_renderer_stats *stats);
+	void (*reset_stats)(struct wlr_renderer *renderer);
+	int (*get_fence_fd)(struct wlr_renderer *renderer);
+	bool (*set_gamma_lut)(struct wlr_renderer *renderer, size_t ramp_size,
+		const uint16_t *r, const uint16_t *g, const uint16_t *b);
 };
 
 void wlr_renderer_init(struct wlr_renderer *renderer,
@@ -72,8 +96,11 @@ struct wlr_texture_impl {
 		uint32_t stride, uint32_t width, uint32_t height,
 		uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y,
 		const void *data);
+	bool (*write_pixels_region)(struct wlr_texture *texture,
+		uint32_t stride, pixman_region32_t *region, const void *data);
 	bool (*to_dmabuf)(struct wlr_texture *texture,
 		struct wlr_dmabuf_attributes *attribs);
+	bool (*detach)(struct wlr_texture *texture);
 	void (*destroy)(struct wlr_texture *texture);
 };
 
@@ -0,0 +1,25 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_RENDER_NULL_H
+#define WLR_RENDER_NULL_H
+
+#include <wlr/render/wlr_renderer.h>
+
+/**
+ * Creates a renderer that accepts textures and discards all drawing. It is
+ * meant for benchmarking: paired with the noop backend it makes it possible
+ * to measure pure protocol and commit overhead, with no GPU or pixel work at
+ * all. read_pixels fabricates zeroed pixels.
+ */
+struct wlr_renderer *wlr_null_renderer_create(void);
+
+bool wlr_renderer_is_null(struct wlr_renderer *renderer);
+bool wlr_texture_is_null(struct wlr_texture *texture);
+
+#endif
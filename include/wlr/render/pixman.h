@@ -0,0 +1,23 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_RENDER_PIXMAN_H
+#define WLR_RENDER_PIXMAN_H
+
+#include <wlr/render/wlr_renderer.h>
+
+/**
+ * Creates a software renderer backed by pixman. It doesn't require a GPU or
+ * an EGL context, at the cost of rendering and reading pixels on the CPU.
+ */
+struct wlr_renderer *wlr_pixman_renderer_create(void);
+
+bool wlr_renderer_is_pixman(struct wlr_renderer *renderer);
+bool wlr_texture_is_pixman(struct wlr_texture *texture);
+
+#endif
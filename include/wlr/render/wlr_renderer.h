@@ -9,6 +9,7 @@
 #ifndef WLR_RENDER_WLR_RENDERER_H
 #define WLR_RENDER_WLR_RENDERER_H
 
+#include <pixman.h>
 #include <stdint.h>
 #include <wayland-server-protocol.h>
 #include <wlr/backend.h>
@@ -23,6 +24,25 @@ struct wlr_renderer_impl;
 struct wlr_drm_format_set;
 struct wlr_buffer;
 
+struct wlr_render_timings {
+	// Duration the GPU spent rendering the last completed frame, in
+	// nanoseconds. Zero if no frame has finished on the GPU yet.
+	uint64_t gpu_render_duration_ns;
+};
+
+/**
+ * Counters of what the renderer did, accumulated since renderer creation or
+ * the last wlr_renderer_reset_stats call.
+ */
+struct wlr_renderer_stats {
+	uint64_t draw_calls;
+	uint64_t texture_binds;
+	uint64_t shader_switches;
+	uint64_t scissor_changes;
+	// Bytes uploaded through wlr_texture_write_pixels
+	uint64_t bytes_uploaded;
+};
+
 struct wlr_renderer {
 	const struct wlr_renderer_impl *impl;
 
@@ -61,6 +81,22 @@ bool wlr_render_texture_with_matrix(struct wlr_renderer *r,
 bool wlr_render_subtexture_with_matrix(struct wlr_renderer *r,
 	struct wlr_texture *texture, const struct wlr_fbox *box,
 	const float matrix[static 9], float alpha);
+/**
+ * Renders the requested texture using the provided matrix, restricted to the
+ * given damage region. The per-rectangle scissoring happens inside the
+ * renderer, so GL state is only set up once per texture instead of once per
+ * damage rectangle. The scissor box is left disabled on return.
+ */
+bool wlr_render_texture_with_matrix_damage(struct wlr_renderer *r,
+	struct wlr_texture *texture, const float matrix[static 9], float alpha,
+	pixman_region32_t *damage);
+/**
+ * Same as wlr_render_texture_with_matrix_damage, after cropping the texture
+ * to the provided rectangle.
+ */
+bool wlr_render_subtexture_with_matrix_damage(struct wlr_renderer *r,
+	struct wlr_texture *texture, const struct wlr_fbox *box,
+	const float matrix[static 9], float alpha, pixman_region32_t *damage);
 /**
  * Renders a solid rectangle in the specified color.
  */
@@ -114,11 +150,44 @@ bool wlr_renderer_read_pixels(struct wlr_renderer *r, enum wl_shm_format fmt,
 	uint32_t *flags, uint32_t stride, uint32_t width, uint32_t height,
 	uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y, void *data);
 
+typedef void (*wlr_renderer_read_pixels_cb)(bool success, void *user_data);
+
+/**
+ * Same as wlr_renderer_read_pixels, but without stalling the rendering
+ * pipeline: the read is performed asynchronously when the renderer supports
+ * it, and `cb` is invoked once the pixels have landed in `data`.
+ *
+ * `data` (and `flags`, if not NULL) must remain valid until the callback has
+ * been invoked. The callback is invoked exactly once, and may fire before
+ * this function returns if the renderer only supports synchronous reads.
+ * Callers are responsible for calling wlr_renderer_poll_async_reads until no
+ * reads remain pending.
+ */
+bool wlr_renderer_read_pixels_async(struct wlr_renderer *r,
+	enum wl_shm_format fmt, uint32_t *flags, uint32_t stride, uint32_t width,
+	uint32_t height, uint32_t src_x, uint32_t src_y, uint32_t dst_x,
+	uint32_t dst_y, void *data, wlr_renderer_read_pixels_cb cb,
+	void *cb_data);
+
+/**
+ * Checks pending asynchronous reads for completion, invoking their callbacks.
+ * Returns the number of reads still pending.
+ */
+size_t wlr_renderer_poll_async_reads(struct wlr_renderer *r);
+
 /**
  * Blits the dmabuf in src onto the one in dst.
  */
 bool wlr_renderer_blit_dmabuf(struct wlr_renderer *r,
 	struct wlr_dmabuf_attributes *dst, struct wlr_dmabuf_attributes *src);
+/**
+ * Blits the src_box region (in src pixel coordinates) of the dmabuf in src
+ * onto the one in dst, scaling to the destination's size on the GPU. A NULL
+ * src_box blits the whole source.
+ */
+bool wlr_renderer_blit_dmabuf_region(struct wlr_renderer *r,
+	struct wlr_dmabuf_attributes *dst, struct wlr_dmabuf_attributes *src,
+	const struct wlr_fbox *src_box);
 /**
  * Creates necessary shm and invokes the initialization of the implementation.
  *
@@ -127,6 +196,29 @@ bool wlr_renderer_blit_dmabuf(struct wlr_renderer *r,
 bool wlr_renderer_init_wl_display(struct wlr_renderer *r,
 	struct wl_display *wl_display);
 
+/**
+ * Obtains GPU timings for the last frame rendered between wlr_renderer_begin
+ * and wlr_renderer_end. Results trail the submitted frames by a few
+ * vblanks, since the GPU is queried asynchronously to avoid stalling.
+ *
+ * Returns false if the renderer doesn't support GPU timing queries.
+ */
+bool wlr_renderer_get_render_timings(struct wlr_renderer *r,
+	struct wlr_render_timings *timings);
+
+/**
+ * Obtains the renderer's statistics counters for the current epoch.
+ *
+ * Returns false if the renderer doesn't maintain statistics.
+ */
+bool wlr_renderer_get_stats(struct wlr_renderer *r,
+	struct wlr_renderer_stats *stats);
+
+/**
+ * Starts a new statistics epoch, resetting all counters to zero.
+ */
+void wlr_renderer_reset_stats(struct wlr_renderer *r);
+
 /**
  * Obtains the FD of the DRM device used for rendering, or -1 if unavailable.
  *
@@ -134,6 +226,27 @@ bool wlr_renderer_init_wl_display(struct wlr_renderer *r,
  */
 int wlr_renderer_get_drm_fd(struct wlr_renderer *r);
 
+/**
+ * Exports a sync file FD fencing all rendering submitted up to this point,
+ * or -1 if explicit synchronization is unsupported.
+ *
+ * The caller is responsible for closing the FD.
+ */
+int wlr_renderer_get_fence_fd(struct wlr_renderer *r);
+
+/**
+ * Sets a gamma/color LUT applied by the renderer while compositing, as one
+ * ramp per channel in the wlr_output_set_gamma format. Pass a ramp_size of
+ * zero to remove the LUT again.
+ *
+ * This is an alternative to the KMS gamma property: ramp changes take effect
+ * on the next frame without a KMS round trip.
+ *
+ * Returns false if the renderer doesn't support color LUTs.
+ */
+bool wlr_renderer_set_gamma_lut(struct wlr_renderer *r, size_t ramp_size,
+	const uint16_t *red, const uint16_t *green, const uint16_t *blue);
+
 /**
  * Destroys this wlr_renderer. Textures must be destroyed separately.
  */
@@ -9,6 +9,7 @@
 #ifndef WLR_RENDER_WLR_TEXTURE_H
 #define WLR_RENDER_WLR_TEXTURE_H
 
+#include <pixman.h>
 #include <stdint.h>
 #include <wayland-server-protocol.h>
 #include <wlr/render/dmabuf.h>
@@ -32,6 +33,39 @@ struct wlr_texture *wlr_texture_from_pixels(struct wlr_renderer *renderer,
 	enum wl_shm_format wl_fmt, uint32_t stride, uint32_t width, uint32_t height,
 	const void *data);
 
+/**
+ * Create a new texture directly from a wl_shm buffer resource, without copying
+ * the pixels. The texture borrows the client's mapped pool for as long as the
+ * wl_buffer exists, so the caller must withhold wl_buffer.release while the
+ * texture is in use and must call wlr_texture_detach() when the wl_buffer is
+ * destroyed. Returns NULL if the renderer doesn't support sampling from client
+ * memory; the caller should then fall back to wlr_texture_from_pixels.
+ *
+ * Should not be called in a rendering block like renderer_begin()/end() or
+ * between attaching a renderer to an output and committing it.
+ */
+struct wlr_texture *wlr_texture_from_shm_resource(struct wlr_renderer *renderer,
+	struct wl_resource *resource);
+
+/**
+ * Create a new texture that borrows a caller-owned pixel allocation instead
+ * of copying it. `stride` is in bytes. The contract: the caller keeps the
+ * memory valid and the layout unchanged for the texture's whole lifetime,
+ * and calls wlr_texture_detach() before freeing or reusing the allocation.
+ * Content changes written by the caller become visible the next time the
+ * texture is sampled.
+ *
+ * Returns NULL if the renderer can't sample from caller memory (the GLES2
+ * renderer has no EGL path for arbitrary allocations); the caller should
+ * then fall back to wlr_texture_from_pixels.
+ *
+ * Should not be called in a rendering block like renderer_begin()/end() or
+ * between attaching a renderer to an output and committing it.
+ */
+struct wlr_texture *wlr_texture_from_pixels_borrowed(
+	struct wlr_renderer *renderer, enum wl_shm_format wl_fmt, uint32_t stride,
+	uint32_t width, uint32_t height, const void *data);
+
 /**
  * Create a new texture from a wl_drm resource. The returned texture is
  * immutable.
@@ -76,9 +110,39 @@ bool wlr_texture_write_pixels(struct wlr_texture *texture,
 	uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y,
 	const void *data);
 
+/**
+  * Update a texture with raw pixels in all rectangles of the given region.
+  * Source and destination coordinates are identical. Adjacent rectangles are
+  * coalesced and the upload state is only set up once, which is considerably
+  * cheaper than one wlr_texture_write_pixels call per rectangle.
+  *
+  * The same restrictions as for wlr_texture_write_pixels apply.
+  */
+bool wlr_texture_write_pixels_region(struct wlr_texture *texture,
+	uint32_t stride, pixman_region32_t *region, const void *data);
+
+/**
+  * Returns a monotonic counter of pixels uploaded to textures via
+  * wlr_texture_from_pixels and the write_pixels family, across all
+  * renderers. Sampling it once per frame gives the upload bandwidth spent
+  * on shm clients, which is useful to verify that damage-driven partial
+  * uploads behave as expected.
+  */
+uint64_t wlr_texture_get_upload_pixels(void);
+
 bool wlr_texture_to_dmabuf(struct wlr_texture *texture,
 	struct wlr_dmabuf_attributes *attribs);
 
+/**
+ * Make a texture self-contained. A texture created with
+ * wlr_texture_from_shm_resource samples directly from the client's mapped
+ * pool; calling this copies the pixels into texture-owned storage so that the
+ * texture stays valid after the wl_buffer is destroyed. Textures which already
+ * own their storage are left untouched. Returns false on allocation failure,
+ * in which case the texture must not be sampled anymore.
+ */
+bool wlr_texture_detach(struct wlr_texture *texture);
+
 /**
  * Destroys this wlr_texture.
  */
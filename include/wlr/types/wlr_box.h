@@ -11,6 +11,7 @@
 
 #include <pixman.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <wayland-server-protocol.h>
 
 struct wlr_box {
@@ -46,4 +47,33 @@ void wlr_box_rotated_bounds(struct wlr_box *dest, const struct wlr_box *box, flo
 
 void wlr_box_from_pixman_box32(struct wlr_box *dest, const pixman_box32_t box);
 
+/*
+ * Batch variants of the helpers above, operating on parallel edge arrays
+ * (structure-of-arrays: x1/y1 are the top-left corner, x2/y2 one past the
+ * bottom-right, like pixman_box32_t). The loops are branchless so compilers
+ * can autovectorize them; damage and culling code touching hundreds of rects
+ * per frame should prefer these over looping the single-box helpers.
+ */
+
+/**
+ * Clips each box against `clip` in place. `clip` must not be empty. Boxes
+ * that don't intersect the clip box end up with x2 <= x1 or y2 <= y1.
+ */
+void wlr_box_batch_intersect(size_t len, int x1[], int y1[], int x2[],
+	int y2[], const struct wlr_box *clip);
+
+/**
+ * Returns the index of the first box containing the point, or `len` if no
+ * box does.
+ */
+size_t wlr_box_batch_contains_point(size_t len, const int x1[],
+	const int y1[], const int x2[], const int y2[], double x, double y);
+
+/**
+ * Computes the bounding box of all boxes. The boxes must not be empty; an
+ * empty `dest` is returned for `len` == 0.
+ */
+void wlr_box_batch_bounds(struct wlr_box *dest, size_t len, const int x1[],
+	const int y1[], const int x2[], const int y2[]);
+
 #endif
@@ -76,6 +76,22 @@ void wlr_buffer_unlock(struct wlr_buffer *buffer);
  */
 bool wlr_buffer_get_dmabuf(struct wlr_buffer *buffer,
 	struct wlr_dmabuf_attributes *attribs);
+/**
+ * Enables or disables release batching. When enabled, wl_buffer.release
+ * events triggered by wlr_buffer_unlock are queued instead of being sent
+ * immediately, and flushed together by wlr_buffer_flush_releases. This
+ * coalesces client wakeups: instead of waking up for each buffer released
+ * during a repaint, clients receive all releases in one batch.
+ *
+ * Disabling release batching flushes any queued releases.
+ */
+void wlr_buffer_set_release_batching(bool enabled);
+/**
+ * Sends all queued wl_buffer.release events. This is called automatically
+ * after each output commit; compositors releasing buffers outside of the
+ * repaint loop may want to call it at other natural flush points as well.
+ */
+void wlr_buffer_flush_releases(void);
 
 /**
  * A client buffer.
@@ -99,6 +115,20 @@ struct wlr_client_buffer {
 
 	struct wl_listener resource_destroy;
 	struct wl_listener release;
+
+	/**
+	 * Link in the queue of pending releases when release batching is
+	 * enabled, see wlr_buffer_set_release_batching. Empty otherwise.
+	 */
+	struct wl_list deferred_link;
+
+	/**
+	 * Graphics memory attributed to the importing client, see
+	 * wlr_gpu_memory_client_bytes. The client pointer is only used as a key
+	 * for the accounting and may outlive the resource.
+	 */
+	struct wl_client *mem_client;
+	size_t mem_bytes;
 };
 
 struct wlr_renderer;
@@ -0,0 +1,57 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_TYPES_WLR_CLIENT_STATS_H
+#define WLR_TYPES_WLR_CLIENT_STATS_H
+
+#include <stdint.h>
+#include <wayland-server-core.h>
+
+/**
+ * Protocol cost accounting for one wl_client. Counters are maintained by the
+ * wl_surface request handlers, where the expensive per-client work enters the
+ * compositor.
+ */
+struct wlr_client_stats {
+	// Monotonic totals since the client connected
+	uint64_t commits;
+	uint64_t damage_rects;
+	uint64_t frame_callbacks;
+
+	// Frame callbacks requested but not yet fired
+	uint32_t frame_callbacks_pending;
+
+	// Rates over the last completed accounting window, normalized to one
+	// second
+	uint32_t commits_per_sec;
+	uint32_t damage_rects_per_sec;
+};
+
+/**
+ * Returns the accounting state for a client, or NULL when nothing has been
+ * recorded for it yet. The returned pointer stays valid until the client
+ * disconnects.
+ */
+const struct wlr_client_stats *wlr_client_get_stats(struct wl_client *client);
+
+typedef void (*wlr_client_throttle_hook_t)(struct wl_client *client,
+	const struct wlr_client_stats *stats, void *data);
+
+/**
+ * Installs a hook invoked at most once per second for each client whose
+ * commit or damage-rect rate exceeded the given threshold during the last
+ * accounting window. Compositors can use it to identify abusive clients and
+ * deprioritize them (e.g. withhold frame events from their surfaces or lower
+ * their process priority); wlroots itself takes no action. A threshold of 0
+ * disables that check; a NULL hook removes the hook.
+ */
+void wlr_client_stats_set_throttle_hook(uint32_t max_commits_per_sec,
+	uint32_t max_damage_rects_per_sec, wlr_client_throttle_hook_t hook,
+	void *data);
+
+#endif
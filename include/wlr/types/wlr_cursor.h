@@ -48,6 +48,9 @@ struct wlr_cursor {
 	 */
 	struct {
 		struct wl_signal motion;
+		// Emitted at full input rate even when motion coalescing is enabled,
+		// for consumers like relative-pointer clients that want every delta
+		struct wl_signal motion_raw;
 		struct wl_signal motion_absolute;
 		struct wl_signal button;
 		struct wl_signal axis;
@@ -131,6 +134,17 @@ void wlr_cursor_warp_absolute(struct wlr_cursor *cur,
 void wlr_cursor_move(struct wlr_cursor *cur, struct wlr_input_device *dev,
 	double delta_x, double delta_y);
 
+/**
+ * Enable or disable motion coalescing. When enabled, relative motion events
+ * are accumulated instead of forwarded, and a single motion event with the
+ * summed delta and the latest timestamp is emitted per frame of the output the
+ * cursor is on — intermediate positions of a high-rate mouse are never
+ * displayed anyway. The motion_raw signal keeps firing at full input rate, so
+ * relative-pointer clients can still be fed every delta. Disabling flushes any
+ * pending motion.
+ */
+void wlr_cursor_set_motion_coalescing(struct wlr_cursor *cur, bool enabled);
+
 /**
  * Set the cursor image. stride is given in bytes. If pixels is NULL, hides the
  * cursor.
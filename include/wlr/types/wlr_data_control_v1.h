@@ -33,6 +33,17 @@ struct wlr_data_control_device_v1 {
 	struct wl_resource *selection_offer_resource; // current selection offer
 	struct wl_resource *primary_selection_offer_resource; // current primary selection offer
 
+	// Sources the current offers were created from, so offers are only
+	// regenerated when the seat's selection actually changes
+	struct wlr_data_source *announced_source;
+	struct wlr_primary_selection_source *announced_primary_source;
+
+	// Deferred selection delivery: changes are flagged here and announced
+	// from an idle callback, collapsing bursts into one offer
+	struct wl_event_source *send_idle;
+	bool selection_pending;
+	bool primary_selection_pending;
+
 	struct wl_listener seat_destroy;
 	struct wl_listener seat_set_selection;
 	struct wl_listener seat_set_primary_selection;
@@ -13,10 +13,16 @@
 #include <wayland-server-core.h>
 #include <wlr/render/dmabuf.h>
 
+struct wlr_output_capture_consumer;
+
 struct wlr_export_dmabuf_manager_v1 {
 	struct wl_global *global;
 	struct wl_list frames; // wlr_export_dmabuf_frame_v1::link
 
+	// Maximum number of frames delivered per second to each capture client,
+	// or 0 (the default) to deliver every frame
+	uint32_t max_capture_fps;
+
 	struct wl_listener display_destroy;
 
 	struct {
@@ -33,7 +39,7 @@ struct wlr_export_dmabuf_frame_v1 {
 
 	bool cursor_locked;
 
-	struct wl_listener output_commit;
+	struct wlr_output_capture_consumer *consumer; // NULL until subscribed
 };
 
 struct wlr_export_dmabuf_manager_v1 *wlr_export_dmabuf_manager_v1_create(
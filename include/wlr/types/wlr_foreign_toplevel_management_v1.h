@@ -38,6 +38,7 @@ struct wlr_foreign_toplevel_handle_v1_output {
 	struct wl_list link; // wlr_foreign_toplevel_handle_v1::outputs
 	struct wl_listener output_destroy;
 	struct wlr_output *output;
+	bool enter_sent; // whether clients were told about this output yet
 
 	struct wlr_foreign_toplevel_handle_v1 *toplevel;
 };
@@ -53,6 +54,9 @@ struct wlr_foreign_toplevel_handle_v1 {
 	struct wlr_foreign_toplevel_handle_v1 *parent;
 	struct wl_list outputs; // wlr_foreign_toplevel_v1_output
 	uint32_t state; // wlr_foreign_toplevel_v1_state
+	// Bitmask of fields that changed since the last done event. Changes are
+	// accumulated and flushed as one batch per event loop iteration.
+	uint32_t dirty;
 
 	struct {
 		// wlr_foreign_toplevel_handle_v1_maximized_event
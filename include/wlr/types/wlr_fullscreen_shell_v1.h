@@ -36,4 +36,18 @@ struct wlr_fullscreen_shell_v1_present_surface_event {
 struct wlr_fullscreen_shell_v1 *wlr_fullscreen_shell_v1_create(
 	struct wl_display *display);
 
+/**
+ * Try to present a fullscreen-shell surface via direct scanout, bypassing
+ * the renderer. This only succeeds for DMA-BUF client buffers whose size
+ * and transform already match the output exactly, and only if the backend
+ * accepts the buffer for the primary plane.
+ *
+ * On success the buffer is attached to the output's pending state and the
+ * caller only needs to call wlr_output_commit(). On failure the output's
+ * pending state is rolled back and the caller should fall back to
+ * rendering the surface as usual.
+ */
+bool wlr_fullscreen_shell_v1_surface_attach_scanout(
+	struct wlr_surface *surface, struct wlr_output *output);
+
 #endif
@@ -1,6 +1,7 @@
 #ifndef WLR_TYPES_WLR_GAMMA_CONTROL_V1_H
 #define WLR_TYPES_WLR_GAMMA_CONTROL_V1_H
 
+#include <stdbool.h>
 #include <wayland-server-core.h>
 
 struct wlr_gamma_control_manager_v1 {
@@ -23,7 +24,10 @@ struct wlr_gamma_control_v1 {
 
 	uint16_t *table;
 	size_t ramp_size;
+	// Set when the table changed but hasn't been applied to the output yet
+	bool table_dirty;
 
+	struct wl_listener output_precommit_listener;
 	struct wl_listener output_commit_listener;
 	struct wl_listener output_destroy_listener;
 
@@ -24,6 +24,7 @@
 struct wlr_idle {
 	struct wl_global *global;
 	struct wl_list idle_timers; // wlr_idle_timeout::link
+	struct wl_list seats; // wlr_idle_seat_timers::link
 	struct wl_event_loop *event_loop;
 	bool enabled;
 
@@ -39,9 +40,12 @@ struct wlr_idle {
 struct wlr_idle_timeout {
 	struct wl_resource *resource;
 	struct wl_list link;
+	struct wlr_idle *idle;
 	struct wlr_seat *seat;
 
-	struct wl_event_source *idle_source;
+	// Seat idle time already elapsed when this timer was last reset; the
+	// timer fires when the seat's shared clock reaches offset + timeout
+	uint32_t offset;
 	bool idle_state;
 	bool enabled;
 	uint32_t timeout; // milliseconds
@@ -9,6 +9,8 @@
 #ifndef WLR_TYPES_WLR_IDLE_INHIBIT_V1_H
 #define WLR_TYPES_WLR_IDLE_INHIBIT_V1_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <wayland-server-core.h>
 
 /* This interface permits clients to inhibit the idle behavior such as
@@ -25,12 +27,16 @@
 
 struct wlr_idle_inhibit_manager_v1 {
 	struct wl_list inhibitors; // wlr_idle_inhibit_inhibitor_v1::link
+	size_t n_inhibitors; // maintained incrementally, avoids list walks
 	struct wl_global *global;
 
 	struct wl_listener display_destroy;
 
 	struct {
 		struct wl_signal new_inhibitor;
+		// Emitted when the first inhibitor appears or the last one goes
+		// away, i.e. whenever wlr_idle_inhibit_v1_inhibited() changes
+		struct wl_signal inhibited;
 		struct wl_signal destroy;
 	} events;
 
@@ -38,6 +44,7 @@ struct wlr_idle_inhibit_manager_v1 {
 };
 
 struct wlr_idle_inhibitor_v1 {
+	struct wlr_idle_inhibit_manager_v1 *manager;
 	struct wlr_surface *surface;
 	struct wl_resource *resource;
 	struct wl_listener surface_destroy;
@@ -53,4 +60,12 @@ struct wlr_idle_inhibitor_v1 {
 
 struct wlr_idle_inhibit_manager_v1 *wlr_idle_inhibit_v1_create(struct wl_display *display);
 
+/**
+ * Whether any idle inhibitor is currently active. Constant-time: backed by a
+ * counter updated on inhibitor create/destroy, so compositors can gate their
+ * idle timers (wlr_idle_set_enabled) from the inhibited event without
+ * walking the inhibitor list.
+ */
+bool wlr_idle_inhibit_v1_inhibited(struct wlr_idle_inhibit_manager_v1 *manager);
+
 #endif
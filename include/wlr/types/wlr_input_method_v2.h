@@ -46,6 +46,9 @@ struct wlr_input_method_v2 {
 
 	struct wl_list link;
 
+	// Pending batched done, see wlr_input_method_v2_schedule_done
+	struct wl_event_source *done_idle;
+
 	struct wl_listener seat_client_destroy;
 
 	struct {
@@ -97,6 +100,16 @@ void wlr_input_method_v2_send_content_type(
 void wlr_input_method_v2_send_text_change_cause(
 	struct wlr_input_method_v2 *input_method, uint32_t cause);
 void wlr_input_method_v2_send_done(struct wlr_input_method_v2 *input_method);
+
+/**
+ * Schedules a single done for the current event-loop iteration. Use this
+ * instead of wlr_input_method_v2_send_done when relaying text-input state:
+ * the activate/surrounding-text/change-cause/content-type updates caused
+ * by one keystroke then reach the input method under one done instead of
+ * one per update.
+ */
+void wlr_input_method_v2_schedule_done(
+	struct wlr_input_method_v2 *input_method);
 void wlr_input_method_v2_send_unavailable(
 	struct wlr_input_method_v2 *input_method);
 
@@ -53,6 +53,12 @@ struct wlr_keyboard {
 
 	char *keymap_string;
 	size_t keymap_size;
+	// Sealed read-only file backing keymap_string, shared across all clients
+	// and keyboards with the same keymap, or -1 if it couldn't be created
+	int keymap_fd;
+	// Cache entry backing keymap, keymap_string and keymap_fd, or NULL if the
+	// keyboard holds private copies (private to types/wlr_keyboard.c)
+	struct keymap_cache_entry *keymap_cache_entry;
 	struct xkb_keymap *keymap;
 	struct xkb_state *xkb_state;
 	xkb_led_index_t led_indexes[WLR_LED_COUNT];
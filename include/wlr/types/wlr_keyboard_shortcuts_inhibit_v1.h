@@ -27,6 +27,15 @@ struct wlr_keyboard_shortcuts_inhibit_manager_v1 {
 	struct wl_list inhibitors;
 	struct wl_global *global;
 
+	// Memoizes the last wlr_keyboard_shortcuts_inhibit_v1_find() result,
+	// including negative ones; reset whenever an inhibitor comes or goes
+	struct {
+		bool valid;
+		struct wlr_surface *surface;
+		struct wlr_seat *seat;
+		struct wlr_keyboard_shortcuts_inhibitor_v1 *inhibitor;
+	} find_cache;
+
 	struct wl_listener display_destroy;
 
 	struct {
@@ -38,6 +47,7 @@ struct wlr_keyboard_shortcuts_inhibit_manager_v1 {
 };
 
 struct wlr_keyboard_shortcuts_inhibitor_v1 {
+	struct wlr_keyboard_shortcuts_inhibit_manager_v1 *manager;
 	struct wlr_surface *surface;
 	struct wlr_seat *seat;
 	bool active;
@@ -76,6 +86,17 @@ struct wlr_keyboard_shortcuts_inhibitor_v1 {
 struct wlr_keyboard_shortcuts_inhibit_manager_v1 *
 wlr_keyboard_shortcuts_inhibit_v1_create(struct wl_display *display);
 
+/**
+ * Returns the inhibitor for the given surface and seat, or NULL if there is
+ * none. Meant for the keyboard event path: consecutive lookups for the same
+ * surface and seat are answered from a cache, so per-key checks don't walk
+ * the inhibitor list.
+ */
+struct wlr_keyboard_shortcuts_inhibitor_v1 *
+wlr_keyboard_shortcuts_inhibit_v1_find(
+	struct wlr_keyboard_shortcuts_inhibit_manager_v1 *manager,
+	struct wlr_surface *surface, struct wlr_seat *seat);
+
 void wlr_keyboard_shortcuts_inhibitor_v1_activate(
 	struct wlr_keyboard_shortcuts_inhibitor_v1 *inhibitor);
 
@@ -29,6 +29,8 @@
  */
 struct wlr_layer_shell_v1 {
 	struct wl_global *global;
+	struct wl_list surfaces; // wlr_layer_surface_v1::link
+	struct wl_list outputs; // wlr_layer_shell_v1_output::link
 
 	struct wl_listener display_destroy;
 
@@ -37,12 +39,31 @@ struct wlr_layer_shell_v1 {
 		// Note: the output may be NULL. In this case, it is your
 		// responsibility to assign an output before returning.
 		struct wl_signal new_surface;
+		// struct wlr_layer_shell_v1_output *
+		// Raised when exclusive zones changed the remaining usable area
+		// of an output arranged with wlr_layer_shell_v1_arrange.
+		struct wl_signal usable_area_changed;
 		struct wl_signal destroy;
 	} events;
 
 	void *data;
 };
 
+/**
+ * Per-output state of the arrangement engine, created by
+ * wlr_layer_shell_v1_arrange.
+ */
+struct wlr_layer_shell_v1_output {
+	struct wl_list link; // wlr_layer_shell_v1::outputs
+	struct wlr_layer_shell_v1 *shell;
+	struct wlr_output *output;
+
+	struct wlr_box full_area; // area passed to wlr_layer_shell_v1_arrange
+	struct wlr_box usable_area; // full_area minus exclusive zones
+
+	struct wl_listener output_destroy;
+};
+
 struct wlr_layer_surface_v1_state {
 	uint32_t anchor;
 	int32_t exclusive_zone;
@@ -66,10 +87,18 @@ struct wlr_layer_surface_v1 {
 	struct wlr_output *output;
 	struct wl_resource *resource;
 	struct wlr_layer_shell_v1 *shell;
+	struct wl_list link; // wlr_layer_shell_v1::surfaces
 	struct wl_list popups; // wlr_xdg_popup::link
 
 	char *namespace;
 
+	// Set by the arrangement engine: the surface's position and size on the
+	// output, and a snapshot of the usable area as it was when this surface
+	// was arranged. The snapshot lets a commit re-arrange only this surface
+	// and the ones that come after it.
+	struct wlr_box geometry;
+	struct wlr_box arrange_area;
+
 	bool added, configured, mapped, closed;
 	uint32_t configure_serial;
 	uint32_t configure_next_serial;
@@ -129,6 +158,23 @@ void wlr_layer_surface_v1_configure(struct wlr_layer_surface_v1 *surface,
  */
 void wlr_layer_surface_v1_close(struct wlr_layer_surface_v1 *surface);
 
+/**
+ * Arrange all layer surfaces assigned to the given output within full_area,
+ * configuring each surface and computing its position into the geometry
+ * field. The engine remembers the arrangement so that later commits only
+ * recompute the surfaces a change actually affects, and raises the
+ * usable_area_changed event when exclusive zones change the remaining area.
+ */
+void wlr_layer_shell_v1_arrange(struct wlr_layer_shell_v1 *shell,
+		struct wlr_output *output, const struct wlr_box *full_area);
+
+/**
+ * Get the arrangement state for an output, or NULL if the output has never
+ * been passed to wlr_layer_shell_v1_arrange.
+ */
+struct wlr_layer_shell_v1_output *wlr_layer_shell_v1_get_output(
+		struct wlr_layer_shell_v1 *shell, struct wlr_output *output);
+
 bool wlr_surface_is_layer_surface(struct wlr_surface *surface);
 
 struct wlr_layer_surface_v1 *wlr_layer_surface_v1_from_wlr_surface(
@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include <wayland-server-protocol.h>
 #include <wlr/render/dmabuf.h>
+#include <wlr/render/drm_format_set.h>
 
 struct wlr_dmabuf_v1_buffer {
 	struct wlr_renderer *renderer;
@@ -46,6 +47,11 @@ struct wlr_linux_dmabuf_v1 {
 	struct wl_global *global;
 	struct wlr_renderer *renderer;
 
+	// When set, only format/modifier pairs present here are advertised,
+	// see wlr_linux_dmabuf_v1_set_scanout_formats
+	struct wlr_drm_format_set scanout_formats;
+	bool has_scanout_formats;
+
 	struct {
 		struct wl_signal destroy;
 	} events;
@@ -67,4 +73,20 @@ struct wlr_linux_dmabuf_v1 *wlr_linux_dmabuf_v1_create(struct wl_display *displa
 struct wlr_linux_dmabuf_v1 *wlr_linux_dmabuf_v1_from_resource(
 	struct wl_resource *resource);
 
+/**
+ * Restrict the advertised format/modifier pairs to those also present in
+ * the given set, typically the primary plane's scanout formats. Clients
+ * then can only allocate buffers that are eligible for direct scanout,
+ * instead of picking a modifier the display engine can't handle.
+ *
+ * Pass NULL to go back to advertising every texture format. Only clients
+ * binding after the call see the changed list; the zwp_linux_dmabuf_v1
+ * version this implementation speaks has no way to re-send formats to
+ * existing clients. Meant for single-app/embedded compositors where every
+ * surface is a scanout candidate.
+ */
+bool wlr_linux_dmabuf_v1_set_scanout_formats(
+	struct wlr_linux_dmabuf_v1 *linux_dmabuf,
+	const struct wlr_drm_format_set *scanout_formats);
+
 #endif
@@ -16,13 +16,24 @@ struct wlr_list {
 	size_t capacity;
 	size_t length;
 	void **items;
+	// Inline storage used until the list outgrows it, so short-lived lists
+	// never allocate. Note that `items` may point into the struct itself:
+	// a wlr_list must not be copied or moved by value.
+	void *inline_items[4];
 };
 
 /**
- * Initialize a list. Returns true on success, false on failure.
+ * Initialize a list. Returns true on success, false on failure. Does not
+ * allocate: the first few items are stored inline.
  */
 bool wlr_list_init(struct wlr_list *list);
 
+/**
+ * Ensure the list has room for at least `capacity` items, growing its
+ * storage in one step if needed. Returns true on success, false on failure.
+ */
+bool wlr_list_reserve(struct wlr_list *list, size_t capacity);
+
 /**
  * Deinitialize a list.
  */
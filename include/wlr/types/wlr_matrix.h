@@ -17,6 +17,7 @@
 #ifndef WLR_TYPES_WLR_MATRIX_H
 #define WLR_TYPES_WLR_MATRIX_H
 
+#include <stddef.h>
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_box.h>
 
@@ -56,4 +57,12 @@ void wlr_matrix_project_box(float mat[static 9], const struct wlr_box *box,
 	enum wl_output_transform transform, float rotation,
 	const float projection[static 9]);
 
+/** Projects an array of boxes at once, writing one matrix per box. All boxes
+ *  share the transform, rotation and projection, so the loop-invariant part of
+ *  the composition is only computed once — noticeably cheaper than one
+ *  wlr_matrix_project_box call per box when projecting many boxes per frame. */
+void wlr_matrix_project_boxes(float (*mats)[9], const struct wlr_box *boxes,
+	size_t len, enum wl_output_transform transform, float rotation,
+	const float projection[static 9]);
+
 #endif
@@ -0,0 +1,65 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_TYPES_WLR_OCCLUSION_H
+#define WLR_TYPES_WLR_OCCLUSION_H
+
+#include <pixman.h>
+#include <stdbool.h>
+#include <wlr/types/wlr_box.h>
+#include <wlr/types/wlr_surface.h>
+
+/**
+ * Front-to-back occlusion tracking based on surface opaque regions.
+ *
+ * Compositors iterate their scene from topmost to bottommost, asking for each
+ * surface's visible region and accumulating its opaque region along the way.
+ * The visible region can be intersected with the output damage to skip
+ * painting covered areas entirely.
+ */
+struct wlr_occlusion {
+	pixman_region32_t opaque; // accumulated opaque area, in layout coordinates
+};
+
+void wlr_occlusion_init(struct wlr_occlusion *occlusion);
+void wlr_occlusion_finish(struct wlr_occlusion *occlusion);
+/**
+ * Computes the part of a surface not covered by the opaque regions of the
+ * surfaces added before it, and accumulates this surface's own opaque region.
+ * The surface's top-left corner is at (lx, ly) in layout coordinates.
+ *
+ * `visible` is overwritten with the visible region, in layout coordinates.
+ * Returns false when the surface is entirely occluded and doesn't need to be
+ * drawn at all.
+ *
+ * Surfaces must be added from topmost to bottommost.
+ */
+bool wlr_occlusion_add_surface(struct wlr_occlusion *occlusion,
+	struct wlr_surface *surface, int lx, int ly, pixman_region32_t *visible);
+/**
+ * Adds a surface and its whole subsurface tree, and updates the tree's
+ * occlusion state: if no part of any surface in the tree is visible, the
+ * tree is marked occluded via wlr_surface_set_occluded, suppressing texture
+ * uploads until it becomes visible again. The tree's topmost-first order is
+ * respected internally.
+ *
+ * Returns false when the entire tree is occluded; compositors will usually
+ * also skip sending frame-done events to such trees. Trees must be added
+ * from topmost to bottommost, like individual surfaces.
+ */
+bool wlr_occlusion_add_surface_tree(struct wlr_occlusion *occlusion,
+	struct wlr_surface *surface, int lx, int ly);
+/**
+ * Same as wlr_occlusion_add_surface, for a plain rectangle: useful for
+ * server-side decorations, backgrounds and other non-surface elements.
+ * `opaque` tells whether the rectangle itself hides what's below it.
+ */
+bool wlr_occlusion_add_box(struct wlr_occlusion *occlusion,
+	const struct wlr_box *box, bool opaque, pixman_region32_t *visible);
+
+#endif
@@ -41,6 +41,22 @@ struct wlr_output_cursor {
 	struct wl_listener surface_commit;
 	struct wl_listener surface_destroy;
 
+	// Optional drag-and-drop icon, see wlr_output_cursor_set_drag_surface
+	struct wlr_surface *drag_surface;
+	int32_t drag_dx, drag_dy;
+	// True while the icon is composited onto the hardware cursor plane: the
+	// compositor must not render it as a regular surface as well
+	bool drag_surface_on_plane;
+	struct wl_listener drag_surface_commit;
+	struct wl_listener drag_surface_destroy;
+
+	// CPU copy of the last wlr_output_cursor_set_image pixels, kept to
+	// recomposite the image with a drag icon (private)
+	uint8_t *image_pixels;
+	int32_t image_stride;
+	uint32_t image_width, image_height;
+	struct wlr_texture *drag_texture;
+
 	struct {
 		struct wl_signal destroy;
 	} events;
@@ -177,6 +193,24 @@ struct wlr_output {
 	struct wl_event_source *idle_frame;
 	struct wl_event_source *idle_done;
 
+	// Predictive frame scheduling, see wlr_output_enable_frame_scheduler
+	bool frame_scheduler_enabled;
+	struct wl_event_source *frame_timer;
+	// Estimated time between the frame event and the resulting commit (nsec)
+	int64_t frame_render_time_pred;
+	// When the last frame event was emitted
+	struct timespec last_frame_signal;
+
+	// Frame pipelining, see wlr_output_enable_frame_pipelining
+	bool frame_pipelining_enabled;
+	// A second frame has been committed behind the one awaiting its flip
+	bool frame_queued;
+
+	// Frame suppression, see wlr_output_suppress_frames
+	bool frames_suppressed;
+	// A frame event was swallowed while suppressed or disabled
+	bool suppressed_frame_pending;
+
 	int attach_render_locks; // number of locks forcing rendering
 
 	struct wl_list cursors; // wlr_output_cursor::link
@@ -380,6 +414,45 @@ void wlr_output_rollback(struct wlr_output *output);
  * it is a no-op.
  */
 void wlr_output_schedule_frame(struct wlr_output *output);
+/**
+ * Enables or disables predictive frame scheduling on this output.
+ *
+ * By default the `frame` event fires right after a buffer has been presented,
+ * so compositors render a full refresh period ahead of the deadline and
+ * finished frames queue up, adding latency. With the scheduler enabled, the
+ * event is delayed until one refresh period minus the output's estimated
+ * render time (plus a safety margin), so rendering finishes just before the
+ * next vblank. The estimate is learnt from the delay between each frame event
+ * and the commit it triggers; while it is unknown, or when the output's
+ * refresh rate is unknown, frame events behave as usual.
+ */
+void wlr_output_enable_frame_scheduler(struct wlr_output *output, bool enabled);
+/**
+ * Enables or disables frame pipelining on this output.
+ *
+ * By default only one frame can be committed at a time, so the time between a
+ * commit and its presentation is dead time and GPU-heavy frames miss the next
+ * vblank. With pipelining enabled, a `frame` event is emitted right after each
+ * commit and one extra frame may be committed behind the one awaiting its
+ * flip; the backend submits it as soon as the flip completes. This trades one
+ * frame of latency for a much better chance of hitting every vblank under
+ * load. Not every backend can queue a frame; when it cannot, the extra commit
+ * fails and the compositor retries on the next `frame` event.
+ */
+void wlr_output_enable_frame_pipelining(struct wlr_output *output,
+	bool enabled);
+/**
+ * Suppresses or resumes `frame` events on this output.
+ *
+ * An output nobody can see — one whose content is an exact mirror of another
+ * output, say — still costs a render pass per refresh when the compositor
+ * answers its frame events. While suppression is enabled, frame events are
+ * swallowed instead of emitted; the same happens for disabled outputs
+ * regardless of this setting. When suppression is lifted (or the output is
+ * re-enabled) after an event was swallowed, a frame is scheduled so
+ * rendering resumes cleanly.
+ */
+void wlr_output_suppress_frames(struct wlr_output *output, bool suppressed);
 /**
  * Returns the maximum length of each gamma ramp, or 0 if unsupported.
  */
@@ -440,6 +513,21 @@ bool wlr_output_cursor_set_image(struct wlr_output_cursor *cursor,
 	int32_t hotspot_x, int32_t hotspot_y);
 void wlr_output_cursor_set_surface(struct wlr_output_cursor *cursor,
 	struct wlr_surface *surface, int32_t hotspot_x, int32_t hotspot_y);
+/**
+ * Attaches a drag-and-drop icon surface to the cursor. While the cursor uses
+ * an image set with wlr_output_cursor_set_image and the icon is a small wl_shm
+ * surface, both are composited together and presented on the hardware cursor
+ * plane, so moving a drag doesn't repaint the outputs underneath. (dx, dy) is
+ * the position of the icon's top-left corner relative to the cursor image's
+ * top-left corner, in buffer pixels.
+ *
+ * Whenever the icon can't ride the plane (software cursor, oversized or
+ * non-shm icon), drag_surface_on_plane is false and the compositor must keep
+ * rendering the icon as a regular surface. Check it after every call and after
+ * each icon or cursor commit. Pass a NULL surface to detach the icon.
+ */
+void wlr_output_cursor_set_drag_surface(struct wlr_output_cursor *cursor,
+	struct wlr_surface *surface, int32_t dx, int32_t dy);
 bool wlr_output_cursor_move(struct wlr_output_cursor *cursor,
 	double x, double y);
 void wlr_output_cursor_destroy(struct wlr_output_cursor *cursor);
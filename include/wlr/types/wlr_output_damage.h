@@ -13,13 +13,16 @@
 #include <time.h>
 #include <wlr/types/wlr_box.h>
 #include <wlr/types/wlr_output.h>
+#include <wlr/util/damage_rects.h>
 
 /**
- * Damage tracking requires to keep track of previous frames' damage. To allow
- * damage tracking to work with triple buffering, a history of two frames is
- * required.
+ * Damage tracking requires to keep track of previous frames' damage. The
+ * history must be one frame shorter than the backend's swapchain depth, so
+ * that any buffer age the swapchain reports can be resolved against recorded
+ * damage instead of repainting everything. This is the initial length; the
+ * history grows to match the buffer ages the backend actually reports.
  */
-#define WLR_OUTPUT_DAMAGE_PREVIOUS_LEN 2
+#define WLR_OUTPUT_DAMAGE_PREVIOUS_LEN 3
 
 /**
  * Tracks damage for an output.
@@ -34,16 +37,34 @@
  */
 struct wlr_output_damage {
 	struct wlr_output *output;
-	int max_rects; // max number of damaged rectangles
+	// Budget of damaged rectangles: larger regions are merged toward their
+	// bounding boxes when that is estimated to be cheaper to repaint
+	int max_rects;
 
 	pixman_region32_t current; // in output-local coordinates
 
+	// Damage submissions land here first and are only folded into `current`
+	// when a consumer needs the pixman region, so each submission costs a
+	// bounded rectangle merge instead of a pixman union
+	struct wlr_damage_rects pending;
+
 	// circular queue for previous damage
-	pixman_region32_t previous[WLR_OUTPUT_DAMAGE_PREVIOUS_LEN];
+	pixman_region32_t *previous;
+	size_t previous_len;
 	size_t previous_idx;
 
 	enum wlr_output_state_buffer_type pending_buffer_type;
 
+	// When set, a tint over the current frame's damage and fading tints over
+	// previous frames' damage are drawn on top of each submitted frame. See
+	// wlr_output_damage_set_debug_overlay.
+	bool debug_overlay;
+
+	// Mirroring, see wlr_output_damage_set_mirror
+	struct wlr_output_damage *mirror_source; // NULL when independent
+	struct wl_list mirrors; // trackers mirroring this one, mirror_link
+	struct wl_list mirror_link;
+
 	struct {
 		struct wl_signal frame;
 		struct wl_signal destroy;
@@ -89,5 +110,27 @@ void wlr_output_damage_add_whole(struct wlr_output_damage *output_damage);
  */
 void wlr_output_damage_add_box(struct wlr_output_damage *output_damage,
 	struct wlr_box *box);
+/**
+ * Toggles the damage visualization overlay at runtime. While enabled, each
+ * frame rendered through the output's renderer gets the current damage region
+ * tinted red and the previous frames' regions tinted yellow, fading with age,
+ * drawn after normal composition — handy for spotting over-damage and
+ * full-frame repaints. The overlay defaults to enabled when the
+ * WLR_DEBUG_DAMAGE_OVERLAY environment variable is set to 1.
+ */
+void wlr_output_damage_set_debug_overlay(struct wlr_output_damage *output_damage,
+	bool enabled);
+/**
+ * Makes this damage tracker mirror `source`: damage submitted to the source
+ * is forwarded here as well, scaled into this output's resolution when the
+ * two differ, and a frame is scheduled on this output whenever the source
+ * changes. One damage computation then drives both outputs, and the mirror
+ * only repaints what the source actually changed — typically a single blit
+ * of the source's frame. Passing NULL stops mirroring.
+ *
+ * Returns false if the link would create a cycle.
+ */
+bool wlr_output_damage_set_mirror(struct wlr_output_damage *output_damage,
+	struct wlr_output_damage *source);
 
 #endif
@@ -0,0 +1,162 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_TYPES_WLR_OUTPUT_LATENCY_H
+#define WLR_TYPES_WLR_OUTPUT_LATENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <wayland-server-core.h>
+#include <wlr/types/wlr_output.h>
+
+/**
+ * The measured pipeline stages. INPUT_TO_PRESENT is the end-to-end
+ * input-to-photon latency; the other two split it at the output commit.
+ */
+enum wlr_output_latency_stage {
+	WLR_OUTPUT_LATENCY_INPUT_TO_COMMIT,
+	WLR_OUTPUT_LATENCY_COMMIT_TO_PRESENT,
+	WLR_OUTPUT_LATENCY_INPUT_TO_PRESENT,
+	WLR_OUTPUT_LATENCY_STAGE_COUNT,
+};
+
+/**
+ * Histogram buckets double in width: bucket i counts samples below
+ * WLR_OUTPUT_LATENCY_BUCKET_MIN_NSEC << i nanoseconds that didn't fit a lower
+ * bucket. The last bucket also catches everything above its bound. With a
+ * 65536ns (~66us) first bucket and 24 buckets the range tops out above
+ * 9 minutes, which is to say: never in practice.
+ */
+#define WLR_OUTPUT_LATENCY_BUCKET_MIN_NSEC 65536
+#define WLR_OUTPUT_LATENCY_BUCKETS 24
+
+struct wlr_output_latency_histogram {
+	uint64_t buckets[WLR_OUTPUT_LATENCY_BUCKETS];
+	uint64_t samples;
+	uint64_t total_nsec;
+	uint64_t max_nsec;
+};
+
+/**
+ * Tracks end-to-end frame latency for an output.
+ *
+ * The tracker hooks the output's commit and present signals by itself;
+ * compositors feed it the missing first stage by calling
+ * wlr_output_latency_mark_input when they ingest an input event that will
+ * affect the output's next frame. Samples are correlated per frame via the
+ * output's commit sequence number, so frames in flight don't get mixed up.
+ *
+ * The `regression` event fires when the recent average input-to-photon
+ * latency rises well above the long-term baseline, and re-arms once it
+ * recovers, so fleet telemetry can alert on it without polling.
+ */
+struct wlr_output_latency {
+	struct wlr_output *output;
+
+	struct wlr_output_latency_histogram
+		histograms[WLR_OUTPUT_LATENCY_STAGE_COUNT];
+
+	struct {
+		struct wl_signal regression; // wlr_output_latency_event_regression
+		struct wl_signal jank; // wlr_output_latency_event_jank
+		struct wl_signal destroy;
+	} events;
+
+	// private state
+
+	struct timespec input_time;
+	bool has_input;
+
+	// In-flight frames, keyed by the output's commit sequence number
+	struct {
+		uint32_t commit_seq;
+		struct timespec input_time;
+		struct timespec commit_time;
+		bool has_input;
+		bool valid;
+	} pending[4];
+
+	// Exponential moving averages of input-to-present latency (nsec)
+	double recent_avg;
+	double baseline_avg;
+	uint64_t avg_samples;
+	bool regressed;
+
+	// Previous presentation, for missed-deadline detection
+	struct timespec last_present;
+	uint32_t last_present_commit_seq;
+	bool has_last_present;
+
+	struct wl_listener output_commit;
+	struct wl_listener output_present;
+	struct wl_listener output_destroy;
+
+	void *data;
+};
+
+struct wlr_output_latency_event_regression {
+	struct wlr_output_latency *latency;
+	uint64_t recent_avg_nsec;
+	uint64_t baseline_avg_nsec;
+};
+
+enum wlr_output_latency_jank_class {
+	// The frame was presented shortly after its commit: the commit itself
+	// came too close to the deadline (compositor or GPU rendered late)
+	WLR_OUTPUT_LATENCY_JANK_RENDER_LATE,
+	// The commit was timely but presentation still slipped: the flip was
+	// held up below us (KMS queue depth, fence waits, modeset contention)
+	WLR_OUTPUT_LATENCY_JANK_FLIP_LATE,
+};
+
+/**
+ * Emitted via the `jank` event when two back-to-back frames are presented
+ * more than one and a half refresh periods apart. Gaps between non-adjacent
+ * commits are ignored: an idle compositor isn't janky, just idle.
+ */
+struct wlr_output_latency_event_jank {
+	struct wlr_output_latency *latency;
+	enum wlr_output_latency_jank_class jank_class;
+	// Whole refresh periods missed, at least 1
+	uint32_t missed_frames;
+	struct timespec commit_time;
+	struct timespec present_time;
+	// Interval since the previous presentation, and the refresh period
+	uint64_t interval_nsec;
+	uint64_t refresh_nsec;
+};
+
+struct wlr_output_latency *wlr_output_latency_create(struct wlr_output *output);
+void wlr_output_latency_destroy(struct wlr_output_latency *latency);
+
+/**
+ * Records the ingestion time of an input event that will influence the
+ * output's next frame. `when` may be NULL to use the current time; backends
+ * that provide event timestamps (e.g. libinput) should pass them through so
+ * queueing delays before ingestion are counted too. When several input
+ * events land before the next commit, the earliest one wins: latency is
+ * measured from the first cause the user is still waiting on.
+ */
+void wlr_output_latency_mark_input(struct wlr_output_latency *latency,
+	const struct timespec *when);
+
+/**
+ * Returns the accumulated histogram for a stage. The returned pointer is
+ * owned by the tracker and stays valid until the tracker is destroyed.
+ */
+const struct wlr_output_latency_histogram *wlr_output_latency_get_histogram(
+	struct wlr_output_latency *latency, enum wlr_output_latency_stage stage);
+
+/**
+ * Clears the histograms and the regression baseline, e.g. after telemetry
+ * has been flushed.
+ */
+void wlr_output_latency_reset(struct wlr_output_latency *latency);
+
+#endif
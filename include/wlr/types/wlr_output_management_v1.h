@@ -10,6 +10,7 @@
 #define WLR_TYPES_WLR_OUTPUT_MANAGEMENT_V1_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_output.h>
 
@@ -66,6 +67,10 @@ struct wlr_output_head_v1 {
 	struct wl_list resources; // wl_resource_get_link
 	struct wl_list mode_resources; // wl_resource_get_link
 
+	// Number of modes already advertised to clients, so updates can skip
+	// the mode-diffing scan when no mode was added
+	size_t n_modes;
+
 	struct wl_listener output_destroy;
 };
 
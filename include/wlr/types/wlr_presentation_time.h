@@ -22,6 +22,10 @@ struct wlr_presentation {
 	struct wl_list feedbacks; // wlr_presentation_feedback::link
 	clockid_t clock;
 
+	// Recycled feedback objects, to avoid an allocation on each commit
+	struct wl_list feedback_pool; // wlr_presentation_feedback::link
+	size_t feedback_pool_len;
+
 	struct {
 		struct wl_signal destroy;
 	} events;
@@ -23,6 +23,18 @@ struct wlr_primary_selection_source_impl {
 	void (*destroy)(struct wlr_primary_selection_source *source);
 };
 
+/**
+ * An immutable, reference-counted set of MIME types. A source builds its
+ * snapshot at most once, when it is first presented to a client; every
+ * offer on every seat then shares the same snapshot, so presenting a
+ * selection allocates once regardless of how many clients see it.
+ */
+struct wlr_primary_selection_mime_snapshot {
+	size_t n_refs;
+
+	struct wl_array mime_types; // char *
+};
+
 /**
  * A source is the sending side of a selection.
  */
@@ -31,6 +43,8 @@ struct wlr_primary_selection_source {
 
 	// source metadata
 	struct wl_array mime_types;
+	// Lazily built, see wlr_primary_selection_source_get_mime_snapshot()
+	struct wlr_primary_selection_mime_snapshot *mime_snapshot;
 
 	struct {
 		struct wl_signal destroy;
@@ -48,6 +62,21 @@ void wlr_primary_selection_source_send(
 	struct wlr_primary_selection_source *source, const char *mime_type,
 	int fd);
 
+/**
+ * Returns the source's MIME snapshot, building it on the first call. The
+ * returned pointer is borrowed: the source keeps its own reference until
+ * it's destroyed. Callers which need the snapshot to outlive the source
+ * must take a reference. Returns NULL on allocation failure.
+ */
+struct wlr_primary_selection_mime_snapshot *
+wlr_primary_selection_source_get_mime_snapshot(
+	struct wlr_primary_selection_source *source);
+struct wlr_primary_selection_mime_snapshot *
+wlr_primary_selection_mime_snapshot_ref(
+	struct wlr_primary_selection_mime_snapshot *snapshot);
+void wlr_primary_selection_mime_snapshot_unref(
+	struct wlr_primary_selection_mime_snapshot *snapshot);
+
 /**
  * Request setting the primary selection. If `client` is not null, then the
  * serial will be checked against the set of serials sent to the client on that
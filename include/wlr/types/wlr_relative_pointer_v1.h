@@ -32,6 +32,12 @@ struct wlr_relative_pointer_manager_v1 {
 
 	struct wl_listener display_destroy_listener;
 
+	struct wl_display *display;
+	// when enabled, motion is summed per client and sent in one event per
+	// flush instead of one event per input report
+	bool accumulate_motion;
+	struct wl_event_source *flush_idle;
+
 	void *data;
 };
 
@@ -54,6 +60,13 @@ struct wlr_relative_pointer_v1 {
 	struct wl_listener seat_destroy;
 	struct wl_listener pointer_destroy;
 
+	// motion accumulated since the last flush, when the manager batches
+	// relative motion; pending_time_usec is the latest event's timestamp
+	bool pending;
+	uint64_t pending_time_usec;
+	double pending_dx, pending_dy;
+	double pending_dx_unaccel, pending_dy_unaccel;
+
 	void *data;
 };
 
@@ -69,6 +82,24 @@ void wlr_relative_pointer_manager_v1_send_relative_motion(
 	uint64_t time_usec, double dx, double dy,
 	double dx_unaccel, double dy_unaccel);
 
+/**
+ * Enable or disable accumulation of relative motion. When enabled, deltas
+ * from individual input events are summed per client and delivered as a
+ * single relative_motion event per flush, so a high-rate mouse doesn't
+ * saturate the client socket with events the client samples once per frame
+ * anyway. Disabling flushes any pending motion.
+ */
+void wlr_relative_pointer_manager_v1_set_accumulation(
+	struct wlr_relative_pointer_manager_v1 *manager, bool enabled);
+
+/**
+ * Send out the motion accumulated since the last flush. Compositors
+ * typically call this once per output frame; if it is never called, pending
+ * motion is flushed automatically once control returns to the event loop.
+ */
+void wlr_relative_pointer_manager_v1_flush(
+	struct wlr_relative_pointer_manager_v1 *manager);
+
 /**
  * Get a relative pointer from its resource. Returns NULL if inert.
  */
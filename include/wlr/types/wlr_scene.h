@@ -0,0 +1,215 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_TYPES_WLR_SCENE_H
+#define WLR_TYPES_WLR_SCENE_H
+
+/**
+ * The scene-graph API provides a declarative way to display surfaces.
+ *
+ * The compositor creates a scene, adds sections of its interface to the tree
+ * and attaches the scene to outputs. The scene-graph API then takes care of
+ * damage tracking (nodes damage the attached outputs when they change), of
+ * culling (nodes completely covered by opaque content above them are not
+ * painted at all) and of rendering the tree bottom-to-top in a single call.
+ *
+ * The scene-graph API only supports basic 2D composition operations (like the
+ * KMS API or the Wayland protocol does). For anything more complicated,
+ * compositors need to implement custom rendering logic.
+ */
+
+#include <pixman.h>
+#include <wayland-server-core.h>
+#include <wlr/types/wlr_surface.h>
+
+struct wlr_output;
+struct wlr_output_damage;
+struct wlr_buffer;
+
+enum wlr_scene_node_type {
+	WLR_SCENE_NODE_ROOT,
+	WLR_SCENE_NODE_TREE,
+	WLR_SCENE_NODE_SURFACE,
+	WLR_SCENE_NODE_RECT,
+	WLR_SCENE_NODE_BUFFER,
+};
+
+struct wlr_scene_node_state {
+	struct wl_list link; // wlr_scene_node_state.children
+
+	// Ordered from bottommost to topmost
+	struct wl_list children;
+
+	bool enabled;
+	int x, y; // relative to parent
+};
+
+/** A node is an object in the scene. */
+struct wlr_scene_node {
+	enum wlr_scene_node_type type;
+	struct wlr_scene_node *parent;
+	struct wlr_scene_node_state state;
+
+	struct {
+		struct wl_signal destroy;
+	} events;
+
+	void *data;
+};
+
+/** The root scene-graph node. */
+struct wlr_scene {
+	struct wlr_scene_node node;
+
+	struct wl_list attached_damage; // wlr_scene_attached_damage.link
+};
+
+/** A sub-tree in the scene-graph, only used for grouping other nodes. */
+struct wlr_scene_tree {
+	struct wlr_scene_node node;
+};
+
+/** A scene-graph node displaying a single surface. */
+struct wlr_scene_surface {
+	struct wlr_scene_node node;
+	struct wlr_surface *surface;
+
+	// private state
+
+	struct wl_listener surface_destroy;
+	struct wl_listener surface_commit;
+};
+
+/** A scene-graph node displaying a solid-colored rectangle */
+struct wlr_scene_rect {
+	struct wlr_scene_node node;
+	int width, height;
+	float color[4];
+};
+
+/** A scene-graph node displaying a buffer */
+struct wlr_scene_buffer {
+	struct wlr_scene_node node;
+	struct wlr_buffer *buffer; // locked while the node is alive
+
+	// private state
+
+	struct wlr_texture *texture;
+};
+
+/**
+ * Immediately destroy the scene-graph node.
+ */
+void wlr_scene_node_destroy(struct wlr_scene_node *node);
+/**
+ * Enable or disable this node. If a node is disabled, all of its children are
+ * implicitly disabled as well.
+ */
+void wlr_scene_node_set_enabled(struct wlr_scene_node *node, bool enabled);
+/**
+ * Set the position of the node relative to its parent.
+ */
+void wlr_scene_node_set_position(struct wlr_scene_node *node, int x, int y);
+/**
+ * Move the node right above the specified sibling.
+ */
+void wlr_scene_node_place_above(struct wlr_scene_node *node,
+	struct wlr_scene_node *sibling);
+/**
+ * Move the node right below the specified sibling.
+ */
+void wlr_scene_node_place_below(struct wlr_scene_node *node,
+	struct wlr_scene_node *sibling);
+/**
+ * Move the node above all of its sibling nodes.
+ */
+void wlr_scene_node_raise_to_top(struct wlr_scene_node *node);
+/**
+ * Move the node below all of its sibling nodes.
+ */
+void wlr_scene_node_lower_to_bottom(struct wlr_scene_node *node);
+/**
+ * Move this node to another location in the tree.
+ */
+void wlr_scene_node_reparent(struct wlr_scene_node *node,
+	struct wlr_scene_node *new_parent);
+/**
+ * Get the node's layout-local coordinates.
+ */
+void wlr_scene_node_coords(struct wlr_scene_node *node, int *lx, int *ly);
+/**
+ * Find the topmost node in this scene-graph that contains the point at the
+ * given layout-local coordinates. (For surface nodes, this means accepting
+ * input events at that point.) Returns the node and coordinates relative to
+ * the returned node, or NULL if no node is found at that location.
+ */
+struct wlr_scene_node *wlr_scene_node_at(struct wlr_scene_node *node,
+	double lx, double ly, double *nx, double *ny);
+
+/**
+ * Create a new scene-graph.
+ */
+struct wlr_scene *wlr_scene_create(void);
+/**
+ * Manually render the scene-graph on an output. The compositor needs to call
+ * wlr_renderer_begin before and wlr_renderer_end after calling this function.
+ * Damage is in output-buffer-local coordinates and can be set to NULL to
+ * render the whole output.
+ */
+void wlr_scene_render_output(struct wlr_scene *scene, struct wlr_output *output,
+	int lx, int ly, pixman_region32_t *damage);
+/**
+ * Attach an output damage to the scene. Changes in the scene-graph will be
+ * accumulated in the output damage automatically: the compositor only needs
+ * to call wlr_output_damage_attach_render and render the damaged region.
+ *
+ * The output must be positioned at the scene-graph's origin.
+ */
+void wlr_scene_attach_output_damage(struct wlr_scene *scene,
+	struct wlr_output_damage *output_damage);
+
+/**
+ * Add a node displaying nothing, only serving as a container.
+ */
+struct wlr_scene_tree *wlr_scene_tree_create(struct wlr_scene_node *parent);
+/**
+ * Add a node displaying a single surface to the scene-graph.
+ *
+ * The child sub-surfaces are ignored. The node will be destroyed when the
+ * surface is destroyed.
+ */
+struct wlr_scene_surface *wlr_scene_surface_create(struct wlr_scene_node *parent,
+	struct wlr_surface *surface);
+/**
+ * If this node represents a wlr_scene_surface, that structure will be returned.
+ * It is not legal to feed any other node type to this function.
+ */
+struct wlr_scene_surface *wlr_scene_surface_from_node(
+	struct wlr_scene_node *node);
+/**
+ * Add a node displaying a solid-colored rectangle to the scene-graph.
+ */
+struct wlr_scene_rect *wlr_scene_rect_create(struct wlr_scene_node *parent,
+	int width, int height, const float color[static 4]);
+/**
+ * Change the width and height of an existing rectangle node.
+ */
+void wlr_scene_rect_set_size(struct wlr_scene_rect *rect, int width, int height);
+/**
+ * Change the color of an existing rectangle node.
+ */
+void wlr_scene_rect_set_color(struct wlr_scene_rect *rect,
+	const float color[static 4]);
+/**
+ * Add a node displaying a buffer to the scene-graph. The buffer is locked
+ * until the node is destroyed.
+ */
+struct wlr_scene_buffer *wlr_scene_buffer_create(struct wlr_scene_node *parent,
+	struct wlr_buffer *buffer);
+
+#endif
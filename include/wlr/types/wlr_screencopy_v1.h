@@ -13,10 +13,19 @@
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_box.h>
 
+struct wlr_output_capture_consumer;
+
 struct wlr_screencopy_manager_v1 {
 	struct wl_global *global;
 	struct wl_list frames; // wlr_screencopy_frame_v1::link
 
+	// Maximum number of copies delivered per second to each capture client,
+	// or 0 (the default) to allow a copy per frame
+	uint32_t max_capture_fps;
+
+	struct wl_list pending_reads; // screencopy_async_read::link
+	struct wl_event_source *poll_timer;
+
 	struct wl_listener display_destroy;
 
 	struct {
@@ -30,6 +39,11 @@ struct wlr_screencopy_v1_client {
 	int ref;
 	struct wlr_screencopy_manager_v1 *manager;
 	struct wl_list damages;
+
+	// Pending copies and their staging bytes, for the per-client
+	// backpressure budget enforced in frame_handle_copy
+	size_t inflight_frames;
+	size_t inflight_bytes;
 };
 
 struct wlr_screencopy_frame_v1 {
@@ -49,14 +63,21 @@ struct wlr_screencopy_frame_v1 {
 	struct wl_shm_buffer *shm_buffer;
 	struct wlr_dmabuf_v1_buffer *dma_buffer;
 
+	struct screencopy_async_read *async_read; // NULL if no read in flight
+
 	struct wl_listener buffer_destroy;
 
 	struct wlr_output *output;
-	struct wl_listener output_precommit;
-	struct wl_listener output_commit;
+	struct wlr_output_capture_consumer *consumer; // NULL until copy is requested
 	struct wl_listener output_destroy;
 	struct wl_listener output_enable;
 
+	// Set while the frame counts against its client's in-flight budget;
+	// inflight_bytes is the staging memory the copy will need (zero for
+	// GPU-to-GPU DMA-BUF copies)
+	bool inflight;
+	size_t inflight_bytes;
+
 	void *data;
 };
 
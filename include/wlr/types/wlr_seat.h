@@ -52,6 +52,9 @@ struct wlr_seat_client {
 	// set of serials which were sent to the client on this seat
 	// for use by wlr_seat_client_{next_serial,validate_event_serial}
 	struct wlr_serial_ringset serials;
+
+	// whether the client has unframed touch events pending
+	bool needs_touch_frame;
 };
 
 struct wlr_touch_point {
@@ -168,6 +171,14 @@ struct wlr_seat_pointer_state {
 	uint32_t grab_serial;
 	uint32_t grab_time;
 
+	// motion deferred until the end of the dispatch cycle, so a burst of
+	// motion events reaches the client as one motion followed by one frame
+	bool motion_pending;
+	uint32_t motion_time;
+	double pending_sx, pending_sy;
+	bool frame_pending;
+	struct wl_event_source *frame_idle;
+
 	struct wl_listener surface_destroy;
 
 	struct {
@@ -192,6 +203,12 @@ struct wlr_seat_keyboard_state {
 	struct wlr_seat_keyboard_grab *grab;
 	struct wlr_seat_keyboard_grab *default_grab;
 
+	// Seat-side key repeat (wlr_seat_keyboard_set_repeat): one timer shared
+	// by all keyboards on the seat
+	bool repeat_enabled;
+	struct wl_event_source *repeat_timer;
+	uint32_t repeat_key;
+
 	struct {
 		struct wl_signal focus_change; // wlr_seat_keyboard_focus_change_event
 	} events;
@@ -206,6 +223,9 @@ struct wlr_seat_touch_state {
 
 	struct wlr_seat_touch_grab *grab;
 	struct wlr_seat_touch_grab *default_grab;
+
+	// flushes pending wl_touch.frame events at the end of the dispatch cycle
+	struct wl_event_source *frame_idle;
 };
 
 struct wlr_primary_selection_source;
@@ -515,6 +535,16 @@ void wlr_seat_keyboard_clear_focus(struct wlr_seat *wlr_seat);
 void wlr_seat_keyboard_notify_key(struct wlr_seat *seat, uint32_t time_msec,
 		uint32_t key, uint32_t state);
 
+/**
+ * Enable or disable seat-side key repeat. When enabled, the seat re-emits the
+ * most recently pressed repeating key through the current keyboard grab, using
+ * the active keyboard's repeat_info and a single timer shared by all keyboards
+ * on the seat. Note that regular clients implement their own repeat from
+ * wl_keyboard.repeat_info; seat-side repeat is meant for consumers that
+ * can't, such as compositor keybindings and grabs.
+ */
+void wlr_seat_keyboard_set_repeat(struct wlr_seat *seat, bool enabled);
+
 /**
  * Notify the seat that the modifiers for the keyboard have changed. Defers to
  * any keyboard grabs.
@@ -631,6 +661,16 @@ void wlr_seat_touch_notify_up(struct wlr_seat *seat, uint32_t time_msec,
 void wlr_seat_touch_notify_motion(struct wlr_seat *seat, uint32_t time_msec,
 		int32_t touch_id, double sx, double sy);
 
+/**
+ * Notify the seat that a batch of touch events ends here, flushing the pending
+ * wl_touch.frame events. Touch down, up and motion events sent since the last
+ * frame are delivered to each client with a single frame, so a multi-finger
+ * update costs one client wakeup instead of one per finger. Calling this is
+ * optional: pending frames are flushed automatically once the compositor
+ * returns to the event loop.
+ */
+void wlr_seat_touch_notify_frame(struct wlr_seat *seat);
+
 /**
  * How many touch points are currently down for the seat.
  */
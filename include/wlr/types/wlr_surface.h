@@ -58,6 +58,14 @@ struct wlr_surface_state {
 		int dst_width, dst_height; // in surface-local coordinates
 	} viewport;
 
+	/**
+	 * Derived buffer source box, in buffer-local coordinates. Kept up to
+	 * date when the state is committed, so render paths can consume it
+	 * without re-deriving it from the viewport each frame. This is what
+	 * wlr_surface_get_buffer_source_box returns.
+	 */
+	struct wlr_fbox buffer_src_box;
+
 	struct wl_listener buffer_destroy;
 };
 
@@ -135,8 +143,36 @@ struct wlr_surface {
 	// wlr_subsurface::parent_pending_link
 	struct wl_list subsurface_pending_list;
 
+	/**
+	 * Flattened, z-ordered snapshot of the subsurface tree used by
+	 * wlr_surface_for_each_surface. Rebuilt lazily when subsurfaces are
+	 * added, removed, moved or reordered.
+	 */
+	struct wl_array iter_cache; // private
+	struct wlr_box iter_extent; // bounding box of the subsurface tree
+	bool iter_cache_valid;
+	/**
+	 * Bumped whenever the subsurface tree or the extents change. Derived
+	 * caches (e.g. the xdg-surface effective geometry) key their validity
+	 * to it instead of recomputing per query.
+	 */
+	uint32_t iter_generation;
+
+	/**
+	 * Whether the surface is fully covered by opaque content above it, see
+	 * wlr_surface_set_occluded. While occluded, committed buffers are not
+	 * uploaded to textures; compositors will usually also stop sending
+	 * frame-done events to throttle the client.
+	 */
+	bool occluded;
+	// A buffer was committed while occluded and its upload was deferred
+	bool texture_upload_pending;
+
 	struct wl_list current_outputs; // wlr_surface_output::link
 
+	// Membership in a pending wlr_surface_transaction, if any (private)
+	struct wlr_surface_transaction_entry *transaction_entry;
+
 	struct wl_listener renderer_destroy;
 
 	void *data;
@@ -175,6 +211,45 @@ struct wlr_subsurface {
 	void *data;
 };
 
+/**
+ * Groups the state application of several surfaces, so that they all change
+ * in the same frame. While a surface is part of a pending transaction its
+ * commits are cached instead of applied; once every member has committed (or
+ * been destroyed), all cached states are applied back-to-back and the `ready`
+ * signal is emitted. The compositor then renders a single frame with the new
+ * geometry of every member, and each member's accumulated damage is processed
+ * once — several commits latched on the same surface merge into one
+ * application.
+ *
+ * This is intended for tiling layouts, where a layout change resizes several
+ * toplevels at once: add the affected surfaces, send the configures, and
+ * relayout from the `ready` handler.
+ *
+ * A transaction is one-shot: after `ready` it holds no surfaces anymore and
+ * must be destroyed by the caller. Destroying a pending transaction cancels
+ * the wait — states cached so far are applied immediately. Enforcing a
+ * timeout on unresponsive clients is the caller's responsibility.
+ */
+struct wlr_surface_transaction {
+	struct wl_list surfaces; // wlr_surface_transaction_entry.link
+	size_t n_waiting; // members that have not committed yet
+
+	struct {
+		struct wl_signal ready;
+	} events;
+};
+
+struct wlr_surface_transaction *wlr_surface_transaction_create(void);
+/**
+ * Adds a surface to the transaction. A surface can be part of at most one
+ * transaction at a time; returns false if it already is, or on allocation
+ * failure.
+ */
+bool wlr_surface_transaction_add(struct wlr_surface_transaction *transaction,
+	struct wlr_surface *surface);
+void wlr_surface_transaction_destroy(
+	struct wlr_surface_transaction *transaction);
+
 typedef void (*wlr_surface_iterator_func_t)(struct wlr_surface *surface,
 	int sx, int sy, void *data);
 
@@ -249,6 +324,28 @@ void wlr_surface_send_leave(struct wlr_surface *surface,
 void wlr_surface_send_frame_done(struct wlr_surface *surface,
 		const struct timespec *when);
 
+/**
+ * Like wlr_surface_send_frame_done, but the callbacks are only queued:
+ * wlr_surface_flush_frame_done sends them all in one tight batch with a
+ * single flush per client. Queue every surface visible on an output and
+ * flush right after the output commit, so clients wake together and get
+ * the full frame as their render window instead of being woken scattered
+ * across it.
+ */
+void wlr_surface_queue_frame_done(struct wlr_surface *surface,
+		const struct timespec *when);
+void wlr_surface_flush_frame_done(struct wl_display *display);
+
+/**
+ * Marks the surface and its subsurface tree as fully occluded, or visible
+ * again. While a surface is occluded, buffers committed to it are not
+ * uploaded to its texture; the deferred upload happens when the surface
+ * becomes visible again. Compositors usually compute this from the stacking
+ * order with wlr_occlusion_add_surface_tree, and check the `occluded` field
+ * to throttle frame-done events for hidden clients.
+ */
+void wlr_surface_set_occluded(struct wlr_surface *surface, bool occluded);
+
 /**
  * Get the bounding box that contains the surface and all subsurfaces in
  * surface coordinates.
@@ -59,6 +59,9 @@ struct wlr_text_input_v3 {
 
 	struct wl_list link;
 
+	// Pending batched done, see wlr_text_input_v3_schedule_done
+	struct wl_event_source *done_idle;
+
 	struct wl_listener surface_destroy;
 	struct wl_listener seat_destroy;
 
@@ -99,4 +102,12 @@ void wlr_text_input_v3_send_delete_surrounding_text(
 	uint32_t after_length);
 void wlr_text_input_v3_send_done(struct wlr_text_input_v3 *text_input);
 
+/**
+ * Schedules a single done for the current event-loop iteration. Use this
+ * instead of wlr_text_input_v3_send_done when forwarding input-method
+ * state: all preedit/commit/delete updates belonging to one keystroke then
+ * reach the client under one done instead of one per update.
+ */
+void wlr_text_input_v3_schedule_done(struct wlr_text_input_v3 *text_input);
+
 #endif
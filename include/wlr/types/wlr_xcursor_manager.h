@@ -14,7 +14,8 @@
 #include <wlr/xcursor.h>
 
 /**
- * An XCursor theme at a particular scale factor of the base size.
+ * An XCursor theme at a particular scale factor of the base size. Scales
+ * whose decoded images turn out identical share one wlr_xcursor_theme.
  */
 struct wlr_xcursor_manager_theme {
 	float scale;
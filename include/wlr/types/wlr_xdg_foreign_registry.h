@@ -13,6 +13,8 @@
 
 #define WLR_XDG_FOREIGN_HANDLE_SIZE 37
 
+struct wlr_map;
+
 /**
  * wlr_xdg_foreign_registry is used for storing a list of exported surfaces with
  * the xdg-foreign family of protocols.
@@ -22,6 +24,8 @@
  */
 struct wlr_xdg_foreign_registry {
 	struct wl_list exported_surfaces; // struct wlr_xdg_foreign_exported_surface
+	// Index over exported_surfaces, keyed by a hash of the handle string
+	struct wlr_map *exported_by_handle;
 
 	struct wl_listener display_destroy;
 	struct {
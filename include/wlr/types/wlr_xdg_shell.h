@@ -77,6 +77,20 @@ struct wlr_xdg_popup {
 
 	struct wlr_xdg_positioner positioner;
 
+	// Cached result of the last wlr_xdg_popup_unconstrain_from_box solve.
+	// Menu-heavy clients reposition popups every frame, usually with
+	// identical inputs; when the positioner, constraint box and parent
+	// placement are unchanged the solved geometry is reused directly.
+	struct {
+		bool valid;
+		struct wlr_xdg_positioner input_positioner;
+		struct wlr_box input_geometry;
+		struct wlr_box constraint_box;
+		int parent_sx, parent_sy;
+		struct wlr_xdg_positioner solved_positioner;
+		struct wlr_box solved_geometry;
+	} unconstrain_cache;
+
 	struct wl_list grab_link; // wlr_xdg_popup_grab::popups
 };
 
@@ -128,6 +142,16 @@ struct wlr_xdg_toplevel {
 	char *title;
 	char *app_id;
 
+	// Interactive-resize configure throttling, see
+	// wlr_xdg_toplevel_set_size_throttle
+	struct {
+		bool enabled;
+		int interval_msec;
+		struct wl_event_source *timer;
+		bool armed; // a configure went out within the current interval
+		bool size_pending; // a newer size arrived while armed
+	} resize_throttle;
+
 	struct {
 		struct wl_signal request_maximize;
 		struct wl_signal request_fullscreen;
@@ -183,6 +207,11 @@ struct wlr_xdg_surface {
 	struct wlr_box next_geometry;
 	struct wlr_box geometry;
 
+	// Cached effective geometry, see wlr_xdg_surface_get_geometry
+	struct wlr_box cached_geometry;
+	uint32_t cached_geometry_generation;
+	bool cached_geometry_valid;
+
 	struct wl_listener surface_destroy;
 	struct wl_listener surface_commit;
 
@@ -263,11 +292,25 @@ void wlr_xdg_surface_ping(struct wlr_xdg_surface *surface);
 
 /**
  * Request that this toplevel surface be the given size. Returns the associated
- * configure serial.
+ * configure serial, or zero if the configure was deferred by size throttling
+ * (see wlr_xdg_toplevel_set_size_throttle).
  */
 uint32_t wlr_xdg_toplevel_set_size(struct wlr_xdg_surface *surface,
 		uint32_t width, uint32_t height);
 
+/**
+ * Enables configure throttling for interactive resize. While enabled,
+ * wlr_xdg_toplevel_set_size emits at most one configure per interval
+ * (typically the output's refresh interval), always carrying the latest
+ * requested size, instead of one per pointer motion. A deferred size is
+ * also flushed as soon as the client acks the previous configure, so
+ * clients that keep up resize ack-paced rather than timer-paced; acks can
+ * be observed via wlr_xdg_surface.events.ack_configure. An interval of
+ * zero disables throttling and flushes any deferred size.
+ */
+void wlr_xdg_toplevel_set_size_throttle(struct wlr_xdg_surface *surface,
+		int interval_msec);
+
 /**
  * Request that this toplevel surface show itself in an activated or deactivated
  * state. Returns the associated configure serial.
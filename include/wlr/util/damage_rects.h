@@ -0,0 +1,61 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_UTIL_DAMAGE_RECTS_H
+#define WLR_UTIL_DAMAGE_RECTS_H
+
+#include <pixman.h>
+#include <stdbool.h>
+
+/**
+ * Maximum number of rectangles a wlr_damage_rects holds before it starts
+ * merging on overflow.
+ */
+#define WLR_DAMAGE_RECTS_CAP 16
+
+/**
+ * A bounded set of damage rectangles, specialized for accumulating damage.
+ *
+ * pixman regions keep a normalized y-band representation which allocates and
+ * re-bands on every union — measurably expensive when clients submit damage
+ * many times per frame. This type instead stores up to WLR_DAMAGE_RECTS_CAP
+ * possibly-overlapping rectangles inline, merging a new rectangle into an
+ * existing one when the merged bounding box wastes little repaint area, and
+ * merging into the cheapest candidate once the budget is exceeded. No memory
+ * is ever allocated.
+ *
+ * The rectangles are only converted to a pixman region when a consumer needs
+ * one, so the pixman cost is paid once per frame rather than once per damage
+ * submission. A zeroed struct is an empty set.
+ */
+struct wlr_damage_rects {
+	pixman_box32_t rects[WLR_DAMAGE_RECTS_CAP];
+	int len;
+};
+
+void wlr_damage_rects_clear(struct wlr_damage_rects *rects);
+bool wlr_damage_rects_empty(const struct wlr_damage_rects *rects);
+/**
+ * Adds a rectangle, given as pixman-style bounds. Empty and inverted
+ * rectangles are ignored.
+ */
+void wlr_damage_rects_add(struct wlr_damage_rects *rects,
+	int x1, int y1, int x2, int y2);
+/**
+ * Adds all rectangles of a pixman region.
+ */
+void wlr_damage_rects_add_region(struct wlr_damage_rects *rects,
+	pixman_region32_t *region);
+/**
+ * Unions the accumulated rectangles into a pixman region, converting to the
+ * normalized band representation in a single pass.
+ */
+void wlr_damage_rects_union_into(const struct wlr_damage_rects *rects,
+	pixman_region32_t *dst);
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_UTIL_GPU_MEMORY_H
+#define WLR_UTIL_GPU_MEMORY_H
+
+#include <stdint.h>
+#include <wayland-server-core.h>
+
+/**
+ * Graphics memory accounting. wlroots tracks the sizes of the GPU-backed
+ * allocations it makes on behalf of clients and for its own compositing, so
+ * leaks can be attributed without driver debugfs spelunking.
+ *
+ * Sizes are what wlroots knows about the allocation (width * stride or an
+ * estimate from the pixel format), not what the driver actually reserved;
+ * they are meant for trend and leak analysis, not exact budgeting.
+ */
+enum wlr_gpu_memory_type {
+	// Textures uploaded from wl_shm or raw pixels
+	WLR_GPU_MEMORY_SHM_TEXTURE,
+	// Textures imported from client DMA-BUFs or wl_drm buffers
+	WLR_GPU_MEMORY_DMABUF_TEXTURE,
+	// Compositor-allocated render/scanout buffers (GBM)
+	WLR_GPU_MEMORY_GBM_BO,
+	WLR_GPU_MEMORY_TYPE_COUNT,
+};
+
+struct wlr_gpu_memory_stats {
+	uint64_t current[WLR_GPU_MEMORY_TYPE_COUNT]; // bytes currently allocated
+	uint64_t peak[WLR_GPU_MEMORY_TYPE_COUNT]; // high-water marks, in bytes
+};
+
+/**
+ * Fills `stats` with the per-type totals and high-water marks.
+ */
+void wlr_gpu_memory_get_stats(struct wlr_gpu_memory_stats *stats);
+
+/**
+ * Returns the bytes currently attributed to buffers imported from this
+ * client, or zero if none are tracked.
+ */
+uint64_t wlr_gpu_memory_client_bytes(struct wl_client *client);
+
+#endif
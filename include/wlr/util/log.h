@@ -39,6 +39,15 @@ typedef void (*wlr_log_func_t)(enum wlr_log_importance importance,
 // callback function.
 void wlr_log_init(enum wlr_log_importance verbosity, wlr_log_func_t callback);
 
+// Like wlr_log_init with the default logger, except that messages are
+// formatted on the calling thread into a fixed-size ring buffer and written to
+// stderr by a background thread, so logging never blocks the compositor on
+// terminal I/O. Messages logged while the ring is full are dropped; the number
+// of dropped messages is reported once the writer catches up. The writer
+// thread is joined and the ring flushed at exit.
+// Returns false if the writer thread could not be started.
+bool wlr_log_init_async(enum wlr_log_importance verbosity);
+
 // Returns the log verbosity provided to wlr_log_init
 enum wlr_log_importance wlr_log_get_verbosity(void);
 
@@ -39,6 +39,29 @@ void wlr_region_scale_xy(pixman_region32_t *dst, pixman_region32_t *src,
 void wlr_region_transform(pixman_region32_t *dst, pixman_region32_t *src,
 	enum wl_output_transform transform, int width, int height);
 
+/**
+ * A precompiled output transform: the coordinate mapping for a given
+ * transform and box size, reduced to an axis swap plus per-axis flips and
+ * offsets. Build it once when an output's transform or size changes and
+ * apply it to damage regions every frame, instead of re-deriving the mapping
+ * per rectangle in wlr_region_transform().
+ */
+struct wlr_region_transform_map {
+	bool swap_xy;
+	bool flip_x, flip_y;
+	int offset_x, offset_y;
+};
+
+void wlr_region_transform_map_init(struct wlr_region_transform_map *map,
+	enum wl_output_transform transform, int width, int height);
+
+/**
+ * Transforms `src` into `dst` by applying the precompiled mapping over the
+ * rectangle array in one pass. `dst` and `src` may be the same region.
+ */
+void wlr_region_transform_map_apply(const struct wlr_region_transform_map *map,
+	pixman_region32_t *dst, pixman_region32_t *src);
+
 /**
  * Expands the region of `distance`. If `distance` is negative, it shrinks the
  * region.
@@ -0,0 +1,34 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_UTIL_TRACE_H
+#define WLR_UTIL_TRACE_H
+
+#include <stdbool.h>
+
+/**
+ * In-process trace recorder. While recording, begin/end spans for surface
+ * commits, render passes, output commits and page flips are appended to
+ * per-thread ring buffers; wlr_trace_dump writes them out as Chrome
+ * trace-event JSON, loadable in chrome://tracing or Perfetto.
+ *
+ * Recording costs one branch per instrumented site when stopped and one
+ * timestamped buffer write when running. The buffers are rings: only the
+ * most recent events per thread survive until the dump.
+ */
+bool wlr_trace_start(void);
+void wlr_trace_stop(void);
+
+/**
+ * Writes the recorded events to `path` as a Chrome trace-event JSON array.
+ * Stop the recorder first; dumping while threads are still recording may
+ * produce torn events.
+ */
+bool wlr_trace_dump(const char *path);
+
+#endif
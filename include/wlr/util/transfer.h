@@ -0,0 +1,67 @@
+/*
+ * This is a stable interface of wlroots. Future changes will be limited to:
+ *
+ * - New functions
+ * - New struct members
+ * - New enum members
+ *
+ * Note that wlroots does not make an ABI compatibility promise - in the future,
+ * the layout and size of structs used by wlroots may change, requiring code
+ * depending on this header to be recompiled (but not edited).
+ *
+ * Breaking changes are announced by email and follow a 1-year deprecation
+ * schedule. Send an email to ~sircmpwn/wlroots-announce+subscribe@lists.sr.ht
+ * to receive these announcements.
+ */
+
+#ifndef WLR_UTIL_TRANSFER_H
+#define WLR_UTIL_TRANSFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <wayland-server-core.h>
+
+struct wlr_pipe_transfer;
+
+typedef void (*wlr_pipe_transfer_done_func_t)(
+	struct wlr_pipe_transfer *transfer, bool success, void *data);
+
+/**
+ * An asynchronous copy between two file descriptors, driven by the event
+ * loop. On Linux, data between two pipes is moved with splice() and never
+ * enters userspace; other fd pairs fall back to a read/write loop. Useful
+ * when the compositor mediates a selection transfer (clipboard managers,
+ * protocol bridges) instead of passing the source fd straight to the
+ * receiving client.
+ */
+struct wlr_pipe_transfer {
+	int src_fd, dst_fd;
+	struct wl_event_source *src_source;
+	struct wl_event_source *dst_source;
+
+	wlr_pipe_transfer_done_func_t done;
+	void *data;
+
+	// fallback state when splice() isn't usable for the fd pair
+	bool use_buffer;
+	bool eof;
+	char buf[4096];
+	size_t buf_start, buf_len;
+};
+
+/**
+ * Start copying everything readable from src_fd into dst_fd. The transfer
+ * takes ownership of both file descriptors and closes them before calling
+ * `done`, which also destroys the transfer. Returns NULL on failure, in
+ * which case the caller keeps both fds.
+ */
+struct wlr_pipe_transfer *wlr_pipe_transfer_start(struct wl_event_loop *loop,
+	int src_fd, int dst_fd, wlr_pipe_transfer_done_func_t done, void *data);
+
+/**
+ * Abort a transfer in flight, closing both file descriptors. The done
+ * callback is not called.
+ */
+void wlr_pipe_transfer_destroy(struct wlr_pipe_transfer *transfer);
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * This an unstable interface of wlroots. No guarantees are made regarding the
+ * future consistency of this API.
+ */
+#ifndef WLR_USE_UNSTABLE
+#error "Add -DWLR_USE_UNSTABLE to enable unstable wlroots features"
+#endif
+
+#ifndef WLR_UTIL_WATCHDOG_H
+#define WLR_UTIL_WATCHDOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <wayland-server-core.h>
+
+/**
+ * Event-loop stall watchdog. While running, every listener dispatched
+ * through the wlroots signal emitters is timed, and handlers exceeding the
+ * threshold are logged with their notify function pointer and duration
+ * (resolve the pointer with addr2line or gdb). A monitor thread
+ * additionally watches a heartbeat timer on the display's event loop and
+ * logs when the loop as a whole stops turning — including the handler that
+ * is stuck mid-dispatch at that moment — so a blocking ioctl or round trip
+ * is attributed while it is still blocking, not after the fact.
+ *
+ * The per-listener timing costs two clock reads per dispatched listener;
+ * cheap enough to leave running in production.
+ */
+bool wlr_stall_watchdog_start(struct wl_display *display,
+	int64_t threshold_msec);
+void wlr_stall_watchdog_stop(void);
+
+#endif
@@ -42,6 +42,8 @@
 #ifndef WLR_XCURSOR_H
 #define WLR_XCURSOR_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <wlr/util/edges.h>
 
@@ -54,11 +56,37 @@ struct wlr_xcursor_image {
 	uint8_t *buffer;
 };
 
+struct xcursor_cache;
+
 struct wlr_xcursor {
 	unsigned int image_count;
 	struct wlr_xcursor_image **images;
 	char *name;
 	uint32_t total_delay; /* length of the animation in ms */
+	bool cached; /* image buffers reference the theme's cache mapping */
+	/*
+	 * Precomputed timeline: ms timestamp within the animation at which each
+	 * frame ends, so frame lookup is a binary search instead of a walk.
+	 * NULL for single-frame cursors.
+	 */
+	uint32_t *frame_ends;
+};
+
+/**
+ * All animation frames of a cursor packed side by side into one ARGB8888
+ * buffer, with frames aligned on their hotspots. Upload the buffer once and
+ * move the source rectangle to x = frame * width per tick instead of
+ * uploading a texture per animation frame. Note that hardware cursor planes
+ * scan out whole buffers and can't sample a sub-rectangle; this is for
+ * composited cursor paths.
+ */
+struct wlr_xcursor_atlas {
+	uint32_t frame_count;
+	uint32_t width, height; /* one frame; the buffer is width*frame_count wide */
+	uint32_t hotspot_x, hotspot_y; /* same for every frame */
+	uint32_t total_delay; /* length of the animation in ms */
+	uint32_t *frame_ends; /* ms timestamp at which each frame ends */
+	uint8_t *buffer; /* stride is 4*width*frame_count */
 };
 
 /**
@@ -69,6 +97,11 @@ struct wlr_xcursor_theme {
 	struct wlr_xcursor **cursors;
 	char *name;
 	int size;
+
+	bool lazy; // shapes are decoded on first wlr_xcursor_theme_get_cursor
+	char **missing_names; // lookups known to fail, to skip theme rescans
+	size_t missing_count;
+	struct xcursor_cache *cache; // compiled on-disk theme cache, may be NULL
 };
 
 /**
@@ -88,12 +121,34 @@ void wlr_xcursor_theme_destroy(struct wlr_xcursor_theme *theme);
 struct wlr_xcursor *wlr_xcursor_theme_get_cursor(
 	struct wlr_xcursor_theme *theme, const char *name);
 
+/**
+ * Decodes the commonly used shapes (pointer, text, grab and the resize
+ * cursors) up front. Themes are otherwise loaded lazily, one shape on its
+ * first use; call this to avoid the first-use disk access, e.g. right after
+ * startup has settled.
+ */
+void wlr_xcursor_theme_prewarm(struct wlr_xcursor_theme *theme);
+
 /**
  * Returns the current frame number for an animated cursor give a monotonic time
  * reference.
  */
 int wlr_xcursor_frame(struct wlr_xcursor *cursor, uint32_t time);
 
+/**
+ * Packs all frames of the cursor into one atlas buffer. Returns NULL on
+ * allocation failure.
+ */
+struct wlr_xcursor_atlas *wlr_xcursor_atlas_create(struct wlr_xcursor *cursor);
+
+void wlr_xcursor_atlas_destroy(struct wlr_xcursor_atlas *atlas);
+
+/**
+ * Returns the frame to show at a monotonic time reference, like
+ * wlr_xcursor_frame.
+ */
+int wlr_xcursor_atlas_frame(struct wlr_xcursor_atlas *atlas, uint32_t time);
+
 /**
  * Get the name of the resize cursor image for the given edges.
  */
@@ -23,6 +23,7 @@ struct wlr_xwayland_server {
 	pid_t pid;
 	struct wl_client *client;
 	struct wl_event_source *pipe_source;
+	struct wl_event_source *idle_source;
 	int wm_fd[2], wl_fd[2];
 
 	time_t server_start;
@@ -34,6 +35,7 @@ struct wlr_xwayland_server {
 	int x_fd[2];
 	struct wl_event_source *x_fd_read_event[2];
 	bool lazy;
+	bool warm_standby;
 	bool enable_wm;
 
 	struct wl_display *wl_display;
@@ -51,6 +53,12 @@ struct wlr_xwayland_server {
 
 struct wlr_xwayland_server_options {
 	bool lazy;
+	/**
+	 * With lazy start, spawn Xwayland in the background once the compositor
+	 * goes idle instead of waiting for the first X11 client, so the first
+	 * launch connects to an already-running server.
+	 */
+	bool warm_standby;
 	bool enable_wm;
 };
 
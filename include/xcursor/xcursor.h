@@ -64,4 +64,7 @@ void
 xcursor_load_theme(const char *theme, int size,
 		    void (*load_callback)(XcursorImages *, void *),
 		    void *user_data);
+
+char *
+xcursor_theme_path(const char *theme);
 #endif
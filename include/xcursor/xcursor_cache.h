@@ -0,0 +1,54 @@
+#ifndef XCURSOR_XCURSOR_CACHE_H
+#define XCURSOR_XCURSOR_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct wlr_xcursor;
+struct wlr_xcursor_theme;
+
+/**
+ * A compiled cursor theme: shapes decoded at one size, serialized into a
+ * single blob that can be mapped read-only, so repeated compositor starts
+ * and nested instances share the decoded pixels through the page cache
+ * instead of re-parsing the theme. Caches are keyed by theme name and size
+ * and invalidated when the theme directory's mtime changes.
+ */
+struct xcursor_cache_entry {
+	const char *name; // not null-terminated, points into the mapping
+	uint32_t name_len;
+	uint32_t image_count;
+	const unsigned char *images; // serialized images, in the mapping
+};
+
+struct xcursor_cache {
+	void *data;
+	size_t len;
+	struct xcursor_cache_entry *entries;
+	size_t entry_count;
+};
+
+/**
+ * Maps the compiled cache for the theme at the given size read-only.
+ * Returns NULL when no cache exists, or when it is stale or malformed.
+ */
+struct xcursor_cache *xcursor_cache_open(const char *theme, int size);
+
+/**
+ * Builds a wlr_xcursor for the named shape from the cache, or returns NULL
+ * when the cache doesn't contain it. The image buffers reference the cache
+ * mapping and stay valid until xcursor_cache_close().
+ */
+struct wlr_xcursor *xcursor_cache_get(struct xcursor_cache *cache,
+	const char *name);
+
+/**
+ * Serializes the theme's decoded shapes to disk, atomically replacing any
+ * previous cache for this theme name and size.
+ */
+bool xcursor_cache_write(struct wlr_xcursor_theme *theme);
+
+void xcursor_cache_close(struct xcursor_cache *cache);
+
+#endif
@@ -4,6 +4,7 @@
 #include <xcb/xfixes.h>
 
 #define INCR_CHUNK_SIZE (64 * 1024)
+#define MAX_INCR_CHUNK_SIZE (4 * 1024 * 1024)
 
 #define XDND_VERSION 5
 
@@ -28,6 +29,7 @@ struct wlr_xwm_selection_transfer {
 	// when receiving from x11
 	int property_start;
 	xcb_get_property_reply_t *property_reply;
+	bool incr_chunk_pending;
 };
 
 struct wlr_xwm_selection {
@@ -50,6 +52,8 @@ void xwm_selection_transfer_destroy_property_reply(
 void xwm_selection_transfer_finish(struct wlr_xwm_selection_transfer *transfer);
 bool xwm_selection_transfer_get_selection_property(
 	struct wlr_xwm_selection_transfer *transfer, bool delete);
+size_t xwm_selection_incr_chunk_size(struct wlr_xwm *xwm);
+void xwm_selection_transfer_enlarge_pipe(struct wlr_xwm *xwm, int fd);
 
 xcb_atom_t xwm_mime_type_to_atom(struct wlr_xwm *xwm, char *mime_type);
 char *xwm_mime_type_from_atom(struct wlr_xwm *xwm, xcb_atom_t atom);
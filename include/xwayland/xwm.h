@@ -11,6 +11,7 @@
 #if WLR_HAS_XCB_ERRORS
 #include <xcb/xcb_errors.h>
 #endif
+#include "util/map.h"
 #include "xwayland/selection.h"
 
 /* This is in xcb/xcb_event.h, but pulling xcb-util just for a constant
@@ -114,6 +115,7 @@ struct wlr_xwm {
 
 	struct wl_list surfaces; // wlr_xwayland_surface::link
 	struct wl_list unpaired_surfaces; // wlr_xwayland_surface::unpaired_link
+	struct wlr_map surfaces_by_id; // X window ID -> wlr_xwayland_surface
 
 	struct wlr_drag *drag;
 	struct wlr_xwayland_surface *drag_focus;
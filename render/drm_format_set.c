@@ -8,7 +8,43 @@
 #include <wlr/util/log.h>
 #include "render/drm_format_set.h"
 
+/**
+ * Small cache for format-set intersections.
+ *
+ * Intersecting two format sets is quadratic in the number of modifiers and
+ * happens on the buffer allocation path (e.g. every time a plane surface is
+ * re-initialized). The result only depends on the contents of the two sets,
+ * so cache it keyed by the (set, set, format) triple. Entries are dropped
+ * whenever one of the sets involved is mutated or finished — both of which
+ * can only happen through this file.
+ */
+#define FORMAT_INTERSECT_CACHE_LEN 8
+
+struct format_intersect_cache_entry {
+	const struct wlr_drm_format_set *a, *b;
+	uint32_t format;
+	struct wlr_drm_format *result;
+};
+
+static struct format_intersect_cache_entry
+	intersect_cache[FORMAT_INTERSECT_CACHE_LEN];
+static size_t intersect_cache_idx;
+
+static void format_intersect_cache_invalidate(
+		const struct wlr_drm_format_set *set) {
+	for (size_t i = 0; i < FORMAT_INTERSECT_CACHE_LEN; ++i) {
+		struct format_intersect_cache_entry *entry = &intersect_cache[i];
+		if (entry->result != NULL && (entry->a == set || entry->b == set)) {
+			free(entry->result);
+			entry->result = NULL;
+			entry->a = entry->b = NULL;
+		}
+	}
+}
+
 void wlr_drm_format_set_finish(struct wlr_drm_format_set *set) {
+	format_intersect_cache_invalidate(set);
+
 	for (size_t i = 0; i < set->len; ++i) {
 		free(set->formats[i]);
 	}
@@ -61,6 +97,8 @@ bool wlr_drm_format_set_add(struct wlr_drm_format_set *set, uint32_t format,
 		uint64_t modifier) {
 	assert(format != DRM_FORMAT_INVALID);
 
+	format_intersect_cache_invalidate(set);
+
 	struct wlr_drm_format **ptr = format_set_get_ref(set, format);
 	if (ptr) {
 		return wlr_drm_format_add(ptr, modifier);
@@ -193,3 +231,38 @@ struct wlr_drm_format *wlr_drm_format_intersect(
 
 	return format;
 }
+
+const struct wlr_drm_format *wlr_drm_format_set_intersect_cached(
+		const struct wlr_drm_format_set *a, const struct wlr_drm_format_set *b,
+		uint32_t format) {
+	for (size_t i = 0; i < FORMAT_INTERSECT_CACHE_LEN; ++i) {
+		struct format_intersect_cache_entry *entry = &intersect_cache[i];
+		if (entry->result != NULL && entry->a == a && entry->b == b &&
+				entry->format == format) {
+			return entry->result;
+		}
+	}
+
+	const struct wlr_drm_format *fmt_a = wlr_drm_format_set_get(a, format);
+	const struct wlr_drm_format *fmt_b = wlr_drm_format_set_get(b, format);
+	if (fmt_a == NULL || fmt_b == NULL) {
+		return NULL;
+	}
+
+	struct wlr_drm_format *result = wlr_drm_format_intersect(fmt_a, fmt_b);
+	if (result == NULL) {
+		// Incompatible formats (or allocation failure) aren't cached: they
+		// only show up on error paths, which aren't hot
+		return NULL;
+	}
+
+	struct format_intersect_cache_entry *entry =
+		&intersect_cache[intersect_cache_idx];
+	intersect_cache_idx = (intersect_cache_idx + 1) % FORMAT_INTERSECT_CACHE_LEN;
+	free(entry->result);
+	entry->a = a;
+	entry->b = b;
+	entry->format = format;
+	entry->result = result;
+	return result;
+}
@@ -4,6 +4,7 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <gbm.h>
 #include <wlr/render/egl.h>
@@ -150,6 +151,147 @@ out:
 	free(formats);
 }
 
+static bool egl_device_cache_path(char *buf, size_t len) {
+	const char *cache_dir = getenv("XDG_CACHE_HOME");
+	if (cache_dir != NULL && cache_dir[0] != '\0') {
+		return (size_t)snprintf(buf, len, "%s/wlroots-egl-device",
+			cache_dir) < len;
+	}
+	const char *home = getenv("HOME");
+	if (home != NULL && home[0] != '\0') {
+		return (size_t)snprintf(buf, len, "%s/.cache/wlroots-egl-device",
+			home) < len;
+	}
+	return false;
+}
+
+/**
+ * The device cache holds the DRM node and device extension string of the
+ * last EGL device that successfully initialized a display, so repeat
+ * startups on multi-GPU machines bind the right GPU without probing (and
+ * paying driver initialization for) every enumerated device.
+ */
+static bool egl_device_cache_load(char *drm_file, size_t drm_file_len,
+		char *device_exts, size_t device_exts_len) {
+	char path[256];
+	if (!egl_device_cache_path(path, sizeof(path))) {
+		return false;
+	}
+	FILE *f = fopen(path, "r");
+	if (f == NULL) {
+		return false;
+	}
+	bool ok = fgets(drm_file, drm_file_len, f) != NULL &&
+		fgets(device_exts, device_exts_len, f) != NULL;
+	fclose(f);
+	if (!ok) {
+		return false;
+	}
+	drm_file[strcspn(drm_file, "\n")] = '\0';
+	device_exts[strcspn(device_exts, "\n")] = '\0';
+	return drm_file[0] != '\0';
+}
+
+static void egl_device_cache_store(const char *drm_file,
+		const char *device_exts) {
+	char path[256];
+	if (drm_file == NULL || device_exts == NULL ||
+			!egl_device_cache_path(path, sizeof(path))) {
+		return;
+	}
+	FILE *f = fopen(path, "w");
+	if (f == NULL) {
+		wlr_log_errno(WLR_DEBUG, "Failed to write EGL device cache %s", path);
+		return;
+	}
+	fprintf(f, "%s\n%s\n", drm_file, device_exts);
+	fclose(f);
+}
+
+static EGLDeviceEXT egl_select_device(struct wlr_egl *egl) {
+	EGLint devices_len = 0;
+	if (egl->procs.eglQueryDevicesEXT(0, NULL, &devices_len) != EGL_TRUE ||
+			devices_len < 1) {
+		wlr_log(WLR_ERROR, "Failed to enumerate EGL devices");
+		return EGL_NO_DEVICE_EXT;
+	}
+	EGLDeviceEXT *devices = calloc(devices_len, sizeof(EGLDeviceEXT));
+	if (devices == NULL) {
+		wlr_log_errno(WLR_ERROR, "Allocation failed");
+		return EGL_NO_DEVICE_EXT;
+	}
+	if (egl->procs.eglQueryDevicesEXT(devices_len, devices,
+			&devices_len) != EGL_TRUE) {
+		wlr_log(WLR_ERROR, "Failed to enumerate EGL devices");
+		free(devices);
+		return EGL_NO_DEVICE_EXT;
+	}
+
+	EGLDeviceEXT device = EGL_NO_DEVICE_EXT;
+	if (devices_len == 1) {
+		device = devices[0];
+		free(devices);
+		return device;
+	}
+
+	// Several devices: reuse the last-known-good one if it still enumerates
+	// with the same driver. Device strings can be queried without
+	// initializing a display, so a cache hit costs no probing at all.
+	char cached_file[256], cached_exts[4096];
+	if (egl_device_cache_load(cached_file, sizeof(cached_file),
+			cached_exts, sizeof(cached_exts))) {
+		for (EGLint i = 0; i < devices_len; i++) {
+			const char *exts = egl->procs.eglQueryDeviceStringEXT(devices[i],
+				EGL_EXTENSIONS);
+			if (exts == NULL || !check_egl_ext(exts, "EGL_EXT_device_drm")) {
+				continue;
+			}
+			const char *drm_file = egl->procs.eglQueryDeviceStringEXT(
+				devices[i], EGL_DRM_DEVICE_FILE_EXT);
+			if (drm_file != NULL && strcmp(drm_file, cached_file) == 0 &&
+					strcmp(exts, cached_exts) == 0) {
+				wlr_log(WLR_DEBUG, "Using cached EGL device %s", drm_file);
+				device = devices[i];
+				break;
+			}
+		}
+	}
+
+	// Cache miss or stale entry: probe the devices in enumeration order and
+	// remember the first one that can initialize a display
+	if (device == EGL_NO_DEVICE_EXT) {
+		for (EGLint i = 0; i < devices_len; i++) {
+			EGLDisplay display = egl->procs.eglGetPlatformDisplayEXT(
+				EGL_PLATFORM_DEVICE_EXT, devices[i], NULL);
+			if (display == EGL_NO_DISPLAY) {
+				continue;
+			}
+			EGLint major, minor;
+			if (eglInitialize(display, &major, &minor) == EGL_FALSE) {
+				continue;
+			}
+			eglTerminate(display);
+			device = devices[i];
+
+			const char *exts = egl->procs.eglQueryDeviceStringEXT(device,
+				EGL_EXTENSIONS);
+			const char *drm_file = NULL;
+			if (exts != NULL && check_egl_ext(exts, "EGL_EXT_device_drm")) {
+				drm_file = egl->procs.eglQueryDeviceStringEXT(device,
+					EGL_DRM_DEVICE_FILE_EXT);
+			}
+			egl_device_cache_store(drm_file, exts);
+			break;
+		}
+	}
+
+	free(devices);
+	if (device == EGL_NO_DEVICE_EXT) {
+		wlr_log(WLR_ERROR, "Failed to find a usable EGL device");
+	}
+	return device;
+}
+
 struct wlr_egl *wlr_egl_create(EGLenum platform, void *remote_display) {
 	struct wlr_egl *egl = calloc(1, sizeof(struct wlr_egl));
 	if (egl == NULL) {
@@ -193,8 +335,29 @@ struct wlr_egl *wlr_egl_create(EGLenum platform, void *remote_display) {
 		goto error;
 	}
 
+	void *native_display = remote_display;
+	if (platform == EGL_PLATFORM_DEVICE_EXT && native_display == NULL) {
+		// No device given: enumerate the EGL devices and pick one ourselves,
+		// preferring the cached last-known-good choice
+		if (!check_egl_ext(client_exts_str, "EGL_EXT_device_enumeration") ||
+				!check_egl_ext(client_exts_str, "EGL_EXT_device_query")) {
+			wlr_log(WLR_ERROR, "EGL_EXT_device_enumeration or "
+				"EGL_EXT_device_query not supported");
+			goto error;
+		}
+		load_egl_proc(&egl->procs.eglQueryDevicesEXT, "eglQueryDevicesEXT");
+		load_egl_proc(&egl->procs.eglQueryDeviceStringEXT,
+			"eglQueryDeviceStringEXT");
+
+		EGLDeviceEXT device = egl_select_device(egl);
+		if (device == EGL_NO_DEVICE_EXT) {
+			goto error;
+		}
+		native_display = device;
+	}
+
 	egl->display = egl->procs.eglGetPlatformDisplayEXT(platform,
-		remote_display, NULL);
+		native_display, NULL);
 	if (egl->display == EGL_NO_DISPLAY) {
 		wlr_log(WLR_ERROR, "Failed to create EGL display");
 		goto error;
@@ -247,6 +410,21 @@ struct wlr_egl *wlr_egl_create(EGLenum platform, void *remote_display) {
 			"eglQueryWaylandBufferWL");
 	}
 
+	if (check_egl_ext(display_exts_str, "EGL_KHR_fence_sync")) {
+		egl->exts.fence_sync_khr = true;
+		load_egl_proc(&egl->procs.eglCreateSyncKHR, "eglCreateSyncKHR");
+		load_egl_proc(&egl->procs.eglDestroySyncKHR, "eglDestroySyncKHR");
+		load_egl_proc(&egl->procs.eglClientWaitSyncKHR,
+			"eglClientWaitSyncKHR");
+	}
+
+	if (egl->exts.fence_sync_khr &&
+			check_egl_ext(display_exts_str, "EGL_ANDROID_native_fence_sync")) {
+		egl->exts.native_fence_sync_android = true;
+		load_egl_proc(&egl->procs.eglDupNativeFenceFDANDROID,
+			"eglDupNativeFenceFDANDROID");
+	}
+
 	const char *device_exts_str = NULL;
 	if (check_egl_ext(client_exts_str, "EGL_EXT_device_query")) {
 		load_egl_proc(&egl->procs.eglQueryDisplayAttribEXT,
@@ -338,6 +516,7 @@ struct wlr_egl *wlr_egl_create(EGLenum platform, void *remote_display) {
 		if (priority != EGL_CONTEXT_PRIORITY_HIGH_IMG) {
 			wlr_log(WLR_INFO, "Failed to obtain a high priority context");
 		} else {
+			egl->has_high_priority = true;
 			wlr_log(WLR_DEBUG, "Obtained high priority context");
 		}
 	}
@@ -367,6 +546,9 @@ void wlr_egl_destroy(struct wlr_egl *egl) {
 		egl->procs.eglUnbindWaylandDisplayWL(egl->display, egl->wl_display);
 	}
 
+	if (egl->upload_context != EGL_NO_CONTEXT) {
+		eglDestroyContext(egl->display, egl->upload_context);
+	}
 	eglDestroyContext(egl->display, egl->context);
 	eglTerminate(egl->display);
 	eglReleaseThread();
@@ -423,6 +605,10 @@ bool wlr_egl_is_current(struct wlr_egl *egl) {
 	return eglGetCurrentContext() == egl->context;
 }
 
+bool wlr_egl_has_high_priority(struct wlr_egl *egl) {
+	return egl->has_high_priority;
+}
+
 void wlr_egl_save_context(struct wlr_egl_context *context) {
 	context->display = eglGetCurrentDisplay();
 	context->context = eglGetCurrentContext();
@@ -431,6 +617,15 @@ void wlr_egl_save_context(struct wlr_egl_context *context) {
 }
 
 bool wlr_egl_restore_context(struct wlr_egl_context *context) {
+	// Nothing changed since the save: skip the eglMakeCurrent call, which
+	// is not free even when it's a no-op on some drivers
+	if (context->context == eglGetCurrentContext() &&
+			context->display == eglGetCurrentDisplay() &&
+			context->draw_surface == eglGetCurrentSurface(EGL_DRAW) &&
+			context->read_surface == eglGetCurrentSurface(EGL_READ)) {
+		return true;
+	}
+
 	// If the saved context is a null-context, we must use the current
 	// display instead of the saved display because eglMakeCurrent() can't
 	// handle EGL_NO_DISPLAY.
@@ -796,3 +991,97 @@ int wlr_egl_dup_drm_fd(struct wlr_egl *egl) {
 
 	return render_fd;
 }
+
+EGLSyncKHR wlr_egl_create_sync(struct wlr_egl *egl) {
+	if (!egl->exts.fence_sync_khr) {
+		return EGL_NO_SYNC_KHR;
+	}
+
+	EGLSyncKHR sync = egl->procs.eglCreateSyncKHR(egl->display,
+		EGL_SYNC_FENCE_KHR, NULL);
+	if (sync == EGL_NO_SYNC_KHR) {
+		wlr_log(WLR_ERROR, "eglCreateSyncKHR failed");
+	}
+	return sync;
+}
+
+void wlr_egl_destroy_sync(struct wlr_egl *egl, EGLSyncKHR sync) {
+	if (sync == EGL_NO_SYNC_KHR) {
+		return;
+	}
+	assert(egl->exts.fence_sync_khr);
+	egl->procs.eglDestroySyncKHR(egl->display, sync);
+}
+
+bool wlr_egl_check_sync(struct wlr_egl *egl, EGLSyncKHR sync) {
+	if (sync == EGL_NO_SYNC_KHR) {
+		return true;
+	}
+	assert(egl->exts.fence_sync_khr);
+	EGLint ret = egl->procs.eglClientWaitSyncKHR(egl->display, sync, 0, 0);
+	return ret == EGL_CONDITION_SATISFIED_KHR;
+}
+
+EGLSyncKHR wlr_egl_create_native_sync(struct wlr_egl *egl) {
+	if (!egl->exts.native_fence_sync_android) {
+		return EGL_NO_SYNC_KHR;
+	}
+
+	EGLSyncKHR sync = egl->procs.eglCreateSyncKHR(egl->display,
+		EGL_SYNC_NATIVE_FENCE_ANDROID, NULL);
+	if (sync == EGL_NO_SYNC_KHR) {
+		wlr_log(WLR_ERROR, "eglCreateSyncKHR failed");
+	}
+	return sync;
+}
+
+int wlr_egl_dup_fence_fd(struct wlr_egl *egl, EGLSyncKHR sync) {
+	if (sync == EGL_NO_SYNC_KHR) {
+		return -1;
+	}
+	assert(egl->exts.native_fence_sync_android);
+
+	int fd = egl->procs.eglDupNativeFenceFDANDROID(egl->display, sync);
+	if (fd == EGL_NO_NATIVE_FENCE_FD_ANDROID) {
+		wlr_log(WLR_ERROR, "eglDupNativeFenceFDANDROID failed");
+		return -1;
+	}
+	return fd;
+}
+
+bool wlr_egl_create_upload_context(struct wlr_egl *egl) {
+	if (egl->upload_context != EGL_NO_CONTEXT) {
+		return true;
+	}
+
+	EGLint attribs[] = {
+		EGL_CONTEXT_CLIENT_VERSION, 2,
+		EGL_NONE,
+	};
+	egl->upload_context = eglCreateContext(egl->display, EGL_NO_CONFIG_KHR,
+		egl->context, attribs);
+	if (egl->upload_context == EGL_NO_CONTEXT) {
+		wlr_log(WLR_ERROR, "Failed to create shared EGL upload context");
+		return false;
+	}
+	return true;
+}
+
+bool wlr_egl_make_upload_current(struct wlr_egl *egl) {
+	assert(egl->upload_context != EGL_NO_CONTEXT);
+	if (!eglMakeCurrent(egl->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+			egl->upload_context)) {
+		wlr_log(WLR_ERROR, "eglMakeCurrent failed");
+		return false;
+	}
+	return true;
+}
+
+bool wlr_egl_unset_upload_current(struct wlr_egl *egl) {
+	if (!eglMakeCurrent(egl->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+			EGL_NO_CONTEXT)) {
+		wlr_log(WLR_ERROR, "eglMakeCurrent failed");
+		return false;
+	}
+	return true;
+}
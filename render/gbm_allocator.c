@@ -7,6 +7,7 @@
 #include <wlr/util/log.h>
 #include <xf86drm.h>
 #include "render/gbm_allocator.h"
+#include "util/gpu_memory.h"
 
 static const struct wlr_buffer_impl buffer_impl;
 
@@ -120,6 +121,9 @@ static struct wlr_gbm_buffer *create_buffer(struct wlr_gbm_allocator *alloc,
 		buffer->dmabuf.modifier = DRM_FORMAT_MOD_INVALID;
 	}
 
+	buffer->mem_bytes = (size_t)gbm_bo_get_stride(bo) * gbm_bo_get_height(bo);
+	gpu_memory_add(WLR_GPU_MEMORY_GBM_BO, buffer->mem_bytes);
+
 	wlr_log(WLR_DEBUG, "Allocated %dx%d GBM buffer (format 0x%"PRIX32", "
 		"modifier 0x%"PRIX64")", buffer->base.width, buffer->base.height,
 		buffer->dmabuf.format, buffer->dmabuf.modifier);
@@ -134,6 +138,7 @@ static void buffer_destroy(struct wlr_buffer *wlr_buffer) {
 	if (buffer->gbm_bo != NULL) {
 		gbm_bo_destroy(buffer->gbm_bo);
 	}
+	gpu_memory_sub(WLR_GPU_MEMORY_GBM_BO, buffer->mem_bytes);
 	wl_list_remove(&buffer->link);
 	free(buffer);
 }
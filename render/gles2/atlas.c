@@ -0,0 +1,126 @@
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <stdlib.h>
+#include <wayland-util.h>
+#include <wlr/util/log.h>
+#include "render/gles2.h"
+
+#define ATLAS_SIZE 1024
+// Padding between entries, so that linear sampling never bleeds in texels
+// from a neighbour
+#define ATLAS_PADDING 1
+
+static bool atlas_alloc(struct wlr_gles2_atlas *atlas, int width, int height,
+		int *x, int *y) {
+	if (atlas->row_x + width > atlas->size) {
+		// Open a new row
+		atlas->row_y += atlas->row_height + ATLAS_PADDING;
+		atlas->row_x = 0;
+		atlas->row_height = 0;
+	}
+	if (atlas->row_y + height > atlas->size) {
+		return false; // atlas is full
+	}
+
+	*x = atlas->row_x;
+	*y = atlas->row_y;
+
+	atlas->row_x += width + ATLAS_PADDING;
+	if (height > atlas->row_height) {
+		atlas->row_height = height;
+	}
+	return true;
+}
+
+static struct wlr_gles2_atlas *atlas_create(struct wlr_gles2_renderer *renderer,
+		const struct wlr_gles2_pixel_format *fmt) {
+	struct wlr_gles2_atlas *atlas = calloc(1, sizeof(*atlas));
+	if (atlas == NULL) {
+		wlr_log_errno(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	atlas->renderer = renderer;
+	atlas->gl_format = fmt->gl_format;
+	atlas->gl_type = fmt->gl_type;
+	atlas->size = ATLAS_SIZE;
+
+	push_gles2_debug(renderer);
+
+	glGenTextures(1, &atlas->tex);
+	glBindTexture(GL_TEXTURE_2D, atlas->tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D(GL_TEXTURE_2D, 0, fmt->gl_format, atlas->size, atlas->size,
+		0, fmt->gl_format, fmt->gl_type, NULL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	gles2_invalidate_gl_state(renderer);
+
+	pop_gles2_debug(renderer);
+
+	wl_list_insert(&renderer->atlases, &atlas->link);
+
+	wlr_log(WLR_DEBUG, "Created %dx%d texture atlas for GL format 0x%X",
+		atlas->size, atlas->size, fmt->gl_format);
+
+	return atlas;
+}
+
+bool gles2_atlas_add_texture(struct wlr_gles2_renderer *renderer,
+		struct wlr_gles2_texture *texture,
+		const struct wlr_gles2_pixel_format *fmt) {
+	int width = texture->wlr_texture.width;
+	int height = texture->wlr_texture.height;
+	if (width > WLR_GLES2_ATLAS_MAX_ENTRY ||
+			height > WLR_GLES2_ATLAS_MAX_ENTRY) {
+		return false;
+	}
+
+	int x, y;
+	struct wlr_gles2_atlas *atlas;
+	wl_list_for_each(atlas, &renderer->atlases, link) {
+		if (atlas->gl_format == fmt->gl_format &&
+				atlas->gl_type == fmt->gl_type &&
+				atlas_alloc(atlas, width, height, &x, &y)) {
+			goto found;
+		}
+	}
+
+	atlas = atlas_create(renderer, fmt);
+	if (atlas == NULL || !atlas_alloc(atlas, width, height, &x, &y)) {
+		return false;
+	}
+
+found:
+	++atlas->n_entries;
+	texture->atlas = atlas;
+	texture->atlas_x = x;
+	texture->atlas_y = y;
+	return true;
+}
+
+void gles2_atlas_remove_texture(struct wlr_gles2_texture *texture) {
+	struct wlr_gles2_atlas *atlas = texture->atlas;
+	texture->atlas = NULL;
+
+	--atlas->n_entries;
+	if (atlas->n_entries == 0) {
+		// All entries are gone: reuse the atlas from scratch
+		atlas->row_x = 0;
+		atlas->row_y = 0;
+		atlas->row_height = 0;
+	}
+}
+
+void gles2_atlas_destroy_all(struct wlr_gles2_renderer *renderer) {
+	struct wlr_gles2_atlas *atlas, *tmp;
+	wl_list_for_each_safe(atlas, tmp, &renderer->atlases, link) {
+		push_gles2_debug(renderer);
+		glDeleteTextures(1, &atlas->tex);
+		gles2_invalidate_gl_state(renderer);
+		pop_gles2_debug(renderer);
+		wl_list_remove(&atlas->link);
+		free(atlas);
+	}
+}
@@ -39,6 +39,14 @@ static const struct wlr_gles2_pixel_format formats[] = {
 		.gl_type = GL_UNSIGNED_BYTE,
 		.has_alpha = true,
 	},
+	{
+		.wl_format = WL_SHM_FORMAT_RGB565,
+		.depth = 16,
+		.bpp = 16,
+		.gl_format = GL_RGB,
+		.gl_type = GL_UNSIGNED_SHORT_5_6_5,
+		.has_alpha = false,
+	},
 };
 
 // TODO: more pixel formats
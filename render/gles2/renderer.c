@@ -1,9 +1,13 @@
 #include <assert.h>
+#include <errno.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#include <inttypes.h>
+#include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <wayland-server-protocol.h>
 #include <wayland-util.h>
@@ -24,6 +28,11 @@ static const GLfloat verts[] = {
 
 static const struct wlr_renderer_impl renderer_impl;
 
+static bool gles2_collect_shaders(struct wlr_gles2_renderer *renderer);
+static void gles2_flush_quad_batch(struct wlr_gles2_renderer *renderer);
+static GLuint load_cached_program(struct wlr_gles2_renderer *renderer,
+	const GLchar *vert_src, const GLchar *frag_src);
+
 struct wlr_gles2_renderer *gles2_get_renderer(
 		struct wlr_renderer *wlr_renderer) {
 	assert(wlr_renderer->impl == &renderer_impl);
@@ -37,13 +46,20 @@ static struct wlr_gles2_renderer *gles2_get_renderer_in_context(
 	return renderer;
 }
 
+bool gles2_make_current(struct wlr_gles2_renderer *renderer) {
+	if (renderer->context_owned && wlr_egl_is_current(renderer->egl)) {
+		return true;
+	}
+	return wlr_egl_make_current(renderer->egl);
+}
+
 static void destroy_buffer(struct wlr_gles2_buffer *buffer) {
 	wl_list_remove(&buffer->link);
 	wl_list_remove(&buffer->buffer_destroy.link);
 
 	struct wlr_egl_context prev_ctx;
 	wlr_egl_save_context(&prev_ctx);
-	wlr_egl_make_current(buffer->renderer->egl);
+	gles2_make_current(buffer->renderer);
 
 	push_gles2_debug(buffer->renderer);
 
@@ -144,7 +160,12 @@ static bool gles2_bind_buffer(struct wlr_renderer *wlr_renderer,
 	if (renderer->current_buffer != NULL) {
 		assert(wlr_egl_is_current(renderer->egl));
 
+		gles2_flush_quad_batch(renderer);
+
 		push_gles2_debug(renderer);
+		// Submit (but don't wait for) this buffer's rendering, so that the GPU
+		// works on it while the CPU records the next output's frame. Commits
+		// synchronize on the rendering through explicit fences instead.
 		glFlush();
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 		pop_gles2_debug(renderer);
@@ -154,11 +175,15 @@ static bool gles2_bind_buffer(struct wlr_renderer *wlr_renderer,
 	}
 
 	if (wlr_buffer == NULL) {
-		wlr_egl_unset_current(renderer->egl);
+		// In context-ownership mode nobody else needs the thread's EGL
+		// binding: keep the context current for the next frame
+		if (!renderer->context_owned) {
+			wlr_egl_unset_current(renderer->egl);
+		}
 		return true;
 	}
 
-	wlr_egl_make_current(renderer->egl);
+	gles2_make_current(renderer);
 
 	struct wlr_gles2_buffer *buffer = get_buffer(renderer, wlr_buffer);
 	if (buffer == NULL) {
@@ -178,6 +203,69 @@ static bool gles2_bind_buffer(struct wlr_renderer *wlr_renderer,
 	return true;
 }
 
+static void gles2_poll_timer_queries(struct wlr_gles2_renderer *renderer) {
+	for (size_t i = 0; i < sizeof(renderer->timer.queries) /
+			sizeof(renderer->timer.queries[0]); ++i) {
+		if (!renderer->timer.pending[i]) {
+			continue;
+		}
+
+		GLuint available = 0;
+		renderer->procs.glGetQueryObjectuivEXT(renderer->timer.queries[i],
+			GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+		if (!available) {
+			continue;
+		}
+
+		GLuint64 duration = 0;
+		renderer->procs.glGetQueryObjectui64vEXT(renderer->timer.queries[i],
+			GL_QUERY_RESULT_EXT, &duration);
+		renderer->timer.pending[i] = false;
+
+		GLint disjoint = 0;
+		glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+		if (!disjoint) {
+			renderer->timer.last_duration_ns = duration;
+		}
+	}
+}
+
+static void gles2_begin_timer_query(struct wlr_gles2_renderer *renderer) {
+	if (!renderer->exts.disjoint_timer_query_ext) {
+		return;
+	}
+
+	if (renderer->timer.queries[0] == 0) {
+		renderer->procs.glGenQueriesEXT(sizeof(renderer->timer.queries) /
+			sizeof(renderer->timer.queries[0]), renderer->timer.queries);
+	}
+
+	gles2_poll_timer_queries(renderer);
+
+	size_t next = renderer->timer.next;
+	if (renderer->timer.pending[next]) {
+		// The GPU is more than a full ring of frames behind: skip timing
+		// this frame rather than stalling on the oldest query
+		return;
+	}
+
+	renderer->procs.glBeginQueryEXT(GL_TIME_ELAPSED_EXT,
+		renderer->timer.queries[next]);
+	renderer->timer.active = true;
+}
+
+static void gles2_end_timer_query(struct wlr_gles2_renderer *renderer) {
+	if (!renderer->timer.active) {
+		return;
+	}
+
+	renderer->procs.glEndQueryEXT(GL_TIME_ELAPSED_EXT);
+	renderer->timer.pending[renderer->timer.next] = true;
+	renderer->timer.next = (renderer->timer.next + 1) %
+		(sizeof(renderer->timer.queries) / sizeof(renderer->timer.queries[0]));
+	renderer->timer.active = false;
+}
+
 static void gles2_begin(struct wlr_renderer *wlr_renderer, uint32_t width,
 		uint32_t height) {
 	struct wlr_gles2_renderer *renderer =
@@ -185,13 +273,26 @@ static void gles2_begin(struct wlr_renderer *wlr_renderer, uint32_t width,
 
 	push_gles2_debug(renderer);
 
+	// First render: pick up the shader programs linked at create time
+	gles2_collect_shaders(renderer);
+
+	gles2_begin_timer_query(renderer);
+
 	glViewport(0, 0, width, height);
 	renderer->viewport_width = width;
 	renderer->viewport_height = height;
 
-	// enable transparency
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	if (!renderer->context_owned) {
+		// Anything may have happened to the GL state since the last frame
+		gles2_invalidate_gl_state(renderer);
+	}
+
+	if (!renderer->context_owned || !renderer->context_state_prepared) {
+		// GL_BLEND itself is toggled per draw via gles2_set_blend, so that
+		// opaque content skips the blending cost; only the func is fixed
+		glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		renderer->context_state_prepared = true;
+	}
 
 	// XXX: maybe we should save output projection and remove some of the need
 	// for users to sling matricies themselves
@@ -200,8 +301,16 @@ static void gles2_begin(struct wlr_renderer *wlr_renderer, uint32_t width,
 }
 
 static void gles2_end(struct wlr_renderer *wlr_renderer) {
-	gles2_get_renderer_in_context(wlr_renderer);
-	// no-op
+	struct wlr_gles2_renderer *renderer =
+		gles2_get_renderer_in_context(wlr_renderer);
+
+	gles2_flush_quad_batch(renderer);
+
+	// A frame boundary is a quiet moment to retire pooled textures that no
+	// allocation has claimed for a while
+	gles2_tex_pool_age(renderer);
+
+	gles2_end_timer_query(renderer);
 }
 
 static void gles2_clear(struct wlr_renderer *wlr_renderer,
@@ -209,6 +318,8 @@ static void gles2_clear(struct wlr_renderer *wlr_renderer,
 	struct wlr_gles2_renderer *renderer =
 		gles2_get_renderer_in_context(wlr_renderer);
 
+	gles2_flush_quad_batch(renderer);
+
 	push_gles2_debug(renderer);
 	glClearColor(color[0], color[1], color[2], color[3]);
 	glClear(GL_COLOR_BUFFER_BIT);
@@ -220,6 +331,8 @@ static void gles2_scissor(struct wlr_renderer *wlr_renderer,
 	struct wlr_gles2_renderer *renderer =
 		gles2_get_renderer_in_context(wlr_renderer);
 
+	gles2_flush_quad_batch(renderer);
+
 	push_gles2_debug(renderer);
 	if (box != NULL) {
 		struct wlr_box gl_box;
@@ -235,6 +348,7 @@ static void gles2_scissor(struct wlr_renderer *wlr_renderer,
 	} else {
 		glDisable(GL_SCISSOR_TEST);
 	}
+	++renderer->stats.scissor_changes;
 	pop_gles2_debug(renderer);
 }
 
@@ -244,6 +358,244 @@ static const float flip_180[9] = {
 	0.0f, 0.0f, 1.0f,
 };
 
+#define QUAD_BATCH_VERTS 6 // two triangles per quad
+#define QUAD_BATCH_FLOATS (QUAD_BATCH_VERTS * 4) // pos + texcoord per vertex
+
+// Quads are pre-transformed on the CPU, so the batch is drawn with an
+// identity projection
+static const float identity_matrix[9] = {
+	1.0f, 0.0f, 0.0f,
+	0.0f, 1.0f, 0.0f,
+	0.0f, 0.0f, 1.0f,
+};
+
+void gles2_invalidate_gl_state(struct wlr_gles2_renderer *renderer) {
+	memset(&renderer->gl_state, 0, sizeof(renderer->gl_state));
+}
+
+static void gles2_use_program(struct wlr_gles2_renderer *renderer,
+		GLuint program) {
+	if (renderer->gl_state.program == program) {
+		return;
+	}
+	glUseProgram(program);
+	renderer->gl_state.program = program;
+	++renderer->stats.shader_switches;
+}
+
+// Binds a texture to unit 0, skipping the call when it is already bound
+static void gles2_bind_tex(struct wlr_gles2_renderer *renderer, GLenum target,
+		GLuint tex) {
+	if (tex != 0 && renderer->gl_state.tex == tex &&
+			renderer->gl_state.tex_target == target) {
+		return;
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(target, tex);
+	renderer->gl_state.tex_target = target;
+	renderer->gl_state.tex = tex;
+	++renderer->stats.texture_binds;
+}
+
+// Sets a texture's minification filter, skipping the call when the filter
+// didn't change since the renderer last set it on this texture
+static void gles2_set_min_filter(struct wlr_gles2_renderer *renderer,
+		GLenum target, GLuint tex, GLenum min_filter) {
+	if (tex != 0 && renderer->gl_state.filter_tex == tex &&
+			renderer->gl_state.min_filter == min_filter) {
+		return;
+	}
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, min_filter);
+	renderer->gl_state.filter_tex = tex;
+	renderer->gl_state.min_filter = min_filter;
+}
+
+// Enables or disables blending, skipping the call when the state is already
+// known to match. Fully opaque draws are submitted with blending disabled,
+// which saves the destination read on every covered pixel.
+static void gles2_set_blend(struct wlr_gles2_renderer *renderer, bool blend) {
+	if (renderer->gl_state.blend_known && renderer->gl_state.blend == blend) {
+		return;
+	}
+	if (blend) {
+		glEnable(GL_BLEND);
+	} else {
+		glDisable(GL_BLEND);
+	}
+	renderer->gl_state.blend_known = true;
+	renderer->gl_state.blend = blend;
+}
+
+// Bind the gamma LUT to texture unit 1 and point the shader at it. Must be
+// called with the shader's program in use; leaves GL_TEXTURE0 active.
+static void gles2_set_lut_uniforms(struct wlr_gles2_renderer *renderer,
+		GLint lut_enabled_loc, GLint lut_loc) {
+	glUniform1i(lut_enabled_loc, renderer->lut_tex != 0);
+	if (renderer->lut_tex != 0) {
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, renderer->lut_tex);
+		glUniform1i(lut_loc, 1);
+		glActiveTexture(GL_TEXTURE0);
+	}
+}
+
+static void gles2_flush_quad_batch(struct wlr_gles2_renderer *renderer) {
+	if (renderer->quad_batch.len == 0) {
+		return;
+	}
+
+	struct wlr_gles2_tex_shader *shader = renderer->quad_batch.shader;
+	size_t size = renderer->quad_batch.len * QUAD_BATCH_FLOATS * sizeof(GLfloat);
+
+	push_gles2_debug(renderer);
+
+	if (renderer->quad_batch.vbo == 0) {
+		glGenBuffers(1, &renderer->quad_batch.vbo);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, renderer->quad_batch.vbo);
+	if (size > renderer->quad_batch.vbo_size) {
+		glBufferData(GL_ARRAY_BUFFER, size, renderer->quad_batch.verts,
+			GL_STREAM_DRAW);
+		renderer->quad_batch.vbo_size = size;
+	} else {
+		// Orphan the previous store so the driver doesn't stall on quads
+		// still in flight
+		glBufferData(GL_ARRAY_BUFFER, renderer->quad_batch.vbo_size, NULL,
+			GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, renderer->quad_batch.verts);
+	}
+
+	gles2_bind_tex(renderer, renderer->quad_batch.target,
+		renderer->quad_batch.tex);
+
+	gles2_set_min_filter(renderer, renderer->quad_batch.target,
+		renderer->quad_batch.tex, renderer->quad_batch.min_filter);
+
+	gles2_use_program(renderer, shader->program);
+
+	gles2_set_blend(renderer, renderer->quad_batch.blend);
+
+	if (!shader->proj_identity) {
+		glUniformMatrix3fv(shader->proj, 1, GL_FALSE, identity_matrix);
+		shader->proj_identity = true;
+	}
+	glUniform1i(shader->invert_y, renderer->quad_batch.invert_y);
+	if (!shader->tex_unit_set) {
+		glUniform1i(shader->tex, 0);
+		shader->tex_unit_set = true;
+	}
+	glUniform1f(shader->alpha, renderer->quad_batch.alpha);
+	gles2_set_lut_uniforms(renderer, shader->lut_enabled, shader->lut);
+
+	glVertexAttribPointer(shader->pos_attrib, 2, GL_FLOAT, GL_FALSE,
+		4 * sizeof(GLfloat), 0);
+	glVertexAttribPointer(shader->tex_attrib, 2, GL_FLOAT, GL_FALSE,
+		4 * sizeof(GLfloat), (void *)(2 * sizeof(GLfloat)));
+
+	glEnableVertexAttribArray(shader->pos_attrib);
+	glEnableVertexAttribArray(shader->tex_attrib);
+
+	glDrawArrays(GL_TRIANGLES, 0, renderer->quad_batch.len * QUAD_BATCH_VERTS);
+	++renderer->stats.draw_calls;
+
+	glDisableVertexAttribArray(shader->pos_attrib);
+	glDisableVertexAttribArray(shader->tex_attrib);
+
+	// The texture stays bound on purpose: the shadowed state cache skips the
+	// re-bind if the next draw uses the same texture
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	pop_gles2_debug(renderer);
+
+	renderer->quad_batch.len = 0;
+}
+
+static bool gles2_batch_quad(struct wlr_gles2_renderer *renderer,
+		struct wlr_gles2_tex_shader *shader, GLenum target, GLuint tex,
+		GLenum min_filter, bool invert_y, const float matrix[static 9],
+		const GLfloat texcoord[static 8], float alpha, bool blend) {
+	if (renderer->quad_batch.len > 0 &&
+			(renderer->quad_batch.shader != shader ||
+			renderer->quad_batch.tex != tex ||
+			renderer->quad_batch.min_filter != min_filter ||
+			renderer->quad_batch.invert_y != invert_y ||
+			renderer->quad_batch.alpha != alpha ||
+			renderer->quad_batch.blend != blend)) {
+		gles2_flush_quad_batch(renderer);
+	}
+
+	if (renderer->quad_batch.len == renderer->quad_batch.cap) {
+		size_t cap = renderer->quad_batch.cap > 0 ?
+			renderer->quad_batch.cap * 2 : 64;
+		GLfloat *verts = realloc(renderer->quad_batch.verts,
+			cap * QUAD_BATCH_FLOATS * sizeof(GLfloat));
+		if (verts == NULL) {
+			wlr_log_errno(WLR_ERROR, "Allocation failed");
+			return false;
+		}
+		renderer->quad_batch.verts = verts;
+		renderer->quad_batch.cap = cap;
+	}
+
+	renderer->quad_batch.shader = shader;
+	renderer->quad_batch.target = target;
+	renderer->quad_batch.tex = tex;
+	renderer->quad_batch.min_filter = min_filter;
+	renderer->quad_batch.invert_y = invert_y;
+	renderer->quad_batch.alpha = alpha;
+	renderer->quad_batch.blend = blend;
+
+	// Expand the triangle strip ordering of `verts` into two triangles
+	static const int strip_to_tris[QUAD_BATCH_VERTS] = { 0, 1, 2, 1, 3, 2 };
+
+	GLfloat *out = renderer->quad_batch.verts +
+		renderer->quad_batch.len * QUAD_BATCH_FLOATS;
+	for (int i = 0; i < QUAD_BATCH_VERTS; ++i) {
+		int v = strip_to_tris[i];
+		float x = verts[v * 2], y = verts[v * 2 + 1];
+		float w = matrix[6] * x + matrix[7] * y + matrix[8];
+		*out++ = (matrix[0] * x + matrix[1] * y + matrix[2]) / w;
+		*out++ = (matrix[3] * x + matrix[4] * y + matrix[5]) / w;
+		*out++ = texcoord[v * 2];
+		*out++ = texcoord[v * 2 + 1];
+	}
+	++renderer->quad_batch.len;
+
+	return true;
+}
+
+// Pick the minification filter for a texture draw. Mipmapped textures are
+// sampled with a trilinear filter when the draw actually shrinks them (e.g.
+// on fractionally scaled outputs), which is both higher quality and cheaper
+// on memory bandwidth than minified GL_LINEAR fetches. The mip chain is
+// regenerated here if writes have dirtied it since the last minified draw.
+static GLenum gles2_texture_min_filter(struct wlr_gles2_renderer *renderer,
+		struct wlr_gles2_texture *texture, const struct wlr_fbox *box,
+		const float matrix[static 9]) {
+	if (!texture->mipmapped) {
+		return GL_LINEAR;
+	}
+
+	// Estimate the on-screen footprint of the projected unit square to
+	// figure out whether the texture is sampled below its native size
+	float dest_w = hypotf(matrix[0] * renderer->viewport_width,
+		matrix[3] * renderer->viewport_height) / 2.0f;
+	float dest_h = hypotf(matrix[1] * renderer->viewport_width,
+		matrix[4] * renderer->viewport_height) / 2.0f;
+	if (dest_w >= box->width && dest_h >= box->height) {
+		return GL_LINEAR;
+	}
+
+	if (texture->mipmaps_dirty) {
+		push_gles2_debug(renderer);
+		gles2_bind_tex(renderer, texture->target, texture->tex);
+		glGenerateMipmap(texture->target);
+		pop_gles2_debug(renderer);
+		texture->mipmaps_dirty = false;
+	}
+	return GL_LINEAR_MIPMAP_LINEAR;
+}
+
 static bool gles2_render_subtexture_with_matrix(
 		struct wlr_renderer *wlr_renderer, struct wlr_texture *wlr_texture,
 		const struct wlr_fbox *box, const float matrix[static 9],
@@ -276,6 +628,88 @@ static bool gles2_render_subtexture_with_matrix(
 		abort();
 	}
 
+	gles2_texture_sync_upload(texture);
+
+	float gl_matrix[9];
+	if (renderer->current_buffer != NULL) {
+		wlr_matrix_multiply(gl_matrix, flip_180, matrix);
+	} else {
+		memcpy(gl_matrix, matrix, sizeof(gl_matrix));
+	}
+
+	GLuint tex = texture->tex;
+	float tex_width = wlr_texture->width;
+	float tex_height = wlr_texture->height;
+	float off_x = 0, off_y = 0;
+	if (texture->atlas != NULL) {
+		// Sample the texture's slot out of the shared atlas
+		tex = texture->atlas->tex;
+		tex_width = tex_height = texture->atlas->size;
+		off_x = texture->atlas_x;
+		off_y = texture->atlas_y;
+	}
+
+	const GLfloat x1 = (off_x + box->x) / tex_width;
+	const GLfloat y1 = (off_y + box->y) / tex_height;
+	const GLfloat x2 = (off_x + box->x + box->width) / tex_width;
+	const GLfloat y2 = (off_y + box->y + box->height) / tex_height;
+	const GLfloat texcoord[] = {
+		x2, y1, // top right
+		x1, y1, // top left
+		x2, y2, // bottom right
+		x1, y2, // bottom left
+	};
+
+	GLenum min_filter = gles2_texture_min_filter(renderer, texture, box,
+		matrix);
+
+	// Opaque content doesn't need the destination read: draw it with
+	// blending disabled
+	bool blend = alpha < 1.0 || texture->has_alpha;
+
+	// Vertices are transformed on the CPU so that consecutive quads sharing
+	// a shader and texture end up in a single draw call. Textures packed
+	// into the same atlas share a GL texture, so they batch together too.
+	return gles2_batch_quad(renderer, shader, texture->target, tex,
+		min_filter, texture->inverted_y, gl_matrix, texcoord, alpha, blend);
+}
+
+static bool gles2_render_subtexture_with_matrix_damage(
+		struct wlr_renderer *wlr_renderer, struct wlr_texture *wlr_texture,
+		const struct wlr_fbox *box, const float matrix[static 9], float alpha,
+		pixman_region32_t *damage) {
+	struct wlr_gles2_renderer *renderer =
+		gles2_get_renderer_in_context(wlr_renderer);
+	struct wlr_gles2_texture *texture =
+		gles2_get_texture(wlr_texture);
+
+	struct wlr_gles2_tex_shader *shader = NULL;
+
+	switch (texture->target) {
+	case GL_TEXTURE_2D:
+		if (texture->has_alpha) {
+			shader = &renderer->shaders.tex_rgba;
+		} else {
+			shader = &renderer->shaders.tex_rgbx;
+		}
+		break;
+	case GL_TEXTURE_EXTERNAL_OES:
+		shader = &renderer->shaders.tex_ext;
+
+		if (!renderer->exts.egl_image_external_oes) {
+			wlr_log(WLR_ERROR, "Failed to render texture: "
+				"GL_TEXTURE_EXTERNAL_OES not supported");
+			return false;
+		}
+		break;
+	default:
+		abort();
+	}
+
+	gles2_texture_sync_upload(texture);
+
+	gles2_flush_quad_batch(renderer);
+
 	float gl_matrix[9];
 	if (renderer->current_buffer != NULL) {
 		wlr_matrix_multiply(gl_matrix, flip_180, matrix);
@@ -286,24 +720,44 @@ static bool gles2_render_subtexture_with_matrix(
 	// to GL_FALSE
 	wlr_matrix_transpose(gl_matrix, gl_matrix);
 
+	GLuint tex = texture->tex;
+	float tex_width = wlr_texture->width;
+	float tex_height = wlr_texture->height;
+	float off_x = 0, off_y = 0;
+	if (texture->atlas != NULL) {
+		tex = texture->atlas->tex;
+		tex_width = tex_height = texture->atlas->size;
+		off_x = texture->atlas_x;
+		off_y = texture->atlas_y;
+	}
+
+	GLenum min_filter = gles2_texture_min_filter(renderer, texture, box,
+		matrix);
+
 	push_gles2_debug(renderer);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(texture->target, texture->tex);
+	gles2_bind_tex(renderer, texture->target, tex);
 
-	glTexParameteri(texture->target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	gles2_set_min_filter(renderer, texture->target, tex, min_filter);
 
-	glUseProgram(shader->program);
+	gles2_use_program(renderer, shader->program);
+
+	gles2_set_blend(renderer, alpha < 1.0 || texture->has_alpha);
 
 	glUniformMatrix3fv(shader->proj, 1, GL_FALSE, gl_matrix);
+	shader->proj_identity = false;
 	glUniform1i(shader->invert_y, texture->inverted_y);
-	glUniform1i(shader->tex, 0);
+	if (!shader->tex_unit_set) {
+		glUniform1i(shader->tex, 0);
+		shader->tex_unit_set = true;
+	}
 	glUniform1f(shader->alpha, alpha);
+	gles2_set_lut_uniforms(renderer, shader->lut_enabled, shader->lut);
 
-	const GLfloat x1 = box->x / wlr_texture->width;
-	const GLfloat y1 = box->y / wlr_texture->height;
-	const GLfloat x2 = (box->x + box->width) / wlr_texture->width;
-	const GLfloat y2 = (box->y + box->height) / wlr_texture->height;
+	const GLfloat x1 = (off_x + box->x) / tex_width;
+	const GLfloat y1 = (off_y + box->y) / tex_height;
+	const GLfloat x2 = (off_x + box->x + box->width) / tex_width;
+	const GLfloat y2 = (off_y + box->y + box->height) / tex_height;
 	const GLfloat texcoord[] = {
 		x2, y1, // top right
 		x1, y1, // top left
@@ -317,13 +771,40 @@ static bool gles2_render_subtexture_with_matrix(
 	glEnableVertexAttribArray(shader->pos_attrib);
 	glEnableVertexAttribArray(shader->tex_attrib);
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	// All GL state above is shared by every damage rectangle: only the
+	// scissor box changes between draws
+	glEnable(GL_SCISSOR_TEST);
+
+	int rects_len;
+	pixman_box32_t *rects = pixman_region32_rectangles(damage, &rects_len);
+	for (int i = 0; i < rects_len; ++i) {
+		struct wlr_box scissor_box = {
+			.x = rects[i].x1,
+			.y = rects[i].y1,
+			.width = rects[i].x2 - rects[i].x1,
+			.height = rects[i].y2 - rects[i].y1,
+		};
+
+		struct wlr_box gl_box;
+		if (renderer->current_buffer != NULL) {
+			memcpy(&gl_box, &scissor_box, sizeof(gl_box));
+		} else {
+			wlr_box_transform(&gl_box, &scissor_box,
+				WL_OUTPUT_TRANSFORM_FLIPPED_180,
+				renderer->viewport_width, renderer->viewport_height);
+		}
+
+		glScissor(gl_box.x, gl_box.y, gl_box.width, gl_box.height);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		++renderer->stats.scissor_changes;
+		++renderer->stats.draw_calls;
+	}
+
+	glDisable(GL_SCISSOR_TEST);
 
 	glDisableVertexAttribArray(shader->pos_attrib);
 	glDisableVertexAttribArray(shader->tex_attrib);
 
-	glBindTexture(texture->target, 0);
-
 	pop_gles2_debug(renderer);
 	return true;
 }
@@ -333,6 +814,8 @@ static void gles2_render_quad_with_matrix(struct wlr_renderer *wlr_renderer,
 	struct wlr_gles2_renderer *renderer =
 		gles2_get_renderer_in_context(wlr_renderer);
 
+	gles2_flush_quad_batch(renderer);
+
 	float gl_matrix[9];
 	if (renderer->current_buffer != NULL) {
 		wlr_matrix_multiply(gl_matrix, flip_180, matrix);
@@ -344,10 +827,14 @@ static void gles2_render_quad_with_matrix(struct wlr_renderer *wlr_renderer,
 	wlr_matrix_transpose(gl_matrix, gl_matrix);
 
 	push_gles2_debug(renderer);
-	glUseProgram(renderer->shaders.quad.program);
+	gles2_use_program(renderer, renderer->shaders.quad.program);
+
+	gles2_set_blend(renderer, color[3] < 1.0);
 
 	glUniformMatrix3fv(renderer->shaders.quad.proj, 1, GL_FALSE, gl_matrix);
 	glUniform4f(renderer->shaders.quad.color, color[0], color[1], color[2], color[3]);
+	gles2_set_lut_uniforms(renderer, renderer->shaders.quad.lut_enabled,
+		renderer->shaders.quad.lut);
 
 	glVertexAttribPointer(renderer->shaders.quad.pos_attrib, 2, GL_FLOAT, GL_FALSE,
 			0, verts);
@@ -355,6 +842,7 @@ static void gles2_render_quad_with_matrix(struct wlr_renderer *wlr_renderer,
 	glEnableVertexAttribArray(renderer->shaders.quad.pos_attrib);
 
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	++renderer->stats.draw_calls;
 
 	glDisableVertexAttribArray(renderer->shaders.quad.pos_attrib);
 
@@ -366,6 +854,8 @@ static void gles2_render_ellipse_with_matrix(struct wlr_renderer *wlr_renderer,
 	struct wlr_gles2_renderer *renderer =
 		gles2_get_renderer_in_context(wlr_renderer);
 
+	gles2_flush_quad_batch(renderer);
+
 	float gl_matrix[9];
 	if (renderer->current_buffer != NULL) {
 		wlr_matrix_multiply(gl_matrix, flip_180, matrix);
@@ -384,10 +874,16 @@ static void gles2_render_ellipse_with_matrix(struct wlr_renderer *wlr_renderer,
 	};
 
 	push_gles2_debug(renderer);
-	glUseProgram(renderer->shaders.ellipse.program);
+	gles2_use_program(renderer, renderer->shaders.ellipse.program);
+
+	// The shader writes transparent pixels outside the ellipse, so this
+	// draw always needs blending
+	gles2_set_blend(renderer, true);
 
 	glUniformMatrix3fv(renderer->shaders.ellipse.proj, 1, GL_FALSE, gl_matrix);
 	glUniform4f(renderer->shaders.ellipse.color, color[0], color[1], color[2], color[3]);
+	gles2_set_lut_uniforms(renderer, renderer->shaders.ellipse.lut_enabled,
+		renderer->shaders.ellipse.lut);
 
 	glVertexAttribPointer(renderer->shaders.ellipse.pos_attrib, 2, GL_FLOAT,
 			GL_FALSE, 0, verts);
@@ -398,6 +894,7 @@ static void gles2_render_ellipse_with_matrix(struct wlr_renderer *wlr_renderer,
 	glEnableVertexAttribArray(renderer->shaders.ellipse.tex_attrib);
 
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	++renderer->stats.draw_calls;
 
 	glDisableVertexAttribArray(renderer->shaders.ellipse.pos_attrib);
 	glDisableVertexAttribArray(renderer->shaders.ellipse.tex_attrib);
@@ -480,62 +977,226 @@ static enum wl_shm_format gles2_preferred_read_format(
 	return WL_SHM_FORMAT_XBGR8888;
 }
 
-static bool gles2_read_pixels(struct wlr_renderer *wlr_renderer,
-		enum wl_shm_format wl_fmt, uint32_t *flags, uint32_t stride,
-		uint32_t width, uint32_t height, uint32_t src_x, uint32_t src_y,
-		uint32_t dst_x, uint32_t dst_y, void *data) {
-	struct wlr_gles2_renderer *renderer =
-		gles2_get_renderer_in_context(wlr_renderer);
-
-	const struct wlr_gles2_pixel_format *fmt = get_gles2_format_from_wl(wl_fmt);
-	if (fmt == NULL) {
-		wlr_log(WLR_ERROR, "Cannot read pixels: unsupported pixel format");
-		return false;
-	}
-
-	if (fmt->gl_format == GL_BGRA_EXT && !renderer->exts.read_format_bgra_ext) {
-		wlr_log(WLR_ERROR,
-			"Cannot read pixels: missing GL_EXT_read_format_bgra extension");
+// Reads back through an intermediate framebuffer in the requested format:
+// the source region is snapshotted into a texture, drawn into the
+// intermediate (converting, and red/blue-swapping for BGRA byte orders, on
+// the GPU), and read from there. This delivers formats the current
+// framebuffer can't produce directly (RGB565, or BGRA without
+// GL_EXT_read_format_bgra) without a CPU conversion loop in the caller.
+static bool gles2_read_pixels_convert(struct wlr_gles2_renderer *renderer,
+		const struct wlr_gles2_pixel_format *fmt, uint32_t *flags,
+		uint32_t stride, uint32_t width, uint32_t height, uint32_t src_x,
+		uint32_t src_y, uint32_t dst_x, uint32_t dst_y, void *data) {
+	bool ok = false;
+
+	// The conversion pass may run before the first render
+	if (!gles2_collect_shaders(renderer)) {
 		return false;
 	}
 
 	push_gles2_debug(renderer);
-
-	// Make sure any pending drawing is finished before we try to read it
-	glFinish();
-
 	glGetError(); // Clear the error flag
 
-	unsigned char *p = (unsigned char *)data + dst_y * stride;
-	uint32_t pack_stride = width * fmt->bpp / 8;
-	if (pack_stride == stride && dst_x == 0 && flags != NULL) {
-		// Under these particular conditions, we can read the pixels with only
-		// one glReadPixels call
+	// Snapshot the source region; the driver converts to RGBA channels here
+	GLuint src_tex = 0;
+	glGenTextures(1, &src_tex);
+	gles2_bind_tex(renderer, GL_TEXTURE_2D, src_tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	uint32_t snap_y = src_y;
+	if (renderer->current_buffer == NULL) {
+		snap_y = renderer->viewport_height - height - src_y;
+	}
+	glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, src_x, snap_y, width, height,
+		0);
 
-		uint32_t y = src_y;
-		if (renderer->current_buffer == NULL) {
-			y = renderer->viewport_height - height - src_y;
-		}
+	GLuint dst_tex = 0, dst_rbo = 0, fbo = 0;
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	if (fmt->gl_format == GL_RGB) {
+		glGenRenderbuffers(1, &dst_rbo);
+		glBindRenderbuffer(GL_RENDERBUFFER, dst_rbo);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB565, width, height);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_RENDERBUFFER, dst_rbo);
+	} else {
+		glGenTextures(1, &dst_tex);
+		gles2_bind_tex(renderer, GL_TEXTURE_2D, dst_tex);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+			GL_UNSIGNED_BYTE, NULL);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D, dst_tex, 0);
+	}
 
-		glReadPixels(src_x, y, width, height, fmt->gl_format, fmt->gl_type, p);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		goto out;
+	}
 
-		if (renderer->current_buffer != NULL) {
-			*flags = 0;
-		} else {
-			*flags = WLR_RENDERER_READ_PIXELS_Y_INVERT;
+	// Reading GL_RGBA/GL_UNSIGNED_BYTE always works; anything else is only
+	// guaranteed when the bound framebuffer's preferred combination matches
+	if (fmt->gl_format != GL_RGBA || fmt->gl_type != GL_UNSIGNED_BYTE) {
+		GLint impl_fmt = -1, impl_type = -1;
+		glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_FORMAT, &impl_fmt);
+		glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_TYPE, &impl_type);
+		if (impl_fmt != (GLint)fmt->gl_format ||
+				impl_type != (GLint)fmt->gl_type) {
+			goto out;
 		}
-	} else {
-		// Unfortunately GLES2 doesn't support GL_PACK_*, so we have to read
-		// the lines out row by row
-		for (size_t i = 0; i < height; ++i) {
-			uint32_t y = src_y + i;
-			if (renderer->current_buffer == NULL) {
-				y = renderer->viewport_height - src_y - i - 1;
-			}
+	}
 
-			glReadPixels(src_x, y, width, 1, fmt->gl_format,
-				fmt->gl_type, p + i * stride + dst_x * fmt->bpp / 8);
-		}
+	// The BGRA byte orders are produced by the red/blue-swapping shader:
+	// reading the swapped intermediate as RGBA yields B,G,R,A bytes
+	struct wlr_gles2_tex_shader *shader = fmt->gl_format == GL_BGRA_EXT ?
+		&renderer->shaders.tex_swap_rgba : &renderer->shaders.tex_rgbx;
+
+	float mat[9];
+	wlr_matrix_projection(mat, 1, 1, WL_OUTPUT_TRANSFORM_NORMAL);
+	static const GLfloat texcoord[] = {
+		1, 0, // top right
+		0, 0, // top left
+		1, 1, // bottom right
+		0, 1, // bottom left
+	};
+
+	GLboolean blend = glIsEnabled(GL_BLEND);
+	glDisable(GL_BLEND);
+	glViewport(0, 0, width, height);
+
+	// Pick invert_y so that the intermediate always ends up with the region's
+	// top row in framebuffer row 0, whichever orientation the source has
+	if (!gles2_batch_quad(renderer, shader, GL_TEXTURE_2D, src_tex,
+			GL_NEAREST, renderer->current_buffer != NULL, mat, texcoord,
+			1.0f)) {
+		goto restore;
+	}
+	gles2_flush_quad_batch(renderer);
+
+	if (fmt->bpp / 8 < 4) {
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	}
+
+	unsigned char *p = (unsigned char *)data + dst_y * stride;
+	uint32_t pack_stride = width * fmt->bpp / 8;
+	if (pack_stride == stride && dst_x == 0) {
+		glReadPixels(0, 0, width, height, fmt->gl_format, fmt->gl_type, p);
+	} else {
+		for (size_t i = 0; i < height; ++i) {
+			glReadPixels(0, i, width, 1, fmt->gl_format, fmt->gl_type,
+				p + i * stride + dst_x * fmt->bpp / 8);
+		}
+	}
+	if (flags != NULL) {
+		*flags = 0;
+	}
+
+	if (fmt->bpp / 8 < 4) {
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	}
+
+	ok = glGetError() == GL_NO_ERROR;
+
+restore:
+	glViewport(0, 0, renderer->viewport_width, renderer->viewport_height);
+	if (blend) {
+		glEnable(GL_BLEND);
+	}
+out:
+	glBindFramebuffer(GL_FRAMEBUFFER, renderer->current_buffer != NULL ?
+		renderer->current_buffer->fbo : 0);
+	glDeleteFramebuffers(1, &fbo);
+	if (dst_rbo != 0) {
+		glDeleteRenderbuffers(1, &dst_rbo);
+	}
+	if (dst_tex != 0) {
+		glDeleteTextures(1, &dst_tex);
+	}
+	glDeleteTextures(1, &src_tex);
+	// The deleted textures may have been cached as bound
+	gles2_invalidate_gl_state(renderer);
+
+	pop_gles2_debug(renderer);
+
+	return ok;
+}
+
+static bool gles2_read_pixels(struct wlr_renderer *wlr_renderer,
+		enum wl_shm_format wl_fmt, uint32_t *flags, uint32_t stride,
+		uint32_t width, uint32_t height, uint32_t src_x, uint32_t src_y,
+		uint32_t dst_x, uint32_t dst_y, void *data) {
+	struct wlr_gles2_renderer *renderer =
+		gles2_get_renderer_in_context(wlr_renderer);
+
+	const struct wlr_gles2_pixel_format *fmt = get_gles2_format_from_wl(wl_fmt);
+	if (fmt == NULL) {
+		wlr_log(WLR_ERROR, "Cannot read pixels: unsupported pixel format");
+		return false;
+	}
+
+	gles2_flush_quad_batch(renderer);
+
+	// Formats the current framebuffer can't be read in directly go through a
+	// GPU conversion blit instead of failing
+	bool direct;
+	if (fmt->gl_format == GL_RGBA && fmt->gl_type == GL_UNSIGNED_BYTE) {
+		direct = true;
+	} else if (fmt->gl_format == GL_BGRA_EXT) {
+		direct = renderer->exts.read_format_bgra_ext;
+	} else {
+		GLint impl_fmt = -1, impl_type = -1;
+		glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_FORMAT, &impl_fmt);
+		glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_TYPE, &impl_type);
+		direct = impl_fmt == (GLint)fmt->gl_format &&
+			impl_type == (GLint)fmt->gl_type;
+	}
+	if (!direct) {
+		push_gles2_debug(renderer);
+		// Make sure pending drawing has landed before snapshotting it
+		glFinish();
+		pop_gles2_debug(renderer);
+		return gles2_read_pixels_convert(renderer, fmt, flags, stride, width,
+			height, src_x, src_y, dst_x, dst_y, data);
+	}
+
+	push_gles2_debug(renderer);
+
+	// Make sure any pending drawing is finished before we try to read it
+	glFinish();
+
+	glGetError(); // Clear the error flag
+
+	unsigned char *p = (unsigned char *)data + dst_y * stride;
+	uint32_t pack_stride = width * fmt->bpp / 8;
+	if (pack_stride == stride && dst_x == 0 && flags != NULL) {
+		// Under these particular conditions, we can read the pixels with only
+		// one glReadPixels call
+
+		uint32_t y = src_y;
+		if (renderer->current_buffer == NULL) {
+			y = renderer->viewport_height - height - src_y;
+		}
+
+		glReadPixels(src_x, y, width, height, fmt->gl_format, fmt->gl_type, p);
+
+		if (renderer->current_buffer != NULL) {
+			*flags = 0;
+		} else {
+			*flags = WLR_RENDERER_READ_PIXELS_Y_INVERT;
+		}
+	} else {
+		// Unfortunately GLES2 doesn't support GL_PACK_*, so we have to read
+		// the lines out row by row
+		for (size_t i = 0; i < height; ++i) {
+			uint32_t y = src_y + i;
+			if (renderer->current_buffer == NULL) {
+				y = renderer->viewport_height - src_y - i - 1;
+			}
+
+			glReadPixels(src_x, y, width, 1, fmt->gl_format,
+				fmt->gl_type, p + i * stride + dst_x * fmt->bpp / 8);
+		}
 
 		if (flags != NULL) {
 			*flags = 0;
@@ -547,9 +1208,200 @@ static bool gles2_read_pixels(struct wlr_renderer *wlr_renderer,
 	return glGetError() == GL_NO_ERROR;
 }
 
+struct wlr_gles2_async_read {
+	struct wl_list link; // wlr_gles2_renderer.async_reads
+	struct wlr_gles2_renderer *renderer;
+
+	GLuint pbo;
+	EGLSyncKHR sync;
+
+	const struct wlr_gles2_pixel_format *fmt;
+	uint32_t stride, width, height, dst_x, dst_y;
+	bool flip; // un-invert rows while copying out
+	void *data;
+
+	wlr_renderer_read_pixels_cb cb;
+	void *cb_data;
+};
+
+// The renderer's context must be current
+static void gles2_finish_async_read(struct wlr_gles2_async_read *read,
+		bool success) {
+	struct wlr_gles2_renderer *renderer = read->renderer;
+
+	push_gles2_debug(renderer);
+
+	uint32_t pack_stride = read->width * read->fmt->bpp / 8;
+	if (success) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, read->pbo);
+		void *src = renderer->procs.glMapBufferRangeEXT(
+			GL_PIXEL_PACK_BUFFER_NV, 0,
+			(GLsizeiptr)pack_stride * read->height, GL_MAP_READ_BIT_EXT);
+		if (src == NULL) {
+			success = false;
+		} else {
+			unsigned char *p = (unsigned char *)read->data +
+				read->dst_y * read->stride +
+				read->dst_x * read->fmt->bpp / 8;
+			for (uint32_t i = 0; i < read->height; ++i) {
+				uint32_t src_row = read->flip ? read->height - i - 1 : i;
+				memcpy(p + i * read->stride,
+					(unsigned char *)src + src_row * pack_stride,
+					pack_stride);
+			}
+			renderer->procs.glUnmapBufferOES(GL_PIXEL_PACK_BUFFER_NV);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, 0);
+	}
+	glDeleteBuffers(1, &read->pbo);
+
+	pop_gles2_debug(renderer);
+
+	wlr_egl_destroy_sync(renderer->egl, read->sync);
+	wl_list_remove(&read->link);
+
+	wlr_renderer_read_pixels_cb cb = read->cb;
+	void *cb_data = read->cb_data;
+	free(read);
+
+	cb(success, cb_data);
+}
+
+static bool gles2_read_pixels_async(struct wlr_renderer *wlr_renderer,
+		enum wl_shm_format wl_fmt, uint32_t *flags, uint32_t stride,
+		uint32_t width, uint32_t height, uint32_t src_x, uint32_t src_y,
+		uint32_t dst_x, uint32_t dst_y, void *data,
+		wlr_renderer_read_pixels_cb cb, void *cb_data) {
+	struct wlr_gles2_renderer *renderer =
+		gles2_get_renderer_in_context(wlr_renderer);
+
+	if (!renderer->exts.pixel_buffer_object_nv ||
+			!renderer->exts.map_buffer_range_ext ||
+			!renderer->egl->exts.fence_sync_khr) {
+		return false;
+	}
+
+	const struct wlr_gles2_pixel_format *fmt = get_gles2_format_from_wl(wl_fmt);
+	if (fmt == NULL) {
+		wlr_log(WLR_ERROR, "Cannot read pixels: unsupported pixel format");
+		return false;
+	}
+
+	if (fmt->gl_format == GL_BGRA_EXT && !renderer->exts.read_format_bgra_ext) {
+		wlr_log(WLR_ERROR,
+			"Cannot read pixels: missing GL_EXT_read_format_bgra extension");
+		return false;
+	}
+
+	struct wlr_gles2_async_read *read = calloc(1, sizeof(*read));
+	if (read == NULL) {
+		wlr_log_errno(WLR_ERROR, "Allocation failed");
+		return false;
+	}
+
+	gles2_flush_quad_batch(renderer);
+
+	push_gles2_debug(renderer);
+
+	glGetError(); // Clear the error flag
+
+	uint32_t pack_stride = width * fmt->bpp / 8;
+	GLuint pbo;
+	glGenBuffers(1, &pbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, pbo);
+	glBufferData(GL_PIXEL_PACK_BUFFER_NV, (GLsizeiptr)pack_stride * height,
+		NULL, GL_DYNAMIC_DRAW);
+
+	bool from_surface = renderer->current_buffer == NULL;
+	uint32_t y = src_y;
+	if (from_surface) {
+		y = renderer->viewport_height - height - src_y;
+	}
+
+	// With a pixel pack buffer bound, this returns immediately: the GPU
+	// performs the copy once the frame has been rendered
+	glReadPixels(src_x, y, width, height, fmt->gl_format, fmt->gl_type, NULL);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, 0);
+
+	if (glGetError() != GL_NO_ERROR) {
+		glDeleteBuffers(1, &pbo);
+		pop_gles2_debug(renderer);
+		free(read);
+		return false;
+	}
+
+	pop_gles2_debug(renderer);
+
+	read->renderer = renderer;
+	read->pbo = pbo;
+	read->fmt = fmt;
+	read->stride = stride;
+	read->width = width;
+	read->height = height;
+	read->dst_x = dst_x;
+	read->dst_y = dst_y;
+	read->data = data;
+	read->cb = cb;
+	read->cb_data = cb_data;
+
+	if (flags != NULL) {
+		*flags = from_surface ? WLR_RENDERER_READ_PIXELS_Y_INVERT : 0;
+	} else {
+		read->flip = from_surface;
+	}
+
+	read->sync = wlr_egl_create_sync(renderer->egl);
+	wl_list_insert(&renderer->async_reads, &read->link);
+
+	if (read->sync == EGL_NO_SYNC_KHR) {
+		// No fence available: complete the read right away
+		push_gles2_debug(renderer);
+		glFinish();
+		pop_gles2_debug(renderer);
+		gles2_finish_async_read(read, true);
+	} else {
+		// Make sure the fence is submitted to the GPU
+		push_gles2_debug(renderer);
+		glFlush();
+		pop_gles2_debug(renderer);
+	}
+
+	return true;
+}
+
+static size_t gles2_poll_async_reads(struct wlr_renderer *wlr_renderer) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+
+	if (wl_list_empty(&renderer->async_reads)) {
+		return 0;
+	}
+
+	struct wlr_egl_context prev_ctx;
+	wlr_egl_save_context(&prev_ctx);
+	gles2_make_current(renderer);
+
+	struct wlr_gles2_async_read *read, *tmp;
+	wl_list_for_each_safe(read, tmp, &renderer->async_reads, link) {
+		if (wlr_egl_check_sync(renderer->egl, read->sync)) {
+			gles2_finish_async_read(read, true);
+		}
+	}
+
+	size_t pending = 0;
+	wl_list_for_each(read, &renderer->async_reads, link) {
+		++pending;
+	}
+
+	wlr_egl_restore_context(&prev_ctx);
+
+	return pending;
+}
+
 static bool gles2_blit_dmabuf(struct wlr_renderer *wlr_renderer,
 		struct wlr_dmabuf_attributes *dst_attr,
-		struct wlr_dmabuf_attributes *src_attr) {
+		struct wlr_dmabuf_attributes *src_attr,
+		const struct wlr_fbox *src_box) {
 	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
 	if (!renderer->procs.glEGLImageTargetRenderbufferStorageOES) {
 		return false;
@@ -580,7 +1432,7 @@ static bool gles2_blit_dmabuf(struct wlr_renderer *wlr_renderer,
 		gles2_src_tex->inverted_y = !gles2_src_tex->inverted_y;
 	}
 
-	if (!wlr_egl_make_current(renderer->egl)) {
+	if (!gles2_make_current(renderer)) {
 		goto texture_destroy_out;
 	}
 
@@ -617,7 +1469,14 @@ static bool gles2_blit_dmabuf(struct wlr_renderer *wlr_renderer,
 
 	wlr_renderer_begin(wlr_renderer, dst_attr->width, dst_attr->height);
 	wlr_renderer_clear(wlr_renderer, (float[]){ 0.0, 0.0, 0.0, 0.0 });
-	wlr_render_texture_with_matrix(wlr_renderer, src_tex, mat, 1.0f);
+	if (src_box != NULL) {
+		// Sample only the requested source region; the quad still covers the
+		// whole destination, so cropping and scaling happen in one pass
+		wlr_render_subtexture_with_matrix(wlr_renderer, src_tex, src_box,
+			mat, 1.0f);
+	} else {
+		wlr_render_texture_with_matrix(wlr_renderer, src_tex, mat, 1.0f);
+	}
 	wlr_renderer_end(wlr_renderer);
 
 	r = true;
@@ -658,6 +1517,30 @@ static bool gles2_init_wl_display(struct wlr_renderer *wlr_renderer,
 	return true;
 }
 
+static bool gles2_get_render_timings(struct wlr_renderer *wlr_renderer,
+		struct wlr_render_timings *timings) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+
+	if (!renderer->exts.disjoint_timer_query_ext) {
+		return false;
+	}
+
+	timings->gpu_render_duration_ns = renderer->timer.last_duration_ns;
+	return true;
+}
+
+static bool gles2_get_stats(struct wlr_renderer *wlr_renderer,
+		struct wlr_renderer_stats *stats) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+	*stats = renderer->stats;
+	return true;
+}
+
+static void gles2_reset_stats(struct wlr_renderer *wlr_renderer) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+	memset(&renderer->stats, 0, sizeof(renderer->stats));
+}
+
 static int gles2_get_drm_fd(struct wlr_renderer *wlr_renderer) {
 	struct wlr_gles2_renderer *renderer =
 		gles2_get_renderer(wlr_renderer);
@@ -669,28 +1552,162 @@ static int gles2_get_drm_fd(struct wlr_renderer *wlr_renderer) {
 	return renderer->drm_fd;
 }
 
+static int gles2_get_fence_fd(struct wlr_renderer *wlr_renderer) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+
+	if (!renderer->egl->exts.native_fence_sync_android) {
+		return -1;
+	}
+
+	struct wlr_egl_context prev_ctx;
+	wlr_egl_save_context(&prev_ctx);
+	gles2_make_current(renderer);
+
+	int fd = -1;
+	EGLSyncKHR sync = wlr_egl_create_native_sync(renderer->egl);
+	if (sync != EGL_NO_SYNC_KHR) {
+		// The sync file only materializes once the fence command has been
+		// flushed
+		glFlush();
+		fd = wlr_egl_dup_fence_fd(renderer->egl, sync);
+		wlr_egl_destroy_sync(renderer->egl, sync);
+	}
+
+	wlr_egl_restore_context(&prev_ctx);
+
+	return fd;
+}
+
+static bool gles2_set_gamma_lut(struct wlr_renderer *wlr_renderer,
+		size_t ramp_size, const uint16_t *r, const uint16_t *g,
+		const uint16_t *b) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+
+	struct wlr_egl_context prev_ctx;
+	wlr_egl_save_context(&prev_ctx);
+	gles2_make_current(renderer);
+
+	push_gles2_debug(renderer);
+
+	if (ramp_size == 0) {
+		if (renderer->lut_tex != 0) {
+			glDeleteTextures(1, &renderer->lut_tex);
+			renderer->lut_tex = 0;
+		}
+		pop_gles2_debug(renderer);
+		wlr_egl_restore_context(&prev_ctx);
+		return true;
+	}
+
+	// Resample the ramps into the fixed-size LUT the shaders sample
+	uint8_t texels[WLR_GLES2_LUT_SIZE * 4];
+	for (size_t i = 0; i < WLR_GLES2_LUT_SIZE; ++i) {
+		size_t j = ramp_size > 1 ?
+			i * (ramp_size - 1) / (WLR_GLES2_LUT_SIZE - 1) : 0;
+		texels[i * 4 + 0] = r[j] >> 8;
+		texels[i * 4 + 1] = g[j] >> 8;
+		texels[i * 4 + 2] = b[j] >> 8;
+		texels[i * 4 + 3] = 0xFF;
+	}
+
+	bool created = renderer->lut_tex == 0;
+	if (created) {
+		glGenTextures(1, &renderer->lut_tex);
+	}
+	glBindTexture(GL_TEXTURE_2D, renderer->lut_tex);
+	if (created) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, WLR_GLES2_LUT_SIZE, 1, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, texels);
+	} else {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, WLR_GLES2_LUT_SIZE, 1,
+			GL_RGBA, GL_UNSIGNED_BYTE, texels);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	gles2_invalidate_gl_state(renderer);
+
+	pop_gles2_debug(renderer);
+
+	wlr_egl_restore_context(&prev_ctx);
+
+	return true;
+}
+
 struct wlr_egl *wlr_gles2_renderer_get_egl(struct wlr_renderer *wlr_renderer) {
 	struct wlr_gles2_renderer *renderer =
 		gles2_get_renderer(wlr_renderer);
 	return renderer->egl;
 }
 
+void wlr_gles2_renderer_set_context_ownership(
+		struct wlr_renderer *wlr_renderer, bool owned) {
+	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
+	renderer->context_owned = owned;
+	if (!owned) {
+		// The next frame must re-establish everything again
+		renderer->context_state_prepared = false;
+		gles2_invalidate_gl_state(renderer);
+	}
+}
+
 static void gles2_destroy(struct wlr_renderer *wlr_renderer) {
 	struct wlr_gles2_renderer *renderer = gles2_get_renderer(wlr_renderer);
 
 	wlr_egl_make_current(renderer->egl);
 
+	gles2_upload_thread_finish(renderer);
+
+	struct wlr_gles2_async_read *read, *read_tmp;
+	wl_list_for_each_safe(read, read_tmp, &renderer->async_reads, link) {
+		gles2_finish_async_read(read, false);
+	}
+
 	struct wlr_gles2_buffer *buffer, *buffer_tmp;
 	wl_list_for_each_safe(buffer, buffer_tmp, &renderer->buffers, link) {
 		destroy_buffer(buffer);
 	}
 
+	gles2_atlas_destroy_all(renderer);
+	gles2_dmabuf_cache_destroy_all(renderer);
+	gles2_tex_pool_destroy_all(renderer);
+
 	push_gles2_debug(renderer);
+	if (renderer->quad_batch.vbo != 0) {
+		glDeleteBuffers(1, &renderer->quad_batch.vbo);
+	}
+	if (renderer->exts.disjoint_timer_query_ext &&
+			renderer->timer.queries[0] != 0) {
+		renderer->procs.glDeleteQueriesEXT(sizeof(renderer->timer.queries) /
+			sizeof(renderer->timer.queries[0]), renderer->timer.queries);
+	}
+	free(renderer->quad_batch.verts);
+	if (renderer->lut_tex != 0) {
+		glDeleteTextures(1, &renderer->lut_tex);
+	}
 	glDeleteProgram(renderer->shaders.quad.program);
 	glDeleteProgram(renderer->shaders.ellipse.program);
 	glDeleteProgram(renderer->shaders.tex_rgba.program);
 	glDeleteProgram(renderer->shaders.tex_rgbx.program);
+	glDeleteProgram(renderer->shaders.tex_swap_rgba.program);
 	glDeleteProgram(renderer->shaders.tex_ext.program);
+
+	// Programs whose link results were never collected still own their objects
+	struct wlr_gles2_pending_program *pending[] = {
+		&renderer->pending_shaders.quad,
+		&renderer->pending_shaders.ellipse,
+		&renderer->pending_shaders.tex_rgba,
+		&renderer->pending_shaders.tex_rgbx,
+		&renderer->pending_shaders.tex_swap_rgba,
+		&renderer->pending_shaders.tex_ext,
+	};
+	for (size_t i = 0; i < sizeof(pending) / sizeof(pending[0]); ++i) {
+		glDeleteShader(pending[i]->vert);
+		glDeleteShader(pending[i]->frag);
+		glDeleteProgram(pending[i]->program);
+	}
 	pop_gles2_debug(renderer);
 
 	if (renderer->exts.debug_khr) {
@@ -716,6 +1733,8 @@ static const struct wlr_renderer_impl renderer_impl = {
 	.clear = gles2_clear,
 	.scissor = gles2_scissor,
 	.render_subtexture_with_matrix = gles2_render_subtexture_with_matrix,
+	.render_subtexture_with_matrix_damage =
+		gles2_render_subtexture_with_matrix_damage,
 	.render_quad_with_matrix = gles2_render_quad_with_matrix,
 	.render_ellipse_with_matrix = gles2_render_ellipse_with_matrix,
 	.get_shm_texture_formats = gles2_get_shm_texture_formats,
@@ -725,12 +1744,19 @@ static const struct wlr_renderer_impl renderer_impl = {
 	.get_dmabuf_render_formats = gles2_get_dmabuf_render_formats,
 	.preferred_read_format = gles2_preferred_read_format,
 	.read_pixels = gles2_read_pixels,
+	.read_pixels_async = gles2_read_pixels_async,
+	.poll_async_reads = gles2_poll_async_reads,
 	.texture_from_pixels = gles2_texture_from_pixels,
 	.texture_from_wl_drm = gles2_texture_from_wl_drm,
 	.texture_from_dmabuf = gles2_texture_from_dmabuf,
 	.init_wl_display = gles2_init_wl_display,
 	.blit_dmabuf = gles2_blit_dmabuf,
 	.get_drm_fd = gles2_get_drm_fd,
+	.get_render_timings = gles2_get_render_timings,
+	.get_stats = gles2_get_stats,
+	.reset_stats = gles2_reset_stats,
+	.get_fence_fd = gles2_get_fence_fd,
+	.set_gamma_lut = gles2_set_gamma_lut,
 };
 
 void push_gles2_debug_(struct wlr_gles2_renderer *renderer,
@@ -771,63 +1797,221 @@ static void gles2_log(GLenum src, GLenum type, GLuint id, GLenum severity,
 	_wlr_log(gles2_log_importance_to_wlr(type), "[GLES2] %s", msg);
 }
 
-static GLuint compile_shader(struct wlr_gles2_renderer *renderer,
-		GLuint type, const GLchar *src) {
+static void start_program(struct wlr_gles2_renderer *renderer,
+		struct wlr_gles2_pending_program *pending,
+		const GLchar *vert_src, const GLchar *frag_src) {
 	push_gles2_debug(renderer);
 
-	GLuint shader = glCreateShader(type);
-	glShaderSource(shader, 1, &src, NULL);
-	glCompileShader(shader);
+	pending->vert_src = vert_src;
+	pending->frag_src = frag_src;
 
-	GLint ok;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
-	if (ok == GL_FALSE) {
-		glDeleteShader(shader);
-		shader = 0;
+	pending->program = load_cached_program(renderer, vert_src, frag_src);
+	if (pending->program) {
+		pop_gles2_debug(renderer);
+		return;
 	}
 
+	// No status queries here: with GL_KHR_parallel_shader_compile the driver
+	// compiles and links on its own worker threads, and querying a result
+	// would block on them. finish_program checks the outcome.
+	pending->vert = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(pending->vert, 1, &vert_src, NULL);
+	glCompileShader(pending->vert);
+
+	pending->frag = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(pending->frag, 1, &frag_src, NULL);
+	glCompileShader(pending->frag);
+
+	pending->program = glCreateProgram();
+	glAttachShader(pending->program, pending->vert);
+	glAttachShader(pending->program, pending->frag);
+	glLinkProgram(pending->program);
+
 	pop_gles2_debug(renderer);
-	return shader;
 }
 
-static GLuint link_program(struct wlr_gles2_renderer *renderer,
+static uint64_t shader_cache_hash(uint64_t hash, const char *str) {
+	// FNV-1a
+	for (const char *p = str; *p != '\0'; ++p) {
+		hash ^= (unsigned char)*p;
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
+static bool shader_cache_path(struct wlr_gles2_renderer *renderer,
+		const GLchar *vert_src, const GLchar *frag_src,
+		char *buf, size_t size) {
+	char dir[256];
+	const char *cache_home = getenv("XDG_CACHE_HOME");
+	if (cache_home != NULL && cache_home[0] != '\0') {
+		snprintf(dir, sizeof(dir), "%s/wlroots", cache_home);
+	} else {
+		const char *home = getenv("HOME");
+		if (home == NULL || home[0] == '\0') {
+			return false;
+		}
+		snprintf(dir, sizeof(dir), "%s/.cache/wlroots", home);
+	}
+
+	if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+		return false;
+	}
+
+	// Key the cache on the driver and the shader sources, so that driver
+	// updates and shader changes both invalidate stale binaries
+	uint64_t hash = 0xcbf29ce484222325;
+	hash = shader_cache_hash(hash, (const char *)glGetString(GL_RENDERER));
+	hash = shader_cache_hash(hash, (const char *)glGetString(GL_VERSION));
+	hash = shader_cache_hash(hash, vert_src);
+	hash = shader_cache_hash(hash, frag_src);
+
+	snprintf(buf, size, "%s/shader-%016" PRIx64 ".bin", dir, hash);
+	return true;
+}
+
+static GLuint load_cached_program(struct wlr_gles2_renderer *renderer,
 		const GLchar *vert_src, const GLchar *frag_src) {
-	push_gles2_debug(renderer);
+	if (!renderer->exts.get_program_binary_oes) {
+		return 0;
+	}
 
-	GLuint vert = compile_shader(renderer, GL_VERTEX_SHADER, vert_src);
-	if (!vert) {
-		goto error;
+	char path[512];
+	if (!shader_cache_path(renderer, vert_src, frag_src, path, sizeof(path))) {
+		return 0;
 	}
 
-	GLuint frag = compile_shader(renderer, GL_FRAGMENT_SHADER, frag_src);
-	if (!frag) {
-		glDeleteShader(vert);
-		goto error;
+	FILE *f = fopen(path, "re");
+	if (f == NULL) {
+		return 0;
 	}
 
-	GLuint prog = glCreateProgram();
-	glAttachShader(prog, vert);
-	glAttachShader(prog, frag);
-	glLinkProgram(prog);
+	GLuint prog = 0;
+	GLenum bin_format;
+	if (fread(&bin_format, sizeof(bin_format), 1, f) != 1) {
+		goto out;
+	}
+
+	long data_start = ftell(f);
+	if (data_start < 0 || fseek(f, 0, SEEK_END) != 0) {
+		goto out;
+	}
+	long len = ftell(f) - data_start;
+	if (len <= 0 || fseek(f, data_start, SEEK_SET) != 0) {
+		goto out;
+	}
+
+	void *data = malloc(len);
+	if (data == NULL) {
+		goto out;
+	}
+	if (fread(data, 1, len, f) != (size_t)len) {
+		free(data);
+		goto out;
+	}
 
-	glDetachShader(prog, vert);
-	glDetachShader(prog, frag);
-	glDeleteShader(vert);
-	glDeleteShader(frag);
+	prog = glCreateProgram();
+	renderer->procs.glProgramBinaryOES(prog, bin_format, data, len);
+	free(data);
 
 	GLint ok;
 	glGetProgramiv(prog, GL_LINK_STATUS, &ok);
 	if (ok == GL_FALSE) {
+		// Stale binary, e.g. after a driver update: fall back to source
 		glDeleteProgram(prog);
-		goto error;
+		prog = 0;
 	}
 
-	pop_gles2_debug(renderer);
+out:
+	fclose(f);
 	return prog;
+}
+
+static void store_cached_program(struct wlr_gles2_renderer *renderer,
+		GLuint prog, const GLchar *vert_src, const GLchar *frag_src) {
+	if (!renderer->exts.get_program_binary_oes) {
+		return;
+	}
+
+	char path[512];
+	if (!shader_cache_path(renderer, vert_src, frag_src, path, sizeof(path))) {
+		return;
+	}
+
+	GLint len = 0;
+	glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH_OES, &len);
+	if (len <= 0) {
+		return;
+	}
+
+	void *data = malloc(len);
+	if (data == NULL) {
+		return;
+	}
+
+	GLenum bin_format;
+	GLsizei written = 0;
+	renderer->procs.glGetProgramBinaryOES(prog, len, &written, &bin_format,
+		data);
+	if (written <= 0) {
+		free(data);
+		return;
+	}
+
+	// Write to a temporary file and rename it, so that concurrent
+	// compositor instances never read a partially-written binary
+	char tmp_path[sizeof(path) + 32];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, getpid());
+	FILE *f = fopen(tmp_path, "we");
+	if (f == NULL) {
+		free(data);
+		return;
+	}
+
+	bool ok = fwrite(&bin_format, sizeof(bin_format), 1, f) == 1 &&
+		fwrite(data, 1, written, f) == (size_t)written;
+	free(data);
+
+	if (fclose(f) != 0 || !ok || rename(tmp_path, path) != 0) {
+		unlink(tmp_path);
+	}
+}
+
+static GLuint finish_program(struct wlr_gles2_renderer *renderer,
+		struct wlr_gles2_pending_program *pending) {
+	GLuint prog = pending->program;
+	pending->program = 0;
+	if (!prog) {
+		return 0;
+	}
+
+	if (pending->vert == 0 && pending->frag == 0) {
+		// Loaded from the binary cache, already validated
+		return prog;
+	}
+
+	push_gles2_debug(renderer);
+
+	glDetachShader(prog, pending->vert);
+	glDetachShader(prog, pending->frag);
+	glDeleteShader(pending->vert);
+	glDeleteShader(pending->frag);
+	pending->vert = 0;
+	pending->frag = 0;
+
+	// This blocks until the driver is done compiling and linking
+	GLint ok;
+	glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+	if (ok == GL_FALSE) {
+		glDeleteProgram(prog);
+		pop_gles2_debug(renderer);
+		return 0;
+	}
+
+	store_cached_program(renderer, prog, pending->vert_src, pending->frag_src);
 
-error:
 	pop_gles2_debug(renderer);
-	return 0;
+	return prog;
 }
 
 static bool check_gl_ext(const char *exts, const char *ext) {
@@ -863,8 +2047,114 @@ extern const GLchar ellipse_fragment_src[];
 extern const GLchar tex_vertex_src[];
 extern const GLchar tex_fragment_src_rgba[];
 extern const GLchar tex_fragment_src_rgbx[];
+extern const GLchar tex_fragment_src_swap_rgba[];
 extern const GLchar tex_fragment_src_external[];
 
+// Collects the results of the program links issued at create time and looks
+// up the uniform and attribute locations. Called lazily on first use, so the
+// driver's shader compiler threads overlap the rest of compositor startup.
+// The renderer's EGL context must be current.
+static bool gles2_collect_shaders(struct wlr_gles2_renderer *renderer) {
+	if (renderer->pending_shaders.collected) {
+		return renderer->pending_shaders.ok;
+	}
+	renderer->pending_shaders.collected = true;
+
+	push_gles2_debug(renderer);
+
+	GLuint prog;
+	renderer->shaders.quad.program = prog =
+		finish_program(renderer, &renderer->pending_shaders.quad);
+	if (!renderer->shaders.quad.program) {
+		goto error;
+	}
+	renderer->shaders.quad.proj = glGetUniformLocation(prog, "proj");
+	renderer->shaders.quad.color = glGetUniformLocation(prog, "color");
+	renderer->shaders.quad.lut_enabled = glGetUniformLocation(prog, "lut_enabled");
+	renderer->shaders.quad.lut = glGetUniformLocation(prog, "lut");
+	renderer->shaders.quad.pos_attrib = glGetAttribLocation(prog, "pos");
+
+	renderer->shaders.ellipse.program = prog =
+		finish_program(renderer, &renderer->pending_shaders.ellipse);
+	if (!renderer->shaders.ellipse.program) {
+		goto error;
+	}
+	renderer->shaders.ellipse.proj = glGetUniformLocation(prog, "proj");
+	renderer->shaders.ellipse.color = glGetUniformLocation(prog, "color");
+	renderer->shaders.ellipse.lut_enabled = glGetUniformLocation(prog, "lut_enabled");
+	renderer->shaders.ellipse.lut = glGetUniformLocation(prog, "lut");
+	renderer->shaders.ellipse.pos_attrib = glGetAttribLocation(prog, "pos");
+	renderer->shaders.ellipse.tex_attrib = glGetAttribLocation(prog, "texcoord");
+
+	renderer->shaders.tex_rgba.program = prog =
+		finish_program(renderer, &renderer->pending_shaders.tex_rgba);
+	if (!renderer->shaders.tex_rgba.program) {
+		goto error;
+	}
+	renderer->shaders.tex_rgba.proj = glGetUniformLocation(prog, "proj");
+	renderer->shaders.tex_rgba.invert_y = glGetUniformLocation(prog, "invert_y");
+	renderer->shaders.tex_rgba.tex = glGetUniformLocation(prog, "tex");
+	renderer->shaders.tex_rgba.alpha = glGetUniformLocation(prog, "alpha");
+	renderer->shaders.tex_rgba.lut_enabled = glGetUniformLocation(prog, "lut_enabled");
+	renderer->shaders.tex_rgba.lut = glGetUniformLocation(prog, "lut");
+	renderer->shaders.tex_rgba.pos_attrib = glGetAttribLocation(prog, "pos");
+	renderer->shaders.tex_rgba.tex_attrib = glGetAttribLocation(prog, "texcoord");
+
+	renderer->shaders.tex_rgbx.program = prog =
+		finish_program(renderer, &renderer->pending_shaders.tex_rgbx);
+	if (!renderer->shaders.tex_rgbx.program) {
+		goto error;
+	}
+	renderer->shaders.tex_rgbx.proj = glGetUniformLocation(prog, "proj");
+	renderer->shaders.tex_rgbx.invert_y = glGetUniformLocation(prog, "invert_y");
+	renderer->shaders.tex_rgbx.tex = glGetUniformLocation(prog, "tex");
+	renderer->shaders.tex_rgbx.alpha = glGetUniformLocation(prog, "alpha");
+	renderer->shaders.tex_rgbx.lut_enabled = glGetUniformLocation(prog, "lut_enabled");
+	renderer->shaders.tex_rgbx.lut = glGetUniformLocation(prog, "lut");
+	renderer->shaders.tex_rgbx.pos_attrib = glGetAttribLocation(prog, "pos");
+	renderer->shaders.tex_rgbx.tex_attrib = glGetAttribLocation(prog, "texcoord");
+
+	renderer->shaders.tex_swap_rgba.program = prog =
+		finish_program(renderer, &renderer->pending_shaders.tex_swap_rgba);
+	if (!renderer->shaders.tex_swap_rgba.program) {
+		goto error;
+	}
+	renderer->shaders.tex_swap_rgba.proj = glGetUniformLocation(prog, "proj");
+	renderer->shaders.tex_swap_rgba.invert_y = glGetUniformLocation(prog, "invert_y");
+	renderer->shaders.tex_swap_rgba.tex = glGetUniformLocation(prog, "tex");
+	renderer->shaders.tex_swap_rgba.alpha = glGetUniformLocation(prog, "alpha");
+	renderer->shaders.tex_swap_rgba.lut_enabled = glGetUniformLocation(prog, "lut_enabled");
+	renderer->shaders.tex_swap_rgba.lut = glGetUniformLocation(prog, "lut");
+	renderer->shaders.tex_swap_rgba.pos_attrib = glGetAttribLocation(prog, "pos");
+	renderer->shaders.tex_swap_rgba.tex_attrib = glGetAttribLocation(prog, "texcoord");
+
+	if (renderer->exts.egl_image_external_oes) {
+		renderer->shaders.tex_ext.program = prog =
+			finish_program(renderer, &renderer->pending_shaders.tex_ext);
+		if (!renderer->shaders.tex_ext.program) {
+			goto error;
+		}
+		renderer->shaders.tex_ext.proj = glGetUniformLocation(prog, "proj");
+		renderer->shaders.tex_ext.invert_y = glGetUniformLocation(prog, "invert_y");
+		renderer->shaders.tex_ext.tex = glGetUniformLocation(prog, "tex");
+		renderer->shaders.tex_ext.alpha = glGetUniformLocation(prog, "alpha");
+		renderer->shaders.tex_ext.lut_enabled = glGetUniformLocation(prog, "lut_enabled");
+		renderer->shaders.tex_ext.lut = glGetUniformLocation(prog, "lut");
+		renderer->shaders.tex_ext.pos_attrib = glGetAttribLocation(prog, "pos");
+		renderer->shaders.tex_ext.tex_attrib = glGetAttribLocation(prog, "texcoord");
+	}
+
+	pop_gles2_debug(renderer);
+
+	renderer->pending_shaders.ok = true;
+	return true;
+
+error:
+	pop_gles2_debug(renderer);
+	wlr_log(WLR_ERROR, "Failed to link shader program");
+	return false;
+}
+
 struct wlr_renderer *wlr_gles2_renderer_create(struct wlr_egl *egl) {
 	if (!wlr_egl_make_current(egl)) {
 		return NULL;
@@ -884,6 +2174,10 @@ struct wlr_renderer *wlr_gles2_renderer_create(struct wlr_egl *egl) {
 	wlr_renderer_init(&renderer->wlr_renderer, &renderer_impl);
 
 	wl_list_init(&renderer->buffers);
+	wl_list_init(&renderer->async_reads);
+	wl_list_init(&renderer->atlases);
+	wl_list_init(&renderer->dmabuf_images);
+	wl_list_init(&renderer->tex_pool);
 
 	renderer->egl = egl;
 	renderer->exts_str = exts_str;
@@ -922,12 +2216,64 @@ struct wlr_renderer *wlr_gles2_renderer_create(struct wlr_egl *egl) {
 			"glEGLImageTargetTexture2DOES");
 	}
 
+	if (check_gl_ext(exts_str, "GL_EXT_disjoint_timer_query")) {
+		renderer->exts.disjoint_timer_query_ext = true;
+		load_gl_proc(&renderer->procs.glGenQueriesEXT, "glGenQueriesEXT");
+		load_gl_proc(&renderer->procs.glDeleteQueriesEXT, "glDeleteQueriesEXT");
+		load_gl_proc(&renderer->procs.glBeginQueryEXT, "glBeginQueryEXT");
+		load_gl_proc(&renderer->procs.glEndQueryEXT, "glEndQueryEXT");
+		load_gl_proc(&renderer->procs.glGetQueryObjectuivEXT,
+			"glGetQueryObjectuivEXT");
+		load_gl_proc(&renderer->procs.glGetQueryObjectui64vEXT,
+			"glGetQueryObjectui64vEXT");
+	}
+
+	renderer->exts.pixel_buffer_object_nv =
+		check_gl_ext(exts_str, "GL_NV_pixel_buffer_object");
+
+	// Mipmap generation for non-power-of-two textures needs full NPOT
+	// support, GLES2 core only mandates NPOT at level zero
+	renderer->exts.texture_npot_oes =
+		check_gl_ext(exts_str, "GL_OES_texture_npot");
+
+	if (check_gl_ext(exts_str, "GL_EXT_map_buffer_range") &&
+			check_gl_ext(exts_str, "GL_OES_mapbuffer")) {
+		renderer->exts.map_buffer_range_ext = true;
+		load_gl_proc(&renderer->procs.glMapBufferRangeEXT,
+			"glMapBufferRangeEXT");
+		load_gl_proc(&renderer->procs.glUnmapBufferOES, "glUnmapBufferOES");
+	}
+
+	if (check_gl_ext(exts_str, "GL_OES_get_program_binary")) {
+		GLint num_formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &num_formats);
+		if (num_formats > 0) {
+			renderer->exts.get_program_binary_oes = true;
+			load_gl_proc(&renderer->procs.glGetProgramBinaryOES,
+				"glGetProgramBinaryOES");
+			load_gl_proc(&renderer->procs.glProgramBinaryOES,
+				"glProgramBinaryOES");
+		}
+	}
+
+	if (check_gl_ext(exts_str, "GL_KHR_parallel_shader_compile")) {
+		renderer->exts.parallel_shader_compile_khr = true;
+		load_gl_proc(&renderer->procs.glMaxShaderCompilerThreadsKHR,
+			"glMaxShaderCompilerThreadsKHR");
+		// Let the driver pick how many compiler threads to use
+		renderer->procs.glMaxShaderCompilerThreadsKHR(0xffffffff);
+	}
+
 	if (check_gl_ext(exts_str, "GL_OES_EGL_image")) {
 		renderer->exts.egl_image_oes = true;
 		load_gl_proc(&renderer->procs.glEGLImageTargetRenderbufferStorageOES,
 			"glEGLImageTargetRenderbufferStorageOES");
 	}
 
+	if (!gles2_upload_thread_init(renderer)) {
+		wlr_log(WLR_INFO, "Texture uploads will happen on the main thread");
+	}
+
 	if (renderer->exts.debug_khr) {
 		glEnable(GL_DEBUG_OUTPUT_KHR);
 		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_KHR);
@@ -942,62 +2288,22 @@ struct wlr_renderer *wlr_gles2_renderer_create(struct wlr_egl *egl) {
 
 	push_gles2_debug(renderer);
 
-	GLuint prog;
-	renderer->shaders.quad.program = prog =
-		link_program(renderer, quad_vertex_src, quad_fragment_src);
-	if (!renderer->shaders.quad.program) {
-		goto error;
-	}
-	renderer->shaders.quad.proj = glGetUniformLocation(prog, "proj");
-	renderer->shaders.quad.color = glGetUniformLocation(prog, "color");
-	renderer->shaders.quad.pos_attrib = glGetAttribLocation(prog, "pos");
-
-	renderer->shaders.ellipse.program = prog =
-		link_program(renderer, quad_vertex_src, ellipse_fragment_src);
-	if (!renderer->shaders.ellipse.program) {
-		goto error;
-	}
-	renderer->shaders.ellipse.proj = glGetUniformLocation(prog, "proj");
-	renderer->shaders.ellipse.color = glGetUniformLocation(prog, "color");
-	renderer->shaders.ellipse.pos_attrib = glGetAttribLocation(prog, "pos");
-	renderer->shaders.ellipse.tex_attrib = glGetAttribLocation(prog, "texcoord");
-
-	renderer->shaders.tex_rgba.program = prog =
-		link_program(renderer, tex_vertex_src, tex_fragment_src_rgba);
-	if (!renderer->shaders.tex_rgba.program) {
-		goto error;
-	}
-	renderer->shaders.tex_rgba.proj = glGetUniformLocation(prog, "proj");
-	renderer->shaders.tex_rgba.invert_y = glGetUniformLocation(prog, "invert_y");
-	renderer->shaders.tex_rgba.tex = glGetUniformLocation(prog, "tex");
-	renderer->shaders.tex_rgba.alpha = glGetUniformLocation(prog, "alpha");
-	renderer->shaders.tex_rgba.pos_attrib = glGetAttribLocation(prog, "pos");
-	renderer->shaders.tex_rgba.tex_attrib = glGetAttribLocation(prog, "texcoord");
-
-	renderer->shaders.tex_rgbx.program = prog =
-		link_program(renderer, tex_vertex_src, tex_fragment_src_rgbx);
-	if (!renderer->shaders.tex_rgbx.program) {
-		goto error;
-	}
-	renderer->shaders.tex_rgbx.proj = glGetUniformLocation(prog, "proj");
-	renderer->shaders.tex_rgbx.invert_y = glGetUniformLocation(prog, "invert_y");
-	renderer->shaders.tex_rgbx.tex = glGetUniformLocation(prog, "tex");
-	renderer->shaders.tex_rgbx.alpha = glGetUniformLocation(prog, "alpha");
-	renderer->shaders.tex_rgbx.pos_attrib = glGetAttribLocation(prog, "pos");
-	renderer->shaders.tex_rgbx.tex_attrib = glGetAttribLocation(prog, "texcoord");
-
+	// Issue all program links up front and only collect the results on first
+	// use: with GL_KHR_parallel_shader_compile the driver compiles them
+	// concurrently while the backend finishes starting up
+	start_program(renderer, &renderer->pending_shaders.quad,
+		quad_vertex_src, quad_fragment_src);
+	start_program(renderer, &renderer->pending_shaders.ellipse,
+		quad_vertex_src, ellipse_fragment_src);
+	start_program(renderer, &renderer->pending_shaders.tex_rgba,
+		tex_vertex_src, tex_fragment_src_rgba);
+	start_program(renderer, &renderer->pending_shaders.tex_rgbx,
+		tex_vertex_src, tex_fragment_src_rgbx);
+	start_program(renderer, &renderer->pending_shaders.tex_swap_rgba,
+		tex_vertex_src, tex_fragment_src_swap_rgba);
 	if (renderer->exts.egl_image_external_oes) {
-		renderer->shaders.tex_ext.program = prog =
-			link_program(renderer, tex_vertex_src, tex_fragment_src_external);
-		if (!renderer->shaders.tex_ext.program) {
-			goto error;
-		}
-		renderer->shaders.tex_ext.proj = glGetUniformLocation(prog, "proj");
-		renderer->shaders.tex_ext.invert_y = glGetUniformLocation(prog, "invert_y");
-		renderer->shaders.tex_ext.tex = glGetUniformLocation(prog, "tex");
-		renderer->shaders.tex_ext.alpha = glGetUniformLocation(prog, "alpha");
-		renderer->shaders.tex_ext.pos_attrib = glGetAttribLocation(prog, "pos");
-		renderer->shaders.tex_ext.tex_attrib = glGetAttribLocation(prog, "texcoord");
+		start_program(renderer, &renderer->pending_shaders.tex_ext,
+			tex_vertex_src, tex_fragment_src_external);
 	}
 
 	pop_gles2_debug(renderer);
@@ -1005,25 +2311,6 @@ struct wlr_renderer *wlr_gles2_renderer_create(struct wlr_egl *egl) {
 	wlr_egl_unset_current(renderer->egl);
 
 	return &renderer->wlr_renderer;
-
-error:
-	glDeleteProgram(renderer->shaders.quad.program);
-	glDeleteProgram(renderer->shaders.ellipse.program);
-	glDeleteProgram(renderer->shaders.tex_rgba.program);
-	glDeleteProgram(renderer->shaders.tex_rgbx.program);
-	glDeleteProgram(renderer->shaders.tex_ext.program);
-
-	pop_gles2_debug(renderer);
-
-	if (renderer->exts.debug_khr) {
-		glDisable(GL_DEBUG_OUTPUT_KHR);
-		renderer->procs.glDebugMessageCallbackKHR(NULL, NULL);
-	}
-
-	wlr_egl_unset_current(renderer->egl);
-
-	free(renderer);
-	return NULL;
 }
 
 bool wlr_gles2_renderer_check_ext(struct wlr_renderer *wlr_renderer,
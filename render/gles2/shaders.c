@@ -1,6 +1,11 @@
 #include <GLES2/gl2.h>
 #include "render/gles2.h"
 
+// Each fragment shader ends with an optional gamma/color LUT stage: a 256x1
+// RGBA texture holding one ramp per channel, applied when lut_enabled is set.
+// This lets night-light style gamma changes happen during the composite pass
+// instead of going through the KMS gamma property.
+
 // Colored quads
 const GLchar quad_vertex_src[] =
 "uniform mat3 proj;\n"
@@ -20,9 +25,21 @@ const GLchar quad_fragment_src[] =
 "precision mediump float;\n"
 "varying vec4 v_color;\n"
 "varying vec2 v_texcoord;\n"
+"uniform bool lut_enabled;\n"
+"uniform sampler2D lut;\n"
+"\n"
+"vec3 apply_lut(vec3 color) {\n"
+"	return vec3(\n"
+"		texture2D(lut, vec2((color.r * 255.0 + 0.5) / 256.0, 0.5)).r,\n"
+"		texture2D(lut, vec2((color.g * 255.0 + 0.5) / 256.0, 0.5)).g,\n"
+"		texture2D(lut, vec2((color.b * 255.0 + 0.5) / 256.0, 0.5)).b);\n"
+"}\n"
 "\n"
 "void main() {\n"
 "	gl_FragColor = v_color;\n"
+"	if (lut_enabled) {\n"
+"		gl_FragColor.rgb = apply_lut(gl_FragColor.rgb);\n"
+"	}\n"
 "}\n";
 
 // Colored ellipses
@@ -30,6 +47,15 @@ const GLchar ellipse_fragment_src[] =
 "precision mediump float;\n"
 "varying vec4 v_color;\n"
 "varying vec2 v_texcoord;\n"
+"uniform bool lut_enabled;\n"
+"uniform sampler2D lut;\n"
+"\n"
+"vec3 apply_lut(vec3 color) {\n"
+"	return vec3(\n"
+"		texture2D(lut, vec2((color.r * 255.0 + 0.5) / 256.0, 0.5)).r,\n"
+"		texture2D(lut, vec2((color.g * 255.0 + 0.5) / 256.0, 0.5)).g,\n"
+"		texture2D(lut, vec2((color.b * 255.0 + 0.5) / 256.0, 0.5)).b);\n"
+"}\n"
 "\n"
 "void main() {\n"
 "	float l = length(v_texcoord - vec2(0.5, 0.5));\n"
@@ -37,6 +63,9 @@ const GLchar ellipse_fragment_src[] =
 "		discard;\n"
 "	}\n"
 "	gl_FragColor = v_color;\n"
+"	if (lut_enabled) {\n"
+"		gl_FragColor.rgb = apply_lut(gl_FragColor.rgb);\n"
+"	}\n"
 "}\n";
 
 // Textured quads
@@ -61,9 +90,22 @@ const GLchar tex_fragment_src_rgba[] =
 "varying vec2 v_texcoord;\n"
 "uniform sampler2D tex;\n"
 "uniform float alpha;\n"
+"uniform bool lut_enabled;\n"
+"uniform sampler2D lut;\n"
+"\n"
+"vec3 apply_lut(vec3 color) {\n"
+"	return vec3(\n"
+"		texture2D(lut, vec2((color.r * 255.0 + 0.5) / 256.0, 0.5)).r,\n"
+"		texture2D(lut, vec2((color.g * 255.0 + 0.5) / 256.0, 0.5)).g,\n"
+"		texture2D(lut, vec2((color.b * 255.0 + 0.5) / 256.0, 0.5)).b);\n"
+"}\n"
 "\n"
 "void main() {\n"
-"	gl_FragColor = texture2D(tex, v_texcoord) * alpha;\n"
+"	vec4 color = texture2D(tex, v_texcoord);\n"
+"	if (lut_enabled) {\n"
+"		color.rgb = apply_lut(color.rgb);\n"
+"	}\n"
+"	gl_FragColor = color * alpha;\n"
 "}\n";
 
 const GLchar tex_fragment_src_rgbx[] =
@@ -71,9 +113,47 @@ const GLchar tex_fragment_src_rgbx[] =
 "varying vec2 v_texcoord;\n"
 "uniform sampler2D tex;\n"
 "uniform float alpha;\n"
+"uniform bool lut_enabled;\n"
+"uniform sampler2D lut;\n"
+"\n"
+"vec3 apply_lut(vec3 color) {\n"
+"	return vec3(\n"
+"		texture2D(lut, vec2((color.r * 255.0 + 0.5) / 256.0, 0.5)).r,\n"
+"		texture2D(lut, vec2((color.g * 255.0 + 0.5) / 256.0, 0.5)).g,\n"
+"		texture2D(lut, vec2((color.b * 255.0 + 0.5) / 256.0, 0.5)).b);\n"
+"}\n"
 "\n"
 "void main() {\n"
-"	gl_FragColor = vec4(texture2D(tex, v_texcoord).rgb, 1.0) * alpha;\n"
+"	vec4 color = vec4(texture2D(tex, v_texcoord).rgb, 1.0);\n"
+"	if (lut_enabled) {\n"
+"		color.rgb = apply_lut(color.rgb);\n"
+"	}\n"
+"	gl_FragColor = color * alpha;\n"
+"}\n";
+
+// Red/blue swapped, for GPU-side conversion to BGRA byte orders during pixel
+// readback when GL_EXT_read_format_bgra is unavailable
+const GLchar tex_fragment_src_swap_rgba[] =
+"precision mediump float;\n"
+"varying vec2 v_texcoord;\n"
+"uniform sampler2D tex;\n"
+"uniform float alpha;\n"
+"uniform bool lut_enabled;\n"
+"uniform sampler2D lut;\n"
+"\n"
+"vec3 apply_lut(vec3 color) {\n"
+"	return vec3(\n"
+"		texture2D(lut, vec2((color.r * 255.0 + 0.5) / 256.0, 0.5)).r,\n"
+"		texture2D(lut, vec2((color.g * 255.0 + 0.5) / 256.0, 0.5)).g,\n"
+"		texture2D(lut, vec2((color.b * 255.0 + 0.5) / 256.0, 0.5)).b);\n"
+"}\n"
+"\n"
+"void main() {\n"
+"	vec4 color = texture2D(tex, v_texcoord).bgra;\n"
+"	if (lut_enabled) {\n"
+"		color.rgb = apply_lut(color.rgb);\n"
+"	}\n"
+"	gl_FragColor = color * alpha;\n"
 "}\n";
 
 const GLchar tex_fragment_src_external[] =
@@ -82,7 +162,20 @@ const GLchar tex_fragment_src_external[] =
 "varying vec2 v_texcoord;\n"
 "uniform samplerExternalOES texture0;\n"
 "uniform float alpha;\n"
+"uniform bool lut_enabled;\n"
+"uniform sampler2D lut;\n"
+"\n"
+"vec3 apply_lut(vec3 color) {\n"
+"	return vec3(\n"
+"		texture2D(lut, vec2((color.r * 255.0 + 0.5) / 256.0, 0.5)).r,\n"
+"		texture2D(lut, vec2((color.g * 255.0 + 0.5) / 256.0, 0.5)).g,\n"
+"		texture2D(lut, vec2((color.b * 255.0 + 0.5) / 256.0, 0.5)).b);\n"
+"}\n"
 "\n"
 "void main() {\n"
-"	gl_FragColor = texture2D(texture0, v_texcoord) * alpha;\n"
+"	vec4 color = texture2D(texture0, v_texcoord);\n"
+"	if (lut_enabled) {\n"
+"		color.rgb = apply_lut(color.rgb);\n"
+"	}\n"
+"	gl_FragColor = color * alpha;\n"
 "}\n";
@@ -4,6 +4,7 @@
 #include <GLES2/gl2ext.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #include <wayland-server-protocol.h>
 #include <wayland-util.h>
 #include <wlr/render/egl.h>
@@ -12,6 +13,7 @@
 #include <wlr/types/wlr_matrix.h>
 #include <wlr/util/log.h>
 #include "render/gles2.h"
+#include "util/gpu_memory.h"
 #include "util/signal.h"
 
 static const struct wlr_texture_impl texture_impl;
@@ -48,24 +50,114 @@ static bool gles2_texture_write_pixels(struct wlr_texture *wlr_texture,
 
 	struct wlr_egl_context prev_ctx;
 	wlr_egl_save_context(&prev_ctx);
-	wlr_egl_make_current(texture->renderer->egl);
+	gles2_make_current(texture->renderer);
+
+	gles2_texture_sync_upload(texture);
 
 	push_gles2_debug(texture->renderer);
 
-	glBindTexture(GL_TEXTURE_2D, texture->tex);
+	uint32_t off_x = 0, off_y = 0;
+	GLuint tex = texture->tex;
+	if (texture->atlas != NULL) {
+		tex = texture->atlas->tex;
+		off_x = texture->atlas_x;
+		off_y = texture->atlas_y;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, tex);
 
 	glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride / (fmt->bpp / 8));
 	glPixelStorei(GL_UNPACK_SKIP_PIXELS_EXT, src_x);
 	glPixelStorei(GL_UNPACK_SKIP_ROWS_EXT, src_y);
 
-	glTexSubImage2D(GL_TEXTURE_2D, 0, dst_x, dst_y, width, height,
-		fmt->gl_format, fmt->gl_type, data);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, off_x + dst_x, off_y + dst_y, width,
+		height, fmt->gl_format, fmt->gl_type, data);
+	texture->renderer->stats.bytes_uploaded +=
+		(uint64_t)width * height * fmt->bpp / 8;
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+	glPixelStorei(GL_UNPACK_SKIP_PIXELS_EXT, 0);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS_EXT, 0);
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	gles2_invalidate_gl_state(texture->renderer);
+
+	texture->mipmaps_dirty = true;
+
+	pop_gles2_debug(texture->renderer);
+
+	wlr_egl_restore_context(&prev_ctx);
+
+	return true;
+}
+
+static bool gles2_texture_write_pixels_region(struct wlr_texture *wlr_texture,
+		uint32_t stride, pixman_region32_t *region, const void *data) {
+	struct wlr_gles2_texture *texture = gles2_get_texture(wlr_texture);
+
+	if (texture->target != GL_TEXTURE_2D) {
+		wlr_log(WLR_ERROR, "Cannot write pixels to immutable texture");
+		return false;
+	}
+
+	const struct wlr_gles2_pixel_format *fmt =
+		get_gles2_format_from_wl(texture->wl_format);
+	assert(fmt);
+
+	struct wlr_egl_context prev_ctx;
+	wlr_egl_save_context(&prev_ctx);
+	gles2_make_current(texture->renderer);
+
+	gles2_texture_sync_upload(texture);
+
+	push_gles2_debug(texture->renderer);
+
+	uint32_t off_x = 0, off_y = 0;
+	GLuint tex = texture->tex;
+	if (texture->atlas != NULL) {
+		tex = texture->atlas->tex;
+		off_x = texture->atlas_x;
+		off_y = texture->atlas_y;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, tex);
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride / (fmt->bpp / 8));
+
+	int rects_len;
+	pixman_box32_t *rects = pixman_region32_rectangles(region, &rects_len);
+	for (int i = 0; i < rects_len; ++i) {
+		pixman_box32_t rect = rects[i];
+
+		// Coalesce vertically adjacent rectangles spanning the same columns
+		// into a single upload
+		while (i + 1 < rects_len && rects[i + 1].x1 == rect.x1 &&
+				rects[i + 1].x2 == rect.x2 && rects[i + 1].y1 == rect.y2) {
+			rect.y2 = rects[i + 1].y2;
+			++i;
+		}
+
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS_EXT, rect.x1);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS_EXT, rect.y1);
+
+		glTexSubImage2D(GL_TEXTURE_2D, 0, off_x + rect.x1, off_y + rect.y1,
+			rect.x2 - rect.x1, rect.y2 - rect.y1,
+			fmt->gl_format, fmt->gl_type, data);
+		texture->renderer->stats.bytes_uploaded +=
+			(uint64_t)(rect.x2 - rect.x1) * (rect.y2 - rect.y1) * fmt->bpp / 8;
+	}
 
 	glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
 	glPixelStorei(GL_UNPACK_SKIP_PIXELS_EXT, 0);
 	glPixelStorei(GL_UNPACK_SKIP_ROWS_EXT, 0);
 
 	glBindTexture(GL_TEXTURE_2D, 0);
+	gles2_invalidate_gl_state(texture->renderer);
+
+	// An empty damage region leaves the mip chain valid
+	if (rects_len > 0) {
+		texture->mipmaps_dirty = true;
+	}
 
 	pop_gles2_debug(texture->renderer);
 
@@ -74,10 +166,156 @@ static bool gles2_texture_write_pixels(struct wlr_texture *wlr_texture,
 	return true;
 }
 
+static void dmabuf_image_destroy(struct wlr_gles2_renderer *renderer,
+		struct wlr_gles2_dmabuf_image *dmabuf_image) {
+	glDeleteTextures(1, &dmabuf_image->tex);
+	wlr_egl_destroy_image(renderer->egl, dmabuf_image->image);
+	gles2_invalidate_gl_state(renderer);
+	gpu_memory_sub(WLR_GPU_MEMORY_DMABUF_TEXTURE, dmabuf_image->mem_bytes);
+	wl_list_remove(&dmabuf_image->link);
+	free(dmabuf_image);
+}
+
+void gles2_dmabuf_image_unref(struct wlr_gles2_renderer *renderer,
+		struct wlr_gles2_dmabuf_image *dmabuf_image) {
+	assert(dmabuf_image->n_refs > 0);
+	if (--dmabuf_image->n_refs > 0) {
+		return;
+	}
+
+	// Keep a bounded number of unreferenced imports around: clients cycle
+	// through a small set of buffers and will import this one again shortly
+	size_t n_unref = 0;
+	struct wlr_gles2_dmabuf_image *it, *tmp;
+	wl_list_for_each_safe(it, tmp, &renderer->dmabuf_images, link) {
+		if (it->n_refs > 0) {
+			continue;
+		}
+		++n_unref;
+		if (n_unref > WLR_GLES2_DMABUF_CACHE_SIZE) {
+			dmabuf_image_destroy(renderer, it);
+		}
+	}
+}
+
+void gles2_dmabuf_cache_destroy_all(struct wlr_gles2_renderer *renderer) {
+	struct wlr_gles2_dmabuf_image *dmabuf_image, *tmp;
+	wl_list_for_each_safe(dmabuf_image, tmp, &renderer->dmabuf_images, link) {
+		dmabuf_image_destroy(renderer, dmabuf_image);
+	}
+}
+
+// Looks up a previous import of the same dma-buf. The buffer is identified
+// by the first plane's inode: dup'ed FDs of one dma-buf share it, and it is
+// unique among live dma-bufs.
+static struct wlr_gles2_dmabuf_image *dmabuf_image_get(
+		struct wlr_gles2_renderer *renderer,
+		struct wlr_dmabuf_attributes *attribs) {
+	struct stat st;
+	if (fstat(attribs->fd[0], &st) != 0) {
+		return NULL;
+	}
+
+	struct wlr_gles2_dmabuf_image *dmabuf_image;
+	wl_list_for_each(dmabuf_image, &renderer->dmabuf_images, link) {
+		if (dmabuf_image->dev == st.st_dev &&
+				dmabuf_image->inode == st.st_ino &&
+				dmabuf_image->format == attribs->format &&
+				dmabuf_image->modifier == attribs->modifier &&
+				dmabuf_image->width == attribs->width &&
+				dmabuf_image->height == attribs->height) {
+			++dmabuf_image->n_refs;
+			// Keep the list most-recently-used first
+			wl_list_remove(&dmabuf_image->link);
+			wl_list_insert(&renderer->dmabuf_images, &dmabuf_image->link);
+			return dmabuf_image;
+		}
+	}
+
+	return NULL;
+}
+
+static void tex_pool_entry_destroy(struct wlr_gles2_renderer *renderer,
+		struct wlr_gles2_tex_pool_entry *entry) {
+	glDeleteTextures(1, &entry->tex);
+	// The name may be handed out again, invalidating the shadowed bindings
+	gles2_invalidate_gl_state(renderer);
+	gpu_memory_sub(WLR_GPU_MEMORY_SHM_TEXTURE, entry->mem_bytes);
+	wl_list_remove(&entry->link);
+	free(entry);
+}
+
+GLuint gles2_tex_pool_get(struct wlr_gles2_renderer *renderer,
+		GLint gl_format, GLint gl_type, uint32_t width, uint32_t height) {
+	struct wlr_gles2_tex_pool_entry *entry;
+	wl_list_for_each(entry, &renderer->tex_pool, link) {
+		if (entry->gl_format == gl_format && entry->gl_type == gl_type &&
+				entry->width == width && entry->height == height) {
+			GLuint tex = entry->tex;
+			// The new owner accounts the storage itself
+			gpu_memory_sub(WLR_GPU_MEMORY_SHM_TEXTURE, entry->mem_bytes);
+			wl_list_remove(&entry->link);
+			free(entry);
+			return tex;
+		}
+	}
+	return 0;
+}
+
+bool gles2_tex_pool_put(struct wlr_gles2_renderer *renderer, GLuint tex,
+		GLint gl_format, GLint gl_type, uint32_t width, uint32_t height,
+		size_t mem_bytes) {
+	struct wlr_gles2_tex_pool_entry *entry = calloc(1, sizeof(*entry));
+	if (entry == NULL) {
+		return false;
+	}
+
+	entry->gl_format = gl_format;
+	entry->gl_type = gl_type;
+	entry->width = width;
+	entry->height = height;
+	entry->tex = tex;
+	entry->mem_bytes = mem_bytes;
+	wl_list_insert(&renderer->tex_pool, &entry->link);
+	gpu_memory_add(WLR_GPU_MEMORY_SHM_TEXTURE, mem_bytes);
+
+	// Evict the oldest entry beyond the cap; the newest are the most likely
+	// to match an upcoming allocation
+	if (wl_list_length(&renderer->tex_pool) > WLR_GLES2_TEX_POOL_SIZE) {
+		struct wlr_gles2_tex_pool_entry *oldest =
+			wl_container_of(renderer->tex_pool.prev, oldest, link);
+		tex_pool_entry_destroy(renderer, oldest);
+	}
+	return true;
+}
+
+void gles2_tex_pool_age(struct wlr_gles2_renderer *renderer) {
+	struct wlr_gles2_tex_pool_entry *entry, *tmp;
+	wl_list_for_each_safe(entry, tmp, &renderer->tex_pool, link) {
+		if (++entry->frames_unused > WLR_GLES2_TEX_POOL_MAX_AGE) {
+			tex_pool_entry_destroy(renderer, entry);
+		}
+	}
+}
+
+void gles2_tex_pool_destroy_all(struct wlr_gles2_renderer *renderer) {
+	struct wlr_gles2_tex_pool_entry *entry, *tmp;
+	wl_list_for_each_safe(entry, tmp, &renderer->tex_pool, link) {
+		tex_pool_entry_destroy(renderer, entry);
+	}
+}
+
 static bool gles2_texture_to_dmabuf(struct wlr_texture *wlr_texture,
 		struct wlr_dmabuf_attributes *attribs) {
 	struct wlr_gles2_texture *texture = gles2_get_texture(wlr_texture);
 
+	if (texture->atlas != NULL) {
+		// The texture only owns part of the atlas, it can't be exported
+		return false;
+	}
+
+	gles2_texture_sync_upload(texture);
+
 	if (!texture->image) {
 		assert(texture->target == GL_TEXTURE_2D);
 
@@ -111,23 +349,46 @@ static void gles2_texture_destroy(struct wlr_texture *wlr_texture) {
 
 	struct wlr_egl_context prev_ctx;
 	wlr_egl_save_context(&prev_ctx);
-	wlr_egl_make_current(texture->renderer->egl);
+	gles2_make_current(texture->renderer);
+
+	gles2_texture_sync_upload(texture);
 
 	push_gles2_debug(texture->renderer);
 
-	glDeleteTextures(1, &texture->tex);
-	wlr_egl_destroy_image(texture->renderer->egl, texture->image);
+	const struct wlr_gles2_pixel_format *fmt =
+		get_gles2_format_from_wl(texture->wl_format);
+
+	if (texture->atlas != NULL) {
+		gles2_atlas_remove_texture(texture);
+	} else if (texture->dmabuf_image != NULL) {
+		// The texture and EGLImage belong to the shared import
+		gles2_dmabuf_image_unref(texture->renderer, texture->dmabuf_image);
+	} else if (fmt != NULL && texture->tex != 0 &&
+			texture->image == EGL_NO_IMAGE_KHR &&
+			gles2_tex_pool_put(texture->renderer, texture->tex,
+				fmt->gl_format, fmt->gl_type, wlr_texture->width,
+				wlr_texture->height, texture->mem_bytes)) {
+		// The GL texture moved into the recycling pool, ready to back the
+		// next texture of the same size and format
+	} else {
+		glDeleteTextures(1, &texture->tex);
+		wlr_egl_destroy_image(texture->renderer->egl, texture->image);
+	}
+	gles2_invalidate_gl_state(texture->renderer);
 
 	pop_gles2_debug(texture->renderer);
 
 	wlr_egl_restore_context(&prev_ctx);
 
+	gpu_memory_sub(texture->mem_type, texture->mem_bytes);
+
 	free(texture);
 }
 
 static const struct wlr_texture_impl texture_impl = {
 	.is_opaque = gles2_texture_is_opaque,
 	.write_pixels = gles2_texture_write_pixels,
+	.write_pixels_region = gles2_texture_write_pixels_region,
 	.to_dmabuf = gles2_texture_to_dmabuf,
 	.destroy = gles2_texture_destroy,
 };
@@ -154,22 +415,67 @@ struct wlr_texture *gles2_texture_from_pixels(struct wlr_renderer *wlr_renderer,
 	texture->target = GL_TEXTURE_2D;
 	texture->has_alpha = fmt->has_alpha;
 	texture->wl_format = fmt->wl_format;
+	// Atlas-packed textures can't be mipmapped: the chain would blend
+	// neighbouring slots together. The flag is cleared below if the texture
+	// ends up in an atlas.
+	texture->mipmapped = renderer->exts.texture_npot_oes;
+	texture->mipmaps_dirty = true;
+	texture->mem_bytes = (size_t)width * height * (fmt->bpp / 8);
+	texture->mem_type = WLR_GPU_MEMORY_SHM_TEXTURE;
+	gpu_memory_add(texture->mem_type, texture->mem_bytes);
 
 	struct wlr_egl_context prev_ctx;
 	wlr_egl_save_context(&prev_ctx);
-	wlr_egl_make_current(renderer->egl);
+	gles2_make_current(renderer);
 
 	push_gles2_debug(renderer);
 
-	glGenTextures(1, &texture->tex);
-	glBindTexture(GL_TEXTURE_2D, texture->tex);
-
-	glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride / (fmt->bpp / 8));
-	glTexImage2D(GL_TEXTURE_2D, 0, fmt->gl_format, width, height, 0,
-		fmt->gl_format, fmt->gl_type, data);
-	glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+	if (gles2_atlas_add_texture(renderer, texture, fmt)) {
+		texture->mipmapped = false;
+
+		// Small texture: upload into its atlas slot instead of a
+		// dedicated GL texture
+		glBindTexture(GL_TEXTURE_2D, texture->atlas->tex);
+
+		glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride / (fmt->bpp / 8));
+		glTexSubImage2D(GL_TEXTURE_2D, 0, texture->atlas_x,
+			texture->atlas_y, width, height, fmt->gl_format, fmt->gl_type,
+			data);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+	} else {
+		// A recently retired texture of the same size and format can donate
+		// its storage, leaving only the pixel transfer itself
+		GLuint recycled = gles2_tex_pool_get(renderer, fmt->gl_format,
+			fmt->gl_type, width, height);
+
+		if (width >= WLR_GLES2_UPLOAD_THREAD_MIN &&
+				height >= WLR_GLES2_UPLOAD_THREAD_MIN &&
+				gles2_upload_thread_queue(renderer, texture, fmt, stride,
+					width, height, data, recycled)) {
+			// Large texture: the transfer happens on the upload thread and
+			// the texture name is filled in once it completes
+		} else {
+			if (recycled != 0) {
+				texture->tex = recycled;
+			} else {
+				glGenTextures(1, &texture->tex);
+			}
+			glBindTexture(GL_TEXTURE_2D, texture->tex);
+
+			glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride / (fmt->bpp / 8));
+			if (recycled != 0) {
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+					fmt->gl_format, fmt->gl_type, data);
+			} else {
+				glTexImage2D(GL_TEXTURE_2D, 0, fmt->gl_format, width, height,
+					0, fmt->gl_format, fmt->gl_type, data);
+			}
+			glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+		}
+	}
 
 	glBindTexture(GL_TEXTURE_2D, 0);
+	gles2_invalidate_gl_state(renderer);
 
 	pop_gles2_debug(renderer);
 
@@ -188,7 +494,7 @@ struct wlr_texture *gles2_texture_from_wl_drm(struct wlr_renderer *wlr_renderer,
 
 	struct wlr_egl_context prev_ctx;
 	wlr_egl_save_context(&prev_ctx);
-	wlr_egl_make_current(renderer->egl);
+	gles2_make_current(renderer);
 
 	EGLint fmt;
 	int width, height;
@@ -235,6 +541,12 @@ struct wlr_texture *gles2_texture_from_wl_drm(struct wlr_renderer *wlr_renderer,
 	renderer->procs.glEGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES,
 		texture->image);
 	glBindTexture(GL_TEXTURE_EXTERNAL_OES, 0);
+	gles2_invalidate_gl_state(renderer);
+
+	// The actual stride and format are the client's business; estimate
+	texture->mem_bytes = (size_t)width * height * 4;
+	texture->mem_type = WLR_GPU_MEMORY_DMABUF_TEXTURE;
+	gpu_memory_add(texture->mem_type, texture->mem_bytes);
 
 	pop_gles2_debug(renderer);
 
@@ -291,9 +603,18 @@ struct wlr_texture *gles2_texture_from_dmabuf(struct wlr_renderer *wlr_renderer,
 	texture->inverted_y =
 		(attribs->flags & WLR_DMABUF_ATTRIBUTES_FLAGS_Y_INVERT) != 0;
 
+	texture->dmabuf_image = dmabuf_image_get(renderer, attribs);
+	if (texture->dmabuf_image != NULL) {
+		// The buffer was imported before: reuse its EGLImage and texture
+		texture->target = texture->dmabuf_image->target;
+		texture->tex = texture->dmabuf_image->tex;
+		texture->image = texture->dmabuf_image->image;
+		return &texture->wlr_texture;
+	}
+
 	struct wlr_egl_context prev_ctx;
 	wlr_egl_save_context(&prev_ctx);
-	wlr_egl_make_current(renderer->egl);
+	gles2_make_current(renderer);
 
 	bool external_only;
 	texture->image =
@@ -313,17 +634,52 @@ struct wlr_texture *gles2_texture_from_dmabuf(struct wlr_renderer *wlr_renderer,
 	glBindTexture(texture->target, texture->tex);
 	renderer->procs.glEGLImageTargetTexture2DOES(texture->target, texture->image);
 	glBindTexture(texture->target, 0);
+	gles2_invalidate_gl_state(renderer);
 
 	pop_gles2_debug(renderer);
 
 	wlr_egl_restore_context(&prev_ctx);
 
+	// The buffer's planes may add up to more, but the first plane dominates
+	size_t mem_bytes = (size_t)attribs->width * attribs->height * 4;
+
+	// Cache the import, so that the next commit of the same buffer doesn't
+	// pay for it again. Failure to cache isn't an error: the texture then
+	// simply owns the import itself.
+	struct stat st;
+	if (fstat(attribs->fd[0], &st) == 0) {
+		struct wlr_gles2_dmabuf_image *dmabuf_image =
+			calloc(1, sizeof(*dmabuf_image));
+		if (dmabuf_image != NULL) {
+			dmabuf_image->dev = st.st_dev;
+			dmabuf_image->inode = st.st_ino;
+			dmabuf_image->format = attribs->format;
+			dmabuf_image->modifier = attribs->modifier;
+			dmabuf_image->width = attribs->width;
+			dmabuf_image->height = attribs->height;
+			dmabuf_image->image = texture->image;
+			dmabuf_image->tex = texture->tex;
+			dmabuf_image->target = texture->target;
+			dmabuf_image->n_refs = 1;
+			dmabuf_image->mem_bytes = mem_bytes;
+			wl_list_insert(&renderer->dmabuf_images, &dmabuf_image->link);
+			texture->dmabuf_image = dmabuf_image;
+		}
+	}
+	if (texture->dmabuf_image == NULL) {
+		// Not cached: the texture owns the import, so it carries the bytes
+		texture->mem_bytes = mem_bytes;
+		texture->mem_type = WLR_GPU_MEMORY_DMABUF_TEXTURE;
+	}
+	gpu_memory_add(WLR_GPU_MEMORY_DMABUF_TEXTURE, mem_bytes);
+
 	return &texture->wlr_texture;
 }
 
 void wlr_gles2_texture_get_attribs(struct wlr_texture *wlr_texture,
 		struct wlr_gles2_texture_attribs *attribs) {
 	struct wlr_gles2_texture *texture = gles2_get_texture(wlr_texture);
+	gles2_texture_sync_upload(texture);
 	memset(attribs, 0, sizeof(*attribs));
 	attribs->target = texture->target;
 	attribs->tex = texture->tex;
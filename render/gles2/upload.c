@@ -0,0 +1,200 @@
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-util.h>
+#include <wlr/render/egl.h>
+#include <wlr/util/log.h>
+#include "render/gles2.h"
+
+static void *upload_thread_run(void *data) {
+	struct wlr_gles2_renderer *renderer = data;
+
+	// If the shared context can't be made current, still drain the queue so
+	// that waiters don't deadlock; their uploads just fail
+	bool ctx_ok = wlr_egl_make_upload_current(renderer->egl);
+
+	pthread_mutex_lock(&renderer->upload.mutex);
+	while (!renderer->upload.shutdown) {
+		struct wlr_gles2_upload *upload = NULL, *iter;
+		wl_list_for_each(iter, &renderer->upload.jobs, link) {
+			if (!iter->taken) {
+				upload = iter;
+				break;
+			}
+		}
+		if (upload == NULL) {
+			pthread_cond_wait(&renderer->upload.cond, &renderer->upload.mutex);
+			continue;
+		}
+		upload->taken = true;
+		pthread_mutex_unlock(&renderer->upload.mutex);
+
+		GLuint tex = 0;
+		EGLSyncKHR sync = EGL_NO_SYNC_KHR;
+		if (ctx_ok) {
+			// Texture names are shared between the two contexts, so a
+			// recycled texture can be filled here as well
+			if (upload->recycled_tex != 0) {
+				tex = upload->recycled_tex;
+			} else {
+				glGenTextures(1, &tex);
+			}
+			glBindTexture(GL_TEXTURE_2D, tex);
+
+			glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT,
+				upload->stride / (upload->fmt->bpp / 8));
+			if (upload->recycled_tex != 0) {
+				glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+					upload->width, upload->height, upload->fmt->gl_format,
+					upload->fmt->gl_type, upload->data);
+			} else {
+				glTexImage2D(GL_TEXTURE_2D, 0, upload->fmt->gl_format,
+					upload->width, upload->height, 0, upload->fmt->gl_format,
+					upload->fmt->gl_type, upload->data);
+			}
+			glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			// The fence lets the main context wait for exactly this upload.
+			// Without fences, fall back to a full glFinish.
+			sync = wlr_egl_create_sync(renderer->egl);
+			if (sync != EGL_NO_SYNC_KHR) {
+				glFlush();
+			} else {
+				glFinish();
+			}
+		}
+
+		pthread_mutex_lock(&renderer->upload.mutex);
+		upload->tex = tex;
+		upload->sync = sync;
+		upload->done = true;
+		pthread_cond_broadcast(&renderer->upload.cond);
+	}
+	pthread_mutex_unlock(&renderer->upload.mutex);
+
+	if (ctx_ok) {
+		wlr_egl_unset_upload_current(renderer->egl);
+	}
+	return NULL;
+}
+
+bool gles2_upload_thread_init(struct wlr_gles2_renderer *renderer) {
+	if (!wlr_egl_create_upload_context(renderer->egl)) {
+		return false;
+	}
+
+	wl_list_init(&renderer->upload.jobs);
+	pthread_mutex_init(&renderer->upload.mutex, NULL);
+	pthread_cond_init(&renderer->upload.cond, NULL);
+
+	if (pthread_create(&renderer->upload.thread, NULL, upload_thread_run,
+			renderer) != 0) {
+		wlr_log(WLR_ERROR, "Failed to start texture upload thread");
+		pthread_mutex_destroy(&renderer->upload.mutex);
+		pthread_cond_destroy(&renderer->upload.cond);
+		return false;
+	}
+
+	renderer->upload.started = true;
+	wlr_log(WLR_DEBUG, "Started texture upload thread");
+	return true;
+}
+
+bool gles2_upload_thread_queue(struct wlr_gles2_renderer *renderer,
+		struct wlr_gles2_texture *texture,
+		const struct wlr_gles2_pixel_format *fmt, uint32_t stride,
+		uint32_t width, uint32_t height, const void *data,
+		GLuint recycled_tex) {
+	if (!renderer->upload.started) {
+		return false;
+	}
+
+	struct wlr_gles2_upload *upload = calloc(1, sizeof(*upload));
+	if (upload == NULL) {
+		wlr_log_errno(WLR_ERROR, "Allocation failed");
+		return false;
+	}
+	upload->data = malloc((size_t)stride * height);
+	if (upload->data == NULL) {
+		wlr_log_errno(WLR_ERROR, "Allocation failed");
+		free(upload);
+		return false;
+	}
+	memcpy(upload->data, data, (size_t)stride * height);
+
+	upload->texture = texture;
+	upload->fmt = fmt;
+	upload->stride = stride;
+	upload->width = width;
+	upload->height = height;
+	upload->recycled_tex = recycled_tex;
+	upload->sync = EGL_NO_SYNC_KHR;
+
+	pthread_mutex_lock(&renderer->upload.mutex);
+	wl_list_insert(renderer->upload.jobs.prev, &upload->link);
+	pthread_cond_broadcast(&renderer->upload.cond);
+	pthread_mutex_unlock(&renderer->upload.mutex);
+
+	texture->upload = upload;
+	return true;
+}
+
+void gles2_texture_sync_upload(struct wlr_gles2_texture *texture) {
+	struct wlr_gles2_upload *upload = texture->upload;
+	if (upload == NULL) {
+		return;
+	}
+	struct wlr_gles2_renderer *renderer = texture->renderer;
+
+	pthread_mutex_lock(&renderer->upload.mutex);
+	while (!upload->done) {
+		pthread_cond_wait(&renderer->upload.cond, &renderer->upload.mutex);
+	}
+	wl_list_remove(&upload->link);
+	pthread_mutex_unlock(&renderer->upload.mutex);
+
+	if (upload->sync != EGL_NO_SYNC_KHR) {
+		// Block until the upload context's transfer is visible to ours
+		renderer->egl->procs.eglClientWaitSyncKHR(renderer->egl->display,
+			upload->sync, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR, EGL_FOREVER_KHR);
+		wlr_egl_destroy_sync(renderer->egl, upload->sync);
+	}
+
+	texture->tex = upload->tex;
+	texture->upload = NULL;
+	free(upload->data);
+	free(upload);
+}
+
+void gles2_upload_thread_finish(struct wlr_gles2_renderer *renderer) {
+	if (!renderer->upload.started) {
+		return;
+	}
+
+	pthread_mutex_lock(&renderer->upload.mutex);
+	renderer->upload.shutdown = true;
+	pthread_cond_broadcast(&renderer->upload.cond);
+	pthread_mutex_unlock(&renderer->upload.mutex);
+	pthread_join(renderer->upload.thread, NULL);
+
+	// Resolve jobs no texture ever waited for
+	struct wlr_gles2_upload *upload, *tmp;
+	wl_list_for_each_safe(upload, tmp, &renderer->upload.jobs, link) {
+		if (upload->done) {
+			gles2_texture_sync_upload(upload->texture);
+		} else {
+			upload->texture->upload = NULL;
+			wl_list_remove(&upload->link);
+			free(upload->data);
+			free(upload);
+		}
+	}
+
+	pthread_mutex_destroy(&renderer->upload.mutex);
+	pthread_cond_destroy(&renderer->upload.cond);
+	renderer->upload.started = false;
+}
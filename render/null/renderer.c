@@ -0,0 +1,196 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-server-protocol.h>
+#include <wlr/render/interface.h>
+#include <wlr/util/log.h>
+#include "render/null.h"
+
+static const struct wlr_renderer_impl renderer_impl;
+static const struct wlr_texture_impl texture_impl;
+
+bool wlr_renderer_is_null(struct wlr_renderer *wlr_renderer) {
+	return wlr_renderer->impl == &renderer_impl;
+}
+
+bool wlr_texture_is_null(struct wlr_texture *wlr_texture) {
+	return wlr_texture->impl == &texture_impl;
+}
+
+static struct wlr_null_renderer *get_renderer(
+		struct wlr_renderer *wlr_renderer) {
+	assert(wlr_renderer_is_null(wlr_renderer));
+	return (struct wlr_null_renderer *)wlr_renderer;
+}
+
+static const enum wl_shm_format shm_formats[] = {
+	WL_SHM_FORMAT_ARGB8888,
+	WL_SHM_FORMAT_XRGB8888,
+};
+
+static bool null_bind_buffer(struct wlr_renderer *wlr_renderer,
+		struct wlr_buffer *buffer) {
+	// Accept any buffer, so backends can run their full commit path
+	return true;
+}
+
+static void null_begin(struct wlr_renderer *wlr_renderer, uint32_t width,
+		uint32_t height) {
+	struct wlr_null_renderer *renderer = get_renderer(wlr_renderer);
+	renderer->viewport_width = width;
+	renderer->viewport_height = height;
+}
+
+static void null_clear(struct wlr_renderer *wlr_renderer,
+		const float color[static 4]) {
+	// This space intentionally left blank
+}
+
+static void null_scissor(struct wlr_renderer *wlr_renderer,
+		struct wlr_box *box) {
+	// This space intentionally left blank
+}
+
+static bool null_render_subtexture_with_matrix(
+		struct wlr_renderer *wlr_renderer, struct wlr_texture *wlr_texture,
+		const struct wlr_fbox *box, const float matrix[static 9],
+		float alpha) {
+	return true;
+}
+
+static void null_render_quad_with_matrix(struct wlr_renderer *wlr_renderer,
+		const float color[static 4], const float matrix[static 9]) {
+	// This space intentionally left blank
+}
+
+static void null_render_ellipse_with_matrix(struct wlr_renderer *wlr_renderer,
+		const float color[static 4], const float matrix[static 9]) {
+	// This space intentionally left blank
+}
+
+static const enum wl_shm_format *null_get_shm_texture_formats(
+		struct wlr_renderer *wlr_renderer, size_t *len) {
+	*len = sizeof(shm_formats) / sizeof(shm_formats[0]);
+	return shm_formats;
+}
+
+static enum wl_shm_format null_preferred_read_format(
+		struct wlr_renderer *wlr_renderer) {
+	return WL_SHM_FORMAT_ARGB8888;
+}
+
+static bool null_read_pixels(struct wlr_renderer *wlr_renderer,
+		enum wl_shm_format wl_fmt, uint32_t *flags, uint32_t stride,
+		uint32_t width, uint32_t height, uint32_t src_x, uint32_t src_y,
+		uint32_t dst_x, uint32_t dst_y, void *data) {
+	// There is nothing to read back; fabricate zeroed pixels so screenshot
+	// and screencopy paths still work end-to-end
+	uint8_t *out = data;
+	for (uint32_t i = 0; i < height; ++i) {
+		memset(out + (dst_y + i) * stride + dst_x * 4, 0, (size_t)width * 4);
+	}
+
+	if (flags != NULL) {
+		*flags = 0;
+	}
+
+	return true;
+}
+
+static bool null_texture_is_opaque(struct wlr_texture *wlr_texture) {
+	struct wlr_null_texture *texture =
+		(struct wlr_null_texture *)wlr_texture;
+	return !texture->has_alpha;
+}
+
+static bool null_texture_write_pixels(struct wlr_texture *wlr_texture,
+		uint32_t stride, uint32_t width, uint32_t height,
+		uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y,
+		const void *data) {
+	return true;
+}
+
+static void null_texture_destroy(struct wlr_texture *wlr_texture) {
+	free(wlr_texture);
+}
+
+static const struct wlr_texture_impl texture_impl = {
+	.is_opaque = null_texture_is_opaque,
+	.write_pixels = null_texture_write_pixels,
+	.destroy = null_texture_destroy,
+};
+
+static struct wlr_texture *create_texture(struct wlr_null_renderer *renderer,
+		enum wl_shm_format wl_fmt, uint32_t width, uint32_t height) {
+	struct wlr_null_texture *texture =
+		calloc(1, sizeof(struct wlr_null_texture));
+	if (texture == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	wlr_texture_init(&texture->wlr_texture, &texture_impl, width, height);
+	texture->renderer = renderer;
+	texture->wl_format = wl_fmt;
+	texture->has_alpha = wl_fmt == WL_SHM_FORMAT_ARGB8888;
+	return &texture->wlr_texture;
+}
+
+static struct wlr_texture *null_texture_from_pixels(
+		struct wlr_renderer *wlr_renderer, enum wl_shm_format wl_fmt,
+		uint32_t stride, uint32_t width, uint32_t height, const void *data) {
+	return create_texture(get_renderer(wlr_renderer), wl_fmt, width, height);
+}
+
+static struct wlr_texture *null_texture_from_shm_resource(
+		struct wlr_renderer *wlr_renderer, struct wl_resource *resource) {
+	struct wl_shm_buffer *shm_buffer = wl_shm_buffer_get(resource);
+	if (shm_buffer == NULL) {
+		return NULL;
+	}
+
+	// Only the dimensions matter; the client's pixels are never touched
+	return create_texture(get_renderer(wlr_renderer),
+		wl_shm_buffer_get_format(shm_buffer),
+		wl_shm_buffer_get_width(shm_buffer),
+		wl_shm_buffer_get_height(shm_buffer));
+}
+
+static struct wlr_texture *null_texture_from_pixels_borrowed(
+		struct wlr_renderer *wlr_renderer, enum wl_shm_format wl_fmt,
+		uint32_t stride, uint32_t width, uint32_t height, const void *data) {
+	return create_texture(get_renderer(wlr_renderer), wl_fmt, width, height);
+}
+
+static void null_destroy(struct wlr_renderer *wlr_renderer) {
+	free(get_renderer(wlr_renderer));
+}
+
+static const struct wlr_renderer_impl renderer_impl = {
+	.bind_buffer = null_bind_buffer,
+	.begin = null_begin,
+	.clear = null_clear,
+	.scissor = null_scissor,
+	.render_subtexture_with_matrix = null_render_subtexture_with_matrix,
+	.render_quad_with_matrix = null_render_quad_with_matrix,
+	.render_ellipse_with_matrix = null_render_ellipse_with_matrix,
+	.get_shm_texture_formats = null_get_shm_texture_formats,
+	.preferred_read_format = null_preferred_read_format,
+	.read_pixels = null_read_pixels,
+	.texture_from_pixels = null_texture_from_pixels,
+	.texture_from_shm_resource = null_texture_from_shm_resource,
+	.texture_from_pixels_borrowed = null_texture_from_pixels_borrowed,
+	.destroy = null_destroy,
+};
+
+struct wlr_renderer *wlr_null_renderer_create(void) {
+	struct wlr_null_renderer *renderer =
+		calloc(1, sizeof(struct wlr_null_renderer));
+	if (renderer == NULL) {
+		return NULL;
+	}
+	wlr_renderer_init(&renderer->wlr_renderer, &renderer_impl);
+
+	wlr_log(WLR_INFO, "Creating null renderer");
+
+	return &renderer->wlr_renderer;
+}
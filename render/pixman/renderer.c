@@ -0,0 +1,602 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pixman.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-server-protocol.h>
+#include <wlr/render/interface.h>
+#include <wlr/types/wlr_matrix.h>
+#include <wlr/util/log.h>
+#include "render/pixman.h"
+
+static const struct wlr_renderer_impl renderer_impl;
+static const struct wlr_texture_impl texture_impl;
+
+bool wlr_renderer_is_pixman(struct wlr_renderer *wlr_renderer) {
+	return wlr_renderer->impl == &renderer_impl;
+}
+
+bool wlr_texture_is_pixman(struct wlr_texture *wlr_texture) {
+	return wlr_texture->impl == &texture_impl;
+}
+
+static struct wlr_pixman_renderer *get_renderer(
+		struct wlr_renderer *wlr_renderer) {
+	assert(wlr_renderer_is_pixman(wlr_renderer));
+	return (struct wlr_pixman_renderer *)wlr_renderer;
+}
+
+static struct wlr_pixman_texture *get_texture(
+		struct wlr_texture *wlr_texture) {
+	assert(wlr_texture_is_pixman(wlr_texture));
+	return (struct wlr_pixman_texture *)wlr_texture;
+}
+
+static pixman_format_code_t get_pixman_format_from_wl(enum wl_shm_format fmt) {
+	switch (fmt) {
+	case WL_SHM_FORMAT_ARGB8888:
+		return PIXMAN_a8r8g8b8;
+	case WL_SHM_FORMAT_XRGB8888:
+		return PIXMAN_x8r8g8b8;
+	default:
+		return 0;
+	}
+}
+
+static const enum wl_shm_format shm_formats[] = {
+	WL_SHM_FORMAT_ARGB8888,
+	WL_SHM_FORMAT_XRGB8888,
+};
+
+/**
+ * Computes the transform mapping the unit square to target pixels, i.e. the
+ * viewport transform (NDC to pixels, with row 0 at the top) applied after the
+ * caller's projection matrix.
+ */
+static void get_dest_transform(struct wlr_pixman_renderer *renderer,
+		const float matrix[static 9], struct pixman_f_transform *transform) {
+	float w = renderer->viewport_width;
+	float h = renderer->viewport_height;
+	const float viewport[9] = {
+		w / 2.0f, 0.0f, w / 2.0f,
+		0.0f, -h / 2.0f, h / 2.0f,
+		0.0f, 0.0f, 1.0f,
+	};
+
+	float m[9];
+	wlr_matrix_multiply(m, viewport, matrix);
+
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			transform->m[i][j] = m[i * 3 + j];
+		}
+	}
+}
+
+/**
+ * Computes the target-pixel bounding box of the unit square under the given
+ * transform, clamped to the viewport. The matrices wlroots produces are
+ * affine, so transforming the four corners is enough.
+ */
+static void get_dest_box(struct wlr_pixman_renderer *renderer,
+		const struct pixman_f_transform *transform, struct wlr_box *box) {
+	double min_x = INFINITY, min_y = INFINITY;
+	double max_x = -INFINITY, max_y = -INFINITY;
+	for (int corner = 0; corner < 4; ++corner) {
+		double u = corner & 1, v = corner >> 1;
+		double x = transform->m[0][0] * u + transform->m[0][1] * v +
+			transform->m[0][2];
+		double y = transform->m[1][0] * u + transform->m[1][1] * v +
+			transform->m[1][2];
+		min_x = fmin(min_x, x);
+		min_y = fmin(min_y, y);
+		max_x = fmax(max_x, x);
+		max_y = fmax(max_y, y);
+	}
+
+	int x1 = fmax(floor(min_x), 0);
+	int y1 = fmax(floor(min_y), 0);
+	int x2 = fmin(ceil(max_x), renderer->viewport_width);
+	int y2 = fmin(ceil(max_y), renderer->viewport_height);
+
+	box->x = x1;
+	box->y = y1;
+	box->width = x2 > x1 ? x2 - x1 : 0;
+	box->height = y2 > y1 ? y2 - y1 : 0;
+}
+
+static void pixman_begin(struct wlr_renderer *wlr_renderer, uint32_t width,
+		uint32_t height) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+
+	if (renderer->target == NULL || renderer->viewport_width != width ||
+			renderer->viewport_height != height) {
+		if (renderer->target != NULL) {
+			pixman_image_unref(renderer->target);
+		}
+		renderer->target = pixman_image_create_bits(PIXMAN_a8r8g8b8,
+			width, height, NULL, 0);
+	}
+
+	renderer->viewport_width = width;
+	renderer->viewport_height = height;
+}
+
+static void pixman_clear(struct wlr_renderer *wlr_renderer,
+		const float color[static 4]) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+
+	// wlroots colors are premultiplied, which matches pixman's pixel format
+	pixman_color_t c = {
+		.red = color[0] * 0xFFFF,
+		.green = color[1] * 0xFFFF,
+		.blue = color[2] * 0xFFFF,
+		.alpha = color[3] * 0xFFFF,
+	};
+	pixman_image_t *fill = pixman_image_create_solid_fill(&c);
+	// Composite instead of a direct fill, so that the scissor clip applies
+	pixman_image_composite32(PIXMAN_OP_SRC, fill, NULL, renderer->target,
+		0, 0, 0, 0, 0, 0, renderer->viewport_width, renderer->viewport_height);
+	pixman_image_unref(fill);
+}
+
+static void pixman_scissor(struct wlr_renderer *wlr_renderer,
+		struct wlr_box *box) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+
+	if (box != NULL) {
+		pixman_region32_t clip;
+		pixman_region32_init_rect(&clip, box->x, box->y, box->width,
+			box->height);
+		pixman_image_set_clip_region32(renderer->target, &clip);
+		pixman_region32_fini(&clip);
+	} else {
+		pixman_image_set_clip_region32(renderer->target, NULL);
+	}
+}
+
+static bool pixman_render_subtexture_with_matrix(
+		struct wlr_renderer *wlr_renderer, struct wlr_texture *wlr_texture,
+		const struct wlr_fbox *box, const float matrix[static 9],
+		float alpha) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+	struct wlr_pixman_texture *texture = get_texture(wlr_texture);
+
+	struct pixman_f_transform dest_from_unit;
+	get_dest_transform(renderer, matrix, &dest_from_unit);
+
+	struct pixman_f_transform unit_from_dest;
+	if (!pixman_f_transform_invert(&unit_from_dest, &dest_from_unit)) {
+		return false;
+	}
+
+	// Texture pixels from the unit square, offset into the subtexture box
+	const struct pixman_f_transform src_from_unit = {{
+		{ box->width, 0.0, box->x },
+		{ 0.0, box->height, box->y },
+		{ 0.0, 0.0, 1.0 },
+	}};
+
+	struct pixman_f_transform src_from_dest;
+	pixman_f_transform_multiply(&src_from_dest, &src_from_unit,
+		&unit_from_dest);
+
+	struct pixman_transform transform;
+	pixman_transform_from_pixman_f_transform(&transform, &src_from_dest);
+	pixman_image_set_transform(texture->image, &transform);
+	pixman_image_set_filter(texture->image, PIXMAN_FILTER_BILINEAR, NULL, 0);
+
+	pixman_image_t *mask = NULL;
+	if (alpha < 1.0f) {
+		pixman_color_t mask_color = { .alpha = alpha * 0xFFFF };
+		mask = pixman_image_create_solid_fill(&mask_color);
+	}
+
+	struct wlr_box dest_box;
+	get_dest_box(renderer, &dest_from_unit, &dest_box);
+
+	pixman_op_t op = texture->has_alpha || alpha < 1.0f ?
+		PIXMAN_OP_OVER : PIXMAN_OP_SRC;
+	if (texture->shm_buffer != NULL) {
+		wl_shm_buffer_begin_access(texture->shm_buffer);
+	}
+	pixman_image_composite32(op, texture->image, mask, renderer->target,
+		dest_box.x, dest_box.y, dest_box.x, dest_box.y,
+		dest_box.x, dest_box.y, dest_box.width, dest_box.height);
+	if (texture->shm_buffer != NULL) {
+		wl_shm_buffer_end_access(texture->shm_buffer);
+	}
+
+	if (mask != NULL) {
+		pixman_image_unref(mask);
+	}
+	pixman_image_set_transform(texture->image, NULL);
+
+	return true;
+}
+
+static void pixman_render_quad_with_matrix(struct wlr_renderer *wlr_renderer,
+		const float color[static 4], const float matrix[static 9]) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+
+	struct pixman_f_transform dest_from_unit;
+	get_dest_transform(renderer, matrix, &dest_from_unit);
+
+	pixman_color_t c = {
+		.red = color[0] * 0xFFFF,
+		.green = color[1] * 0xFFFF,
+		.blue = color[2] * 0xFFFF,
+		.alpha = color[3] * 0xFFFF,
+	};
+	pixman_image_t *fill = pixman_image_create_solid_fill(&c);
+
+	// An axis-aligned quad covers its bounding box exactly and can be filled
+	// directly. 90° rotations stay axis-aligned, zeroing the diagonal instead
+	// of the off-diagonal entries.
+	if ((dest_from_unit.m[0][1] == 0.0 && dest_from_unit.m[1][0] == 0.0) ||
+			(dest_from_unit.m[0][0] == 0.0 && dest_from_unit.m[1][1] == 0.0)) {
+		struct wlr_box box;
+		get_dest_box(renderer, &dest_from_unit, &box);
+
+		pixman_op_t op = color[3] < 1.0f ? PIXMAN_OP_OVER : PIXMAN_OP_SRC;
+		pixman_image_composite32(op, fill, NULL, renderer->target,
+			0, 0, 0, 0, box.x, box.y, box.width, box.height);
+	} else {
+		// A rotated quad is rasterized as two antialiased triangles
+		struct pixman_point_fixed corners[4];
+		for (int i = 0; i < 4; ++i) {
+			double u = i & 1, v = i >> 1;
+			double x = dest_from_unit.m[0][0] * u +
+				dest_from_unit.m[0][1] * v + dest_from_unit.m[0][2];
+			double y = dest_from_unit.m[1][0] * u +
+				dest_from_unit.m[1][1] * v + dest_from_unit.m[1][2];
+			corners[i].x = pixman_double_to_fixed(x);
+			corners[i].y = pixman_double_to_fixed(y);
+		}
+
+		// Corners are ordered (0,0), (1,0), (0,1), (1,1), so splitting along
+		// the (1,0)-(0,1) diagonal covers the quad
+		struct pixman_triangle tris[2] = {
+			{ corners[0], corners[1], corners[2] },
+			{ corners[3], corners[1], corners[2] },
+		};
+		// OP_OVER regardless of alpha: with an a8 mask, OP_SRC would clear
+		// the parts of the mask's bounding box outside the triangles
+		pixman_composite_triangles(PIXMAN_OP_OVER, fill, renderer->target,
+			PIXMAN_a8, 0, 0, 0, 0, 2, tris);
+	}
+
+	pixman_image_unref(fill);
+}
+
+static void pixman_render_ellipse_with_matrix(struct wlr_renderer *wlr_renderer,
+		const float color[static 4], const float matrix[static 9]) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+
+	struct pixman_f_transform dest_from_unit;
+	get_dest_transform(renderer, matrix, &dest_from_unit);
+
+	struct wlr_box box;
+	get_dest_box(renderer, &dest_from_unit, &box);
+	if (box.width == 0 || box.height == 0) {
+		return;
+	}
+
+	pixman_color_t c = {
+		.red = color[0] * 0xFFFF,
+		.green = color[1] * 0xFFFF,
+		.blue = color[2] * 0xFFFF,
+		.alpha = color[3] * 0xFFFF,
+	};
+	pixman_image_t *fill = pixman_image_create_solid_fill(&c);
+	pixman_op_t op = color[3] < 1.0f ? PIXMAN_OP_OVER : PIXMAN_OP_SRC;
+
+	// Fill the inscribed ellipse one row of spans at a time
+	double rx = box.width / 2.0, ry = box.height / 2.0;
+	double cx = box.x + rx, cy = box.y + ry;
+	for (int y = box.y; y < box.y + box.height; ++y) {
+		double v = (y + 0.5 - cy) / ry;
+		double dx = rx * sqrt(fmax(1.0 - v * v, 0.0));
+		int x1 = round(cx - dx), x2 = round(cx + dx);
+		if (x2 <= x1) {
+			continue;
+		}
+		pixman_image_composite32(op, fill, NULL, renderer->target,
+			0, 0, 0, 0, x1, y, x2 - x1, 1);
+	}
+
+	pixman_image_unref(fill);
+}
+
+static const enum wl_shm_format *pixman_get_shm_texture_formats(
+		struct wlr_renderer *wlr_renderer, size_t *len) {
+	*len = sizeof(shm_formats) / sizeof(shm_formats[0]);
+	return shm_formats;
+}
+
+static enum wl_shm_format pixman_preferred_read_format(
+		struct wlr_renderer *wlr_renderer) {
+	return WL_SHM_FORMAT_ARGB8888;
+}
+
+static bool pixman_read_pixels(struct wlr_renderer *wlr_renderer,
+		enum wl_shm_format wl_fmt, uint32_t *flags, uint32_t stride,
+		uint32_t width, uint32_t height, uint32_t src_x, uint32_t src_y,
+		uint32_t dst_x, uint32_t dst_y, void *data) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+	if (renderer->target == NULL) {
+		return false;
+	}
+
+	pixman_format_code_t fmt = get_pixman_format_from_wl(wl_fmt);
+	if (fmt == 0) {
+		wlr_log(WLR_ERROR, "Unsupported pixel format %"PRIu32, wl_fmt);
+		return false;
+	}
+
+	pixman_image_t *dst = pixman_image_create_bits(fmt, dst_x + width,
+		dst_y + height, data, stride);
+	if (dst == NULL) {
+		return false;
+	}
+
+	pixman_image_composite32(PIXMAN_OP_SRC, renderer->target, NULL, dst,
+		src_x, src_y, 0, 0, dst_x, dst_y, width, height);
+	pixman_image_unref(dst);
+
+	if (flags != NULL) {
+		*flags = 0;
+	}
+
+	return true;
+}
+
+static bool pixman_texture_is_opaque(struct wlr_texture *wlr_texture) {
+	struct wlr_pixman_texture *texture = get_texture(wlr_texture);
+	return !texture->has_alpha;
+}
+
+static bool pixman_texture_write_pixels(struct wlr_texture *wlr_texture,
+		uint32_t stride, uint32_t width, uint32_t height,
+		uint32_t src_x, uint32_t src_y, uint32_t dst_x, uint32_t dst_y,
+		const void *data) {
+	struct wlr_pixman_texture *texture = get_texture(wlr_texture);
+
+	if (texture->data == NULL) {
+		// The image borrows caller or client memory, we must not write
+		// into it
+		return false;
+	}
+
+	uint32_t tex_stride = pixman_image_get_stride(texture->image);
+	const uint8_t *src = data;
+	uint8_t *dst = texture->data;
+	for (uint32_t i = 0; i < height; ++i) {
+		memcpy(dst + (dst_y + i) * tex_stride + dst_x * 4,
+			src + (src_y + i) * stride + src_x * 4, width * 4);
+	}
+
+	return true;
+}
+
+static bool pixman_texture_detach(struct wlr_texture *wlr_texture) {
+	struct wlr_pixman_texture *texture = get_texture(wlr_texture);
+	if (texture->data != NULL) {
+		return true;
+	}
+
+	// The borrowed memory is going away: copy the pixels into
+	// texture-owned storage before it gets unmapped or freed
+	pixman_format_code_t fmt = pixman_image_get_format(texture->image);
+	int32_t width = pixman_image_get_width(texture->image);
+	int32_t height = pixman_image_get_height(texture->image);
+	int32_t stride = pixman_image_get_stride(texture->image);
+
+	void *data = malloc((size_t)stride * height);
+	if (data == NULL) {
+		wlr_log_errno(WLR_ERROR, "Allocation failed");
+		return false;
+	}
+
+	if (texture->shm_buffer != NULL) {
+		wl_shm_buffer_begin_access(texture->shm_buffer);
+	}
+	memcpy(data, pixman_image_get_data(texture->image),
+		(size_t)stride * height);
+	if (texture->shm_buffer != NULL) {
+		wl_shm_buffer_end_access(texture->shm_buffer);
+	}
+
+	pixman_image_t *image = pixman_image_create_bits_no_clear(fmt, width,
+		height, data, stride);
+	if (image == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create pixman image");
+		free(data);
+		return false;
+	}
+
+	pixman_image_unref(texture->image);
+	texture->image = image;
+	texture->data = data;
+	texture->shm_buffer = NULL;
+	return true;
+}
+
+static void pixman_texture_destroy(struct wlr_texture *wlr_texture) {
+	if (wlr_texture == NULL) {
+		return;
+	}
+	struct wlr_pixman_texture *texture = get_texture(wlr_texture);
+	pixman_image_unref(texture->image);
+	free(texture->data);
+	free(texture);
+}
+
+static const struct wlr_texture_impl texture_impl = {
+	.is_opaque = pixman_texture_is_opaque,
+	.write_pixels = pixman_texture_write_pixels,
+	.detach = pixman_texture_detach,
+	.destroy = pixman_texture_destroy,
+};
+
+static struct wlr_texture *pixman_texture_from_pixels(
+		struct wlr_renderer *wlr_renderer, enum wl_shm_format wl_fmt,
+		uint32_t stride, uint32_t width, uint32_t height, const void *data) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+
+	pixman_format_code_t fmt = get_pixman_format_from_wl(wl_fmt);
+	if (fmt == 0) {
+		wlr_log(WLR_ERROR, "Unsupported pixel format %"PRIu32, wl_fmt);
+		return NULL;
+	}
+
+	struct wlr_pixman_texture *texture =
+		calloc(1, sizeof(struct wlr_pixman_texture));
+	if (texture == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	wlr_texture_init(&texture->wlr_texture, &texture_impl, width, height);
+	texture->renderer = renderer;
+	texture->wl_format = wl_fmt;
+	texture->has_alpha = wl_fmt == WL_SHM_FORMAT_ARGB8888;
+
+	texture->data = malloc((size_t)stride * height);
+	if (texture->data == NULL) {
+		wlr_log_errno(WLR_ERROR, "Allocation failed");
+		free(texture);
+		return NULL;
+	}
+	memcpy(texture->data, data, (size_t)stride * height);
+
+	texture->image = pixman_image_create_bits_no_clear(fmt, width, height,
+		texture->data, stride);
+	if (texture->image == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create pixman image");
+		free(texture->data);
+		free(texture);
+		return NULL;
+	}
+
+	return &texture->wlr_texture;
+}
+
+static struct wlr_texture *pixman_texture_from_shm_resource(
+		struct wlr_renderer *wlr_renderer, struct wl_resource *resource) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+
+	struct wl_shm_buffer *shm_buffer = wl_shm_buffer_get(resource);
+	if (shm_buffer == NULL) {
+		return NULL;
+	}
+
+	enum wl_shm_format wl_fmt = wl_shm_buffer_get_format(shm_buffer);
+	pixman_format_code_t fmt = get_pixman_format_from_wl(wl_fmt);
+	if (fmt == 0) {
+		wlr_log(WLR_ERROR, "Unsupported pixel format %"PRIu32, wl_fmt);
+		return NULL;
+	}
+
+	int32_t stride = wl_shm_buffer_get_stride(shm_buffer);
+	int32_t width = wl_shm_buffer_get_width(shm_buffer);
+	int32_t height = wl_shm_buffer_get_height(shm_buffer);
+
+	struct wlr_pixman_texture *texture =
+		calloc(1, sizeof(struct wlr_pixman_texture));
+	if (texture == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	wlr_texture_init(&texture->wlr_texture, &texture_impl, width, height);
+	texture->renderer = renderer;
+	texture->wl_format = wl_fmt;
+	texture->has_alpha = wl_fmt == WL_SHM_FORMAT_ARGB8888;
+	texture->shm_buffer = shm_buffer;
+
+	// Sample straight from the client's mapped pool instead of copying. The
+	// caller withholds wl_buffer.release while the texture exists, so the
+	// client won't write into the buffer behind our back.
+	texture->image = pixman_image_create_bits_no_clear(fmt, width, height,
+		wl_shm_buffer_get_data(shm_buffer), stride);
+	if (texture->image == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create pixman image");
+		free(texture);
+		return NULL;
+	}
+
+	return &texture->wlr_texture;
+}
+
+static struct wlr_texture *pixman_texture_from_pixels_borrowed(
+		struct wlr_renderer *wlr_renderer, enum wl_shm_format wl_fmt,
+		uint32_t stride, uint32_t width, uint32_t height, const void *data) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+
+	pixman_format_code_t fmt = get_pixman_format_from_wl(wl_fmt);
+	if (fmt == 0) {
+		wlr_log(WLR_ERROR, "Unsupported pixel format %"PRIu32, wl_fmt);
+		return NULL;
+	}
+
+	struct wlr_pixman_texture *texture =
+		calloc(1, sizeof(struct wlr_pixman_texture));
+	if (texture == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	wlr_texture_init(&texture->wlr_texture, &texture_impl, width, height);
+	texture->renderer = renderer;
+	texture->wl_format = wl_fmt;
+	texture->has_alpha = wl_fmt == WL_SHM_FORMAT_ARGB8888;
+
+	// Sample straight from the caller's allocation instead of copying. The
+	// caller keeps the memory valid and calls wlr_texture_detach() before
+	// freeing it, see wlr_texture_from_pixels_borrowed.
+	texture->image = pixman_image_create_bits_no_clear(fmt, width, height,
+		(void *)data, stride);
+	if (texture->image == NULL) {
+		wlr_log(WLR_ERROR, "Failed to create pixman image");
+		free(texture);
+		return NULL;
+	}
+
+	return &texture->wlr_texture;
+}
+
+static void pixman_destroy(struct wlr_renderer *wlr_renderer) {
+	struct wlr_pixman_renderer *renderer = get_renderer(wlr_renderer);
+	if (renderer->target != NULL) {
+		pixman_image_unref(renderer->target);
+	}
+	free(renderer);
+}
+
+static const struct wlr_renderer_impl renderer_impl = {
+	.begin = pixman_begin,
+	.clear = pixman_clear,
+	.scissor = pixman_scissor,
+	.render_subtexture_with_matrix = pixman_render_subtexture_with_matrix,
+	.render_quad_with_matrix = pixman_render_quad_with_matrix,
+	.render_ellipse_with_matrix = pixman_render_ellipse_with_matrix,
+	.get_shm_texture_formats = pixman_get_shm_texture_formats,
+	.preferred_read_format = pixman_preferred_read_format,
+	.read_pixels = pixman_read_pixels,
+	.texture_from_pixels = pixman_texture_from_pixels,
+	.texture_from_shm_resource = pixman_texture_from_shm_resource,
+	.texture_from_pixels_borrowed = pixman_texture_from_pixels_borrowed,
+	.destroy = pixman_destroy,
+};
+
+struct wlr_renderer *wlr_pixman_renderer_create(void) {
+	struct wlr_pixman_renderer *renderer =
+		calloc(1, sizeof(struct wlr_pixman_renderer));
+	if (renderer == NULL) {
+		return NULL;
+	}
+	wlr_renderer_init(&renderer->wlr_renderer, &renderer_impl);
+
+	wlr_log(WLR_INFO, "Creating pixman renderer");
+
+	return &renderer->wlr_renderer;
+}
@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <stdlib.h>
+#include <wlr/render/wlr_renderer.h>
 #include <wlr/util/log.h>
 #include <wlr/types/wlr_buffer.h>
 #include "render/allocator.h"
@@ -112,6 +113,38 @@ struct wlr_buffer *wlr_swapchain_acquire(struct wlr_swapchain *swapchain,
 	return slot_acquire(swapchain, free_slot, age);
 }
 
+bool wlr_swapchain_warmup(struct wlr_swapchain *swapchain,
+		struct wlr_renderer *renderer) {
+	if (swapchain->allocator == NULL) {
+		return false;
+	}
+
+	bool ok = true;
+	for (size_t i = 0; i < WLR_SWAPCHAIN_CAP; i++) {
+		struct wlr_swapchain_slot *slot = &swapchain->slots[i];
+		if (slot->buffer == NULL) {
+			wlr_log(WLR_DEBUG, "Pre-allocating swapchain buffer");
+			slot->buffer = wlr_allocator_create_buffer(swapchain->allocator,
+				swapchain->width, swapchain->height, swapchain->format);
+			if (slot->buffer == NULL) {
+				wlr_log(WLR_ERROR, "Failed to pre-allocate buffer");
+				ok = false;
+				continue;
+			}
+		}
+		if (renderer != NULL && !slot->acquired) {
+			// Bind the buffer once so renderer-side state (EGL image, FBO)
+			// is created now instead of on the slot's first frame
+			if (wlr_renderer_bind_buffer(renderer, slot->buffer)) {
+				wlr_renderer_bind_buffer(renderer, NULL);
+			} else {
+				ok = false;
+			}
+		}
+	}
+	return ok;
+}
+
 static bool swapchain_has_buffer(struct wlr_swapchain *swapchain,
 		struct wlr_buffer *buffer) {
 	for (size_t i = 0; i < WLR_SWAPCHAIN_CAP; i++) {
@@ -1,14 +1,18 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <gbm.h>
 #include <wlr/render/egl.h>
 #include <wlr/render/gles2.h>
 #include <wlr/render/interface.h>
+#include <wlr/render/null.h>
+#include <wlr/render/pixman.h>
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/types/wlr_matrix.h>
 #include <wlr/util/log.h>
 #include "util/signal.h"
+#include "util/trace.h"
 #include "render/wlr_renderer.h"
 #include "backend/backend.h"
 
@@ -52,6 +56,7 @@ bool wlr_renderer_bind_buffer(struct wlr_renderer *r,
 void wlr_renderer_begin(struct wlr_renderer *r, uint32_t width, uint32_t height) {
 	assert(!r->rendering);
 
+	trace_span_begin("render_pass");
 	r->impl->begin(r, width, height);
 
 	r->rendering = true;
@@ -63,6 +68,7 @@ void wlr_renderer_end(struct wlr_renderer *r) {
 	if (r->impl->end) {
 		r->impl->end(r);
 	}
+	trace_span_end("render_pass");
 
 	r->rendering = false;
 }
@@ -113,6 +119,53 @@ bool wlr_render_subtexture_with_matrix(struct wlr_renderer *r,
 		box, matrix, alpha);
 }
 
+bool wlr_render_texture_with_matrix_damage(struct wlr_renderer *r,
+		struct wlr_texture *texture, const float matrix[static 9], float alpha,
+		pixman_region32_t *damage) {
+	struct wlr_fbox box = {
+		.x = 0,
+		.y = 0,
+		.width = texture->width,
+		.height = texture->height,
+	};
+	return wlr_render_subtexture_with_matrix_damage(r, texture, &box, matrix,
+		alpha, damage);
+}
+
+bool wlr_render_subtexture_with_matrix_damage(struct wlr_renderer *r,
+		struct wlr_texture *texture, const struct wlr_fbox *box,
+		const float matrix[static 9], float alpha,
+		pixman_region32_t *damage) {
+	assert(r->rendering);
+
+	if (!pixman_region32_not_empty(damage)) {
+		return true;
+	}
+
+	if (r->impl->render_subtexture_with_matrix_damage) {
+		return r->impl->render_subtexture_with_matrix_damage(r, texture, box,
+			matrix, alpha, damage);
+	}
+
+	// Fall back to one scissored draw per damage rectangle
+	bool ok = true;
+	int rects_len;
+	pixman_box32_t *rects = pixman_region32_rectangles(damage, &rects_len);
+	for (int i = 0; i < rects_len; ++i) {
+		struct wlr_box scissor_box = {
+			.x = rects[i].x1,
+			.y = rects[i].y1,
+			.width = rects[i].x2 - rects[i].x1,
+			.height = rects[i].y2 - rects[i].y1,
+		};
+		r->impl->scissor(r, &scissor_box);
+		ok = r->impl->render_subtexture_with_matrix(r, texture, box, matrix,
+			alpha) && ok;
+	}
+	r->impl->scissor(r, NULL);
+	return ok;
+}
+
 void wlr_render_rect(struct wlr_renderer *r, const struct wlr_box *box,
 		const float color[static 4], const float projection[static 9]) {
 	if (box->width == 0 || box->height == 0) {
@@ -199,14 +252,45 @@ bool wlr_renderer_read_pixels(struct wlr_renderer *r, enum wl_shm_format fmt,
 		src_x, src_y, dst_x, dst_y, data);
 }
 
+bool wlr_renderer_read_pixels_async(struct wlr_renderer *r,
+		enum wl_shm_format fmt, uint32_t *flags, uint32_t stride,
+		uint32_t width, uint32_t height, uint32_t src_x, uint32_t src_y,
+		uint32_t dst_x, uint32_t dst_y, void *data,
+		wlr_renderer_read_pixels_cb cb, void *cb_data) {
+	if (r->impl->read_pixels_async &&
+			r->impl->read_pixels_async(r, fmt, flags, stride, width, height,
+				src_x, src_y, dst_x, dst_y, data, cb, cb_data)) {
+		return true;
+	}
+
+	// Fall back to a synchronous read completing immediately
+	bool ok = wlr_renderer_read_pixels(r, fmt, flags, stride, width, height,
+		src_x, src_y, dst_x, dst_y, data);
+	cb(ok, cb_data);
+	return ok;
+}
+
+size_t wlr_renderer_poll_async_reads(struct wlr_renderer *r) {
+	if (!r->impl->poll_async_reads) {
+		return 0;
+	}
+	return r->impl->poll_async_reads(r);
+}
+
 bool wlr_renderer_blit_dmabuf(struct wlr_renderer *r,
 		struct wlr_dmabuf_attributes *dst,
 		struct wlr_dmabuf_attributes *src) {
+	return wlr_renderer_blit_dmabuf_region(r, dst, src, NULL);
+}
+
+bool wlr_renderer_blit_dmabuf_region(struct wlr_renderer *r,
+		struct wlr_dmabuf_attributes *dst,
+		struct wlr_dmabuf_attributes *src, const struct wlr_fbox *src_box) {
 	assert(!r->rendering);
 	if (!r->impl->blit_dmabuf) {
 		return false;
 	}
-	return r->impl->blit_dmabuf(r, dst, src);
+	return r->impl->blit_dmabuf(r, dst, src, src_box);
 }
 
 bool wlr_renderer_init_wl_display(struct wlr_renderer *r,
@@ -250,7 +334,7 @@ bool wlr_renderer_init_wl_display(struct wlr_renderer *r,
 	return true;
 }
 
-struct wlr_renderer *wlr_renderer_autocreate_with_drm_fd(int drm_fd) {
+static struct wlr_renderer *renderer_autocreate_gles2(int drm_fd) {
 	struct gbm_device *gbm_device = gbm_create_device(drm_fd);
 	if (!gbm_device) {
 		wlr_log(WLR_ERROR, "Failed to create GBM device");
@@ -275,6 +359,27 @@ struct wlr_renderer *wlr_renderer_autocreate_with_drm_fd(int drm_fd) {
 	return renderer;
 }
 
+struct wlr_renderer *wlr_renderer_autocreate_with_drm_fd(int drm_fd) {
+	const char *name = getenv("WLR_RENDERER");
+	if (name != NULL) {
+		wlr_log(WLR_INFO, "Loading user-specified renderer due to "
+			"WLR_RENDERER: %s", name);
+		if (strcmp(name, "gles2") == 0) {
+			return renderer_autocreate_gles2(drm_fd);
+		}
+		if (strcmp(name, "pixman") == 0) {
+			return wlr_pixman_renderer_create();
+		}
+		if (strcmp(name, "null") == 0) {
+			return wlr_null_renderer_create();
+		}
+		wlr_log(WLR_ERROR, "Invalid WLR_RENDERER value: '%s'", name);
+		return NULL;
+	}
+
+	return renderer_autocreate_gles2(drm_fd);
+}
+
 struct wlr_renderer *wlr_renderer_autocreate(struct wlr_backend *backend) {
 	int drm_fd = backend_get_drm_fd(backend);
 	if (drm_fd < 0) {
@@ -285,9 +390,46 @@ struct wlr_renderer *wlr_renderer_autocreate(struct wlr_backend *backend) {
 	return wlr_renderer_autocreate_with_drm_fd(drm_fd);
 }
 
+bool wlr_renderer_get_render_timings(struct wlr_renderer *r,
+		struct wlr_render_timings *timings) {
+	if (!r->impl->get_render_timings) {
+		return false;
+	}
+	return r->impl->get_render_timings(r, timings);
+}
+
+bool wlr_renderer_get_stats(struct wlr_renderer *r,
+		struct wlr_renderer_stats *stats) {
+	if (!r->impl->get_stats) {
+		return false;
+	}
+	return r->impl->get_stats(r, stats);
+}
+
+void wlr_renderer_reset_stats(struct wlr_renderer *r) {
+	if (r->impl->reset_stats) {
+		r->impl->reset_stats(r);
+	}
+}
+
 int wlr_renderer_get_drm_fd(struct wlr_renderer *r) {
 	if (!r->impl->get_drm_fd) {
 		return -1;
 	}
 	return r->impl->get_drm_fd(r);
 }
+
+int wlr_renderer_get_fence_fd(struct wlr_renderer *r) {
+	if (!r->impl->get_fence_fd) {
+		return -1;
+	}
+	return r->impl->get_fence_fd(r);
+}
+
+bool wlr_renderer_set_gamma_lut(struct wlr_renderer *r, size_t ramp_size,
+		const uint16_t *red, const uint16_t *green, const uint16_t *blue) {
+	if (!r->impl->set_gamma_lut) {
+		return false;
+	}
+	return r->impl->set_gamma_lut(r, ramp_size, red, green, blue);
+}
@@ -1,9 +1,18 @@
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <wlr/render/interface.h>
 #include <wlr/render/wlr_texture.h>
 
+// Counts pixels handed to the renderer for upload, see
+// wlr_texture_get_upload_pixels
+static uint64_t upload_pixels_counter = 0;
+
+uint64_t wlr_texture_get_upload_pixels(void) {
+	return upload_pixels_counter;
+}
+
 void wlr_texture_init(struct wlr_texture *texture,
 		const struct wlr_texture_impl *impl, uint32_t width, uint32_t height) {
 	texture->impl = impl;
@@ -22,8 +31,32 @@ void wlr_texture_destroy(struct wlr_texture *texture) {
 struct wlr_texture *wlr_texture_from_pixels(struct wlr_renderer *renderer,
 		enum wl_shm_format wl_fmt, uint32_t stride, uint32_t width,
 		uint32_t height, const void *data) {
-	return renderer->impl->texture_from_pixels(renderer, wl_fmt, stride, width,
-		height, data);
+	struct wlr_texture *texture = renderer->impl->texture_from_pixels(renderer,
+		wl_fmt, stride, width, height, data);
+	if (texture != NULL) {
+		upload_pixels_counter += (uint64_t)width * height;
+	}
+	return texture;
+}
+
+struct wlr_texture *wlr_texture_from_shm_resource(struct wlr_renderer *renderer,
+		struct wl_resource *resource) {
+	if (!renderer->impl->texture_from_shm_resource) {
+		return NULL;
+	}
+	// No pixels are copied here, so the upload counter isn't bumped
+	return renderer->impl->texture_from_shm_resource(renderer, resource);
+}
+
+struct wlr_texture *wlr_texture_from_pixels_borrowed(
+		struct wlr_renderer *renderer, enum wl_shm_format wl_fmt,
+		uint32_t stride, uint32_t width, uint32_t height, const void *data) {
+	if (!renderer->impl->texture_from_pixels_borrowed) {
+		return NULL;
+	}
+	// No pixels are copied here, so the upload counter isn't bumped
+	return renderer->impl->texture_from_pixels_borrowed(renderer, wl_fmt,
+		stride, width, height, data);
 }
 
 struct wlr_texture *wlr_texture_from_wl_drm(struct wlr_renderer *renderer,
@@ -62,8 +95,42 @@ bool wlr_texture_write_pixels(struct wlr_texture *texture,
 	if (!texture->impl->write_pixels) {
 		return false;
 	}
-	return texture->impl->write_pixels(texture, stride, width, height,
-		src_x, src_y, dst_x, dst_y, data);
+	if (!texture->impl->write_pixels(texture, stride, width, height,
+			src_x, src_y, dst_x, dst_y, data)) {
+		return false;
+	}
+	upload_pixels_counter += (uint64_t)width * height;
+	return true;
+}
+
+bool wlr_texture_write_pixels_region(struct wlr_texture *texture,
+		uint32_t stride, pixman_region32_t *region, const void *data) {
+	if (texture->impl->write_pixels_region) {
+		if (!texture->impl->write_pixels_region(texture, stride, region,
+				data)) {
+			return false;
+		}
+		int rects_len;
+		pixman_box32_t *rects =
+			pixman_region32_rectangles(region, &rects_len);
+		for (int i = 0; i < rects_len; ++i) {
+			upload_pixels_counter += (uint64_t)(rects[i].x2 - rects[i].x1) *
+				(rects[i].y2 - rects[i].y1);
+		}
+		return true;
+	}
+
+	// Fall back to one write per rectangle
+	int rects_len;
+	pixman_box32_t *rects = pixman_region32_rectangles(region, &rects_len);
+	for (int i = 0; i < rects_len; ++i) {
+		pixman_box32_t *r = &rects[i];
+		if (!wlr_texture_write_pixels(texture, stride, r->x2 - r->x1,
+				r->y2 - r->y1, r->x1, r->y1, r->x1, r->y1, data)) {
+			return false;
+		}
+	}
+	return true;
 }
 
 bool wlr_texture_to_dmabuf(struct wlr_texture *texture,
@@ -73,3 +140,11 @@ bool wlr_texture_to_dmabuf(struct wlr_texture *texture,
 	}
 	return texture->impl->to_dmabuf(texture, attribs);
 }
+
+bool wlr_texture_detach(struct wlr_texture *texture) {
+	if (!texture->impl->detach) {
+		// Textures without the hook always own their storage
+		return true;
+	}
+	return texture->impl->detach(texture);
+}
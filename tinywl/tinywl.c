@@ -1,5 +1,6 @@
 #define _POSIX_C_SOURCE 200112L
 #include <getopt.h>
+#include <pixman.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -15,12 +16,15 @@
 #include <wlr/types/wlr_keyboard.h>
 #include <wlr/types/wlr_matrix.h>
 #include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_output_damage.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_pointer.h>
 #include <wlr/types/wlr_seat.h>
+#include <wlr/types/wlr_surface.h>
 #include <wlr/types/wlr_xcursor_manager.h>
 #include <wlr/types/wlr_xdg_shell.h>
 #include <wlr/util/log.h>
+#include <wlr/util/region.h>
 #include <xkbcommon/xkbcommon.h>
 
 /* For brevity's sake, struct members are annotated where they are used. */
@@ -67,6 +71,7 @@ struct tinywl_output {
 	struct wl_list link;
 	struct tinywl_server *server;
 	struct wlr_output *wlr_output;
+	struct wlr_output_damage *damage;
 	struct wl_listener frame;
 };
 
@@ -77,6 +82,7 @@ struct tinywl_view {
 	struct wl_listener map;
 	struct wl_listener unmap;
 	struct wl_listener destroy;
+	struct wl_listener commit;
 	struct wl_listener request_move;
 	struct wl_listener request_resize;
 	bool mapped;
@@ -351,10 +357,73 @@ static struct tinywl_view *desktop_view_at(
 	return NULL;
 }
 
+/* Used to pass a view to the per-surface damage iterator, along with whether
+ * the whole surface area should be damaged or only the region the client
+ * reported as changed on its last commit. */
+struct damage_data {
+	struct tinywl_view *view;
+	bool whole;
+};
+
+static void damage_surface(struct wlr_surface *surface,
+		int sx, int sy, void *data) {
+	/* This function is called for every surface of a view that needs to have
+	 * its damage recorded. It translates the damage into each output's
+	 * coordinate space and hands it to that output's wlr_output_damage, which
+	 * accumulates it and schedules a frame. */
+	struct damage_data *ddata = data;
+	struct tinywl_view *view = ddata->view;
+	struct tinywl_server *server = view->server;
+
+	struct tinywl_output *output;
+	wl_list_for_each(output, &server->outputs, link) {
+		float scale = output->wlr_output->scale;
+		double ox = 0, oy = 0;
+		wlr_output_layout_output_coords(
+				server->output_layout, output->wlr_output, &ox, &oy);
+		ox += view->x + sx, oy += view->y + sy;
+
+		if (ddata->whole) {
+			/* Damage the surface's full extents, e.g. because it (un)mapped
+			 * or the view moved. */
+			struct wlr_box box = {
+				.x = ox * scale,
+				.y = oy * scale,
+				.width = surface->current.width * scale,
+				.height = surface->current.height * scale,
+			};
+			wlr_output_damage_add_box(output->damage, &box);
+		} else {
+			/* Only damage what the client marked as changed. The effective
+			 * damage is in surface-local coordinates, with the surface's own
+			 * buffer scale and transform already resolved. */
+			pixman_region32_t damage;
+			pixman_region32_init(&damage);
+			wlr_surface_get_effective_damage(surface, &damage);
+			wlr_region_scale(&damage, &damage, scale);
+			pixman_region32_translate(&damage, ox * scale, oy * scale);
+			wlr_output_damage_add(output->damage, &damage);
+			pixman_region32_fini(&damage);
+		}
+	}
+}
+
+static void view_damage(struct tinywl_view *view, bool whole) {
+	/* Records damage for all of the view's surfaces on every output. */
+	struct damage_data data = {
+		.view = view,
+		.whole = whole,
+	};
+	wlr_xdg_surface_for_each_surface(view->xdg_surface, damage_surface, &data);
+}
+
 static void process_cursor_move(struct tinywl_server *server, uint32_t time) {
-	/* Move the grabbed view to the new position. */
+	/* Move the grabbed view to the new position. Both the old and the new
+	 * position need to be repainted. */
+	view_damage(server->grabbed_view, true);
 	server->grabbed_view->x = server->cursor->x - server->grab_x;
 	server->grabbed_view->y = server->cursor->y - server->grab_y;
+	view_damage(server->grabbed_view, true);
 }
 
 static void process_cursor_resize(struct tinywl_server *server, uint32_t time) {
@@ -401,8 +470,10 @@ static void process_cursor_resize(struct tinywl_server *server, uint32_t time) {
 
 	struct wlr_box geo_box;
 	wlr_xdg_surface_get_geometry(view->xdg_surface, &geo_box);
+	view_damage(view, true);
 	view->x = new_left - geo_box.x;
 	view->y = new_top - geo_box.y;
+	view_damage(view, true);
 
 	int new_width = new_right - new_left;
 	int new_height = new_bottom - new_top;
@@ -537,9 +608,30 @@ struct render_data {
 	struct wlr_output *output;
 	struct wlr_renderer *renderer;
 	struct tinywl_view *view;
-	struct timespec *when;
+	pixman_region32_t *damage;
 };
 
+static void scissor_output(struct wlr_output *output,
+		struct wlr_renderer *renderer, pixman_box32_t *rect) {
+	/* Restricts rendering to a single damage rectangle. The rectangle is in
+	 * output-buffer-local coordinates, but the GL scissor box is applied after
+	 * the output transform, so we have to transform it back. */
+	struct wlr_box box = {
+		.x = rect->x1,
+		.y = rect->y1,
+		.width = rect->x2 - rect->x1,
+		.height = rect->y2 - rect->y1,
+	};
+
+	int ow, oh;
+	wlr_output_transformed_resolution(output, &ow, &oh);
+	enum wl_output_transform transform =
+		wlr_output_transform_invert(output->transform);
+	wlr_box_transform(&box, &box, transform, ow, oh);
+
+	wlr_renderer_scissor(renderer, &box);
+}
+
 static void render_surface(struct wlr_surface *surface,
 		int sx, int sy, void *data) {
 	/* This function is called for every surface that needs to be rendered. */
@@ -592,13 +684,36 @@ static void render_surface(struct wlr_surface *surface,
 	wlr_matrix_project_box(matrix, &box, transform, 0,
 		output->transform_matrix);
 
-	/* This takes our matrix, the texture, and an alpha, and performs the actual
-	 * rendering on the GPU. */
-	wlr_render_texture_with_matrix(rdata->renderer, texture, matrix, 1);
+	/* Only the damaged part of the surface needs to be repainted. We intersect
+	 * the surface's extents with the output's accumulated damage and draw the
+	 * texture once per remaining rectangle, scissored to that rectangle. If
+	 * the surface is entirely clean, we don't touch it at all. */
+	pixman_region32_t damage;
+	pixman_region32_init(&damage);
+	pixman_region32_union_rect(&damage, &damage,
+		box.x, box.y, box.width, box.height);
+	pixman_region32_intersect(&damage, &damage, rdata->damage);
+	if (pixman_region32_not_empty(&damage)) {
+		int nrects;
+		pixman_box32_t *rects = pixman_region32_rectangles(&damage, &nrects);
+		for (int i = 0; i < nrects; i++) {
+			scissor_output(output, rdata->renderer, &rects[i]);
+			/* This takes our matrix, the texture, and an alpha, and performs
+			 * the actual rendering on the GPU. */
+			wlr_render_texture_with_matrix(rdata->renderer, texture, matrix, 1);
+		}
+	}
+	pixman_region32_fini(&damage);
+}
 
+static void surface_send_frame_done(struct wlr_surface *surface,
+		int sx, int sy, void *data) {
 	/* This lets the client know that we've displayed that frame and it can
-	 * prepare another one now if it likes. */
-	wlr_surface_send_frame_done(surface, rdata->when);
+	 * prepare another one now if it likes. It is sent even when the surface
+	 * wasn't repainted, so clients animating without damaging themselves (or
+	 * while entirely occluded by the damage region) don't stall. */
+	struct timespec *when = data;
+	wlr_surface_send_frame_done(surface, when);
 }
 
 static void output_frame(struct wl_listener *listener, void *data) {
@@ -611,51 +726,105 @@ static void output_frame(struct wl_listener *listener, void *data) {
 	struct timespec now;
 	clock_gettime(CLOCK_MONOTONIC, &now);
 
-	/* wlr_output_attach_render makes the OpenGL context current. */
-	if (!wlr_output_attach_render(output->wlr_output, NULL)) {
+	/* wlr_output_damage_attach_render makes the OpenGL context current and
+	 * resolves the age of the buffer we were handed against the damage
+	 * recorded for previous frames: buffer_damage is everything that changed
+	 * since this buffer was last on screen, in output-buffer-local
+	 * coordinates. */
+	bool needs_frame;
+	pixman_region32_t buffer_damage;
+	pixman_region32_init(&buffer_damage);
+	if (!wlr_output_damage_attach_render(output->damage,
+			&needs_frame, &buffer_damage)) {
+		pixman_region32_fini(&buffer_damage);
 		return;
 	}
-	/* The "effective" resolution can change if you rotate your outputs. */
-	int width, height;
-	wlr_output_effective_resolution(output->wlr_output, &width, &height);
-	/* Begin the renderer (calls glViewport and some other GL sanity checks) */
-	wlr_renderer_begin(renderer, width, height);
 
-	float color[4] = {0.3, 0.3, 0.3, 1.0};
-	wlr_renderer_clear(renderer, color);
+	if (needs_frame) {
+		/* The "effective" resolution can change if you rotate your outputs. */
+		int width, height;
+		wlr_output_effective_resolution(output->wlr_output, &width, &height);
+		/* Begin the renderer (calls glViewport and some other GL sanity
+		 * checks) */
+		wlr_renderer_begin(renderer, width, height);
+
+		/* Only the damaged rectangles need to be cleared; the rest of the
+		 * buffer still holds valid contents from when it was last on
+		 * screen. */
+		float color[4] = {0.3, 0.3, 0.3, 1.0};
+		int nrects;
+		pixman_box32_t *rects =
+			pixman_region32_rectangles(&buffer_damage, &nrects);
+		for (int i = 0; i < nrects; i++) {
+			scissor_output(output->wlr_output, renderer, &rects[i]);
+			wlr_renderer_clear(renderer, color);
+		}
 
-	/* Each subsequent window we render is rendered on top of the last. Because
-	 * our view list is ordered front-to-back, we iterate over it backwards. */
+		/* Each subsequent window we render is rendered on top of the last.
+		 * Because our view list is ordered front-to-back, we iterate over it
+		 * backwards. */
+		struct tinywl_view *view;
+		wl_list_for_each_reverse(view, &output->server->views, link) {
+			if (!view->mapped) {
+				/* An unmapped view should not be rendered. */
+				continue;
+			}
+			struct render_data rdata = {
+				.output = output->wlr_output,
+				.view = view,
+				.renderer = renderer,
+				.damage = &buffer_damage,
+			};
+			/* This calls our render_surface function for each surface among
+			 * the xdg_surface's toplevel and popups. */
+			wlr_xdg_surface_for_each_surface(view->xdg_surface,
+					render_surface, &rdata);
+		}
+		wlr_renderer_scissor(renderer, NULL);
+
+		/* Hardware cursors are rendered by the GPU on a separate plane, and
+		 * can be moved around without re-rendering what's beneath them -
+		 * which is more efficient. However, not all hardware supports
+		 * hardware cursors. For this reason, wlroots provides a software
+		 * fallback, which we ask it to render here, restricted to the damaged
+		 * region. wlr_cursor handles configuring hardware vs software cursors
+		 * for you, and this function is a no-op when hardware cursors are in
+		 * use. */
+		wlr_output_render_software_cursors(output->wlr_output, &buffer_damage);
+
+		/* Conclude rendering and swap the buffers, showing the final frame
+		 * on-screen. The frame damage tells the backend which part of the
+		 * buffer actually changed, so it can upload or flip only that; it is
+		 * in output-local coordinates, hence the inverse transform. */
+		wlr_renderer_end(renderer);
+
+		enum wl_output_transform transform =
+			wlr_output_transform_invert(output->wlr_output->transform);
+		pixman_region32_t frame_damage;
+		pixman_region32_init(&frame_damage);
+		wlr_region_transform(&frame_damage, &buffer_damage, transform,
+			output->wlr_output->width, output->wlr_output->height);
+		wlr_output_set_damage(output->wlr_output, &frame_damage);
+		pixman_region32_fini(&frame_damage);
+
+		wlr_output_commit(output->wlr_output);
+	} else {
+		/* Nothing on this output changed since the last frame: skip
+		 * rendering and give the buffer back untouched. */
+		wlr_output_rollback(output->wlr_output);
+	}
+	pixman_region32_fini(&buffer_damage);
+
+	/* Frame callbacks are sent whether or not we actually repainted, see
+	 * surface_send_frame_done. */
 	struct tinywl_view *view;
 	wl_list_for_each_reverse(view, &output->server->views, link) {
 		if (!view->mapped) {
-			/* An unmapped view should not be rendered. */
 			continue;
 		}
-		struct render_data rdata = {
-			.output = output->wlr_output,
-			.view = view,
-			.renderer = renderer,
-			.when = &now,
-		};
-		/* This calls our render_surface function for each surface among the
-		 * xdg_surface's toplevel and popups. */
 		wlr_xdg_surface_for_each_surface(view->xdg_surface,
-				render_surface, &rdata);
+				surface_send_frame_done, &now);
 	}
-
-	/* Hardware cursors are rendered by the GPU on a separate plane, and can be
-	 * moved around without re-rendering what's beneath them - which is more
-	 * efficient. However, not all hardware supports hardware cursors. For this
-	 * reason, wlroots provides a software fallback, which we ask it to render
-	 * here. wlr_cursor handles configuring hardware vs software cursors for you,
-	 * and this function is a no-op when hardware cursors are in use. */
-	wlr_output_render_software_cursors(output->wlr_output, NULL);
-
-	/* Conclude rendering and swap the buffers, showing the final frame
-	 * on-screen. */
-	wlr_renderer_end(renderer);
-	wlr_output_commit(output->wlr_output);
 }
 
 static void server_new_output(struct wl_listener *listener, void *data) {
@@ -684,9 +853,14 @@ static void server_new_output(struct wl_listener *listener, void *data) {
 		calloc(1, sizeof(struct tinywl_output));
 	output->wlr_output = wlr_output;
 	output->server = server;
-	/* Sets up a listener for the frame notify event. */
+	/* Damage tracking for this output: it records which parts of the output
+	 * changed between frames so we only repaint those. */
+	output->damage = wlr_output_damage_create(wlr_output);
+	/* Sets up a listener for the frame notify event. The damage tracker
+	 * forwards the output's frame events, so we listen to it rather than to
+	 * the output directly. */
 	output->frame.notify = output_frame;
-	wl_signal_add(&wlr_output->events.frame, &output->frame);
+	wl_signal_add(&output->damage->events.frame, &output->frame);
 	wl_list_insert(&server->outputs, &output->link);
 
 	/* Adds this to the output layout. The add_auto function arranges outputs
@@ -705,18 +879,32 @@ static void xdg_surface_map(struct wl_listener *listener, void *data) {
 	/* Called when the surface is mapped, or ready to display on-screen. */
 	struct tinywl_view *view = wl_container_of(listener, view, map);
 	view->mapped = true;
+	view_damage(view, true);
 	focus_view(view, view->xdg_surface->surface);
 }
 
 static void xdg_surface_unmap(struct wl_listener *listener, void *data) {
-	/* Called when the surface is unmapped, and should no longer be shown. */
+	/* Called when the surface is unmapped, and should no longer be shown. The
+	 * area it occupied has to be repainted with whatever was underneath. */
 	struct tinywl_view *view = wl_container_of(listener, view, unmap);
+	view_damage(view, true);
 	view->mapped = false;
 }
 
+static void xdg_surface_commit(struct wl_listener *listener, void *data) {
+	/* Called when the surface commits new state, e.g. a new buffer. The
+	 * client told us which parts of the surface changed; record those so
+	 * the next frame repaints them. */
+	struct tinywl_view *view = wl_container_of(listener, view, commit);
+	if (view->mapped) {
+		view_damage(view, false);
+	}
+}
+
 static void xdg_surface_destroy(struct wl_listener *listener, void *data) {
 	/* Called when the surface is destroyed and should never be shown again. */
 	struct tinywl_view *view = wl_container_of(listener, view, destroy);
+	wl_list_remove(&view->commit.link);
 	wl_list_remove(&view->link);
 	free(view);
 }
@@ -802,6 +990,8 @@ static void server_new_xdg_surface(struct wl_listener *listener, void *data) {
 	wl_signal_add(&xdg_surface->events.unmap, &view->unmap);
 	view->destroy.notify = xdg_surface_destroy;
 	wl_signal_add(&xdg_surface->events.destroy, &view->destroy);
+	view->commit.notify = xdg_surface_commit;
+	wl_signal_add(&xdg_surface->surface->events.commit, &view->commit);
 
 	/* cotd */
 	struct wlr_xdg_toplevel *toplevel = xdg_surface->toplevel;
@@ -192,6 +192,15 @@ void wlr_seat_destroy(struct wlr_seat *seat) {
 	}
 
 	wlr_global_destroy_safe(seat->global, seat->display);
+	if (seat->keyboard_state.repeat_timer != NULL) {
+		wl_event_source_remove(seat->keyboard_state.repeat_timer);
+	}
+	if (seat->touch_state.frame_idle != NULL) {
+		wl_event_source_remove(seat->touch_state.frame_idle);
+	}
+	if (seat->pointer_state.frame_idle != NULL) {
+		wl_event_source_remove(seat->pointer_state.frame_idle);
+	}
 	free(seat->pointer_state.default_grab);
 	free(seat->keyboard_state.default_grab);
 	free(seat->touch_state.default_grab);
@@ -440,16 +449,40 @@ bool wlr_seat_client_validate_event_serial(struct wlr_seat_client *client, uint3
 		return false;
 	}
 
-	for (int i = 0; i < set->count; i++) {
-		int j = (set->end - i + WLR_SERIAL_RINGSET_SIZE) % WLR_SERIAL_RINGSET_SIZE;
-		if (rev_dist < cur - set->data[j].max_incl) {
-			return false;
-		}
-		if (rev_dist <= cur - set->data[j].min_incl) {
-			return true;
+	if (set->count == 0) {
+		return false;
+	}
+
+	// The ranges are ordered from newest (i = 0) to oldest (i = count - 1),
+	// so the reverse distance from `cur` to their bounds grows with i and we
+	// can binary-search for the only range that can contain the serial: the
+	// oldest one whose max is not older than it. This keeps validation at
+	// O(log n) even when a misbehaving client probes serials.
+	if (rev_dist < cur - set->data[set->end].max_incl) {
+		// Newer than everything recorded, i.e. never sent to this client
+		return false;
+	}
+	int lo = 0, hi = set->count - 1;
+	while (lo < hi) {
+		int mid = (lo + hi + 1) / 2;
+		int j = (set->end - mid + WLR_SERIAL_RINGSET_SIZE) %
+			WLR_SERIAL_RINGSET_SIZE;
+		if (rev_dist >= cur - set->data[j].max_incl) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
 		}
 	}
 
+	int j = (set->end - lo + WLR_SERIAL_RINGSET_SIZE) % WLR_SERIAL_RINGSET_SIZE;
+	if (rev_dist <= cur - set->data[j].min_incl) {
+		return true;
+	}
+	if (lo < set->count - 1) {
+		// Falls in the gap between two recorded ranges
+		return false;
+	}
+
 	// Iff the set is full, then `rev_dist` is large enough that serial
 	// could already have been recycled out of the set.
 	return set->count == WLR_SERIAL_RINGSET_SIZE;
@@ -1,5 +1,6 @@
 #define _POSIX_C_SOURCE 200809L
 #include <assert.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
@@ -7,6 +8,7 @@
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_data_device.h>
+#include <xkbcommon/xkbcommon.h>
 #include <wlr/types/wlr_gtk_primary_selection.h>
 #include <wlr/types/wlr_input_device.h>
 #include <wlr/util/log.h>
@@ -136,6 +138,10 @@ void wlr_seat_set_keyboard(struct wlr_seat *seat,
 		wl_list_remove(&seat->keyboard_state.keyboard_destroy.link);
 		wl_list_remove(&seat->keyboard_state.keyboard_keymap.link);
 		wl_list_remove(&seat->keyboard_state.keyboard_repeat_info.link);
+		if (seat->keyboard_state.repeat_timer != NULL) {
+			// Don't repeat a key from the previous keyboard
+			wl_event_source_timer_update(seat->keyboard_state.repeat_timer, 0);
+		}
 		seat->keyboard_state.keyboard = NULL;
 	}
 
@@ -343,11 +349,88 @@ void wlr_seat_keyboard_notify_modifiers(struct wlr_seat *seat,
 	grab->interface->modifiers(grab, modifiers);
 }
 
+static void keyboard_repeat_disarm(struct wlr_seat *seat) {
+	if (seat->keyboard_state.repeat_timer != NULL) {
+		wl_event_source_timer_update(seat->keyboard_state.repeat_timer, 0);
+	}
+}
+
+static int keyboard_repeat_timer_handler(void *data) {
+	struct wlr_seat *seat = data;
+	struct wlr_keyboard *keyboard = seat->keyboard_state.keyboard;
+	if (!seat->keyboard_state.repeat_enabled || keyboard == NULL ||
+			keyboard->repeat_info.rate <= 0) {
+		return 0;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	uint32_t time = now.tv_sec * 1000 + now.tv_nsec / 1000000;
+
+	struct wlr_seat_keyboard_grab *grab = seat->keyboard_state.grab;
+	grab->interface->key(grab, time, seat->keyboard_state.repeat_key,
+		WL_KEYBOARD_KEY_STATE_PRESSED);
+
+	wl_event_source_timer_update(seat->keyboard_state.repeat_timer,
+		1000 / keyboard->repeat_info.rate);
+	return 0;
+}
+
+static void keyboard_update_repeat(struct wlr_seat *seat, uint32_t key,
+		uint32_t state) {
+	struct wlr_seat_keyboard_state *kb_state = &seat->keyboard_state;
+	struct wlr_keyboard *keyboard = kb_state->keyboard;
+
+	if (state != WL_KEYBOARD_KEY_STATE_PRESSED) {
+		// Only the most recently pressed key repeats
+		if (key == kb_state->repeat_key) {
+			keyboard_repeat_disarm(seat);
+		}
+		return;
+	}
+
+	if (keyboard == NULL || keyboard->repeat_info.rate <= 0 ||
+			keyboard->repeat_info.delay <= 0) {
+		keyboard_repeat_disarm(seat);
+		return;
+	}
+	// Keycodes are offset by 8 between evdev and XKB
+	if (keyboard->keymap != NULL &&
+			!xkb_keymap_key_repeats(keyboard->keymap, key + 8)) {
+		return;
+	}
+
+	if (kb_state->repeat_timer == NULL) {
+		struct wl_event_loop *loop =
+			wl_display_get_event_loop(seat->display);
+		kb_state->repeat_timer = wl_event_loop_add_timer(loop,
+			keyboard_repeat_timer_handler, seat);
+		if (kb_state->repeat_timer == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create keyboard repeat timer");
+			return;
+		}
+	}
+	kb_state->repeat_key = key;
+	wl_event_source_timer_update(kb_state->repeat_timer,
+		keyboard->repeat_info.delay);
+}
+
+void wlr_seat_keyboard_set_repeat(struct wlr_seat *seat, bool enabled) {
+	seat->keyboard_state.repeat_enabled = enabled;
+	if (!enabled) {
+		keyboard_repeat_disarm(seat);
+	}
+}
+
 void wlr_seat_keyboard_notify_key(struct wlr_seat *seat, uint32_t time,
 		uint32_t key, uint32_t state) {
 	clock_gettime(CLOCK_MONOTONIC, &seat->last_event);
 	struct wlr_seat_keyboard_grab *grab = seat->keyboard_state.grab;
 	grab->interface->key(grab, time, key, state);
+
+	if (seat->keyboard_state.repeat_enabled) {
+		keyboard_update_repeat(seat, key, state);
+	}
 }
 
 
@@ -365,6 +448,22 @@ static void seat_client_send_keymap(struct wlr_seat_client *client,
 			continue;
 		}
 
+		if (keyboard->keymap_fd >= 0) {
+			// Every client shares the keyboard's sealed read-only keymap
+			// file, each one just gets its own descriptor to it
+			int keymap_fd = fcntl(keyboard->keymap_fd, F_DUPFD_CLOEXEC, 0);
+			if (keymap_fd < 0) {
+				wlr_log_errno(WLR_ERROR, "failed to dup() the keymap fd");
+				continue;
+			}
+			wl_keyboard_send_keymap(resource,
+				WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1, keymap_fd,
+				keyboard->keymap_size);
+			close(keymap_fd);
+			continue;
+		}
+
+		// Fall back to a private copy per client
 		int keymap_fd = allocate_shm_file(keyboard->keymap_size);
 		if (keymap_fd < 0) {
 			wlr_log(WLR_ERROR, "creating a keymap file for %zu bytes failed", keyboard->keymap_size);
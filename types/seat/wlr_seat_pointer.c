@@ -7,6 +7,7 @@
 #include <wlr/types/wlr_input_device.h>
 #include <wlr/util/log.h>
 #include "types/wlr_seat.h"
+#include "util/flush.h"
 #include "util/signal.h"
 #include "util/array.h"
 
@@ -125,6 +126,71 @@ bool wlr_seat_pointer_surface_has_focus(struct wlr_seat *wlr_seat,
 	return surface == wlr_seat->pointer_state.focused_surface;
 }
 
+/**
+ * Send out the deferred motion and frame events. Motion from high-rate mice
+ * is coalesced per dispatch cycle: only the latest coordinates are kept, and
+ * they go out with a single frame either from here or from the idle source,
+ * so a burst of N events costs one motion and one frame on the wire.
+ */
+static void pointer_flush(struct wlr_seat *wlr_seat) {
+	struct wlr_seat_pointer_state *state = &wlr_seat->pointer_state;
+	if (state->frame_idle != NULL) {
+		wl_event_source_remove(state->frame_idle);
+		state->frame_idle = NULL;
+	}
+	if (!state->motion_pending && !state->frame_pending) {
+		return;
+	}
+
+	bool send_motion = state->motion_pending;
+	bool send_frame = state->frame_pending;
+	state->motion_pending = false;
+	state->frame_pending = false;
+
+	struct wlr_seat_client *client = state->focused_client;
+	if (client == NULL) {
+		return;
+	}
+
+	struct wl_resource *resource;
+	wl_resource_for_each(resource, &client->pointers) {
+		if (wlr_seat_client_from_pointer_resource(resource) == NULL) {
+			continue;
+		}
+
+		if (send_motion) {
+			wl_pointer_send_motion(resource, state->motion_time,
+				wl_fixed_from_double(state->pending_sx),
+				wl_fixed_from_double(state->pending_sy));
+		}
+		if (send_frame) {
+			pointer_send_frame(resource);
+		}
+	}
+
+	// Leave the socket write to the shared end-of-turn flush pass
+	client_flush_soon(client->client);
+}
+
+static void pointer_frame_idle_handler(void *data) {
+	struct wlr_seat *wlr_seat = data;
+	wlr_seat->pointer_state.frame_idle = NULL;
+	pointer_flush(wlr_seat);
+}
+
+static void pointer_schedule_flush(struct wlr_seat *wlr_seat) {
+	struct wlr_seat_pointer_state *state = &wlr_seat->pointer_state;
+	if (state->frame_idle == NULL) {
+		struct wl_event_loop *loop =
+			wl_display_get_event_loop(wlr_seat->display);
+		state->frame_idle = wl_event_loop_add_idle(loop,
+			pointer_frame_idle_handler, wlr_seat);
+		if (state->frame_idle == NULL) {
+			pointer_flush(wlr_seat);
+		}
+	}
+}
+
 static void seat_pointer_handle_surface_destroy(struct wl_listener *listener,
 		void *data) {
 	struct wlr_seat_pointer_state *state =
@@ -155,6 +221,9 @@ void wlr_seat_pointer_enter(struct wlr_seat *wlr_seat,
 		return;
 	}
 
+	// The leave must not overtake motion still waiting for the flush
+	pointer_flush(wlr_seat);
+
 	struct wlr_seat_client *client = NULL;
 	if (surface) {
 		struct wl_client *wl_client = wl_resource_get_client(surface->resource);
@@ -234,21 +303,21 @@ void wlr_seat_pointer_send_motion(struct wlr_seat *wlr_seat, uint32_t time,
 		return;
 	}
 
-	struct wl_resource *resource;
-	wl_resource_for_each(resource, &client->pointers) {
-		if (wlr_seat_client_from_pointer_resource(resource) == NULL) {
-			continue;
-		}
-
-		wl_pointer_send_motion(resource, time, wl_fixed_from_double(sx),
-			wl_fixed_from_double(sy));
-	}
+	// Only the latest coordinates matter: defer the event and let the flush
+	// collapse a motion burst into a single motion
+	wlr_seat->pointer_state.motion_pending = true;
+	wlr_seat->pointer_state.motion_time = time;
+	wlr_seat->pointer_state.pending_sx = sx;
+	wlr_seat->pointer_state.pending_sy = sy;
+	pointer_schedule_flush(wlr_seat);
 
 	wlr_seat_pointer_warp(wlr_seat, sx, sy);
 }
 
 uint32_t wlr_seat_pointer_send_button(struct wlr_seat *wlr_seat, uint32_t time,
 		uint32_t button, enum wlr_button_state state) {
+	pointer_flush(wlr_seat);
+
 	struct wlr_seat_client *client = wlr_seat->pointer_state.focused_client;
 	if (client == NULL) {
 		return 0;
@@ -269,6 +338,8 @@ uint32_t wlr_seat_pointer_send_button(struct wlr_seat *wlr_seat, uint32_t time,
 void wlr_seat_pointer_send_axis(struct wlr_seat *wlr_seat, uint32_t time,
 		enum wlr_axis_orientation orientation, double value,
 		int32_t value_discrete, enum wlr_axis_source source) {
+	pointer_flush(wlr_seat);
+
 	struct wlr_seat_client *client = wlr_seat->pointer_state.focused_client;
 	if (client == NULL) {
 		return;
@@ -306,6 +377,14 @@ void wlr_seat_pointer_send_frame(struct wlr_seat *wlr_seat) {
 		return;
 	}
 
+	if (wlr_seat->pointer_state.motion_pending) {
+		// Ride along with the deferred motion instead of ending its group
+		// early: the flush sends one frame for the whole burst
+		wlr_seat->pointer_state.frame_pending = true;
+		pointer_schedule_flush(wlr_seat);
+		return;
+	}
+
 	struct wl_resource *resource;
 	wl_resource_for_each(resource, &client->pointers) {
 		if (wlr_seat_client_from_pointer_resource(resource) == NULL) {
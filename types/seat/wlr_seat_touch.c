@@ -8,6 +8,11 @@
 #include <wlr/util/log.h>
 #include "types/wlr_seat.h"
 #include "util/signal.h"
+#include "util/slab.h"
+
+// One touch point is created and destroyed per finger down/up
+static struct wlr_slab touch_point_slab;
+static bool touch_point_slab_initialized = false;
 
 static uint32_t default_touch_down(struct wlr_seat_touch_grab *grab,
 		uint32_t time, struct wlr_touch_point *point) {
@@ -103,7 +108,7 @@ static void touch_point_destroy(struct wlr_touch_point *point) {
 	wl_list_remove(&point->surface_destroy.link);
 	wl_list_remove(&point->client_destroy.link);
 	wl_list_remove(&point->link);
-	free(point);
+	wlr_slab_free(&touch_point_slab, point);
 }
 
 static void touch_point_handle_surface_destroy(struct wl_listener *listener,
@@ -135,7 +140,11 @@ static struct wlr_touch_point *touch_point_create(
 		return NULL;
 	}
 
-	struct wlr_touch_point *point = calloc(1, sizeof(struct wlr_touch_point));
+	if (!touch_point_slab_initialized) {
+		wlr_slab_init(&touch_point_slab, sizeof(struct wlr_touch_point));
+		touch_point_slab_initialized = true;
+	}
+	struct wlr_touch_point *point = wlr_slab_alloc(&touch_point_slab);
 	if (!point) {
 		return NULL;
 	}
@@ -158,6 +167,59 @@ static struct wlr_touch_point *touch_point_create(
 	return point;
 }
 
+static void touch_send_frames(struct wlr_seat *seat) {
+	struct wlr_seat_client *client;
+	wl_list_for_each(client, &seat->clients, link) {
+		if (!client->needs_touch_frame) {
+			continue;
+		}
+		client->needs_touch_frame = false;
+
+		struct wl_resource *resource;
+		wl_resource_for_each(resource, &client->touches) {
+			if (seat_client_from_touch_resource(resource) == NULL) {
+				continue;
+			}
+			wl_touch_send_frame(resource);
+		}
+	}
+}
+
+static void touch_frame_idle_handler(void *data) {
+	struct wlr_seat *seat = data;
+	seat->touch_state.frame_idle = NULL;
+	touch_send_frames(seat);
+}
+
+/**
+ * Mark the client as needing a wl_touch.frame. The frame is sent once the
+ * compositor calls wlr_seat_touch_notify_frame(), or from an idle source once
+ * control returns to the event loop, so that all touch points updated in one
+ * dispatch cycle are delivered as a single batch with a single frame.
+ */
+static void touch_frame_schedule(struct wlr_seat *seat,
+		struct wlr_seat_client *client) {
+	client->needs_touch_frame = true;
+
+	if (seat->touch_state.frame_idle == NULL) {
+		struct wl_event_loop *loop = wl_display_get_event_loop(seat->display);
+		seat->touch_state.frame_idle = wl_event_loop_add_idle(loop,
+			touch_frame_idle_handler, seat);
+		if (seat->touch_state.frame_idle == NULL) {
+			// Don't leave the client without a frame
+			touch_send_frames(seat);
+		}
+	}
+}
+
+void wlr_seat_touch_notify_frame(struct wlr_seat *seat) {
+	if (seat->touch_state.frame_idle != NULL) {
+		wl_event_source_remove(seat->touch_state.frame_idle);
+		seat->touch_state.frame_idle = NULL;
+	}
+	touch_send_frames(seat);
+}
+
 struct wlr_touch_point *wlr_seat_touch_get_point(
 		struct wlr_seat *seat, int32_t touch_id) {
 	struct wlr_touch_point *point = NULL;
@@ -303,8 +365,8 @@ uint32_t wlr_seat_touch_send_down(struct wlr_seat *seat,
 		}
 		wl_touch_send_down(resource, serial, time, surface->resource,
 			touch_id, wl_fixed_from_double(sx), wl_fixed_from_double(sy));
-		wl_touch_send_frame(resource);
 	}
+	touch_frame_schedule(seat, point->client);
 
 	return serial;
 }
@@ -323,8 +385,8 @@ void wlr_seat_touch_send_up(struct wlr_seat *seat, uint32_t time, int32_t touch_
 			continue;
 		}
 		wl_touch_send_up(resource, serial, time, touch_id);
-		wl_touch_send_frame(resource);
 	}
+	touch_frame_schedule(seat, point->client);
 }
 
 void wlr_seat_touch_send_motion(struct wlr_seat *seat, uint32_t time, int32_t touch_id,
@@ -342,8 +404,8 @@ void wlr_seat_touch_send_motion(struct wlr_seat *seat, uint32_t time, int32_t to
 		}
 		wl_touch_send_motion(resource, time, touch_id, wl_fixed_from_double(sx),
 			wl_fixed_from_double(sy));
-		wl_touch_send_frame(resource);
 	}
+	touch_frame_schedule(seat, point->client);
 }
 
 int wlr_seat_touch_num_points(struct wlr_seat *seat) {
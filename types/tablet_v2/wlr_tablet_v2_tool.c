@@ -9,6 +9,7 @@
 #include <stdlib.h>
 #include <types/wlr_tablet_v2.h>
 #include <wayland-util.h>
+#include <wlr/types/wlr_surface.h>
 #include <wlr/types/wlr_tablet_tool.h>
 #include <wlr/types/wlr_tablet_v2.h>
 #include <wlr/util/log.h>
@@ -302,9 +303,60 @@ static ssize_t tablet_tool_button_update(struct wlr_tablet_v2_tablet_tool *tool,
 	return i;
 }
 
+/**
+ * Whether axis updates for the client should be coalesced until the next
+ * frame event instead of being sent immediately. A client waiting on a frame
+ * callback is actively drawing with the tool and wants every report at full
+ * fidelity; for everyone else the latest value per axis is enough, which
+ * keeps a 200+ Hz pen from waking an idle client for every report.
+ */
+static bool tool_client_defers_axes(struct wlr_tablet_tool_client_v2 *tool) {
+	struct wlr_surface *surface = tool->tool->focused_surface;
+	return surface == NULL ||
+		wl_list_empty(&surface->current.frame_callback_list);
+}
+
+static void tool_client_flush_axes(struct wlr_tablet_tool_client_v2 *tool) {
+	uint32_t axes = tool->deferred_axes;
+	tool->deferred_axes = 0;
+
+	if (axes & (WLR_TABLET_TOOL_AXIS_X | WLR_TABLET_TOOL_AXIS_Y)) {
+		zwp_tablet_tool_v2_send_motion(tool->resource,
+			wl_fixed_from_double(tool->x), wl_fixed_from_double(tool->y));
+	}
+	if (axes & WLR_TABLET_TOOL_AXIS_PRESSURE) {
+		zwp_tablet_tool_v2_send_pressure(tool->resource,
+			tool->pressure * 65535);
+	}
+	if (axes & WLR_TABLET_TOOL_AXIS_DISTANCE) {
+		zwp_tablet_tool_v2_send_distance(tool->resource,
+			tool->distance * 65535);
+	}
+	if (axes & (WLR_TABLET_TOOL_AXIS_TILT_X | WLR_TABLET_TOOL_AXIS_TILT_Y)) {
+		zwp_tablet_tool_v2_send_tilt(tool->resource,
+			wl_fixed_from_double(tool->tilt_x),
+			wl_fixed_from_double(tool->tilt_y));
+	}
+	if (axes & WLR_TABLET_TOOL_AXIS_ROTATION) {
+		zwp_tablet_tool_v2_send_rotation(tool->resource,
+			wl_fixed_from_double(tool->rotation));
+	}
+	if (axes & WLR_TABLET_TOOL_AXIS_SLIDER) {
+		zwp_tablet_tool_v2_send_slider(tool->resource,
+			tool->slider * 65535);
+	}
+	if (axes & WLR_TABLET_TOOL_AXIS_WHEEL) {
+		zwp_tablet_tool_v2_send_wheel(tool->resource,
+			tool->wheel_clicks, tool->wheel_degrees);
+		tool->wheel_degrees = 0;
+		tool->wheel_clicks = 0;
+	}
+}
+
 static void send_tool_frame(void *data) {
 	struct wlr_tablet_tool_client_v2 *tool = data;
 
+	tool_client_flush_axes(tool);
 	zwp_tablet_tool_v2_send_frame(tool->resource, get_current_time_msec());
 	tool->frame_source = NULL;
 }
@@ -397,14 +449,23 @@ void wlr_send_tablet_v2_tablet_tool_proximity_in(
 
 void wlr_send_tablet_v2_tablet_tool_motion(
 		struct wlr_tablet_v2_tablet_tool *tool, double x, double y) {
-	if (!tool->current_client) {
+	struct wlr_tablet_tool_client_v2 *client = tool->current_client;
+	if (!client) {
 		return;
 	}
 
-	zwp_tablet_tool_v2_send_motion(tool->current_client->resource,
-		wl_fixed_from_double(x), wl_fixed_from_double(y));
+	if (tool_client_defers_axes(client)) {
+		client->x = x;
+		client->y = y;
+		client->deferred_axes |=
+			WLR_TABLET_TOOL_AXIS_X | WLR_TABLET_TOOL_AXIS_Y;
+	} else {
+		tool_client_flush_axes(client);
+		zwp_tablet_tool_v2_send_motion(client->resource,
+			wl_fixed_from_double(x), wl_fixed_from_double(y));
+	}
 
-	queue_tool_frame(tool->current_client);
+	queue_tool_frame(client);
 }
 
 void wlr_send_tablet_v2_tablet_tool_proximity_out(
@@ -435,58 +496,96 @@ void wlr_send_tablet_v2_tablet_tool_proximity_out(
 
 void wlr_send_tablet_v2_tablet_tool_pressure(
 		struct wlr_tablet_v2_tablet_tool *tool, double pressure) {
-	if (tool->current_client) {
-		zwp_tablet_tool_v2_send_pressure(tool->current_client->resource,
-			pressure * 65535);
+	struct wlr_tablet_tool_client_v2 *client = tool->current_client;
+	if (!client) {
+		return;
+	}
 
-		queue_tool_frame(tool->current_client);
+	if (tool_client_defers_axes(client)) {
+		client->pressure = pressure;
+		client->deferred_axes |= WLR_TABLET_TOOL_AXIS_PRESSURE;
+	} else {
+		tool_client_flush_axes(client);
+		zwp_tablet_tool_v2_send_pressure(client->resource, pressure * 65535);
 	}
+
+	queue_tool_frame(client);
 }
 
 void wlr_send_tablet_v2_tablet_tool_distance(
 		struct wlr_tablet_v2_tablet_tool *tool, double distance) {
-	if (tool->current_client) {
-		zwp_tablet_tool_v2_send_distance(tool->current_client->resource,
-			distance * 65535);
+	struct wlr_tablet_tool_client_v2 *client = tool->current_client;
+	if (!client) {
+		return;
+	}
 
-		queue_tool_frame(tool->current_client);
+	if (tool_client_defers_axes(client)) {
+		client->distance = distance;
+		client->deferred_axes |= WLR_TABLET_TOOL_AXIS_DISTANCE;
+	} else {
+		tool_client_flush_axes(client);
+		zwp_tablet_tool_v2_send_distance(client->resource, distance * 65535);
 	}
+
+	queue_tool_frame(client);
 }
 
 void wlr_send_tablet_v2_tablet_tool_tilt(
 		struct wlr_tablet_v2_tablet_tool *tool, double x, double y) {
-	if (!tool->current_client) {
+	struct wlr_tablet_tool_client_v2 *client = tool->current_client;
+	if (!client) {
 		return;
 	}
 
-	zwp_tablet_tool_v2_send_tilt(tool->current_client->resource,
-		wl_fixed_from_double(x), wl_fixed_from_double(y));
+	if (tool_client_defers_axes(client)) {
+		client->tilt_x = x;
+		client->tilt_y = y;
+		client->deferred_axes |=
+			WLR_TABLET_TOOL_AXIS_TILT_X | WLR_TABLET_TOOL_AXIS_TILT_Y;
+	} else {
+		tool_client_flush_axes(client);
+		zwp_tablet_tool_v2_send_tilt(client->resource,
+			wl_fixed_from_double(x), wl_fixed_from_double(y));
+	}
 
-	queue_tool_frame(tool->current_client);
+	queue_tool_frame(client);
 }
 
 void wlr_send_tablet_v2_tablet_tool_rotation(
 		struct wlr_tablet_v2_tablet_tool *tool, double degrees) {
-	if (!tool->current_client) {
+	struct wlr_tablet_tool_client_v2 *client = tool->current_client;
+	if (!client) {
 		return;
 	}
 
-	zwp_tablet_tool_v2_send_rotation(tool->current_client->resource,
-		wl_fixed_from_double(degrees));
+	if (tool_client_defers_axes(client)) {
+		client->rotation = degrees;
+		client->deferred_axes |= WLR_TABLET_TOOL_AXIS_ROTATION;
+	} else {
+		tool_client_flush_axes(client);
+		zwp_tablet_tool_v2_send_rotation(client->resource,
+			wl_fixed_from_double(degrees));
+	}
 
-	queue_tool_frame(tool->current_client);
+	queue_tool_frame(client);
 }
 
 void wlr_send_tablet_v2_tablet_tool_slider(
 		struct wlr_tablet_v2_tablet_tool *tool, double position) {
-	if (!tool->current_client) {
+	struct wlr_tablet_tool_client_v2 *client = tool->current_client;
+	if (!client) {
 		return;
 	}
 
-	zwp_tablet_tool_v2_send_slider(tool->current_client->resource,
-		position * 65535);
+	if (tool_client_defers_axes(client)) {
+		client->slider = position;
+		client->deferred_axes |= WLR_TABLET_TOOL_AXIS_SLIDER;
+	} else {
+		tool_client_flush_axes(client);
+		zwp_tablet_tool_v2_send_slider(client->resource, position * 65535);
+	}
 
-	queue_tool_frame(tool->current_client);
+	queue_tool_frame(client);
 }
 
 void wlr_send_tablet_v2_tablet_tool_button(
@@ -509,12 +608,23 @@ void wlr_send_tablet_v2_tablet_tool_button(
 
 void wlr_send_tablet_v2_tablet_tool_wheel(
 	struct wlr_tablet_v2_tablet_tool *tool, double degrees, int32_t clicks) {
-	if (tool->current_client) {
-		zwp_tablet_tool_v2_send_wheel(tool->current_client->resource,
-			clicks, degrees);
+	struct wlr_tablet_tool_client_v2 *client = tool->current_client;
+	if (!client) {
+		return;
+	}
 
-		queue_tool_frame(tool->current_client);
+	if (tool_client_defers_axes(client)) {
+		// Wheel events carry deltas, accumulate them instead of keeping
+		// only the latest
+		client->wheel_degrees += degrees;
+		client->wheel_clicks += clicks;
+		client->deferred_axes |= WLR_TABLET_TOOL_AXIS_WHEEL;
+	} else {
+		tool_client_flush_axes(client);
+		zwp_tablet_tool_v2_send_wheel(client->resource, clicks, degrees);
 	}
+
+	queue_tool_frame(client);
 }
 
 void wlr_send_tablet_v2_tablet_tool_down(struct wlr_tablet_v2_tablet_tool *tool) {
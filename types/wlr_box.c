@@ -150,6 +150,52 @@ void wlr_box_rotated_bounds(struct wlr_box *dest, const struct wlr_box *box,
 	dest->height = ceil(fmax(y1, y2) - fmin(y1, y2));
 }
 
+void wlr_box_batch_intersect(size_t len, int x1[], int y1[], int x2[],
+		int y2[], const struct wlr_box *clip) {
+	int cx1 = clip->x;
+	int cy1 = clip->y;
+	int cx2 = clip->x + clip->width;
+	int cy2 = clip->y + clip->height;
+	for (size_t i = 0; i < len; ++i) {
+		x1[i] = x1[i] > cx1 ? x1[i] : cx1;
+		y1[i] = y1[i] > cy1 ? y1[i] : cy1;
+		x2[i] = x2[i] < cx2 ? x2[i] : cx2;
+		y2[i] = y2[i] < cy2 ? y2[i] : cy2;
+	}
+}
+
+size_t wlr_box_batch_contains_point(size_t len, const int x1[],
+		const int y1[], const int x2[], const int y2[], double x, double y) {
+	for (size_t i = 0; i < len; ++i) {
+		if (x >= x1[i] && x < x2[i] && y >= y1[i] && y < y2[i]) {
+			return i;
+		}
+	}
+	return len;
+}
+
+void wlr_box_batch_bounds(struct wlr_box *dest, size_t len, const int x1[],
+		const int y1[], const int x2[], const int y2[]) {
+	if (len == 0) {
+		*dest = (struct wlr_box){0};
+		return;
+	}
+
+	int bx1 = INT_MAX, by1 = INT_MAX;
+	int bx2 = INT_MIN, by2 = INT_MIN;
+	for (size_t i = 0; i < len; ++i) {
+		bx1 = x1[i] < bx1 ? x1[i] : bx1;
+		by1 = y1[i] < by1 ? y1[i] : by1;
+		bx2 = x2[i] > bx2 ? x2[i] : bx2;
+		by2 = y2[i] > by2 ? y2[i] : by2;
+	}
+
+	dest->x = bx1;
+	dest->y = by1;
+	dest->width = bx2 - bx1;
+	dest->height = by2 - by1;
+}
+
 void wlr_box_from_pixman_box32(struct wlr_box *dest, const pixman_box32_t box) {
 	*dest = (struct wlr_box){
 		.x = box.x1,
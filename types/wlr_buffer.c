@@ -4,8 +4,20 @@
 #include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_linux_dmabuf_v1.h>
 #include <wlr/util/log.h>
+#include "util/gpu_memory.h"
 #include "util/signal.h"
 
+static bool release_batching_enabled = false;
+// wlr_client_buffer::deferred_link, lazily initialized
+static struct wl_list deferred_releases;
+
+static struct wl_list *get_deferred_releases(void) {
+	if (deferred_releases.next == NULL) {
+		wl_list_init(&deferred_releases);
+	}
+	return &deferred_releases;
+}
+
 void wlr_buffer_init(struct wlr_buffer *buffer,
 		const struct wlr_buffer_impl *impl, int width, int height) {
 	assert(impl->destroy);
@@ -117,8 +129,10 @@ static void client_buffer_destroy(struct wlr_buffer *_buffer) {
 		wl_buffer_send_release(buffer->resource);
 	}
 
+	wl_list_remove(&buffer->deferred_link);
 	wl_list_remove(&buffer->resource_destroy.link);
 	wlr_texture_destroy(buffer->texture);
+	gpu_memory_client_sub(buffer->mem_client, buffer->mem_bytes);
 	free(buffer);
 }
 
@@ -155,6 +169,14 @@ static void client_buffer_resource_handle_destroy(struct wl_listener *listener,
 	wl_list_init(&buffer->resource_destroy.link);
 	buffer->resource = NULL;
 
+	// If the texture samples directly from the client's wl_shm pool, it must
+	// stop doing so before the pool gets unmapped
+	if (buffer->texture != NULL && !wlr_texture_detach(buffer->texture)) {
+		wlr_log(WLR_ERROR, "Failed to detach texture from destroyed wl_buffer");
+		wlr_texture_destroy(buffer->texture);
+		buffer->texture = NULL;
+	}
+
 	// At this point, if the wl_buffer comes from linux-dmabuf or wl_drm, we
 	// still haven't released it (ie. we'll read it in the future) but the
 	// client destroyed it. Reading the texture itself should be fine because
@@ -163,13 +185,50 @@ static void client_buffer_resource_handle_destroy(struct wl_listener *listener,
 	// which case we'll read garbage. We decide to accept this risk.
 }
 
+static void client_buffer_send_release(struct wlr_client_buffer *buffer) {
+	if (buffer->resource_released || buffer->resource == NULL) {
+		return;
+	}
+
+	if (release_batching_enabled) {
+		if (wl_list_empty(&buffer->deferred_link)) {
+			wl_list_insert(get_deferred_releases()->prev,
+				&buffer->deferred_link);
+		}
+		return;
+	}
+
+	wl_buffer_send_release(buffer->resource);
+	buffer->resource_released = true;
+}
+
 static void client_buffer_handle_release(struct wl_listener *listener,
 		void *data) {
 	struct wlr_client_buffer *buffer =
 		wl_container_of(listener, buffer, release);
-	if (!buffer->resource_released && buffer->resource != NULL) {
-		wl_buffer_send_release(buffer->resource);
-		buffer->resource_released = true;
+	client_buffer_send_release(buffer);
+}
+
+void wlr_buffer_flush_releases(void) {
+	if (deferred_releases.next == NULL) {
+		return;
+	}
+
+	struct wlr_client_buffer *buffer, *tmp;
+	wl_list_for_each_safe(buffer, tmp, &deferred_releases, deferred_link) {
+		wl_list_remove(&buffer->deferred_link);
+		wl_list_init(&buffer->deferred_link);
+		if (!buffer->resource_released && buffer->resource != NULL) {
+			wl_buffer_send_release(buffer->resource);
+			buffer->resource_released = true;
+		}
+	}
+}
+
+void wlr_buffer_set_release_batching(bool enabled) {
+	release_batching_enabled = enabled;
+	if (!enabled) {
+		wlr_buffer_flush_releases();
 	}
 }
 
@@ -182,21 +241,29 @@ struct wlr_client_buffer *wlr_client_buffer_import(
 
 	struct wl_shm_buffer *shm_buf = wl_shm_buffer_get(resource);
 	if (shm_buf != NULL) {
-		enum wl_shm_format fmt = wl_shm_buffer_get_format(shm_buf);
-		int32_t stride = wl_shm_buffer_get_stride(shm_buf);
-		int32_t width = wl_shm_buffer_get_width(shm_buf);
-		int32_t height = wl_shm_buffer_get_height(shm_buf);
-
-		wl_shm_buffer_begin_access(shm_buf);
-		void *data = wl_shm_buffer_get_data(shm_buf);
-		texture = wlr_texture_from_pixels(renderer, fmt, stride,
-			width, height, data);
-		wl_shm_buffer_end_access(shm_buf);
+		// If the renderer can sample directly from the client's mapped pool,
+		// skip the upload entirely. Withholding wl_buffer.release prevents
+		// the client from writing into the buffer while we read it, just
+		// like the DMA-BUF path below.
+		texture = wlr_texture_from_shm_resource(renderer, resource);
+
+		if (texture == NULL) {
+			enum wl_shm_format fmt = wl_shm_buffer_get_format(shm_buf);
+			int32_t stride = wl_shm_buffer_get_stride(shm_buf);
+			int32_t width = wl_shm_buffer_get_width(shm_buf);
+			int32_t height = wl_shm_buffer_get_height(shm_buf);
+
+			wl_shm_buffer_begin_access(shm_buf);
+			void *data = wl_shm_buffer_get_data(shm_buf);
+			texture = wlr_texture_from_pixels(renderer, fmt, stride,
+				width, height, data);
+			wl_shm_buffer_end_access(shm_buf);
 
-		// We have uploaded the data, we don't need to access the wl_buffer
-		// anymore
-		wl_buffer_send_release(resource);
-		resource_released = true;
+			// We have uploaded the data, we don't need to access the
+			// wl_buffer anymore
+			wl_buffer_send_release(resource);
+			resource_released = true;
+		}
 	} else if (wlr_renderer_resource_is_wl_drm_buffer(renderer, resource)) {
 		texture = wlr_texture_from_wl_drm(renderer, resource);
 	} else if (wlr_dmabuf_v1_resource_is_buffer(resource)) {
@@ -234,6 +301,7 @@ struct wlr_client_buffer *wlr_client_buffer_import(
 	buffer->resource = resource;
 	buffer->texture = texture;
 	buffer->resource_released = resource_released;
+	wl_list_init(&buffer->deferred_link);
 
 	wl_resource_add_destroy_listener(resource, &buffer->resource_destroy);
 	buffer->resource_destroy.notify = client_buffer_resource_handle_destroy;
@@ -241,6 +309,12 @@ struct wlr_client_buffer *wlr_client_buffer_import(
 	buffer->release.notify = client_buffer_handle_release;
 	wl_signal_add(&buffer->base.events.release, &buffer->release);
 
+	// Attribute the import to the client; the texture's own format isn't
+	// known here, so estimate with 32 bits per pixel
+	buffer->mem_client = wl_resource_get_client(resource);
+	buffer->mem_bytes = (size_t)texture->width * texture->height * 4;
+	gpu_memory_client_add(buffer->mem_client, buffer->mem_bytes);
+
 	// Ensure the buffer will be released before being destroyed
 	wlr_buffer_lock(&buffer->base);
 	wlr_buffer_drop(&buffer->base);
@@ -285,29 +359,24 @@ struct wlr_client_buffer *wlr_client_buffer_apply_damage(
 	wl_shm_buffer_begin_access(shm_buf);
 	void *data = wl_shm_buffer_get_data(shm_buf);
 
-	int n;
-	pixman_box32_t *rects = pixman_region32_rectangles(damage, &n);
-	for (int i = 0; i < n; ++i) {
-		pixman_box32_t *r = &rects[i];
-		if (!wlr_texture_write_pixels(buffer->texture, stride,
-				r->x2 - r->x1, r->y2 - r->y1, r->x1, r->y1,
-				r->x1, r->y1, data)) {
-			wl_shm_buffer_end_access(shm_buf);
-			return NULL;
-		}
+	if (!wlr_texture_write_pixels_region(buffer->texture, stride, damage,
+			data)) {
+		wl_shm_buffer_end_access(shm_buf);
+		return NULL;
 	}
 
 	wl_shm_buffer_end_access(shm_buf);
 
-	// We have uploaded the data, we don't need to access the wl_buffer
-	// anymore
-	wl_buffer_send_release(resource);
-
 	wl_list_remove(&buffer->resource_destroy.link);
 	wl_resource_add_destroy_listener(resource, &buffer->resource_destroy);
 	buffer->resource_destroy.notify = client_buffer_resource_handle_destroy;
 
 	buffer->resource = resource;
-	buffer->resource_released = true;
+
+	// We have uploaded the data, we don't need to access the wl_buffer
+	// anymore
+	buffer->resource_released = false;
+	client_buffer_send_release(buffer);
+
 	return buffer;
 }
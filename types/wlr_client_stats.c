@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include <wayland-server-core.h>
+#include "types/wlr_client_stats.h"
+#include "util/time.h"
+
+struct client_stats_state {
+	struct wl_client *client;
+	struct wlr_client_stats stats;
+
+	// Accumulation window the per-second rates are computed from
+	uint32_t window_start_msec;
+	uint32_t window_commits;
+	uint32_t window_damage_rects;
+
+	struct wl_list link; // stats_states
+	struct wl_listener client_destroy;
+};
+
+static struct wl_list stats_states; // client_stats_state.link, lazily initialized
+
+static wlr_client_throttle_hook_t throttle_hook;
+static void *throttle_hook_data;
+static uint32_t throttle_max_commits;
+static uint32_t throttle_max_damage_rects;
+
+static void handle_client_destroy(struct wl_listener *listener, void *data) {
+	struct client_stats_state *state =
+		wl_container_of(listener, state, client_destroy);
+	wl_list_remove(&state->link);
+	wl_list_remove(&state->client_destroy.link);
+	free(state);
+}
+
+static struct client_stats_state *client_stats_find(struct wl_client *client) {
+	if (stats_states.next == NULL) {
+		wl_list_init(&stats_states);
+	}
+
+	struct client_stats_state *state;
+	wl_list_for_each(state, &stats_states, link) {
+		if (state->client == client) {
+			return state;
+		}
+	}
+	return NULL;
+}
+
+static struct client_stats_state *client_stats_get(struct wl_client *client) {
+	struct client_stats_state *state = client_stats_find(client);
+	if (state != NULL) {
+		return state;
+	}
+
+	state = calloc(1, sizeof(*state));
+	if (state == NULL) {
+		return NULL;
+	}
+	state->client = client;
+	state->window_start_msec = get_current_time_msec();
+	state->client_destroy.notify = handle_client_destroy;
+	wl_client_add_destroy_listener(client, &state->client_destroy);
+	wl_list_insert(&stats_states, &state->link);
+	return state;
+}
+
+// Closes the accumulation window once it spans at least a second, publishing
+// the normalized rates and firing the throttle hook for clients over budget
+static void client_stats_roll_window(struct client_stats_state *state) {
+	uint32_t now = get_current_time_msec();
+	uint32_t elapsed = now - state->window_start_msec;
+	if (elapsed < 1000) {
+		return;
+	}
+
+	state->stats.commits_per_sec =
+		(uint32_t)((uint64_t)state->window_commits * 1000 / elapsed);
+	state->stats.damage_rects_per_sec =
+		(uint32_t)((uint64_t)state->window_damage_rects * 1000 / elapsed);
+	state->window_commits = 0;
+	state->window_damage_rects = 0;
+	state->window_start_msec = now;
+
+	if (throttle_hook != NULL &&
+			((throttle_max_commits != 0 &&
+				state->stats.commits_per_sec > throttle_max_commits) ||
+			(throttle_max_damage_rects != 0 &&
+				state->stats.damage_rects_per_sec >
+				throttle_max_damage_rects))) {
+		throttle_hook(state->client, &state->stats, throttle_hook_data);
+	}
+}
+
+void client_stats_count_commit(struct wl_client *client) {
+	struct client_stats_state *state = client_stats_get(client);
+	if (state == NULL) {
+		return;
+	}
+	state->stats.commits++;
+	state->window_commits++;
+	client_stats_roll_window(state);
+}
+
+void client_stats_count_damage(struct wl_client *client, uint32_t rects) {
+	struct client_stats_state *state = client_stats_get(client);
+	if (state == NULL) {
+		return;
+	}
+	state->stats.damage_rects += rects;
+	state->window_damage_rects += rects;
+	client_stats_roll_window(state);
+}
+
+void client_stats_count_frame_callback(struct wl_client *client) {
+	struct client_stats_state *state = client_stats_get(client);
+	if (state == NULL) {
+		return;
+	}
+	state->stats.frame_callbacks++;
+	state->stats.frame_callbacks_pending++;
+}
+
+void client_stats_frame_callback_fired(struct wl_client *client) {
+	// Only look up existing state: the callback was counted when created
+	struct client_stats_state *state = client_stats_find(client);
+	if (state == NULL || state->stats.frame_callbacks_pending == 0) {
+		return;
+	}
+	state->stats.frame_callbacks_pending--;
+}
+
+const struct wlr_client_stats *wlr_client_get_stats(struct wl_client *client) {
+	struct client_stats_state *state = client_stats_find(client);
+	if (state == NULL) {
+		return NULL;
+	}
+	// An idle client's stale window would otherwise report old rates forever
+	client_stats_roll_window(state);
+	return &state->stats;
+}
+
+void wlr_client_stats_set_throttle_hook(uint32_t max_commits_per_sec,
+		uint32_t max_damage_rects_per_sec, wlr_client_throttle_hook_t hook,
+		void *data) {
+	throttle_max_commits = max_commits_per_sec;
+	throttle_max_damage_rects = max_damage_rects_per_sec;
+	throttle_hook = hook;
+	throttle_hook_data = data;
+}
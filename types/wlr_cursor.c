@@ -2,6 +2,7 @@
 #include <limits.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_cursor.h>
 #include <wlr/types/wlr_input_device.h>
@@ -51,6 +52,7 @@ struct wlr_cursor_output_cursor {
 	struct wl_list link;
 
 	struct wl_listener layout_output_destroy;
+	struct wl_listener output_frame;
 };
 
 struct wlr_cursor_state {
@@ -61,6 +63,12 @@ struct wlr_cursor_state {
 	struct wlr_output *mapped_output;
 	struct wlr_box *mapped_box;
 
+	// Motion coalescing (wlr_cursor_set_motion_coalescing): relative deltas
+	// accumulate here and flush as one motion per output frame
+	bool coalesce_motion;
+	bool motion_pending;
+	struct wlr_event_pointer_motion pending_motion;
+
 	struct wl_listener layout_add;
 	struct wl_listener layout_change;
 	struct wl_listener layout_destroy;
@@ -88,6 +96,7 @@ struct wlr_cursor *wlr_cursor_create(void) {
 
 	// pointer signals
 	wl_signal_init(&cur->events.motion);
+	wl_signal_init(&cur->events.motion_raw);
 	wl_signal_init(&cur->events.motion_absolute);
 	wl_signal_init(&cur->events.button);
 	wl_signal_init(&cur->events.axis);
@@ -120,6 +129,7 @@ struct wlr_cursor *wlr_cursor_create(void) {
 static void output_cursor_destroy(
 		struct wlr_cursor_output_cursor *output_cursor) {
 	wl_list_remove(&output_cursor->layout_output_destroy.link);
+	wl_list_remove(&output_cursor->output_frame.link);
 	wl_list_remove(&output_cursor->link);
 	wlr_output_cursor_destroy(output_cursor->output_cursor);
 	free(output_cursor);
@@ -351,11 +361,51 @@ void wlr_cursor_set_surface(struct wlr_cursor *cur, struct wlr_surface *surface,
 	}
 }
 
+static void cursor_flush_pending_motion(struct wlr_cursor *cur) {
+	if (!cur->state->motion_pending) {
+		return;
+	}
+
+	struct wlr_event_pointer_motion event = cur->state->pending_motion;
+	cur->state->motion_pending = false;
+	memset(&cur->state->pending_motion, 0,
+		sizeof(cur->state->pending_motion));
+
+	wlr_signal_emit_safe(&cur->events.motion, &event);
+	wlr_signal_emit_safe(&cur->events.frame, cur);
+}
+
 static void handle_pointer_motion(struct wl_listener *listener, void *data) {
 	struct wlr_event_pointer_motion *event = data;
 	struct wlr_cursor_device *device =
 		wl_container_of(listener, device, motion);
-	wlr_signal_emit_safe(&device->cursor->events.motion, event);
+	struct wlr_cursor *cur = device->cursor;
+
+	wlr_signal_emit_safe(&cur->events.motion_raw, event);
+
+	if (cur->state->coalesce_motion) {
+		// Intermediate positions are never displayed: accumulate and flush
+		// one motion per frame of the output the cursor is on
+		struct wlr_event_pointer_motion *pending =
+			&cur->state->pending_motion;
+		pending->device = event->device;
+		pending->time_msec = event->time_msec;
+		pending->delta_x += event->delta_x;
+		pending->delta_y += event->delta_y;
+		pending->unaccel_dx += event->unaccel_dx;
+		pending->unaccel_dy += event->unaccel_dy;
+		cur->state->motion_pending = true;
+		return;
+	}
+
+	wlr_signal_emit_safe(&cur->events.motion, event);
+}
+
+void wlr_cursor_set_motion_coalescing(struct wlr_cursor *cur, bool enabled) {
+	cur->state->coalesce_motion = enabled;
+	if (!enabled) {
+		cursor_flush_pending_motion(cur);
+	}
 }
 
 static void apply_output_transform(double *x, double *y,
@@ -445,7 +495,13 @@ static void handle_pointer_axis(struct wl_listener *listener, void *data) {
 
 static void handle_pointer_frame(struct wl_listener *listener, void *data) {
 	struct wlr_cursor_device *device = wl_container_of(listener, device, frame);
-	wlr_signal_emit_safe(&device->cursor->events.frame, device->cursor);
+	struct wlr_cursor *cur = device->cursor;
+	if (cur->state->motion_pending) {
+		// The motion ending this frame is still accumulating; its frame is
+		// emitted when it flushes
+		return;
+	}
+	wlr_signal_emit_safe(&cur->events.frame, cur);
 }
 
 static void handle_pointer_swipe_begin(struct wl_listener *listener, void *data) {
@@ -730,6 +786,23 @@ static void handle_layout_output_destroy(struct wl_listener *listener,
 	output_cursor_destroy(output_cursor);
 }
 
+static void handle_output_frame(struct wl_listener *listener, void *data) {
+	struct wlr_cursor_output_cursor *output_cursor =
+		wl_container_of(listener, output_cursor, output_frame);
+	struct wlr_cursor *cur = output_cursor->cursor;
+
+	if (!cur->state->motion_pending) {
+		return;
+	}
+	// With overlapping outputs, only the one under the cursor flushes
+	struct wlr_output *output = wlr_output_layout_output_at(cur->state->layout,
+		cur->x, cur->y);
+	if (output != NULL && output != output_cursor->output_cursor->output) {
+		return;
+	}
+	cursor_flush_pending_motion(cur);
+}
+
 static void layout_add(struct wlr_cursor_state *state,
 		struct wlr_output_layout_output *l_output) {
 	struct wlr_cursor_output_cursor *output_cursor;
@@ -757,6 +830,10 @@ static void layout_add(struct wlr_cursor_state *state,
 	wl_signal_add(&l_output->events.destroy,
 		&output_cursor->layout_output_destroy);
 
+	output_cursor->output_frame.notify = handle_output_frame;
+	wl_signal_add(&l_output->output->events.frame,
+		&output_cursor->output_frame);
+
 	wl_list_insert(&state->output_cursors, &output_cursor->link);
 }
 
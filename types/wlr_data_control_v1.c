@@ -449,6 +449,14 @@ static const struct zwlr_data_control_device_v1_interface control_impl = {
 static void control_send_selection(struct wlr_data_control_device_v1 *device) {
 	struct wlr_data_source *source = device->seat->selection_source;
 
+	if (source != NULL && source == device->announced_source &&
+			device->selection_offer_resource != NULL) {
+		// The client already has an offer for this source, no need to
+		// tear it down and rebuild it
+		return;
+	}
+	device->announced_source = source;
+
 	if (device->selection_offer_resource != NULL) {
 		// Make the offer inert
 		struct data_offer *offer = data_offer_from_offer_resource(
@@ -480,6 +488,14 @@ static void control_send_primary_selection(
 	struct wlr_primary_selection_source *source =
 		device->seat->primary_selection_source;
 
+	if (source != NULL && source == device->announced_primary_source &&
+			device->primary_selection_offer_resource != NULL) {
+		// The client already has an offer for this source, no need to
+		// tear it down and rebuild it
+		return;
+	}
+	device->announced_primary_source = source;
+
 	if (device->primary_selection_offer_resource != NULL) {
 		// Make the offer inert
 		struct data_offer *offer = data_offer_from_offer_resource(
@@ -501,6 +517,41 @@ static void control_send_primary_selection(
 		device->primary_selection_offer_resource);
 }
 
+static void control_handle_send_idle(void *data) {
+	struct wlr_data_control_device_v1 *device = data;
+	device->send_idle = NULL;
+
+	if (device->selection_pending) {
+		device->selection_pending = false;
+		control_send_selection(device);
+	}
+	if (device->primary_selection_pending) {
+		device->primary_selection_pending = false;
+		control_send_primary_selection(device);
+	}
+}
+
+// Defers selection delivery to an idle callback. Selections can change in
+// bursts (e.g. a clipboard manager mirroring every change), and announcing
+// each one tears down and rebuilds the client's offer; deferring collapses a
+// burst into a single announcement of the final selection, so a client that
+// has stopped reading only ever has one offer's worth of events queued for it
+// per dispatch turn.
+static void control_schedule_send(struct wlr_data_control_device_v1 *device) {
+	if (device->send_idle != NULL) {
+		return;
+	}
+
+	struct wl_event_loop *loop =
+		wl_display_get_event_loop(device->seat->display);
+	device->send_idle = wl_event_loop_add_idle(loop,
+		control_handle_send_idle, device);
+	if (device->send_idle == NULL) {
+		// Fall back to announcing in place
+		control_handle_send_idle(device);
+	}
+}
+
 static void control_handle_resource_destroy(struct wl_resource *resource) {
 	struct wlr_data_control_device_v1 *device = control_from_resource(resource);
 	wlr_data_control_device_v1_destroy(device);
@@ -517,7 +568,8 @@ static void control_handle_seat_set_selection(struct wl_listener *listener,
 		void *data) {
 	struct wlr_data_control_device_v1 *device =
 		wl_container_of(listener, device, seat_set_selection);
-	control_send_selection(device);
+	device->selection_pending = true;
+	control_schedule_send(device);
 }
 
 static void control_handle_seat_set_primary_selection(
@@ -525,7 +577,8 @@ static void control_handle_seat_set_primary_selection(
 		void *data) {
 	struct wlr_data_control_device_v1 *device =
 		wl_container_of(listener, device, seat_set_primary_selection);
-	control_send_primary_selection(device);
+	device->primary_selection_pending = true;
+	control_schedule_send(device);
 }
 
 void wlr_data_control_device_v1_destroy(struct wlr_data_control_device_v1 *device) {
@@ -545,6 +598,9 @@ void wlr_data_control_device_v1_destroy(struct wlr_data_control_device_v1 *devic
 			device->primary_selection_offer_resource);
 		data_offer_destroy(offer);
 	}
+	if (device->send_idle != NULL) {
+		wl_event_source_remove(device->send_idle);
+	}
 	wl_list_remove(&device->seat_destroy.link);
 	wl_list_remove(&device->seat_set_selection.link);
 	wl_list_remove(&device->seat_set_primary_selection.link);
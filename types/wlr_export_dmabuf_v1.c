@@ -6,11 +6,25 @@
 #include <wlr/types/wlr_export_dmabuf_v1.h>
 #include <wlr/types/wlr_output.h>
 #include <wlr/util/log.h>
+#include "types/wlr_output_capture.h"
 #include "util/signal.h"
+#include "util/slab.h"
 #include "wlr-export-dmabuf-unstable-v1-protocol.h"
 
 #define EXPORT_DMABUF_MANAGER_VERSION 1
 
+// Screencast clients request a new frame object per captured vblank
+static struct wlr_slab frame_slab;
+static bool frame_slab_initialized = false;
+
+static struct wlr_slab *get_frame_slab(void) {
+	if (!frame_slab_initialized) {
+		wlr_slab_init(&frame_slab,
+			sizeof(struct wlr_export_dmabuf_frame_v1));
+		frame_slab_initialized = true;
+	}
+	return &frame_slab;
+}
 
 static const struct zwlr_export_dmabuf_frame_v1_interface frame_impl;
 
@@ -40,11 +54,14 @@ static void frame_destroy(struct wlr_export_dmabuf_frame_v1 *frame) {
 			wlr_output_lock_software_cursors(frame->output, false);
 		}
 	}
+	if (frame->consumer != NULL) {
+		wlr_output_capture_remove(frame->consumer);
+		free(frame->consumer);
+	}
 	wl_list_remove(&frame->link);
-	wl_list_remove(&frame->output_commit.link);
 	// Make the frame resource inert
 	wl_resource_set_user_data(frame->resource, NULL);
-	free(frame);
+	wlr_slab_free(get_frame_slab(), frame);
 }
 
 static void frame_handle_resource_destroy(struct wl_resource *resource) {
@@ -52,48 +69,66 @@ static void frame_handle_resource_destroy(struct wl_resource *resource) {
 	frame_destroy(frame);
 }
 
-static void frame_output_handle_commit(struct wl_listener *listener,
-		void *data) {
-	struct wlr_export_dmabuf_frame_v1 *frame =
-		wl_container_of(listener, frame, output_commit);
-	struct wlr_output_event_commit *event = data;
+static void frame_send(struct wlr_export_dmabuf_frame_v1 *frame,
+		const struct wlr_dmabuf_attributes *attribs, const off_t *sizes,
+		const struct timespec *when) {
+	uint32_t frame_flags = ZWLR_EXPORT_DMABUF_FRAME_V1_FLAGS_TRANSIENT;
+	uint32_t mod_high = attribs->modifier >> 32;
+	uint32_t mod_low = attribs->modifier & 0xFFFFFFFF;
+	zwlr_export_dmabuf_frame_v1_send_frame(frame->resource,
+		attribs->width, attribs->height, 0, 0, attribs->flags, frame_flags,
+		attribs->format, mod_high, mod_low, attribs->n_planes);
 
-	if (!(event->committed & WLR_OUTPUT_STATE_BUFFER)) {
-		return;
+	for (int i = 0; i < attribs->n_planes; ++i) {
+		zwlr_export_dmabuf_frame_v1_send_object(frame->resource, i,
+			attribs->fd[i], sizes[i], attribs->offset[i], attribs->stride[i],
+			i);
+	}
+
+	time_t tv_sec = when->tv_sec;
+	uint32_t tv_sec_hi = (sizeof(tv_sec) > 4) ? tv_sec >> 32 : 0;
+	uint32_t tv_sec_lo = tv_sec & 0xFFFFFFFF;
+	zwlr_export_dmabuf_frame_v1_send_ready(frame->resource,
+		tv_sec_hi, tv_sec_lo, when->tv_nsec);
+	if (frame->consumer != NULL) {
+		wlr_output_capture_consumer_captured(frame->consumer);
 	}
+	frame_destroy(frame);
+}
 
-	wl_list_remove(&frame->output_commit.link);
-	wl_list_init(&frame->output_commit.link);
+static void frame_handle_capture(struct wlr_output_capture_consumer *consumer,
+		struct wlr_output_event_commit *event) {
+	struct wlr_export_dmabuf_frame_v1 *frame = consumer->data;
+	struct wlr_export_dmabuf_manager_v1 *manager = frame->manager;
+	struct wlr_output *output = frame->output;
 
 	struct wlr_dmabuf_attributes attribs = {0};
-	if (!wlr_output_export_dmabuf(frame->output, &attribs)) {
+	if (!wlr_output_export_dmabuf(output, &attribs)) {
 		zwlr_export_dmabuf_frame_v1_send_cancel(frame->resource,
 			ZWLR_EXPORT_DMABUF_FRAME_V1_CANCEL_REASON_TEMPORARY);
 		frame_destroy(frame);
 		return;
 	}
 
-	uint32_t frame_flags = ZWLR_EXPORT_DMABUF_FRAME_V1_FLAGS_TRANSIENT;
-	uint32_t mod_high = attribs.modifier >> 32;
-	uint32_t mod_low = attribs.modifier & 0xFFFFFFFF;
-	zwlr_export_dmabuf_frame_v1_send_frame(frame->resource,
-		attribs.width, attribs.height, 0, 0, attribs.flags, frame_flags,
-		attribs.format, mod_high, mod_low, attribs.n_planes);
-
+	off_t sizes[WLR_DMABUF_MAX_PLANES];
 	for (int i = 0; i < attribs.n_planes; ++i) {
-		off_t size = lseek(attribs.fd[i], 0, SEEK_END);
-		zwlr_export_dmabuf_frame_v1_send_object(frame->resource, i,
-			attribs.fd[i], size, attribs.offset[i], attribs.stride[i], i);
+		sizes[i] = lseek(attribs.fd[i], 0, SEEK_END);
 	}
 
-	wlr_dmabuf_attributes_finish(&attribs);
+	frame_send(frame, &attribs, sizes, event->when);
 
-	time_t tv_sec = event->when->tv_sec;
-	uint32_t tv_sec_hi = (sizeof(tv_sec) > 4) ? tv_sec >> 32 : 0;
-	uint32_t tv_sec_lo = tv_sec & 0xFFFFFFFF;
-	zwlr_export_dmabuf_frame_v1_send_ready(frame->resource,
-		tv_sec_hi, tv_sec_lo, event->when->tv_nsec);
-	frame_destroy(frame);
+	// Serve every other client waiting to capture this output from the same
+	// export: libwayland duplicates the dma-buf fds on marshalling, so N
+	// capture clients cost a single export
+	struct wlr_export_dmabuf_frame_v1 *other, *tmp;
+	wl_list_for_each_safe(other, tmp, &manager->frames, link) {
+		if (other->output == output && other->consumer != NULL &&
+				other->consumer->source != NULL) {
+			frame_send(other, &attribs, sizes, event->when);
+		}
+	}
+
+	wlr_dmabuf_attributes_finish(&attribs);
 }
 
 
@@ -114,20 +149,19 @@ static void manager_handle_capture_output(struct wl_client *client,
 	struct wlr_output *output = wlr_output_from_resource(output_resource);
 
 	struct wlr_export_dmabuf_frame_v1 *frame =
-		calloc(1, sizeof(struct wlr_export_dmabuf_frame_v1));
+		wlr_slab_alloc(get_frame_slab());
 	if (frame == NULL) {
 		wl_resource_post_no_memory(manager_resource);
 		return;
 	}
 	frame->manager = manager;
-	wl_list_init(&frame->output_commit.link);
 
 	uint32_t version = wl_resource_get_version(manager_resource);
 	frame->resource = wl_resource_create(client,
 		&zwlr_export_dmabuf_frame_v1_interface, version, id);
 	if (frame->resource == NULL) {
 		wl_client_post_no_memory(client);
-		free(frame);
+		wlr_slab_free(get_frame_slab(), frame);
 		return;
 	}
 	wl_resource_set_implementation(frame->resource, &frame_impl, frame,
@@ -142,6 +176,21 @@ static void manager_handle_capture_output(struct wl_client *client,
 		return;
 	}
 
+	frame->consumer = calloc(1, sizeof(struct wlr_output_capture_consumer));
+	if (frame->consumer == NULL) {
+		wl_resource_post_no_memory(manager_resource);
+		frame_destroy(frame);
+		return;
+	}
+	frame->consumer->max_fps = manager->max_capture_fps;
+	frame->consumer->commit = frame_handle_capture;
+	frame->consumer->data = frame;
+	if (!wlr_output_capture_add(output, frame->consumer)) {
+		wl_resource_post_no_memory(manager_resource);
+		frame_destroy(frame);
+		return;
+	}
+
 	frame->output = output;
 
 	wlr_output_lock_attach_render(frame->output, true);
@@ -150,10 +199,6 @@ static void manager_handle_capture_output(struct wl_client *client,
 		frame->cursor_locked = true;
 	}
 
-	wl_list_remove(&frame->output_commit.link);
-	wl_signal_add(&output->events.commit, &frame->output_commit);
-	frame->output_commit.notify = frame_output_handle_commit;
-
 	wlr_output_schedule_frame(output);
 }
 
@@ -11,6 +11,15 @@
 
 #define FOREIGN_TOPLEVEL_MANAGEMENT_V1_VERSION 3
 
+// wlr_foreign_toplevel_handle_v1::dirty
+enum toplevel_dirty_field {
+	TOPLEVEL_DIRTY_TITLE = 1 << 0,
+	TOPLEVEL_DIRTY_APP_ID = 1 << 1,
+	TOPLEVEL_DIRTY_STATE = 1 << 2,
+	TOPLEVEL_DIRTY_PARENT = 1 << 3,
+	TOPLEVEL_DIRTY_OUTPUTS = 1 << 4,
+};
+
 static const struct zwlr_foreign_toplevel_handle_v1_interface toplevel_handle_impl;
 
 static struct wlr_foreign_toplevel_handle_v1 *toplevel_handle_from_resource(
@@ -174,18 +183,80 @@ static const struct zwlr_foreign_toplevel_handle_v1_interface toplevel_handle_im
 	.unset_fullscreen = foreign_toplevel_handle_unset_fullscreen,
 };
 
+static bool fill_array_from_toplevel_state(struct wl_array *array,
+	uint32_t state);
+static void toplevel_resource_send_parent(
+	struct wl_resource *toplevel_resource,
+	struct wlr_foreign_toplevel_handle_v1 *parent);
+static void send_output_to_resource(struct wl_resource *resource,
+	struct wlr_output *output, bool enter);
+
+/**
+ * Flush all accumulated changes to every client holding a handle, sending
+ * only the fields that are dirty, followed by a single done event.
+ */
 static void toplevel_idle_send_done(void *data) {
 	struct wlr_foreign_toplevel_handle_v1 *toplevel = data;
+
+	struct wl_array states;
+	wl_array_init(&states);
+	if (toplevel->dirty & TOPLEVEL_DIRTY_STATE) {
+		if (!fill_array_from_toplevel_state(&states, toplevel->state)) {
+			struct wl_resource *resource;
+			wl_resource_for_each(resource, &toplevel->resources) {
+				wl_resource_post_no_memory(resource);
+			}
+
+			wl_array_release(&states);
+			toplevel->idle_source = NULL;
+			return;
+		}
+	}
+
 	struct wl_resource *resource;
 	wl_resource_for_each(resource, &toplevel->resources) {
+		if ((toplevel->dirty & TOPLEVEL_DIRTY_TITLE) && toplevel->title) {
+			zwlr_foreign_toplevel_handle_v1_send_title(resource,
+				toplevel->title);
+		}
+		if ((toplevel->dirty & TOPLEVEL_DIRTY_APP_ID) && toplevel->app_id) {
+			zwlr_foreign_toplevel_handle_v1_send_app_id(resource,
+				toplevel->app_id);
+		}
+		if (toplevel->dirty & TOPLEVEL_DIRTY_OUTPUTS) {
+			struct wlr_foreign_toplevel_handle_v1_output *toplevel_output;
+			wl_list_for_each(toplevel_output, &toplevel->outputs, link) {
+				if (!toplevel_output->enter_sent) {
+					send_output_to_resource(resource,
+						toplevel_output->output, true);
+				}
+			}
+		}
+		if (toplevel->dirty & TOPLEVEL_DIRTY_STATE) {
+			zwlr_foreign_toplevel_handle_v1_send_state(resource, &states);
+		}
+		if (toplevel->dirty & TOPLEVEL_DIRTY_PARENT) {
+			toplevel_resource_send_parent(resource, toplevel->parent);
+		}
 		zwlr_foreign_toplevel_handle_v1_send_done(resource);
 	}
 
+	wl_array_release(&states);
+
+	struct wlr_foreign_toplevel_handle_v1_output *toplevel_output;
+	wl_list_for_each(toplevel_output, &toplevel->outputs, link) {
+		toplevel_output->enter_sent = true;
+	}
+
+	toplevel->dirty = 0;
 	toplevel->idle_source = NULL;
 }
 
 static void toplevel_update_idle_source(
-	struct wlr_foreign_toplevel_handle_v1 *toplevel) {
+		struct wlr_foreign_toplevel_handle_v1 *toplevel,
+		enum toplevel_dirty_field field) {
+	toplevel->dirty |= field;
+
 	if (toplevel->idle_source) {
 		return;
 	}
@@ -203,12 +274,7 @@ void wlr_foreign_toplevel_handle_v1_set_title(
 		return;
 	}
 
-	struct wl_resource *resource;
-	wl_resource_for_each(resource, &toplevel->resources) {
-		zwlr_foreign_toplevel_handle_v1_send_title(resource, title);
-	}
-
-	toplevel_update_idle_source(toplevel);
+	toplevel_update_idle_source(toplevel, TOPLEVEL_DIRTY_TITLE);
 }
 
 void wlr_foreign_toplevel_handle_v1_set_app_id(
@@ -220,12 +286,7 @@ void wlr_foreign_toplevel_handle_v1_set_app_id(
 		return;
 	}
 
-	struct wl_resource *resource;
-	wl_resource_for_each(resource, &toplevel->resources) {
-		zwlr_foreign_toplevel_handle_v1_send_app_id(resource, app_id);
-	}
-
-	toplevel_update_idle_source(toplevel);
+	toplevel_update_idle_source(toplevel, TOPLEVEL_DIRTY_APP_ID);
 }
 
 static void send_output_to_resource(struct wl_resource *resource,
@@ -246,15 +307,6 @@ static void send_output_to_resource(struct wl_resource *resource,
 	}
 }
 
-static void toplevel_send_output(struct wlr_foreign_toplevel_handle_v1 *toplevel,
-		struct wlr_output *output, bool enter) {
-	struct wl_resource *resource;
-	wl_resource_for_each(resource, &toplevel->resources) {
-		send_output_to_resource(resource, output, enter);
-	}
-
-	toplevel_update_idle_source(toplevel);
-}
 
 static void toplevel_handle_output_destroy(struct wl_listener *listener,
 		void *data) {
@@ -288,7 +340,9 @@ void wlr_foreign_toplevel_handle_v1_output_enter(
 	toplevel_output->output_destroy.notify = toplevel_handle_output_destroy;
 	wl_signal_add(&output->events.destroy, &toplevel_output->output_destroy);
 
-	toplevel_send_output(toplevel, output, true);
+	// The enter event is deferred to the idle source, so that an output
+	// entered and left within the same cycle is never announced at all
+	toplevel_update_idle_source(toplevel, TOPLEVEL_DIRTY_OUTPUTS);
 }
 
 static void toplevel_output_destroy(
@@ -312,7 +366,16 @@ void wlr_foreign_toplevel_handle_v1_output_leave(
 	}
 
 	if (toplevel_output) {
-		toplevel_send_output(toplevel, output, false);
+		if (toplevel_output->enter_sent) {
+			// The leave is sent right away: the output (and its resources)
+			// may be about to be destroyed
+			struct wl_resource *resource;
+			wl_resource_for_each(resource, &toplevel->resources) {
+				send_output_to_resource(resource, output, false);
+			}
+
+			toplevel_update_idle_source(toplevel, TOPLEVEL_DIRTY_OUTPUTS);
+		}
 		toplevel_output_destroy(toplevel_output);
 	} else {
 		// XXX: log an error? crash?
@@ -354,26 +417,7 @@ static bool fill_array_from_toplevel_state(struct wl_array *array,
 }
 
 static void toplevel_send_state(struct wlr_foreign_toplevel_handle_v1 *toplevel) {
-	struct wl_array states;
-	wl_array_init(&states);
-	bool r = fill_array_from_toplevel_state(&states, toplevel->state);
-	if (!r) {
-		struct wl_resource *resource;
-		wl_resource_for_each(resource, &toplevel->resources) {
-			wl_resource_post_no_memory(resource);
-		}
-
-		wl_array_release(&states);
-		return;
-	}
-
-	struct wl_resource *resource;
-	wl_resource_for_each(resource, &toplevel->resources) {
-		zwlr_foreign_toplevel_handle_v1_send_state(resource, &states);
-	}
-
-	wl_array_release(&states);
-	toplevel_update_idle_source(toplevel);
+	toplevel_update_idle_source(toplevel, TOPLEVEL_DIRTY_STATE);
 }
 
 void wlr_foreign_toplevel_handle_v1_set_maximized(
@@ -459,12 +503,8 @@ void wlr_foreign_toplevel_handle_v1_set_parent(
 		/* only send parent event to the clients if there was a change */
 		return;
 	}
-	struct wl_resource *toplevel_resource, *tmp;
-	wl_resource_for_each_safe(toplevel_resource, tmp, &toplevel->resources) {
-		toplevel_resource_send_parent(toplevel_resource, parent);
-	}
 	toplevel->parent = parent;
-	toplevel_update_idle_source(toplevel);
+	toplevel_update_idle_source(toplevel, TOPLEVEL_DIRTY_PARENT);
 }
 
 void wlr_foreign_toplevel_handle_v1_destroy(
@@ -602,7 +642,10 @@ static void toplevel_send_details_to_toplevel_resource(
 
 	struct wlr_foreign_toplevel_handle_v1_output *output;
 	wl_list_for_each(output, &toplevel->outputs, link) {
-		send_output_to_resource(resource, output->output, true);
+		// Outputs not yet announced are picked up by the pending flush
+		if (output->enter_sent) {
+			send_output_to_resource(resource, output->output, true);
+		}
 	}
 
 	struct wl_array states;
@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <stdlib.h>
+#include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_fullscreen_shell_v1.h>
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_surface.h>
@@ -76,6 +77,39 @@ static void shell_bind(struct wl_client *client, void *data, uint32_t version,
 	wl_resource_set_implementation(resource, &shell_impl, shell, NULL);
 }
 
+bool wlr_fullscreen_shell_v1_surface_attach_scanout(
+		struct wlr_surface *surface, struct wlr_output *output) {
+	struct wlr_client_buffer *buffer = surface->buffer;
+	if (buffer == NULL) {
+		return false;
+	}
+
+	// Scanout bypasses the output's transform chain entirely, so the
+	// client's buffer must already match the CRTC exactly
+	if (surface->current.transform != output->transform ||
+			surface->current.buffer_width != output->width ||
+			surface->current.buffer_height != output->height) {
+		return false;
+	}
+
+	// Only DMA-BUFs can reach the primary plane; shm buffers stay on the
+	// render path
+	struct wlr_dmabuf_attributes dmabuf;
+	if (!wlr_buffer_get_dmabuf(&buffer->base, &dmabuf)) {
+		return false;
+	}
+
+	wlr_output_attach_buffer(output, &buffer->base);
+	if (!wlr_output_test(output)) {
+		// The backend rejected the format/modifier, or doesn't support
+		// scanout at all
+		wlr_output_rollback(output);
+		return false;
+	}
+
+	return true;
+}
+
 static void handle_display_destroy(struct wl_listener *listener, void *data) {
 	struct wlr_fullscreen_shell_v1 *shell =
 		wl_container_of(listener, shell, display_destroy);
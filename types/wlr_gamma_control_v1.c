@@ -28,6 +28,7 @@ static void gamma_control_destroy(struct wlr_gamma_control_v1 *gamma_control) {
 
 	wl_resource_set_user_data(gamma_control->resource, NULL);
 	wl_list_remove(&gamma_control->output_destroy_listener.link);
+	wl_list_remove(&gamma_control->output_precommit_listener.link);
 	wl_list_remove(&gamma_control->output_commit_listener.link);
 	wl_list_remove(&gamma_control->link);
 	free(gamma_control->table);
@@ -40,6 +41,8 @@ static void gamma_control_send_failed(
 	gamma_control_destroy(gamma_control);
 }
 
+// Called from the output's precommit signal, so the ramps join the commit
+// that's about to happen instead of generating a separate update
 static void gamma_control_apply(struct wlr_gamma_control_v1 *gamma_control) {
 	uint16_t *r = gamma_control->table;
 	uint16_t *g = gamma_control->table + gamma_control->ramp_size;
@@ -47,12 +50,18 @@ static void gamma_control_apply(struct wlr_gamma_control_v1 *gamma_control) {
 
 	wlr_output_set_gamma(gamma_control->output, gamma_control->ramp_size, r, g, b);
 	if (!wlr_output_test(gamma_control->output)) {
-		wlr_output_rollback(gamma_control->output);
+		// gamma_control_destroy resets the pending gamma, so the commit in
+		// progress proceeds with the LUT cleared instead of the bad ramps
 		gamma_control_send_failed(gamma_control);
-		return;
 	}
+}
 
-	// Gamma LUT will be applied on next output commit
+// Coalesce ramp updates to at most one application per output frame: the
+// table is only stored when the client submits it, and the latest one is
+// applied right before the next commit
+static void gamma_control_schedule_apply(
+		struct wlr_gamma_control_v1 *gamma_control) {
+	gamma_control->table_dirty = true;
 	wlr_output_schedule_frame(gamma_control->output);
 }
 
@@ -78,14 +87,25 @@ static void gamma_control_handle_output_destroy(struct wl_listener *listener,
 	gamma_control_destroy(gamma_control);
 }
 
+static void gamma_control_handle_output_precommit(struct wl_listener *listener,
+		void *data) {
+	struct wlr_gamma_control_v1 *gamma_control =
+		wl_container_of(listener, gamma_control, output_precommit_listener);
+	if (!gamma_control->table_dirty || !gamma_control->output->enabled) {
+		return;
+	}
+	gamma_control->table_dirty = false;
+	gamma_control_apply(gamma_control);
+}
+
 static void gamma_control_handle_output_commit(struct wl_listener *listener,
 		void *data) {
 	struct wlr_gamma_control_v1 *gamma_control =
 		wl_container_of(listener, gamma_control, output_commit_listener);
 	struct wlr_output_event_commit *event = data;
 	if ((event->committed & WLR_OUTPUT_STATE_ENABLED) &&
-			gamma_control->output->enabled) {
-		gamma_control_apply(gamma_control);
+			gamma_control->output->enabled && gamma_control->table != NULL) {
+		gamma_control_schedule_apply(gamma_control);
 	}
 }
 
@@ -138,9 +158,7 @@ static void gamma_control_handle_set_gamma(struct wl_client *client,
 	gamma_control->table = table;
 	gamma_control->ramp_size = ramp_size;
 
-	if (gamma_control->output->enabled) {
-		gamma_control_apply(gamma_control);
-	}
+	gamma_control_schedule_apply(gamma_control);
 
 	return;
 
@@ -203,6 +221,11 @@ static void gamma_control_manager_get_gamma_control(struct wl_client *client,
 	gamma_control->output_destroy_listener.notify =
 		gamma_control_handle_output_destroy;
 
+	wl_signal_add(&output->events.precommit,
+		&gamma_control->output_precommit_listener);
+	gamma_control->output_precommit_listener.notify =
+		gamma_control_handle_output_precommit;
+
 	wl_signal_add(&output->events.commit,
 		&gamma_control->output_commit_listener);
 	gamma_control->output_commit_listener.notify =
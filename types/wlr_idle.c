@@ -16,8 +16,7 @@ static struct wlr_idle_timeout *idle_timeout_from_resource(
 	return wl_resource_get_user_data(resource);
 }
 
-static int idle_notify(void *data) {
-	struct wlr_idle_timeout *timer = data;
+static int idle_notify(struct wlr_idle_timeout *timer) {
 	if (timer->idle_state) {
 		return 0;
 	}
@@ -30,23 +29,127 @@ static int idle_notify(void *data) {
 	return 1;
 }
 
-static void handle_activity(struct wlr_idle_timeout *timer) {
-	if (!timer->enabled) {
-		return;
+/**
+ * One shared timer per seat: all timeouts on the seat are tracked against a
+ * single monotonically increasing idle clock, so user activity costs one
+ * timerfd rearm regardless of how many idle listeners the seat has.
+ */
+struct wlr_idle_seat_timers {
+	struct wl_list link; // wlr_idle.seats
+	struct wlr_idle *idle;
+	struct wlr_seat *seat;
+	struct wl_event_source *source;
+	uint32_t elapsed; // ms of seat idle time accounted since last activity
+	uint32_t armed_delay; // delay the source was last armed with
+};
+
+static struct wlr_idle_seat_timers *idle_seat_timers_get(struct wlr_idle *idle,
+		struct wlr_seat *seat) {
+	struct wlr_idle_seat_timers *seat_timers;
+	wl_list_for_each(seat_timers, &idle->seats, link) {
+		if (seat_timers->seat == seat) {
+			return seat_timers;
+		}
 	}
+	return NULL;
+}
 
-	// in case the previous state was sleeping send a resume event and switch state
-	if (timer->idle_state) {
-		timer->idle_state = false;
-		wlr_signal_emit_safe(&timer->events.resume, timer);
+// Arms the shared timer to the earliest pending deadline on the seat, or
+// disarms it when every timer is idle or disabled
+static void idle_seat_timers_arm(struct wlr_idle_seat_timers *seat_timers) {
+	bool armed = false;
+	uint32_t next = 0;
+	struct wlr_idle_timeout *timer;
+	wl_list_for_each(timer, &seat_timers->idle->idle_timers, link) {
+		if (timer->seat != seat_timers->seat || !timer->enabled ||
+				timer->idle_state) {
+			continue;
+		}
+		uint32_t deadline = timer->offset + timer->timeout;
+		uint32_t delay = deadline > seat_timers->elapsed ?
+			deadline - seat_timers->elapsed : 1;
+		if (!armed || delay < next) {
+			next = delay;
+			armed = true;
+		}
+	}
+	seat_timers->armed_delay = armed ? next : 0;
+	wl_event_source_timer_update(seat_timers->source, armed ? (int)next : 0);
+}
 
-		if (timer->resource) {
-			org_kde_kwin_idle_timeout_send_resumed(timer->resource);
+static int idle_seat_timers_notify(void *data) {
+	struct wlr_idle_seat_timers *seat_timers = data;
+	seat_timers->elapsed += seat_timers->armed_delay;
+
+	struct wlr_idle_timeout *timer;
+	wl_list_for_each(timer, &seat_timers->idle->idle_timers, link) {
+		if (timer->seat != seat_timers->seat || !timer->enabled ||
+				timer->idle_state) {
+			continue;
+		}
+		if (timer->offset + timer->timeout <= seat_timers->elapsed) {
+			idle_notify(timer);
 		}
 	}
 
-	// rearm the timer
-	wl_event_source_timer_update(timer->idle_source, timer->timeout);
+	idle_seat_timers_arm(seat_timers);
+	return 1;
+}
+
+static struct wlr_idle_seat_timers *idle_seat_timers_get_or_create(
+		struct wlr_idle *idle, struct wlr_seat *seat) {
+	struct wlr_idle_seat_timers *seat_timers = idle_seat_timers_get(idle, seat);
+	if (seat_timers != NULL) {
+		return seat_timers;
+	}
+
+	seat_timers = calloc(1, sizeof(struct wlr_idle_seat_timers));
+	if (seat_timers == NULL) {
+		return NULL;
+	}
+	seat_timers->idle = idle;
+	seat_timers->seat = seat;
+	seat_timers->source = wl_event_loop_add_timer(idle->event_loop,
+		idle_seat_timers_notify, seat_timers);
+	if (seat_timers->source == NULL) {
+		free(seat_timers);
+		return NULL;
+	}
+	wl_list_insert(&idle->seats, &seat_timers->link);
+	return seat_timers;
+}
+
+static void idle_seat_timers_destroy(struct wlr_idle_seat_timers *seat_timers) {
+	wl_event_source_remove(seat_timers->source);
+	wl_list_remove(&seat_timers->link);
+	free(seat_timers);
+}
+
+// Sends the resume events if the timer was idle
+static void timer_resume(struct wlr_idle_timeout *timer) {
+	if (!timer->idle_state) {
+		return;
+	}
+	timer->idle_state = false;
+	wlr_signal_emit_safe(&timer->events.resume, timer);
+
+	if (timer->resource) {
+		org_kde_kwin_idle_timeout_send_resumed(timer->resource);
+	}
+}
+
+// Resets a single timer, for simulate_user_activity
+static void handle_activity(struct wlr_idle_timeout *timer) {
+	if (!timer->enabled) {
+		return;
+	}
+
+	timer_resume(timer);
+
+	struct wlr_idle_seat_timers *seat_timers =
+		idle_seat_timers_get(timer->idle, timer->seat);
+	timer->offset = seat_timers->elapsed;
+	idle_seat_timers_arm(seat_timers);
 	if (timer->timeout == 0) {
 		idle_notify(timer);
 	}
@@ -95,21 +198,35 @@ static void handle_input_notification(struct wl_listener *listener, void *data)
 	struct wlr_idle_timeout *timer =
 		wl_container_of(listener, timer, input_listener);
 	struct wlr_seat *seat = data;
-	if (timer->seat == seat) {
-		handle_activity(timer);
+	if (timer->seat != seat || !timer->enabled) {
+		return;
+	}
+	// Only the per-timer events are handled here: the timer reset happens
+	// once per seat in wlr_idle_notify_activity
+	timer_resume(timer);
+	if (timer->timeout == 0) {
+		idle_notify(timer);
 	}
 }
 
 static struct wlr_idle_timeout *create_timer(struct wlr_idle *idle,
 		struct wlr_seat *seat, uint32_t timeout, struct wl_resource *resource) {
+	struct wlr_idle_seat_timers *seat_timers =
+		idle_seat_timers_get_or_create(idle, seat);
+	if (seat_timers == NULL) {
+		return NULL;
+	}
+
 	struct wlr_idle_timeout *timer =
 		calloc(1, sizeof(struct wlr_idle_timeout));
 	if (!timer) {
 		return NULL;
 	}
 
+	timer->idle = idle;
 	timer->seat = seat;
 	timer->timeout = timeout;
+	timer->offset = seat_timers->elapsed;
 	timer->idle_state = false;
 	timer->enabled = idle->enabled;
 
@@ -123,16 +240,6 @@ static struct wlr_idle_timeout *create_timer(struct wlr_idle *idle,
 
 	timer->input_listener.notify = handle_input_notification;
 	wl_signal_add(&idle->events.activity_notify, &timer->input_listener);
-	// create the timer
-	timer->idle_source =
-		wl_event_loop_add_timer(idle->event_loop, idle_notify, timer);
-	if (timer->idle_source == NULL) {
-		wl_list_remove(&timer->link);
-		wl_list_remove(&timer->input_listener.link);
-		wl_list_remove(&timer->seat_destroy.link);
-		free(timer);
-		return NULL;
-	}
 
 	if (resource) {
 		timer->resource = resource;
@@ -140,8 +247,8 @@ static struct wlr_idle_timeout *create_timer(struct wlr_idle *idle,
 	}
 
 	if (timer->enabled) {
-		// arm the timer
-		wl_event_source_timer_update(timer->idle_source, timer->timeout);
+		// arm the shared timer
+		idle_seat_timers_arm(seat_timers);
 		if (timer->timeout == 0) {
 			idle_notify(timer);
 		}
@@ -185,14 +292,23 @@ void wlr_idle_set_enabled(struct wlr_idle *idle, struct wlr_seat *seat,
 		enabled ? "Enabling" : "Disabling",
 		seat ? seat->name : "all seats");
 	idle->enabled = enabled;
-	struct wlr_idle_timeout *timer;
-	wl_list_for_each(timer, &idle->idle_timers, link) {
-		if (seat != NULL && timer->seat != seat) {
+	struct wlr_idle_seat_timers *seat_timers;
+	wl_list_for_each(seat_timers, &idle->seats, link) {
+		if (seat != NULL && seat_timers->seat != seat) {
 			continue;
 		}
-		int timeout = enabled ? timer->timeout : 0;
-		wl_event_source_timer_update(timer->idle_source, timeout);
-		timer->enabled = enabled;
+		struct wlr_idle_timeout *timer;
+		wl_list_for_each(timer, &idle->idle_timers, link) {
+			if (timer->seat != seat_timers->seat) {
+				continue;
+			}
+			if (enabled) {
+				// restart at the full timeout, like a fresh arm did before
+				timer->offset = seat_timers->elapsed;
+			}
+			timer->enabled = enabled;
+		}
+		idle_seat_timers_arm(seat_timers);
 	}
 }
 
@@ -215,6 +331,10 @@ static void handle_display_destroy(struct wl_listener *listener, void *data) {
 	wlr_signal_emit_safe(&idle->events.destroy, idle);
 	wl_list_remove(&idle->display_destroy.link);
 	wl_global_destroy(idle->global);
+	struct wlr_idle_seat_timers *seat_timers, *tmp;
+	wl_list_for_each_safe(seat_timers, tmp, &idle->seats, link) {
+		idle_seat_timers_destroy(seat_timers);
+	}
 	free(idle);
 }
 
@@ -224,6 +344,7 @@ struct wlr_idle *wlr_idle_create(struct wl_display *display) {
 		return NULL;
 	}
 	wl_list_init(&idle->idle_timers);
+	wl_list_init(&idle->seats);
 	wl_signal_init(&idle->events.activity_notify);
 	wl_signal_init(&idle->events.destroy);
 	idle->enabled = true;
@@ -250,6 +371,22 @@ struct wlr_idle *wlr_idle_create(struct wl_display *display) {
 
 void wlr_idle_notify_activity(struct wlr_idle *idle, struct wlr_seat *seat) {
 	wlr_signal_emit_safe(&idle->events.activity_notify, seat);
+
+	struct wlr_idle_seat_timers *seat_timers = idle_seat_timers_get(idle, seat);
+	if (seat_timers == NULL) {
+		return;
+	}
+
+	// Restart the shared clock and every timer on the seat: one timerfd
+	// rearm no matter how many listeners there are
+	seat_timers->elapsed = 0;
+	struct wlr_idle_timeout *timer;
+	wl_list_for_each(timer, &idle->idle_timers, link) {
+		if (timer->seat == seat) {
+			timer->offset = 0;
+		}
+	}
+	idle_seat_timers_arm(seat_timers);
 }
 
 struct wlr_idle_timeout *wlr_idle_timeout_create(struct wlr_idle *idle,
@@ -262,12 +399,28 @@ void wlr_idle_timeout_destroy(struct wlr_idle_timeout *timer) {
 
 	wl_list_remove(&timer->input_listener.link);
 	wl_list_remove(&timer->seat_destroy.link);
-	wl_event_source_remove(timer->idle_source);
 	wl_list_remove(&timer->link);
 
 	if (timer->resource) {
 		wl_resource_set_user_data(timer->resource, NULL);
 	}
 
+	// Tear down the seat's shared timer with its last timeout
+	struct wlr_idle_seat_timers *seat_timers =
+		idle_seat_timers_get(timer->idle, timer->seat);
+	if (seat_timers != NULL) {
+		bool used = false;
+		struct wlr_idle_timeout *other;
+		wl_list_for_each(other, &timer->idle->idle_timers, link) {
+			if (other->seat == timer->seat) {
+				used = true;
+				break;
+			}
+		}
+		if (!used) {
+			idle_seat_timers_destroy(seat_timers);
+		}
+	}
+
 	free(timer);
 }
@@ -28,17 +28,29 @@ wlr_idle_inhibitor_v1_from_resource(struct wl_resource *inhibitor_resource) {
 	return wl_resource_get_user_data(inhibitor_resource);
 }
 
+bool wlr_idle_inhibit_v1_inhibited(
+		struct wlr_idle_inhibit_manager_v1 *manager) {
+	return manager->n_inhibitors > 0;
+}
+
 static void idle_inhibitor_v1_destroy(struct wlr_idle_inhibitor_v1 *inhibitor) {
 	if (!inhibitor) {
 		return;
 	}
 
+	struct wlr_idle_inhibit_manager_v1 *manager = inhibitor->manager;
+
 	wlr_signal_emit_safe(&inhibitor->events.destroy, inhibitor->surface);
 
 	wl_resource_set_user_data(inhibitor->resource, NULL);
 	wl_list_remove(&inhibitor->link);
 	wl_list_remove(&inhibitor->surface_destroy.link);
 	free(inhibitor);
+
+	assert(manager->n_inhibitors > 0);
+	if (--manager->n_inhibitors == 0) {
+		wlr_signal_emit_safe(&manager->events.inhibited, manager);
+	}
 }
 
 static void idle_inhibitor_v1_handle_resource_destroy(
@@ -87,6 +99,7 @@ static void manager_handle_create_inhibitor(struct wl_client *client,
 		return;
 	}
 
+	inhibitor->manager = manager;
 	inhibitor->resource = inhibitor_resource;
 	inhibitor->surface = surface;
 	wl_signal_init(&inhibitor->events.destroy);
@@ -98,6 +111,9 @@ static void manager_handle_create_inhibitor(struct wl_client *client,
 		inhibitor, idle_inhibitor_v1_handle_resource_destroy);
 
 	wl_list_insert(&manager->inhibitors, &inhibitor->link);
+	if (++manager->n_inhibitors == 1) {
+		wlr_signal_emit_safe(&manager->events.inhibited, manager);
+	}
 	wlr_signal_emit_safe(&manager->events.new_inhibitor, inhibitor);
 }
 
@@ -144,6 +160,7 @@ struct wlr_idle_inhibit_manager_v1 *wlr_idle_inhibit_v1_create(struct wl_display
 
 	wl_list_init(&manager->inhibitors);
 	wl_signal_init(&manager->events.new_inhibitor);
+	wl_signal_init(&manager->events.inhibited);
 	wl_signal_init(&manager->events.destroy);
 
 	manager->global = wl_global_create(display,
@@ -2,6 +2,7 @@
 #define _POSIX_C_SOURCE 200809L
 #endif
 #include <assert.h>
+#include <fcntl.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <unistd.h>
@@ -34,6 +35,10 @@ static struct wlr_input_method_keyboard_grab_v2 *keyboard_grab_from_resource(
 
 static void input_method_destroy(struct wlr_input_method_v2 *input_method) {
 	wlr_signal_emit_safe(&input_method->events.destroy, input_method);
+	if (input_method->done_idle != NULL) {
+		wl_event_source_remove(input_method->done_idle);
+		input_method->done_idle = NULL;
+	}
 	wl_list_remove(wl_resource_get_link(input_method->resource));
 	wl_list_remove(&input_method->seat_client_destroy.link);
 	wlr_input_method_keyboard_grab_v2_destroy(input_method->keyboard_grab);
@@ -167,6 +172,21 @@ void wlr_input_method_keyboard_grab_v2_send_modifiers(
 static bool keyboard_grab_send_keymap(
 		struct wlr_input_method_keyboard_grab_v2 *keyboard_grab,
 		struct wlr_keyboard *keyboard) {
+	if (keyboard->keymap_fd >= 0) {
+		// Share the keyboard's sealed read-only keymap file instead of
+		// filling a fresh copy
+		int keymap_fd = fcntl(keyboard->keymap_fd, F_DUPFD_CLOEXEC, 0);
+		if (keymap_fd < 0) {
+			wlr_log_errno(WLR_ERROR, "failed to dup() the keymap fd");
+			return false;
+		}
+		zwp_input_method_keyboard_grab_v2_send_keymap(keyboard_grab->resource,
+			WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1, keymap_fd,
+			keyboard->keymap_size);
+		close(keymap_fd);
+		return true;
+	}
+
 	int keymap_fd = allocate_shm_file(keyboard->keymap_size);
 	if (keymap_fd < 0) {
 		wlr_log(WLR_ERROR, "creating a keymap file for %zu bytes failed",
@@ -348,11 +368,39 @@ void wlr_input_method_v2_send_content_type(
 }
 
 void wlr_input_method_v2_send_done(struct wlr_input_method_v2 *input_method) {
+	if (input_method->done_idle != NULL) {
+		// An explicit done supersedes the scheduled one
+		wl_event_source_remove(input_method->done_idle);
+		input_method->done_idle = NULL;
+	}
 	zwp_input_method_v2_send_done(input_method->resource);
 	input_method->client_active = input_method->active;
 	input_method->current_serial++;
 }
 
+static void input_method_handle_done_idle(void *data) {
+	struct wlr_input_method_v2 *input_method = data;
+	input_method->done_idle = NULL;
+	wlr_input_method_v2_send_done(input_method);
+}
+
+void wlr_input_method_v2_schedule_done(
+		struct wlr_input_method_v2 *input_method) {
+	if (input_method->done_idle != NULL) {
+		// Already scheduled: the pending done covers this update too
+		return;
+	}
+	struct wl_client *client = wl_resource_get_client(input_method->resource);
+	struct wl_event_loop *loop =
+		wl_display_get_event_loop(wl_client_get_display(client));
+	input_method->done_idle = wl_event_loop_add_idle(loop,
+		input_method_handle_done_idle, input_method);
+	if (input_method->done_idle == NULL) {
+		// Better an extra done than a dropped one
+		wlr_input_method_v2_send_done(input_method);
+	}
+}
+
 void wlr_input_method_v2_send_unavailable(
 		struct wlr_input_method_v2 *input_method) {
 	zwp_input_method_v2_send_unavailable(input_method->resource);
@@ -2,13 +2,107 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <wayland-server-core.h>
 #include <wlr/interfaces/wlr_keyboard.h>
 #include <wlr/types/wlr_keyboard.h>
 #include <wlr/util/log.h>
 #include "types/wlr_keyboard.h"
+#include "util/shm.h"
 #include "util/signal.h"
 
+/**
+ * Compiled keymaps, deduplicated by their string form. Every member of a
+ * keyboard group carries the same keymap, and a compiled keymap plus its
+ * TEXT_V1 string weigh tens of kilobytes, so identical keymaps share one
+ * entry instead of each keyboard compiling and storing its own copy. As a
+ * side effect, keyboards with equal keymaps end up with equal keymap
+ * pointers, which lets wlr_keyboard_keymaps_match() short-circuit.
+ */
+struct keymap_cache_entry {
+	struct xkb_keymap *keymap;
+	char *string;
+	size_t size; // strlen(string) + 1
+	int fd; // sealed read-only file holding `string`, or -1
+	size_t n_refs;
+	struct wl_list link; // keymap_cache
+};
+
+static struct wl_list keymap_cache = {
+	.prev = &keymap_cache,
+	.next = &keymap_cache,
+};
+
+/**
+ * Returns the cache entry matching the given keymap string, taking a
+ * reference on it. On a hit the string is freed, on a miss a new entry takes
+ * ownership of it. Returns NULL if allocating an entry failed, in which case
+ * the caller keeps the string.
+ */
+static struct keymap_cache_entry *keymap_cache_get(struct xkb_keymap *keymap,
+		char *string) {
+	struct keymap_cache_entry *entry;
+	wl_list_for_each(entry, &keymap_cache, link) {
+		if (strcmp(entry->string, string) == 0) {
+			free(string);
+			++entry->n_refs;
+			return entry;
+		}
+	}
+
+	entry = calloc(1, sizeof(struct keymap_cache_entry));
+	if (entry == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate keymap_cache_entry");
+		return NULL;
+	}
+	entry->keymap = xkb_keymap_ref(keymap);
+	entry->string = string;
+	entry->size = strlen(string) + 1;
+	// One sealed copy of the serialized keymap serves every client: senders
+	// only dup() this descriptor instead of allocating and filling a fresh
+	// file per recipient
+	entry->fd = allocate_sealed_shm_file(string, entry->size);
+	if (entry->fd < 0) {
+		wlr_log(WLR_ERROR, "Failed to create a sealed keymap file for "
+			"%zu bytes", entry->size);
+	}
+	entry->n_refs = 1;
+	wl_list_insert(&keymap_cache, &entry->link);
+	return entry;
+}
+
+/**
+ * Drops the keyboard's keymap, string and size, releasing the cache entry
+ * backing them if there is one.
+ */
+static void keyboard_release_keymap(struct wlr_keyboard *kb) {
+	struct keymap_cache_entry *entry = kb->keymap_cache_entry;
+	if (entry != NULL) {
+		if (--entry->n_refs == 0) {
+			wl_list_remove(&entry->link);
+			xkb_keymap_unref(entry->keymap);
+			free(entry->string);
+			if (entry->fd >= 0) {
+				close(entry->fd);
+			}
+			free(entry);
+		}
+	} else {
+		// The keyboard owns the string and file if its keymap never made it
+		// into the cache
+		free(kb->keymap_string);
+		if (kb->keymap_fd >= 0) {
+			close(kb->keymap_fd);
+		}
+	}
+	xkb_keymap_unref(kb->keymap);
+	kb->keymap = NULL;
+	kb->keymap_string = NULL;
+	kb->keymap_size = 0;
+	kb->keymap_fd = -1;
+	kb->keymap_cache_entry = NULL;
+}
+
 void keyboard_led_update(struct wlr_keyboard *keyboard) {
 	if (keyboard->xkb_state == NULL) {
 		return;
@@ -122,6 +216,8 @@ void wlr_keyboard_init(struct wlr_keyboard *kb,
 	// Sane defaults
 	kb->repeat_info.rate = 25;
 	kb->repeat_info.delay = 600;
+	kb->keymap_fd = -1;
+	kb->keymap_cache_entry = NULL;
 }
 
 void wlr_keyboard_destroy(struct wlr_keyboard *kb) {
@@ -130,8 +226,7 @@ void wlr_keyboard_destroy(struct wlr_keyboard *kb) {
 	}
 	wlr_signal_emit_safe(&kb->events.destroy, kb);
 	xkb_state_unref(kb->xkb_state);
-	xkb_keymap_unref(kb->keymap);
-	free(kb->keymap_string);
+	keyboard_release_keymap(kb);
 	if (kb->impl && kb->impl->destroy) {
 		kb->impl->destroy(kb);
 	} else {
@@ -148,8 +243,36 @@ void wlr_keyboard_led_update(struct wlr_keyboard *kb, uint32_t leds) {
 
 bool wlr_keyboard_set_keymap(struct wlr_keyboard *kb,
 		struct xkb_keymap *keymap) {
-	xkb_keymap_unref(kb->keymap);
-	kb->keymap = xkb_keymap_ref(keymap);
+	char *keymap_string = xkb_keymap_get_as_string(keymap,
+		XKB_KEYMAP_FORMAT_TEXT_V1);
+	if (keymap_string == NULL) {
+		wlr_log(WLR_ERROR, "Failed to get string version of keymap");
+		return false;
+	}
+
+	// Share a previously compiled copy of the same keymap if there is one,
+	// so that e.g. the members of a keyboard group hold a single compiled
+	// keymap and string between them
+	struct keymap_cache_entry *entry = keymap_cache_get(keymap, keymap_string);
+
+	keyboard_release_keymap(kb);
+	if (entry != NULL) {
+		kb->keymap = xkb_keymap_ref(entry->keymap);
+		kb->keymap_string = entry->string;
+		kb->keymap_size = entry->size;
+		kb->keymap_fd = entry->fd;
+		kb->keymap_cache_entry = entry;
+	} else {
+		kb->keymap = xkb_keymap_ref(keymap);
+		kb->keymap_string = keymap_string;
+		kb->keymap_size = strlen(keymap_string) + 1;
+		kb->keymap_fd = allocate_sealed_shm_file(kb->keymap_string,
+			kb->keymap_size);
+		if (kb->keymap_fd < 0) {
+			wlr_log(WLR_ERROR, "Failed to create a sealed keymap file for "
+				"%zu bytes", kb->keymap_size);
+		}
+	}
 
 	xkb_state_unref(kb->xkb_state);
 	kb->xkb_state = xkb_state_new(kb->keymap);
@@ -182,16 +305,6 @@ bool wlr_keyboard_set_keymap(struct wlr_keyboard *kb,
 		kb->mod_indexes[i] = xkb_map_mod_get_index(kb->keymap, mod_names[i]);
 	}
 
-	char *tmp_keymap_string = xkb_keymap_get_as_string(kb->keymap,
-		XKB_KEYMAP_FORMAT_TEXT_V1);
-	if (tmp_keymap_string == NULL) {
-		wlr_log(WLR_ERROR, "Failed to get string version of keymap");
-		goto err;
-	}
-	free(kb->keymap_string);
-	kb->keymap_string = tmp_keymap_string;
-	kb->keymap_size = strlen(kb->keymap_string) + 1;
-
 	for (size_t i = 0; i < kb->num_keycodes; ++i) {
 		xkb_keycode_t keycode = kb->keycodes[i] + 8;
 		xkb_state_update_key(kb->xkb_state, keycode, XKB_KEY_DOWN);
@@ -205,10 +318,7 @@ bool wlr_keyboard_set_keymap(struct wlr_keyboard *kb,
 err:
 	xkb_state_unref(kb->xkb_state);
 	kb->xkb_state = NULL;
-	xkb_keymap_unref(keymap);
-	kb->keymap = NULL;
-	free(kb->keymap_string);
-	kb->keymap_string = NULL;
+	keyboard_release_keymap(kb);
 	return false;
 }
 
@@ -236,7 +346,9 @@ uint32_t wlr_keyboard_get_modifiers(struct wlr_keyboard *kb) {
 
 bool wlr_keyboard_keymaps_match(struct xkb_keymap *km1,
 		struct xkb_keymap *km2) {
-	if (!km1 && !km2) {
+	// Keymaps set via wlr_keyboard_set_keymap are deduplicated, so equal
+	// keymaps usually are the same object
+	if (km1 == km2) {
 		return true;
 	}
 	if (!km1 || !km2) {
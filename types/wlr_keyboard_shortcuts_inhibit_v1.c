@@ -36,6 +36,8 @@ static void keyboard_shortcuts_inhibitor_v1_destroy(
 
 	wlr_signal_emit_safe(&inhibitor->events.destroy, inhibitor);
 
+	inhibitor->manager->find_cache.valid = false;
+
 	wl_resource_set_user_data(inhibitor->resource, NULL);
 	wl_list_remove(&inhibitor->link);
 	wl_list_remove(&inhibitor->surface_destroy.link);
@@ -94,13 +96,8 @@ static void manager_handle_inhibit_shortcuts(struct wl_client *client,
 				manager_resource);
 
 	struct wlr_seat *seat = seat_client->seat;
-	struct wlr_keyboard_shortcuts_inhibitor_v1 *existing_inhibitor;
-	wl_list_for_each(existing_inhibitor, &manager->inhibitors, link) {
-		if (existing_inhibitor->surface != surface ||
-				existing_inhibitor->seat != seat) {
-			continue;
-		}
-
+	if (wlr_keyboard_shortcuts_inhibit_v1_find(manager, surface,
+			seat) != NULL) {
 		wl_resource_post_error(manager_resource,
 			ZWP_KEYBOARD_SHORTCUTS_INHIBIT_MANAGER_V1_ERROR_ALREADY_INHIBITED,
 			"this surface already has keyboard shortcuts "
@@ -125,11 +122,14 @@ static void manager_handle_inhibit_shortcuts(struct wl_client *client,
 	}
 
 	inhibitor->resource = inhibitor_resource;
+	inhibitor->manager = manager;
 	inhibitor->surface = surface;
 	inhibitor->seat = seat;
 	inhibitor->active = false;
 	wl_signal_init(&inhibitor->events.destroy);
 
+	manager->find_cache.valid = false;
+
 	inhibitor->surface_destroy.notify =
 		keyboard_shortcuts_inhibitor_handle_surface_destroy;
 	wl_signal_add(&surface->events.destroy, &inhibitor->surface_destroy);
@@ -208,6 +208,34 @@ wlr_keyboard_shortcuts_inhibit_v1_create(struct wl_display *display) {
 	return manager;
 }
 
+struct wlr_keyboard_shortcuts_inhibitor_v1 *
+wlr_keyboard_shortcuts_inhibit_v1_find(
+		struct wlr_keyboard_shortcuts_inhibit_manager_v1 *manager,
+		struct wlr_surface *surface, struct wlr_seat *seat) {
+	if (manager->find_cache.valid &&
+			manager->find_cache.surface == surface &&
+			manager->find_cache.seat == seat) {
+		return manager->find_cache.inhibitor;
+	}
+
+	struct wlr_keyboard_shortcuts_inhibitor_v1 *found = NULL;
+	struct wlr_keyboard_shortcuts_inhibitor_v1 *inhibitor;
+	wl_list_for_each(inhibitor, &manager->inhibitors, link) {
+		if (inhibitor->surface == surface && inhibitor->seat == seat) {
+			found = inhibitor;
+			break;
+		}
+	}
+
+	// Cache misses too: most surfaces have no inhibitor, and that's the
+	// answer the keyboard path asks for on every key
+	manager->find_cache.valid = true;
+	manager->find_cache.surface = surface;
+	manager->find_cache.seat = seat;
+	manager->find_cache.inhibitor = found;
+	return found;
+}
+
 void wlr_keyboard_shortcuts_inhibitor_v1_activate(
 		struct wlr_keyboard_shortcuts_inhibitor_v1 *inhibitor) {
 	if (!inhibitor->active) {
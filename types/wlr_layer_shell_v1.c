@@ -9,10 +9,24 @@
 #include <wlr/types/wlr_xdg_shell.h>
 #include <wlr/util/log.h>
 #include "util/signal.h"
+#include "util/slab.h"
 #include "wlr-layer-shell-unstable-v1-protocol.h"
 
 #define LAYER_SHELL_VERSION 4
 
+// Panels animating their exclusive zone produce one configure per frame
+static struct wlr_slab configure_slab;
+static bool configure_slab_initialized = false;
+
+static struct wlr_slab *get_configure_slab(void) {
+	if (!configure_slab_initialized) {
+		wlr_slab_init(&configure_slab,
+			sizeof(struct wlr_layer_surface_v1_configure));
+		configure_slab_initialized = true;
+	}
+	return &configure_slab;
+}
+
 static void resource_handle_destroy(struct wl_client *client,
 		struct wl_resource *resource) {
 	wl_resource_destroy(resource);
@@ -21,6 +35,10 @@ static void resource_handle_destroy(struct wl_client *client,
 static const struct zwlr_layer_shell_v1_interface layer_shell_implementation;
 static const struct zwlr_layer_surface_v1_interface layer_surface_implementation;
 
+static void layer_shell_output_arrange(
+	struct wlr_layer_shell_v1_output *shell_output,
+	struct wlr_layer_surface_v1 *start);
+
 static struct wlr_layer_shell_v1 *layer_shell_from_resource(
 		struct wl_resource *resource) {
 	assert(wl_resource_instance_of(resource, &zwlr_layer_shell_v1_interface,
@@ -53,7 +71,7 @@ static void layer_surface_configure_destroy(
 		return;
 	}
 	wl_list_remove(&configure->link);
-	free(configure);
+	wlr_slab_free(get_configure_slab(), configure);
 }
 
 static void layer_surface_handle_ack_configure(struct wl_client *client,
@@ -245,6 +263,17 @@ static void layer_surface_destroy(struct wlr_layer_surface_v1 *surface) {
 	wl_resource_set_user_data(surface->resource, NULL);
 	surface->surface->role_data = NULL;
 	wl_list_remove(&surface->surface_destroy.link);
+	wl_list_remove(&surface->link);
+
+	// Give the area the surface reserved back to the ones arranged after it
+	if (surface->output != NULL && surface->current.exclusive_zone > 0) {
+		struct wlr_layer_shell_v1_output *shell_output =
+			wlr_layer_shell_v1_get_output(surface->shell, surface->output);
+		if (shell_output != NULL) {
+			layer_shell_output_arrange(shell_output, NULL);
+		}
+	}
+
 	free(surface->namespace);
 	free(surface);
 }
@@ -286,7 +315,7 @@ void wlr_layer_surface_v1_configure(struct wlr_layer_surface_v1 *surface,
 		struct wl_display *display =
 			wl_client_get_display(wl_resource_get_client(surface->resource));
 		struct wlr_layer_surface_v1_configure *configure =
-			calloc(1, sizeof(struct wlr_layer_surface_v1_configure));
+			wlr_slab_alloc(get_configure_slab());
 		if (configure == NULL) {
 			wl_client_post_no_memory(wl_resource_get_client(surface->resource));
 			return;
@@ -313,6 +342,285 @@ void wlr_layer_surface_v1_close(struct wlr_layer_surface_v1 *surface) {
 	zwlr_layer_surface_v1_send_closed(surface->resource);
 }
 
+struct wlr_layer_shell_v1_output *wlr_layer_shell_v1_get_output(
+		struct wlr_layer_shell_v1 *shell, struct wlr_output *output) {
+	struct wlr_layer_shell_v1_output *shell_output;
+	wl_list_for_each(shell_output, &shell->outputs, link) {
+		if (shell_output->output == output) {
+			return shell_output;
+		}
+	}
+	return NULL;
+}
+
+static void layer_shell_output_handle_output_destroy(
+		struct wl_listener *listener, void *data) {
+	struct wlr_layer_shell_v1_output *shell_output =
+		wl_container_of(listener, shell_output, output_destroy);
+	wl_list_remove(&shell_output->link);
+	wl_list_remove(&shell_output->output_destroy.link);
+	free(shell_output);
+}
+
+/**
+ * Position a surface within the usable area (or within the full area for
+ * surfaces with a negative exclusive zone), honoring anchors and margins.
+ */
+static void layer_surface_compute_box(struct wlr_layer_surface_v1 *surface,
+		const struct wlr_box *full_area, const struct wlr_box *usable_area,
+		struct wlr_box *box) {
+	struct wlr_layer_surface_v1_state *state = &surface->current;
+	struct wlr_box bounds =
+		state->exclusive_zone < 0 ? *full_area : *usable_area;
+
+	box->width = state->desired_width;
+	box->height = state->desired_height;
+
+	// Horizontal axis
+	const uint32_t both_horiz = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT |
+		ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT;
+	if (box->width == 0) {
+		box->x = bounds.x;
+	} else if ((state->anchor & both_horiz) == both_horiz) {
+		box->x = bounds.x + ((bounds.width / 2) - (box->width / 2));
+	} else if (state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT) {
+		box->x = bounds.x;
+	} else if (state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT) {
+		box->x = bounds.x + (bounds.width - box->width);
+	} else {
+		box->x = bounds.x + ((bounds.width / 2) - (box->width / 2));
+	}
+	// Vertical axis
+	const uint32_t both_vert = ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP |
+		ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM;
+	if (box->height == 0) {
+		box->y = bounds.y;
+	} else if ((state->anchor & both_vert) == both_vert) {
+		box->y = bounds.y + ((bounds.height / 2) - (box->height / 2));
+	} else if (state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP) {
+		box->y = bounds.y;
+	} else if (state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM) {
+		box->y = bounds.y + (bounds.height - box->height);
+	} else {
+		box->y = bounds.y + ((bounds.height / 2) - (box->height / 2));
+	}
+	// Margins
+	if (box->width == 0) {
+		box->x = bounds.x + state->margin.left;
+		box->width = bounds.width -
+			(state->margin.left + state->margin.right);
+	} else if (state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT) {
+		box->x += state->margin.left;
+	} else if (state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT) {
+		box->x -= state->margin.right;
+	}
+	if (box->height == 0) {
+		box->y = bounds.y + state->margin.top;
+		box->height = bounds.height -
+			(state->margin.top + state->margin.bottom);
+	} else if (state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP) {
+		box->y += state->margin.top;
+	} else if (state->anchor & ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM) {
+		box->y -= state->margin.bottom;
+	}
+}
+
+static void layer_surface_apply_exclusive(struct wlr_layer_surface_v1 *surface,
+		struct wlr_box *usable_area) {
+	struct wlr_layer_surface_v1_state *state = &surface->current;
+	struct {
+		uint32_t singular_anchor;
+		uint32_t anchor_triplet;
+		int *positive_axis;
+		int *negative_axis;
+		int margin;
+	} edges[] = {
+		{
+			.singular_anchor = ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP,
+			.anchor_triplet = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT |
+				ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT |
+				ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP,
+			.positive_axis = &usable_area->y,
+			.negative_axis = &usable_area->height,
+			.margin = state->margin.top,
+		},
+		{
+			.singular_anchor = ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM,
+			.anchor_triplet = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT |
+				ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT |
+				ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM,
+			.positive_axis = NULL,
+			.negative_axis = &usable_area->height,
+			.margin = state->margin.bottom,
+		},
+		{
+			.singular_anchor = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT,
+			.anchor_triplet = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT |
+				ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP |
+				ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM,
+			.positive_axis = &usable_area->x,
+			.negative_axis = &usable_area->width,
+			.margin = state->margin.left,
+		},
+		{
+			.singular_anchor = ZWLR_LAYER_SURFACE_V1_ANCHOR_RIGHT,
+			.anchor_triplet = ZWLR_LAYER_SURFACE_V1_ANCHOR_LEFT |
+				ZWLR_LAYER_SURFACE_V1_ANCHOR_TOP |
+				ZWLR_LAYER_SURFACE_V1_ANCHOR_BOTTOM,
+			.positive_axis = NULL,
+			.negative_axis = &usable_area->width,
+			.margin = state->margin.right,
+		},
+	};
+	for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); ++i) {
+		if ((state->anchor == edges[i].singular_anchor ||
+				state->anchor == edges[i].anchor_triplet) &&
+				state->exclusive_zone + edges[i].margin > 0) {
+			if (edges[i].positive_axis) {
+				*edges[i].positive_axis +=
+					state->exclusive_zone + edges[i].margin;
+			}
+			if (edges[i].negative_axis) {
+				*edges[i].negative_axis -=
+					state->exclusive_zone + edges[i].margin;
+			}
+			break;
+		}
+	}
+}
+
+static void layer_shell_arrange_surface(struct wlr_layer_surface_v1 *surface,
+		struct wlr_layer_shell_v1_output *shell_output,
+		struct wlr_box *usable_area) {
+	surface->arrange_area = *usable_area;
+
+	layer_surface_compute_box(surface, &shell_output->full_area, usable_area,
+		&surface->geometry);
+	if (surface->current.exclusive_zone > 0) {
+		layer_surface_apply_exclusive(surface, usable_area);
+	}
+
+	// wlr_layer_surface_v1_configure only sends an event on size changes
+	wlr_layer_surface_v1_configure(surface, surface->geometry.width,
+		surface->geometry.height);
+}
+
+/**
+ * Arrange the surfaces on an output, layers from overlay down to background
+ * and exclusive surfaces before the rest within each layer. When `start` is
+ * non-NULL the surfaces arranged before it are untouched: the arrangement is
+ * resumed from start's usable-area snapshot, so only the surfaces that
+ * depend on its exclusive zone are recomputed.
+ */
+static void layer_shell_output_arrange(
+		struct wlr_layer_shell_v1_output *shell_output,
+		struct wlr_layer_surface_v1 *start) {
+	struct wlr_layer_shell_v1 *shell = shell_output->shell;
+
+	struct wlr_box usable_area = shell_output->full_area;
+	bool reached = start == NULL;
+	if (start != NULL) {
+		usable_area = start->arrange_area;
+	}
+
+	for (int layer = ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY;
+			layer >= ZWLR_LAYER_SHELL_V1_LAYER_BACKGROUND; --layer) {
+		for (int exclusive = 1; exclusive >= 0; --exclusive) {
+			struct wlr_layer_surface_v1 *surface;
+			wl_list_for_each(surface, &shell->surfaces, link) {
+				if (surface->output != shell_output->output ||
+						surface->closed ||
+						(int)surface->current.layer != layer ||
+						(surface->current.exclusive_zone > 0) !=
+							(bool)exclusive) {
+					continue;
+				}
+				if (!reached) {
+					if (surface != start) {
+						continue;
+					}
+					reached = true;
+				}
+				layer_shell_arrange_surface(surface, shell_output,
+					&usable_area);
+			}
+		}
+	}
+
+	if (memcmp(&usable_area, &shell_output->usable_area,
+			sizeof(usable_area)) != 0) {
+		shell_output->usable_area = usable_area;
+		wlr_signal_emit_safe(&shell->events.usable_area_changed,
+			shell_output);
+	}
+}
+
+void wlr_layer_shell_v1_arrange(struct wlr_layer_shell_v1 *shell,
+		struct wlr_output *output, const struct wlr_box *full_area) {
+	struct wlr_layer_shell_v1_output *shell_output =
+		wlr_layer_shell_v1_get_output(shell, output);
+	if (shell_output == NULL) {
+		shell_output = calloc(1, sizeof(struct wlr_layer_shell_v1_output));
+		if (shell_output == NULL) {
+			wlr_log(WLR_ERROR, "Failed to allocate wlr_layer_shell_v1_output");
+			return;
+		}
+		shell_output->shell = shell;
+		shell_output->output = output;
+		shell_output->usable_area = *full_area;
+		wl_list_insert(&shell->outputs, &shell_output->link);
+
+		shell_output->output_destroy.notify =
+			layer_shell_output_handle_output_destroy;
+		wl_signal_add(&output->events.destroy, &shell_output->output_destroy);
+	}
+
+	shell_output->full_area = *full_area;
+	layer_shell_output_arrange(shell_output, NULL);
+}
+
+/**
+ * Recompute the arrangement after a commit, restricted to what the change
+ * can actually affect: nothing, the surface alone, or the surfaces arranged
+ * after it (when an exclusive zone changed).
+ */
+static void layer_surface_update_arrangement(
+		struct wlr_layer_surface_v1 *surface,
+		const struct wlr_layer_surface_v1_state *old) {
+	if (surface->output == NULL) {
+		return;
+	}
+	struct wlr_layer_shell_v1_output *shell_output =
+		wlr_layer_shell_v1_get_output(surface->shell, surface->output);
+	if (shell_output == NULL) {
+		// The compositor doesn't use the arrangement engine
+		return;
+	}
+
+	struct wlr_layer_surface_v1_state *current = &surface->current;
+	bool margin_changed =
+		memcmp(&current->margin, &old->margin, sizeof(current->margin)) != 0;
+	bool affects_others = current->exclusive_zone != old->exclusive_zone ||
+		((current->exclusive_zone > 0 || old->exclusive_zone > 0) &&
+			(current->anchor != old->anchor || margin_changed));
+	bool affects_self = affects_others ||
+		current->anchor != old->anchor || margin_changed ||
+		current->desired_width != old->desired_width ||
+		current->desired_height != old->desired_height;
+
+	if (current->layer != old->layer ||
+			(current->exclusive_zone > 0) != (old->exclusive_zone > 0)) {
+		// The surface moved within the arrangement order, earlier
+		// snapshots are stale
+		layer_shell_output_arrange(shell_output, NULL);
+	} else if (affects_others) {
+		layer_shell_output_arrange(shell_output, surface);
+	} else if (affects_self) {
+		struct wlr_box usable_area = surface->arrange_area;
+		layer_shell_arrange_surface(surface, shell_output, &usable_area);
+	}
+}
+
 static void layer_surface_role_commit(struct wlr_surface *wlr_surface) {
 	struct wlr_layer_surface_v1 *surface =
 		wlr_layer_surface_v1_from_wlr_surface(wlr_surface);
@@ -363,6 +671,8 @@ static void layer_surface_role_commit(struct wlr_surface *wlr_surface) {
 		return;
 	}
 
+	struct wlr_layer_surface_v1_state old = surface->current;
+
 	surface->current.anchor = surface->client_pending.anchor;
 	surface->current.exclusive_zone = surface->client_pending.exclusive_zone;
 	surface->current.margin = surface->client_pending.margin;
@@ -389,6 +699,8 @@ static void layer_surface_role_commit(struct wlr_surface *wlr_surface) {
 			surface->mapped) {
 		layer_surface_unmap(surface);
 	}
+
+	layer_surface_update_arrangement(surface, &old);
 }
 
 static const struct wlr_surface_role layer_surface_role = {
@@ -456,6 +768,7 @@ static void layer_shell_handle_get_layer_surface(struct wl_client *wl_client,
 		return;
 	}
 
+	wl_list_insert(&shell->surfaces, &surface->link);
 	wl_list_init(&surface->configure_list);
 	wl_list_init(&surface->popups);
 
@@ -498,6 +811,11 @@ static void handle_display_destroy(struct wl_listener *listener, void *data) {
 	struct wlr_layer_shell_v1 *layer_shell =
 		wl_container_of(listener, layer_shell, display_destroy);
 	wlr_signal_emit_safe(&layer_shell->events.destroy, layer_shell);
+	struct wlr_layer_shell_v1_output *shell_output, *tmp;
+	wl_list_for_each_safe(shell_output, tmp, &layer_shell->outputs, link) {
+		wl_list_remove(&shell_output->output_destroy.link);
+		free(shell_output);
+	}
 	wl_list_remove(&layer_shell->display_destroy.link);
 	wl_global_destroy(layer_shell->global);
 	free(layer_shell);
@@ -519,7 +837,11 @@ struct wlr_layer_shell_v1 *wlr_layer_shell_v1_create(struct wl_display *display)
 	}
 	layer_shell->global = global;
 
+	wl_list_init(&layer_shell->surfaces);
+	wl_list_init(&layer_shell->outputs);
+
 	wl_signal_init(&layer_shell->events.new_surface);
+	wl_signal_init(&layer_shell->events.usable_area_changed);
 	wl_signal_init(&layer_shell->events.destroy);
 
 	layer_shell->display_destroy.notify = handle_display_destroy;
@@ -2,6 +2,7 @@
 #include <assert.h>
 #include <drm_fourcc.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include <wlr/render/drm_format_set.h>
@@ -407,6 +408,11 @@ static void linux_dmabuf_send_formats(struct wlr_linux_dmabuf_v1 *linux_dmabuf,
 			modifiers = &modifier_invalid;
 		}
 		for (size_t j = 0; j < modifiers_len; j++) {
+			if (linux_dmabuf->has_scanout_formats &&
+					!wlr_drm_format_set_has(&linux_dmabuf->scanout_formats,
+						fmt->format, modifiers[j])) {
+				continue;
+			}
 			if (version >= ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION) {
 				uint32_t modifier_lo = modifiers[j] & 0xFFFFFFFF;
 				uint32_t modifier_hi = modifiers[j] >> 32;
@@ -443,6 +449,8 @@ static void linux_dmabuf_v1_destroy(struct wlr_linux_dmabuf_v1 *linux_dmabuf) {
 	wl_list_remove(&linux_dmabuf->display_destroy.link);
 	wl_list_remove(&linux_dmabuf->renderer_destroy.link);
 
+	wlr_drm_format_set_finish(&linux_dmabuf->scanout_formats);
+
 	wl_global_destroy(linux_dmabuf->global);
 	free(linux_dmabuf);
 }
@@ -459,6 +467,45 @@ static void handle_renderer_destroy(struct wl_listener *listener, void *data) {
 	linux_dmabuf_v1_destroy(linux_dmabuf);
 }
 
+bool wlr_linux_dmabuf_v1_set_scanout_formats(
+		struct wlr_linux_dmabuf_v1 *linux_dmabuf,
+		const struct wlr_drm_format_set *scanout_formats) {
+	if (scanout_formats == NULL) {
+		wlr_drm_format_set_finish(&linux_dmabuf->scanout_formats);
+		memset(&linux_dmabuf->scanout_formats, 0,
+			sizeof(linux_dmabuf->scanout_formats));
+		linux_dmabuf->has_scanout_formats = false;
+		return true;
+	}
+
+	struct wlr_drm_format_set copy = {0};
+	for (size_t i = 0; i < scanout_formats->len; i++) {
+		const struct wlr_drm_format *fmt = scanout_formats->formats[i];
+		if (fmt->len == 0) {
+			if (!wlr_drm_format_set_add(&copy, fmt->format,
+					DRM_FORMAT_MOD_INVALID)) {
+				goto error_copy;
+			}
+			continue;
+		}
+		for (size_t j = 0; j < fmt->len; j++) {
+			if (!wlr_drm_format_set_add(&copy, fmt->format,
+					fmt->modifiers[j])) {
+				goto error_copy;
+			}
+		}
+	}
+
+	wlr_drm_format_set_finish(&linux_dmabuf->scanout_formats);
+	linux_dmabuf->scanout_formats = copy;
+	linux_dmabuf->has_scanout_formats = true;
+	return true;
+
+error_copy:
+	wlr_drm_format_set_finish(&copy);
+	return false;
+}
+
 struct wlr_linux_dmabuf_v1 *wlr_linux_dmabuf_v1_create(struct wl_display *display,
 		struct wlr_renderer *renderer) {
 	struct wlr_linux_dmabuf_v1 *linux_dmabuf =
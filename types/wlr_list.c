@@ -7,30 +7,47 @@
 #include <wlr/types/wlr_list.h>
 
 bool wlr_list_init(struct wlr_list *list) {
-	list->capacity = 10;
+	list->capacity =
+		sizeof(list->inline_items) / sizeof(list->inline_items[0]);
 	list->length = 0;
-	list->items = malloc(sizeof(void *) * list->capacity);
-	if (list->items == NULL) {
-		return false;
-	}
+	list->items = list->inline_items;
 	return true;
 }
 
-static bool list_resize(struct wlr_list *list) {
-	if (list->length == list->capacity) {
-		void *new_items = realloc(list->items,
-			sizeof(void *) * (list->capacity + 10));
-		if (!new_items) {
+bool wlr_list_reserve(struct wlr_list *list, size_t capacity) {
+	if (capacity <= list->capacity) {
+		return true;
+	}
+	if (list->items == list->inline_items) {
+		void **new_items = malloc(sizeof(void *) * capacity);
+		if (new_items == NULL) {
+			return false;
+		}
+		memcpy(new_items, list->items, sizeof(void *) * list->length);
+		list->items = new_items;
+	} else {
+		void *new_items = realloc(list->items, sizeof(void *) * capacity);
+		if (new_items == NULL) {
 			return false;
 		}
-		list->capacity += 10;
 		list->items = new_items;
 	}
+	list->capacity = capacity;
+	return true;
+}
+
+static bool list_resize(struct wlr_list *list) {
+	if (list->length == list->capacity) {
+		// Geometric growth keeps pushes amortized constant-time
+		return wlr_list_reserve(list, list->capacity * 2);
+	}
 	return true;
 }
 
 void wlr_list_finish(struct wlr_list *list) {
-	free(list->items);
+	if (list->items != list->inline_items) {
+		free(list->items);
+	}
 }
 
 void wlr_list_for_each(struct wlr_list *list, void (*callback)(void *item)) {
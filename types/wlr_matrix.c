@@ -148,6 +148,34 @@ void wlr_matrix_project_box(float mat[static 9], const struct wlr_box *box,
 	int width = box->width;
 	int height = box->height;
 
+	// Affine fast path: without a free rotation every factor is a known
+	// affine matrix, so the composition collapses into a handful of
+	// multiply-adds instead of a chain of full 3x3 multiplies. Projections
+	// from wlr_matrix_projection always have an affine bottom row.
+	if (rotation == 0 && projection[6] == 0.0f && projection[7] == 0.0f &&
+			projection[8] == 1.0f) {
+		const float *t = transforms[transform];
+
+		// T(x, y) × S(width, height) × (T(½, ½) × transform × T(-½, -½))
+		float l0 = width * t[0];
+		float l1 = width * t[1];
+		float l2 = width * 0.5f * (1.0f - t[0] - t[1]) + x;
+		float l3 = height * t[3];
+		float l4 = height * t[4];
+		float l5 = height * 0.5f * (1.0f - t[3] - t[4]) + y;
+
+		mat[0] = projection[0] * l0 + projection[1] * l3;
+		mat[1] = projection[0] * l1 + projection[1] * l4;
+		mat[2] = projection[0] * l2 + projection[1] * l5 + projection[2];
+		mat[3] = projection[3] * l0 + projection[4] * l3;
+		mat[4] = projection[3] * l1 + projection[4] * l4;
+		mat[5] = projection[3] * l2 + projection[4] * l5 + projection[5];
+		mat[6] = 0.0f;
+		mat[7] = 0.0f;
+		mat[8] = 1.0f;
+		return;
+	}
+
 	wlr_matrix_identity(mat);
 	wlr_matrix_translate(mat, x, y);
 
@@ -167,3 +195,50 @@ void wlr_matrix_project_box(float mat[static 9], const struct wlr_box *box,
 
 	wlr_matrix_multiply(mat, projection, mat);
 }
+
+void wlr_matrix_project_boxes(float (*mats)[9], const struct wlr_box *boxes,
+		size_t len, enum wl_output_transform transform, float rotation,
+		const float projection[static 9]) {
+	if (rotation != 0 || projection[6] != 0.0f || projection[7] != 0.0f ||
+			projection[8] != 1.0f) {
+		for (size_t i = 0; i < len; ++i) {
+			wlr_matrix_project_box(mats[i], &boxes[i], transform, rotation,
+				projection);
+		}
+		return;
+	}
+
+	// Everything except the box geometry is loop-invariant: fold the
+	// transform and the projection into per-result coefficients of the box
+	// width (cw) and height (ch), leaving ~12 multiply-adds per box
+	const float *t = transforms[transform];
+	float f2 = 0.5f * (1.0f - t[0] - t[1]);
+	float f5 = 0.5f * (1.0f - t[3] - t[4]);
+	float cw[6] = {
+		projection[0] * t[0], projection[0] * t[1], projection[0] * f2,
+		projection[3] * t[0], projection[3] * t[1], projection[3] * f2,
+	};
+	float ch[6] = {
+		projection[1] * t[3], projection[1] * t[4], projection[1] * f5,
+		projection[4] * t[3], projection[4] * t[4], projection[4] * f5,
+	};
+
+	for (size_t i = 0; i < len; ++i) {
+		const struct wlr_box *box = &boxes[i];
+		float *mat = mats[i];
+		float width = box->width;
+		float height = box->height;
+
+		mat[0] = width * cw[0] + height * ch[0];
+		mat[1] = width * cw[1] + height * ch[1];
+		mat[2] = width * cw[2] + height * ch[2] +
+			projection[0] * box->x + projection[1] * box->y + projection[2];
+		mat[3] = width * cw[3] + height * ch[3];
+		mat[4] = width * cw[4] + height * ch[4];
+		mat[5] = width * cw[5] + height * ch[5] +
+			projection[3] * box->x + projection[4] * box->y + projection[5];
+		mat[6] = 0.0f;
+		mat[7] = 0.0f;
+		mat[8] = 1.0f;
+	}
+}
@@ -0,0 +1,91 @@
+#include <pixman.h>
+#include <stdbool.h>
+#include <wlr/types/wlr_box.h>
+#include <wlr/types/wlr_occlusion.h>
+#include <wlr/types/wlr_surface.h>
+
+void wlr_occlusion_init(struct wlr_occlusion *occlusion) {
+	pixman_region32_init(&occlusion->opaque);
+}
+
+void wlr_occlusion_finish(struct wlr_occlusion *occlusion) {
+	pixman_region32_fini(&occlusion->opaque);
+}
+
+static bool visible_from_box(struct wlr_occlusion *occlusion,
+		const struct wlr_box *box, pixman_region32_t *visible) {
+	pixman_region32_clear(visible);
+	if (box->width <= 0 || box->height <= 0) {
+		return false;
+	}
+
+	pixman_region32_union_rect(visible, visible, box->x, box->y,
+		box->width, box->height);
+	pixman_region32_subtract(visible, visible, &occlusion->opaque);
+	return pixman_region32_not_empty(visible);
+}
+
+bool wlr_occlusion_add_surface(struct wlr_occlusion *occlusion,
+		struct wlr_surface *surface, int lx, int ly,
+		pixman_region32_t *visible) {
+	struct wlr_box box = {
+		.x = lx,
+		.y = ly,
+		.width = surface->current.width,
+		.height = surface->current.height,
+	};
+	bool any_visible = visible_from_box(occlusion, &box, visible);
+
+	// opaque_region is maintained by wlr_surface: it is clipped to the
+	// surface bounds and covers the whole surface for opaque buffer formats
+	if (pixman_region32_not_empty(&surface->opaque_region)) {
+		pixman_region32_t opaque;
+		pixman_region32_init(&opaque);
+		pixman_region32_copy(&opaque, &surface->opaque_region);
+		pixman_region32_translate(&opaque, lx, ly);
+		pixman_region32_union(&occlusion->opaque, &occlusion->opaque, &opaque);
+		pixman_region32_fini(&opaque);
+	}
+
+	return any_visible;
+}
+
+static bool occlusion_add_surface_tree(struct wlr_occlusion *occlusion,
+		struct wlr_surface *surface, int lx, int ly) {
+	bool any_visible = false;
+
+	// Subsurfaces are stacked above their parent, add them first
+	struct wlr_subsurface *subsurface;
+	wl_list_for_each_reverse(subsurface, &surface->subsurfaces, parent_link) {
+		any_visible |= occlusion_add_surface_tree(occlusion,
+			subsurface->surface, lx + subsurface->current.x,
+			ly + subsurface->current.y);
+	}
+
+	pixman_region32_t visible;
+	pixman_region32_init(&visible);
+	any_visible |= wlr_occlusion_add_surface(occlusion, surface, lx, ly,
+		&visible);
+	pixman_region32_fini(&visible);
+
+	return any_visible;
+}
+
+bool wlr_occlusion_add_surface_tree(struct wlr_occlusion *occlusion,
+		struct wlr_surface *surface, int lx, int ly) {
+	bool any_visible = occlusion_add_surface_tree(occlusion, surface, lx, ly);
+	wlr_surface_set_occluded(surface, !any_visible);
+	return any_visible;
+}
+
+bool wlr_occlusion_add_box(struct wlr_occlusion *occlusion,
+		const struct wlr_box *box, bool opaque, pixman_region32_t *visible) {
+	bool any_visible = visible_from_box(occlusion, box, visible);
+
+	if (opaque && box->width > 0 && box->height > 0) {
+		pixman_region32_union_rect(&occlusion->opaque, &occlusion->opaque,
+			box->x, box->y, box->width, box->height);
+	}
+
+	return any_visible;
+}
@@ -9,6 +9,7 @@
 #include <wlr/render/interface.h>
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/types/wlr_box.h>
+#include <wlr/types/wlr_buffer.h>
 #include <wlr/types/wlr_matrix.h>
 #include <wlr/types/wlr_output.h>
 #include <wlr/types/wlr_seat.h>
@@ -17,6 +18,7 @@
 #include <wlr/util/region.h>
 #include "util/global.h"
 #include "util/signal.h"
+#include "util/trace.h"
 
 #define OUTPUT_VERSION 3
 
@@ -137,6 +139,13 @@ void wlr_output_update_enabled(struct wlr_output *output, bool enabled) {
 
 	output->enabled = enabled;
 	wlr_signal_emit_safe(&output->events.enable, output);
+
+	if (enabled && !output->frames_suppressed &&
+			output->suppressed_frame_pending) {
+		// Replay the frame swallowed while the output was off
+		output->suppressed_frame_pending = false;
+		wlr_output_schedule_frame(output);
+	}
 }
 
 static void output_update_matrix(struct wlr_output *output) {
@@ -379,6 +388,10 @@ void wlr_output_destroy(struct wlr_output *output) {
 		wl_event_source_remove(output->idle_frame);
 	}
 
+	if (output->frame_timer != NULL) {
+		wl_event_source_remove(output->frame_timer);
+	}
+
 	if (output->idle_done != NULL) {
 		wl_event_source_remove(output->idle_done);
 	}
@@ -508,8 +521,13 @@ static void output_pending_resolution(struct wlr_output *output, int *width,
 static bool output_basic_test(struct wlr_output *output) {
 	if (output->pending.committed & WLR_OUTPUT_STATE_BUFFER) {
 		if (output->frame_pending) {
-			wlr_log(WLR_DEBUG, "Tried to commit a buffer while a frame is pending");
-			return false;
+			// With frame pipelining, one extra frame may be committed
+			// behind the frame awaiting its flip
+			if (!output->frame_pipelining_enabled || output->frame_queued) {
+				wlr_log(WLR_DEBUG,
+					"Tried to commit a buffer while a frame is pending");
+				return false;
+			}
 		}
 
 		if (output->pending.buffer_type == WLR_OUTPUT_STATE_BUFFER_SCANOUT) {
@@ -574,6 +592,8 @@ bool wlr_output_test(struct wlr_output *output) {
 	return output->impl->test(output);
 }
 
+static void output_schedule_pipelined_frame(struct wlr_output *output);
+
 bool wlr_output_commit(struct wlr_output *output) {
 	if (!output_basic_test(output)) {
 		wlr_log(WLR_ERROR, "Basic output test failed for %s", output->name);
@@ -589,13 +609,35 @@ bool wlr_output_commit(struct wlr_output *output) {
 	struct timespec now;
 	clock_gettime(CLOCK_MONOTONIC, &now);
 
+	if (output->frame_scheduler_enabled &&
+			(output->pending.committed & WLR_OUTPUT_STATE_BUFFER) &&
+			output->last_frame_signal.tv_sec != 0) {
+		int64_t render_nsec = (int64_t)(now.tv_sec -
+			output->last_frame_signal.tv_sec) * 1000000000 +
+			(now.tv_nsec - output->last_frame_signal.tv_nsec);
+		// Overestimating only costs a little latency, underestimating costs
+		// a missed vblank: adopt slower frames at once, decay towards faster
+		// ones
+		if (render_nsec > output->frame_render_time_pred) {
+			output->frame_render_time_pred = render_nsec;
+		} else {
+			output->frame_render_time_pred =
+				(output->frame_render_time_pred * 3 + render_nsec) / 4;
+		}
+		output->last_frame_signal.tv_sec = 0;
+		output->last_frame_signal.tv_nsec = 0;
+	}
+
 	struct wlr_output_event_precommit pre_event = {
 		.output = output,
 		.when = &now,
 	};
 	wlr_signal_emit_safe(&output->events.precommit, &pre_event);
 
-	if (!output->impl->commit(output)) {
+	trace_span_begin("output_commit");
+	bool ok = output->impl->commit(output);
+	trace_span_end("output_commit");
+	if (!ok) {
 		output_state_clear(&output->pending);
 		return false;
 	}
@@ -612,6 +654,9 @@ bool wlr_output_commit(struct wlr_output *output) {
 
 	output->commit_seq++;
 
+	wlr_trace(output_commit, output, output->commit_seq,
+		output->pending.committed);
+
 	bool scale_updated = output->pending.committed & WLR_OUTPUT_STATE_SCALE;
 	if (scale_updated) {
 		output->scale = output->pending.scale;
@@ -638,7 +683,15 @@ bool wlr_output_commit(struct wlr_output *output) {
 	}
 
 	if (output->pending.committed & WLR_OUTPUT_STATE_BUFFER) {
-		output->frame_pending = true;
+		if (output->frame_pending) {
+			// Pipelined: this commit was queued behind the one in flight
+			output->frame_queued = true;
+		} else {
+			output->frame_pending = true;
+			if (output->frame_pipelining_enabled) {
+				output_schedule_pipelined_frame(output);
+			}
+		}
 		output->needs_frame = false;
 	}
 
@@ -652,6 +705,10 @@ bool wlr_output_commit(struct wlr_output *output) {
 	};
 	wlr_signal_emit_safe(&output->events.commit, &event);
 
+	// With release batching enabled, releases accumulated while rendering
+	// this frame go out in a single burst
+	wlr_buffer_flush_releases();
+
 	return true;
 }
 
@@ -673,9 +730,119 @@ void wlr_output_attach_buffer(struct wlr_output *output,
 	output->pending.buffer = wlr_buffer_lock(buffer);
 }
 
+// Safety margin subtracted from the predicted frame deadline, to absorb
+// render-time variance and timer jitter
+#define OUTPUT_FRAME_SCHEDULER_MARGIN_NSEC (2 * 1000 * 1000)
+
+static void output_emit_frame(struct wlr_output *output) {
+	if (output->frames_suppressed || !output->enabled) {
+		// Remember that a frame was wanted, so it can be replayed when the
+		// output becomes visible again
+		output->suppressed_frame_pending = true;
+		return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &output->last_frame_signal);
+	wlr_signal_emit_safe(&output->events.frame, output);
+}
+
+static int output_frame_timer_handler(void *data) {
+	struct wlr_output *output = data;
+	if (!output->frame_pending) {
+		output_emit_frame(output);
+	}
+	return 0;
+}
+
+static void pipelined_frame_handle_idle(void *data) {
+	struct wlr_output *output = data;
+	output->idle_frame = NULL;
+	if (!output->frame_queued) {
+		output_emit_frame(output);
+	}
+}
+
+/**
+ * Ask the compositor for the next frame right away, so that it is already
+ * committed when the frame in flight completes.
+ */
+static void output_schedule_pipelined_frame(struct wlr_output *output) {
+	if (output->idle_frame != NULL) {
+		return;
+	}
+	struct wl_event_loop *ev = wl_display_get_event_loop(output->display);
+	output->idle_frame =
+		wl_event_loop_add_idle(ev, pipelined_frame_handle_idle, output);
+}
+
+void wlr_output_enable_frame_pipelining(struct wlr_output *output,
+		bool enabled) {
+	output->frame_pipelining_enabled = enabled;
+}
+
+void wlr_output_suppress_frames(struct wlr_output *output, bool suppressed) {
+	if (output->frames_suppressed == suppressed) {
+		return;
+	}
+	output->frames_suppressed = suppressed;
+
+	if (!suppressed && output->suppressed_frame_pending && output->enabled) {
+		output->suppressed_frame_pending = false;
+		wlr_output_schedule_frame(output);
+	}
+}
+
 void wlr_output_send_frame(struct wlr_output *output) {
+	if (output->frame_queued) {
+		// The queued frame takes over the in-flight slot: the output is
+		// still busy, but there is room for the next frame now
+		output->frame_queued = false;
+		output_emit_frame(output);
+		return;
+	}
+
 	output->frame_pending = false;
-	wlr_signal_emit_safe(&output->events.frame, output);
+
+	if (output->frame_scheduler_enabled && output->refresh > 0 &&
+			output->frame_render_time_pred > 0) {
+		// Called right after a buffer has been presented: the next deadline
+		// is one refresh period away. Delay the frame event so that
+		// rendering finishes just before it instead of right after the
+		// previous one.
+		int64_t period_nsec = 1000000000000LL / output->refresh;
+		int64_t delay_nsec = period_nsec - output->frame_render_time_pred -
+			OUTPUT_FRAME_SCHEDULER_MARGIN_NSEC;
+		int delay_msec = delay_nsec / 1000000;
+		if (delay_msec >= 1) {
+			wl_event_source_timer_update(output->frame_timer, delay_msec);
+			return;
+		}
+	}
+
+	output_emit_frame(output);
+}
+
+void wlr_output_enable_frame_scheduler(struct wlr_output *output,
+		bool enabled) {
+	if (enabled == output->frame_scheduler_enabled) {
+		return;
+	}
+
+	if (enabled) {
+		struct wl_event_loop *ev = wl_display_get_event_loop(output->display);
+		output->frame_timer =
+			wl_event_loop_add_timer(ev, output_frame_timer_handler, output);
+		if (output->frame_timer == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create frame scheduler timer");
+			return;
+		}
+	} else {
+		wl_event_source_remove(output->frame_timer);
+		output->frame_timer = NULL;
+		output->frame_render_time_pred = 0;
+	}
+
+	output->frame_scheduler_enabled = enabled;
 }
 
 static void schedule_frame_handle_idle_timer(void *data) {
@@ -935,6 +1102,11 @@ static void output_cursor_get_box(struct wlr_output_cursor *cursor,
 }
 
 static void output_cursor_damage_whole(struct wlr_output_cursor *cursor) {
+	if (!cursor->visible) {
+		// Nothing of the cursor is on screen, no repaint needed
+		return;
+	}
+
 	struct wlr_box box;
 	output_cursor_get_box(cursor, &box);
 
@@ -989,6 +1161,126 @@ static void output_cursor_update_visible(struct wlr_output_cursor *cursor) {
 	cursor->visible = visible;
 }
 
+// Largest combined cursor-plus-drag-icon image we'll try to put on the
+// cursor plane. Anything bigger is unlikely to fit a cursor plane anyway and
+// would make the CPU composition noticeable.
+#define OUTPUT_CURSOR_DRAG_MAX_SIZE 512
+
+/**
+ * Blits an ARGB8888 image into dst at (x, y), blending with the
+ * premultiplied-alpha "over" operator. With opaque set, the source alpha
+ * channel is ignored (for XRGB8888 sources).
+ */
+static void output_cursor_blit(uint8_t *dst, int32_t dst_stride,
+		const uint8_t *src, int32_t src_stride, uint32_t width,
+		uint32_t height, int32_t x, int32_t y, bool opaque) {
+	for (uint32_t j = 0; j < height; ++j) {
+		uint8_t *d = dst + (y + j) * dst_stride + x * 4;
+		const uint8_t *s = src + j * src_stride;
+		for (uint32_t i = 0; i < width; ++i) {
+			if (opaque) {
+				d[0] = s[0];
+				d[1] = s[1];
+				d[2] = s[2];
+				d[3] = 0xFF;
+			} else {
+				uint32_t a = s[3];
+				d[0] = s[0] + d[0] * (255 - a) / 255;
+				d[1] = s[1] + d[1] * (255 - a) / 255;
+				d[2] = s[2] + d[2] * (255 - a) / 255;
+				d[3] = s[3] + d[3] * (255 - a) / 255;
+			}
+			d += 4;
+			s += 4;
+		}
+	}
+}
+
+/**
+ * Composites the cursor image and the drag icon into a single texture fit for
+ * the cursor plane, and adjusts the hotspot for the combined image's origin.
+ * Returns NULL when the pair can't be composited (surface cursor, non-shm or
+ * oversized icon), in which case the icon must go through the composite path.
+ */
+static struct wlr_texture *output_cursor_render_drag(
+		struct wlr_output_cursor *cursor, int32_t *hotspot_x,
+		int32_t *hotspot_y) {
+	// Only image cursors keep their pixels around for recompositing
+	if (cursor->surface != NULL || cursor->image_pixels == NULL) {
+		return NULL;
+	}
+
+	struct wlr_surface *icon = cursor->drag_surface;
+	if (!wlr_surface_has_buffer(icon) || icon->buffer->resource == NULL ||
+			icon->current.scale != 1 ||
+			icon->current.transform != WL_OUTPUT_TRANSFORM_NORMAL) {
+		return NULL;
+	}
+	struct wl_shm_buffer *shm_buf = wl_shm_buffer_get(icon->buffer->resource);
+	if (shm_buf == NULL) {
+		return NULL;
+	}
+	uint32_t format = wl_shm_buffer_get_format(shm_buf);
+	if (format != WL_SHM_FORMAT_ARGB8888 && format != WL_SHM_FORMAT_XRGB8888) {
+		return NULL;
+	}
+
+	int32_t icon_width = wl_shm_buffer_get_width(shm_buf);
+	int32_t icon_height = wl_shm_buffer_get_height(shm_buf);
+
+	// Combined bounds, in buffer pixels relative to the cursor image origin
+	int32_t x1 = cursor->drag_dx < 0 ? cursor->drag_dx : 0;
+	int32_t y1 = cursor->drag_dy < 0 ? cursor->drag_dy : 0;
+	int32_t x2 = (int32_t)cursor->image_width;
+	if (cursor->drag_dx + icon_width > x2) {
+		x2 = cursor->drag_dx + icon_width;
+	}
+	int32_t y2 = (int32_t)cursor->image_height;
+	if (cursor->drag_dy + icon_height > y2) {
+		y2 = cursor->drag_dy + icon_height;
+	}
+	int32_t width = x2 - x1;
+	int32_t height = y2 - y1;
+	if (width > OUTPUT_CURSOR_DRAG_MAX_SIZE ||
+			height > OUTPUT_CURSOR_DRAG_MAX_SIZE) {
+		return NULL;
+	}
+
+	int32_t stride = width * 4;
+	uint8_t *data = calloc(height, stride);
+	if (data == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+
+	// Icon first, so the pointer image stays on top
+	wl_shm_buffer_begin_access(shm_buf);
+	output_cursor_blit(data, stride, wl_shm_buffer_get_data(shm_buf),
+		wl_shm_buffer_get_stride(shm_buf), icon_width, icon_height,
+		cursor->drag_dx - x1, cursor->drag_dy - y1,
+		format == WL_SHM_FORMAT_XRGB8888);
+	wl_shm_buffer_end_access(shm_buf);
+	output_cursor_blit(data, stride, cursor->image_pixels,
+		cursor->image_stride, cursor->image_width, cursor->image_height,
+		-x1, -y1, false);
+
+	struct wlr_texture *texture = NULL;
+	struct wlr_renderer *renderer =
+		wlr_backend_get_renderer(cursor->output->backend);
+	if (renderer != NULL) {
+		texture = wlr_texture_from_pixels(renderer, WL_SHM_FORMAT_ARGB8888,
+			stride, width, height, data);
+	}
+	free(data);
+	if (texture == NULL) {
+		return NULL;
+	}
+
+	*hotspot_x = cursor->hotspot_x - x1;
+	*hotspot_y = cursor->hotspot_y - y1;
+	return texture;
+}
+
 static bool output_cursor_attempt_hardware(struct wlr_output_cursor *cursor) {
 	float scale = cursor->output->scale;
 	enum wl_output_transform transform = WL_OUTPUT_TRANSFORM_NORMAL;
@@ -1000,22 +1292,41 @@ static bool output_cursor_attempt_hardware(struct wlr_output_cursor *cursor) {
 	}
 
 	if (cursor->output->software_cursor_locks > 0) {
+		cursor->drag_surface_on_plane = false;
 		return false;
 	}
 
 	struct wlr_output_cursor *hwcur = cursor->output->hardware_cursor;
 	if (cursor->output->impl->set_cursor && (hwcur == NULL || hwcur == cursor)) {
+		int32_t hotspot_x = cursor->hotspot_x;
+		int32_t hotspot_y = cursor->hotspot_y;
+		struct wlr_texture *combined = NULL;
+		if (cursor->drag_surface != NULL && texture != NULL) {
+			combined = output_cursor_render_drag(cursor,
+				&hotspot_x, &hotspot_y);
+			if (combined != NULL) {
+				texture = combined;
+			}
+		}
+
 		// If the cursor was hidden or was a software cursor, the hardware
 		// cursor position is outdated
 		assert(cursor->output->impl->move_cursor);
 		cursor->output->impl->move_cursor(cursor->output,
 			(int)cursor->x, (int)cursor->y);
 		if (cursor->output->impl->set_cursor(cursor->output, texture,
-				scale, transform, cursor->hotspot_x, cursor->hotspot_y, true)) {
+				scale, transform, hotspot_x, hotspot_y, true)) {
 			cursor->output->hardware_cursor = cursor;
+			if (combined != NULL) {
+				wlr_texture_destroy(cursor->drag_texture);
+				cursor->drag_texture = combined;
+			}
+			cursor->drag_surface_on_plane = combined != NULL;
 			return true;
 		}
+		wlr_texture_destroy(combined);
 	}
+	cursor->drag_surface_on_plane = false;
 	return false;
 }
 
@@ -1041,6 +1352,9 @@ bool wlr_output_cursor_set_image(struct wlr_output_cursor *cursor,
 	wlr_texture_destroy(cursor->texture);
 	cursor->texture = NULL;
 
+	free(cursor->image_pixels);
+	cursor->image_pixels = NULL;
+
 	cursor->enabled = false;
 	if (pixels != NULL) {
 		cursor->texture = wlr_texture_from_pixels(renderer,
@@ -1049,6 +1363,19 @@ bool wlr_output_cursor_set_image(struct wlr_output_cursor *cursor,
 			return false;
 		}
 		cursor->enabled = true;
+
+		// Keep a CPU copy of the image so it can be recomposited with a
+		// drag icon. Losing it on allocation failure only costs the
+		// hardware plane for drags, so it isn't fatal.
+		cursor->image_pixels = malloc((size_t)stride * height);
+		if (cursor->image_pixels != NULL) {
+			memcpy(cursor->image_pixels, pixels, (size_t)stride * height);
+			cursor->image_stride = stride;
+			cursor->image_width = width;
+			cursor->image_height = height;
+		} else {
+			wlr_log(WLR_ERROR, "Allocation failed");
+		}
 	}
 
 	if (output_cursor_attempt_hardware(cursor)) {
@@ -1061,8 +1388,53 @@ bool wlr_output_cursor_set_image(struct wlr_output_cursor *cursor,
 	return true;
 }
 
+/**
+ * Returns true if the commit only changes the surface contents, so a cursor
+ * already on the hardware plane can be updated by re-uploading its texture,
+ * without recomputing visibility or damaging the output.
+ */
+static bool output_cursor_commit_hardware(struct wlr_output_cursor *cursor) {
+	struct wlr_surface *surface = cursor->surface;
+	struct wlr_output *output = cursor->output;
+
+	if (output->hardware_cursor != cursor ||
+			output->software_cursor_locks > 0) {
+		return false;
+	}
+	if (!cursor->enabled || !wlr_surface_has_buffer(surface)) {
+		return false;
+	}
+	if ((uint32_t)(surface->current.width * output->scale) != cursor->width ||
+			(uint32_t)(surface->current.height * output->scale) !=
+			cursor->height) {
+		return false;
+	}
+	if (surface->current.dx != 0 || surface->current.dy != 0) {
+		// The commit moves the hotspot
+		return false;
+	}
+
+	struct wlr_texture *texture = wlr_surface_get_texture(surface);
+	if (texture == NULL) {
+		return false;
+	}
+
+	assert(output->impl->set_cursor);
+	return output->impl->set_cursor(output, texture, surface->current.scale,
+		surface->current.transform, cursor->hotspot_x, cursor->hotspot_y,
+		true);
+}
+
 static void output_cursor_commit(struct wlr_output_cursor *cursor,
 		bool update_hotspot) {
+	// Fast path for animated cursors: a commit of the already-attached
+	// surface which only brings new contents for the cursor plane doesn't
+	// need the full fallback logic. The initial commit after attaching a
+	// surface still goes through it for the output enter/leave bookkeeping.
+	if (update_hotspot && output_cursor_commit_hardware(cursor)) {
+		return;
+	}
+
 	if (cursor->output->hardware_cursor != cursor) {
 		output_cursor_damage_whole(cursor);
 	}
@@ -1102,6 +1474,57 @@ static void output_cursor_handle_destroy(struct wl_listener *listener,
 	output_cursor_reset(cursor);
 }
 
+static void output_cursor_handle_drag_commit(struct wl_listener *listener,
+		void *data) {
+	struct wlr_output_cursor *cursor = wl_container_of(listener, cursor,
+		drag_surface_commit);
+	// New icon contents: recomposite onto the plane, or drop back to the
+	// composite path if the icon no longer fits
+	if (cursor->output->hardware_cursor == cursor &&
+			!output_cursor_attempt_hardware(cursor)) {
+		output_cursor_damage_whole(cursor);
+	}
+}
+
+static void output_cursor_handle_drag_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_output_cursor *cursor = wl_container_of(listener, cursor,
+		drag_surface_destroy);
+	wlr_output_cursor_set_drag_surface(cursor, NULL, 0, 0);
+}
+
+void wlr_output_cursor_set_drag_surface(struct wlr_output_cursor *cursor,
+		struct wlr_surface *surface, int32_t dx, int32_t dy) {
+	if (cursor->drag_surface == surface && cursor->drag_dx == dx &&
+			cursor->drag_dy == dy) {
+		return;
+	}
+
+	if (cursor->drag_surface != NULL) {
+		wl_list_remove(&cursor->drag_surface_commit.link);
+		wl_list_init(&cursor->drag_surface_commit.link);
+		wl_list_remove(&cursor->drag_surface_destroy.link);
+		wl_list_init(&cursor->drag_surface_destroy.link);
+	}
+
+	cursor->drag_surface = surface;
+	cursor->drag_dx = dx;
+	cursor->drag_dy = dy;
+
+	if (surface != NULL) {
+		wl_signal_add(&surface->events.commit, &cursor->drag_surface_commit);
+		wl_signal_add(&surface->events.destroy, &cursor->drag_surface_destroy);
+	}
+
+	if (!cursor->enabled) {
+		cursor->drag_surface_on_plane = false;
+		return;
+	}
+	if (!output_cursor_attempt_hardware(cursor)) {
+		output_cursor_damage_whole(cursor);
+	}
+}
+
 void wlr_output_cursor_set_surface(struct wlr_output_cursor *cursor,
 		struct wlr_surface *surface, int32_t hotspot_x, int32_t hotspot_y) {
 	hotspot_x *= cursor->output->scale;
@@ -1116,6 +1539,8 @@ void wlr_output_cursor_set_surface(struct wlr_output_cursor *cursor,
 		cursor->hotspot_x = hotspot_x;
 		cursor->hotspot_y = hotspot_y;
 		if (cursor->output->hardware_cursor != cursor) {
+			// The hotspot moves the cursor box, possibly on or off screen
+			output_cursor_update_visible(cursor);
 			output_cursor_damage_whole(cursor);
 		} else {
 			assert(cursor->output->impl->set_cursor);
@@ -1156,8 +1581,17 @@ bool wlr_output_cursor_move(struct wlr_output_cursor *cursor,
 		return true;
 	}
 
-	if (cursor->output->hardware_cursor != cursor) {
-		output_cursor_damage_whole(cursor);
+	bool software = cursor->output->hardware_cursor != cursor;
+
+	// A software cursor move repaints at most the old and the new cursor
+	// rectangles, sent out as a single damage event
+	pixman_region32_t damage;
+	pixman_region32_init(&damage);
+	if (software && cursor->visible) {
+		struct wlr_box box;
+		output_cursor_get_box(cursor, &box);
+		pixman_region32_union_rect(&damage, &damage, box.x, box.y,
+			box.width, box.height);
 	}
 
 	bool was_visible = cursor->visible;
@@ -1167,13 +1601,28 @@ bool wlr_output_cursor_move(struct wlr_output_cursor *cursor,
 	cursor->y = y;
 	output_cursor_update_visible(cursor);
 
-	if (!was_visible && !cursor->visible) {
-		// Cursor is still hidden, do nothing
+	if (software) {
+		if (cursor->visible) {
+			struct wlr_box box;
+			output_cursor_get_box(cursor, &box);
+			pixman_region32_union_rect(&damage, &damage, box.x, box.y,
+				box.width, box.height);
+		}
+
+		if (pixman_region32_not_empty(&damage)) {
+			struct wlr_output_event_damage event = {
+				.output = cursor->output,
+				.damage = &damage,
+			};
+			wlr_signal_emit_safe(&cursor->output->events.damage, &event);
+		}
+		pixman_region32_fini(&damage);
 		return true;
 	}
+	pixman_region32_fini(&damage);
 
-	if (cursor->output->hardware_cursor != cursor) {
-		output_cursor_damage_whole(cursor);
+	if (!was_visible && !cursor->visible) {
+		// Cursor is still hidden, no need to move it
 		return true;
 	}
 
@@ -1193,6 +1642,10 @@ struct wlr_output_cursor *wlr_output_cursor_create(struct wlr_output *output) {
 	cursor->surface_commit.notify = output_cursor_handle_commit;
 	wl_list_init(&cursor->surface_destroy.link);
 	cursor->surface_destroy.notify = output_cursor_handle_destroy;
+	wl_list_init(&cursor->drag_surface_commit.link);
+	cursor->drag_surface_commit.notify = output_cursor_handle_drag_commit;
+	wl_list_init(&cursor->drag_surface_destroy.link);
+	cursor->drag_surface_destroy.notify = output_cursor_handle_drag_destroy;
 	wl_list_insert(&output->cursors, &cursor->link);
 	cursor->visible = true; // default position is at (0, 0)
 	return cursor;
@@ -1212,7 +1665,13 @@ void wlr_output_cursor_destroy(struct wlr_output_cursor *cursor) {
 		}
 		cursor->output->hardware_cursor = NULL;
 	}
+	if (cursor->drag_surface != NULL) {
+		wl_list_remove(&cursor->drag_surface_commit.link);
+		wl_list_remove(&cursor->drag_surface_destroy.link);
+	}
 	wlr_texture_destroy(cursor->texture);
+	wlr_texture_destroy(cursor->drag_texture);
+	free(cursor->image_pixels);
 	wl_list_remove(&cursor->link);
 	free(cursor);
 }
@@ -0,0 +1,217 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pixman.h>
+#include <stdlib.h>
+#include <time.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/util/log.h>
+#include "types/wlr_output_capture.h"
+
+static struct wl_list sources; // wlr_output_capture_source::link
+static bool sources_initialized = false;
+
+static struct wl_list *get_sources(void) {
+	if (!sources_initialized) {
+		wl_list_init(&sources);
+		sources_initialized = true;
+	}
+	return &sources;
+}
+
+static void source_destroy(struct wlr_output_capture_source *source) {
+	// Detach any remaining consumers; their owners notice through their own
+	// output destroy listeners (or stay idle until the client gives up)
+	struct wlr_output_capture_consumer *consumer, *tmp;
+	wl_list_for_each_safe(consumer, tmp, &source->consumers, link) {
+		consumer->source = NULL;
+		wl_list_remove(&consumer->link);
+		wl_list_init(&consumer->link);
+	}
+
+	wl_list_remove(&source->output_precommit.link);
+	wl_list_remove(&source->output_commit.link);
+	wl_list_remove(&source->output_destroy.link);
+	wl_list_remove(&source->link);
+	free(source);
+}
+
+static bool consumer_within_budget(
+		struct wlr_output_capture_consumer *consumer,
+		const struct timespec *now) {
+	if (consumer->max_fps == 0) {
+		return true;
+	}
+	int64_t elapsed =
+		(int64_t)(now->tv_sec - consumer->last_capture.tv_sec) * 1000000000 +
+		(now->tv_nsec - consumer->last_capture.tv_nsec);
+	return elapsed >= 1000000000 / (int64_t)consumer->max_fps;
+}
+
+static void source_handle_output_precommit(struct wl_listener *listener,
+		void *data) {
+	struct wlr_output_capture_source *source =
+		wl_container_of(listener, source, output_precommit);
+	struct wlr_output_event_precommit *event = data;
+	struct wlr_output *output = source->output;
+
+	if (!(output->pending.committed & WLR_OUTPUT_STATE_BUFFER)) {
+		return;
+	}
+
+	bool damaged = true;
+	if (output->pending.committed & WLR_OUTPUT_STATE_DAMAGE) {
+		damaged = pixman_region32_not_empty(&output->pending.damage);
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	// Callbacks may remove arbitrary consumers (e.g. when one capture is
+	// shared with other waiting clients), so walk the list with a cursor
+	// the same way wlr_signal_emit_safe does
+	struct wl_list cursor, end;
+	wl_list_insert(&source->consumers, &cursor);
+	wl_list_insert(source->consumers.prev, &end);
+
+	while (cursor.next != &end) {
+		struct wl_list *pos = cursor.next;
+		struct wlr_output_capture_consumer *consumer =
+			wl_container_of(pos, consumer, link);
+
+		wl_list_remove(&cursor);
+		wl_list_insert(pos, &cursor);
+
+		consumer->damaged = consumer->damaged || damaged;
+		consumer->eligible =
+			(!consumer->only_damaged || consumer->damaged) &&
+			consumer_within_budget(consumer, &now);
+		if (consumer->eligible && consumer->precommit != NULL) {
+			consumer->precommit(consumer, event);
+		}
+	}
+
+	wl_list_remove(&cursor);
+	wl_list_remove(&end);
+
+	// The sentinels kept the list non-empty while callbacks removed
+	// consumers, so check again now that they're gone
+	if (wl_list_empty(&source->consumers)) {
+		source_destroy(source);
+	}
+}
+
+static void source_handle_output_commit(struct wl_listener *listener,
+		void *data) {
+	struct wlr_output_capture_source *source =
+		wl_container_of(listener, source, output_commit);
+	struct wlr_output_event_commit *event = data;
+
+	if (!(event->committed & WLR_OUTPUT_STATE_BUFFER)) {
+		return;
+	}
+
+	struct wl_list cursor, end;
+	wl_list_insert(&source->consumers, &cursor);
+	wl_list_insert(source->consumers.prev, &end);
+
+	while (cursor.next != &end) {
+		struct wl_list *pos = cursor.next;
+		struct wlr_output_capture_consumer *consumer =
+			wl_container_of(pos, consumer, link);
+
+		wl_list_remove(&cursor);
+		wl_list_insert(pos, &cursor);
+
+		// Eligibility was decided in the precommit phase; consume it even
+		// when there's no commit callback
+		bool eligible = consumer->eligible;
+		consumer->eligible = false;
+		if (eligible && consumer->commit != NULL) {
+			consumer->commit(consumer, event);
+		}
+	}
+
+	wl_list_remove(&cursor);
+	wl_list_remove(&end);
+
+	if (wl_list_empty(&source->consumers)) {
+		source_destroy(source);
+	}
+}
+
+static void source_handle_output_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_output_capture_source *source =
+		wl_container_of(listener, source, output_destroy);
+	source_destroy(source);
+}
+
+static struct wlr_output_capture_source *source_get_or_create(
+		struct wlr_output *output) {
+	struct wlr_output_capture_source *source;
+	wl_list_for_each(source, get_sources(), link) {
+		if (source->output == output) {
+			return source;
+		}
+	}
+
+	source = calloc(1, sizeof(struct wlr_output_capture_source));
+	if (source == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	source->output = output;
+	wl_list_init(&source->consumers);
+	wl_list_insert(get_sources(), &source->link);
+
+	wl_signal_add(&output->events.precommit, &source->output_precommit);
+	source->output_precommit.notify = source_handle_output_precommit;
+
+	wl_signal_add(&output->events.commit, &source->output_commit);
+	source->output_commit.notify = source_handle_output_commit;
+
+	wl_signal_add(&output->events.destroy, &source->output_destroy);
+	source->output_destroy.notify = source_handle_output_destroy;
+
+	return source;
+}
+
+bool wlr_output_capture_add(struct wlr_output *output,
+		struct wlr_output_capture_consumer *consumer) {
+	struct wlr_output_capture_source *source = source_get_or_create(output);
+	if (source == NULL) {
+		return false;
+	}
+
+	consumer->source = source;
+	consumer->last_capture = source->last_capture;
+	consumer->damaged = false;
+	consumer->eligible = false;
+	wl_list_insert(&source->consumers, &consumer->link);
+	return true;
+}
+
+void wlr_output_capture_remove(struct wlr_output_capture_consumer *consumer) {
+	struct wlr_output_capture_source *source = consumer->source;
+	if (source == NULL) {
+		return;
+	}
+
+	consumer->source = NULL;
+	wl_list_remove(&consumer->link);
+	wl_list_init(&consumer->link);
+
+	if (wl_list_empty(&source->consumers)) {
+		source_destroy(source);
+	}
+}
+
+void wlr_output_capture_consumer_captured(
+		struct wlr_output_capture_consumer *consumer) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	consumer->last_capture = now;
+	consumer->damaged = false;
+	if (consumer->source != NULL) {
+		consumer->source->last_capture = now;
+	}
+}
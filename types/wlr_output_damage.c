@@ -1,10 +1,15 @@
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <wayland-server-core.h>
+#include <wlr/backend.h>
+#include <wlr/render/wlr_renderer.h>
 #include <wlr/types/wlr_box.h>
 #include <wlr/types/wlr_output_damage.h>
 #include <wlr/types/wlr_output.h>
+#include <wlr/util/region.h>
 #include "util/signal.h"
 
 static void output_handle_destroy(struct wl_listener *listener, void *data) {
@@ -44,6 +49,56 @@ static void output_handle_frame(struct wl_listener *listener, void *data) {
 	wlr_signal_emit_safe(&output_damage->events.frame, output_damage);
 }
 
+static void output_damage_overlay_region(
+		struct wlr_output_damage *output_damage,
+		struct wlr_renderer *renderer, pixman_region32_t *region,
+		const float color[static 4]) {
+	int n_rects;
+	pixman_box32_t *rects = pixman_region32_rectangles(region, &n_rects);
+	for (int i = 0; i < n_rects; ++i) {
+		struct wlr_box box = {
+			.x = rects[i].x1,
+			.y = rects[i].y1,
+			.width = rects[i].x2 - rects[i].x1,
+			.height = rects[i].y2 - rects[i].y1,
+		};
+		wlr_render_rect(renderer, &box, color,
+			output_damage->output->transform_matrix);
+	}
+}
+
+// Drawn from the precommit handler: the compositor has finished its own
+// rendering, but the buffer hasn't been handed to the backend yet
+static void output_damage_render_overlay(
+		struct wlr_output_damage *output_damage) {
+	struct wlr_output *output = output_damage->output;
+	struct wlr_renderer *renderer = wlr_backend_get_renderer(output->backend);
+	if (renderer == NULL) {
+		return;
+	}
+
+	wlr_renderer_begin(renderer, output->width, output->height);
+
+	// Previous frames first, oldest and most faded at the bottom, so newer
+	// damage reads stronger where regions overlap (premultiplied yellow)
+	for (size_t age = output_damage->previous_len; age > 0; --age) {
+		size_t idx = (output_damage->previous_idx + age - 1) %
+			output_damage->previous_len;
+		float alpha = 0.2f * (output_damage->previous_len - (age - 1)) /
+			(output_damage->previous_len + 1);
+		float color[4] = {alpha, alpha, 0.0f, alpha};
+		output_damage_overlay_region(output_damage, renderer,
+			&output_damage->previous[idx], color);
+	}
+
+	// Premultiplied red for the frame being submitted
+	float color[4] = {0.25f, 0.0f, 0.0f, 0.25f};
+	output_damage_overlay_region(output_damage, renderer,
+		&output_damage->current, color);
+
+	wlr_renderer_end(renderer);
+}
+
 static void output_handle_precommit(struct wl_listener *listener, void *data) {
 	struct wlr_output_damage *output_damage =
 		wl_container_of(listener, output_damage, output_precommit);
@@ -53,9 +108,19 @@ static void output_handle_precommit(struct wl_listener *listener, void *data) {
 		// TODO: find a better way to access this info without a precommit
 		// handler
 		output_damage->pending_buffer_type = output->pending.buffer_type;
+
+		if (output_damage->debug_overlay && output->pending.buffer_type ==
+				WLR_OUTPUT_STATE_BUFFER_RENDER) {
+			output_damage_render_overlay(output_damage);
+		}
 	}
 }
 
+// Folds damage accumulated by the add functions into the pixman region in
+// `current`, clipped to the output
+static void output_damage_flush_pending(
+		struct wlr_output_damage *output_damage);
+
 static void output_handle_commit(struct wl_listener *listener, void *data) {
 	struct wlr_output_damage *output_damage =
 		wl_container_of(listener, output_damage, output_commit);
@@ -69,14 +134,16 @@ static void output_handle_commit(struct wl_listener *listener, void *data) {
 		return;
 	}
 
+	output_damage_flush_pending(output_damage);
+
 	pixman_region32_t *prev;
 	switch (output_damage->pending_buffer_type) {
 	case WLR_OUTPUT_STATE_BUFFER_RENDER:
 		// render-buffers have been swapped, rotate the damage
 
 		// same as decrementing, but works on unsigned integers
-		output_damage->previous_idx += WLR_OUTPUT_DAMAGE_PREVIOUS_LEN - 1;
-		output_damage->previous_idx %= WLR_OUTPUT_DAMAGE_PREVIOUS_LEN;
+		output_damage->previous_idx += output_damage->previous_len - 1;
+		output_damage->previous_idx %= output_damage->previous_len;
 
 		prev = &output_damage->previous[output_damage->previous_idx];
 		pixman_region32_copy(prev, &output_damage->current);
@@ -100,11 +167,24 @@ struct wlr_output_damage *wlr_output_damage_create(struct wlr_output *output) {
 
 	output_damage->output = output;
 	output_damage->max_rects = 20;
+
+	const char *overlay = getenv("WLR_DEBUG_DAMAGE_OVERLAY");
+	output_damage->debug_overlay = overlay != NULL && strcmp(overlay, "1") == 0;
 	wl_signal_init(&output_damage->events.frame);
 	wl_signal_init(&output_damage->events.destroy);
 
+	wl_list_init(&output_damage->mirrors);
+	wl_list_init(&output_damage->mirror_link);
+
 	pixman_region32_init(&output_damage->current);
-	for (size_t i = 0; i < WLR_OUTPUT_DAMAGE_PREVIOUS_LEN; ++i) {
+	output_damage->previous_len = WLR_OUTPUT_DAMAGE_PREVIOUS_LEN;
+	output_damage->previous = calloc(output_damage->previous_len,
+		sizeof(output_damage->previous[0]));
+	if (output_damage->previous == NULL) {
+		free(output_damage);
+		return NULL;
+	}
+	for (size_t i = 0; i < output_damage->previous_len; ++i) {
 		pixman_region32_init(&output_damage->previous[i]);
 	}
 
@@ -131,6 +211,15 @@ void wlr_output_damage_destroy(struct wlr_output_damage *output_damage) {
 		return;
 	}
 	wlr_signal_emit_safe(&output_damage->events.destroy, output_damage);
+
+	struct wlr_output_damage *mirror, *tmp;
+	wl_list_for_each_safe(mirror, tmp, &output_damage->mirrors, mirror_link) {
+		mirror->mirror_source = NULL;
+		wl_list_remove(&mirror->mirror_link);
+		wl_list_init(&mirror->mirror_link);
+	}
+	wl_list_remove(&output_damage->mirror_link);
+
 	wl_list_remove(&output_damage->output_destroy.link);
 	wl_list_remove(&output_damage->output_mode.link);
 	wl_list_remove(&output_damage->output_needs_frame.link);
@@ -139,12 +228,136 @@ void wlr_output_damage_destroy(struct wlr_output_damage *output_damage) {
 	wl_list_remove(&output_damage->output_precommit.link);
 	wl_list_remove(&output_damage->output_commit.link);
 	pixman_region32_fini(&output_damage->current);
-	for (size_t i = 0; i < WLR_OUTPUT_DAMAGE_PREVIOUS_LEN; ++i) {
+	for (size_t i = 0; i < output_damage->previous_len; ++i) {
 		pixman_region32_fini(&output_damage->previous[i]);
 	}
+	free(output_damage->previous);
 	free(output_damage);
 }
 
+// Upper bound for the previous-damage history: buffer ages beyond this are
+// more likely a misbehaving backend than a real swapchain depth
+#define OUTPUT_DAMAGE_PREVIOUS_MAX_LEN 8
+
+static void output_damage_grow_previous(struct wlr_output_damage *output_damage,
+		size_t new_len) {
+	pixman_region32_t *previous = calloc(new_len, sizeof(previous[0]));
+	if (previous == NULL) {
+		return;
+	}
+
+	int width, height;
+	wlr_output_transformed_resolution(output_damage->output, &width, &height);
+
+	// Keep the recorded damage, oldest first; the real damage of the new
+	// slots is unknown, so conservatively mark them as fully damaged
+	for (size_t i = 0; i < new_len; ++i) {
+		pixman_region32_init(&previous[i]);
+		if (i < output_damage->previous_len) {
+			pixman_region32_copy(&previous[i], &output_damage->previous[
+				(output_damage->previous_idx + i) %
+				output_damage->previous_len]);
+		} else {
+			pixman_region32_union_rect(&previous[i], &previous[i],
+				0, 0, width, height);
+		}
+	}
+
+	for (size_t i = 0; i < output_damage->previous_len; ++i) {
+		pixman_region32_fini(&output_damage->previous[i]);
+	}
+	free(output_damage->previous);
+
+	output_damage->previous = previous;
+	output_damage->previous_len = new_len;
+	output_damage->previous_idx = 0;
+}
+
+// Approximate fixed cost of scissoring and drawing one rectangle, expressed
+// in pixels: weighs repainting a few large boxes against many small ones
+#define OUTPUT_DAMAGE_RECT_COST 1024
+
+static uint64_t boxes_cost(const pixman_box32_t *boxes, int n_boxes) {
+	uint64_t cost = 0;
+	for (int i = 0; i < n_boxes; ++i) {
+		cost += (uint64_t)(boxes[i].x2 - boxes[i].x1) *
+			(boxes[i].y2 - boxes[i].y1) + OUTPUT_DAMAGE_RECT_COST;
+	}
+	return cost;
+}
+
+/**
+ * When the region exceeds the rectangle budget, collapse it toward its
+ * bounding boxes — but only when the merged repaint is actually estimated to
+ * be cheaper than the precise one.
+ */
+static void output_damage_simplify(pixman_region32_t *region, int max_rects) {
+	int n_rects;
+	pixman_box32_t *rects = pixman_region32_rectangles(region, &n_rects);
+	if (n_rects <= max_rects) {
+		return;
+	}
+
+	uint64_t precise_cost = boxes_cost(rects, n_rects);
+
+	// Merge all rectangles sharing a horizontal band into their bounding
+	// box: grids of small updates collapse into a few wide boxes. Rects in
+	// a pixman region are y-banded and sorted, so equal bands are adjacent.
+	int n_bands = 0;
+	uint64_t banded_cost = UINT64_MAX;
+	pixman_box32_t *bands = malloc(n_rects * sizeof(pixman_box32_t));
+	if (bands != NULL) {
+		for (int i = 0; i < n_rects; ++i) {
+			if (n_bands > 0 && bands[n_bands - 1].y1 == rects[i].y1 &&
+					bands[n_bands - 1].y2 == rects[i].y2) {
+				if (rects[i].x1 < bands[n_bands - 1].x1) {
+					bands[n_bands - 1].x1 = rects[i].x1;
+				}
+				if (rects[i].x2 > bands[n_bands - 1].x2) {
+					bands[n_bands - 1].x2 = rects[i].x2;
+				}
+			} else {
+				bands[n_bands++] = rects[i];
+			}
+		}
+		banded_cost = boxes_cost(bands, n_bands);
+	}
+
+	pixman_box32_t extents = *pixman_region32_extents(region);
+	uint64_t extents_cost = boxes_cost(&extents, 1);
+
+	if (bands != NULL && n_bands <= max_rects &&
+			banded_cost < precise_cost && banded_cost <= extents_cost) {
+		pixman_region32_fini(region);
+		pixman_region32_init_rects(region, bands, n_bands);
+	} else if (extents_cost < precise_cost) {
+		pixman_region32_fini(region);
+		pixman_region32_init_rect(region, extents.x1, extents.y1,
+			extents.x2 - extents.x1, extents.y2 - extents.y1);
+	}
+	// Otherwise the precise region, although over budget, is the cheapest
+	// to repaint: keep it
+
+	free(bands);
+}
+
+static void output_damage_flush_pending(
+		struct wlr_output_damage *output_damage) {
+	if (wlr_damage_rects_empty(&output_damage->pending)) {
+		return;
+	}
+
+	int width, height;
+	wlr_output_transformed_resolution(output_damage->output, &width, &height);
+
+	wlr_damage_rects_union_into(&output_damage->pending,
+		&output_damage->current);
+	wlr_damage_rects_clear(&output_damage->pending);
+	pixman_region32_intersect_rect(&output_damage->current,
+		&output_damage->current, 0, 0, width, height);
+	output_damage_simplify(&output_damage->current, output_damage->max_rects);
+}
+
 bool wlr_output_damage_attach_render(struct wlr_output_damage *output_damage,
 		bool *needs_frame, pixman_region32_t *damage) {
 	struct wlr_output *output = output_damage->output;
@@ -154,10 +367,19 @@ bool wlr_output_damage_attach_render(struct wlr_output_damage *output_damage,
 		return false;
 	}
 
+	output_damage_flush_pending(output_damage);
+
 	*needs_frame =
 		output->needs_frame || pixman_region32_not_empty(&output_damage->current);
 	// Check if we can use damage tracking
-	if (buffer_age <= 0 || buffer_age - 1 > WLR_OUTPUT_DAMAGE_PREVIOUS_LEN) {
+	if (buffer_age <= 0 || (size_t)(buffer_age - 1) > output_damage->previous_len) {
+		// The swapchain is deeper than our history: grow it so this buffer
+		// age can be resolved next time around instead of repainting forever
+		if (buffer_age > 0 &&
+				(size_t)(buffer_age - 1) <= OUTPUT_DAMAGE_PREVIOUS_MAX_LEN) {
+			output_damage_grow_previous(output_damage, buffer_age - 1);
+		}
+
 		int width, height;
 		wlr_output_transformed_resolution(output, &width, &height);
 
@@ -170,52 +392,132 @@ bool wlr_output_damage_attach_render(struct wlr_output_damage *output_damage,
 		// Accumulate damage from old buffers
 		size_t idx = output_damage->previous_idx;
 		for (int i = 0; i < buffer_age - 1; ++i) {
-			int j = (idx + i) % WLR_OUTPUT_DAMAGE_PREVIOUS_LEN;
+			size_t j = (idx + i) % output_damage->previous_len;
 			pixman_region32_union(damage, damage, &output_damage->previous[j]);
 		}
 
-		// Check the number of rectangles
-		int n_rects = pixman_region32_n_rects(damage);
-		if (n_rects > output_damage->max_rects) {
-			pixman_box32_t *extents = pixman_region32_extents(damage);
-			pixman_region32_union_rect(damage, damage, extents->x1, extents->y1,
-				extents->x2 - extents->x1, extents->y2 - extents->y1);
-		}
+		// Keep the number of rectangles in check
+		output_damage_simplify(damage, output_damage->max_rects);
+	}
+
+	if (output_damage->debug_overlay) {
+		// Repaint everything so the previous frame's overlay tints don't
+		// linger; the recorded damage used for the tints stays untouched
+		int width, height;
+		wlr_output_transformed_resolution(output, &width, &height);
+		pixman_region32_union_rect(damage, damage, 0, 0, width, height);
+		*needs_frame = true;
 	}
 
 	return true;
 }
 
-void wlr_output_damage_add(struct wlr_output_damage *output_damage,
+// Forward damage to every tracker mirroring this one, scaled into the
+// mirror's resolution where it differs. Recursion through the public add
+// functions lets chains of mirrors work; cycles are rejected at link time.
+static void output_damage_forward_region(struct wlr_output_damage *source,
 		pixman_region32_t *damage) {
-	int width, height;
-	wlr_output_transformed_resolution(output_damage->output, &width, &height);
+	struct wlr_output_damage *mirror;
+	wl_list_for_each(mirror, &source->mirrors, mirror_link) {
+		int sw, sh, mw, mh;
+		wlr_output_transformed_resolution(source->output, &sw, &sh);
+		wlr_output_transformed_resolution(mirror->output, &mw, &mh);
+
+		if (sw == mw && sh == mh) {
+			wlr_output_damage_add(mirror, damage);
+		} else if (sw > 0 && sh > 0) {
+			// wlr_region_scale rounds outwards, so the scaled damage
+			// covers at least the source's
+			pixman_region32_t scaled;
+			pixman_region32_init(&scaled);
+			wlr_region_scale_xy(&scaled, damage,
+				(float)mw / sw, (float)mh / sh);
+			wlr_output_damage_add(mirror, &scaled);
+			pixman_region32_fini(&scaled);
+		}
+	}
+}
 
-	pixman_region32_union(&output_damage->current, &output_damage->current,
-		damage);
-	pixman_region32_intersect_rect(&output_damage->current,
-		&output_damage->current, 0, 0, width, height);
+void wlr_output_damage_add(struct wlr_output_damage *output_damage,
+		pixman_region32_t *damage) {
+	// The rectangle set bounds its own size, so pathological clients can't
+	// make the accumulated damage arbitrarily expensive; clipping to the
+	// output happens when the set is flushed
+	wlr_damage_rects_add_region(&output_damage->pending, damage);
 	wlr_output_schedule_frame(output_damage->output);
+
+	output_damage_forward_region(output_damage, damage);
 }
 
 void wlr_output_damage_add_whole(struct wlr_output_damage *output_damage) {
 	int width, height;
 	wlr_output_transformed_resolution(output_damage->output, &width, &height);
 
-	pixman_region32_union_rect(&output_damage->current, &output_damage->current,
-		0, 0, width, height);
+	// The full-output rectangle absorbs everything else in the set
+	wlr_damage_rects_add(&output_damage->pending, 0, 0, width, height);
 
 	wlr_output_schedule_frame(output_damage->output);
+
+	struct wlr_output_damage *mirror;
+	wl_list_for_each(mirror, &output_damage->mirrors, mirror_link) {
+		wlr_output_damage_add_whole(mirror);
+	}
 }
 
 void wlr_output_damage_add_box(struct wlr_output_damage *output_damage,
 		struct wlr_box *box) {
-	int width, height;
-	wlr_output_transformed_resolution(output_damage->output, &width, &height);
-
-	pixman_region32_union_rect(&output_damage->current, &output_damage->current,
-		box->x, box->y, box->width, box->height);
-	pixman_region32_intersect_rect(&output_damage->current,
-		&output_damage->current, 0, 0, width, height);
+	wlr_damage_rects_add(&output_damage->pending, box->x, box->y,
+		box->x + box->width, box->y + box->height);
 	wlr_output_schedule_frame(output_damage->output);
+
+	if (!wl_list_empty(&output_damage->mirrors)) {
+		pixman_region32_t region;
+		pixman_region32_init_rect(&region, box->x, box->y,
+			box->width, box->height);
+		output_damage_forward_region(output_damage, &region);
+		pixman_region32_fini(&region);
+	}
+}
+
+void wlr_output_damage_set_debug_overlay(
+		struct wlr_output_damage *output_damage, bool enabled) {
+	if (output_damage->debug_overlay == enabled) {
+		return;
+	}
+	output_damage->debug_overlay = enabled;
+	// Repaint to draw the first overlay, or to clear the last one
+	wlr_output_damage_add_whole(output_damage);
+}
+
+bool wlr_output_damage_set_mirror(struct wlr_output_damage *output_damage,
+		struct wlr_output_damage *source) {
+	if (output_damage->mirror_source == source) {
+		return true;
+	}
+
+	// Refuse loops: forwarding through one would never terminate
+	for (struct wlr_output_damage *it = source; it != NULL;
+			it = it->mirror_source) {
+		if (it == output_damage) {
+			return false;
+		}
+	}
+
+	if (output_damage->mirror_source != NULL) {
+		wl_list_remove(&output_damage->mirror_link);
+		wl_list_init(&output_damage->mirror_link);
+		output_damage->mirror_source = NULL;
+	}
+
+	if (source == NULL) {
+		return true;
+	}
+
+	output_damage->mirror_source = source;
+	wl_list_insert(&source->mirrors, &output_damage->mirror_link);
+
+	// Start from a clean slate; after this the mirror only repaints what
+	// the source damages
+	wlr_output_damage_add_whole(output_damage);
+	return true;
 }
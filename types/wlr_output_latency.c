@@ -0,0 +1,289 @@
+#define _POSIX_C_SOURCE 200809L
+#include <assert.h>
+#include <stdlib.h>
+#include <time.h>
+#include <wlr/types/wlr_output_latency.h>
+#include <wlr/util/log.h>
+#include "util/signal.h"
+#include "util/time.h"
+
+// Regression detection compares two exponential moving averages of the
+// input-to-present latency: a fast one tracking the last few dozen frames
+// and a slow one acting as the long-term baseline.
+#define RECENT_ALPHA 0.2
+#define BASELINE_ALPHA 0.01
+// Don't alert before the baseline has settled
+#define WARMUP_SAMPLES 64
+// Alert when recent exceeds baseline by half again and at least 1ms; re-arm
+// once it's back within a quarter, so a noisy boundary doesn't flap
+#define REGRESSION_RATIO 1.5
+#define REARM_RATIO 1.25
+#define REGRESSION_MIN_NSEC 1000000
+
+static int64_t timespec_sub_nsec(const struct timespec *a,
+		const struct timespec *b) {
+	struct timespec diff;
+	timespec_sub(&diff, a, b);
+	return (int64_t)diff.tv_sec * 1000000000 + diff.tv_nsec;
+}
+
+static void histogram_add(struct wlr_output_latency_histogram *histogram,
+		uint64_t nsec) {
+	size_t i = 0;
+	uint64_t bound = WLR_OUTPUT_LATENCY_BUCKET_MIN_NSEC;
+	while (nsec >= bound && i < WLR_OUTPUT_LATENCY_BUCKETS - 1) {
+		bound <<= 1;
+		++i;
+	}
+	++histogram->buckets[i];
+	++histogram->samples;
+	histogram->total_nsec += nsec;
+	if (nsec > histogram->max_nsec) {
+		histogram->max_nsec = nsec;
+	}
+}
+
+static void latency_check_regression(struct wlr_output_latency *latency) {
+	if (latency->avg_samples < WARMUP_SAMPLES) {
+		return;
+	}
+
+	if (latency->regressed) {
+		if (latency->recent_avg <= latency->baseline_avg * REARM_RATIO) {
+			latency->regressed = false;
+		}
+		return;
+	}
+
+	if (latency->recent_avg > latency->baseline_avg * REGRESSION_RATIO &&
+			latency->recent_avg - latency->baseline_avg >
+			REGRESSION_MIN_NSEC) {
+		latency->regressed = true;
+		struct wlr_output_latency_event_regression event = {
+			.latency = latency,
+			.recent_avg_nsec = (uint64_t)latency->recent_avg,
+			.baseline_avg_nsec = (uint64_t)latency->baseline_avg,
+		};
+		wlr_signal_emit_safe(&latency->events.regression, &event);
+	}
+}
+
+// A frame missed its deadline when two back-to-back commits are presented
+// more than one and a half refresh periods apart
+static void latency_check_jank(struct wlr_output_latency *latency,
+		struct wlr_output_event_present *event,
+		const struct timespec *commit_time, int64_t commit_to_present) {
+	bool adjacent = latency->has_last_present &&
+		event->commit_seq == latency->last_present_commit_seq + 1;
+	struct timespec prev = latency->last_present;
+
+	latency->last_present = *event->when;
+	latency->last_present_commit_seq = event->commit_seq;
+	latency->has_last_present = true;
+
+	if (!adjacent) {
+		// An idle compositor isn't janky, just idle
+		return;
+	}
+
+	uint64_t refresh_nsec = 0;
+	if (event->refresh > 0) {
+		refresh_nsec = event->refresh;
+	} else if (latency->output->refresh > 0) {
+		// mHz to nsec
+		refresh_nsec = 1000000000000ULL / latency->output->refresh;
+	}
+	if (refresh_nsec == 0) {
+		return;
+	}
+
+	int64_t interval = timespec_sub_nsec(event->when, &prev);
+	if (interval < 0 || (uint64_t)interval <= refresh_nsec * 3 / 2) {
+		return;
+	}
+
+	struct wlr_output_latency_event_jank jank = {
+		.latency = latency,
+		.missed_frames = (interval + refresh_nsec / 2) / refresh_nsec - 1,
+		.commit_time = *commit_time,
+		.present_time = *event->when,
+		.interval_nsec = interval,
+		.refresh_nsec = refresh_nsec,
+	};
+	if (jank.missed_frames == 0) {
+		jank.missed_frames = 1;
+	}
+	// A presentation following its commit within the normal pipeline depth
+	// means the commit itself came late; a timely commit that still slipped
+	// points at the flip path below us
+	if ((uint64_t)commit_to_present <= refresh_nsec * 3 / 2) {
+		jank.jank_class = WLR_OUTPUT_LATENCY_JANK_RENDER_LATE;
+	} else {
+		jank.jank_class = WLR_OUTPUT_LATENCY_JANK_FLIP_LATE;
+	}
+	wlr_signal_emit_safe(&latency->events.jank, &jank);
+}
+
+static void latency_handle_output_commit(struct wl_listener *listener,
+		void *data) {
+	struct wlr_output_latency *latency =
+		wl_container_of(listener, latency, output_commit);
+	struct wlr_output_event_commit *event = data;
+
+	if (!(event->committed & WLR_OUTPUT_STATE_BUFFER)) {
+		return;
+	}
+
+	// Claim a slot for this frame; with more frames in flight than slots
+	// the oldest one is simply dropped, losing a sample, not correctness
+	size_t slots = sizeof(latency->pending) / sizeof(latency->pending[0]);
+	size_t idx = latency->output->commit_seq % slots;
+	latency->pending[idx].commit_seq = latency->output->commit_seq;
+	latency->pending[idx].commit_time = *event->when;
+	latency->pending[idx].input_time = latency->input_time;
+	latency->pending[idx].has_input = latency->has_input;
+	latency->pending[idx].valid = true;
+
+	// The next frame measures from the next input event
+	latency->has_input = false;
+}
+
+static void latency_handle_output_present(struct wl_listener *listener,
+		void *data) {
+	struct wlr_output_latency *latency =
+		wl_container_of(listener, latency, output_present);
+	struct wlr_output_event_present *event = data;
+
+	size_t slots = sizeof(latency->pending) / sizeof(latency->pending[0]);
+	size_t idx = event->commit_seq % slots;
+	if (!latency->pending[idx].valid ||
+			latency->pending[idx].commit_seq != event->commit_seq) {
+		return;
+	}
+	latency->pending[idx].valid = false;
+
+	int64_t commit_to_present =
+		timespec_sub_nsec(event->when, &latency->pending[idx].commit_time);
+	if (commit_to_present < 0) {
+		// Mismatched clocks (e.g. a backend reporting hardware timestamps
+		// from a different clock domain); drop the sample
+		return;
+	}
+	histogram_add(&latency->histograms[WLR_OUTPUT_LATENCY_COMMIT_TO_PRESENT],
+		commit_to_present);
+
+	latency_check_jank(latency, event, &latency->pending[idx].commit_time,
+		commit_to_present);
+
+	if (!latency->pending[idx].has_input) {
+		return;
+	}
+
+	int64_t input_to_commit = timespec_sub_nsec(
+		&latency->pending[idx].commit_time, &latency->pending[idx].input_time);
+	int64_t input_to_present =
+		timespec_sub_nsec(event->when, &latency->pending[idx].input_time);
+	if (input_to_commit < 0 || input_to_present < 0) {
+		return;
+	}
+	histogram_add(&latency->histograms[WLR_OUTPUT_LATENCY_INPUT_TO_COMMIT],
+		input_to_commit);
+	histogram_add(&latency->histograms[WLR_OUTPUT_LATENCY_INPUT_TO_PRESENT],
+		input_to_present);
+
+	if (latency->avg_samples == 0) {
+		latency->recent_avg = input_to_present;
+		latency->baseline_avg = input_to_present;
+	} else {
+		latency->recent_avg += RECENT_ALPHA *
+			(input_to_present - latency->recent_avg);
+		latency->baseline_avg += BASELINE_ALPHA *
+			(input_to_present - latency->baseline_avg);
+	}
+	++latency->avg_samples;
+
+	latency_check_regression(latency);
+}
+
+static void latency_handle_output_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_output_latency *latency =
+		wl_container_of(listener, latency, output_destroy);
+	wlr_output_latency_destroy(latency);
+}
+
+struct wlr_output_latency *wlr_output_latency_create(
+		struct wlr_output *output) {
+	struct wlr_output_latency *latency =
+		calloc(1, sizeof(struct wlr_output_latency));
+	if (latency == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	latency->output = output;
+
+	wl_signal_init(&latency->events.regression);
+	wl_signal_init(&latency->events.jank);
+	wl_signal_init(&latency->events.destroy);
+
+	wl_signal_add(&output->events.commit, &latency->output_commit);
+	latency->output_commit.notify = latency_handle_output_commit;
+
+	wl_signal_add(&output->events.present, &latency->output_present);
+	latency->output_present.notify = latency_handle_output_present;
+
+	wl_signal_add(&output->events.destroy, &latency->output_destroy);
+	latency->output_destroy.notify = latency_handle_output_destroy;
+
+	return latency;
+}
+
+void wlr_output_latency_destroy(struct wlr_output_latency *latency) {
+	if (latency == NULL) {
+		return;
+	}
+	wlr_signal_emit_safe(&latency->events.destroy, latency);
+	wl_list_remove(&latency->output_commit.link);
+	wl_list_remove(&latency->output_present.link);
+	wl_list_remove(&latency->output_destroy.link);
+	free(latency);
+}
+
+void wlr_output_latency_mark_input(struct wlr_output_latency *latency,
+		const struct timespec *when) {
+	struct timespec now;
+	if (when == NULL) {
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		when = &now;
+	}
+	// The earliest un-presented input event wins
+	if (latency->has_input) {
+		return;
+	}
+	latency->input_time = *when;
+	latency->has_input = true;
+}
+
+const struct wlr_output_latency_histogram *wlr_output_latency_get_histogram(
+		struct wlr_output_latency *latency,
+		enum wlr_output_latency_stage stage) {
+	assert(stage < WLR_OUTPUT_LATENCY_STAGE_COUNT);
+	return &latency->histograms[stage];
+}
+
+void wlr_output_latency_reset(struct wlr_output_latency *latency) {
+	for (size_t i = 0; i < WLR_OUTPUT_LATENCY_STAGE_COUNT; ++i) {
+		struct wlr_output_latency_histogram *histogram =
+			&latency->histograms[i];
+		for (size_t j = 0; j < WLR_OUTPUT_LATENCY_BUCKETS; ++j) {
+			histogram->buckets[j] = 0;
+		}
+		histogram->samples = 0;
+		histogram->total_nsec = 0;
+		histogram->max_nsec = 0;
+	}
+	latency->recent_avg = 0;
+	latency->baseline_avg = 0;
+	latency->avg_samples = 0;
+	latency->regressed = false;
+}
@@ -8,8 +8,20 @@
 #include <wlr/util/log.h>
 #include "util/signal.h"
 
+struct wlr_output_layout_index_entry {
+	struct wlr_output_layout_output *l_output;
+	struct wlr_box box;
+	int max_x2; // max box.x + box.width over this and all previous entries
+};
+
 struct wlr_output_layout_state {
 	struct wlr_box _box; // should never be read directly, use the getter
+
+	/* Point-query index: the output boxes sorted by their left edge,
+	 * rebuilt whenever the layout changes. NULL when allocation failed, in
+	 * which case queries fall back to scanning the output list. */
+	struct wlr_output_layout_index_entry *index;
+	size_t index_len;
 };
 
 struct wlr_output_layout_output_state {
@@ -68,6 +80,7 @@ void wlr_output_layout_destroy(struct wlr_output_layout *layout) {
 		output_layout_output_destroy(l_output);
 	}
 
+	free(layout->state->index);
 	free(layout->state);
 	free(layout);
 }
@@ -83,6 +96,86 @@ static struct wlr_box *output_layout_output_get_box(
 	return &l_output->state->_box;
 }
 
+static int index_entry_compare(const void *ptr_a, const void *ptr_b) {
+	const struct wlr_output_layout_index_entry *a = ptr_a, *b = ptr_b;
+	if (a->box.x != b->box.x) {
+		return a->box.x < b->box.x ? -1 : 1;
+	}
+	if (a->box.y != b->box.y) {
+		return a->box.y < b->box.y ? -1 : 1;
+	}
+	return 0;
+}
+
+static void output_layout_rebuild_index(struct wlr_output_layout *layout) {
+	struct wlr_output_layout_state *state = layout->state;
+
+	free(state->index);
+	state->index = NULL;
+	state->index_len = 0;
+
+	size_t len = wl_list_length(&layout->outputs);
+	if (len == 0) {
+		return;
+	}
+
+	struct wlr_output_layout_index_entry *index =
+		calloc(len, sizeof(struct wlr_output_layout_index_entry));
+	if (index == NULL) {
+		return; // queries fall back to scanning the output list
+	}
+
+	size_t i = 0;
+	struct wlr_output_layout_output *l_output;
+	wl_list_for_each(l_output, &layout->outputs, link) {
+		index[i].l_output = l_output;
+		index[i].box = *output_layout_output_get_box(l_output);
+		++i;
+	}
+
+	qsort(index, len, sizeof(index[0]), index_entry_compare);
+
+	int max_x2 = INT_MIN;
+	for (i = 0; i < len; ++i) {
+		if (index[i].box.x + index[i].box.width > max_x2) {
+			max_x2 = index[i].box.x + index[i].box.width;
+		}
+		index[i].max_x2 = max_x2;
+	}
+
+	state->index = index;
+	state->index_len = len;
+}
+
+/**
+ * Find the output whose box contains the given point, in O(log n): binary
+ * search for the rightmost box starting left of the point, then walk towards
+ * the left edge of the layout only as long as a box could still reach the
+ * point (the prefix maximum of the right edges bounds the reach).
+ */
+static struct wlr_output_layout_output *output_layout_index_at(
+		struct wlr_output_layout *layout, double lx, double ly) {
+	struct wlr_output_layout_state *state = layout->state;
+
+	// `low` becomes the number of boxes starting left of (or at) the point
+	size_t low = 0, high = state->index_len;
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if ((double)state->index[mid].box.x <= lx) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	for (size_t i = low; i > 0 && (double)state->index[i - 1].max_x2 > lx; --i) {
+		if (wlr_box_contains_point(&state->index[i - 1].box, lx, ly)) {
+			return state->index[i - 1].l_output;
+		}
+	}
+	return NULL;
+}
+
 /**
  * This must be called whenever the layout changes to reconfigure the auto
  * configured outputs and emit the `changed` event.
@@ -125,6 +218,8 @@ static void output_layout_reconfigure(struct wlr_output_layout *layout) {
 		max_x += box->width;
 	}
 
+	output_layout_rebuild_index(layout);
+
 	wlr_signal_emit_safe(&layout->events.change, layout);
 }
 
@@ -265,6 +360,12 @@ bool wlr_output_layout_intersects(struct wlr_output_layout *layout,
 
 struct wlr_output *wlr_output_layout_output_at(struct wlr_output_layout *layout,
 		double lx, double ly) {
+	if (layout->state->index != NULL) {
+		struct wlr_output_layout_output *l_output =
+			output_layout_index_at(layout, lx, ly);
+		return l_output != NULL ? l_output->output : NULL;
+	}
+
 	struct wlr_output_layout_output *l_output;
 	wl_list_for_each(l_output, &layout->outputs, link) {
 		struct wlr_box *box = output_layout_output_get_box(l_output);
@@ -322,6 +423,19 @@ void wlr_output_layout_closest_point(struct wlr_output_layout *layout,
 		return;
 	}
 
+	// The common case for cursor motion: the point already lies on an
+	// output, so it is its own closest point
+	if (reference == NULL && layout->state->index != NULL && isfinite(lx) &&
+			isfinite(ly) && output_layout_index_at(layout, lx, ly) != NULL) {
+		if (dest_lx) {
+			*dest_lx = lx;
+		}
+		if (dest_ly) {
+			*dest_ly = ly;
+		}
+		return;
+	}
+
 	double min_x = 0, min_y = 0, min_distance = DBL_MAX;
 	struct wlr_output_layout_output *l_output;
 	wl_list_for_each(l_output, &layout->outputs, link) {
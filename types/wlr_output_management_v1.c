@@ -777,10 +777,13 @@ static void manager_send_head(struct wlr_output_manager_v1 *manager,
 		zwlr_output_head_v1_send_serial_number(head_resource, output->serial);
 	}
 
+	size_t n_modes = 0;
 	struct wlr_output_mode *mode;
 	wl_list_for_each(mode, &output->modes, link) {
 		head_send_mode(head, head_resource, mode);
+		++n_modes;
 	}
+	head->n_modes = n_modes;
 
 	if (wl_list_empty(&output->modes)) {
 		// Output doesn't support modes. Send a virtual one.
@@ -819,24 +822,32 @@ static bool manager_update_head(struct wlr_output_manager_v1 *manager,
 		state |= HEAD_STATE_SCALE;
 	}
 
-	// If  a mode was added to wlr_output.modes we need to add the new mode
-	// to the wlr_output_head
+	// If a mode was added to wlr_output.modes we need to add the new mode
+	// to the wlr_output_head. Comparing the mode count is enough to detect
+	// this: an output's modes are only ever appended.
+	size_t n_modes = 0;
 	struct wlr_output_mode *mode;
 	wl_list_for_each(mode, &head->state.output->modes, link) {
-		bool found = false;
-		struct wl_resource *mode_resource;
-		wl_resource_for_each(mode_resource, &head->mode_resources) {
-			if (mode_from_resource(mode_resource) == mode) {
-				found = true;
-				break;
+		++n_modes;
+	}
+	if (n_modes != head->n_modes) {
+		wl_list_for_each(mode, &head->state.output->modes, link) {
+			bool found = false;
+			struct wl_resource *mode_resource;
+			wl_resource_for_each(mode_resource, &head->mode_resources) {
+				if (mode_from_resource(mode_resource) == mode) {
+					found = true;
+					break;
+				}
 			}
-		}
-		if (!found) {
-			struct wl_resource *resource;
-			wl_resource_for_each(resource, &head->resources) {
-				head_send_mode(head, resource, mode);
+			if (!found) {
+				struct wl_resource *resource;
+				wl_resource_for_each(resource, &head->resources) {
+					head_send_mode(head, resource, mode);
+				}
 			}
 		}
+		head->n_modes = n_modes;
 	}
 
 	if (state != 0) {
@@ -10,6 +10,11 @@
 
 #define PRESENTATION_VERSION 1
 
+// Upper bound for the number of recycled feedback objects: enough for a few
+// frames worth of feedback-hungry surfaces, without hoarding memory forever
+// after a usage spike
+#define FEEDBACK_POOL_MAX_LEN 64
+
 static void feedback_handle_resource_destroy(struct wl_resource *resource) {
 	wl_list_remove(wl_resource_get_link(resource));
 }
@@ -105,12 +110,21 @@ static void presentation_handle_feedback(struct wl_client *client,
 		}
 	}
 	if (!found) {
-		feedback = calloc(1, sizeof(struct wlr_presentation_feedback));
-		if (feedback == NULL) {
-			wl_client_post_no_memory(client);
-			return;
+		if (!wl_list_empty(&presentation->feedback_pool)) {
+			// Pool entries are zeroed when they are recycled
+			feedback = wl_container_of(presentation->feedback_pool.next,
+				feedback, link);
+			wl_list_remove(&feedback->link);
+			--presentation->feedback_pool_len;
+		} else {
+			feedback = calloc(1, sizeof(struct wlr_presentation_feedback));
+			if (feedback == NULL) {
+				wl_client_post_no_memory(client);
+				return;
+			}
 		}
 
+		feedback->presentation = presentation;
 		feedback->surface = surface;
 		wl_list_init(&feedback->resources);
 
@@ -166,6 +180,13 @@ static void handle_display_destroy(struct wl_listener *listener, void *data) {
 	struct wlr_presentation *presentation =
 		wl_container_of(listener, presentation, display_destroy);
 	wlr_signal_emit_safe(&presentation->events.destroy, presentation);
+
+	struct wlr_presentation_feedback *feedback, *feedback_tmp;
+	wl_list_for_each_safe(feedback, feedback_tmp,
+			&presentation->feedback_pool, link) {
+		free(feedback);
+	}
+
 	wl_list_remove(&presentation->display_destroy.link);
 	wl_global_destroy(presentation->global);
 	free(presentation);
@@ -189,6 +210,7 @@ struct wlr_presentation *wlr_presentation_create(struct wl_display *display,
 	presentation->clock = wlr_backend_get_presentation_clock(backend);
 
 	wl_list_init(&presentation->feedbacks);
+	wl_list_init(&presentation->feedback_pool);
 	wl_signal_init(&presentation->events.destroy);
 
 	presentation->display_destroy.notify = handle_display_destroy;
@@ -242,6 +264,15 @@ void wlr_presentation_feedback_destroy(
 	feedback_unset_surface(feedback);
 	feedback_unset_output(feedback);
 	wl_list_remove(&feedback->link);
+
+	struct wlr_presentation *presentation = feedback->presentation;
+	if (presentation != NULL &&
+			presentation->feedback_pool_len < FEEDBACK_POOL_MAX_LEN) {
+		memset(feedback, 0, sizeof(*feedback));
+		wl_list_insert(&presentation->feedback_pool, &feedback->link);
+		++presentation->feedback_pool_len;
+		return;
+	}
 	free(feedback);
 }
 
@@ -1,14 +1,76 @@
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wlr/types/wlr_primary_selection.h>
 #include <wlr/util/log.h>
 #include "util/signal.h"
 
+struct wlr_primary_selection_mime_snapshot *
+		wlr_primary_selection_mime_snapshot_ref(
+		struct wlr_primary_selection_mime_snapshot *snapshot) {
+	snapshot->n_refs++;
+	return snapshot;
+}
+
+void wlr_primary_selection_mime_snapshot_unref(
+		struct wlr_primary_selection_mime_snapshot *snapshot) {
+	if (snapshot == NULL) {
+		return;
+	}
+
+	assert(snapshot->n_refs > 0);
+	if (--snapshot->n_refs > 0) {
+		return;
+	}
+
+	char **p;
+	wl_array_for_each(p, &snapshot->mime_types) {
+		free(*p);
+	}
+	wl_array_release(&snapshot->mime_types);
+	free(snapshot);
+}
+
+struct wlr_primary_selection_mime_snapshot *
+		wlr_primary_selection_source_get_mime_snapshot(
+		struct wlr_primary_selection_source *source) {
+	if (source->mime_snapshot != NULL) {
+		return source->mime_snapshot;
+	}
+
+	struct wlr_primary_selection_mime_snapshot *snapshot =
+		calloc(1, sizeof(struct wlr_primary_selection_mime_snapshot));
+	if (snapshot == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	snapshot->n_refs = 1;
+	wl_array_init(&snapshot->mime_types);
+
+	char **p;
+	wl_array_for_each(p, &source->mime_types) {
+		char *mime_type = strdup(*p);
+		char **dst = mime_type != NULL ?
+			wl_array_add(&snapshot->mime_types, sizeof(*dst)) : NULL;
+		if (dst == NULL) {
+			free(mime_type);
+			wlr_primary_selection_mime_snapshot_unref(snapshot);
+			wlr_log(WLR_ERROR, "Allocation failed");
+			return NULL;
+		}
+		*dst = mime_type;
+	}
+
+	source->mime_snapshot = snapshot;
+	return snapshot;
+}
+
 void wlr_primary_selection_source_init(
 		struct wlr_primary_selection_source *source,
 		const struct wlr_primary_selection_source_impl *impl) {
 	assert(impl->send);
 	wl_array_init(&source->mime_types);
+	source->mime_snapshot = NULL;
 	wl_signal_init(&source->events.destroy);
 	source->impl = impl;
 }
@@ -26,6 +88,7 @@ void wlr_primary_selection_source_destroy(
 		free(*p);
 	}
 	wl_array_release(&source->mime_types);
+	wlr_primary_selection_mime_snapshot_unref(source->mime_snapshot);
 
 	if (source->impl->destroy) {
 		source->impl->destroy(source);
@@ -73,8 +73,15 @@ static void create_offer(struct wl_resource *device_resource,
 
 	zwp_primary_selection_device_v1_send_data_offer(device_resource, resource);
 
+	// All offers for this source share one immutable MIME snapshot, built
+	// on the first presentation
+	struct wlr_primary_selection_mime_snapshot *snapshot =
+		wlr_primary_selection_source_get_mime_snapshot(source);
+	struct wl_array *mime_types = snapshot != NULL ?
+		&snapshot->mime_types : &source->mime_types;
+
 	char **p;
-	wl_array_for_each(p, &source->mime_types) {
+	wl_array_for_each(p, mime_types) {
 		zwp_primary_selection_offer_v1_send_offer(resource, *p);
 	}
 
@@ -1,9 +1,24 @@
 #include <assert.h>
 #include <pixman.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_region.h>
+#include "util/slab.h"
+
+// wl_region objects are created and destroyed in bulk while clients build
+// their per-commit damage/opaque/input regions
+static struct wlr_slab region_slab;
+static bool region_slab_initialized = false;
+
+static struct wlr_slab *get_region_slab(void) {
+	if (!region_slab_initialized) {
+		wlr_slab_init(&region_slab, sizeof(pixman_region32_t));
+		region_slab_initialized = true;
+	}
+	return &region_slab;
+}
 
 static void region_add(struct wl_client *client, struct wl_resource *resource,
 		int32_t x, int32_t y, int32_t width, int32_t height) {
@@ -38,12 +53,12 @@ static void region_handle_resource_destroy(struct wl_resource *resource) {
 	wl_list_remove(wl_resource_get_link(resource));
 
 	pixman_region32_fini(reg);
-	free(reg);
+	wlr_slab_free(get_region_slab(), reg);
 }
 
 struct wl_resource *wlr_region_create(struct wl_client *client,
 		uint32_t version, uint32_t id, struct wl_list *resource_list) {
-	pixman_region32_t *region = calloc(1, sizeof(pixman_region32_t));
+	pixman_region32_t *region = wlr_slab_alloc(get_region_slab());
 	if (region == NULL) {
 		wl_client_post_no_memory(client);
 		return NULL;
@@ -54,7 +69,7 @@ struct wl_resource *wlr_region_create(struct wl_client *client,
 	struct wl_resource *region_resource = wl_resource_create(client,
 		&wl_region_interface, version, id);
 	if (region_resource == NULL) {
-		free(region);
+		wlr_slab_free(get_region_slab(), region);
 		wl_client_post_no_memory(client);
 		return NULL;
 	}
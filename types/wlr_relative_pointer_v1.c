@@ -167,6 +167,9 @@ static void handle_display_destroy(struct wl_listener *listener, void *data) {
 		wl_container_of(listener, manager, display_destroy_listener);
 	wlr_signal_emit_safe(&manager->events.destroy, manager);
 	wl_list_remove(&manager->display_destroy_listener.link);
+	if (manager->flush_idle != NULL) {
+		wl_event_source_remove(manager->flush_idle);
+	}
 	wl_global_destroy(manager->global);
 	free(manager);
 }
@@ -198,6 +201,7 @@ struct wlr_relative_pointer_manager_v1 *wlr_relative_pointer_manager_v1_create(s
 		return NULL;
 	}
 
+	manager->display = display;
 	wl_list_init(&manager->relative_pointers);
 
 	manager->global = wl_global_create(display,
@@ -217,6 +221,56 @@ struct wlr_relative_pointer_manager_v1 *wlr_relative_pointer_manager_v1_create(s
 	return manager;
 }
 
+static void relative_pointer_flush(struct wlr_relative_pointer_v1 *pointer) {
+	if (!pointer->pending) {
+		return;
+	}
+	pointer->pending = false;
+
+	zwp_relative_pointer_v1_send_relative_motion(pointer->resource,
+		(uint32_t)(pointer->pending_time_usec >> 32),
+		(uint32_t)pointer->pending_time_usec,
+		wl_fixed_from_double(pointer->pending_dx),
+		wl_fixed_from_double(pointer->pending_dy),
+		wl_fixed_from_double(pointer->pending_dx_unaccel),
+		wl_fixed_from_double(pointer->pending_dy_unaccel));
+
+	pointer->pending_dx = 0;
+	pointer->pending_dy = 0;
+	pointer->pending_dx_unaccel = 0;
+	pointer->pending_dy_unaccel = 0;
+}
+
+static void relative_pointer_manager_flush_idle_handler(void *data) {
+	struct wlr_relative_pointer_manager_v1 *manager = data;
+	manager->flush_idle = NULL;
+	wlr_relative_pointer_manager_v1_flush(manager);
+}
+
+void wlr_relative_pointer_manager_v1_flush(
+		struct wlr_relative_pointer_manager_v1 *manager) {
+	if (manager->flush_idle != NULL) {
+		wl_event_source_remove(manager->flush_idle);
+		manager->flush_idle = NULL;
+	}
+
+	struct wlr_relative_pointer_v1 *pointer;
+	wl_list_for_each(pointer, &manager->relative_pointers, link) {
+		relative_pointer_flush(pointer);
+	}
+}
+
+void wlr_relative_pointer_manager_v1_set_accumulation(
+		struct wlr_relative_pointer_manager_v1 *manager, bool enabled) {
+	if (manager->accumulate_motion == enabled) {
+		return;
+	}
+	manager->accumulate_motion = enabled;
+	if (!enabled) {
+		wlr_relative_pointer_manager_v1_flush(manager);
+	}
+}
+
 void wlr_relative_pointer_manager_v1_send_relative_motion(
 		struct wlr_relative_pointer_manager_v1 *manager, struct wlr_seat *seat,
 		uint64_t time_usec, double dx, double dy,
@@ -234,9 +288,28 @@ void wlr_relative_pointer_manager_v1_send_relative_motion(
 			continue;
 		}
 
+		if (manager->accumulate_motion) {
+			pointer->pending = true;
+			pointer->pending_time_usec = time_usec;
+			pointer->pending_dx += dx;
+			pointer->pending_dy += dy;
+			pointer->pending_dx_unaccel += dx_unaccel;
+			pointer->pending_dy_unaccel += dy_unaccel;
+			continue;
+		}
+
 		zwp_relative_pointer_v1_send_relative_motion(pointer->resource,
 			(uint32_t)(time_usec >> 32), (uint32_t)time_usec,
 			wl_fixed_from_double(dx), wl_fixed_from_double(dy),
 			wl_fixed_from_double(dx_unaccel), wl_fixed_from_double(dy_unaccel));
 	}
+
+	// Make sure accumulated motion goes out even if the compositor never
+	// calls wlr_relative_pointer_manager_v1_flush()
+	if (manager->accumulate_motion && manager->flush_idle == NULL) {
+		struct wl_event_loop *loop =
+			wl_display_get_event_loop(manager->display);
+		manager->flush_idle = wl_event_loop_add_idle(loop,
+			relative_pointer_manager_flush_idle_handler, manager);
+	}
 }
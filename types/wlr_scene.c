@@ -0,0 +1,791 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-server-core.h>
+#include <wlr/backend.h>
+#include <wlr/render/wlr_renderer.h>
+#include <wlr/render/wlr_texture.h>
+#include <wlr/types/wlr_box.h>
+#include <wlr/types/wlr_buffer.h>
+#include <wlr/types/wlr_matrix.h>
+#include <wlr/types/wlr_occlusion.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_output_damage.h>
+#include <wlr/types/wlr_scene.h>
+#include <wlr/types/wlr_surface.h>
+#include <wlr/util/region.h>
+#include "util/signal.h"
+
+struct wlr_scene_attached_damage {
+	struct wlr_output_damage *output_damage;
+	struct wl_list link; // wlr_scene.attached_damage
+
+	struct wl_listener output_damage_destroy;
+};
+
+static struct wlr_scene *scene_root_from_node(struct wlr_scene_node *node) {
+	while (node->parent != NULL) {
+		node = node->parent;
+	}
+	assert(node->type == WLR_SCENE_NODE_ROOT);
+	struct wlr_scene *scene = (struct wlr_scene *)node;
+	assert(&scene->node == node);
+	return scene;
+}
+
+struct wlr_scene_surface *wlr_scene_surface_from_node(
+		struct wlr_scene_node *node) {
+	assert(node->type == WLR_SCENE_NODE_SURFACE);
+	struct wlr_scene_surface *scene_surface =
+		(struct wlr_scene_surface *)node;
+	assert(&scene_surface->node == node);
+	return scene_surface;
+}
+
+static struct wlr_scene_rect *scene_rect_from_node(
+		struct wlr_scene_node *node) {
+	assert(node->type == WLR_SCENE_NODE_RECT);
+	struct wlr_scene_rect *rect = (struct wlr_scene_rect *)node;
+	assert(&rect->node == node);
+	return rect;
+}
+
+static struct wlr_scene_buffer *scene_buffer_from_node(
+		struct wlr_scene_node *node) {
+	assert(node->type == WLR_SCENE_NODE_BUFFER);
+	struct wlr_scene_buffer *scene_buffer = (struct wlr_scene_buffer *)node;
+	assert(&scene_buffer->node == node);
+	return scene_buffer;
+}
+
+static void scene_node_get_size(struct wlr_scene_node *node,
+		int *width, int *height) {
+	*width = 0;
+	*height = 0;
+
+	switch (node->type) {
+	case WLR_SCENE_NODE_ROOT:
+	case WLR_SCENE_NODE_TREE:
+		break;
+	case WLR_SCENE_NODE_SURFACE:;
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(node);
+		*width = scene_surface->surface->current.width;
+		*height = scene_surface->surface->current.height;
+		break;
+	case WLR_SCENE_NODE_RECT:;
+		struct wlr_scene_rect *rect = scene_rect_from_node(node);
+		*width = rect->width;
+		*height = rect->height;
+		break;
+	case WLR_SCENE_NODE_BUFFER:;
+		struct wlr_scene_buffer *scene_buffer = scene_buffer_from_node(node);
+		*width = scene_buffer->buffer->width;
+		*height = scene_buffer->buffer->height;
+		break;
+	}
+}
+
+static bool scene_node_enabled(struct wlr_scene_node *node) {
+	while (node != NULL) {
+		if (!node->state.enabled) {
+			return false;
+		}
+		node = node->parent;
+	}
+	return true;
+}
+
+/**
+ * Forward damage, in scene coordinates, to all of the attached outputs.
+ */
+static void scene_damage(struct wlr_scene *scene, pixman_region32_t *damage) {
+	struct wlr_scene_attached_damage *attached;
+	wl_list_for_each(attached, &scene->attached_damage, link) {
+		struct wlr_output *output = attached->output_damage->output;
+		if (output->scale == 1.0f) {
+			wlr_output_damage_add(attached->output_damage, damage);
+			continue;
+		}
+
+		pixman_region32_t scaled;
+		pixman_region32_init(&scaled);
+		wlr_region_scale(&scaled, damage, output->scale);
+		wlr_output_damage_add(attached->output_damage, &scaled);
+		pixman_region32_fini(&scaled);
+	}
+}
+
+static void scene_node_accumulate_extent(struct wlr_scene_node *node,
+		int lx, int ly, pixman_region32_t *region) {
+	if (!node->state.enabled) {
+		return;
+	}
+
+	int width, height;
+	scene_node_get_size(node, &width, &height);
+	pixman_region32_union_rect(region, region, lx, ly, width, height);
+
+	struct wlr_scene_node *child;
+	wl_list_for_each(child, &node->state.children, state.link) {
+		scene_node_accumulate_extent(child, lx + child->state.x,
+			ly + child->state.y, region);
+	}
+}
+
+/**
+ * Damage the whole area the node (and its children) currently occupies.
+ */
+static void scene_node_damage_whole(struct wlr_scene_node *node) {
+	struct wlr_scene *scene = scene_root_from_node(node);
+	if (wl_list_empty(&scene->attached_damage) || !scene_node_enabled(node)) {
+		return;
+	}
+
+	int lx, ly;
+	wlr_scene_node_coords(node, &lx, &ly);
+
+	pixman_region32_t damage;
+	pixman_region32_init(&damage);
+	scene_node_accumulate_extent(node, lx, ly, &damage);
+	scene_damage(scene, &damage);
+	pixman_region32_fini(&damage);
+}
+
+static void scene_node_init(struct wlr_scene_node *node,
+		enum wlr_scene_node_type type, struct wlr_scene_node *parent) {
+	assert(type == WLR_SCENE_NODE_ROOT || parent != NULL);
+
+	node->type = type;
+	node->parent = parent;
+	node->state.enabled = true;
+	wl_list_init(&node->state.children);
+	wl_signal_init(&node->events.destroy);
+
+	if (parent != NULL) {
+		wl_list_insert(parent->state.children.prev, &node->state.link);
+	} else {
+		wl_list_init(&node->state.link);
+	}
+}
+
+static void scene_node_finish(struct wlr_scene_node *node) {
+	wlr_signal_emit_safe(&node->events.destroy, node);
+
+	struct wlr_scene_node *child, *child_tmp;
+	wl_list_for_each_safe(child, child_tmp,
+			&node->state.children, state.link) {
+		wlr_scene_node_destroy(child);
+	}
+
+	wl_list_remove(&node->state.link);
+}
+
+static void attached_damage_destroy(
+		struct wlr_scene_attached_damage *attached) {
+	wl_list_remove(&attached->output_damage_destroy.link);
+	wl_list_remove(&attached->link);
+	free(attached);
+}
+
+void wlr_scene_node_destroy(struct wlr_scene_node *node) {
+	if (node == NULL) {
+		return;
+	}
+
+	scene_node_damage_whole(node);
+	scene_node_finish(node);
+
+	switch (node->type) {
+	case WLR_SCENE_NODE_ROOT:;
+		struct wlr_scene *scene = (struct wlr_scene *)node;
+		struct wlr_scene_attached_damage *attached, *attached_tmp;
+		wl_list_for_each_safe(attached, attached_tmp,
+				&scene->attached_damage, link) {
+			attached_damage_destroy(attached);
+		}
+		free(scene);
+		break;
+	case WLR_SCENE_NODE_TREE:;
+		struct wlr_scene_tree *tree = (struct wlr_scene_tree *)node;
+		free(tree);
+		break;
+	case WLR_SCENE_NODE_SURFACE:;
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(node);
+		wl_list_remove(&scene_surface->surface_destroy.link);
+		wl_list_remove(&scene_surface->surface_commit.link);
+		free(scene_surface);
+		break;
+	case WLR_SCENE_NODE_RECT:;
+		struct wlr_scene_rect *rect = scene_rect_from_node(node);
+		free(rect);
+		break;
+	case WLR_SCENE_NODE_BUFFER:;
+		struct wlr_scene_buffer *scene_buffer = scene_buffer_from_node(node);
+		wlr_texture_destroy(scene_buffer->texture);
+		wlr_buffer_unlock(scene_buffer->buffer);
+		free(scene_buffer);
+		break;
+	}
+}
+
+struct wlr_scene *wlr_scene_create(void) {
+	struct wlr_scene *scene = calloc(1, sizeof(struct wlr_scene));
+	if (scene == NULL) {
+		return NULL;
+	}
+	scene_node_init(&scene->node, WLR_SCENE_NODE_ROOT, NULL);
+	wl_list_init(&scene->attached_damage);
+	return scene;
+}
+
+struct wlr_scene_tree *wlr_scene_tree_create(struct wlr_scene_node *parent) {
+	struct wlr_scene_tree *tree = calloc(1, sizeof(struct wlr_scene_tree));
+	if (tree == NULL) {
+		return NULL;
+	}
+	scene_node_init(&tree->node, WLR_SCENE_NODE_TREE, parent);
+	return tree;
+}
+
+static void scene_surface_handle_surface_destroy(struct wl_listener *listener,
+		void *data) {
+	struct wlr_scene_surface *scene_surface =
+		wl_container_of(listener, scene_surface, surface_destroy);
+	wlr_scene_node_destroy(&scene_surface->node);
+}
+
+static void scene_surface_handle_surface_commit(struct wl_listener *listener,
+		void *data) {
+	struct wlr_scene_surface *scene_surface =
+		wl_container_of(listener, scene_surface, surface_commit);
+
+	struct wlr_scene *scene = scene_root_from_node(&scene_surface->node);
+	if (wl_list_empty(&scene->attached_damage) ||
+			!scene_node_enabled(&scene_surface->node)) {
+		return;
+	}
+
+	int lx, ly;
+	wlr_scene_node_coords(&scene_surface->node, &lx, &ly);
+
+	pixman_region32_t damage;
+	pixman_region32_init(&damage);
+	wlr_surface_get_effective_damage(scene_surface->surface, &damage);
+	pixman_region32_translate(&damage, lx, ly);
+	scene_damage(scene, &damage);
+	pixman_region32_fini(&damage);
+}
+
+struct wlr_scene_surface *wlr_scene_surface_create(
+		struct wlr_scene_node *parent, struct wlr_surface *surface) {
+	struct wlr_scene_surface *scene_surface =
+		calloc(1, sizeof(struct wlr_scene_surface));
+	if (scene_surface == NULL) {
+		return NULL;
+	}
+	scene_node_init(&scene_surface->node, WLR_SCENE_NODE_SURFACE, parent);
+
+	scene_surface->surface = surface;
+
+	scene_surface->surface_destroy.notify = scene_surface_handle_surface_destroy;
+	wl_signal_add(&surface->events.destroy, &scene_surface->surface_destroy);
+	scene_surface->surface_commit.notify = scene_surface_handle_surface_commit;
+	wl_signal_add(&surface->events.commit, &scene_surface->surface_commit);
+
+	scene_node_damage_whole(&scene_surface->node);
+
+	return scene_surface;
+}
+
+struct wlr_scene_rect *wlr_scene_rect_create(struct wlr_scene_node *parent,
+		int width, int height, const float color[static 4]) {
+	struct wlr_scene_rect *rect = calloc(1, sizeof(struct wlr_scene_rect));
+	if (rect == NULL) {
+		return NULL;
+	}
+	scene_node_init(&rect->node, WLR_SCENE_NODE_RECT, parent);
+
+	rect->width = width;
+	rect->height = height;
+	memcpy(rect->color, color, sizeof(rect->color));
+
+	scene_node_damage_whole(&rect->node);
+
+	return rect;
+}
+
+void wlr_scene_rect_set_size(struct wlr_scene_rect *rect, int width,
+		int height) {
+	if (rect->width == width && rect->height == height) {
+		return;
+	}
+
+	scene_node_damage_whole(&rect->node);
+	rect->width = width;
+	rect->height = height;
+	scene_node_damage_whole(&rect->node);
+}
+
+void wlr_scene_rect_set_color(struct wlr_scene_rect *rect,
+		const float color[static 4]) {
+	if (memcmp(rect->color, color, sizeof(rect->color)) == 0) {
+		return;
+	}
+
+	memcpy(rect->color, color, sizeof(rect->color));
+	scene_node_damage_whole(&rect->node);
+}
+
+struct wlr_scene_buffer *wlr_scene_buffer_create(struct wlr_scene_node *parent,
+		struct wlr_buffer *buffer) {
+	struct wlr_scene_buffer *scene_buffer =
+		calloc(1, sizeof(struct wlr_scene_buffer));
+	if (scene_buffer == NULL) {
+		return NULL;
+	}
+	scene_node_init(&scene_buffer->node, WLR_SCENE_NODE_BUFFER, parent);
+
+	scene_buffer->buffer = wlr_buffer_lock(buffer);
+
+	scene_node_damage_whole(&scene_buffer->node);
+
+	return scene_buffer;
+}
+
+static struct wlr_texture *scene_buffer_get_texture(
+		struct wlr_scene_buffer *scene_buffer, struct wlr_renderer *renderer) {
+	struct wlr_client_buffer *client_buffer =
+		wlr_client_buffer_get(scene_buffer->buffer);
+	if (client_buffer != NULL) {
+		return client_buffer->texture;
+	}
+
+	if (scene_buffer->texture != NULL) {
+		return scene_buffer->texture;
+	}
+
+	struct wlr_dmabuf_attributes attribs;
+	if (!wlr_buffer_get_dmabuf(scene_buffer->buffer, &attribs)) {
+		return NULL;
+	}
+
+	scene_buffer->texture = wlr_texture_from_dmabuf(renderer, &attribs);
+	return scene_buffer->texture;
+}
+
+void wlr_scene_node_set_enabled(struct wlr_scene_node *node, bool enabled) {
+	if (node->state.enabled == enabled) {
+		return;
+	}
+
+	// One of the two calls is a no-op depending on the direction of the
+	// change: the node is invisible either before or after the toggle
+	scene_node_damage_whole(node);
+	node->state.enabled = enabled;
+	scene_node_damage_whole(node);
+}
+
+void wlr_scene_node_set_position(struct wlr_scene_node *node, int x, int y) {
+	if (node->state.x == x && node->state.y == y) {
+		return;
+	}
+
+	scene_node_damage_whole(node);
+	node->state.x = x;
+	node->state.y = y;
+	scene_node_damage_whole(node);
+}
+
+void wlr_scene_node_place_above(struct wlr_scene_node *node,
+		struct wlr_scene_node *sibling) {
+	assert(node != sibling);
+	assert(node->parent == sibling->parent);
+
+	if (node->state.link.prev == &sibling->state.link) {
+		return;
+	}
+
+	wl_list_remove(&node->state.link);
+	wl_list_insert(&sibling->state.link, &node->state.link);
+
+	scene_node_damage_whole(node);
+}
+
+void wlr_scene_node_place_below(struct wlr_scene_node *node,
+		struct wlr_scene_node *sibling) {
+	assert(node != sibling);
+	assert(node->parent == sibling->parent);
+
+	if (node->state.link.next == &sibling->state.link) {
+		return;
+	}
+
+	wl_list_remove(&node->state.link);
+	wl_list_insert(sibling->state.link.prev, &node->state.link);
+
+	scene_node_damage_whole(node);
+}
+
+void wlr_scene_node_raise_to_top(struct wlr_scene_node *node) {
+	struct wlr_scene_node *current_top = wl_container_of(
+		node->parent->state.children.prev, current_top, state.link);
+	if (node == current_top) {
+		return;
+	}
+	wlr_scene_node_place_above(node, current_top);
+}
+
+void wlr_scene_node_lower_to_bottom(struct wlr_scene_node *node) {
+	struct wlr_scene_node *current_bottom = wl_container_of(
+		node->parent->state.children.next, current_bottom, state.link);
+	if (node == current_bottom) {
+		return;
+	}
+	wlr_scene_node_place_below(node, current_bottom);
+}
+
+void wlr_scene_node_reparent(struct wlr_scene_node *node,
+		struct wlr_scene_node *new_parent) {
+	assert(node->type != WLR_SCENE_NODE_ROOT && new_parent != NULL);
+
+	if (node->parent == new_parent) {
+		return;
+	}
+
+	/* Ensure that a node cannot become its own ancestor */
+	for (struct wlr_scene_node *ancestor = new_parent; ancestor != NULL;
+			ancestor = ancestor->parent) {
+		assert(ancestor != node);
+	}
+
+	scene_node_damage_whole(node);
+
+	wl_list_remove(&node->state.link);
+	node->parent = new_parent;
+	wl_list_insert(new_parent->state.children.prev, &node->state.link);
+
+	scene_node_damage_whole(node);
+}
+
+void wlr_scene_node_coords(struct wlr_scene_node *node,
+		int *lx_out, int *ly_out) {
+	int lx = 0, ly = 0;
+	while (node != NULL) {
+		lx += node->state.x;
+		ly += node->state.y;
+		node = node->parent;
+	}
+
+	*lx_out = lx;
+	*ly_out = ly;
+}
+
+struct wlr_scene_node *wlr_scene_node_at(struct wlr_scene_node *node,
+		double lx, double ly, double *nx, double *ny) {
+	if (!node->state.enabled) {
+		return NULL;
+	}
+
+	// Children are drawn above their parent, so examine them first,
+	// topmost first
+	struct wlr_scene_node *child;
+	wl_list_for_each_reverse(child, &node->state.children, state.link) {
+		struct wlr_scene_node *found = wlr_scene_node_at(child,
+			lx - child->state.x, ly - child->state.y, nx, ny);
+		if (found != NULL) {
+			return found;
+		}
+	}
+
+	bool intersects = false;
+	switch (node->type) {
+	case WLR_SCENE_NODE_ROOT:
+	case WLR_SCENE_NODE_TREE:
+		break;
+	case WLR_SCENE_NODE_SURFACE:;
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(node);
+		intersects = wlr_surface_point_accepts_input(scene_surface->surface,
+			lx, ly);
+		break;
+	case WLR_SCENE_NODE_RECT:
+	case WLR_SCENE_NODE_BUFFER:;
+		int width, height;
+		scene_node_get_size(node, &width, &height);
+		intersects = lx >= 0 && lx < width && ly >= 0 && ly < height;
+		break;
+	}
+
+	if (intersects) {
+		if (nx != NULL) {
+			*nx = lx;
+		}
+		if (ny != NULL) {
+			*ny = ly;
+		}
+		return node;
+	}
+
+	return NULL;
+}
+
+static void attached_damage_handle_output_damage_destroy(
+		struct wl_listener *listener, void *data) {
+	struct wlr_scene_attached_damage *attached =
+		wl_container_of(listener, attached, output_damage_destroy);
+	attached_damage_destroy(attached);
+}
+
+void wlr_scene_attach_output_damage(struct wlr_scene *scene,
+		struct wlr_output_damage *output_damage) {
+	struct wlr_scene_attached_damage *attached =
+		calloc(1, sizeof(struct wlr_scene_attached_damage));
+	if (attached == NULL) {
+		return;
+	}
+
+	attached->output_damage = output_damage;
+	wl_list_insert(&scene->attached_damage, &attached->link);
+
+	attached->output_damage_destroy.notify =
+		attached_damage_handle_output_damage_destroy;
+	wl_signal_add(&output_damage->events.destroy,
+		&attached->output_damage_destroy);
+
+	// The scene's current content hasn't been painted on this output yet
+	wlr_output_damage_add_whole(output_damage);
+}
+
+struct scene_render_entry {
+	struct wlr_scene_node *node;
+	int x, y; // layout coordinates of the node
+	pixman_region32_t visible; // in layout coordinates
+};
+
+/**
+ * Walk the tree from topmost to bottommost, computing each node's visible
+ * region and dropping the nodes that are completely covered by opaque
+ * content or outside of the damaged area.
+ */
+static void scene_node_collect(struct wlr_scene_node *node, int lx, int ly,
+		struct wlr_occlusion *occlusion, pixman_region32_t *damage,
+		struct wl_array *entries) {
+	if (!node->state.enabled) {
+		return;
+	}
+
+	lx += node->state.x;
+	ly += node->state.y;
+
+	// Children are drawn above their parent's own content
+	struct wlr_scene_node *child;
+	wl_list_for_each_reverse(child, &node->state.children, state.link) {
+		scene_node_collect(child, lx, ly, occlusion, damage, entries);
+	}
+
+	pixman_region32_t visible;
+	pixman_region32_init(&visible);
+
+	bool any_visible = false;
+	switch (node->type) {
+	case WLR_SCENE_NODE_ROOT:
+	case WLR_SCENE_NODE_TREE:
+		break;
+	case WLR_SCENE_NODE_SURFACE:;
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(node);
+		any_visible = wlr_occlusion_add_surface(occlusion,
+			scene_surface->surface, lx, ly, &visible);
+		break;
+	case WLR_SCENE_NODE_RECT:;
+		struct wlr_scene_rect *rect = scene_rect_from_node(node);
+		struct wlr_box rect_box = {
+			.x = lx,
+			.y = ly,
+			.width = rect->width,
+			.height = rect->height,
+		};
+		any_visible = wlr_occlusion_add_box(occlusion, &rect_box,
+			rect->color[3] == 1.0f, &visible);
+		break;
+	case WLR_SCENE_NODE_BUFFER:;
+		struct wlr_scene_buffer *scene_buffer = scene_buffer_from_node(node);
+		// There's no way to tell whether an arbitrary buffer has alpha,
+		// conservatively treat it as non-opaque
+		struct wlr_box buffer_box = {
+			.x = lx,
+			.y = ly,
+			.width = scene_buffer->buffer->width,
+			.height = scene_buffer->buffer->height,
+		};
+		any_visible = wlr_occlusion_add_box(occlusion, &buffer_box, false,
+			&visible);
+		break;
+	}
+
+	if (any_visible) {
+		pixman_region32_intersect(&visible, &visible, damage);
+		any_visible = pixman_region32_not_empty(&visible);
+	}
+	if (!any_visible) {
+		pixman_region32_fini(&visible);
+		return;
+	}
+
+	struct scene_render_entry *entry =
+		wl_array_add(entries, sizeof(struct scene_render_entry));
+	if (entry == NULL) {
+		pixman_region32_fini(&visible);
+		return;
+	}
+	entry->node = node;
+	entry->x = lx;
+	entry->y = ly;
+	entry->visible = visible; // transfers ownership of the region
+}
+
+static void scale_box(struct wlr_box *box, float scale) {
+	box->x *= scale;
+	box->y *= scale;
+	box->width *= scale;
+	box->height *= scale;
+}
+
+static void scene_output_scissor(struct wlr_output *output,
+		struct wlr_renderer *renderer, pixman_box32_t *rect) {
+	struct wlr_box box = {
+		.x = rect->x1,
+		.y = rect->y1,
+		.width = rect->x2 - rect->x1,
+		.height = rect->y2 - rect->y1,
+	};
+
+	int ow, oh;
+	wlr_output_transformed_resolution(output, &ow, &oh);
+
+	enum wl_output_transform transform =
+		wlr_output_transform_invert(output->transform);
+	wlr_box_transform(&box, &box, transform, ow, oh);
+
+	wlr_renderer_scissor(renderer, &box);
+}
+
+static void scene_entry_render(struct scene_render_entry *entry,
+		struct wlr_output *output, int base_x, int base_y,
+		struct wlr_renderer *renderer) {
+	struct wlr_scene_node *node = entry->node;
+
+	struct wlr_texture *texture = NULL;
+	enum wl_output_transform transform = WL_OUTPUT_TRANSFORM_NORMAL;
+	switch (node->type) {
+	case WLR_SCENE_NODE_ROOT:
+	case WLR_SCENE_NODE_TREE:
+		return;
+	case WLR_SCENE_NODE_SURFACE:;
+		struct wlr_scene_surface *scene_surface =
+			wlr_scene_surface_from_node(node);
+		texture = wlr_surface_get_texture(scene_surface->surface);
+		if (texture == NULL) {
+			return;
+		}
+		transform = wlr_output_transform_invert(
+			scene_surface->surface->current.transform);
+		break;
+	case WLR_SCENE_NODE_RECT:
+		break;
+	case WLR_SCENE_NODE_BUFFER:
+		texture = scene_buffer_get_texture(scene_buffer_from_node(node),
+			renderer);
+		if (texture == NULL) {
+			return;
+		}
+		break;
+	}
+
+	int width, height;
+	scene_node_get_size(node, &width, &height);
+	struct wlr_box box = {
+		.x = entry->x - base_x,
+		.y = entry->y - base_y,
+		.width = width,
+		.height = height,
+	};
+	scale_box(&box, output->scale);
+
+	// The visible region is in layout coordinates, the scissor needs
+	// output-buffer coordinates
+	pixman_region32_t render_region;
+	pixman_region32_init(&render_region);
+	pixman_region32_copy(&render_region, &entry->visible);
+	pixman_region32_translate(&render_region, -base_x, -base_y);
+	wlr_region_scale(&render_region, &render_region, output->scale);
+
+	float matrix[9];
+	if (node->type != WLR_SCENE_NODE_RECT) {
+		wlr_matrix_project_box(matrix, &box, transform, 0.0f,
+			output->transform_matrix);
+	}
+
+	int nrects;
+	pixman_box32_t *rects = pixman_region32_rectangles(&render_region, &nrects);
+	for (int i = 0; i < nrects; ++i) {
+		scene_output_scissor(output, renderer, &rects[i]);
+		if (node->type == WLR_SCENE_NODE_RECT) {
+			struct wlr_scene_rect *rect = scene_rect_from_node(node);
+			wlr_render_rect(renderer, &box, rect->color,
+				output->transform_matrix);
+		} else {
+			wlr_render_texture_with_matrix(renderer, texture, matrix, 1.0f);
+		}
+	}
+	wlr_renderer_scissor(renderer, NULL);
+
+	pixman_region32_fini(&render_region);
+}
+
+void wlr_scene_render_output(struct wlr_scene *scene, struct wlr_output *output,
+		int lx, int ly, pixman_region32_t *damage) {
+	struct wlr_renderer *renderer =
+		wlr_backend_get_renderer(output->backend);
+	assert(renderer != NULL);
+
+	int width, height;
+	wlr_output_transformed_resolution(output, &width, &height);
+
+	// The damage is in scaled output-buffer coordinates, the tree walk
+	// happens in layout coordinates
+	pixman_region32_t layout_damage;
+	pixman_region32_init(&layout_damage);
+	if (damage != NULL) {
+		wlr_region_scale(&layout_damage, damage, 1.0f / output->scale);
+	} else {
+		pixman_region32_union_rect(&layout_damage, &layout_damage, 0, 0,
+			ceil(width / output->scale), ceil(height / output->scale));
+	}
+	pixman_region32_translate(&layout_damage, lx, ly);
+
+	struct wlr_occlusion occlusion;
+	wlr_occlusion_init(&occlusion);
+
+	struct wl_array entries;
+	wl_array_init(&entries);
+	scene_node_collect(&scene->node, 0, 0, &occlusion, &layout_damage,
+		&entries);
+
+	wlr_occlusion_finish(&occlusion);
+	pixman_region32_fini(&layout_damage);
+
+	// The walk collected the nodes from topmost to bottommost, paint them
+	// in the opposite order
+	struct scene_render_entry *entry_arr = entries.data;
+	size_t entries_len = entries.size / sizeof(struct scene_render_entry);
+	for (size_t i = entries_len; i > 0; --i) {
+		struct scene_render_entry *entry = &entry_arr[i - 1];
+		scene_entry_render(entry, output, lx, ly, renderer);
+		pixman_region32_fini(&entry->visible);
+	}
+	wl_array_release(&entries);
+}
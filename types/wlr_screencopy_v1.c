@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <drm_fourcc.h>
 #include <wlr/render/wlr_renderer.h>
 #include <wlr/types/wlr_output.h>
@@ -8,10 +9,18 @@
 #include <wlr/backend.h>
 #include <wlr/util/log.h>
 #include "wlr-screencopy-unstable-v1-protocol.h"
+#include "types/wlr_output_capture.h"
 #include "util/signal.h"
 
 #define SCREENCOPY_MANAGER_VERSION 3
 
+// Backpressure budget per capture client. A stalled reader that keeps issuing
+// copies would otherwise accumulate frames, staging buffers and queued events
+// in the compositor without bound; once a client exceeds the budget its
+// oldest pending copy is dropped in favour of the new one.
+#define SCREENCOPY_CLIENT_MAX_INFLIGHT_FRAMES 4
+#define SCREENCOPY_CLIENT_MAX_INFLIGHT_BYTES (64 * 1024 * 1024)
+
 struct screencopy_damage {
 	struct wl_list link;
 	struct wlr_output *output;
@@ -21,6 +30,18 @@ struct screencopy_damage {
 	uint32_t last_commit_seq;
 };
 
+struct screencopy_async_read {
+	struct wl_list link; // wlr_screencopy_manager_v1::pending_reads
+	struct wlr_screencopy_manager_v1 *manager;
+	struct wlr_renderer *renderer;
+	struct wlr_screencopy_frame_v1 *frame; // NULL if the frame went away
+
+	void *staging; // pixels land here before being copied into the shm buffer
+	int32_t stride, height;
+	uint32_t renderer_flags;
+	struct timespec when;
+};
+
 static const struct zwlr_screencopy_frame_v1_interface frame_impl;
 
 static struct screencopy_damage *screencopy_damage_find(
@@ -150,9 +171,21 @@ static void frame_destroy(struct wlr_screencopy_frame_v1 *frame) {
 			wlr_output_lock_software_cursors(frame->output, false);
 		}
 	}
+	if (frame->async_read != NULL) {
+		// The renderer-side read keeps going; the completion callback
+		// cleans up the orphaned state
+		frame->async_read->frame = NULL;
+		frame->async_read = NULL;
+	}
+	if (frame->consumer != NULL) {
+		wlr_output_capture_remove(frame->consumer);
+		free(frame->consumer);
+	}
+	if (frame->inflight) {
+		frame->client->inflight_frames--;
+		frame->client->inflight_bytes -= frame->inflight_bytes;
+	}
 	wl_list_remove(&frame->link);
-	wl_list_remove(&frame->output_precommit.link);
-	wl_list_remove(&frame->output_commit.link);
 	wl_list_remove(&frame->output_destroy.link);
 	wl_list_remove(&frame->output_enable.link);
 	wl_list_remove(&frame->buffer_destroy.link);
@@ -197,19 +230,66 @@ static void frame_send_ready(struct wlr_screencopy_frame_v1 *frame,
 		tv_sec_hi, tv_sec_lo, when->tv_nsec);
 }
 
-static void frame_handle_output_precommit(struct wl_listener *listener,
-		void *_data) {
-	struct wlr_screencopy_frame_v1 *frame =
-		wl_container_of(listener, frame, output_precommit);
-	struct wlr_output_event_precommit *event = _data;
+static void frame_handle_read_done(bool success, void *data) {
+	struct screencopy_async_read *read = data;
+	struct wlr_screencopy_frame_v1 *frame = read->frame;
+
+	wl_list_remove(&read->link);
+
+	if (frame == NULL) {
+		goto out;
+	}
+	frame->async_read = NULL;
+
+	if (!success) {
+		zwlr_screencopy_frame_v1_send_failed(frame->resource);
+		frame_destroy(frame);
+		goto out;
+	}
+
+	struct wl_shm_buffer *shm_buffer = frame->shm_buffer;
+	wl_shm_buffer_begin_access(shm_buffer);
+	void *shm_data = wl_shm_buffer_get_data(shm_buffer);
+	memcpy(shm_data, read->staging, (size_t)read->stride * read->height);
+	wl_shm_buffer_end_access(shm_buffer);
+
+	uint32_t flags = read->renderer_flags & WLR_RENDERER_READ_PIXELS_Y_INVERT ?
+		ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT : 0;
+	zwlr_screencopy_frame_v1_send_flags(frame->resource, flags);
+	frame_send_damage(frame);
+	frame_send_ready(frame, &read->when);
+	frame_destroy(frame);
+
+out:
+	free(read->staging);
+	free(read);
+}
+
+static int manager_poll_async_reads(void *data) {
+	struct wlr_screencopy_manager_v1 *manager = data;
+
+	if (!wl_list_empty(&manager->pending_reads)) {
+		struct screencopy_async_read *read =
+			wl_container_of(manager->pending_reads.next, read, link);
+		// In practice all pending reads share one renderer; completed reads
+		// are removed from the list by their callbacks
+		wlr_renderer_poll_async_reads(read->renderer);
+	}
+
+	if (!wl_list_empty(&manager->pending_reads)) {
+		wl_event_source_timer_update(manager->poll_timer, 1);
+	}
+	return 0;
+}
+
+static void frame_handle_capture_precommit(
+		struct wlr_output_capture_consumer *consumer,
+		struct wlr_output_event_precommit *event) {
+	struct wlr_screencopy_frame_v1 *frame = consumer->data;
 	struct wlr_output *output = frame->output;
 	struct wlr_renderer *renderer = wlr_backend_get_renderer(output->backend);
 	assert(renderer);
 
-	if (!(output->pending.committed & WLR_OUTPUT_STATE_BUFFER)) {
-		return;
-	}
-
 	struct wl_shm_buffer *shm_buffer = frame->shm_buffer;
 	if (shm_buffer == NULL) {
 		return;
@@ -226,8 +306,8 @@ static void frame_handle_output_precommit(struct wl_listener *listener,
 		}
 	}
 
-	wl_list_remove(&frame->output_precommit.link);
-	wl_list_init(&frame->output_precommit.link);
+	wlr_output_capture_consumer_captured(frame->consumer);
+	wlr_output_capture_remove(frame->consumer);
 
 	int x = frame->box.x;
 	int y = frame->box.y;
@@ -237,40 +317,54 @@ static void frame_handle_output_precommit(struct wl_listener *listener,
 	int32_t height = wl_shm_buffer_get_height(shm_buffer);
 	int32_t stride = wl_shm_buffer_get_stride(shm_buffer);
 
-	wl_shm_buffer_begin_access(shm_buffer);
-	void *data = wl_shm_buffer_get_data(shm_buffer);
-	uint32_t renderer_flags = 0;
-	bool ok = wlr_renderer_read_pixels(renderer, fmt, &renderer_flags,
-		stride, width, height, x, y, 0, 0, data);
-	uint32_t flags = renderer_flags & WLR_RENDERER_READ_PIXELS_Y_INVERT ?
-		ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT : 0;
-	wl_shm_buffer_end_access(shm_buffer);
+	struct wlr_screencopy_manager_v1 *manager = frame->client->manager;
 
-	if (!ok) {
-		zwlr_screencopy_frame_v1_send_failed(frame->resource);
-		frame_destroy(frame);
-		return;
+	struct screencopy_async_read *read = calloc(1, sizeof(*read));
+	if (read == NULL) {
+		goto error;
+	}
+	// Read into a staging buffer, so the client's shm pool is only touched
+	// once the GPU-side copy has finished
+	read->staging = malloc((size_t)stride * height);
+	if (read->staging == NULL) {
+		free(read);
+		goto error;
 	}
 
-	zwlr_screencopy_frame_v1_send_flags(frame->resource, flags);
-	frame_send_damage(frame);
-	frame_send_ready(frame, event->when);
+	read->manager = manager;
+	read->renderer = renderer;
+	read->frame = frame;
+	read->stride = stride;
+	read->height = height;
+	read->when = *event->when;
+	wl_list_insert(&manager->pending_reads, &read->link);
+	frame->async_read = read;
+
+	// The callback may fire before this returns if the renderer only
+	// supports synchronous reads; it handles failure as well
+	wlr_renderer_read_pixels_async(renderer, fmt, &read->renderer_flags,
+		stride, width, height, x, y, 0, 0, read->staging,
+		frame_handle_read_done, read);
+
+	if (!wl_list_empty(&manager->pending_reads)) {
+		// Reading asynchronously: poll for completion from the event loop
+		wl_event_source_timer_update(manager->poll_timer, 1);
+	}
+	return;
+
+error:
+	zwlr_screencopy_frame_v1_send_failed(frame->resource);
 	frame_destroy(frame);
 }
 
-static void frame_handle_output_commit(struct wl_listener *listener,
-		void *data) {
-	struct wlr_screencopy_frame_v1 *frame =
-		wl_container_of(listener, frame, output_commit);
-	struct wlr_output_event_commit *event = data;
+static void frame_handle_capture_commit(
+		struct wlr_output_capture_consumer *consumer,
+		struct wlr_output_event_commit *event) {
+	struct wlr_screencopy_frame_v1 *frame = consumer->data;
 	struct wlr_output *output = frame->output;
 	struct wlr_renderer *renderer = wlr_backend_get_renderer(output->backend);
 	assert(renderer);
 
-	if (!(event->committed & WLR_OUTPUT_STATE_BUFFER)) {
-		return;
-	}
-
 	struct wlr_dmabuf_v1_buffer *dma_buffer = frame->dma_buffer;
 	if (dma_buffer == NULL) {
 		return;
@@ -284,22 +378,23 @@ static void frame_handle_output_commit(struct wl_listener *listener,
 		}
 	}
 
-	wl_list_remove(&frame->output_commit.link);
-	wl_list_init(&frame->output_commit.link);
+	wlr_output_capture_consumer_captured(frame->consumer);
+	wlr_output_capture_remove(frame->consumer);
 
-	// TODO: add support for copying regions with DMA-BUFs
-	if (frame->box.x != 0 || frame->box.y != 0 ||
-			output->width != frame->box.width ||
-			output->height != frame->box.height) {
-		zwlr_screencopy_frame_v1_send_failed(frame->resource);
-		frame_destroy(frame);
-		return;
-	}
+	// Crop to the captured region and scale to the client's buffer size as
+	// part of the GPU copy, so region shares and thumbnails only ever
+	// transfer the pixels they need
+	struct wlr_fbox src_box = {
+		.x = frame->box.x,
+		.y = frame->box.y,
+		.width = frame->box.width,
+		.height = frame->box.height,
+	};
 
 	struct wlr_dmabuf_attributes attr = { 0 };
 	bool ok = wlr_output_export_dmabuf(output, &attr);
-	ok = ok && wlr_renderer_blit_dmabuf(renderer,
-		&dma_buffer->attributes, &attr);
+	ok = ok && wlr_renderer_blit_dmabuf_region(renderer,
+		&dma_buffer->attributes, &attr, &src_box);
 	uint32_t flags = dma_buffer->attributes.flags & WLR_DMABUF_ATTRIBUTES_FLAGS_Y_INVERT ?
 		ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT : 0;
 	wlr_dmabuf_attributes_finish(&attr);
@@ -342,6 +437,20 @@ static void frame_handle_buffer_destroy(struct wl_listener *listener,
 	frame_destroy(frame);
 }
 
+static void client_drop_oldest_frame(struct wlr_screencopy_v1_client *client) {
+	// The frames list is newest-first, so the last in-flight entry of this
+	// client is its oldest pending copy
+	struct wlr_screencopy_frame_v1 *oldest = NULL, *iter;
+	wl_list_for_each(iter, &client->manager->frames, link) {
+		if (iter->client == client && iter->inflight) {
+			oldest = iter;
+		}
+	}
+	assert(oldest != NULL);
+	zwlr_screencopy_frame_v1_send_failed(oldest->resource);
+	frame_destroy(oldest);
+}
+
 static void frame_handle_copy(struct wl_client *wl_client,
 		struct wl_resource *frame_resource,
 		struct wl_resource *buffer_resource) {
@@ -413,14 +522,19 @@ static void frame_handle_copy(struct wl_client *wl_client,
 		abort();
 	}
 
-	if (width != frame->box.width || height != frame->box.height) {
+	// The CPU read path needs an exactly-sized shm buffer. DMA-BUFs of a
+	// different size are accepted: the copy is a GPU blit which scales the
+	// captured region to the buffer, letting clients downscale (e.g. for
+	// thumbnails) without touching the full-size pixels on the CPU.
+	if (shm_buffer != NULL &&
+			(width != frame->box.width || height != frame->box.height)) {
 		wl_resource_post_error(frame->resource,
 			ZWLR_SCREENCOPY_FRAME_V1_ERROR_INVALID_BUFFER,
 			"invalid buffer dimensions");
 		return;
 	}
 
-	if (!wl_list_empty(&frame->output_precommit.link) ||
+	if (frame->consumer != NULL ||
 			frame->shm_buffer != NULL || frame->dma_buffer != NULL) {
 		wl_resource_post_error(frame->resource,
 			ZWLR_SCREENCOPY_FRAME_V1_ERROR_ALREADY_USED,
@@ -428,14 +542,42 @@ static void frame_handle_copy(struct wl_client *wl_client,
 		return;
 	}
 
+	// DMA-BUF copies are GPU blits and need no staging memory; only the CPU
+	// read path allocates stride * height bytes per pending copy
+	size_t inflight_bytes =
+		shm_buffer != NULL ? (size_t)frame->stride * height : 0;
+	struct wlr_screencopy_v1_client *client = frame->client;
+	while (client->inflight_frames >= SCREENCOPY_CLIENT_MAX_INFLIGHT_FRAMES ||
+			(client->inflight_frames > 0 &&
+			client->inflight_bytes + inflight_bytes >
+			SCREENCOPY_CLIENT_MAX_INFLIGHT_BYTES)) {
+		client_drop_oldest_frame(client);
+	}
+
+	frame->consumer = calloc(1, sizeof(struct wlr_output_capture_consumer));
+	if (frame->consumer == NULL) {
+		wl_resource_post_no_memory(frame->resource);
+		return;
+	}
+	frame->consumer->only_damaged = frame->with_damage;
+	frame->consumer->max_fps = frame->client->manager->max_capture_fps;
+	frame->consumer->precommit = frame_handle_capture_precommit;
+	frame->consumer->commit = frame_handle_capture_commit;
+	frame->consumer->data = frame;
+	if (!wlr_output_capture_add(output, frame->consumer)) {
+		free(frame->consumer);
+		frame->consumer = NULL;
+		wl_resource_post_no_memory(frame->resource);
+		return;
+	}
+
 	frame->shm_buffer = shm_buffer;
 	frame->dma_buffer = dma_buffer;
 
-	wl_signal_add(&output->events.precommit, &frame->output_precommit);
-	frame->output_precommit.notify = frame_handle_output_precommit;
-
-	wl_signal_add(&output->events.commit, &frame->output_commit);
-	frame->output_commit.notify = frame_handle_output_commit;
+	frame->inflight = true;
+	frame->inflight_bytes = inflight_bytes;
+	client->inflight_frames++;
+	client->inflight_bytes += inflight_bytes;
 
 	wl_signal_add(&output->events.destroy, &frame->output_enable);
 	frame->output_enable.notify = frame_handle_output_enable;
@@ -446,8 +588,24 @@ static void frame_handle_copy(struct wl_client *wl_client,
 	wl_resource_add_destroy_listener(buffer_resource, &frame->buffer_destroy);
 	frame->buffer_destroy.notify = frame_handle_buffer_destroy;
 
-	// Schedule a buffer commit
-	wlr_output_schedule_frame(output);
+	// Schedule a buffer commit. For with-damage frames, don't force a
+	// repaint while nothing has changed: the copy completes with the next
+	// commit that actually produces damage.
+	bool need_frame = true;
+	if (frame->with_damage) {
+		struct screencopy_damage *damage =
+			screencopy_damage_get_or_create(frame->client, output);
+		if (damage != NULL && !pixman_region32_not_empty(&damage->damage)) {
+			need_frame = false;
+		} else {
+			// Damage accumulated before this copy was requested still
+			// counts as interest
+			frame->consumer->damaged = true;
+		}
+	}
+	if (need_frame) {
+		wlr_output_schedule_frame(output);
+	}
 
 	wlr_output_lock_attach_render(output, true);
 	if (frame->overlay_cursor) {
@@ -538,8 +696,6 @@ static void capture_output(struct wl_client *wl_client,
 
 	wl_list_insert(&client->manager->frames, &frame->link);
 
-	wl_list_init(&frame->output_precommit.link);
-	wl_list_init(&frame->output_commit.link);
 	wl_list_init(&frame->output_enable.link);
 	wl_list_init(&frame->output_destroy.link);
 	wl_list_init(&frame->buffer_destroy.link);
@@ -680,6 +836,16 @@ static void handle_display_destroy(struct wl_listener *listener, void *data) {
 	struct wlr_screencopy_manager_v1 *manager =
 		wl_container_of(listener, manager, display_destroy);
 	wlr_signal_emit_safe(&manager->events.destroy, manager);
+
+	// Orphan in-flight reads: their callbacks only touch their own state
+	// from now on
+	struct screencopy_async_read *read, *read_tmp;
+	wl_list_for_each_safe(read, read_tmp, &manager->pending_reads, link) {
+		wl_list_remove(&read->link);
+		wl_list_init(&read->link);
+	}
+	wl_event_source_remove(manager->poll_timer);
+
 	wl_list_remove(&manager->display_destroy.link);
 	wl_global_destroy(manager->global);
 	free(manager);
@@ -702,6 +868,16 @@ struct wlr_screencopy_manager_v1 *wlr_screencopy_manager_v1_create(
 	}
 	wl_list_init(&manager->frames);
 
+	wl_list_init(&manager->pending_reads);
+	struct wl_event_loop *loop = wl_display_get_event_loop(display);
+	manager->poll_timer = wl_event_loop_add_timer(loop,
+		manager_poll_async_reads, manager);
+	if (manager->poll_timer == NULL) {
+		wl_global_destroy(manager->global);
+		free(manager);
+		return NULL;
+	}
+
 	wl_signal_init(&manager->events.destroy);
 
 	manager->display_destroy.notify = handle_display_destroy;
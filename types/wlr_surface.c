@@ -10,13 +10,31 @@
 #include <wlr/types/wlr_output.h>
 #include <wlr/util/log.h>
 #include <wlr/util/region.h>
+#include "types/wlr_client_stats.h"
+#include "util/flush.h"
 #include "util/signal.h"
+#include "util/slab.h"
 #include "util/time.h"
+#include "util/trace.h"
 
 #define CALLBACK_VERSION 1
 #define SURFACE_VERSION 4
 #define SUBSURFACE_VERSION 1
 
+// Surfaces and subsurfaces churn with every menu, tooltip and popup; slabs
+// keep them off the general-purpose allocator and close together in memory
+static struct wlr_slab surface_slab;
+static struct wlr_slab subsurface_slab;
+static bool surface_slabs_initialized = false;
+
+static void surface_slabs_init(void) {
+	if (!surface_slabs_initialized) {
+		wlr_slab_init(&surface_slab, sizeof(struct wlr_surface));
+		wlr_slab_init(&subsurface_slab, sizeof(struct wlr_subsurface));
+		surface_slabs_initialized = true;
+	}
+}
+
 static int min(int fst, int snd) {
 	if (fst < snd) {
 		return fst;
@@ -86,10 +104,13 @@ static void surface_damage(struct wl_client *client,
 	pixman_region32_union_rect(&surface->pending.surface_damage,
 		&surface->pending.surface_damage,
 		x, y, width, height);
+	client_stats_count_damage(client, 1);
 }
 
 static void callback_handle_resource_destroy(struct wl_resource *resource) {
 	wl_list_remove(wl_resource_get_link(resource));
+	// Every destruction path ends up here, fired or abandoned alike
+	client_stats_frame_callback_fired(wl_resource_get_client(resource));
 }
 
 static void surface_frame(struct wl_client *client,
@@ -109,6 +130,7 @@ static void surface_frame(struct wl_client *client,
 		wl_resource_get_link(callback_resource));
 
 	surface->pending.committed |= WLR_SURFACE_STATE_FRAME_CALLBACK_LIST;
+	client_stats_count_frame_callback(client);
 }
 
 static void surface_set_opaque_region(struct wl_client *client,
@@ -199,6 +221,35 @@ static void surface_state_finalize(struct wlr_surface *surface,
 		state->buffer_height);
 }
 
+/**
+ * Recomputes the derived buffer source box. Called when the state is
+ * committed, so that render paths don't re-derive it from the viewport on
+ * every frame.
+ */
+static void surface_state_update_buffer_src_box(
+		struct wlr_surface_state *state) {
+	struct wlr_fbox *box = &state->buffer_src_box;
+	box->x = box->y = 0;
+	box->width = state->buffer_width;
+	box->height = state->buffer_height;
+
+	if (state->viewport.has_src) {
+		box->x = state->viewport.src.x * state->scale;
+		box->y = state->viewport.src.y * state->scale;
+		box->width = state->viewport.src.width * state->scale;
+		box->height = state->viewport.src.height * state->scale;
+		if ((state->transform & WL_OUTPUT_TRANSFORM_90) != 0) {
+			double tmp = box->x;
+			box->x = box->y;
+			box->y = tmp;
+
+			tmp = box->width;
+			box->width = box->height;
+			box->height = tmp;
+		}
+	}
+}
+
 static void surface_update_damage(pixman_region32_t *buffer_damage,
 		struct wlr_surface_state *current, struct wlr_surface_state *pending) {
 	pixman_region32_clear(buffer_damage);
@@ -284,23 +335,67 @@ static void surface_state_copy(struct wlr_surface_state *state,
 	state->committed |= next->committed;
 }
 
+static void surface_state_swap_region(pixman_region32_t *region,
+		pixman_region32_t *other) {
+	pixman_region32_t tmp = *region;
+	*region = *other;
+	*other = tmp;
+}
+
 /**
  * Append pending state to current state and clear pending state.
+ *
+ * Unlike surface_state_copy, regions are moved into place by swapping the
+ * region structs, which transfers ownership of their rectangle arrays. This
+ * keeps the common commit path free of per-region allocations.
  */
 static void surface_state_move(struct wlr_surface_state *state,
 		struct wlr_surface_state *next) {
-	surface_state_copy(state, next);
+	state->width = next->width;
+	state->height = next->height;
+	state->buffer_width = next->buffer_width;
+	state->buffer_height = next->buffer_height;
 
+	if (next->committed & WLR_SURFACE_STATE_SCALE) {
+		state->scale = next->scale;
+	}
+	if (next->committed & WLR_SURFACE_STATE_TRANSFORM) {
+		state->transform = next->transform;
+	}
 	if (next->committed & WLR_SURFACE_STATE_BUFFER) {
+		state->dx = next->dx;
+		state->dy = next->dy;
 		surface_state_set_buffer(state, next->buffer_resource);
 		surface_state_reset_buffer(next);
 		next->dx = next->dy = 0;
+	} else {
+		state->dx = state->dy = 0;
 	}
 	if (next->committed & WLR_SURFACE_STATE_SURFACE_DAMAGE) {
+		surface_state_swap_region(&state->surface_damage,
+			&next->surface_damage);
 		pixman_region32_clear(&next->surface_damage);
+	} else {
+		pixman_region32_clear(&state->surface_damage);
 	}
 	if (next->committed & WLR_SURFACE_STATE_BUFFER_DAMAGE) {
+		surface_state_swap_region(&state->buffer_damage,
+			&next->buffer_damage);
 		pixman_region32_clear(&next->buffer_damage);
+	} else {
+		pixman_region32_clear(&state->buffer_damage);
+	}
+	if (next->committed & WLR_SURFACE_STATE_OPAQUE_REGION) {
+		// The swap leaves the previously committed region in `next`; it's
+		// either equal to the new one or overwritten by the next
+		// set_opaque_region request before it is read again
+		surface_state_swap_region(&state->opaque, &next->opaque);
+	}
+	if (next->committed & WLR_SURFACE_STATE_INPUT_REGION) {
+		surface_state_swap_region(&state->input, &next->input);
+	}
+	if (next->committed & WLR_SURFACE_STATE_VIEWPORT) {
+		memcpy(&state->viewport, &next->viewport, sizeof(state->viewport));
 	}
 	if (next->committed & WLR_SURFACE_STATE_FRAME_CALLBACK_LIST) {
 		wl_list_insert_list(&state->frame_callback_list,
@@ -308,9 +403,37 @@ static void surface_state_move(struct wlr_surface_state *state,
 		wl_list_init(&next->frame_callback_list);
 	}
 
+	state->committed |= next->committed;
 	next->committed = 0;
 }
 
+struct surface_iter_entry {
+	struct wlr_surface *surface;
+	int x, y; // relative to the surface the cache is built on
+};
+
+static bool surface_update_iter_cache(struct wlr_surface *surface);
+
+/**
+ * Invalidate the flattened iteration cache of this surface and of every
+ * surface it is nested in.
+ */
+static void surface_invalidate_iter_cache(struct wlr_surface *surface) {
+	while (surface != NULL) {
+		surface->iter_cache_valid = false;
+		++surface->iter_generation;
+		if (!wlr_surface_is_subsurface(surface)) {
+			break;
+		}
+		struct wlr_subsurface *subsurface =
+			wlr_subsurface_from_wlr_surface(surface);
+		if (subsurface == NULL) {
+			break;
+		}
+		surface = subsurface->parent;
+	}
+}
+
 static void surface_damage_subsurfaces(struct wlr_subsurface *subsurface) {
 	// XXX: This is probably the wrong way to do it, because this damage should
 	// come from the client, but weston doesn't do it correctly either and it
@@ -337,9 +460,18 @@ static void surface_apply_damage(struct wlr_surface *surface) {
 			wlr_buffer_unlock(&surface->buffer->base);
 		}
 		surface->buffer = NULL;
+		surface->texture_upload_pending = false;
 		return;
 	}
 
+	if (surface->occluded) {
+		// Nobody can see the result: defer the upload until the surface
+		// becomes visible again
+		surface->texture_upload_pending = true;
+		return;
+	}
+	surface->texture_upload_pending = false;
+
 	if (surface->buffer != NULL && surface->buffer->resource_released) {
 		struct wlr_client_buffer *updated_buffer =
 			wlr_client_buffer_apply_damage(surface->buffer, resource,
@@ -387,7 +519,17 @@ static void surface_update_input_region(struct wlr_surface *surface) {
 		0, 0, surface->current.width, surface->current.height);
 }
 
+static bool surface_transaction_latch(struct wlr_surface *surface);
+
 static void surface_commit_pending(struct wlr_surface *surface) {
+	if (surface_transaction_latch(surface)) {
+		// The commit is held until the whole transaction is ready
+		return;
+	}
+
+	wlr_trace(surface_commit, surface, surface->pending.committed);
+	trace_span_begin("surface_commit");
+
 	surface_state_finalize(surface, &surface->pending);
 
 	if (surface->role && surface->role->precommit) {
@@ -396,6 +538,12 @@ static void surface_commit_pending(struct wlr_surface *surface) {
 
 	bool invalid_buffer = surface->pending.committed & WLR_SURFACE_STATE_BUFFER;
 
+	if (surface->pending.width != surface->current.width ||
+			surface->pending.height != surface->current.height) {
+		// The cached subsurface-tree extent depends on surface sizes
+		surface_invalidate_iter_cache(surface);
+	}
+
 	surface->sx += surface->pending.dx;
 	surface->sy += surface->pending.dy;
 	surface_update_damage(&surface->buffer_damage,
@@ -403,6 +551,7 @@ static void surface_commit_pending(struct wlr_surface *surface) {
 
 	surface_state_copy(&surface->previous, &surface->current);
 	surface_state_move(&surface->current, &surface->pending);
+	surface_state_update_buffer_src_box(&surface->current);
 
 	if (invalid_buffer) {
 		surface_apply_damage(surface);
@@ -420,6 +569,7 @@ static void surface_commit_pending(struct wlr_surface *surface) {
 		if (subsurface->reordered) {
 			// TODO: damage all the subsurfaces
 			surface_damage_subsurfaces(subsurface);
+			surface_invalidate_iter_cache(surface);
 		}
 	}
 
@@ -428,6 +578,8 @@ static void surface_commit_pending(struct wlr_surface *surface) {
 	}
 
 	wlr_signal_emit_safe(&surface->events.commit, surface);
+
+	trace_span_end("surface_commit");
 }
 
 static bool subsurface_is_synchronized(struct wlr_subsurface *subsurface) {
@@ -491,6 +643,8 @@ static void surface_commit(struct wl_client *client,
 		struct wl_resource *resource) {
 	struct wlr_surface *surface = wlr_surface_from_resource(resource);
 
+	client_stats_count_commit(client);
+
 	struct wlr_subsurface *subsurface = wlr_surface_is_subsurface(surface) ?
 		wlr_subsurface_from_wlr_surface(surface) : NULL;
 	if (subsurface != NULL) {
@@ -541,6 +695,7 @@ static void surface_damage_buffer(struct wl_client *client,
 	pixman_region32_union_rect(&surface->pending.buffer_damage,
 		&surface->pending.buffer_damage,
 		x, y, width, height);
+	client_stats_count_damage(client, 1);
 }
 
 static const struct wl_surface_interface surface_interface = {
@@ -563,16 +718,26 @@ struct wlr_surface *wlr_surface_from_resource(struct wl_resource *resource) {
 }
 
 static void surface_state_init(struct wlr_surface_state *state) {
-	state->scale = 1;
-	state->transform = WL_OUTPUT_TRANSFORM_NORMAL;
+	// A fresh state is all plain values: empty regions and the single-rect
+	// infinite input region live inline in pixman_region32_t without heap
+	// data, so one struct copy from a template initializes a state. Only
+	// the self-referential list link needs per-instance setup. Three
+	// states per surface makes this worth it for surface-churny clients.
+	static struct wlr_surface_state template;
+	static bool template_initialized = false;
+	if (!template_initialized) {
+		template.scale = 1;
+		template.transform = WL_OUTPUT_TRANSFORM_NORMAL;
+		pixman_region32_init(&template.surface_damage);
+		pixman_region32_init(&template.buffer_damage);
+		pixman_region32_init(&template.opaque);
+		pixman_region32_init_rect(&template.input,
+			INT32_MIN, INT32_MIN, UINT32_MAX, UINT32_MAX);
+		template_initialized = true;
+	}
 
+	*state = template;
 	wl_list_init(&state->frame_callback_list);
-
-	pixman_region32_init(&state->surface_damage);
-	pixman_region32_init(&state->buffer_damage);
-	pixman_region32_init(&state->opaque);
-	pixman_region32_init_rect(&state->input,
-		INT32_MIN, INT32_MIN, UINT32_MAX, UINT32_MAX);
 }
 
 static void surface_state_finish(struct wlr_surface_state *state) {
@@ -589,6 +754,142 @@ static void surface_state_finish(struct wlr_surface_state *state) {
 	pixman_region32_fini(&state->input);
 }
 
+// Membership of one surface in a transaction. Commits latched while the
+// transaction is pending accumulate in `cached`, exactly like a synchronized
+// subsurface's cached state.
+struct wlr_surface_transaction_entry {
+	struct wl_list link; // wlr_surface_transaction.surfaces
+	struct wlr_surface_transaction *transaction;
+	struct wlr_surface *surface;
+
+	struct wlr_surface_state cached;
+	bool has_cache;
+
+	struct wl_listener surface_destroy;
+};
+
+static void surface_transaction_entry_destroy(
+		struct wlr_surface_transaction_entry *entry) {
+	entry->surface->transaction_entry = NULL;
+	wl_list_remove(&entry->surface_destroy.link);
+	wl_list_remove(&entry->link);
+	surface_state_finish(&entry->cached);
+	free(entry);
+}
+
+static void surface_transaction_apply(
+		struct wlr_surface_transaction *transaction) {
+	// Apply every member's cached state back-to-back, within one dispatch
+	// slice: the compositor renders a single frame with the new geometry of
+	// every member, and each member's accumulated damage is processed once
+	struct wlr_surface_transaction_entry *entry, *tmp;
+	wl_list_for_each_safe(entry, tmp, &transaction->surfaces, link) {
+		struct wlr_surface *surface = entry->surface;
+		bool has_cache = entry->has_cache;
+		if (has_cache) {
+			surface_state_move(&surface->pending, &entry->cached);
+		}
+		// Unlatch before committing so the commit isn't cached again
+		surface_transaction_entry_destroy(entry);
+		if (has_cache) {
+			surface_commit_pending(surface);
+		}
+	}
+
+	wlr_signal_emit_safe(&transaction->events.ready, transaction);
+}
+
+static bool surface_transaction_latch(struct wlr_surface *surface) {
+	struct wlr_surface_transaction_entry *entry = surface->transaction_entry;
+	if (entry == NULL) {
+		return false;
+	}
+
+	surface_state_move(&entry->cached, &surface->pending);
+	if (!entry->has_cache) {
+		entry->has_cache = true;
+		struct wlr_surface_transaction *transaction = entry->transaction;
+		assert(transaction->n_waiting > 0);
+		if (--transaction->n_waiting == 0) {
+			surface_transaction_apply(transaction);
+		}
+	}
+	return true;
+}
+
+static void surface_transaction_handle_surface_destroy(
+		struct wl_listener *listener, void *data) {
+	struct wlr_surface_transaction_entry *entry =
+		wl_container_of(listener, entry, surface_destroy);
+	struct wlr_surface_transaction *transaction = entry->transaction;
+	bool arrived = entry->has_cache;
+	surface_transaction_entry_destroy(entry);
+
+	// A dead member can't commit anymore; don't wait for it
+	if (!arrived && --transaction->n_waiting == 0) {
+		surface_transaction_apply(transaction);
+	}
+}
+
+struct wlr_surface_transaction *wlr_surface_transaction_create(void) {
+	struct wlr_surface_transaction *transaction =
+		calloc(1, sizeof(struct wlr_surface_transaction));
+	if (transaction == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	wl_list_init(&transaction->surfaces);
+	wl_signal_init(&transaction->events.ready);
+	return transaction;
+}
+
+bool wlr_surface_transaction_add(struct wlr_surface_transaction *transaction,
+		struct wlr_surface *surface) {
+	if (surface->transaction_entry != NULL) {
+		return false;
+	}
+
+	struct wlr_surface_transaction_entry *entry =
+		calloc(1, sizeof(struct wlr_surface_transaction_entry));
+	if (entry == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return false;
+	}
+	entry->transaction = transaction;
+	entry->surface = surface;
+	surface_state_init(&entry->cached);
+	wl_list_insert(&transaction->surfaces, &entry->link);
+	entry->surface_destroy.notify = surface_transaction_handle_surface_destroy;
+	wl_signal_add(&surface->events.destroy, &entry->surface_destroy);
+	surface->transaction_entry = entry;
+	transaction->n_waiting++;
+	return true;
+}
+
+void wlr_surface_transaction_destroy(
+		struct wlr_surface_transaction *transaction) {
+	if (transaction == NULL) {
+		return;
+	}
+
+	// Cancelling: apply whatever members already committed so their latched
+	// state isn't lost, without waiting for the rest
+	struct wlr_surface_transaction_entry *entry, *tmp;
+	wl_list_for_each_safe(entry, tmp, &transaction->surfaces, link) {
+		struct wlr_surface *surface = entry->surface;
+		bool has_cache = entry->has_cache;
+		if (has_cache) {
+			surface_state_move(&surface->pending, &entry->cached);
+		}
+		surface_transaction_entry_destroy(entry);
+		if (has_cache) {
+			surface_commit_pending(surface);
+		}
+	}
+
+	free(transaction);
+}
+
 static void subsurface_unmap(struct wlr_subsurface *subsurface);
 
 static void subsurface_destroy(struct wlr_subsurface *subsurface) {
@@ -604,6 +905,7 @@ static void subsurface_destroy(struct wlr_subsurface *subsurface) {
 	surface_state_finish(&subsurface->cached);
 
 	if (subsurface->parent) {
+		surface_invalidate_iter_cache(subsurface->parent);
 		wl_list_remove(&subsurface->parent_link);
 		wl_list_remove(&subsurface->parent_pending_link);
 		wl_list_remove(&subsurface->parent_destroy.link);
@@ -613,7 +915,7 @@ static void subsurface_destroy(struct wlr_subsurface *subsurface) {
 	if (subsurface->surface) {
 		subsurface->surface->role_data = NULL;
 	}
-	free(subsurface);
+	wlr_slab_free(&subsurface_slab, subsurface);
 }
 
 static void surface_output_destroy(struct wlr_surface_output *surface_output);
@@ -634,13 +936,14 @@ static void surface_handle_resource_destroy(struct wl_resource *resource) {
 	surface_state_finish(&surface->pending);
 	surface_state_finish(&surface->current);
 	surface_state_finish(&surface->previous);
+	wl_array_release(&surface->iter_cache);
 	pixman_region32_fini(&surface->buffer_damage);
 	pixman_region32_fini(&surface->opaque_region);
 	pixman_region32_fini(&surface->input_region);
 	if (surface->buffer != NULL) {
 		wlr_buffer_unlock(&surface->buffer->base);
 	}
-	free(surface);
+	wlr_slab_free(&surface_slab, surface);
 }
 
 static void surface_handle_renderer_destroy(struct wl_listener *listener,
@@ -655,7 +958,8 @@ struct wlr_surface *wlr_surface_create(struct wl_client *client,
 		struct wl_list *resource_list) {
 	assert(version <= SURFACE_VERSION);
 
-	struct wlr_surface *surface = calloc(1, sizeof(struct wlr_surface));
+	surface_slabs_init();
+	struct wlr_surface *surface = wlr_slab_alloc(&surface_slab);
 	if (!surface) {
 		wl_client_post_no_memory(client);
 		return NULL;
@@ -663,7 +967,7 @@ struct wlr_surface *wlr_surface_create(struct wl_client *client,
 	surface->resource = wl_resource_create(client, &wl_surface_interface,
 		version, id);
 	if (surface->resource == NULL) {
-		free(surface);
+		wlr_slab_free(&surface_slab, surface);
 		wl_client_post_no_memory(client);
 		return NULL;
 	}
@@ -684,6 +988,7 @@ struct wlr_surface *wlr_surface_create(struct wl_client *client,
 	wl_list_init(&surface->subsurfaces);
 	wl_list_init(&surface->subsurface_pending_list);
 	wl_list_init(&surface->current_outputs);
+	wl_array_init(&surface->iter_cache);
 	pixman_region32_init(&surface->buffer_damage);
 	pixman_region32_init(&surface->opaque_region);
 	pixman_region32_init(&surface->input_region);
@@ -939,20 +1244,23 @@ static void subsurface_role_commit(struct wlr_surface *surface) {
 
 		subsurface->current.x = subsurface->pending.x;
 		subsurface->current.y = subsurface->pending.y;
+		surface_invalidate_iter_cache(subsurface->parent);
 
-		if ((surface->current.transform & WL_OUTPUT_TRANSFORM_90) != 0) {
-			int tmp = dx;
-			dx = dy;
-			dy = tmp;
-		}
-
-		pixman_region32_union_rect(&surface->buffer_damage,
-			&surface->buffer_damage,
-			dx * surface->previous.scale, dy * surface->previous.scale,
-			surface->previous.buffer_width, surface->previous.buffer_height);
-		pixman_region32_union_rect(&surface->buffer_damage,
-			&surface->buffer_damage, 0, 0,
-			surface->current.buffer_width, surface->current.buffer_height);
+		// Damage only the union of the old and new boxes, in surface-local
+		// coordinates relative to the new position, then convert to buffer
+		// coordinates like regular surface damage
+		pixman_region32_t moved;
+		pixman_region32_init_rect(&moved, dx, dy,
+			surface->previous.width, surface->previous.height);
+		pixman_region32_union_rect(&moved, &moved, 0, 0,
+			surface->current.width, surface->current.height);
+		wlr_region_transform(&moved, &moved,
+			wlr_output_transform_invert(surface->current.transform),
+			surface->current.width, surface->current.height);
+		wlr_region_scale(&moved, &moved, surface->current.scale);
+		pixman_region32_union(&surface->buffer_damage,
+			&surface->buffer_damage, &moved);
+		pixman_region32_fini(&moved);
 	}
 
 	subsurface_consider_map(subsurface, true);
@@ -1003,8 +1311,8 @@ struct wlr_subsurface *wlr_subsurface_create(struct wlr_surface *surface,
 
 	struct wl_client *client = wl_resource_get_client(surface->resource);
 
-	struct wlr_subsurface *subsurface =
-		calloc(1, sizeof(struct wlr_subsurface));
+	surface_slabs_init();
+	struct wlr_subsurface *subsurface = wlr_slab_alloc(&subsurface_slab);
 	if (!subsurface) {
 		wl_client_post_no_memory(client);
 		return NULL;
@@ -1016,7 +1324,7 @@ struct wlr_subsurface *wlr_subsurface_create(struct wlr_surface *surface,
 		wl_resource_create(client, &wl_subsurface_interface, version, id);
 	if (subsurface->resource == NULL) {
 		surface_state_finish(&subsurface->cached);
-		free(subsurface);
+		wlr_slab_free(&subsurface_slab, subsurface);
 		wl_client_post_no_memory(client);
 		return NULL;
 	}
@@ -1038,6 +1346,7 @@ struct wlr_subsurface *wlr_subsurface_create(struct wlr_surface *surface,
 	wl_list_insert(parent->subsurfaces.prev, &subsurface->parent_link);
 	wl_list_insert(parent->subsurface_pending_list.prev,
 		&subsurface->parent_pending_link);
+	surface_invalidate_iter_cache(parent);
 
 	surface->role_data = subsurface;
 
@@ -1078,6 +1387,40 @@ bool wlr_surface_point_accepts_input(struct wlr_surface *surface,
 
 struct wlr_surface *wlr_surface_surface_at(struct wlr_surface *surface,
 		double sx, double sy, double *sub_x, double *sub_y) {
+	if (surface_update_iter_cache(surface)) {
+		// Input regions are clipped to their surface's bounds, so a point
+		// outside the tree's bounding box cannot hit anything
+		struct wlr_box *extent = &surface->iter_extent;
+		if (sx < extent->x || sy < extent->y ||
+				sx >= extent->x + extent->width ||
+				sy >= extent->y + extent->height) {
+			return NULL;
+		}
+
+		// Walk the flattened list backwards, i.e. top-down in z-order
+		struct surface_iter_entry *entries = surface->iter_cache.data;
+		size_t entries_len =
+			surface->iter_cache.size / sizeof(struct surface_iter_entry);
+		for (size_t i = entries_len; i > 0; --i) {
+			struct surface_iter_entry *entry = &entries[i - 1];
+			double _sub_x = sx - entry->x;
+			double _sub_y = sy - entry->y;
+			if (wlr_surface_point_accepts_input(entry->surface,
+					_sub_x, _sub_y)) {
+				if (sub_x) {
+					*sub_x = _sub_x;
+				}
+				if (sub_y) {
+					*sub_y = _sub_y;
+				}
+				return entry->surface;
+			}
+		}
+
+		return NULL;
+	}
+
+	// Allocation failure: fall back to walking the tree
 	struct wlr_subsurface *subsurface;
 	wl_list_for_each_reverse(subsurface, &surface->subsurfaces, parent_link) {
 		double _sub_x = subsurface->current.x;
@@ -1182,6 +1525,29 @@ void wlr_surface_send_leave(struct wlr_surface *surface,
 	}
 }
 
+void wlr_surface_set_occluded(struct wlr_surface *surface, bool occluded) {
+	if (surface->occluded != occluded) {
+		surface->occluded = occluded;
+
+		if (!occluded && surface->texture_upload_pending &&
+				surface->current.buffer_resource != NULL) {
+			// Damage tracked while hidden only covers the last commit:
+			// upload the full buffer
+			pixman_region32_union_rect(&surface->buffer_damage,
+				&surface->buffer_damage, 0, 0,
+				surface->current.buffer_width,
+				surface->current.buffer_height);
+			surface_apply_damage(surface);
+			surface_update_opaque_region(surface);
+		}
+	}
+
+	struct wlr_subsurface *subsurface;
+	wl_list_for_each(subsurface, &surface->subsurfaces, parent_link) {
+		wlr_surface_set_occluded(subsurface->surface, occluded);
+	}
+}
+
 void wlr_surface_send_frame_done(struct wlr_surface *surface,
 		const struct timespec *when) {
 	struct wl_resource *resource, *tmp;
@@ -1192,6 +1558,45 @@ void wlr_surface_send_frame_done(struct wlr_surface *surface,
 	}
 }
 
+// Frame callbacks queued by wlr_surface_queue_frame_done, lazily initialized
+static struct wl_list deferred_frame_callbacks;
+static uint32_t deferred_frame_time_msec;
+
+void wlr_surface_queue_frame_done(struct wlr_surface *surface,
+		const struct timespec *when) {
+	if (deferred_frame_callbacks.next == NULL) {
+		wl_list_init(&deferred_frame_callbacks);
+	}
+	deferred_frame_time_msec = timespec_to_msec(when);
+
+	struct wl_resource *resource, *tmp;
+	wl_resource_for_each_safe(resource, tmp,
+			&surface->current.frame_callback_list) {
+		wl_list_remove(wl_resource_get_link(resource));
+		wl_list_insert(deferred_frame_callbacks.prev,
+			wl_resource_get_link(resource));
+	}
+}
+
+void wlr_surface_flush_frame_done(struct wl_display *display) {
+	if (deferred_frame_callbacks.next == NULL ||
+			wl_list_empty(&deferred_frame_callbacks)) {
+		return;
+	}
+
+	struct wl_resource *resource, *tmp;
+	wl_resource_for_each_safe(resource, tmp, &deferred_frame_callbacks) {
+		wl_callback_send_done(resource, deferred_frame_time_msec);
+		wl_resource_destroy(resource);
+	}
+
+	// Each client's buffered events leave in one write at the end of the
+	// dispatch turn, shared with any other pending senders
+	if (display != NULL) {
+		flush_clients_soon(display);
+	}
+}
+
 static void surface_for_each_surface(struct wlr_surface *surface, int x, int y,
 		wlr_surface_iterator_func_t iterator, void *user_data) {
 	iterator(surface, x, y, user_data);
@@ -1207,9 +1612,71 @@ static void surface_for_each_surface(struct wlr_surface *surface, int x, int y,
 	}
 }
 
+static bool surface_iter_cache_add(struct wlr_surface *root,
+		struct wlr_surface *surface, int x, int y) {
+	struct surface_iter_entry *entry =
+		wl_array_add(&root->iter_cache, sizeof(*entry));
+	if (entry == NULL) {
+		return false;
+	}
+	entry->surface = surface;
+	entry->x = x;
+	entry->y = y;
+
+	struct wlr_subsurface *subsurface;
+	wl_list_for_each(subsurface, &surface->subsurfaces, parent_link) {
+		struct wlr_subsurface_state *state = &subsurface->current;
+		if (!surface_iter_cache_add(root, subsurface->surface,
+				x + state->x, y + state->y)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool surface_update_iter_cache(struct wlr_surface *surface) {
+	if (surface->iter_cache_valid) {
+		return true;
+	}
+
+	surface->iter_cache.size = 0;
+	if (!surface_iter_cache_add(surface, surface, 0, 0)) {
+		return false;
+	}
+
+	int32_t min_x = 0, min_y = 0;
+	int32_t max_x = surface->current.width;
+	int32_t max_y = surface->current.height;
+	struct surface_iter_entry *entry;
+	wl_array_for_each(entry, &surface->iter_cache) {
+		min_x = min(entry->x, min_x);
+		min_y = min(entry->y, min_y);
+		max_x = max(entry->x + entry->surface->current.width, max_x);
+		max_y = max(entry->y + entry->surface->current.height, max_y);
+	}
+	surface->iter_extent = (struct wlr_box){
+		.x = min_x,
+		.y = min_y,
+		.width = max_x - min_x,
+		.height = max_y - min_y,
+	};
+
+	surface->iter_cache_valid = true;
+	return true;
+}
+
 void wlr_surface_for_each_surface(struct wlr_surface *surface,
 		wlr_surface_iterator_func_t iterator, void *user_data) {
-	surface_for_each_surface(surface, 0, 0, iterator, user_data);
+	if (!surface_update_iter_cache(surface)) {
+		// Allocation failure: fall back to walking the tree
+		surface_for_each_surface(surface, 0, 0, iterator, user_data);
+		return;
+	}
+
+	struct surface_iter_entry *entry;
+	wl_array_for_each(entry, &surface->iter_cache) {
+		iterator(entry->surface, entry->x, entry->y, user_data);
+	}
 }
 
 struct bound_acc {
@@ -1229,6 +1696,11 @@ static void handle_bounding_box_surface(struct wlr_surface *surface,
 }
 
 void wlr_surface_get_extends(struct wlr_surface *surface, struct wlr_box *box) {
+	if (surface_update_iter_cache(surface)) {
+		*box = surface->iter_extent;
+		return;
+	}
+
 	struct bound_acc acc = {
 		.min_x = 0,
 		.min_y = 0,
@@ -1303,23 +1775,5 @@ void wlr_surface_get_effective_damage(struct wlr_surface *surface,
 
 void wlr_surface_get_buffer_source_box(struct wlr_surface *surface,
 		struct wlr_fbox *box) {
-	box->x = box->y = 0;
-	box->width = surface->current.buffer_width;
-	box->height = surface->current.buffer_height;
-
-	if (surface->current.viewport.has_src) {
-		box->x = surface->current.viewport.src.x * surface->current.scale;
-		box->y = surface->current.viewport.src.y * surface->current.scale;
-		box->width = surface->current.viewport.src.width * surface->current.scale;
-		box->height = surface->current.viewport.src.height * surface->current.scale;
-		if ((surface->current.transform & WL_OUTPUT_TRANSFORM_90) != 0) {
-			double tmp = box->x;
-			box->x = box->y;
-			box->y = tmp;
-
-			tmp = box->width;
-			box->width = box->height;
-			box->height = tmp;
-		}
-	}
+	*box = surface->current.buffer_src_box;
 }
@@ -60,12 +60,43 @@ void wlr_text_input_v3_send_delete_surrounding_text(
 }
 
 void wlr_text_input_v3_send_done(struct wlr_text_input_v3 *text_input) {
+	if (text_input->done_idle != NULL) {
+		// An explicit done supersedes the scheduled one
+		wl_event_source_remove(text_input->done_idle);
+		text_input->done_idle = NULL;
+	}
 	zwp_text_input_v3_send_done(text_input->resource,
 		text_input->current_serial);
 }
 
+static void text_input_handle_done_idle(void *data) {
+	struct wlr_text_input_v3 *text_input = data;
+	text_input->done_idle = NULL;
+	wlr_text_input_v3_send_done(text_input);
+}
+
+void wlr_text_input_v3_schedule_done(struct wlr_text_input_v3 *text_input) {
+	if (text_input->done_idle != NULL) {
+		// Already scheduled: the pending done covers this update too
+		return;
+	}
+	struct wl_client *client = wl_resource_get_client(text_input->resource);
+	struct wl_event_loop *loop =
+		wl_display_get_event_loop(wl_client_get_display(client));
+	text_input->done_idle = wl_event_loop_add_idle(loop,
+		text_input_handle_done_idle, text_input);
+	if (text_input->done_idle == NULL) {
+		// Better an extra done than a dropped one
+		wlr_text_input_v3_send_done(text_input);
+	}
+}
+
 static void wlr_text_input_destroy(struct wlr_text_input_v3 *text_input) {
 	wlr_signal_emit_safe(&text_input->events.destroy, text_input);
+	if (text_input->done_idle != NULL) {
+		wl_event_source_remove(text_input->done_idle);
+		text_input->done_idle = NULL;
+	}
 	text_input_clear_focused_surface(text_input);
 	wl_list_remove(&text_input->seat_destroy.link);
 	// remove from manager::text_inputs
@@ -49,6 +49,40 @@ static void virtual_pointer_motion(struct wl_client *client,
 	wlr_signal_emit_safe(&wlr_dev->pointer->events.motion, &event);
 }
 
+static void virtual_pointer_motion_batch(struct wl_client *client,
+		struct wl_resource *resource, struct wl_array *motions) {
+	// Three 32-bit words per motion: time, then dx and dy as wl_fixed
+	const size_t motion_size = 3 * sizeof(uint32_t);
+	if (motions->size % motion_size != 0) {
+		wl_resource_post_error(resource,
+				ZWLR_VIRTUAL_POINTER_V1_ERROR_INVALID_BATCH,
+				"Batch size %zu is not a multiple of one motion (%zu bytes)",
+				motions->size, motion_size);
+		return;
+	}
+	struct wlr_virtual_pointer_v1 *pointer =
+		virtual_pointer_from_resource(resource);
+	if (pointer == NULL) {
+		return;
+	}
+	struct wlr_input_device *wlr_dev = &pointer->input_device;
+	const uint32_t *words = motions->data;
+	size_t len = motions->size / sizeof(uint32_t);
+	for (size_t i = 0; i < len; i += 3) {
+		double dx = wl_fixed_to_double((wl_fixed_t)words[i + 1]);
+		double dy = wl_fixed_to_double((wl_fixed_t)words[i + 2]);
+		struct wlr_event_pointer_motion event = {
+			.device = wlr_dev,
+			.time_msec = words[i],
+			.delta_x = dx,
+			.delta_y = dy,
+			.unaccel_dx = dx,
+			.unaccel_dy = dy,
+		};
+		wlr_signal_emit_safe(&wlr_dev->pointer->events.motion, &event);
+	}
+}
+
 static void virtual_pointer_motion_absolute(struct wl_client *client,
 		struct wl_resource *resource, uint32_t time, uint32_t x, uint32_t y,
 		uint32_t x_extent, uint32_t y_extent) {
@@ -223,6 +257,7 @@ static const struct zwlr_virtual_pointer_v1_interface virtual_pointer_impl = {
 	.axis_stop = virtual_pointer_axis_stop,
 	.axis_discrete = virtual_pointer_axis_discrete,
 	.destroy = virtual_pointer_destroy,
+	.motion_batch = virtual_pointer_motion_batch,
 };
 
 static const struct zwlr_virtual_pointer_manager_v1_interface manager_impl;
@@ -355,7 +390,7 @@ struct wlr_virtual_pointer_manager_v1* wlr_virtual_pointer_manager_v1_create(
 	wl_signal_init(&manager->events.new_virtual_pointer);
 	wl_signal_init(&manager->events.destroy);
 	manager->global = wl_global_create(display,
-		&zwlr_virtual_pointer_manager_v1_interface, 2, manager,
+		&zwlr_virtual_pointer_manager_v1_interface, 3, manager,
 		virtual_pointer_manager_bind);
 	if (!manager->global) {
 		free(manager);
@@ -25,13 +25,61 @@ void wlr_xcursor_manager_destroy(struct wlr_xcursor_manager *manager) {
 	struct wlr_xcursor_manager_theme *theme, *tmp;
 	wl_list_for_each_safe(theme, tmp, &manager->scaled_themes, link) {
 		wl_list_remove(&theme->link);
-		wlr_xcursor_theme_destroy(theme->theme);
+		// Entries may share one decoded theme, destroy it with its last
+		// entry only
+		bool shared = false;
+		struct wlr_xcursor_manager_theme *other;
+		wl_list_for_each(other, &manager->scaled_themes, link) {
+			if (other->theme == theme->theme) {
+				shared = true;
+				break;
+			}
+		}
+		if (!shared) {
+			wlr_xcursor_theme_destroy(theme->theme);
+		}
 		free(theme);
 	}
 	free(manager->name);
 	free(manager);
 }
 
+/**
+ * Returns true when both themes decoded to identical cursors. Cursor files
+ * store a discrete set of sizes and nearby requested sizes often select the
+ * same stored images, so themes loaded for different output scales are
+ * frequently bit-for-bit duplicates.
+ */
+static bool xcursor_theme_equal(struct wlr_xcursor_theme *a,
+		struct wlr_xcursor_theme *b) {
+	if (a->cursor_count != b->cursor_count) {
+		return false;
+	}
+	for (unsigned int i = 0; i < a->cursor_count; ++i) {
+		struct wlr_xcursor *ca = a->cursors[i];
+		struct wlr_xcursor *cb = b->cursors[i];
+		if (strcmp(ca->name, cb->name) != 0 ||
+				ca->image_count != cb->image_count) {
+			return false;
+		}
+		for (unsigned int j = 0; j < ca->image_count; ++j) {
+			struct wlr_xcursor_image *ia = ca->images[j];
+			struct wlr_xcursor_image *ib = cb->images[j];
+			if (ia->width != ib->width || ia->height != ib->height ||
+					ia->hotspot_x != ib->hotspot_x ||
+					ia->hotspot_y != ib->hotspot_y ||
+					ia->delay != ib->delay) {
+				return false;
+			}
+			if (memcmp(ia->buffer, ib->buffer,
+					(size_t)ia->width * ia->height * 4) != 0) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
 bool wlr_xcursor_manager_load(struct wlr_xcursor_manager *manager,
 		float scale) {
 	struct wlr_xcursor_manager_theme *theme;
@@ -46,11 +94,39 @@ bool wlr_xcursor_manager_load(struct wlr_xcursor_manager *manager,
 		return false;
 	}
 	theme->scale = scale;
-	theme->theme = wlr_xcursor_theme_load(manager->name, manager->size * scale);
+
+	// Share the decoded images with a scale that needs the same pixel size
+	struct wlr_xcursor_manager_theme *existing;
+	wl_list_for_each(existing, &manager->scaled_themes, link) {
+		if ((int)(manager->size * existing->scale) ==
+				(int)(manager->size * scale)) {
+			theme->theme = existing->theme;
+			break;
+		}
+	}
+
 	if (theme->theme == NULL) {
-		free(theme);
-		return false;
+		theme->theme =
+			wlr_xcursor_theme_load(manager->name, manager->size * scale);
+		if (theme->theme == NULL) {
+			free(theme);
+			return false;
+		}
+		// A different requested size may still have selected the same stored
+		// images (themes rarely ship every size): dedupe the decoded copies.
+		// Lazily loaded themes only hold the shapes used so far, so their
+		// remaining shapes can't be compared yet; share fully decoded
+		// (embedded fallback) themes only.
+		wl_list_for_each(existing, &manager->scaled_themes, link) {
+			if (!existing->theme->lazy && !theme->theme->lazy &&
+					xcursor_theme_equal(existing->theme, theme->theme)) {
+				wlr_xcursor_theme_destroy(theme->theme);
+				theme->theme = existing->theme;
+				break;
+			}
+		}
 	}
+
 	wl_list_insert(&manager->scaled_themes, &theme->link);
 	return true;
 }
@@ -1,18 +1,39 @@
 #include <wlr/types/wlr_xdg_foreign_registry.h>
+#include "util/map.h"
 #include "util/signal.h"
 #include "util/uuid.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
+// FNV-1a. Handles are imported by string, so hash the whole handle into the
+// map's key space; exported_init keeps these hashes unique per registry.
+static uint32_t handle_hash(const char *handle) {
+	uint32_t hash = 2166136261u;
+	for (const char *p = handle; *p != '\0'; ++p) {
+		hash = (hash ^ (uint8_t)*p) * 16777619u;
+	}
+	return hash;
+}
+
 bool wlr_xdg_foreign_exported_init(
 		struct wlr_xdg_foreign_exported *exported,
 		struct wlr_xdg_foreign_registry *registry) {
+	uint32_t hash;
 	do {
 		if (!generate_uuid(exported->handle)) {
 			return false;
 		}
-	} while (wlr_xdg_foreign_registry_find_by_handle(registry, exported->handle) != NULL);
+		hash = handle_hash(exported->handle);
+		// Zero marks an empty map slot; a hash collision would make two
+		// handles share an index entry. Both are cheap to dodge by
+		// drawing another UUID.
+	} while (hash == 0 ||
+		wlr_map_get(registry->exported_by_handle, hash) != NULL);
+
+	if (!wlr_map_insert(registry->exported_by_handle, hash, exported)) {
+		return false;
+	}
 
 	exported->registry = registry;
 	wl_list_insert(&registry->exported_surfaces, &exported->link);
@@ -27,18 +48,21 @@ struct wlr_xdg_foreign_exported *wlr_xdg_foreign_registry_find_by_handle(
 		return NULL;
 	}
 
-	struct wlr_xdg_foreign_exported *exported;
-	wl_list_for_each(exported, &registry->exported_surfaces, link) {
-		if (strcmp(handle, exported->handle) == 0) {
-			return exported;
-		}
+	struct wlr_xdg_foreign_exported *exported =
+		wlr_map_get(registry->exported_by_handle, handle_hash(handle));
+	if (exported == NULL || strcmp(handle, exported->handle) != 0) {
+		// Hashes are unique within the registry, so a string mismatch
+		// means no exported surface carries this handle
+		return NULL;
 	}
 
-	return NULL;
+	return exported;
 }
 
 void wlr_xdg_foreign_exported_finish(struct wlr_xdg_foreign_exported *surface) {
 	wlr_signal_emit_safe(&surface->events.destroy, NULL);
+	wlr_map_remove(surface->registry->exported_by_handle,
+		handle_hash(surface->handle));
 	surface->registry = NULL;
 	wl_list_remove(&surface->link);
 	wl_list_init(&surface->link);
@@ -53,6 +77,8 @@ static void foreign_registry_handle_display_destroy(struct wl_listener *listener
 
 	// Implementations are supposed to remove all surfaces
 	assert(wl_list_empty(&registry->exported_surfaces));
+	wlr_map_finish(registry->exported_by_handle);
+	free(registry->exported_by_handle);
 	free(registry);
 }
 
@@ -64,6 +90,14 @@ struct wlr_xdg_foreign_registry *wlr_xdg_foreign_registry_create(
 		return NULL;
 	}
 
+	registry->exported_by_handle =
+		calloc(1, sizeof(*registry->exported_by_handle));
+	if (!registry->exported_by_handle) {
+		free(registry);
+		return NULL;
+	}
+	wlr_map_init(registry->exported_by_handle);
+
 	registry->display_destroy.notify = foreign_registry_handle_display_destroy;
 	wl_display_add_destroy_listener(display, &registry->display_destroy);
 
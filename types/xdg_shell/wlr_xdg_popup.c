@@ -551,15 +551,54 @@ static bool xdg_popup_unconstrain_resize(struct wlr_xdg_popup *popup,
 	return !offset_x && !offset_y;
 }
 
+static bool box_equal(const struct wlr_box *a, const struct wlr_box *b) {
+	return a->x == b->x && a->y == b->y &&
+		a->width == b->width && a->height == b->height;
+}
+
+static bool positioner_equal(const struct wlr_xdg_positioner *a,
+		const struct wlr_xdg_positioner *b) {
+	return box_equal(&a->anchor_rect, &b->anchor_rect) &&
+		a->anchor == b->anchor && a->gravity == b->gravity &&
+		a->constraint_adjustment == b->constraint_adjustment &&
+		a->size.width == b->size.width && a->size.height == b->size.height &&
+		a->offset.x == b->offset.x && a->offset.y == b->offset.y;
+}
+
 void wlr_xdg_popup_unconstrain_from_box(struct wlr_xdg_popup *popup,
 		const struct wlr_box *toplevel_sx_box) {
-	if (xdg_popup_unconstrain_flip(popup, toplevel_sx_box)) {
-		return;
-	}
-	if (xdg_popup_unconstrain_slide(popup, toplevel_sx_box)) {
+	// The solve also depends on where the parent chain places the popup in
+	// toplevel coordinates; capture that as part of the cache key
+	int parent_sx = 0, parent_sy = 0;
+	wlr_xdg_popup_get_toplevel_coords(popup, 0, 0, &parent_sx, &parent_sy);
+
+	if (popup->unconstrain_cache.valid &&
+			positioner_equal(&popup->unconstrain_cache.input_positioner,
+				&popup->positioner) &&
+			box_equal(&popup->unconstrain_cache.input_geometry,
+				&popup->geometry) &&
+			box_equal(&popup->unconstrain_cache.constraint_box,
+				toplevel_sx_box) &&
+			popup->unconstrain_cache.parent_sx == parent_sx &&
+			popup->unconstrain_cache.parent_sy == parent_sy) {
+		popup->positioner = popup->unconstrain_cache.solved_positioner;
+		popup->geometry = popup->unconstrain_cache.solved_geometry;
 		return;
 	}
-	if (xdg_popup_unconstrain_resize(popup, toplevel_sx_box)) {
-		return;
+
+	// The solve mutates the positioner (flips), so record the inputs first
+	popup->unconstrain_cache.input_positioner = popup->positioner;
+	popup->unconstrain_cache.input_geometry = popup->geometry;
+	popup->unconstrain_cache.constraint_box = *toplevel_sx_box;
+	popup->unconstrain_cache.parent_sx = parent_sx;
+	popup->unconstrain_cache.parent_sy = parent_sy;
+
+	if (!xdg_popup_unconstrain_flip(popup, toplevel_sx_box) &&
+			!xdg_popup_unconstrain_slide(popup, toplevel_sx_box)) {
+		xdg_popup_unconstrain_resize(popup, toplevel_sx_box);
 	}
+
+	popup->unconstrain_cache.solved_positioner = popup->positioner;
+	popup->unconstrain_cache.solved_geometry = popup->geometry;
+	popup->unconstrain_cache.valid = true;
 }
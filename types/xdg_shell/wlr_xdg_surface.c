@@ -4,6 +4,28 @@
 #include <wlr/util/log.h>
 #include "types/wlr_xdg_shell.h"
 #include "util/signal.h"
+#include "util/slab.h"
+
+// Configures churn on every interactive resize frame; slabs keep them and
+// their toplevel state off the general-purpose allocator
+static struct wlr_slab configure_slab;
+static struct wlr_slab toplevel_state_slab;
+static bool configure_slabs_initialized = false;
+
+static void configure_slabs_init(void) {
+	if (!configure_slabs_initialized) {
+		wlr_slab_init(&configure_slab,
+			sizeof(struct wlr_xdg_surface_configure));
+		wlr_slab_init(&toplevel_state_slab,
+			sizeof(struct wlr_xdg_toplevel_state));
+		configure_slabs_initialized = true;
+	}
+}
+
+struct wlr_slab *xdg_toplevel_state_slab(void) {
+	configure_slabs_init();
+	return &toplevel_state_slab;
+}
 
 bool wlr_surface_is_xdg_surface(struct wlr_surface *surface) {
 	return surface->role == &xdg_toplevel_surface_role ||
@@ -22,8 +44,8 @@ static void xdg_surface_configure_destroy(
 		return;
 	}
 	wl_list_remove(&configure->link);
-	free(configure->toplevel_state);
-	free(configure);
+	wlr_slab_free(&toplevel_state_slab, configure->toplevel_state);
+	wlr_slab_free(&configure_slab, configure);
 }
 
 void unmap_xdg_surface(struct wlr_xdg_surface *surface) {
@@ -90,6 +112,7 @@ void unmap_xdg_surface(struct wlr_xdg_surface *surface) {
 	surface->has_next_geometry = false;
 	memset(&surface->geometry, 0, sizeof(struct wlr_box));
 	memset(&surface->next_geometry, 0, sizeof(struct wlr_box));
+	surface->cached_geometry_valid = false;
 }
 
 
@@ -154,8 +177,9 @@ static void surface_send_configure(void *user_data) {
 
 	surface->configure_idle = NULL;
 
+	configure_slabs_init();
 	struct wlr_xdg_surface_configure *configure =
-		calloc(1, sizeof(struct wlr_xdg_surface_configure));
+		wlr_slab_alloc(&configure_slab);
 	if (configure == NULL) {
 		wl_client_post_no_memory(surface->client->client);
 		return;
@@ -359,6 +383,7 @@ void handle_xdg_surface_commit(struct wlr_surface *wlr_surface) {
 		surface->geometry.y = surface->next_geometry.y;
 		surface->geometry.width = surface->next_geometry.width;
 		surface->geometry.height = surface->next_geometry.height;
+		surface->cached_geometry_valid = false;
 	}
 
 	switch (surface->role) {
@@ -487,6 +512,11 @@ void reset_xdg_surface(struct wlr_xdg_surface *xdg_surface) {
 		wl_resource_set_user_data(xdg_surface->toplevel->resource, NULL);
 		xdg_surface->toplevel->resource = NULL;
 
+		if (xdg_surface->toplevel->resize_throttle.timer != NULL) {
+			wl_event_source_remove(xdg_surface->toplevel->resize_throttle.timer);
+			xdg_surface->toplevel->resize_throttle.timer = NULL;
+		}
+
 		if (xdg_surface->toplevel->client_pending.fullscreen_output) {
 			struct wlr_xdg_toplevel_state *client_pending =
 				&xdg_surface->toplevel->client_pending;
@@ -666,11 +696,23 @@ void wlr_xdg_surface_for_each_popup_surface(struct wlr_xdg_surface *surface,
 
 void wlr_xdg_surface_get_geometry(struct wlr_xdg_surface *surface,
 		struct wlr_box *box) {
-	wlr_surface_get_extends(surface->surface, box);
-	/* The client never set the geometry */
-	if (!surface->geometry.width) {
+	/* Compositors query the geometry several times per frame for every
+	 * mapped toplevel: recompute it only when the surface extents or the
+	 * set_window_geometry rectangle actually changed */
+	if (surface->cached_geometry_valid &&
+			surface->cached_geometry_generation ==
+			surface->surface->iter_generation) {
+		*box = surface->cached_geometry;
 		return;
 	}
 
-	wlr_box_intersection(box, &surface->geometry, box);
+	wlr_surface_get_extends(surface->surface, box);
+	/* Only intersect if the client ever set the geometry */
+	if (surface->geometry.width) {
+		wlr_box_intersection(box, &surface->geometry, box);
+	}
+
+	surface->cached_geometry = *box;
+	surface->cached_geometry_generation = surface->surface->iter_generation;
+	surface->cached_geometry_valid = true;
 }
@@ -6,6 +6,29 @@
 #include <wlr/util/edges.h>
 #include "types/wlr_xdg_shell.h"
 #include "util/signal.h"
+#include "util/slab.h"
+
+static void toplevel_throttle_flush(struct wlr_xdg_surface *surface) {
+	struct wlr_xdg_toplevel *toplevel = surface->toplevel;
+
+	toplevel->resize_throttle.size_pending = false;
+	schedule_xdg_surface_configure(surface);
+
+	toplevel->resize_throttle.armed = true;
+	wl_event_source_timer_update(toplevel->resize_throttle.timer,
+		toplevel->resize_throttle.interval_msec);
+}
+
+static int toplevel_throttle_handle_timer(void *data) {
+	struct wlr_xdg_surface *surface = data;
+	struct wlr_xdg_toplevel *toplevel = surface->toplevel;
+
+	toplevel->resize_throttle.armed = false;
+	if (toplevel->resize_throttle.size_pending) {
+		toplevel_throttle_flush(surface);
+	}
+	return 0;
+}
 
 void handle_xdg_toplevel_ack_configure(
 		struct wlr_xdg_surface *surface,
@@ -14,6 +37,12 @@ void handle_xdg_toplevel_ack_configure(
 	assert(configure->toplevel_state != NULL);
 
 	surface->toplevel->last_acked = *configure->toplevel_state;
+
+	if (surface->toplevel->resize_throttle.size_pending) {
+		// The client keeps up: let its ack, not the timer, pace the next
+		// configure
+		toplevel_throttle_flush(surface);
+	}
 }
 
 bool compare_xdg_surface_toplevel_state(struct wlr_xdg_toplevel *state) {
@@ -65,7 +94,7 @@ void send_xdg_toplevel_configure(struct wlr_xdg_surface *surface,
 		struct wlr_xdg_surface_configure *configure) {
 	assert(surface->role == WLR_XDG_SURFACE_ROLE_TOPLEVEL);
 
-	configure->toplevel_state = malloc(sizeof(*configure->toplevel_state));
+	configure->toplevel_state = wlr_slab_alloc(xdg_toplevel_state_slab());
 	if (configure->toplevel_state == NULL) {
 		wlr_log(WLR_ERROR, "Allocation failed");
 		wl_resource_post_no_memory(surface->toplevel->resource);
@@ -547,12 +576,58 @@ void destroy_xdg_toplevel(struct wlr_xdg_surface *xdg_surface) {
 uint32_t wlr_xdg_toplevel_set_size(struct wlr_xdg_surface *surface,
 		uint32_t width, uint32_t height) {
 	assert(surface->role == WLR_XDG_SURFACE_ROLE_TOPLEVEL);
-	surface->toplevel->server_pending.width = width;
-	surface->toplevel->server_pending.height = height;
+	struct wlr_xdg_toplevel *toplevel = surface->toplevel;
+	toplevel->server_pending.width = width;
+	toplevel->server_pending.height = height;
+
+	if (toplevel->resize_throttle.enabled) {
+		if (toplevel->resize_throttle.armed) {
+			// A configure already went out this interval: remember that a
+			// newer size exists, the timer or the client's ack sends it
+			toplevel->resize_throttle.size_pending = true;
+			return 0;
+		}
+		toplevel->resize_throttle.armed = true;
+		wl_event_source_timer_update(toplevel->resize_throttle.timer,
+			toplevel->resize_throttle.interval_msec);
+	}
 
 	return schedule_xdg_surface_configure(surface);
 }
 
+void wlr_xdg_toplevel_set_size_throttle(struct wlr_xdg_surface *surface,
+		int interval_msec) {
+	assert(surface->role == WLR_XDG_SURFACE_ROLE_TOPLEVEL);
+	struct wlr_xdg_toplevel *toplevel = surface->toplevel;
+
+	if (interval_msec <= 0) {
+		toplevel->resize_throttle.enabled = false;
+		toplevel->resize_throttle.armed = false;
+		if (toplevel->resize_throttle.timer != NULL) {
+			wl_event_source_timer_update(toplevel->resize_throttle.timer, 0);
+		}
+		if (toplevel->resize_throttle.size_pending) {
+			toplevel->resize_throttle.size_pending = false;
+			schedule_xdg_surface_configure(surface);
+		}
+		return;
+	}
+
+	if (toplevel->resize_throttle.timer == NULL) {
+		struct wl_display *display =
+			wl_client_get_display(surface->client->client);
+		struct wl_event_loop *loop = wl_display_get_event_loop(display);
+		toplevel->resize_throttle.timer = wl_event_loop_add_timer(loop,
+			toplevel_throttle_handle_timer, surface);
+		if (toplevel->resize_throttle.timer == NULL) {
+			wlr_log(WLR_ERROR, "Failed to create resize throttle timer");
+			return;
+		}
+	}
+	toplevel->resize_throttle.interval_msec = interval_msec;
+	toplevel->resize_throttle.enabled = true;
+}
+
 uint32_t wlr_xdg_toplevel_set_activated(struct wlr_xdg_surface *surface,
 		bool activated) {
 	assert(surface->role == WLR_XDG_SURFACE_ROLE_TOPLEVEL);
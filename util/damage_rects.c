@@ -0,0 +1,123 @@
+#include <pixman.h>
+#include <stdint.h>
+#include <wlr/util/damage_rects.h>
+
+// Fixed repaint overhead of one extra rectangle, in pixels: merging two
+// rectangles is worthwhile as long as it wastes no more area than this.
+// Matches the per-rect cost wlr_output_damage uses when simplifying regions.
+#define DAMAGE_RECTS_MERGE_SLACK 1024
+
+static int64_t box_area(const pixman_box32_t *box) {
+	return (int64_t)(box->x2 - box->x1) * (box->y2 - box->y1);
+}
+
+static bool box_contains(const pixman_box32_t *a, const pixman_box32_t *b) {
+	return a->x1 <= b->x1 && a->y1 <= b->y1 &&
+		a->x2 >= b->x2 && a->y2 >= b->y2;
+}
+
+static pixman_box32_t box_union(const pixman_box32_t *a,
+		const pixman_box32_t *b) {
+	return (pixman_box32_t){
+		.x1 = a->x1 < b->x1 ? a->x1 : b->x1,
+		.y1 = a->y1 < b->y1 ? a->y1 : b->y1,
+		.x2 = a->x2 > b->x2 ? a->x2 : b->x2,
+		.y2 = a->y2 > b->y2 ? a->y2 : b->y2,
+	};
+}
+
+// Extra area the merged bounding box repaints compared to repainting the two
+// inputs separately. Negative when the inputs overlap by more than the merge
+// adds, i.e. when merging actually shrinks the repaint.
+static int64_t merge_waste(const pixman_box32_t *a, const pixman_box32_t *b) {
+	pixman_box32_t u = box_union(a, b);
+
+	int64_t overlap = 0;
+	int32_t ix1 = a->x1 > b->x1 ? a->x1 : b->x1;
+	int32_t iy1 = a->y1 > b->y1 ? a->y1 : b->y1;
+	int32_t ix2 = a->x2 < b->x2 ? a->x2 : b->x2;
+	int32_t iy2 = a->y2 < b->y2 ? a->y2 : b->y2;
+	if (ix2 > ix1 && iy2 > iy1) {
+		overlap = (int64_t)(ix2 - ix1) * (iy2 - iy1);
+	}
+
+	return box_area(&u) + overlap - box_area(a) - box_area(b);
+}
+
+// Drops rectangles covered by the rectangle at idx, which has just grown
+static void damage_rects_compact(struct wlr_damage_rects *rects, int idx) {
+	for (int i = rects->len - 1; i >= 0; --i) {
+		if (i == idx || !box_contains(&rects->rects[idx], &rects->rects[i])) {
+			continue;
+		}
+		rects->rects[i] = rects->rects[--rects->len];
+		if (idx == rects->len) {
+			// The grown rectangle was moved into the freed slot
+			idx = i;
+		}
+	}
+}
+
+void wlr_damage_rects_clear(struct wlr_damage_rects *rects) {
+	rects->len = 0;
+}
+
+bool wlr_damage_rects_empty(const struct wlr_damage_rects *rects) {
+	return rects->len == 0;
+}
+
+void wlr_damage_rects_add(struct wlr_damage_rects *rects,
+		int x1, int y1, int x2, int y2) {
+	if (x2 <= x1 || y2 <= y1) {
+		return;
+	}
+	pixman_box32_t box = {.x1 = x1, .y1 = y1, .x2 = x2, .y2 = y2};
+
+	int best = -1;
+	int64_t best_waste = INT64_MAX;
+	for (int i = 0; i < rects->len; ++i) {
+		if (box_contains(&rects->rects[i], &box)) {
+			return;
+		}
+		int64_t waste = merge_waste(&rects->rects[i], &box);
+		if (waste < best_waste) {
+			best_waste = waste;
+			best = i;
+		}
+	}
+
+	// Merge-on-insert when the cheapest merge is near-free, and always once
+	// the rectangle budget is exhausted
+	if (best >= 0 && (best_waste <= DAMAGE_RECTS_MERGE_SLACK ||
+			rects->len == WLR_DAMAGE_RECTS_CAP)) {
+		rects->rects[best] = box_union(&rects->rects[best], &box);
+		damage_rects_compact(rects, best);
+		return;
+	}
+
+	rects->rects[rects->len++] = box;
+}
+
+void wlr_damage_rects_add_region(struct wlr_damage_rects *rects,
+		pixman_region32_t *region) {
+	int n_rects;
+	pixman_box32_t *boxes = pixman_region32_rectangles(region, &n_rects);
+	for (int i = 0; i < n_rects; ++i) {
+		wlr_damage_rects_add(rects, boxes[i].x1, boxes[i].y1,
+			boxes[i].x2, boxes[i].y2);
+	}
+}
+
+void wlr_damage_rects_union_into(const struct wlr_damage_rects *rects,
+		pixman_region32_t *dst) {
+	if (rects->len == 0) {
+		return;
+	}
+
+	// init_rects normalizes the possibly-overlapping rectangles into the
+	// banded representation in one pass
+	pixman_region32_t region;
+	pixman_region32_init_rects(&region, rects->rects, rects->len);
+	pixman_region32_union(dst, dst, &region);
+	pixman_region32_fini(&region);
+}
@@ -0,0 +1,75 @@
+#include <stdlib.h>
+#include <wayland-server-core.h>
+#include "util/flush.h"
+
+struct flush_state {
+	struct wl_display *display;
+	struct wl_event_source *idle; // NULL when no flush pass is scheduled
+
+	struct wl_list link; // flush_states
+	struct wl_listener display_destroy;
+};
+
+static struct wl_list flush_states; // flush_state.link, lazily initialized
+
+static void handle_display_destroy(struct wl_listener *listener, void *data) {
+	struct flush_state *state =
+		wl_container_of(listener, state, display_destroy);
+	if (state->idle != NULL) {
+		wl_event_source_remove(state->idle);
+	}
+	wl_list_remove(&state->link);
+	wl_list_remove(&state->display_destroy.link);
+	free(state);
+}
+
+static struct flush_state *flush_state_get(struct wl_display *display) {
+	if (flush_states.next == NULL) {
+		wl_list_init(&flush_states);
+	}
+
+	struct flush_state *state;
+	wl_list_for_each(state, &flush_states, link) {
+		if (state->display == display) {
+			return state;
+		}
+	}
+
+	state = calloc(1, sizeof(*state));
+	if (state == NULL) {
+		return NULL;
+	}
+	state->display = display;
+	state->display_destroy.notify = handle_display_destroy;
+	wl_display_add_destroy_listener(display, &state->display_destroy);
+	wl_list_insert(&flush_states, &state->link);
+	return state;
+}
+
+static void flush_idle_handler(void *data) {
+	struct flush_state *state = data;
+	state->idle = NULL;
+	wl_display_flush_clients(state->display);
+}
+
+void flush_clients_soon(struct wl_display *display) {
+	struct flush_state *state = flush_state_get(display);
+	if (state == NULL) {
+		// Allocation failed: fall back to an eager flush
+		wl_display_flush_clients(display);
+		return;
+	}
+	if (state->idle != NULL) {
+		return;
+	}
+
+	struct wl_event_loop *loop = wl_display_get_event_loop(display);
+	state->idle = wl_event_loop_add_idle(loop, flush_idle_handler, state);
+	if (state->idle == NULL) {
+		wl_display_flush_clients(display);
+	}
+}
+
+void client_flush_soon(struct wl_client *client) {
+	flush_clients_soon(wl_client_get_display(client));
+}
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <wlr/util/log.h>
 #include "util/global.h"
 
 struct destroy_global_data {
@@ -41,3 +42,68 @@ void wlr_global_destroy_safe(struct wl_global *global,
 	}
 	wl_event_source_timer_update(data->event_source, 5000);
 }
+
+struct lazy_global {
+	struct wl_display *display;
+	struct wl_global *global;
+
+	wl_global_bind_func_t bind;
+	wlr_lazy_global_init_func_t init;
+	// Argument of init until the first bind, then the state it returned
+	void *data;
+	bool initialized;
+
+	struct wl_listener display_destroy;
+};
+
+static void lazy_global_bind(struct wl_client *client, void *data,
+		uint32_t version, uint32_t id) {
+	struct lazy_global *lazy = data;
+
+	if (!lazy->initialized) {
+		void *state = lazy->init(lazy->display, lazy->data);
+		if (state == NULL) {
+			wl_client_post_no_memory(client);
+			return;
+		}
+		lazy->data = state;
+		lazy->initialized = true;
+	}
+
+	lazy->bind(client, lazy->data, version, id);
+}
+
+static void lazy_global_handle_display_destroy(struct wl_listener *listener,
+		void *data) {
+	struct lazy_global *lazy =
+		wl_container_of(listener, lazy, display_destroy);
+	wl_list_remove(&lazy->display_destroy.link);
+	free(lazy);
+}
+
+struct wl_global *wlr_global_create_lazy(struct wl_display *display,
+		const struct wl_interface *interface, int version,
+		wl_global_bind_func_t bind, wlr_lazy_global_init_func_t init,
+		void *data) {
+	struct lazy_global *lazy = calloc(1, sizeof(struct lazy_global));
+	if (lazy == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+	lazy->display = display;
+	lazy->bind = bind;
+	lazy->init = init;
+	lazy->data = data;
+
+	lazy->global = wl_global_create(display, interface, version, lazy,
+		lazy_global_bind);
+	if (lazy->global == NULL) {
+		free(lazy);
+		return NULL;
+	}
+
+	lazy->display_destroy.notify = lazy_global_handle_display_destroy;
+	wl_display_add_destroy_listener(display, &lazy->display_destroy);
+
+	return lazy->global;
+}
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-server-core.h>
+#include <wlr/util/log.h>
+#include "util/gpu_memory.h"
+
+static struct wlr_gpu_memory_stats stats;
+
+// Log a new high-water mark at most every this many additional bytes, so
+// steady growth doesn't flood the log
+#define HIGH_WATER_LOG_STEP (16 * 1024 * 1024)
+
+static uint64_t logged_total;
+static int log_enabled = -1; // lazily read from the environment
+
+static uint64_t stats_total(void) {
+	uint64_t total = 0;
+	for (size_t i = 0; i < WLR_GPU_MEMORY_TYPE_COUNT; ++i) {
+		total += stats.current[i];
+	}
+	return total;
+}
+
+static void maybe_log_high_water(void) {
+	if (log_enabled == -1) {
+		const char *env = getenv("WLR_GPU_MEM_LOG");
+		log_enabled = env != NULL && strcmp(env, "1") == 0;
+	}
+	if (!log_enabled) {
+		return;
+	}
+
+	uint64_t total = stats_total();
+	if (total < logged_total + HIGH_WATER_LOG_STEP) {
+		return;
+	}
+	logged_total = total;
+
+	wlr_log(WLR_INFO, "GPU memory high-water mark: %.1f MiB "
+		"(shm-tex %.1f, dmabuf %.1f, gbm %.1f)",
+		total / (1024.0 * 1024.0),
+		stats.current[WLR_GPU_MEMORY_SHM_TEXTURE] / (1024.0 * 1024.0),
+		stats.current[WLR_GPU_MEMORY_DMABUF_TEXTURE] / (1024.0 * 1024.0),
+		stats.current[WLR_GPU_MEMORY_GBM_BO] / (1024.0 * 1024.0));
+}
+
+void gpu_memory_add(enum wlr_gpu_memory_type type, size_t bytes) {
+	stats.current[type] += bytes;
+	if (stats.current[type] > stats.peak[type]) {
+		stats.peak[type] = stats.current[type];
+	}
+	maybe_log_high_water();
+}
+
+void gpu_memory_sub(enum wlr_gpu_memory_type type, size_t bytes) {
+	if (stats.current[type] < bytes) {
+		// An unpaired sub is a bug in the instrumentation, not a reason to
+		// wrap around and report petabytes
+		stats.current[type] = 0;
+		return;
+	}
+	stats.current[type] -= bytes;
+}
+
+struct gpu_memory_client {
+	struct wl_client *client;
+	uint64_t bytes;
+	struct wl_list link;
+	struct wl_listener client_destroy;
+};
+
+// gpu_memory_client::link, lazily initialized
+static struct wl_list clients;
+
+static struct wl_list *get_clients(void) {
+	if (clients.next == NULL) {
+		wl_list_init(&clients);
+	}
+	return &clients;
+}
+
+static void client_handle_destroy(struct wl_listener *listener, void *data) {
+	struct gpu_memory_client *entry =
+		wl_container_of(listener, entry, client_destroy);
+	wl_list_remove(&entry->client_destroy.link);
+	wl_list_remove(&entry->link);
+	free(entry);
+}
+
+static struct gpu_memory_client *client_entry_get(struct wl_client *client) {
+	struct gpu_memory_client *entry;
+	wl_list_for_each(entry, get_clients(), link) {
+		if (entry->client == client) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+void gpu_memory_client_add(struct wl_client *client, size_t bytes) {
+	if (client == NULL) {
+		return;
+	}
+
+	struct gpu_memory_client *entry = client_entry_get(client);
+	if (entry == NULL) {
+		entry = calloc(1, sizeof(struct gpu_memory_client));
+		if (entry == NULL) {
+			return;
+		}
+		entry->client = client;
+		entry->client_destroy.notify = client_handle_destroy;
+		wl_client_add_destroy_listener(client, &entry->client_destroy);
+		wl_list_insert(get_clients(), &entry->link);
+	}
+	entry->bytes += bytes;
+}
+
+void gpu_memory_client_sub(struct wl_client *client, size_t bytes) {
+	if (client == NULL) {
+		return;
+	}
+
+	struct gpu_memory_client *entry = client_entry_get(client);
+	if (entry == NULL) {
+		// The client already disconnected and took its entry with it
+		return;
+	}
+	if (entry->bytes < bytes) {
+		entry->bytes = 0;
+	} else {
+		entry->bytes -= bytes;
+	}
+}
+
+void wlr_gpu_memory_get_stats(struct wlr_gpu_memory_stats *out) {
+	*out = stats;
+}
+
+uint64_t wlr_gpu_memory_client_bytes(struct wl_client *client) {
+	struct gpu_memory_client *entry = client_entry_get(client);
+	return entry != NULL ? entry->bytes : 0;
+}
@@ -1,6 +1,8 @@
 #define _XOPEN_SOURCE 700 // for snprintf
 #include <errno.h>
+#include <pthread.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,16 +37,9 @@ static void init_start_time(void) {
 	clock_gettime(CLOCK_MONOTONIC, &start_time);
 }
 
-static void log_stderr(enum wlr_log_importance verbosity, const char *fmt,
-		va_list args) {
-	init_start_time();
-
-	if (verbosity > log_importance) {
-		return;
-	}
-
-	struct timespec ts = {0};
-	clock_gettime(CLOCK_MONOTONIC, &ts);
+static void log_stderr_header(enum wlr_log_importance verbosity,
+		const struct timespec *time) {
+	struct timespec ts = *time;
 	timespec_sub(&ts, &ts, &start_time);
 
 	fprintf(stderr, "%02d:%02d:%02d.%03ld ", (int)(ts.tv_sec / 60 / 60),
@@ -58,17 +53,171 @@ static void log_stderr(enum wlr_log_importance verbosity, const char *fmt,
 	} else {
 		fprintf(stderr, "%s ", verbosity_headers[c]);
 	}
+}
 
-	vfprintf(stderr, fmt, args);
-
+static void log_stderr_footer(void) {
 	if (colored && isatty(STDERR_FILENO)) {
 		fprintf(stderr, "\x1B[0m");
 	}
 	fprintf(stderr, "\n");
 }
 
+static void log_stderr(enum wlr_log_importance verbosity, const char *fmt,
+		va_list args) {
+	init_start_time();
+
+	if (verbosity > log_importance) {
+		return;
+	}
+
+	struct timespec ts = {0};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	log_stderr_header(verbosity, &ts);
+	vfprintf(stderr, fmt, args);
+	log_stderr_footer();
+}
+
 static wlr_log_func_t log_callback = log_stderr;
 
+// Number of ring slots, must be a power of two
+#define ASYNC_LOG_RING_SIZE 256
+// Longer messages are truncated
+#define ASYNC_LOG_MSG_SIZE 1024
+
+struct async_log_msg {
+	// Slot sequence number, see async_log_write. Producers wait for it to
+	// become the sequence number they claimed, publish the message by
+	// incrementing it, and the writer hands the slot back by adding the ring
+	// size.
+	atomic_uint seq;
+	enum wlr_log_importance verbosity;
+	struct timespec time;
+	char text[ASYNC_LOG_MSG_SIZE];
+};
+
+static struct {
+	struct async_log_msg ring[ASYNC_LOG_RING_SIZE];
+	atomic_uint head; // next sequence number producers claim
+	unsigned tail; // next sequence number the writer drains
+	atomic_uint dropped;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	bool running; // protected by mutex
+} async_log = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+/**
+ * Formats a message into the ring from any thread without taking a lock. This
+ * is a bounded multi-producer queue: a producer claims the slot whose sequence
+ * number matches the head, formats into it, and hands it to the writer by
+ * bumping the sequence number. If the slot is still owned by the writer the
+ * ring is full and the message is counted as dropped instead of blocking.
+ */
+static void async_log_write(enum wlr_log_importance verbosity, const char *fmt,
+		va_list args) {
+	if (verbosity > log_importance) {
+		return;
+	}
+
+	unsigned pos = atomic_load_explicit(&async_log.head, memory_order_relaxed);
+	struct async_log_msg *msg;
+	while (true) {
+		msg = &async_log.ring[pos & (ASYNC_LOG_RING_SIZE - 1)];
+		unsigned seq = atomic_load_explicit(&msg->seq, memory_order_acquire);
+		if (seq == pos) {
+			if (atomic_compare_exchange_weak_explicit(&async_log.head, &pos,
+					pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+				break;
+			}
+		} else if ((int)(seq - pos) < 0) {
+			// The writer hasn't released this slot yet, the ring is full
+			atomic_fetch_add_explicit(&async_log.dropped, 1,
+				memory_order_relaxed);
+			return;
+		} else {
+			pos = atomic_load_explicit(&async_log.head, memory_order_relaxed);
+		}
+	}
+
+	msg->verbosity = verbosity;
+	clock_gettime(CLOCK_MONOTONIC, &msg->time);
+	vsnprintf(msg->text, sizeof(msg->text), fmt, args);
+	atomic_store_explicit(&msg->seq, pos + 1, memory_order_release);
+
+	pthread_cond_signal(&async_log.cond);
+}
+
+static void async_log_drain(void) {
+	while (true) {
+		struct async_log_msg *msg =
+			&async_log.ring[async_log.tail & (ASYNC_LOG_RING_SIZE - 1)];
+		unsigned seq = atomic_load_explicit(&msg->seq, memory_order_acquire);
+		if (seq != async_log.tail + 1) {
+			break;
+		}
+
+		log_stderr_header(msg->verbosity, &msg->time);
+		fputs(msg->text, stderr);
+		log_stderr_footer();
+
+		atomic_store_explicit(&msg->seq, async_log.tail + ASYNC_LOG_RING_SIZE,
+			memory_order_release);
+		++async_log.tail;
+	}
+
+	unsigned dropped = atomic_exchange_explicit(&async_log.dropped, 0,
+		memory_order_relaxed);
+	if (dropped > 0) {
+		fprintf(stderr, "[wlroots] dropped %u log messages "
+			"(ring buffer overflow)\n", dropped);
+	}
+}
+
+static void *async_log_writer(void *data) {
+	pthread_mutex_lock(&async_log.mutex);
+	while (async_log.running) {
+		pthread_mutex_unlock(&async_log.mutex);
+		async_log_drain();
+		pthread_mutex_lock(&async_log.mutex);
+		if (!async_log.running) {
+			break;
+		}
+		// A producer may signal between the drain and the wait, so don't
+		// sleep forever
+		struct timespec wait;
+		clock_gettime(CLOCK_REALTIME, &wait);
+		wait.tv_nsec += 100000000;
+		if (wait.tv_nsec >= 1000000000) {
+			wait.tv_nsec -= 1000000000;
+			++wait.tv_sec;
+		}
+		pthread_cond_timedwait(&async_log.cond, &async_log.mutex, &wait);
+	}
+	pthread_mutex_unlock(&async_log.mutex);
+
+	// Flush whatever was logged before shutdown
+	async_log_drain();
+	return NULL;
+}
+
+static void async_log_finish(void) {
+	pthread_mutex_lock(&async_log.mutex);
+	if (!async_log.running) {
+		pthread_mutex_unlock(&async_log.mutex);
+		return;
+	}
+	async_log.running = false;
+	pthread_cond_signal(&async_log.cond);
+	pthread_mutex_unlock(&async_log.mutex);
+
+	pthread_join(async_log.thread, NULL);
+	log_callback = log_stderr;
+}
+
 static void log_wl(const char *fmt, va_list args) {
 	static char wlr_fmt[1024];
 	int n = snprintf(wlr_fmt, sizeof(wlr_fmt), "[wayland] %s", fmt);
@@ -91,6 +240,37 @@ void wlr_log_init(enum wlr_log_importance verbosity, wlr_log_func_t callback) {
 	wl_log_set_handler_server(log_wl);
 }
 
+bool wlr_log_init_async(enum wlr_log_importance verbosity) {
+	wlr_log_init(verbosity, NULL);
+
+	pthread_mutex_lock(&async_log.mutex);
+	if (async_log.running) {
+		pthread_mutex_unlock(&async_log.mutex);
+		return true;
+	}
+
+	for (unsigned i = 0; i < ASYNC_LOG_RING_SIZE; ++i) {
+		atomic_init(&async_log.ring[i].seq, i);
+	}
+	atomic_init(&async_log.head, 0);
+	async_log.tail = 0;
+	atomic_init(&async_log.dropped, 0);
+
+	async_log.running = true;
+	if (pthread_create(&async_log.thread, NULL, async_log_writer,
+			NULL) != 0) {
+		async_log.running = false;
+		pthread_mutex_unlock(&async_log.mutex);
+		wlr_log_errno(WLR_ERROR, "Failed to start log writer thread");
+		return false;
+	}
+	pthread_mutex_unlock(&async_log.mutex);
+
+	log_callback = async_log_write;
+	atexit(async_log_finish);
+	return true;
+}
+
 void _wlr_vlog(enum wlr_log_importance verbosity, const char *fmt, va_list args) {
 	log_callback(verbosity, fmt, args);
 }
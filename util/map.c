@@ -0,0 +1,132 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "util/map.h"
+
+/**
+ * Fibonacci hashing. XIDs and DRM object IDs are handed out sequentially, so
+ * multiply by the golden-ratio constant to spread consecutive keys across the
+ * table before masking.
+ */
+static size_t map_bucket(size_t cap, uint32_t key) {
+	return (size_t)(key * (uint32_t)2654435761u) & (cap - 1);
+}
+
+static bool map_grow(struct wlr_map *map) {
+	size_t cap = map->cap == 0 ? 16 : map->cap * 2;
+	uint32_t *keys = calloc(cap, sizeof(*keys));
+	void **values = malloc(cap * sizeof(*values));
+	if (keys == NULL || values == NULL) {
+		free(keys);
+		free(values);
+		return false;
+	}
+
+	for (size_t i = 0; i < map->cap; ++i) {
+		if (map->keys[i] == 0) {
+			continue;
+		}
+		size_t b = map_bucket(cap, map->keys[i]);
+		while (keys[b] != 0) {
+			b = (b + 1) & (cap - 1);
+		}
+		keys[b] = map->keys[i];
+		values[b] = map->values[i];
+	}
+
+	free(map->keys);
+	free(map->values);
+	map->keys = keys;
+	map->values = values;
+	map->cap = cap;
+	return true;
+}
+
+void wlr_map_init(struct wlr_map *map) {
+	map->keys = NULL;
+	map->values = NULL;
+	map->len = 0;
+	map->cap = 0;
+}
+
+void wlr_map_finish(struct wlr_map *map) {
+	free(map->keys);
+	free(map->values);
+	map->keys = NULL;
+	map->values = NULL;
+	map->len = 0;
+	map->cap = 0;
+}
+
+bool wlr_map_insert(struct wlr_map *map, uint32_t key, void *value) {
+	assert(key != 0);
+
+	if (map->len * 3 >= map->cap * 2) {
+		// If growing fails, keep going with longer probe chains as long as
+		// at least one slot stays empty (lookups stop on empty slots)
+		if (!map_grow(map) && map->len + 1 >= map->cap) {
+			return false;
+		}
+	}
+
+	size_t b = map_bucket(map->cap, key);
+	while (map->keys[b] != 0 && map->keys[b] != key) {
+		b = (b + 1) & (map->cap - 1);
+	}
+	if (map->keys[b] == 0) {
+		map->keys[b] = key;
+		++map->len;
+	}
+	map->values[b] = value;
+	return true;
+}
+
+void *wlr_map_get(struct wlr_map *map, uint32_t key) {
+	if (map->cap == 0) {
+		return NULL;
+	}
+	size_t b = map_bucket(map->cap, key);
+	while (map->keys[b] != 0) {
+		if (map->keys[b] == key) {
+			return map->values[b];
+		}
+		b = (b + 1) & (map->cap - 1);
+	}
+	return NULL;
+}
+
+void *wlr_map_remove(struct wlr_map *map, uint32_t key) {
+	if (map->cap == 0) {
+		return NULL;
+	}
+	size_t b = map_bucket(map->cap, key);
+	while (map->keys[b] != 0 && map->keys[b] != key) {
+		b = (b + 1) & (map->cap - 1);
+	}
+	if (map->keys[b] == 0) {
+		return NULL;
+	}
+
+	void *value = map->values[b];
+	--map->len;
+
+	// Backward-shift deletion: pull up every later entry of the probe chain
+	// whose home bucket lies at or before the hole, so lookups never cross
+	// an empty slot on the way to their target
+	size_t mask = map->cap - 1;
+	size_t hole = b;
+	size_t i = b;
+	while (true) {
+		i = (i + 1) & mask;
+		if (map->keys[i] == 0) {
+			break;
+		}
+		size_t home = map_bucket(map->cap, map->keys[i]);
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			map->keys[hole] = map->keys[i];
+			map->values[hole] = map->values[i];
+			hole = i;
+		}
+	}
+	map->keys[hole] = 0;
+	return value;
+}
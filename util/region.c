@@ -5,6 +5,34 @@
 #include <wlr/types/wlr_box.h>
 #include <wlr/util/region.h>
 
+/**
+ * Scratch buffer for the rect-transforming helpers below. Damage
+ * transformation runs per-surface per-commit on scaled or rotated outputs, so
+ * the buffer is kept across calls instead of malloc'd and freed every time;
+ * in steady state no allocation happens at all. Thread-local since rendering
+ * helpers may transform damage off the main thread. The buffer lives for the
+ * lifetime of the thread and is bounded by the largest region seen.
+ */
+static _Thread_local pixman_box32_t *scratch_rects = NULL;
+static _Thread_local size_t scratch_cap = 0;
+
+static pixman_box32_t *region_scratch_rects(int nrects) {
+	if ((size_t)nrects <= scratch_cap) {
+		return scratch_rects;
+	}
+	size_t cap = scratch_cap > 0 ? scratch_cap : 16;
+	while (cap < (size_t)nrects) {
+		cap *= 2;
+	}
+	pixman_box32_t *rects = realloc(scratch_rects, cap * sizeof(*rects));
+	if (rects == NULL) {
+		return NULL;
+	}
+	scratch_rects = rects;
+	scratch_cap = cap;
+	return rects;
+}
+
 void wlr_region_scale(pixman_region32_t *dst, pixman_region32_t *src,
 		float scale) {
 	wlr_region_scale_xy(dst, src, scale, scale);
@@ -20,7 +48,7 @@ void wlr_region_scale_xy(pixman_region32_t *dst, pixman_region32_t *src,
 	int nrects;
 	pixman_box32_t *src_rects = pixman_region32_rectangles(src, &nrects);
 
-	pixman_box32_t *dst_rects = malloc(nrects * sizeof(pixman_box32_t));
+	pixman_box32_t *dst_rects = region_scratch_rects(nrects);
 	if (dst_rects == NULL) {
 		return;
 	}
@@ -34,80 +62,116 @@ void wlr_region_scale_xy(pixman_region32_t *dst, pixman_region32_t *src,
 
 	pixman_region32_fini(dst);
 	pixman_region32_init_rects(dst, dst_rects, nrects);
-	free(dst_rects);
 }
 
-void wlr_region_transform(pixman_region32_t *dst, pixman_region32_t *src,
+void wlr_region_transform_map_init(struct wlr_region_transform_map *map,
 		enum wl_output_transform transform, int width, int height) {
-	if (transform == WL_OUTPUT_TRANSFORM_NORMAL) {
-		pixman_region32_copy(dst, src);
+	// Every output transform maps a rect coordinate to either the same or
+	// the other source axis, optionally mirrored inside the box. Reducing
+	// the transform to these three decisions once lets the apply loop run
+	// over the rect array without re-deriving the mapping per rect.
+	map->swap_xy = false;
+	map->flip_x = map->flip_y = false;
+	map->offset_x = map->offset_y = 0;
+
+	switch (transform) {
+	case WL_OUTPUT_TRANSFORM_NORMAL:
+		break;
+	case WL_OUTPUT_TRANSFORM_90:
+		map->swap_xy = true;
+		map->flip_x = true;
+		map->offset_x = height;
+		break;
+	case WL_OUTPUT_TRANSFORM_180:
+		map->flip_x = true;
+		map->offset_x = width;
+		map->flip_y = true;
+		map->offset_y = height;
+		break;
+	case WL_OUTPUT_TRANSFORM_270:
+		map->swap_xy = true;
+		map->flip_y = true;
+		map->offset_y = width;
+		break;
+	case WL_OUTPUT_TRANSFORM_FLIPPED:
+		map->flip_x = true;
+		map->offset_x = width;
+		break;
+	case WL_OUTPUT_TRANSFORM_FLIPPED_90:
+		map->swap_xy = true;
+		break;
+	case WL_OUTPUT_TRANSFORM_FLIPPED_180:
+		map->flip_y = true;
+		map->offset_y = height;
+		break;
+	case WL_OUTPUT_TRANSFORM_FLIPPED_270:
+		map->swap_xy = true;
+		map->flip_x = true;
+		map->offset_x = height;
+		map->flip_y = true;
+		map->offset_y = width;
+		break;
+	}
+}
+
+void wlr_region_transform_map_apply(const struct wlr_region_transform_map *map,
+		pixman_region32_t *dst, pixman_region32_t *src) {
+	if (!map->swap_xy && !map->flip_x && !map->flip_y) {
+		if (dst != src) {
+			pixman_region32_copy(dst, src);
+		}
 		return;
 	}
 
 	int nrects;
 	pixman_box32_t *src_rects = pixman_region32_rectangles(src, &nrects);
 
-	pixman_box32_t *dst_rects = malloc(nrects * sizeof(pixman_box32_t));
+	pixman_box32_t *dst_rects = region_scratch_rects(nrects);
 	if (dst_rects == NULL) {
 		return;
 	}
 
 	for (int i = 0; i < nrects; ++i) {
-		switch (transform) {
-		case WL_OUTPUT_TRANSFORM_NORMAL:
-			dst_rects[i].x1 = src_rects[i].x1;
-			dst_rects[i].y1 = src_rects[i].y1;
-			dst_rects[i].x2 = src_rects[i].x2;
-			dst_rects[i].y2 = src_rects[i].y2;
-			break;
-		case WL_OUTPUT_TRANSFORM_90:
-			dst_rects[i].x1 = height - src_rects[i].y2;
-			dst_rects[i].y1 = src_rects[i].x1;
-			dst_rects[i].x2 = height - src_rects[i].y1;
-			dst_rects[i].y2 = src_rects[i].x2;
-			break;
-		case WL_OUTPUT_TRANSFORM_180:
-			dst_rects[i].x1 = width - src_rects[i].x2;
-			dst_rects[i].y1 = height - src_rects[i].y2;
-			dst_rects[i].x2 = width - src_rects[i].x1;
-			dst_rects[i].y2 = height - src_rects[i].y1;
-			break;
-		case WL_OUTPUT_TRANSFORM_270:
-			dst_rects[i].x1 = src_rects[i].y1;
-			dst_rects[i].y1 = width - src_rects[i].x2;
-			dst_rects[i].x2 = src_rects[i].y2;
-			dst_rects[i].y2 = width - src_rects[i].x1;
-			break;
-		case WL_OUTPUT_TRANSFORM_FLIPPED:
-			dst_rects[i].x1 = width - src_rects[i].x2;
-			dst_rects[i].y1 = src_rects[i].y1;
-			dst_rects[i].x2 = width - src_rects[i].x1;
-			dst_rects[i].y2 = src_rects[i].y2;
-			break;
-		case WL_OUTPUT_TRANSFORM_FLIPPED_90:
-			dst_rects[i].x1 = src_rects[i].y1;
-			dst_rects[i].y1 = src_rects[i].x1;
-			dst_rects[i].x2 = src_rects[i].y2;
-			dst_rects[i].y2 = src_rects[i].x2;
-			break;
-		case WL_OUTPUT_TRANSFORM_FLIPPED_180:
-			dst_rects[i].x1 = src_rects[i].x1;
-			dst_rects[i].y1 = height - src_rects[i].y2;
-			dst_rects[i].x2 = src_rects[i].x2;
-			dst_rects[i].y2 = height - src_rects[i].y1;
-			break;
-		case WL_OUTPUT_TRANSFORM_FLIPPED_270:
-			dst_rects[i].x1 = height - src_rects[i].y2;
-			dst_rects[i].y1 = width - src_rects[i].x2;
-			dst_rects[i].x2 = height - src_rects[i].y1;
-			dst_rects[i].y2 = width - src_rects[i].x1;
-			break;
+		int sx1 = src_rects[i].x1, sx2 = src_rects[i].x2;
+		int sy1 = src_rects[i].y1, sy2 = src_rects[i].y2;
+		if (map->swap_xy) {
+			int tmp = sx1;
+			sx1 = sy1;
+			sy1 = tmp;
+			tmp = sx2;
+			sx2 = sy2;
+			sy2 = tmp;
+		}
+		if (map->flip_x) {
+			dst_rects[i].x1 = map->offset_x - sx2;
+			dst_rects[i].x2 = map->offset_x - sx1;
+		} else {
+			dst_rects[i].x1 = sx1;
+			dst_rects[i].x2 = sx2;
+		}
+		if (map->flip_y) {
+			dst_rects[i].y1 = map->offset_y - sy2;
+			dst_rects[i].y2 = map->offset_y - sy1;
+		} else {
+			dst_rects[i].y1 = sy1;
+			dst_rects[i].y2 = sy2;
 		}
 	}
 
 	pixman_region32_fini(dst);
 	pixman_region32_init_rects(dst, dst_rects, nrects);
-	free(dst_rects);
+}
+
+void wlr_region_transform(pixman_region32_t *dst, pixman_region32_t *src,
+		enum wl_output_transform transform, int width, int height) {
+	if (transform == WL_OUTPUT_TRANSFORM_NORMAL) {
+		pixman_region32_copy(dst, src);
+		return;
+	}
+
+	struct wlr_region_transform_map map;
+	wlr_region_transform_map_init(&map, transform, width, height);
+	wlr_region_transform_map_apply(&map, dst, src);
 }
 
 void wlr_region_expand(pixman_region32_t *dst, pixman_region32_t *src,
@@ -120,7 +184,7 @@ void wlr_region_expand(pixman_region32_t *dst, pixman_region32_t *src,
 	int nrects;
 	pixman_box32_t *src_rects = pixman_region32_rectangles(src, &nrects);
 
-	pixman_box32_t *dst_rects = malloc(nrects * sizeof(pixman_box32_t));
+	pixman_box32_t *dst_rects = region_scratch_rects(nrects);
 	if (dst_rects == NULL) {
 		return;
 	}
@@ -134,7 +198,6 @@ void wlr_region_expand(pixman_region32_t *dst, pixman_region32_t *src,
 
 	pixman_region32_fini(dst);
 	pixman_region32_init_rects(dst, dst_rects, nrects);
-	free(dst_rects);
 }
 
 void wlr_region_rotated_bounds(pixman_region32_t *dst, pixman_region32_t *src,
@@ -147,7 +210,7 @@ void wlr_region_rotated_bounds(pixman_region32_t *dst, pixman_region32_t *src,
 	int nrects;
 	pixman_box32_t *src_rects = pixman_region32_rectangles(src, &nrects);
 
-	pixman_box32_t *dst_rects = malloc(nrects * sizeof(pixman_box32_t));
+	pixman_box32_t *dst_rects = region_scratch_rects(nrects);
 	if (dst_rects == NULL) {
 		return;
 	}
@@ -183,7 +246,63 @@ void wlr_region_rotated_bounds(pixman_region32_t *dst, pixman_region32_t *src,
 
 	pixman_region32_fini(dst);
 	pixman_region32_init_rects(dst, dst_rects, nrects);
-	free(dst_rects);
+}
+
+/**
+ * Finds the rectangle of the region containing (x, y), like
+ * pixman_region32_contains_point. Region rectangles are stored banded and
+ * sorted on (y1, x1), so a binary search for the band followed by one for the
+ * rectangle within it replaces pixman's linear scan — pointer confinement
+ * calls this for every motion while a constraint is active.
+ */
+static pixman_box32_t *region_find_box(pixman_region32_t *region,
+		int x, int y) {
+	int nrects;
+	pixman_box32_t *rects = pixman_region32_rectangles(region, &nrects);
+
+	// First rectangle whose band ends below y
+	int lo = 0, hi = nrects;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (rects[mid].y2 <= y) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo == nrects || rects[lo].y1 > y) {
+		return NULL;
+	}
+
+	// End of the band: all its rectangles share y1
+	int band_start = lo;
+	int band_y1 = rects[band_start].y1;
+	hi = nrects;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (rects[mid].y1 <= band_y1) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	int band_end = lo;
+
+	// First rectangle of the band ending right of x
+	lo = band_start;
+	hi = band_end;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (rects[mid].x2 <= x) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	if (lo == band_end || rects[lo].x1 > x) {
+		return NULL;
+	}
+	return &rects[lo];
 }
 
 static void region_confine(pixman_region32_t *region, double x1, double y1, double x2,
@@ -214,8 +333,9 @@ static void region_confine(pixman_region32_t *region, double x1, double y1, doub
 	int x_ext = floor(x) + (dx == 0 ? 0 : dx > 0 ? 1 : -1);
 	int y_ext = floor(y) + (dy == 0 ? 0 : dy > 0 ? 1 : -1);
 
-	if (pixman_region32_contains_point(region, x_ext, y_ext, &box)) {
-		return region_confine(region, x1, y1, x2, y2, x2_out, y2_out, box);
+	pixman_box32_t *ext_box = region_find_box(region, x_ext, y_ext);
+	if (ext_box != NULL) {
+		return region_confine(region, x1, y1, x2, y2, x2_out, y2_out, *ext_box);
 	} else if (dx == 0 || dy == 0) {
 		*x2_out = x;
 		*y2_out = y;
@@ -245,9 +365,9 @@ static void region_confine(pixman_region32_t *region, double x1, double y1, doub
 
 bool wlr_region_confine(pixman_region32_t *region, double x1, double y1, double x2,
 		double y2, double *x2_out, double *y2_out) {
-	pixman_box32_t box;
-	if (pixman_region32_contains_point(region, floor(x1), floor(y1), &box)) {
-		region_confine(region, x1, y1, x2, y2, x2_out, y2_out, box);
+	pixman_box32_t *box = region_find_box(region, floor(x1), floor(y1));
+	if (box != NULL) {
+		region_confine(region, x1, y1, x2, y2, x2_out, y2_out, *box);
 		return true;
 	} else {
 		return false;
@@ -1,6 +1,7 @@
-#define _POSIX_C_SOURCE 200112L
+#define _GNU_SOURCE
 #include <errno.h>
 #include <fcntl.h>
+#include <stdbool.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <time.h>
@@ -53,3 +54,42 @@ int allocate_shm_file(size_t size) {
 
 	return fd;
 }
+
+static bool write_full(int fd, const void *data, size_t size) {
+	size_t written = 0;
+	while (written < size) {
+		ssize_t n = write(fd, (const char *)data + written, size - written);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		written += n;
+	}
+	return true;
+}
+
+int allocate_sealed_shm_file(const void *data, size_t size) {
+#ifdef MFD_ALLOW_SEALING
+	int fd = memfd_create("wlroots", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (fd < 0) {
+		// Without seals an unsealed file would stay writable through every
+		// descriptor dup()ed to a client, so refuse: callers fall back to
+		// private per-client copies
+		return -1;
+	}
+	if (!write_full(fd, data, size)) {
+		close(fd);
+		return -1;
+	}
+	if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW |
+			F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+#else
+	return -1;
+#endif
+}
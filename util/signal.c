@@ -1,4 +1,16 @@
+#include <stdlib.h>
 #include "util/signal.h"
+#include "util/watchdog.h"
+
+static void notify_listener(struct wl_listener *listener, void *data) {
+	if (watchdog_active) {
+		watchdog_listener_begin(listener);
+		listener->notify(listener, data);
+		watchdog_listener_end(listener);
+	} else {
+		listener->notify(listener, data);
+	}
+}
 
 static void handle_noop(struct wl_listener *listener, void *data) {
 	// Do nothing
@@ -26,9 +38,99 @@ void wlr_signal_emit_safe(struct wl_signal *signal, void *data) {
 		wl_list_remove(&cursor.link);
 		wl_list_insert(pos, &cursor.link);
 
-		l->notify(l, data);
+		notify_listener(l, data);
 	}
 
 	wl_list_remove(&cursor.link);
 	wl_list_remove(&end.link);
 }
+
+void wlr_fast_signal_init(struct wlr_fast_signal *signal) {
+	wl_signal_init(&signal->legacy);
+	signal->entries = NULL;
+	signal->len = signal->cap = 0;
+	signal->nesting = 0;
+	signal->compact_pending = false;
+}
+
+void wlr_fast_signal_finish(struct wlr_fast_signal *signal) {
+	free(signal->entries);
+	signal->entries = NULL;
+	signal->len = signal->cap = 0;
+}
+
+void wlr_fast_signal_add(struct wlr_fast_signal *signal,
+		struct wl_listener *listener) {
+	if (signal->len == signal->cap) {
+		size_t cap = signal->cap == 0 ? 4 : signal->cap * 2;
+		struct wl_listener **entries =
+			realloc(signal->entries, cap * sizeof(*entries));
+		if (entries == NULL) {
+			// Keep working, just slower: put the listener on the legacy
+			// list instead
+			wl_signal_add(&signal->legacy, listener);
+			return;
+		}
+		signal->entries = entries;
+		signal->cap = cap;
+	}
+	// A cleared link marks the listener as array-backed, see
+	// wlr_fast_signal_remove
+	listener->link.prev = NULL;
+	listener->link.next = NULL;
+	signal->entries[signal->len++] = listener;
+}
+
+static void fast_signal_compact(struct wlr_fast_signal *signal) {
+	size_t len = 0;
+	for (size_t i = 0; i < signal->len; ++i) {
+		if (signal->entries[i] != NULL) {
+			signal->entries[len++] = signal->entries[i];
+		}
+	}
+	signal->len = len;
+	signal->compact_pending = false;
+}
+
+void wlr_fast_signal_remove(struct wlr_fast_signal *signal,
+		struct wl_listener *listener) {
+	if (listener->link.prev != NULL) {
+		// The listener overflowed onto the legacy list
+		wl_list_remove(&listener->link);
+		return;
+	}
+	for (size_t i = 0; i < signal->len; ++i) {
+		if (signal->entries[i] != listener) {
+			continue;
+		}
+		if (signal->nesting > 0) {
+			// An emit is walking the array, so don't shift entries from
+			// under it; the hole is skipped and compacted afterwards
+			signal->entries[i] = NULL;
+			signal->compact_pending = true;
+		} else {
+			signal->entries[i] = signal->entries[--signal->len];
+		}
+		return;
+	}
+}
+
+void wlr_fast_signal_emit(struct wlr_fast_signal *signal, void *data) {
+	++signal->nesting;
+	// Entries appended by handlers are beyond this length and are only
+	// called on the next emit
+	size_t len = signal->len;
+	for (size_t i = 0; i < len; ++i) {
+		struct wl_listener *listener = signal->entries[i];
+		if (listener != NULL) {
+			notify_listener(listener, data);
+		}
+	}
+	if (--signal->nesting == 0 && signal->compact_pending) {
+		fast_signal_compact(signal);
+	}
+
+	if (!wl_list_empty(&signal->legacy.listener_list)) {
+		wlr_signal_emit_safe(&signal->legacy, data);
+	}
+}
@@ -0,0 +1,74 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "util/slab.h"
+
+// Keep entries of any reasonable type suitably aligned
+#define SLAB_ALIGN (2 * sizeof(void *))
+#define SLAB_CHUNK_ENTRIES 32
+
+struct wlr_slab_chunk {
+	struct wlr_slab_chunk *next;
+	// entries follow, aligned to SLAB_ALIGN
+};
+
+void wlr_slab_init(struct wlr_slab *slab, size_t entry_size) {
+	if (entry_size < sizeof(void *)) {
+		// A free entry stores the free-list link in its first word
+		entry_size = sizeof(void *);
+	}
+	slab->entry_size = (entry_size + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+	slab->chunk_entries = SLAB_CHUNK_ENTRIES;
+	slab->chunks = NULL;
+	slab->free_list = NULL;
+}
+
+void wlr_slab_finish(struct wlr_slab *slab) {
+	struct wlr_slab_chunk *chunk = slab->chunks;
+	while (chunk != NULL) {
+		struct wlr_slab_chunk *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	slab->chunks = NULL;
+	slab->free_list = NULL;
+}
+
+static bool slab_grow(struct wlr_slab *slab) {
+	size_t header_size =
+		(sizeof(struct wlr_slab_chunk) + SLAB_ALIGN - 1) & ~(SLAB_ALIGN - 1);
+	struct wlr_slab_chunk *chunk =
+		malloc(header_size + slab->entry_size * slab->chunk_entries);
+	if (chunk == NULL) {
+		return false;
+	}
+	chunk->next = slab->chunks;
+	slab->chunks = chunk;
+
+	char *entries = (char *)chunk + header_size;
+	for (size_t i = 0; i < slab->chunk_entries; ++i) {
+		void *entry = entries + i * slab->entry_size;
+		*(void **)entry = slab->free_list;
+		slab->free_list = entry;
+	}
+	return true;
+}
+
+void *wlr_slab_alloc(struct wlr_slab *slab) {
+	if (slab->free_list == NULL && !slab_grow(slab)) {
+		return NULL;
+	}
+
+	void *entry = slab->free_list;
+	slab->free_list = *(void **)entry;
+	memset(entry, 0, slab->entry_size);
+	return entry;
+}
+
+void wlr_slab_free(struct wlr_slab *slab, void *ptr) {
+	if (ptr == NULL) {
+		return;
+	}
+	*(void **)ptr = slab->free_list;
+	slab->free_list = ptr;
+}
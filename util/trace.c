@@ -0,0 +1,120 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-util.h>
+#include <wlr/util/log.h>
+#include <wlr/util/trace.h>
+#include "util/trace.h"
+
+bool trace_recorder_active = false;
+
+// Events kept per thread; older events are overwritten ring-style. At the
+// few dozen spans a busy compositor records per frame this covers minutes.
+#define TRACE_EVENTS_PER_THREAD (1 << 14)
+
+struct trace_event {
+	const char *name; // string literal, not owned
+	uint64_t ts_nsec;
+	char phase;
+};
+
+struct trace_thread {
+	struct wl_list link; // threads
+	int tid;
+	size_t head; // total events written; the ring index is head % size
+	struct trace_event events[TRACE_EVENTS_PER_THREAD];
+};
+
+// Thread buffers are registered once per thread under the mutex and then
+// written to without locking: each buffer has exactly one writer. Buffers
+// of exited threads stay around so their events survive until the dump.
+static pthread_mutex_t threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct wl_list threads; // trace_thread.link, lazily initialized
+static int next_tid = 1;
+
+static _Thread_local struct trace_thread *local_thread;
+
+static uint64_t now_nsec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void trace_recorder_record(const char *name, char phase) {
+	struct trace_thread *thread = local_thread;
+	if (thread == NULL) {
+		thread = calloc(1, sizeof(*thread));
+		if (thread == NULL) {
+			return;
+		}
+		pthread_mutex_lock(&threads_mutex);
+		if (threads.next == NULL) {
+			wl_list_init(&threads);
+		}
+		thread->tid = next_tid++;
+		wl_list_insert(&threads, &thread->link);
+		pthread_mutex_unlock(&threads_mutex);
+		local_thread = thread;
+	}
+
+	struct trace_event *event =
+		&thread->events[thread->head % TRACE_EVENTS_PER_THREAD];
+	event->name = name;
+	event->ts_nsec = now_nsec();
+	event->phase = phase;
+	++thread->head;
+}
+
+bool wlr_trace_start(void) {
+	trace_recorder_active = true;
+	return true;
+}
+
+void wlr_trace_stop(void) {
+	trace_recorder_active = false;
+}
+
+bool wlr_trace_dump(const char *path) {
+	FILE *f = fopen(path, "w");
+	if (f == NULL) {
+		wlr_log_errno(WLR_ERROR, "Failed to open trace dump file '%s'", path);
+		return false;
+	}
+
+	int pid = getpid();
+	bool first = true;
+	fputs("[", f);
+
+	pthread_mutex_lock(&threads_mutex);
+	if (threads.next != NULL) {
+		struct trace_thread *thread;
+		wl_list_for_each(thread, &threads, link) {
+			size_t count = thread->head;
+			size_t start = 0;
+			if (count > TRACE_EVENTS_PER_THREAD) {
+				start = count - TRACE_EVENTS_PER_THREAD;
+			}
+			for (size_t i = start; i < count; ++i) {
+				const struct trace_event *event =
+					&thread->events[i % TRACE_EVENTS_PER_THREAD];
+				fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"%c\","
+					"\"pid\":%d,\"tid\":%d,\"ts\":%.3f%s}",
+					first ? "" : ",", event->name, event->phase, pid,
+					thread->tid, event->ts_nsec / 1000.0,
+					event->phase == 'i' ? ",\"s\":\"t\"" : "");
+				first = false;
+			}
+		}
+	}
+	pthread_mutex_unlock(&threads_mutex);
+
+	fputs("\n]\n", f);
+	if (fclose(f) != 0) {
+		wlr_log_errno(WLR_ERROR, "Failed to write trace dump file '%s'", path);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,185 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <wlr/util/log.h>
+#include <wlr/util/transfer.h>
+
+#define TRANSFER_CHUNK_SIZE 65536
+
+static void pipe_transfer_end(struct wlr_pipe_transfer *transfer,
+		bool success, bool call_done) {
+	wl_event_source_remove(transfer->src_source);
+	wl_event_source_remove(transfer->dst_source);
+	close(transfer->src_fd);
+	close(transfer->dst_fd);
+
+	if (call_done && transfer->done != NULL) {
+		transfer->done(transfer, success, transfer->data);
+	}
+	free(transfer);
+}
+
+/**
+ * Move as much data as possible. `from_dst` says whether we woke up because
+ * the destination became writable, which disambiguates EAGAIN from splice():
+ * it doesn't tell apart an empty source from a full destination, so the side
+ * that was just reported ready can't be the one that blocked.
+ */
+static void pipe_transfer_pump(struct wlr_pipe_transfer *transfer,
+		bool from_dst) {
+	while (true) {
+#ifdef __linux__
+		if (!transfer->use_buffer) {
+			ssize_t n = splice(transfer->src_fd, NULL, transfer->dst_fd,
+				NULL, TRANSFER_CHUNK_SIZE,
+				SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+			if (n > 0) {
+				continue;
+			} else if (n == 0) {
+				pipe_transfer_end(transfer, true, true);
+				return;
+			} else if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN) {
+				if (from_dst) {
+					// The destination has room, the source must be empty
+					wl_event_source_fd_update(transfer->src_source,
+						WL_EVENT_READABLE);
+					wl_event_source_fd_update(transfer->dst_source, 0);
+				} else {
+					wl_event_source_fd_update(transfer->src_source, 0);
+					wl_event_source_fd_update(transfer->dst_source,
+						WL_EVENT_WRITABLE);
+				}
+				return;
+			} else if (errno == EINVAL) {
+				// Not a pipe pair, copy through userspace instead
+				transfer->use_buffer = true;
+				continue;
+			} else {
+				wlr_log_errno(WLR_ERROR, "splice failed");
+				pipe_transfer_end(transfer, false, true);
+				return;
+			}
+		}
+#endif
+
+		if (transfer->buf_len == 0) {
+			if (transfer->eof) {
+				pipe_transfer_end(transfer, true, true);
+				return;
+			}
+			ssize_t n = read(transfer->src_fd, transfer->buf,
+				sizeof(transfer->buf));
+			if (n > 0) {
+				transfer->buf_start = 0;
+				transfer->buf_len = n;
+			} else if (n == 0) {
+				transfer->eof = true;
+			} else if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN) {
+				wl_event_source_fd_update(transfer->src_source,
+					WL_EVENT_READABLE);
+				wl_event_source_fd_update(transfer->dst_source, 0);
+				return;
+			} else {
+				wlr_log_errno(WLR_ERROR, "read error from transfer source");
+				pipe_transfer_end(transfer, false, true);
+				return;
+			}
+		} else {
+			ssize_t n = write(transfer->dst_fd,
+				transfer->buf + transfer->buf_start, transfer->buf_len);
+			if (n > 0) {
+				transfer->buf_start += n;
+				transfer->buf_len -= n;
+			} else if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN) {
+				wl_event_source_fd_update(transfer->src_source, 0);
+				wl_event_source_fd_update(transfer->dst_source,
+					WL_EVENT_WRITABLE);
+				return;
+			} else {
+				wlr_log_errno(WLR_ERROR, "write error to transfer destination");
+				pipe_transfer_end(transfer, false, true);
+				return;
+			}
+		}
+	}
+}
+
+static int handle_src_ready(int fd, uint32_t mask, void *data) {
+	struct wlr_pipe_transfer *transfer = data;
+	pipe_transfer_pump(transfer, false);
+	return 0;
+}
+
+static int handle_dst_ready(int fd, uint32_t mask, void *data) {
+	struct wlr_pipe_transfer *transfer = data;
+	if (mask & (WL_EVENT_ERROR | WL_EVENT_HANGUP)) {
+		// The reading end went away, no point in continuing
+		pipe_transfer_end(transfer, false, true);
+		return 0;
+	}
+	pipe_transfer_pump(transfer, true);
+	return 0;
+}
+
+static bool set_nonblock(int fd) {
+	int flags = fcntl(fd, F_GETFL);
+	if (flags == -1) {
+		return false;
+	}
+	return fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+struct wlr_pipe_transfer *wlr_pipe_transfer_start(struct wl_event_loop *loop,
+		int src_fd, int dst_fd, wlr_pipe_transfer_done_func_t done,
+		void *data) {
+	struct wlr_pipe_transfer *transfer =
+		calloc(1, sizeof(struct wlr_pipe_transfer));
+	if (transfer == NULL) {
+		wlr_log(WLR_ERROR, "Failed to allocate wlr_pipe_transfer");
+		return NULL;
+	}
+	transfer->src_fd = src_fd;
+	transfer->dst_fd = dst_fd;
+	transfer->done = done;
+	transfer->data = data;
+#ifndef __linux__
+	transfer->use_buffer = true;
+#endif
+
+	if (!set_nonblock(src_fd) || !set_nonblock(dst_fd)) {
+		wlr_log_errno(WLR_ERROR, "fcntl failed");
+		free(transfer);
+		return NULL;
+	}
+
+	transfer->src_source = wl_event_loop_add_fd(loop, src_fd,
+		WL_EVENT_READABLE, handle_src_ready, transfer);
+	if (transfer->src_source == NULL) {
+		free(transfer);
+		return NULL;
+	}
+	transfer->dst_source = wl_event_loop_add_fd(loop, dst_fd, 0,
+		handle_dst_ready, transfer);
+	if (transfer->dst_source == NULL) {
+		wl_event_source_remove(transfer->src_source);
+		free(transfer);
+		return NULL;
+	}
+
+	return transfer;
+}
+
+void wlr_pipe_transfer_destroy(struct wlr_pipe_transfer *transfer) {
+	if (transfer == NULL) {
+		return;
+	}
+	pipe_transfer_end(transfer, false, false);
+}
@@ -0,0 +1,147 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <time.h>
+#include <wlr/util/log.h>
+#include <wlr/util/watchdog.h>
+#include "util/watchdog.h"
+
+bool watchdog_active = false;
+
+static int64_t threshold_nsec;
+
+// Written by the dispatching thread, read by the monitor thread
+static _Atomic int64_t heartbeat_nsec;
+static _Atomic int64_t dispatch_start_nsec;
+static void *_Atomic dispatch_notify;
+
+static _Thread_local int dispatch_depth;
+
+static struct wl_event_source *heartbeat_source;
+static pthread_t monitor_thread;
+static bool monitor_started;
+static _Atomic bool monitor_stop;
+
+static int64_t now_nsec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void watchdog_listener_begin(struct wl_listener *listener) {
+	if (++dispatch_depth > 1) {
+		return;
+	}
+	atomic_store_explicit(&dispatch_start_nsec, now_nsec(),
+		memory_order_relaxed);
+	atomic_store_explicit(&dispatch_notify, (void *)listener->notify,
+		memory_order_relaxed);
+}
+
+void watchdog_listener_end(struct wl_listener *listener) {
+	if (--dispatch_depth > 0) {
+		return;
+	}
+
+	int64_t duration = now_nsec() -
+		atomic_load_explicit(&dispatch_start_nsec, memory_order_relaxed);
+	void *notify =
+		atomic_load_explicit(&dispatch_notify, memory_order_relaxed);
+	atomic_store_explicit(&dispatch_notify, NULL, memory_order_relaxed);
+
+	if (duration >= threshold_nsec) {
+		wlr_log(WLR_ERROR, "Slow event handler: notify %p ran for %d ms "
+			"(threshold %d ms)", notify, (int)(duration / 1000000),
+			(int)(threshold_nsec / 1000000));
+	}
+}
+
+static int handle_heartbeat(void *data) {
+	atomic_store_explicit(&heartbeat_nsec, now_nsec(), memory_order_relaxed);
+	wl_event_source_timer_update(heartbeat_source,
+		threshold_nsec / 2 / 1000000);
+	return 0;
+}
+
+static void *monitor_main(void *data) {
+	bool reported = false;
+	while (!atomic_load_explicit(&monitor_stop, memory_order_relaxed)) {
+		struct timespec interval = {
+			.tv_sec = threshold_nsec / 2 / 1000000000,
+			.tv_nsec = threshold_nsec / 2 % 1000000000,
+		};
+		clock_nanosleep(CLOCK_MONOTONIC, 0, &interval, NULL);
+
+		int64_t now = now_nsec();
+		int64_t stalled = now -
+			atomic_load_explicit(&heartbeat_nsec, memory_order_relaxed);
+		if (stalled < threshold_nsec) {
+			reported = false;
+			continue;
+		}
+		if (reported) {
+			// One report per stall; the loop resuming re-arms it
+			continue;
+		}
+		reported = true;
+
+		void *notify =
+			atomic_load_explicit(&dispatch_notify, memory_order_relaxed);
+		if (notify != NULL) {
+			int64_t running = now - atomic_load_explicit(
+				&dispatch_start_nsec, memory_order_relaxed);
+			wlr_log(WLR_ERROR, "Event loop stalled for %d ms, currently "
+				"dispatching notify %p (running for %d ms)",
+				(int)(stalled / 1000000), notify, (int)(running / 1000000));
+		} else {
+			wlr_log(WLR_ERROR, "Event loop stalled for %d ms outside a "
+				"listener (blocking FD handler or syscall)",
+				(int)(stalled / 1000000));
+		}
+	}
+	return NULL;
+}
+
+bool wlr_stall_watchdog_start(struct wl_display *display,
+		int64_t threshold_msec) {
+	if (monitor_started || threshold_msec <= 0) {
+		return false;
+	}
+	threshold_nsec = threshold_msec * 1000000;
+
+	struct wl_event_loop *loop = wl_display_get_event_loop(display);
+	heartbeat_source = wl_event_loop_add_timer(loop, handle_heartbeat, NULL);
+	if (heartbeat_source == NULL) {
+		return false;
+	}
+	atomic_store_explicit(&heartbeat_nsec, now_nsec(), memory_order_relaxed);
+	wl_event_source_timer_update(heartbeat_source,
+		threshold_nsec / 2 / 1000000);
+
+	atomic_store_explicit(&monitor_stop, false, memory_order_relaxed);
+	if (pthread_create(&monitor_thread, NULL, monitor_main, NULL) != 0) {
+		wlr_log(WLR_ERROR, "Failed to start stall watchdog thread");
+		wl_event_source_remove(heartbeat_source);
+		heartbeat_source = NULL;
+		return false;
+	}
+	monitor_started = true;
+
+	watchdog_active = true;
+	return true;
+}
+
+void wlr_stall_watchdog_stop(void) {
+	if (!monitor_started) {
+		return;
+	}
+	watchdog_active = false;
+
+	atomic_store_explicit(&monitor_stop, true, memory_order_relaxed);
+	pthread_join(monitor_thread, NULL);
+	monitor_started = false;
+
+	wl_event_source_remove(heartbeat_source);
+	heartbeat_source = NULL;
+}
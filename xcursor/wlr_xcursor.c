@@ -31,14 +31,18 @@
 #include <wlr/util/log.h>
 #include <wlr/xcursor.h>
 #include "xcursor/xcursor.h"
+#include "xcursor/xcursor_cache.h"
 
 static void xcursor_destroy(struct wlr_xcursor *cursor) {
 	for (size_t i = 0; i < cursor->image_count; i++) {
-		free(cursor->images[i]->buffer);
+		if (!cursor->cached) {
+			free(cursor->images[i]->buffer);
+		}
 		free(cursor->images[i]);
 	}
 
 	free(cursor->images);
+	free(cursor->frame_ends);
 	free(cursor->name);
 	free(cursor);
 }
@@ -64,6 +68,8 @@ static struct wlr_xcursor *xcursor_create_from_data(
 
 	cursor->name = strdup(metadata->name);
 	cursor->total_delay = 0;
+	cursor->frame_ends = NULL;
+	cursor->cached = false;
 
 	image = malloc(sizeof(*image));
 	if (!image) {
@@ -145,6 +151,7 @@ static struct wlr_xcursor *xcursor_create_from_xcursor_images(
 
 	cursor->name = strdup(images->name);
 	cursor->total_delay = 0;
+	cursor->cached = false;
 
 	for (i = 0; i < images->nimage; i++) {
 		image = malloc(sizeof(*image));
@@ -181,34 +188,61 @@ static struct wlr_xcursor *xcursor_create_from_xcursor_images(
 		return NULL;
 	}
 
+	cursor->frame_ends = NULL;
+	if (cursor->image_count > 1) {
+		/* Precompute when each frame ends so frame lookup can binary
+		 * search instead of walking the delays. On allocation failure we
+		 * simply fall back to the walk.
+		 */
+		cursor->frame_ends =
+			malloc(cursor->image_count * sizeof(cursor->frame_ends[0]));
+		if (cursor->frame_ends) {
+			uint32_t end = 0;
+			for (size_t j = 0; j < cursor->image_count; j++) {
+				end += cursor->images[j]->delay;
+				cursor->frame_ends[j] = end;
+			}
+		}
+	}
+
 	return cursor;
 }
 
+static struct wlr_xcursor *theme_get_loaded_cursor(
+		struct wlr_xcursor_theme *theme, const char *name) {
+	for (unsigned int i = 0; i < theme->cursor_count; i++) {
+		if (strcmp(name, theme->cursors[i]->name) == 0) {
+			return theme->cursors[i];
+		}
+	}
+	return NULL;
+}
+
+static bool theme_add_cursor(struct wlr_xcursor_theme *theme,
+		struct wlr_xcursor *cursor) {
+	struct wlr_xcursor **cursors = realloc(theme->cursors,
+		(theme->cursor_count + 1) * sizeof(theme->cursors[0]));
+	if (cursors == NULL) {
+		return false;
+	}
+	theme->cursors = cursors;
+	theme->cursors[theme->cursor_count++] = cursor;
+	return true;
+}
+
 static void load_callback(XcursorImages *images, void *data) {
 	struct wlr_xcursor_theme *theme = data;
 	struct wlr_xcursor *cursor;
 
-	if (wlr_xcursor_theme_get_cursor(theme, images->name)) {
+	if (theme_get_loaded_cursor(theme, images->name)) {
 		XcursorImagesDestroy(images);
 		return;
 	}
 
 	cursor = xcursor_create_from_xcursor_images(images, theme);
 
-	if (cursor) {
-		struct wlr_xcursor **cursors;
-		theme->cursor_count++;
-		cursors =
-			realloc(theme->cursors,
-				theme->cursor_count * sizeof(theme->cursors[0]));
-
-		if (cursors == NULL) {
-			theme->cursor_count--;
-			free(cursor);
-		} else {
-			theme->cursors = cursors;
-			theme->cursors[theme->cursor_count - 1] = cursor;
-		}
+	if (cursor && !theme_add_cursor(theme, cursor)) {
+		xcursor_destroy(cursor);
 	}
 
 	XcursorImagesDestroy(images);
@@ -233,22 +267,36 @@ struct wlr_xcursor_theme *wlr_xcursor_theme_load(const char *name, int size) {
 	theme->size = size;
 	theme->cursor_count = 0;
 	theme->cursors = NULL;
+	theme->lazy = false;
+	theme->missing_names = NULL;
+	theme->missing_count = 0;
+
+	// Shapes decoded by a previous instance are served straight from the
+	// compiled cache mapping; a valid cache also proves the theme exists
+	// on disk, so no probe is needed
+	theme->cache = xcursor_cache_open(name, size);
+	if (theme->cache != NULL) {
+		theme->lazy = true;
+	} else {
+		// A session typically touches a dozen of the ~80 shapes a theme
+		// ships, so probe with the shape every theme has instead of decoding
+		// them all; the rest are decoded on first wlr_xcursor_theme_get_cursor
+		XcursorImages *images =
+			XcursorLibraryLoadImages("left_ptr", name, size);
+		if (images != NULL) {
+			theme->lazy = true;
+			load_callback(images, theme);
+		}
 
-	xcursor_load_theme(name, size, load_callback, theme);
-
-	if (theme->cursor_count == 0) {
-		load_default_theme(theme);
+		if (theme->cursor_count == 0) {
+			theme->lazy = false;
+			load_default_theme(theme);
+		}
 	}
 
-	wlr_log(WLR_DEBUG, "Loaded cursor theme '%s', available cursors:",
-			theme->name);
-	for (size_t i = 0; i < theme->cursor_count; ++i) {
-		struct wlr_xcursor *c = theme->cursors[i];
-		struct wlr_xcursor_image *i = c->images[0];
-		wlr_log(WLR_DEBUG, "%s (%u images) %" PRIu32 "x%" PRIu32 "+%" PRIu32 ",%" PRIu32,
-				c->name, c->image_count,
-				i->width, i->height, i->hotspot_x, i->hotspot_y);
-	}
+	wlr_log(WLR_DEBUG, "Loaded cursor theme '%s' (%s)", theme->name,
+			theme->cache != NULL ? "cached" :
+			theme->lazy ? "lazy" : "embedded fallback");
 
 	return theme;
 
@@ -260,10 +308,32 @@ out_error_name:
 void wlr_xcursor_theme_destroy(struct wlr_xcursor_theme *theme) {
 	unsigned int i;
 
+	// Compile the decoded shapes for the next start, unless every one of
+	// them already came from the cache
+	if (theme->lazy) {
+		bool dirty = false;
+		for (i = 0; i < theme->cursor_count; i++) {
+			if (!theme->cursors[i]->cached) {
+				dirty = true;
+				break;
+			}
+		}
+		if (dirty) {
+			xcursor_cache_write(theme);
+		}
+	}
+
 	for (i = 0; i < theme->cursor_count; i++) {
 		xcursor_destroy(theme->cursors[i]);
 	}
 
+	xcursor_cache_close(theme->cache);
+
+	for (size_t j = 0; j < theme->missing_count; j++) {
+		free(theme->missing_names[j]);
+	}
+	free(theme->missing_names);
+
 	free(theme->name);
 	free(theme->cursors);
 	free(theme);
@@ -271,41 +341,103 @@ void wlr_xcursor_theme_destroy(struct wlr_xcursor_theme *theme) {
 
 struct wlr_xcursor *wlr_xcursor_theme_get_cursor(struct wlr_xcursor_theme *theme,
 		const char *name) {
-	unsigned int i;
+	struct wlr_xcursor *cursor = theme_get_loaded_cursor(theme, name);
+	if (cursor != NULL || !theme->lazy) {
+		return cursor;
+	}
 
-	for (i = 0; i < theme->cursor_count; i++) {
-		if (strcmp(name, theme->cursors[i]->name) == 0) {
-			return theme->cursors[i];
+	for (size_t i = 0; i < theme->missing_count; i++) {
+		if (strcmp(theme->missing_names[i], name) == 0) {
+			return NULL;
+		}
+	}
+
+	if (theme->cache != NULL) {
+		cursor = xcursor_cache_get(theme->cache, name);
+		if (cursor != NULL) {
+			if (!theme_add_cursor(theme, cursor)) {
+				xcursor_destroy(cursor);
+				return NULL;
+			}
+			return cursor;
 		}
 	}
 
+	XcursorImages *images =
+		XcursorLibraryLoadImages(name, theme->name, theme->size);
+	if (images != NULL) {
+		load_callback(images, theme);
+		cursor = theme_get_loaded_cursor(theme, name);
+		if (cursor != NULL) {
+			return cursor;
+		}
+	}
+
+	// Remember the miss so repeated lookups don't rescan the theme dirs
+	char **missing_names = realloc(theme->missing_names,
+		(theme->missing_count + 1) * sizeof(char *));
+	if (missing_names != NULL) {
+		theme->missing_names = missing_names;
+		missing_names[theme->missing_count] = strdup(name);
+		if (missing_names[theme->missing_count] != NULL) {
+			theme->missing_count++;
+		}
+	}
 	return NULL;
 }
 
+void wlr_xcursor_theme_prewarm(struct wlr_xcursor_theme *theme) {
+	static const char *common_names[] = {
+		"left_ptr", "xterm", "hand1", "grabbing", "watch",
+		"n-resize", "s-resize", "e-resize", "w-resize",
+		"ne-resize", "nw-resize", "se-resize", "sw-resize",
+	};
+	for (size_t i = 0; i < sizeof(common_names) / sizeof(common_names[0]);
+			i++) {
+		wlr_xcursor_theme_get_cursor(theme, common_names[i]);
+	}
+}
+
 static int xcursor_frame_and_duration(struct wlr_xcursor *cursor,
 		uint32_t time, uint32_t *duration) {
 	uint32_t t;
 	int i;
 
-	if (cursor->image_count == 1) {
+	if (cursor->image_count == 1 || cursor->total_delay == 0) {
 		if (duration) {
 			*duration = 0;
 		}
 		return 0;
 	}
 
-	i = 0;
 	t = time % cursor->total_delay;
 
-	/* If there is a 0 delay in the image set then this
-	 * loop breaks on it and we display that cursor until
-	 * time % cursor->total_delay wraps again.
-	 * Since a 0 delay is silly, and we've never actually
-	 * seen one in a cursor file, we haven't bothered to
-	 * "fix" this.
-	 */
-	while (t - cursor->images[i]->delay < t) {
-		t -= cursor->images[i++]->delay;
+	if (cursor->frame_ends) {
+		/* Binary search for the first frame ending past t */
+		uint32_t lo = 0, hi = cursor->image_count - 1;
+		while (lo < hi) {
+			uint32_t mid = lo + (hi - lo) / 2;
+			if (cursor->frame_ends[mid] <= t) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		i = lo;
+		t -= cursor->frame_ends[i] - cursor->images[i]->delay;
+	} else {
+		i = 0;
+
+		/* If there is a 0 delay in the image set then this
+		 * loop breaks on it and we display that cursor until
+		 * time % cursor->total_delay wraps again.
+		 * Since a 0 delay is silly, and we've never actually
+		 * seen one in a cursor file, we haven't bothered to
+		 * "fix" this.
+		 */
+		while (t - cursor->images[i]->delay < t) {
+			t -= cursor->images[i++]->delay;
+		}
 	}
 
 	if (!duration) {
@@ -328,6 +460,95 @@ int wlr_xcursor_frame(struct wlr_xcursor *_cursor, uint32_t time) {
 	return xcursor_frame_and_duration(_cursor, time, NULL);
 }
 
+struct wlr_xcursor_atlas *wlr_xcursor_atlas_create(struct wlr_xcursor *cursor) {
+	struct wlr_xcursor_atlas *atlas = calloc(1, sizeof(*atlas));
+	if (atlas == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		return NULL;
+	}
+
+	/* The frame cell is the union of every frame's extents around its
+	 * hotspot, so all frames share one hotspot and switching frames is
+	 * purely a source rectangle move.
+	 */
+	uint32_t left = 0, right = 0, top = 0, bottom = 0;
+	for (size_t i = 0; i < cursor->image_count; i++) {
+		struct wlr_xcursor_image *image = cursor->images[i];
+		if (image->hotspot_x > left) {
+			left = image->hotspot_x;
+		}
+		if (image->width - image->hotspot_x > right) {
+			right = image->width - image->hotspot_x;
+		}
+		if (image->hotspot_y > top) {
+			top = image->hotspot_y;
+		}
+		if (image->height - image->hotspot_y > bottom) {
+			bottom = image->height - image->hotspot_y;
+		}
+	}
+
+	atlas->frame_count = cursor->image_count;
+	atlas->width = left + right;
+	atlas->height = top + bottom;
+	atlas->hotspot_x = left;
+	atlas->hotspot_y = top;
+	atlas->total_delay = cursor->total_delay;
+
+	size_t stride = (size_t)4 * atlas->width * atlas->frame_count;
+	atlas->buffer = calloc(atlas->height, stride);
+	atlas->frame_ends =
+		malloc(atlas->frame_count * sizeof(atlas->frame_ends[0]));
+	if (atlas->buffer == NULL || atlas->frame_ends == NULL) {
+		wlr_log(WLR_ERROR, "Allocation failed");
+		wlr_xcursor_atlas_destroy(atlas);
+		return NULL;
+	}
+
+	uint32_t end = 0;
+	for (size_t i = 0; i < cursor->image_count; i++) {
+		struct wlr_xcursor_image *image = cursor->images[i];
+		size_t x0 = (size_t)i * atlas->width + (left - image->hotspot_x);
+		size_t y0 = top - image->hotspot_y;
+		for (size_t y = 0; y < image->height; y++) {
+			memcpy(&atlas->buffer[(y0 + y) * stride + 4 * x0],
+				&image->buffer[(size_t)y * image->width * 4],
+				(size_t)image->width * 4);
+		}
+		end += image->delay;
+		atlas->frame_ends[i] = end;
+	}
+
+	return atlas;
+}
+
+void wlr_xcursor_atlas_destroy(struct wlr_xcursor_atlas *atlas) {
+	if (atlas == NULL) {
+		return;
+	}
+	free(atlas->frame_ends);
+	free(atlas->buffer);
+	free(atlas);
+}
+
+int wlr_xcursor_atlas_frame(struct wlr_xcursor_atlas *atlas, uint32_t time) {
+	if (atlas->frame_count == 1 || atlas->total_delay == 0) {
+		return 0;
+	}
+
+	uint32_t t = time % atlas->total_delay;
+	uint32_t lo = 0, hi = atlas->frame_count - 1;
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (atlas->frame_ends[mid] <= t) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
 const char *wlr_xcursor_get_resize_name(enum wlr_edges edges) {
 	if (edges & WLR_EDGE_TOP) {
 		if (edges & WLR_EDGE_RIGHT) {
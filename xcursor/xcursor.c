@@ -28,6 +28,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "xcursor/xcursor.h"
 
 /*
@@ -180,14 +183,18 @@ typedef struct _XcursorComment {
 #define XCURSOR_IMAGE_HEADER_LEN    (XCURSOR_CHUNK_HEADER_LEN + (5*4))
 #define XCURSOR_IMAGE_MAX_SIZE	    0x7fff	/* 32767x32767 max cursor size */
 
-typedef struct _XcursorFile XcursorFile;
-
-struct _XcursorFile {
-    void    *closure;
-    int	    (*read)  (XcursorFile *file, unsigned char *buf, int len);
-    int	    (*write) (XcursorFile *file, unsigned char *buf, int len);
-    int	    (*seek)  (XcursorFile *file, long offset, int whence);
-};
+/*
+ * Cursor files are parsed straight out of a read-only mapping of the file:
+ * the kernel pages in only the headers and the images actually chosen, and
+ * nothing is copied until pixels are read.  A heap buffer is substituted when
+ * mmap isn't possible (e.g. a filesystem without mmap support).
+ */
+typedef struct _XcursorBuffer {
+    const unsigned char	*bytes;
+    size_t		len;
+    size_t		pos;
+    XcursorBool		mapped;	/* munmap vs free on finish */
+} XcursorBuffer;
 
 typedef struct _XcursorComments {
     int		    ncomment;	/* number of comments */
@@ -277,16 +284,19 @@ XcursorImagesSetName (XcursorImages *images, const char *name)
 }
 
 static XcursorBool
-_XcursorReadUInt (XcursorFile *file, XcursorUInt *u)
+_XcursorReadUInt (XcursorBuffer *buffer, XcursorUInt *u)
 {
-    unsigned char   bytes[4];
+    const unsigned char	*bytes;
 
-    if (!file || !u)
+    if (!buffer || !u)
         return XcursorFalse;
 
-    if ((*file->read) (file, bytes, 4) != 4)
+    if (buffer->len - buffer->pos < 4)
         return XcursorFalse;
 
+    bytes = buffer->bytes + buffer->pos;
+    buffer->pos += 4;
+
     *u = ((XcursorUInt)(bytes[0]) << 0) |
          ((XcursorUInt)(bytes[1]) << 8) |
          ((XcursorUInt)(bytes[2]) << 16) |
@@ -320,29 +330,32 @@ _XcursorFileHeaderCreate (int ntoc)
 }
 
 static XcursorFileHeader *
-_XcursorReadFileHeader (XcursorFile *file)
+_XcursorReadFileHeader (XcursorBuffer *buffer)
 {
     XcursorFileHeader	head, *fileHeader;
     XcursorUInt		skip;
     unsigned int	n;
 
-    if (!file)
+    if (!buffer)
         return NULL;
 
-    if (!_XcursorReadUInt (file, &head.magic))
+    if (!_XcursorReadUInt (buffer, &head.magic))
 	return NULL;
     if (head.magic != XCURSOR_MAGIC)
 	return NULL;
-    if (!_XcursorReadUInt (file, &head.header))
+    if (!_XcursorReadUInt (buffer, &head.header))
 	return NULL;
-    if (!_XcursorReadUInt (file, &head.version))
+    if (!_XcursorReadUInt (buffer, &head.version))
 	return NULL;
-    if (!_XcursorReadUInt (file, &head.ntoc))
+    if (!_XcursorReadUInt (buffer, &head.ntoc))
 	return NULL;
     skip = head.header - XCURSOR_FILE_HEADER_LEN;
     if (skip)
-	if ((*file->seek) (file, skip, SEEK_CUR) == EOF)
+    {
+	if (skip > buffer->len - buffer->pos)
 	    return NULL;
+	buffer->pos += skip;
+    }
     fileHeader = _XcursorFileHeaderCreate (head.ntoc);
     if (!fileHeader)
 	return NULL;
@@ -352,11 +365,11 @@ _XcursorReadFileHeader (XcursorFile *file)
     fileHeader->ntoc = head.ntoc;
     for (n = 0; n < fileHeader->ntoc; n++)
     {
-	if (!_XcursorReadUInt (file, &fileHeader->tocs[n].type))
+	if (!_XcursorReadUInt (buffer, &fileHeader->tocs[n].type))
 	    break;
-	if (!_XcursorReadUInt (file, &fileHeader->tocs[n].subtype))
+	if (!_XcursorReadUInt (buffer, &fileHeader->tocs[n].subtype))
 	    break;
-	if (!_XcursorReadUInt (file, &fileHeader->tocs[n].position))
+	if (!_XcursorReadUInt (buffer, &fileHeader->tocs[n].position))
 	    break;
     }
     if (n != fileHeader->ntoc)
@@ -368,33 +381,34 @@ _XcursorReadFileHeader (XcursorFile *file)
 }
 
 static XcursorBool
-_XcursorSeekToToc (XcursorFile		*file,
+_XcursorSeekToToc (XcursorBuffer	*buffer,
 		   XcursorFileHeader	*fileHeader,
 		   int			toc)
 {
-    if (!file || !fileHeader || \
-        (*file->seek) (file, fileHeader->tocs[toc].position, SEEK_SET) == EOF)
+    if (!buffer || !fileHeader ||
+        fileHeader->tocs[toc].position > buffer->len)
 	return XcursorFalse;
+    buffer->pos = fileHeader->tocs[toc].position;
     return XcursorTrue;
 }
 
 static XcursorBool
-_XcursorFileReadChunkHeader (XcursorFile	*file,
+_XcursorFileReadChunkHeader (XcursorBuffer	*buffer,
 			     XcursorFileHeader	*fileHeader,
 			     int		toc,
 			     XcursorChunkHeader	*chunkHeader)
 {
-    if (!file || !fileHeader || !chunkHeader)
+    if (!buffer || !fileHeader || !chunkHeader)
         return XcursorFalse;
-    if (!_XcursorSeekToToc (file, fileHeader, toc))
+    if (!_XcursorSeekToToc (buffer, fileHeader, toc))
 	return XcursorFalse;
-    if (!_XcursorReadUInt (file, &chunkHeader->header))
+    if (!_XcursorReadUInt (buffer, &chunkHeader->header))
 	return XcursorFalse;
-    if (!_XcursorReadUInt (file, &chunkHeader->type))
+    if (!_XcursorReadUInt (buffer, &chunkHeader->type))
 	return XcursorFalse;
-    if (!_XcursorReadUInt (file, &chunkHeader->subtype))
+    if (!_XcursorReadUInt (buffer, &chunkHeader->subtype))
 	return XcursorFalse;
-    if (!_XcursorReadUInt (file, &chunkHeader->version))
+    if (!_XcursorReadUInt (buffer, &chunkHeader->version))
 	return XcursorFalse;
     /* sanity check */
     if (chunkHeader->type != fileHeader->tocs[toc].type ||
@@ -463,7 +477,7 @@ _XcursorFindImageToc (XcursorFileHeader	*fileHeader,
 }
 
 static XcursorImage *
-_XcursorReadImage (XcursorFile		*file,
+_XcursorReadImage (XcursorBuffer	*buffer,
 		   XcursorFileHeader	*fileHeader,
 		   int			toc)
 {
@@ -472,21 +486,22 @@ _XcursorReadImage (XcursorFile		*file,
     XcursorImage	*image;
     int			n;
     XcursorPixel	*p;
+    const unsigned char	*bytes;
 
-    if (!file || !fileHeader)
+    if (!buffer || !fileHeader)
         return NULL;
 
-    if (!_XcursorFileReadChunkHeader (file, fileHeader, toc, &chunkHeader))
+    if (!_XcursorFileReadChunkHeader (buffer, fileHeader, toc, &chunkHeader))
 	return NULL;
-    if (!_XcursorReadUInt (file, &head.width))
+    if (!_XcursorReadUInt (buffer, &head.width))
 	return NULL;
-    if (!_XcursorReadUInt (file, &head.height))
+    if (!_XcursorReadUInt (buffer, &head.height))
 	return NULL;
-    if (!_XcursorReadUInt (file, &head.xhot))
+    if (!_XcursorReadUInt (buffer, &head.xhot))
 	return NULL;
-    if (!_XcursorReadUInt (file, &head.yhot))
+    if (!_XcursorReadUInt (buffer, &head.yhot))
 	return NULL;
-    if (!_XcursorReadUInt (file, &head.delay))
+    if (!_XcursorReadUInt (buffer, &head.delay))
 	return NULL;
     /* sanity check data */
     if (head.width > XCURSOR_IMAGE_MAX_SIZE  ||
@@ -508,21 +523,28 @@ _XcursorReadImage (XcursorFile		*file,
     image->yhot = head.yhot;
     image->delay = head.delay;
     n = image->width * image->height;
+    if ((size_t) n * 4 > buffer->len - buffer->pos)
+    {
+	XcursorImageDestroy (image);
+	return NULL;
+    }
+    /* bounds checked above, assemble pixels straight from the mapping */
+    bytes = buffer->bytes + buffer->pos;
+    buffer->pos += (size_t) n * 4;
     p = image->pixels;
     while (n--)
     {
-	if (!_XcursorReadUInt (file, p))
-	{
-	    XcursorImageDestroy (image);
-	    return NULL;
-	}
-	p++;
+	*p++ = ((XcursorPixel)(bytes[0]) << 0) |
+	       ((XcursorPixel)(bytes[1]) << 8) |
+	       ((XcursorPixel)(bytes[2]) << 16) |
+	       ((XcursorPixel)(bytes[3]) << 24);
+	bytes += 4;
     }
     return image;
 }
 
 static XcursorImages *
-XcursorXcFileLoadImages (XcursorFile *file, int size)
+XcursorXcFileLoadImages (XcursorBuffer *buffer, int size)
 {
     XcursorFileHeader	*fileHeader;
     XcursorDim		bestSize;
@@ -531,9 +553,9 @@ XcursorXcFileLoadImages (XcursorFile *file, int size)
     int			n;
     int			toc;
 
-    if (!file || size < 0)
+    if (!buffer || size < 0)
 	return NULL;
-    fileHeader = _XcursorReadFileHeader (file);
+    fileHeader = _XcursorReadFileHeader (buffer);
     if (!fileHeader)
 	return NULL;
     bestSize = _XcursorFindBestSize (fileHeader, (XcursorDim) size, &nsize);
@@ -553,7 +575,7 @@ XcursorXcFileLoadImages (XcursorFile *file, int size)
 	toc = _XcursorFindImageToc (fileHeader, bestSize, n);
 	if (toc < 0)
 	    break;
-	images->images[images->nimage] = _XcursorReadImage (file, fileHeader,
+	images->images[images->nimage] = _XcursorReadImage (buffer, fileHeader,
 							    toc);
 	if (!images->images[images->nimage])
 	    break;
@@ -568,46 +590,64 @@ XcursorXcFileLoadImages (XcursorFile *file, int size)
     return images;
 }
 
-static int
-_XcursorStdioFileRead (XcursorFile *file, unsigned char *buf, int len)
+static XcursorBool
+_XcursorBufferInit (XcursorBuffer *buffer, FILE *file)
 {
-    FILE    *f = file->closure;
-    return fread (buf, 1, len, f);
-}
+    struct stat	st;
+    int		fd = fileno (file);
+    void	*map;
 
-static int
-_XcursorStdioFileWrite (XcursorFile *file, unsigned char *buf, int len)
-{
-    FILE    *f = file->closure;
-    return fwrite (buf, 1, len, f);
-}
+    if (fd < 0 || fstat (fd, &st) != 0 || st.st_size < 0)
+	return XcursorFalse;
 
-static int
-_XcursorStdioFileSeek (XcursorFile *file, long offset, int whence)
-{
-    FILE    *f = file->closure;
-    return fseek (f, offset, whence);
+    buffer->len = (size_t) st.st_size;
+    buffer->pos = 0;
+
+    map = mmap (NULL, buffer->len ? buffer->len : 1, PROT_READ, MAP_PRIVATE,
+		fd, 0);
+    if (map != MAP_FAILED)
+    {
+	buffer->bytes = map;
+	buffer->mapped = XcursorTrue;
+	return XcursorTrue;
+    }
+
+    /* mmap can fail on exotic filesystems; fall back to reading it all */
+    buffer->bytes = malloc (buffer->len ? buffer->len : 1);
+    if (!buffer->bytes)
+	return XcursorFalse;
+    if (fread ((void *) buffer->bytes, 1, buffer->len, file) != buffer->len)
+    {
+	free ((void *) buffer->bytes);
+	return XcursorFalse;
+    }
+    buffer->mapped = XcursorFalse;
+    return XcursorTrue;
 }
 
 static void
-_XcursorStdioFileInitialize (FILE *stdfile, XcursorFile *file)
+_XcursorBufferFinish (XcursorBuffer *buffer)
 {
-    file->closure = stdfile;
-    file->read = _XcursorStdioFileRead;
-    file->write = _XcursorStdioFileWrite;
-    file->seek = _XcursorStdioFileSeek;
+    if (buffer->mapped)
+	munmap ((void *) buffer->bytes, buffer->len ? buffer->len : 1);
+    else
+	free ((void *) buffer->bytes);
 }
 
 static XcursorImages *
 XcursorFileLoadImages (FILE *file, int size)
 {
-    XcursorFile	f;
+    XcursorBuffer   buffer;
+    XcursorImages   *images;
 
     if (!file)
         return NULL;
 
-    _XcursorStdioFileInitialize (file, &f);
-    return XcursorXcFileLoadImages (&f, size);
+    if (!_XcursorBufferInit (&buffer, file))
+	return NULL;
+    images = XcursorXcFileLoadImages (&buffer, size);
+    _XcursorBufferFinish (&buffer);
+    return images;
 }
 
 /*
@@ -982,3 +1022,39 @@ xcursor_load_theme(const char *theme, int size,
 	if (inherits)
 		free(inherits);
 }
+
+/** Locate a theme on disk
+ *
+ * Returns the first directory in the library path containing a "cursors"
+ * subdirectory for the given theme, or NULL when the theme is not
+ * installed. The caller is expected to free the returned path.
+ */
+char *
+xcursor_theme_path(const char *theme)
+{
+	char *full, *dir;
+	const char *path;
+	struct stat st;
+
+	if (!theme)
+		theme = "default";
+
+	for (path = XcursorLibraryPath();
+	     path;
+	     path = _XcursorNextPath(path)) {
+		dir = _XcursorBuildThemeDir(path, theme);
+		if (!dir)
+			continue;
+
+		full = _XcursorBuildFullname(dir, "cursors", "");
+		if (full && stat(full, &st) == 0 && S_ISDIR(st.st_mode)) {
+			free(dir);
+			return full;
+		}
+
+		free(full);
+		free(dir);
+	}
+
+	return NULL;
+}
@@ -0,0 +1,376 @@
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <wlr/util/log.h>
+#include <wlr/xcursor.h>
+#include "xcursor/xcursor.h"
+#include "xcursor/xcursor_cache.h"
+
+#define CACHE_MAGIC 0x52435857 // "WXCR"
+#define CACHE_VERSION 1
+
+struct cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size; // requested cursor size
+	uint32_t shape_count;
+	uint64_t mtime_sec; // theme directory mtime at write time
+	uint32_t mtime_nsec;
+	uint32_t pad;
+};
+
+/*
+ * After the header, each shape is serialized as a uint32_t name length, the
+ * name bytes zero-padded to a multiple of four, a uint32_t image count, and
+ * then each image as a cache_image immediately followed by its
+ * width*height*4 pixel bytes. All offsets stay 4-byte aligned.
+ */
+struct cache_image {
+	uint32_t width;
+	uint32_t height;
+	uint32_t hotspot_x;
+	uint32_t hotspot_y;
+	uint32_t delay;
+};
+
+static char *cache_path(const char *theme, int size) {
+	if (strchr(theme, '/') != NULL) {
+		return NULL;
+	}
+
+	const char *cache_home = getenv("XDG_CACHE_HOME");
+	const char *home = NULL;
+	if (cache_home == NULL || cache_home[0] == '\0') {
+		cache_home = NULL;
+		home = getenv("HOME");
+		if (home == NULL) {
+			return NULL;
+		}
+	}
+
+	int len;
+	if (cache_home != NULL) {
+		len = snprintf(NULL, 0, "%s/wlroots/xcursor/%s-%d",
+			cache_home, theme, size);
+	} else {
+		len = snprintf(NULL, 0, "%s/.cache/wlroots/xcursor/%s-%d",
+			home, theme, size);
+	}
+	char *path = malloc(len + 1);
+	if (path == NULL) {
+		return NULL;
+	}
+	if (cache_home != NULL) {
+		snprintf(path, len + 1, "%s/wlroots/xcursor/%s-%d",
+			cache_home, theme, size);
+	} else {
+		snprintf(path, len + 1, "%s/.cache/wlroots/xcursor/%s-%d",
+			home, theme, size);
+	}
+	return path;
+}
+
+static bool theme_dir_mtime(const char *theme, struct timespec *mtime) {
+	char *dir = xcursor_theme_path(theme);
+	if (dir == NULL) {
+		return false;
+	}
+	struct stat st;
+	bool ok = stat(dir, &st) == 0;
+	if (ok) {
+		*mtime = st.st_mtim;
+	}
+	free(dir);
+	return ok;
+}
+
+struct xcursor_cache *xcursor_cache_open(const char *theme, int size) {
+	char *path = cache_path(theme, size);
+	if (path == NULL) {
+		return NULL;
+	}
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	free(path);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct cache_header)) {
+		close(fd);
+		return NULL;
+	}
+	size_t len = st.st_size;
+
+	void *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+
+	const struct cache_header *header = data;
+	if (header->magic != CACHE_MAGIC || header->version != CACHE_VERSION ||
+			header->size != (uint32_t)size ||
+			header->shape_count > len / 8) {
+		goto err_unmap;
+	}
+
+	// The cache is only valid while the theme it was compiled from is
+	// unchanged on disk
+	struct timespec mtime;
+	if (!theme_dir_mtime(theme, &mtime) ||
+			(uint64_t)mtime.tv_sec != header->mtime_sec ||
+			(uint32_t)mtime.tv_nsec != header->mtime_nsec) {
+		goto err_unmap;
+	}
+
+	struct xcursor_cache *cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		goto err_unmap;
+	}
+	cache->data = data;
+	cache->len = len;
+	cache->entries = calloc(header->shape_count, sizeof(cache->entries[0]));
+	if (cache->entries == NULL) {
+		free(cache);
+		goto err_unmap;
+	}
+
+	// Walk the blob once, bounds-checking every record, and index the shapes
+	const unsigned char *bytes = data;
+	size_t pos = sizeof(*header);
+	for (uint32_t i = 0; i < header->shape_count; i++) {
+		uint32_t name_len, image_count;
+		if (len - pos < 4) {
+			goto err_malformed;
+		}
+		memcpy(&name_len, &bytes[pos], 4);
+		pos += 4;
+
+		size_t padded = ((size_t)name_len + 3) & ~(size_t)3;
+		if (name_len == 0 || len - pos < padded) {
+			goto err_malformed;
+		}
+		cache->entries[i].name = (const char *)&bytes[pos];
+		cache->entries[i].name_len = name_len;
+		pos += padded;
+
+		if (len - pos < 4) {
+			goto err_malformed;
+		}
+		memcpy(&image_count, &bytes[pos], 4);
+		pos += 4;
+		cache->entries[i].image_count = image_count;
+		cache->entries[i].images = &bytes[pos];
+
+		for (uint32_t j = 0; j < image_count; j++) {
+			struct cache_image image;
+			if (len - pos < sizeof(image)) {
+				goto err_malformed;
+			}
+			memcpy(&image, &bytes[pos], sizeof(image));
+			pos += sizeof(image);
+			if (image.width > 0x8000 || image.height > 0x8000 ||
+					len - pos < (size_t)image.width * image.height * 4) {
+				goto err_malformed;
+			}
+			pos += (size_t)image.width * image.height * 4;
+		}
+	}
+	cache->entry_count = header->shape_count;
+
+	return cache;
+
+err_malformed:
+	free(cache->entries);
+	free(cache);
+err_unmap:
+	munmap(data, len);
+	return NULL;
+}
+
+struct wlr_xcursor *xcursor_cache_get(struct xcursor_cache *cache,
+		const char *name) {
+	size_t name_len = strlen(name);
+	struct xcursor_cache_entry *entry = NULL;
+	for (size_t i = 0; i < cache->entry_count; i++) {
+		if (cache->entries[i].name_len == name_len &&
+				memcmp(cache->entries[i].name, name, name_len) == 0) {
+			entry = &cache->entries[i];
+			break;
+		}
+	}
+	if (entry == NULL) {
+		return NULL;
+	}
+
+	struct wlr_xcursor *cursor = calloc(1, sizeof(*cursor));
+	if (cursor == NULL) {
+		return NULL;
+	}
+	cursor->cached = true;
+	cursor->name = strdup(name);
+	cursor->images = malloc(entry->image_count * sizeof(cursor->images[0]));
+	if (cursor->name == NULL || cursor->images == NULL) {
+		goto err_cursor;
+	}
+
+	const unsigned char *ptr = entry->images;
+	uint32_t i;
+	for (i = 0; i < entry->image_count; i++) {
+		struct wlr_xcursor_image *image = malloc(sizeof(*image));
+		if (image == NULL) {
+			goto err_images;
+		}
+
+		struct cache_image ci;
+		memcpy(&ci, ptr, sizeof(ci));
+		ptr += sizeof(ci);
+
+		image->width = ci.width;
+		image->height = ci.height;
+		image->hotspot_x = ci.hotspot_x;
+		image->hotspot_y = ci.hotspot_y;
+		image->delay = ci.delay;
+		// Shared with every process that maps this cache
+		image->buffer = (uint8_t *)ptr;
+		ptr += (size_t)ci.width * ci.height * 4;
+
+		cursor->total_delay += ci.delay;
+		cursor->images[i] = image;
+	}
+	cursor->image_count = entry->image_count;
+
+	if (cursor->image_count > 1) {
+		cursor->frame_ends =
+			malloc(cursor->image_count * sizeof(cursor->frame_ends[0]));
+		if (cursor->frame_ends != NULL) {
+			uint32_t end = 0;
+			for (uint32_t j = 0; j < cursor->image_count; j++) {
+				end += cursor->images[j]->delay;
+				cursor->frame_ends[j] = end;
+			}
+		}
+	}
+
+	return cursor;
+
+err_images:
+	while (i > 0) {
+		free(cursor->images[--i]);
+	}
+err_cursor:
+	free(cursor->images);
+	free(cursor->name);
+	free(cursor);
+	return NULL;
+}
+
+static void mkdir_parents(const char *path) {
+	char *copy = strdup(path);
+	if (copy == NULL) {
+		return;
+	}
+	for (char *p = copy + 1; *p != '\0'; p++) {
+		if (*p == '/') {
+			*p = '\0';
+			mkdir(copy, 0755);
+			*p = '/';
+		}
+	}
+	free(copy);
+}
+
+static bool write_u32(FILE *f, uint32_t value) {
+	return fwrite(&value, sizeof(value), 1, f) == 1;
+}
+
+bool xcursor_cache_write(struct wlr_xcursor_theme *theme) {
+	struct timespec mtime;
+	if (!theme_dir_mtime(theme->name, &mtime)) {
+		return false;
+	}
+
+	char *path = cache_path(theme->name, theme->size);
+	if (path == NULL) {
+		return false;
+	}
+	mkdir_parents(path);
+
+	char *tmp = NULL;
+	int tmp_len = snprintf(NULL, 0, "%s.%d.tmp", path, getpid());
+	tmp = malloc(tmp_len + 1);
+	if (tmp == NULL) {
+		free(path);
+		return false;
+	}
+	snprintf(tmp, tmp_len + 1, "%s.%d.tmp", path, getpid());
+
+	FILE *f = fopen(tmp, "w");
+	if (f == NULL) {
+		free(tmp);
+		free(path);
+		return false;
+	}
+
+	struct cache_header header = {
+		.magic = CACHE_MAGIC,
+		.version = CACHE_VERSION,
+		.size = theme->size,
+		.shape_count = theme->cursor_count,
+		.mtime_sec = mtime.tv_sec,
+		.mtime_nsec = mtime.tv_nsec,
+	};
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+
+	static const char zeros[4] = {0};
+	for (unsigned int i = 0; ok && i < theme->cursor_count; i++) {
+		struct wlr_xcursor *cursor = theme->cursors[i];
+		uint32_t name_len = strlen(cursor->name);
+		size_t padding = (4 - (size_t)name_len % 4) % 4;
+		ok = write_u32(f, name_len) &&
+			fwrite(cursor->name, name_len, 1, f) == 1 &&
+			(padding == 0 || fwrite(zeros, padding, 1, f) == 1) &&
+			write_u32(f, cursor->image_count);
+		for (size_t j = 0; ok && j < cursor->image_count; j++) {
+			struct wlr_xcursor_image *image = cursor->images[j];
+			struct cache_image ci = {
+				.width = image->width,
+				.height = image->height,
+				.hotspot_x = image->hotspot_x,
+				.hotspot_y = image->hotspot_y,
+				.delay = image->delay,
+			};
+			ok = fwrite(&ci, sizeof(ci), 1, f) == 1 &&
+				fwrite(image->buffer,
+					(size_t)image->width * image->height * 4, 1, f) == 1;
+		}
+	}
+
+	ok = fclose(f) == 0 && ok;
+	if (ok) {
+		ok = rename(tmp, path) == 0;
+	}
+	if (!ok) {
+		unlink(tmp);
+		wlr_log(WLR_DEBUG, "Failed to write cursor theme cache '%s'", path);
+	}
+	free(tmp);
+	free(path);
+	return ok;
+}
+
+void xcursor_cache_close(struct xcursor_cache *cache) {
+	if (cache == NULL) {
+		return;
+	}
+	munmap(cache->data, cache->len);
+	free(cache->entries);
+	free(cache);
+}
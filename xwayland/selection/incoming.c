@@ -13,16 +13,17 @@
 
 static void xwm_notify_ready_for_next_incr_chunk(
 		struct wlr_xwm_selection_transfer *transfer) {
-	struct wlr_xwm *xwm = transfer->selection->xwm;
 	assert(transfer->incr);
 
-	wlr_log(WLR_DEBUG, "deleting property");
-	xcb_delete_property(xwm->xcb_conn, transfer->selection->window,
-		xwm->atoms[WL_SELECTION]);
-	xcb_flush(xwm->xcb_conn);
-
 	xwm_selection_transfer_remove_event_source(transfer);
 	xwm_selection_transfer_destroy_property_reply(transfer);
+
+	// The consumed property was deleted when it was fetched, so the X11
+	// owner may have posted the next chunk while we were draining this one
+	if (transfer->incr_chunk_pending) {
+		transfer->incr_chunk_pending = false;
+		xwm_get_incr_chunk(transfer);
+	}
 }
 
 /**
@@ -89,11 +90,15 @@ void xwm_get_incr_chunk(struct wlr_xwm_selection_transfer *transfer) {
 	wlr_log(WLR_DEBUG, "xwm_get_incr_chunk");
 
 	if (transfer->property_reply) {
-		wlr_log(WLR_ERROR, "X11 client offered a new property before we deleted");
+		// Still draining the previous chunk; fetch this one once it's done
+		transfer->incr_chunk_pending = true;
 		return;
 	}
 
-	if (!xwm_selection_transfer_get_selection_property(transfer, false)) {
+	// Delete the property in the same request as the read, so the X11 owner
+	// can prepare the next chunk while this one is written to the Wayland
+	// client instead of idling until we finish
+	if (!xwm_selection_transfer_get_selection_property(transfer, true)) {
 		return;
 	}
 
@@ -160,6 +165,7 @@ static void source_send(struct wlr_xwm_selection *selection,
 	xcb_flush(xwm->xcb_conn);
 
 	fcntl(fd, F_SETFL, O_WRONLY | O_NONBLOCK);
+	xwm_selection_transfer_enlarge_pipe(xwm, fd);
 	transfer->wl_client_fd = fd;
 }
 
@@ -90,10 +90,12 @@ static int xwm_data_source_read(int fd, uint32_t mask, void *data) {
 	struct wlr_xwm_selection_transfer *transfer = data;
 	struct wlr_xwm *xwm = transfer->selection->xwm;
 
+	size_t incr_chunk_size = xwm_selection_incr_chunk_size(xwm);
+
 	void *p;
 	size_t current = transfer->source_data.size;
-	if (transfer->source_data.size < INCR_CHUNK_SIZE) {
-		p = wl_array_add(&transfer->source_data, INCR_CHUNK_SIZE);
+	if (transfer->source_data.size < incr_chunk_size) {
+		p = wl_array_add(&transfer->source_data, incr_chunk_size);
 		if (p == NULL) {
 			wlr_log(WLR_ERROR, "Could not allocate selection source_data");
 			goto error_out;
@@ -113,19 +115,19 @@ static int xwm_data_source_read(int fd, uint32_t mask, void *data) {
 		available, mask);
 
 	transfer->source_data.size = current + len;
-	if (transfer->source_data.size >= INCR_CHUNK_SIZE) {
+	if (transfer->source_data.size >= incr_chunk_size) {
 		if (!transfer->incr) {
 			wlr_log(WLR_DEBUG, "got %zu bytes, starting incr",
 				transfer->source_data.size);
 
-			size_t incr_chunk_size = INCR_CHUNK_SIZE;
+			uint32_t chunk_size_hint = incr_chunk_size;
 			xcb_change_property(xwm->xcb_conn,
 				XCB_PROP_MODE_REPLACE,
 				transfer->request.requestor,
 				transfer->request.property,
 				xwm->atoms[INCR],
 				32, /* format */
-				1, &incr_chunk_size);
+				1, &chunk_size_hint);
 			transfer->incr = true;
 			transfer->property_set = true;
 			transfer->flush_property_on_delete = true;
@@ -311,6 +313,7 @@ static bool xwm_selection_send_data(struct wlr_xwm_selection *selection,
 	fcntl(p[0], F_SETFL, O_NONBLOCK);
 	fcntl(p[1], F_SETFD, FD_CLOEXEC);
 	fcntl(p[1], F_SETFL, O_NONBLOCK);
+	xwm_selection_transfer_enlarge_pipe(selection->xwm, p[1]);
 
 	transfer->wl_client_fd = p[0];
 
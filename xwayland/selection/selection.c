@@ -1,4 +1,4 @@
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
 #include <assert.h>
 #include <fcntl.h>
 #include <stdlib.h>
@@ -36,6 +36,7 @@ void xwm_selection_transfer_destroy_property_reply(
 void xwm_selection_transfer_finish(
 		struct wlr_xwm_selection_transfer *transfer) {
 	transfer->incr = false;
+	transfer->incr_chunk_pending = false;
 	xwm_selection_transfer_destroy_property_reply(transfer);
 	xwm_selection_transfer_remove_event_source(transfer);
 	xwm_selection_transfer_close_wl_client_fd(transfer);
@@ -67,6 +68,39 @@ bool xwm_selection_transfer_get_selection_property(
 	return true;
 }
 
+/**
+ * INCR transfers move one property-sized chunk per X11 round trip, so the
+ * chunk size bounds throughput on large pastes. Use the largest chunk that
+ * fits in a single ChangeProperty request (minus slack for the request
+ * header), within a sane ceiling; with big-requests servers this is a few
+ * MiB instead of the 64 KiB floor.
+ */
+size_t xwm_selection_incr_chunk_size(struct wlr_xwm *xwm) {
+	size_t max_req = (size_t)xcb_get_maximum_request_length(xwm->xcb_conn) * 4;
+	size_t size = INCR_CHUNK_SIZE;
+	if (max_req > 2 * INCR_CHUNK_SIZE) {
+		size = max_req - INCR_CHUNK_SIZE;
+	}
+	if (size > MAX_INCR_CHUNK_SIZE) {
+		size = MAX_INCR_CHUNK_SIZE;
+	}
+	return size;
+}
+
+/**
+ * Selection payloads relay through pipes whose default capacity forces one
+ * event-loop wakeup per pipe-full on large pastes. Grow the pipe to the INCR
+ * chunk size so a whole chunk moves per wakeup; failure (e.g. exceeding
+ * /proc/sys/fs/pipe-max-size) just keeps the default capacity.
+ */
+void xwm_selection_transfer_enlarge_pipe(struct wlr_xwm *xwm, int fd) {
+#ifdef F_SETPIPE_SZ
+	if (fcntl(fd, F_SETPIPE_SZ, (int)xwm_selection_incr_chunk_size(xwm)) < 0) {
+		wlr_log(WLR_DEBUG, "Failed to grow the selection pipe buffer");
+	}
+#endif
+}
+
 xcb_atom_t xwm_mime_type_to_atom(struct wlr_xwm *xwm, char *mime_type) {
 	if (strcmp(mime_type, "text/plain;charset=utf-8") == 0) {
 		return xwm->atoms[UTF8_STRING];
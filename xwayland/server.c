@@ -136,6 +136,11 @@ static void server_finish_process(struct wlr_xwayland_server *server) {
 		server->x_fd_read_event[0] = server->x_fd_read_event[1] = NULL;
 	}
 
+	if (server->idle_source) {
+		wl_event_source_remove(server->idle_source);
+		server->idle_source = NULL;
+	}
+
 	if (server->client) {
 		wl_list_remove(&server->client_destroy.link);
 		wl_client_destroy(server->client);
@@ -398,6 +403,24 @@ static bool server_start(struct wlr_xwayland_server *server) {
 	return true;
 }
 
+static void xwayland_warm_start(void *data) {
+	struct wlr_xwayland_server *server = data;
+	server->idle_source = NULL;
+
+	if (server->x_fd_read_event[0] == NULL) {
+		// An X11 client connected before the compositor went idle and
+		// already triggered the start
+		return;
+	}
+
+	wlr_log(WLR_DEBUG, "Pre-spawning Xwayland for warm standby");
+	wl_event_source_remove(server->x_fd_read_event[0]);
+	wl_event_source_remove(server->x_fd_read_event[1]);
+	server->x_fd_read_event[0] = server->x_fd_read_event[1] = NULL;
+
+	server_start(server);
+}
+
 static int xwayland_socket_connected(int fd, uint32_t mask, void *data) {
 	struct wlr_xwayland_server *server = data;
 
@@ -425,6 +448,14 @@ static bool server_start_lazy(struct wlr_xwayland_server *server) {
 		return false;
 	}
 
+	if (server->warm_standby) {
+		// Spawn Xwayland off the first-launch critical path, once startup
+		// has settled; connections beating the idle callback still trigger
+		// the regular socket-activated start
+		server->idle_source = wl_event_loop_add_idle(loop,
+			xwayland_warm_start, server);
+	}
+
 	return true;
 }
 
@@ -450,6 +481,7 @@ struct wlr_xwayland_server *wlr_xwayland_server_create(
 
 	server->wl_display = wl_display;
 	server->lazy = options->lazy;
+	server->warm_standby = options->warm_standby;
 	server->enable_wm = options->enable_wm;
 
 	server->x_fd[0] = server->x_fd[1] = -1;
@@ -95,16 +95,9 @@ struct wlr_xwayland_surface *wlr_xwayland_surface_from_wlr_surface(
 	return (struct wlr_xwayland_surface *)surface->role_data;
 }
 
-// TODO: replace this with hash table?
 static struct wlr_xwayland_surface *lookup_surface(struct wlr_xwm *xwm,
 		xcb_window_t window_id) {
-	struct wlr_xwayland_surface *surface;
-	wl_list_for_each(surface, &xwm->surfaces, link) {
-		if (surface->window_id == window_id) {
-			return surface;
-		}
-	}
-	return NULL;
+	return wlr_map_get(&xwm->surfaces_by_id, window_id);
 }
 
 static int xwayland_surface_handle_ping_timeout(void *data) {
@@ -173,13 +166,9 @@ static struct wlr_xwayland_surface *xwayland_surface_create(
 	}
 	free(geometry_reply);
 
-	struct wl_display *display = xwm->xwayland->wl_display;
-	struct wl_event_loop *loop = wl_display_get_event_loop(display);
-	surface->ping_timer = wl_event_loop_add_timer(loop,
-		xwayland_surface_handle_ping_timeout, surface);
-	if (surface->ping_timer == NULL) {
+	if (!wlr_map_insert(&xwm->surfaces_by_id, window_id, surface)) {
 		free(surface);
-		wlr_log(WLR_ERROR, "Could not add timer to event loop");
+		wlr_log(WLR_ERROR, "Could not insert surface into window table");
 		return NULL;
 	}
 
@@ -219,10 +208,12 @@ static void xwm_send_wm_message(struct wlr_xwayland_surface *surface,
 }
 
 static void xwm_set_net_client_list(struct wlr_xwm *xwm) {
+	// _NET_CLIENT_LIST only tracks managed windows, so override-redirect
+	// windows are skipped here and don't trigger a rebuild on map/unmap
 	size_t mapped_surfaces = 0;
 	struct wlr_xwayland_surface *surface;
 	wl_list_for_each(surface, &xwm->surfaces, link) {
-		if (surface->mapped) {
+		if (surface->mapped && !surface->override_redirect) {
 			mapped_surfaces++;
 		}
 	}
@@ -230,7 +221,7 @@ static void xwm_set_net_client_list(struct wlr_xwm *xwm) {
 	xcb_window_t windows[mapped_surfaces + 1];
 	size_t index = 0;
 	wl_list_for_each(surface, &xwm->surfaces, link) {
-		if (surface->mapped) {
+		if (surface->mapped && !surface->override_redirect) {
 			windows[index++] = surface->window_id;
 		}
 	}
@@ -353,6 +344,7 @@ static void xwayland_surface_destroy(
 		xwm_surface_activate(xsurface->xwm, NULL);
 	}
 
+	wlr_map_remove(&xsurface->xwm->surfaces_by_id, xsurface->window_id);
 	wl_list_remove(&xsurface->link);
 	wl_list_remove(&xsurface->parent_link);
 
@@ -372,7 +364,9 @@ static void xwayland_surface_destroy(
 		xsurface->surface->role_data = NULL;
 	}
 
-	wl_event_source_remove(xsurface->ping_timer);
+	if (xsurface->ping_timer != NULL) {
+		wl_event_source_remove(xsurface->ping_timer);
+	}
 
 	free(xsurface->title);
 	free(xsurface->class);
@@ -718,10 +712,15 @@ char *xwm_get_atom_name(struct wlr_xwm *xwm, xcb_atom_t atom) {
 	return name;
 }
 
-static void read_surface_property(struct wlr_xwm *xwm,
+static xcb_get_property_cookie_t request_surface_property(struct wlr_xwm *xwm,
 		struct wlr_xwayland_surface *xsurface, xcb_atom_t property) {
-	xcb_get_property_cookie_t cookie = xcb_get_property(xwm->xcb_conn, 0,
-		xsurface->window_id, property, XCB_ATOM_ANY, 0, 2048);
+	return xcb_get_property(xwm->xcb_conn, 0, xsurface->window_id, property,
+		XCB_ATOM_ANY, 0, 2048);
+}
+
+static void read_surface_property_reply(struct wlr_xwm *xwm,
+		struct wlr_xwayland_surface *xsurface, xcb_atom_t property,
+		xcb_get_property_cookie_t cookie) {
 	xcb_get_property_reply_t *reply = xcb_get_property_reply(xwm->xcb_conn,
 		cookie, NULL);
 	if (reply == NULL) {
@@ -761,6 +760,13 @@ static void read_surface_property(struct wlr_xwm *xwm,
 	free(reply);
 }
 
+static void read_surface_property(struct wlr_xwm *xwm,
+		struct wlr_xwayland_surface *xsurface, xcb_atom_t property) {
+	xcb_get_property_cookie_t cookie =
+		request_surface_property(xwm, xsurface, property);
+	read_surface_property_reply(xwm, xsurface, property, cookie);
+}
+
 static void xwayland_surface_role_commit(struct wlr_surface *wlr_surface) {
 	assert(wlr_surface->role == &xwayland_surface_role);
 	struct wlr_xwayland_surface *surface = wlr_surface->role_data;
@@ -771,7 +777,9 @@ static void xwayland_surface_role_commit(struct wlr_surface *wlr_surface) {
 	if (!surface->mapped && wlr_surface_has_buffer(surface->surface)) {
 		wlr_signal_emit_safe(&surface->events.map, surface);
 		surface->mapped = true;
-		xwm_set_net_client_list(surface->xwm);
+		if (!surface->override_redirect) {
+			xwm_set_net_client_list(surface->xwm);
+		}
 	}
 }
 
@@ -788,7 +796,9 @@ static void xwayland_surface_role_precommit(struct wlr_surface *wlr_surface) {
 		if (surface->mapped) {
 			wlr_signal_emit_safe(&surface->events.unmap, surface);
 			surface->mapped = false;
-			xwm_set_net_client_list(surface->xwm);
+			if (!surface->override_redirect) {
+				xwm_set_net_client_list(surface->xwm);
+			}
 		}
 	}
 }
@@ -829,8 +839,28 @@ static void xwm_map_shell_surface(struct wlr_xwm *xwm,
 		xwm->atoms[NET_WM_NAME],
 		xwm->atoms[NET_WM_PID],
 	};
-	for (size_t i = 0; i < sizeof(props)/sizeof(xcb_atom_t); i++) {
-		read_surface_property(xwm, xsurface, props[i]);
+	// Override-redirect windows (menus, tooltips, DnD ghosts) are unmanaged
+	// and usually live for milliseconds: only fetch what compositors consult
+	// for them and skip the WM hint machinery entirely
+	const xcb_atom_t or_props[] = {
+		XCB_ATOM_WM_TRANSIENT_FOR,
+		xwm->atoms[NET_WM_WINDOW_TYPE],
+	};
+	const xcb_atom_t *fetch = props;
+	size_t fetch_len = sizeof(props)/sizeof(xcb_atom_t);
+	if (xsurface->override_redirect) {
+		fetch = or_props;
+		fetch_len = sizeof(or_props)/sizeof(xcb_atom_t);
+	}
+	// Issue all fetches before reading any reply, so the whole batch is
+	// pipelined and costs one round trip instead of one per property
+	xcb_get_property_cookie_t cookies[sizeof(props)/sizeof(xcb_atom_t)];
+	for (size_t i = 0; i < fetch_len; i++) {
+		cookies[i] = request_surface_property(xwm, xsurface, fetch[i]);
+	}
+	xcb_flush(xwm->xcb_conn);
+	for (size_t i = 0; i < fetch_len; i++) {
+		read_surface_property_reply(xwm, xsurface, fetch[i], cookies[i]);
 	}
 
 	xsurface->surface_destroy.notify = handle_surface_destroy;
@@ -841,7 +871,9 @@ static void xsurface_unmap(struct wlr_xwayland_surface *surface) {
 	if (surface->mapped) {
 		wlr_signal_emit_safe(&surface->events.unmap, surface);
 		surface->mapped = false;
-		xwm_set_net_client_list(surface->xwm);
+		if (!surface->override_redirect) {
+			xwm_set_net_client_list(surface->xwm);
+		}
 	}
 
 	if (surface->surface_id) {
@@ -983,6 +1015,10 @@ static void xwm_handle_map_notify(struct wlr_xwm *xwm,
 	if (xsurface->override_redirect != ev->override_redirect) {
 		xsurface->override_redirect = ev->override_redirect;
 		wlr_signal_emit_safe(&xsurface->events.set_override_redirect, xsurface);
+		if (xsurface->mapped) {
+			// The window changed between managed and unmanaged
+			xwm_set_net_client_list(xwm);
+		}
 	}
 }
 
@@ -1606,6 +1642,7 @@ void xwm_destroy(struct wlr_xwm *xwm) {
 	wl_list_for_each_safe(xsurface, tmp, &xwm->unpaired_surfaces, link) {
 		xwayland_surface_destroy(xsurface);
 	}
+	wlr_map_finish(&xwm->surfaces_by_id);
 	wl_list_remove(&xwm->compositor_new_surface.link);
 	wl_list_remove(&xwm->compositor_destroy.link);
 	xcb_disconnect(xwm->xcb_conn);
@@ -1824,6 +1861,7 @@ struct wlr_xwm *xwm_create(struct wlr_xwayland *xwayland, int wm_fd) {
 	xwm->xwayland = xwayland;
 	wl_list_init(&xwm->surfaces);
 	wl_list_init(&xwm->unpaired_surfaces);
+	wlr_map_init(&xwm->surfaces_by_id);
 	xwm->ping_timeout = 10000;
 
 	xwm->xcb_conn = xcb_connect_to_fd(wm_fd, NULL);
@@ -1955,6 +1993,19 @@ bool xwm_atoms_contains(struct wlr_xwm *xwm, xcb_atom_t *atoms,
 }
 
 void wlr_xwayland_surface_ping(struct wlr_xwayland_surface *surface) {
+	if (surface->ping_timer == NULL) {
+		// Created on first use: most windows (especially short-lived
+		// override-redirect ones) are never pinged
+		struct wl_event_loop *loop =
+			wl_display_get_event_loop(surface->xwm->xwayland->wl_display);
+		surface->ping_timer = wl_event_loop_add_timer(loop,
+			xwayland_surface_handle_ping_timeout, surface);
+		if (surface->ping_timer == NULL) {
+			wlr_log(WLR_ERROR, "Could not add timer to event loop");
+			return;
+		}
+	}
+
 	xcb_client_message_data_t data = { 0 };
 	data.data32[0] = surface->xwm->atoms[NET_WM_PING];
 	data.data32[1] = XCB_CURRENT_TIME;